@@ -132,6 +132,17 @@ typedef struct binder_ext_call_info {
     const char* name;
 } BinderExtCallInfo;
 
+/*
+ * Immutable reference counted snapshot of the calls, sorted by call_id.
+ * Each change produces a new list with a larger version number, i.e.
+ * two lists with the same version have the same contents.
+ */
+typedef struct binder_ext_call_list {
+    guint version;
+    guint count;
+    const BinderExtCallInfo* calls;
+} BinderExtCallList;
+
 typedef
 void
 (*BinderExtCallResultFunc)(
@@ -181,6 +192,10 @@ const BinderExtCallInfo* const*
 binder_ext_call_get_calls(
     BinderExtCall* ext);
 
+BinderExtCallList*
+binder_ext_call_get_call_list(
+    BinderExtCall* ext); /* Caller must unref the list */
+
 guint
 binder_ext_call_dial(
     BinderExtCall* ext,
@@ -253,11 +268,27 @@ binder_ext_call_hangup(
     GDestroyNotify destroy,
     void* user_data);
 
+guint
+binder_ext_call_hangup_batch(
+    BinderExtCall* ext,
+    const guint* call_ids,
+    guint count,
+    BINDER_EXT_CALL_HANGUP_REASON reason,
+    BINDER_EXT_CALL_HANGUP_FLAGS flags,
+    BinderExtCallResultFunc complete,
+    GDestroyNotify destroy,
+    void* user_data);
+
 void
 binder_ext_call_cancel(
     BinderExtCall* ext,
     guint id);
 
+void
+binder_ext_call_cancel_batch(
+    BinderExtCall* ext,
+    guint id);
+
 gulong
 binder_ext_call_add_calls_changed_handler(
     BinderExtCall* ext,
@@ -296,6 +327,24 @@ binder_ext_call_remove_handlers(
 #define binder_ext_call_remove_all_handlers(ext, ids) \
     binder_ext_call_remove_handlers(ext, ids, G_N_ELEMENTS(ids))
 
+BinderExtCallList*
+binder_ext_call_list_new(
+    const BinderExtCallInfo* const* calls,
+    guint version);
+
+BinderExtCallList*
+binder_ext_call_list_ref(
+    BinderExtCallList* list);
+
+void
+binder_ext_call_list_unref(
+    BinderExtCallList* list);
+
+gboolean
+binder_ext_call_info_equal(
+    const BinderExtCallInfo* info1,
+    const BinderExtCallInfo* info2);
+
 G_END_DECLS
 
 #endif /* BINDER_EXT_CALL_H */
@@ -22,7 +22,7 @@
 
 G_BEGIN_DECLS
 
-#define BINDER_EXT_CALL_INTERFACE_VERSION 1
+#define BINDER_EXT_CALL_INTERFACE_VERSION 2
 
 /*
  * Implementation sets field to BINDER_EXT_CALL_INTERFACE_VERSION.
@@ -81,9 +81,24 @@ typedef struct binder_ext_call_interface {
         BinderExtCallSuppSvcNotifyFunc handler, void* user_data);
     void (*remove_handler)(BinderExtCall* ext, gulong id);
 
+    /*
+     * Since version 2. Optional, if it's missing then the calls are
+     * hung up one by one and the completion callback is invoked once
+     * all of them have completed. The returned id is passed to cancel.
+     */
+    guint (*hangup_batch)(BinderExtCall* ext, const guint* call_ids,
+        guint count, BINDER_EXT_CALL_HANGUP_REASON reason,
+        BINDER_EXT_CALL_HANGUP_FLAGS flags,
+        BinderExtCallResultFunc complete, GDestroyNotify destroy,
+        void* user_data);
+
+    /*
+     * Since version 2. Optional, returns a new reference to the list.
+     * If it's missing, the list is built from what get_calls returns.
+     */
+    BinderExtCallList* (*get_call_list)(BinderExtCall* ext);
+
     /* Padding for future expansion */
-    void (*_reserved1)(void);
-    void (*_reserved2)(void);
     void (*_reserved3)(void);
     void (*_reserved4)(void);
     void (*_reserved5)(void);
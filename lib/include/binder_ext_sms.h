@@ -43,6 +43,12 @@ typedef enum binder_ext_sms_send_result {
     BINDER_EXT_SMS_SEND_RESULT_ERROR_NETWORK_TIMEOUT
 } BINDER_EXT_SMS_SEND_RESULT;
 
+typedef struct binder_ext_sms_pdu {
+    const void* pdu;
+    gsize pdu_len;
+    guint msg_ref;
+} BinderExtSmsPdu;
+
 typedef
 void
 (*BinderExtSmsSendFunc)(
@@ -51,6 +57,19 @@ void
     guint msg_ref,
     void* user_data);
 
+/*
+ * Invoked once per segment. The batch is finished after the last
+ * segment has been sent or after the first failure.
+ */
+typedef
+void
+(*BinderExtSmsSendBatchFunc)(
+    BinderExtSms* ext,
+    guint index,
+    BINDER_EXT_SMS_SEND_RESULT result,
+    guint msg_ref,
+    void* user_data);
+
 typedef
 void
 (*BinderExtSmsReportFunc)(
@@ -97,11 +116,27 @@ binder_ext_sms_send(
     GDestroyNotify destroy,
     void* user_data);
 
+guint
+binder_ext_sms_send_batch(
+    BinderExtSms* ext,
+    const char* smsc,
+    const BinderExtSmsPdu* pdus,
+    guint count,
+    BINDER_EXT_SMS_SEND_FLAGS flags,
+    BinderExtSmsSendBatchFunc complete,
+    GDestroyNotify destroy,
+    void* user_data);
+
 void
 binder_ext_sms_cancel(
     BinderExtSms* ext,
     guint id);
 
+void
+binder_ext_sms_cancel_batch(
+    BinderExtSms* ext,
+    guint id);
+
 gulong
 binder_ext_sms_add_report_handler(
     BinderExtSms* ext,
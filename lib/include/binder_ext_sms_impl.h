@@ -22,7 +22,7 @@
 
 G_BEGIN_DECLS
 
-#define BINDER_EXT_SMS_INTERFACE_VERSION 1
+#define BINDER_EXT_SMS_INTERFACE_VERSION 2
 
 /*
  * Implementation sets field to BINDER_EXT_SMS_INTERFACE_VERSION.
@@ -53,8 +53,17 @@ typedef struct binder_ext_sms_interface {
         BinderExtSmsIncomingFunc handler, void* user_data);
     void (*remove_handler)(BinderExtSms* ext, gulong id);
 
+    /*
+     * Since version 2. Optional, if it's missing then the segments
+     * are sent one after another. The returned id is passed to cancel.
+     */
+    guint (*send_batch)(BinderExtSms* ext, const char* smsc,
+        const BinderExtSmsPdu* pdus, guint count,
+        BINDER_EXT_SMS_SEND_FLAGS flags,
+        BinderExtSmsSendBatchFunc complete, GDestroyNotify destroy,
+        void* user_data);
+
     /* Padding for future expansion */
-    void (*_reserved1)(void);
     void (*_reserved2)(void);
     void (*_reserved3)(void);
     void (*_reserved4)(void);
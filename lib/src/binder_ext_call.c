@@ -15,9 +15,298 @@
 
 #include "binder_ext_call_impl.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 G_DEFINE_INTERFACE(BinderExtCall, binder_ext_call, G_TYPE_OBJECT)
 #define GET_IFACE(obj) BINDER_EXT_CALL_GET_IFACE(obj)
 
+/*==========================================================================*
+ * Call list
+ *==========================================================================*/
+
+typedef struct binder_ext_call_list_priv {
+    BinderExtCallList pub;
+    gint ref_count;
+} BinderExtCallListPriv;
+
+static inline
+BinderExtCallListPriv*
+binder_ext_call_list_cast(
+    BinderExtCallList* list)
+{
+    /* The public part is the first member */
+    return (BinderExtCallListPriv*)list;
+}
+
+static
+int
+binder_ext_call_info_compare(
+    const void* a,
+    const void* b)
+{
+    const BinderExtCallInfo* info1 = a;
+    const BinderExtCallInfo* info2 = b;
+
+    return (info1->call_id < info2->call_id) ? -1 :
+        (info1->call_id > info2->call_id) ? 1 : 0;
+}
+
+static
+BinderExtCallList*
+binder_ext_call_list_from_calls(
+    BinderExtCall* self,
+    BinderExtCallInterface* iface)
+{
+    static GQuark quark = 0;
+    const BinderExtCallInfo* const* calls = iface->get_calls ?
+        iface->get_calls(self) : NULL;
+    BinderExtCallList* last;
+    BinderExtCallList* list;
+    guint i, n = 0;
+
+    if (G_UNLIKELY(!quark)) {
+        quark = g_quark_from_static_string("binder-ext-call-list");
+    }
+
+    /* Reuse the previous snapshot if nothing has changed */
+    last = g_object_get_qdata(G_OBJECT(self), quark);
+    if (calls) {
+        while (calls[n]) {
+            n++;
+        }
+    }
+    if (last && last->count == n) {
+        for (i = 0; i < n; i++) {
+            const BinderExtCallInfo* info = bsearch(calls[i], last->calls,
+                last->count, sizeof(last->calls[0]),
+                binder_ext_call_info_compare);
+
+            if (!info || !binder_ext_call_info_equal(info, calls[i])) {
+                break;
+            }
+        }
+        if (i == n) {
+            return binder_ext_call_list_ref(last);
+        }
+    }
+
+    list = binder_ext_call_list_new(calls, last ? (last->version + 1) : 1);
+    g_object_set_qdata_full(G_OBJECT(self), quark,
+        binder_ext_call_list_ref(list), (GDestroyNotify)
+        binder_ext_call_list_unref);
+    return list;
+}
+
+/*==========================================================================*
+ * Batch fallback
+ *==========================================================================*/
+
+typedef struct binder_ext_call_batch_op BinderExtCallBatchOp;
+
+typedef struct binder_ext_call_batch {
+    BinderExtCall* ext;
+    guint id;
+    guint pending;
+    gboolean cancelled;
+    BINDER_EXT_CALL_RESULT result;
+    BinderExtCallResultFunc complete;
+    GDestroyNotify destroy;
+    void* user_data;
+    guint count;
+    BinderExtCallBatchOp* ops;
+} BinderExtCallBatch;
+
+struct binder_ext_call_batch_op {
+    BinderExtCallBatch* batch;
+    guint id;
+};
+
+typedef struct binder_ext_call_batches {
+    GHashTable* table;
+    guint last_id;
+} BinderExtCallBatches;
+
+static
+void
+binder_ext_call_batches_free(
+    gpointer data)
+{
+    BinderExtCallBatches* batches = data;
+
+    /* Batches hold a reference, the table must be empty by now */
+    g_hash_table_destroy(batches->table);
+    g_slice_free(BinderExtCallBatches, batches);
+}
+
+static
+BinderExtCallBatches*
+binder_ext_call_batches(
+    BinderExtCall* self)
+{
+    static GQuark quark = 0;
+    BinderExtCallBatches* batches;
+
+    if (G_UNLIKELY(!quark)) {
+        quark = g_quark_from_static_string("binder-ext-call-batches");
+    }
+    batches = g_object_get_qdata(G_OBJECT(self), quark);
+    if (!batches) {
+        batches = g_slice_new0(BinderExtCallBatches);
+        batches->table = g_hash_table_new(g_direct_hash, g_direct_equal);
+        g_object_set_qdata_full(G_OBJECT(self), quark, batches,
+            binder_ext_call_batches_free);
+    }
+    return batches;
+}
+
+static
+void
+binder_ext_call_batch_finish(
+    BinderExtCallBatch* batch)
+{
+    BinderExtCall* ext = batch->ext;
+
+    if (!batch->cancelled) {
+        g_hash_table_remove(binder_ext_call_batches(ext)->table,
+            GUINT_TO_POINTER(batch->id));
+        if (batch->complete) {
+            batch->complete(ext, batch->result, batch->user_data);
+        }
+    }
+    if (batch->destroy) {
+        batch->destroy(batch->user_data);
+    }
+    g_free(batch->ops);
+    g_slice_free(BinderExtCallBatch, batch);
+    g_object_unref(ext);
+}
+
+static
+void
+binder_ext_call_batch_op_complete(
+    BinderExtCall* ext,
+    BINDER_EXT_CALL_RESULT result,
+    void* user_data)
+{
+    BinderExtCallBatchOp* op = user_data;
+
+    op->id = 0;
+    if (result != BINDER_EXT_CALL_RESULT_OK) {
+        op->batch->result = result;
+    }
+}
+
+static
+void
+binder_ext_call_batch_op_destroy(
+    void* user_data)
+{
+    BinderExtCallBatchOp* op = user_data;
+    BinderExtCallBatch* batch = op->batch;
+
+    op->id = 0;
+    if (!--batch->pending) {
+        binder_ext_call_batch_finish(batch);
+    }
+}
+
+static
+guint
+binder_ext_call_hangup_batch_fallback(
+    BinderExtCall* self,
+    BinderExtCallInterface* iface,
+    const guint* call_ids,
+    guint count,
+    BINDER_EXT_CALL_HANGUP_REASON reason,
+    BINDER_EXT_CALL_HANGUP_FLAGS flags,
+    BinderExtCallResultFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    BinderExtCallBatches* batches = binder_ext_call_batches(self);
+    BinderExtCallBatch* batch = g_slice_new0(BinderExtCallBatch);
+    guint i, submitted = 0;
+
+    batch->ext = g_object_ref(self);
+    batch->count = count;
+    batch->complete = complete;
+    batch->destroy = destroy;
+    batch->user_data = user_data;
+    batch->ops = g_new0(BinderExtCallBatchOp, count);
+
+    /* Hold an extra pending count while the requests are being submitted */
+    batch->pending = 1;
+    for (i = 0; i < count; i++) {
+        BinderExtCallBatchOp* op = batch->ops + i;
+
+        op->batch = batch;
+        batch->pending++;
+        op->id = iface->hangup(self, call_ids[i], reason, flags,
+            binder_ext_call_batch_op_complete,
+            binder_ext_call_batch_op_destroy, op);
+        if (op->id) {
+            submitted++;
+        } else {
+            batch->pending--;
+            batch->result = BINDER_EXT_CALL_RESULT_ERROR;
+        }
+    }
+
+    if (!submitted) {
+        /* Nothing to wait for, the caller will have to deal with it */
+        g_free(batch->ops);
+        g_slice_free(BinderExtCallBatch, batch);
+        g_object_unref(self);
+        return 0;
+    }
+
+    if (!(++batches->last_id)) {
+        batches->last_id++;
+    }
+    batch->id = batches->last_id;
+    g_hash_table_insert(batches->table, GUINT_TO_POINTER(batch->id), batch);
+    if (!--batch->pending) {
+        /* Everything has completed synchronously */
+        const guint id = batch->id;
+
+        binder_ext_call_batch_finish(batch);
+        return id;
+    }
+    return batch->id;
+}
+
+static
+void
+binder_ext_call_cancel_batch_fallback(
+    BinderExtCall* self,
+    BinderExtCallInterface* iface,
+    guint id)
+{
+    BinderExtCallBatches* batches = binder_ext_call_batches(self);
+    BinderExtCallBatch* batch = g_hash_table_lookup(batches->table,
+        GUINT_TO_POINTER(id));
+
+    if (batch) {
+        guint i;
+
+        /* The batch gets freed after the last request is destroyed */
+        g_hash_table_remove(batches->table, GUINT_TO_POINTER(id));
+        batch->cancelled = TRUE;
+        batch->pending++;
+        for (i = 0; i < batch->count; i++) {
+            const guint op_id = batch->ops[i].id;
+
+            if (op_id && iface->cancel) {
+                iface->cancel(self, op_id);
+            }
+        }
+        if (!--batch->pending) {
+            binder_ext_call_batch_finish(batch);
+        }
+    }
+}
+
 /*==========================================================================*
  * API
  *==========================================================================*/
@@ -71,6 +360,27 @@ binder_ext_call_get_calls(
     return &none;
 }
 
+BinderExtCallList*
+binder_ext_call_get_call_list(
+    BinderExtCall* self)
+{
+    if (G_LIKELY(self)) {
+        BinderExtCallInterface* iface = GET_IFACE(self);
+
+        if (iface->version > 1 && iface->get_call_list) {
+            BinderExtCallList* list = iface->get_call_list(self);
+
+            if (list) {
+                return list;
+            }
+        }
+        return binder_ext_call_list_from_calls(self, iface);
+    }
+
+    /* This function never returns NULL */
+    return binder_ext_call_list_new(NULL, 0);
+}
+
 guint
 binder_ext_call_dial(
     BinderExtCall* self,
@@ -227,6 +537,32 @@ binder_ext_call_hangup(
     return 0;
 }
 
+guint
+binder_ext_call_hangup_batch(
+    BinderExtCall* self,
+    const guint* call_ids,
+    guint count,
+    BINDER_EXT_CALL_HANGUP_REASON reason,
+    BINDER_EXT_CALL_HANGUP_FLAGS flags,
+    BinderExtCallResultFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    if (G_LIKELY(self) && G_LIKELY(call_ids) && G_LIKELY(count)) {
+        BinderExtCallInterface* iface = GET_IFACE(self);
+
+        if (iface->version > 1 && iface->hangup_batch) {
+            return iface->hangup_batch(self, call_ids, count, reason, flags,
+                complete, destroy, user_data);
+        } else if (iface->hangup) {
+            return binder_ext_call_hangup_batch_fallback(self, iface,
+                call_ids, count, reason, flags, complete, destroy,
+                user_data);
+        }
+    }
+    return 0;
+}
+
 void
 binder_ext_call_cancel(
     BinderExtCall* self,
@@ -241,6 +577,24 @@ binder_ext_call_cancel(
     }
 }
 
+void
+binder_ext_call_cancel_batch(
+    BinderExtCall* self,
+    guint id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        BinderExtCallInterface* iface = GET_IFACE(self);
+
+        if (iface->version > 1 && iface->hangup_batch) {
+            if (iface->cancel) {
+                iface->cancel(self, id);
+            }
+        } else {
+            binder_ext_call_cancel_batch_fallback(self, iface, id);
+        }
+    }
+}
+
 gulong
 binder_ext_call_add_calls_changed_handler(
     BinderExtCall* self,
@@ -342,6 +696,106 @@ binder_ext_call_remove_handlers(
     }
 }
 
+BinderExtCallList*
+binder_ext_call_list_new(
+    const BinderExtCallInfo* const* calls,
+    guint version)
+{
+    BinderExtCallListPriv* priv;
+    BinderExtCallList* list;
+    BinderExtCallInfo* infos;
+    gsize size = sizeof(BinderExtCallListPriv);
+    guint i, n = 0;
+    char* ptr;
+
+    /* The whole thing is allocated as a single memory block */
+    if (calls) {
+        while (calls[n]) {
+            const BinderExtCallInfo* info = calls[n++];
+
+            size += sizeof(BinderExtCallInfo);
+            if (info->number) {
+                size += strlen(info->number) + 1;
+            }
+            if (info->name) {
+                size += strlen(info->name) + 1;
+            }
+        }
+    }
+
+    priv = g_malloc0(size);
+    priv->ref_count = 1;
+    list = &priv->pub;
+    list->version = version;
+    list->count = n;
+    infos = (BinderExtCallInfo*)(priv + 1);
+    list->calls = infos;
+    ptr = (char*)(infos + n);
+    for (i = 0; i < n; i++) {
+        const BinderExtCallInfo* src = calls[i];
+        BinderExtCallInfo* dest = infos + i;
+
+        *dest = *src;
+        if (src->number) {
+            const gsize len = strlen(src->number) + 1;
+
+            dest->number = memcpy(ptr, src->number, len);
+            ptr += len;
+        }
+        if (src->name) {
+            const gsize len = strlen(src->name) + 1;
+
+            dest->name = memcpy(ptr, src->name, len);
+            ptr += len;
+        }
+    }
+    qsort(infos, n, sizeof(infos[0]), binder_ext_call_info_compare);
+    return list;
+}
+
+BinderExtCallList*
+binder_ext_call_list_ref(
+    BinderExtCallList* list)
+{
+    if (G_LIKELY(list)) {
+        g_atomic_int_inc(&binder_ext_call_list_cast(list)->ref_count);
+    }
+    return list;
+}
+
+void
+binder_ext_call_list_unref(
+    BinderExtCallList* list)
+{
+    if (G_LIKELY(list)) {
+        BinderExtCallListPriv* priv = binder_ext_call_list_cast(list);
+
+        if (g_atomic_int_dec_and_test(&priv->ref_count)) {
+            g_free(priv);
+        }
+    }
+}
+
+gboolean
+binder_ext_call_info_equal(
+    const BinderExtCallInfo* info1,
+    const BinderExtCallInfo* info2)
+{
+    if (info1 == info2) {
+        return TRUE;
+    } else if (info1 && info2) {
+        return info1->call_id == info2->call_id &&
+            info1->type == info2->type &&
+            info1->state == info2->state &&
+            info1->flags == info2->flags &&
+            info1->toa == info2->toa &&
+            !g_strcmp0(info1->number, info2->number) &&
+            !g_strcmp0(info1->name, info2->name);
+    } else {
+        return FALSE;
+    }
+}
+
 /*==========================================================================*
  * Internals
  *==========================================================================*/
@@ -18,6 +18,236 @@
 G_DEFINE_INTERFACE(BinderExtSms, binder_ext_sms, G_TYPE_OBJECT)
 #define GET_IFACE(obj) BINDER_EXT_SMS_GET_IFACE(obj)
 
+/*==========================================================================*
+ * Batch fallback
+ *==========================================================================*/
+
+typedef struct binder_ext_sms_batch {
+    BinderExtSms* ext;
+    guint id;
+    guint send_id;
+    gboolean cancelled;
+    gboolean done;
+    char* smsc;
+    BINDER_EXT_SMS_SEND_FLAGS flags;
+    BinderExtSmsSendBatchFunc complete;
+    GDestroyNotify destroy;
+    void* user_data;
+    guint index;
+    guint count;
+    GBytes** pdus;
+    guint* msg_refs;
+} BinderExtSmsBatch;
+
+typedef struct binder_ext_sms_batches {
+    GHashTable* table;
+    guint last_id;
+} BinderExtSmsBatches;
+
+static
+void
+binder_ext_sms_batches_free(
+    gpointer data)
+{
+    BinderExtSmsBatches* batches = data;
+
+    /* Batches hold a reference, the table must be empty by now */
+    g_hash_table_destroy(batches->table);
+    g_slice_free(BinderExtSmsBatches, batches);
+}
+
+static
+BinderExtSmsBatches*
+binder_ext_sms_batches(
+    BinderExtSms* self)
+{
+    static GQuark quark = 0;
+    BinderExtSmsBatches* batches;
+
+    if (G_UNLIKELY(!quark)) {
+        quark = g_quark_from_static_string("binder-ext-sms-batches");
+    }
+    batches = g_object_get_qdata(G_OBJECT(self), quark);
+    if (!batches) {
+        batches = g_slice_new0(BinderExtSmsBatches);
+        batches->table = g_hash_table_new(g_direct_hash, g_direct_equal);
+        g_object_set_qdata_full(G_OBJECT(self), quark, batches,
+            binder_ext_sms_batches_free);
+    }
+    return batches;
+}
+
+static
+void
+binder_ext_sms_batch_free(
+    BinderExtSmsBatch* batch)
+{
+    guint i;
+
+    for (i = 0; i < batch->count; i++) {
+        g_bytes_unref(batch->pdus[i]);
+    }
+    g_free(batch->pdus);
+    g_free(batch->msg_refs);
+    g_free(batch->smsc);
+    g_slice_free(BinderExtSmsBatch, batch);
+}
+
+static
+void
+binder_ext_sms_batch_finish(
+    BinderExtSmsBatch* batch)
+{
+    BinderExtSms* ext = batch->ext;
+
+    if (!batch->cancelled) {
+        g_hash_table_remove(binder_ext_sms_batches(ext)->table,
+            GUINT_TO_POINTER(batch->id));
+    }
+    if (batch->destroy) {
+        batch->destroy(batch->user_data);
+    }
+    binder_ext_sms_batch_free(batch);
+    g_object_unref(ext);
+}
+
+static
+void
+binder_ext_sms_batch_send_complete(
+    BinderExtSms* ext,
+    BINDER_EXT_SMS_SEND_RESULT result,
+    guint msg_ref,
+    void* user_data)
+{
+    BinderExtSmsBatch* batch = user_data;
+    const guint index = batch->index++;
+
+    batch->send_id = 0;
+    if (result != BINDER_EXT_SMS_SEND_RESULT_OK ||
+        batch->index >= batch->count) {
+        batch->done = TRUE;
+    }
+    if (!batch->cancelled && batch->complete) {
+        batch->complete(ext, index, result, msg_ref, batch->user_data);
+    }
+}
+
+static
+gboolean
+binder_ext_sms_batch_send_next(
+    BinderExtSmsBatch* batch);
+
+static
+void
+binder_ext_sms_batch_send_destroy(
+    void* user_data)
+{
+    BinderExtSmsBatch* batch = user_data;
+
+    batch->send_id = 0;
+    if (!batch->done && !batch->cancelled) {
+        if (binder_ext_sms_batch_send_next(batch)) {
+            return;
+        }
+
+        /* The next segment didn't go through */
+        batch->done = TRUE;
+        if (batch->complete) {
+            batch->complete(batch->ext, batch->index,
+                BINDER_EXT_SMS_SEND_RESULT_ERROR, 0, batch->user_data);
+        }
+    }
+    binder_ext_sms_batch_finish(batch);
+}
+
+static
+gboolean
+binder_ext_sms_batch_send_next(
+    BinderExtSmsBatch* batch)
+{
+    BinderExtSms* ext = batch->ext;
+    BinderExtSmsInterface* iface = GET_IFACE(ext);
+    const guint i = batch->index;
+    GBytes* pdu = batch->pdus[i];
+    gsize size;
+    const void* data = g_bytes_get_data(pdu, &size);
+
+    /* All segments but the last one are followed by more */
+    batch->send_id = iface->send(ext, batch->smsc, data, size,
+        batch->msg_refs[i], (i + 1 < batch->count) ?
+        (batch->flags | BINDER_EXT_SMS_SEND_EXPECT_MORE) :
+        (batch->flags & ~BINDER_EXT_SMS_SEND_EXPECT_MORE),
+        binder_ext_sms_batch_send_complete,
+        binder_ext_sms_batch_send_destroy, batch);
+    return batch->send_id != 0;
+}
+
+static
+guint
+binder_ext_sms_send_batch_fallback(
+    BinderExtSms* self,
+    const char* smsc,
+    const BinderExtSmsPdu* pdus,
+    guint count,
+    BINDER_EXT_SMS_SEND_FLAGS flags,
+    BinderExtSmsSendBatchFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    BinderExtSmsBatches* batches = binder_ext_sms_batches(self);
+    BinderExtSmsBatch* batch = g_slice_new0(BinderExtSmsBatch);
+    guint i;
+
+    /* The caller's buffers don't have to outlive this call */
+    batch->ext = g_object_ref(self);
+    batch->smsc = g_strdup(smsc);
+    batch->flags = flags;
+    batch->count = count;
+    batch->pdus = g_new(GBytes*, count);
+    batch->msg_refs = g_new(guint, count);
+    for (i = 0; i < count; i++) {
+        batch->pdus[i] = g_bytes_new(pdus[i].pdu, pdus[i].pdu_len);
+        batch->msg_refs[i] = pdus[i].msg_ref;
+    }
+    batch->complete = complete;
+    batch->destroy = destroy;
+    batch->user_data = user_data;
+    if (!(++batches->last_id)) {
+        batches->last_id++;
+    }
+    batch->id = batches->last_id;
+    g_hash_table_insert(batches->table, GUINT_TO_POINTER(batch->id), batch);
+    if (binder_ext_sms_batch_send_next(batch)) {
+        return batch->id;
+    } else {
+        g_hash_table_remove(batches->table, GUINT_TO_POINTER(batch->id));
+        binder_ext_sms_batch_free(batch);
+        g_object_unref(self);
+        return 0;
+    }
+}
+
+static
+void
+binder_ext_sms_cancel_batch_fallback(
+    BinderExtSms* self,
+    BinderExtSmsInterface* iface,
+    guint id)
+{
+    BinderExtSmsBatches* batches = binder_ext_sms_batches(self);
+    BinderExtSmsBatch* batch = g_hash_table_lookup(batches->table,
+        GUINT_TO_POINTER(id));
+
+    if (batch) {
+        /* The batch gets freed when the current request is destroyed */
+        g_hash_table_remove(batches->table, GUINT_TO_POINTER(id));
+        batch->cancelled = TRUE;
+        if (batch->send_id && iface->cancel) {
+            iface->cancel(self, batch->send_id);
+        }
+    }
+}
+
 /*==========================================================================*
  * API
  *==========================================================================*/
@@ -72,6 +302,31 @@ binder_ext_sms_send(
     return 0;
 }
 
+guint
+binder_ext_sms_send_batch(
+    BinderExtSms* self,
+    const char* smsc,
+    const BinderExtSmsPdu* pdus,
+    guint count,
+    BINDER_EXT_SMS_SEND_FLAGS flags,
+    BinderExtSmsSendBatchFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    if (G_LIKELY(self) && G_LIKELY(pdus) && G_LIKELY(count)) {
+        BinderExtSmsInterface* iface = GET_IFACE(self);
+
+        if (iface->version > 1 && iface->send_batch) {
+            return iface->send_batch(self, smsc, pdus, count, flags,
+                complete, destroy, user_data);
+        } else if (iface->send) {
+            return binder_ext_sms_send_batch_fallback(self, smsc, pdus,
+                count, flags, complete, destroy, user_data);
+        }
+    }
+    return 0;
+}
+
 void
 binder_ext_sms_cancel(
     BinderExtSms* self,
@@ -86,6 +341,24 @@ binder_ext_sms_cancel(
     }
 }
 
+void
+binder_ext_sms_cancel_batch(
+    BinderExtSms* self,
+    guint id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        BinderExtSmsInterface* iface = GET_IFACE(self);
+
+        if (iface->version > 1 && iface->send_batch) {
+            if (iface->cancel) {
+                iface->cancel(self, id);
+            }
+        } else {
+            binder_ext_sms_cancel_batch_fallback(self, iface, id);
+        }
+    }
+}
+
 gulong
 binder_ext_sms_add_report_handler(
     BinderExtSms* self,
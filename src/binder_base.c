@@ -29,19 +29,48 @@ typedef struct binder_base_closure {
     gpointer user_data;
 } BinderBaseClosure;
 
+typedef struct binder_base_mask_closure {
+    GCClosure cclosure;
+    BinderBasePropertiesFunc callback;
+    gpointer user_data;
+} BinderBaseMaskClosure;
+
+/* Hidden header preceding the snapshot data */
+typedef union binder_base_snapshot_priv {
+    struct {
+        gint ref_count;
+        GDestroyNotify clear;
+    } h;
+    gint64 align1;
+    gpointer align2;
+    double align3;
+} BinderBaseSnapshotPriv;
+
+#define SNAPSHOT_LOCK_BIT (0)
+#define SNAPSHOT_LOCK_MASK ((gsize)1 << SNAPSHOT_LOCK_BIT)
+#define SNAPSHOT_STALE_BIT (1)
+#define SNAPSHOT_STALE_MASK ((gsize)1 << SNAPSHOT_STALE_BIT)
+#define SNAPSHOT_FLAGS (SNAPSHOT_LOCK_MASK | SNAPSHOT_STALE_MASK)
+#define snapshot_ptr(ptr) ((gpointer)((gsize)(ptr) & ~SNAPSHOT_FLAGS))
+#define snapshot_priv(ptr) (((BinderBaseSnapshotPriv*)(ptr)) - 1)
+
 #define binder_base_closure_new() ((BinderBaseClosure*) \
     g_closure_new_simple(sizeof(BinderBaseClosure), NULL))
+#define binder_base_mask_closure_new() ((BinderBaseMaskClosure*) \
+    g_closure_new_simple(sizeof(BinderBaseMaskClosure), NULL))
 
 G_DEFINE_ABSTRACT_TYPE(BinderBase, binder_base, G_TYPE_OBJECT)
 #define GET_CLASS(obj) G_TYPE_INSTANCE_GET_CLASS((obj), \
    BINDER_TYPE_BASE, BinderBaseClass)
 
 #define SIGNAL_PROPERTY_CHANGED_NAME    "binder-base-property-changed"
+#define SIGNAL_PROPERTIES_CHANGED_NAME  "binder-base-properties-changed"
 #define SIGNAL_PROPERTY_DETAIL          "%x"
 #define SIGNAL_PROPERTY_DETAIL_MAX_LEN  (8)
 
 enum binder_base_signal {
     SIGNAL_PROPERTY_CHANGED,
+    SIGNAL_PROPERTIES_CHANGED,
     SIGNAL_COUNT
 };
 
@@ -83,6 +112,32 @@ binder_base_property_changed(
         closure->user_data);
 }
 
+static
+void
+binder_base_properties_changed(
+    BinderBase* self,
+    guint mask,
+    BinderBaseMaskClosure* closure)
+{
+    const BinderBaseClass* klass = GET_CLASS(self);
+
+    closure->callback(((guint8*)self) + klass->public_offset, mask,
+        closure->user_data);
+}
+
+static
+void
+binder_base_invalidate_snapshot(
+    BinderBase* self)
+{
+    if (GET_CLASS(self)->snapshot) {
+        g_pointer_bit_lock(&self->snapshot, SNAPSHOT_LOCK_BIT);
+        g_atomic_pointer_set(&self->snapshot, (gpointer)
+            ((gsize)self->snapshot | SNAPSHOT_STALE_MASK));
+        g_pointer_bit_unlock(&self->snapshot, SNAPSHOT_LOCK_BIT);
+    }
+}
+
 /*==========================================================================*
  * API
  *==========================================================================*/
@@ -117,6 +172,29 @@ binder_base_add_property_handler(
     return 0;
 }
 
+gulong
+binder_base_add_properties_handler(
+    BinderBase* self,
+    BinderBasePropertiesFunc callback,
+    gpointer user_data)
+{
+    if (G_LIKELY(callback)) {
+        /* Same public pointer conversion as for the detailed signal */
+        BinderBaseMaskClosure* closure = binder_base_mask_closure_new();
+        GCClosure* cc = &closure->cclosure;
+
+        cc->closure.data = closure;
+        cc->callback = G_CALLBACK(binder_base_properties_changed);
+        closure->callback = callback;
+        closure->user_data = user_data;
+
+        return g_signal_connect_closure_by_id(self,
+            binder_base_signals[SIGNAL_PROPERTIES_CHANGED], 0,
+            &cc->closure, FALSE);
+    }
+    return 0;
+}
+
 void
 binder_base_queue_property_change(
     BinderBase* self,
@@ -138,8 +216,17 @@ void
 binder_base_emit_queued_signals(
     BinderBase* self)
 {
+    const guint mask = self->queued_signals;
     guint p;
 
+    /* Nothing is emitted until the outermost batch is committed */
+    if (self->batch_depth || !mask) {
+        return;
+    }
+
+    /* The next snapshot_ref() on the owner thread takes a new one */
+    binder_base_invalidate_snapshot(self);
+
     /* Signal handlers may release references to this object */
     g_object_ref(self);
 
@@ -152,10 +239,103 @@ binder_base_emit_queued_signals(
         }
     }
 
+    /* And then the combined one */
+    g_signal_emit(self, binder_base_signals[SIGNAL_PROPERTIES_CHANGED], 0,
+        mask);
+
     /* Release the temporary reference */
     g_object_unref(self);
 }
 
+void
+binder_base_begin_batch(
+    BinderBase* self)
+{
+    self->batch_depth++;
+}
+
+void
+binder_base_commit_batch(
+    BinderBase* self)
+{
+    GASSERT(self->batch_depth);
+    if (G_LIKELY(self->batch_depth) && !(--self->batch_depth)) {
+        binder_base_emit_queued_signals(self);
+    }
+}
+
+gpointer
+binder_base_snapshot_new(
+    gsize size,
+    GDestroyNotify clear)
+{
+    BinderBaseSnapshotPriv* priv = g_malloc0(sizeof(*priv) + size);
+
+    priv->h.ref_count = 1;
+    priv->h.clear = clear;
+    return priv + 1;
+}
+
+gconstpointer
+binder_base_snapshot_ref(
+    BinderBase* self)
+{
+    gpointer snapshot = NULL;
+
+    if (G_LIKELY(self)) {
+        /* Nobody else modifies the pointer, no need to lock for that */
+        if (self->owner == g_thread_self() &&
+            ((gsize)self->snapshot & SNAPSHOT_STALE_MASK)) {
+            binder_base_update_snapshot(self);
+        }
+
+        /* The lock is only held for as long as it takes to grab a ref */
+        g_pointer_bit_lock(&self->snapshot, SNAPSHOT_LOCK_BIT);
+        snapshot = snapshot_ptr(self->snapshot);
+        if (snapshot) {
+            g_atomic_int_inc(&snapshot_priv(snapshot)->h.ref_count);
+        }
+        g_pointer_bit_unlock(&self->snapshot, SNAPSHOT_LOCK_BIT);
+    }
+    return snapshot;
+}
+
+void
+binder_base_snapshot_unref(
+    gconstpointer snapshot)
+{
+    if (G_LIKELY(snapshot)) {
+        BinderBaseSnapshotPriv* priv = snapshot_priv(snapshot);
+
+        if (g_atomic_int_dec_and_test(&priv->h.ref_count)) {
+            if (priv->h.clear) {
+                priv->h.clear((gpointer)snapshot);
+            }
+            g_free(priv);
+        }
+    }
+}
+
+void
+binder_base_update_snapshot(
+    BinderBase* self)
+{
+    const BinderBaseClass* klass = GET_CLASS(self);
+
+    if (klass->snapshot) {
+        gpointer snapshot = klass->snapshot(self);
+        gpointer old;
+
+        g_pointer_bit_lock(&self->snapshot, SNAPSHOT_LOCK_BIT);
+        old = snapshot_ptr(self->snapshot);
+        /* Keep the lock bit set until g_pointer_bit_unlock() */
+        g_atomic_pointer_set(&self->snapshot, (gpointer)
+            ((gsize)snapshot | SNAPSHOT_LOCK_MASK));
+        g_pointer_bit_unlock(&self->snapshot, SNAPSHOT_LOCK_BIT);
+        binder_base_snapshot_unref(old);
+    }
+}
+
 /*==========================================================================*
  * Internals
  *==========================================================================*/
@@ -165,6 +345,18 @@ void
 binder_base_init(
     BinderBase* self)
 {
+    self->owner = g_thread_self();
+}
+
+static
+void
+binder_base_finalize(
+    GObject* object)
+{
+    BinderBase* self = (BinderBase*)object;
+
+    binder_base_snapshot_unref(snapshot_ptr(self->snapshot));
+    G_OBJECT_CLASS(binder_base_parent_class)->finalize(object);
 }
 
 static
@@ -172,12 +364,18 @@ void
 binder_base_class_init(
     BinderBaseClass* klass)
 {
+    G_OBJECT_CLASS(klass)->finalize = binder_base_finalize;
+
     /* By default assume that public part immediately follows BinderBase */
     klass->public_offset = sizeof(BinderBase);
     binder_base_signals[SIGNAL_PROPERTY_CHANGED] =
         g_signal_new(SIGNAL_PROPERTY_CHANGED_NAME, G_OBJECT_CLASS_TYPE(klass),
             G_SIGNAL_RUN_FIRST | G_SIGNAL_DETAILED, 0, NULL, NULL, NULL,
             G_TYPE_NONE, 1, G_TYPE_UINT);
+    binder_base_signals[SIGNAL_PROPERTIES_CHANGED] =
+        g_signal_new(SIGNAL_PROPERTIES_CHANGED_NAME,
+            G_OBJECT_CLASS_TYPE(klass), G_SIGNAL_RUN_FIRST, 0, NULL, NULL,
+            NULL, G_TYPE_NONE, 1, G_TYPE_UINT);
 }
 
 /*
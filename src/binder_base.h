@@ -20,15 +20,22 @@
 
 #include <glib-object.h>
 
+typedef struct binder_base BinderBase;
+
 typedef struct binder_base_class {
     GObjectClass object;
     int public_offset;
+    /* Allocates the snapshot with binder_base_snapshot_new() */
+    gpointer (*snapshot)(BinderBase* base);
 } BinderBaseClass;
 
-typedef struct binder_base {
+struct binder_base {
     GObject object;
     gsize queued_signals;
-} BinderBase;
+    guint batch_depth;
+    gpointer snapshot;
+    GThread* owner;
+};
 
 BINDER_INTERNAL GType binder_base_get_type(void);
 #define BINDER_TYPE_BASE (binder_base_get_type())
@@ -44,6 +51,19 @@ typedef enum binder_base_property {
 #define BINDER_BASE_ASSERT_COUNT(count) \
     G_STATIC_ASSERT((int)count <= (int)BINDER_BASE_MAX_PROPERTIES)
 
+/*
+ * Handlers registered with binder_base_add_properties_handler() receive
+ * a single callback per emission, with the bits (see
+ * BINDER_BASE_PROPERTY_BIT) of all the properties that have changed.
+ * That is emitted after the individual property change signals.
+ */
+typedef
+void
+(*BinderBasePropertiesFunc)(
+    gpointer source,
+    guint mask,
+    gpointer user_data);
+
 gulong
 binder_base_add_property_handler(
     BinderBase* base,
@@ -52,6 +72,13 @@ binder_base_add_property_handler(
     gpointer user_data)
     BINDER_INTERNAL;
 
+gulong
+binder_base_add_properties_handler(
+    BinderBase* base,
+    BinderBasePropertiesFunc callback,
+    gpointer user_data)
+    BINDER_INTERNAL;
+
 void
 binder_base_queue_property_change(
     BinderBase* base,
@@ -69,6 +96,54 @@ binder_base_emit_queued_signals(
     BinderBase* base)
     BINDER_INTERNAL;
 
+/*
+ * Between binder_base_begin_batch() and the matching
+ * binder_base_commit_batch() property changes are only queued.
+ * The outermost commit emits them all at once. Batches may nest.
+ */
+void
+binder_base_begin_batch(
+    BinderBase* base)
+    BINDER_INTERNAL;
+
+void
+binder_base_commit_batch(
+    BinderBase* base)
+    BINDER_INTERNAL;
+
+/*
+ * Immutable refcounted snapshots of the public state. If the class
+ * provides the snapshot callback, emitting the property change signals
+ * marks the current snapshot stale, and the next binder_base_snapshot_ref()
+ * on the thread which created the object takes a new one. Nothing gets
+ * allocated for the changes which nobody looks at.
+ *
+ * Snapshots are swapped in atomically, binder_base_snapshot_ref() may
+ * be called from any thread and never sees the state in the middle of
+ * an update. Other threads get the last snapshot taken by the owner,
+ * binder_base_update_snapshot() takes one right away.
+ */
+gpointer
+binder_base_snapshot_new(
+    gsize size,
+    GDestroyNotify clear)
+    BINDER_INTERNAL;
+
+gconstpointer
+binder_base_snapshot_ref(
+    BinderBase* base)
+    BINDER_INTERNAL;
+
+void
+binder_base_snapshot_unref(
+    gconstpointer snapshot)
+    BINDER_INTERNAL;
+
+void
+binder_base_update_snapshot(
+    BinderBase* base)
+    BINDER_INTERNAL;
+
 #endif /* BINDER_BASE_H */
 
 /*
@@ -0,0 +1,310 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_base.h"
+#include "binder_batman.h"
+#include "binder_log.h"
+#include "binder_wakeup.h"
+
+#include <ofono/log.h>
+
+#include <gutil_macros.h>
+
+#include <batman/batman-wrappers.h>
+
+#include <sys/inotify.h>
+#include <limits.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+BINDER_BASE_ASSERT_COUNT(BINDER_BATMAN_PROPERTY_COUNT);
+
+#define BATMAN_SCREEN_PATH "/var/lib/batman/screen"
+#define EVENT_BUF_LEN     (10 * (sizeof(struct inotify_event) + NAME_MAX + 1))
+
+typedef BinderBaseClass BatmanObjectClass;
+typedef struct batman_object {
+    BinderBase base;
+    BinderBatman pub;
+    UpClient* upower;
+    int inotify_fd;
+    int screen_wd;
+    guint watch_source;
+} BatmanObject;
+
+GType batman_object_get_type() BINDER_INTERNAL;
+G_DEFINE_TYPE(BatmanObject, batman_object, BINDER_TYPE_BASE)
+#define PARENT_CLASS batman_object_parent_class
+#define THIS_TYPE batman_object_get_type()
+#define THIS(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, THIS_TYPE, BatmanObject)
+
+static inline
+BatmanObject*
+batman_object_cast(
+    BinderBatman* batman)
+{
+    return G_LIKELY(batman) ?
+        THIS(G_CAST(batman, BatmanObject, pub)) :
+        NULL;
+}
+
+static
+void
+batman_object_read_state(
+    BatmanObject* self)
+{
+    BinderBatman* batman = &self->pub;
+    gboolean display_on = FALSE;
+    int battery_state;
+    FILE* screen_file = fopen(BATMAN_SCREEN_PATH, "r");
+
+    if (screen_file) {
+        char screen_state[4];
+
+        if (fgets(screen_state, sizeof(screen_state), screen_file)) {
+            display_on = !strncmp(screen_state, "yes", 3);
+            DBG("screen state: %s", screen_state);
+        } else {
+            DBG("Failed to read screen state");
+        }
+        fclose(screen_file);
+    } else {
+        DBG("Failed to open screen state file: %s", strerror(errno));
+    }
+
+    battery_state = get_battery_state(self->upower);
+    DBG("Battery state: %s", binder_batman_battery_state_name(battery_state));
+
+    /* Subscribers only hear about actual changes */
+    if (!batman->valid || batman->display_on != display_on ||
+        batman->battery_state != battery_state) {
+        batman->valid = TRUE;
+        batman->display_on = display_on;
+        batman->battery_state = battery_state;
+        binder_base_emit_property_change(&self->base,
+            BINDER_BATMAN_PROPERTY_STATE);
+    }
+}
+
+static
+gboolean
+batman_object_inotify_cb(
+    GIOChannel* channel,
+    GIOCondition condition,
+    gpointer user_data)
+{
+    BatmanObject* self = THIS(user_data);
+    gchar buf[EVENT_BUF_LEN];
+    gsize bytes_read;
+    GError* error = NULL;
+    GIOStatus status;
+
+    binder_wakeup("batman screen");
+    if (condition & (G_IO_HUP | G_IO_ERR | G_IO_NVAL)) {
+        DBG("inotify watch failed, condition: %d", condition);
+        self->watch_source = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    /* Drain all pending events, the file is only read once */
+    status = g_io_channel_read_chars(channel, buf, sizeof(buf),
+        &bytes_read, &error);
+    if (status == G_IO_STATUS_ERROR) {
+        if (error) {
+            DBG("inotify read failed, error: %s", error->message);
+            g_error_free(error);
+        }
+        self->watch_source = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    if (bytes_read == 0) {
+        DBG("No bytes read from inotify");
+    } else {
+        batman_object_read_state(self);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static
+void
+batman_object_init_watch(
+    BatmanObject* self)
+{
+    GIOChannel* channel;
+
+    self->inotify_fd = inotify_init();
+    if (self->inotify_fd < 0) {
+        DBG("Failed to initialize inotify: %s", strerror(errno));
+        return;
+    }
+
+    self->screen_wd = inotify_add_watch(self->inotify_fd,
+        BATMAN_SCREEN_PATH, IN_MODIFY | IN_CLOSE_WRITE);
+    if (self->screen_wd < 0) {
+        DBG("Failed to add watch: %s", strerror(errno));
+        close(self->inotify_fd);
+        self->inotify_fd = -1;
+        return;
+    }
+
+    DBG("watching %s, fd=%d wd=%d", BATMAN_SCREEN_PATH, self->inotify_fd,
+        self->screen_wd);
+
+    channel = g_io_channel_unix_new(self->inotify_fd);
+    g_io_channel_set_encoding(channel, NULL, NULL);
+    g_io_channel_set_flags(channel, G_IO_FLAG_NONBLOCK, NULL);
+    g_io_channel_set_buffered(channel, FALSE);
+    self->watch_source = g_io_add_watch(channel,
+        G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
+        batman_object_inotify_cb, self);
+    g_io_channel_unref(channel);
+
+    batman_object_read_state(self);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderBatman*
+binder_batman_new()
+{
+    static BatmanObject* instance = NULL;
+
+    if (instance) {
+        g_object_ref(instance);
+    } else {
+        instance = g_object_new(THIS_TYPE, NULL);
+        batman_object_init_watch(instance);
+        g_object_add_weak_pointer(G_OBJECT(instance), (gpointer*)
+            (&instance));
+    }
+    return &instance->pub;
+}
+
+BinderBatman*
+binder_batman_ref(
+    BinderBatman* batman)
+{
+    BatmanObject* self = batman_object_cast(batman);
+
+    if (G_LIKELY(self)) {
+        g_object_ref(self);
+    }
+    return batman;
+}
+
+void
+binder_batman_unref(
+    BinderBatman* batman)
+{
+    BatmanObject* self = batman_object_cast(batman);
+
+    if (G_LIKELY(self)) {
+        g_object_unref(self);
+    }
+}
+
+const char*
+binder_batman_battery_state_name(
+    int state)
+{
+    return state == BATMAN_NO_BATTERY ? "no battery" :
+        state == BATMAN_CHARGING ? "charging" :
+        state == BATMAN_DISCHARGING ? "discharging" :
+        state == BATMAN_FULLY_CHARGED ? "fully charged" : "unknown";
+}
+
+gulong
+binder_batman_add_state_changed_handler(
+    BinderBatman* batman,
+    BinderBatmanPropertyFunc callback,
+    void* user_data)
+{
+    BatmanObject* self = batman_object_cast(batman);
+
+    return G_LIKELY(self) ? binder_base_add_property_handler(&self->base,
+        BINDER_BATMAN_PROPERTY_STATE, G_CALLBACK(callback), user_data) : 0;
+}
+
+void
+binder_batman_remove_handler(
+    BinderBatman* batman,
+    gulong id)
+{
+    if (G_LIKELY(id)) {
+        BatmanObject* self = batman_object_cast(batman);
+
+        if (G_LIKELY(self)) {
+            g_signal_handler_disconnect(self, id);
+        }
+    }
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+batman_object_init(
+    BatmanObject* self)
+{
+    self->inotify_fd = -1;
+    self->screen_wd = -1;
+    self->pub.battery_state = BATMAN_UNKNOWN;
+    self->upower = up_client_new();
+}
+
+static
+void
+batman_object_finalize(
+    GObject* object)
+{
+    BatmanObject* self = THIS(object);
+
+    if (self->watch_source) {
+        g_source_remove(self->watch_source);
+    }
+    if (self->screen_wd >= 0) {
+        inotify_rm_watch(self->inotify_fd, self->screen_wd);
+    }
+    if (self->inotify_fd >= 0) {
+        close(self->inotify_fd);
+    }
+    g_object_unref(self->upower);
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+batman_object_class_init(
+    BatmanObjectClass* klass)
+{
+    G_OBJECT_CLASS(klass)->finalize = batman_object_finalize;
+    BINDER_BASE_CLASS(klass)->public_offset =
+        G_STRUCT_OFFSET(BatmanObject, pub);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,88 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_BATMAN_H
+#define BINDER_BATMAN_H
+
+#include "binder_types.h"
+
+/*
+ * Process-wide watcher of the screen state file maintained by batman.
+ * The file is watched and read once per change no matter how many
+ * slots (and device monitors) are interested in it. The battery state
+ * is sampled at the same time.
+ */
+
+typedef struct binder_batman {
+    gboolean valid;         /* The state file is being watched */
+    gboolean display_on;
+    int battery_state;      /* BATMAN_* */
+} BinderBatman;
+
+typedef enum binder_batman_property {
+    BINDER_BATMAN_PROPERTY_ANY,
+    BINDER_BATMAN_PROPERTY_STATE,
+    BINDER_BATMAN_PROPERTY_COUNT
+} BINDER_BATMAN_PROPERTY;
+
+typedef
+void
+(*BinderBatmanPropertyFunc)(
+    BinderBatman* batman,
+    BINDER_BATMAN_PROPERTY property,
+    void* user_data);
+
+BinderBatman*
+binder_batman_new(
+    void)
+    BINDER_INTERNAL;
+
+BinderBatman*
+binder_batman_ref(
+    BinderBatman* batman)
+    BINDER_INTERNAL;
+
+void
+binder_batman_unref(
+    BinderBatman* batman)
+    BINDER_INTERNAL;
+
+const char*
+binder_batman_battery_state_name(
+    int battery_state)
+    BINDER_INTERNAL;
+
+gulong
+binder_batman_add_state_changed_handler(
+    BinderBatman* batman,
+    BinderBatmanPropertyFunc fn,
+    void* user_data)
+    BINDER_INTERNAL;
+
+void
+binder_batman_remove_handler(
+    BinderBatman* batman,
+    gulong id)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_BATMAN_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -17,10 +17,12 @@
 #include "binder_log.h"
 #include "binder_modem.h"
 #include "binder_sim_card.h"
+#include "binder_ss_cache.h"
 #include "binder_util.h"
 
 #include <ofono/call-barring.h>
 #include <ofono/log.h>
+#include <ofono/watch.h>
 
 #include <radio_request.h>
 #include <radio_request_group.h>
@@ -32,12 +34,16 @@ typedef struct binder_call_barring {
     struct ofono_call_barring* b;
     BinderSimCard* card;
     RadioRequestGroup* g;
+    BinderSsCache* cache;
+    struct ofono_watch* watch;
     char* log_prefix;
     guint register_id;
 } BinderCallBarring;
 
 typedef struct binder_call_barring_callback_data {
     BinderCallBarring* self;
+    char* cache_key;
+    guint cache_gen;
     union call_barring_cb {
         ofono_call_barring_query_cb_t query;
         ofono_call_barring_set_cb_t set;
@@ -62,6 +68,8 @@ binder_call_barring_callback_data_new(
     BinderCallBarringCbData* cbd = g_slice_new0(BinderCallBarringCbData);
 
     cbd->self = self;
+    cbd->cache_gen = binder_ss_cache_generation(self->cache,
+        BINDER_SS_CACHE_CALL_BARRING);
     cbd->cb.ptr = cb;
     cbd->data = data;
     return cbd;
@@ -70,8 +78,11 @@ binder_call_barring_callback_data_new(
 static
 void
 binder_call_barring_callback_data_free(
-    gpointer cbd)
+    gpointer data)
 {
+    BinderCallBarringCbData* cbd = data;
+
+    g_free(cbd->cache_key);
     g_slice_free(BinderCallBarringCbData, cbd);
 }
 
@@ -93,10 +104,16 @@ binder_call_barring_query_ok(
      */
     gbinder_reader_copy(&reader, args);
     if (gbinder_reader_read_int32(&reader, &response)) {
+        BinderCallBarring* self = cbd->self;
         struct ofono_error err;
 
-        DBG_(cbd->self, "Active services: %d", response);
-        cbd->cb.query(binder_error_ok(&err), response, cbd->data);
+        DBG_(self, "Active services: %d", response);
+        binder_ss_cache_put(self->cache, self->watch->imsi,
+            BINDER_SS_CACHE_CALL_BARRING, cbd->cache_gen, cbd->cache_key,
+            &response, sizeof(response));
+        if (cbd->cb.query) {
+            cbd->cb.query(binder_error_ok(&err), response, cbd->data);
+        }
         return TRUE;
     }
     return FALSE;
@@ -128,7 +145,9 @@ binder_call_barring_query_cb(
             ofono_error("Unexpected getFacilityLockForApp response %d", resp);
         }
     }
-    cbd->cb.query(binder_error_failure(&err), 0, cbd->data);
+    if (cbd->cb.query) {
+        cbd->cb.query(binder_error_failure(&err), 0, cbd->data);
+    }
 }
 
 static
@@ -141,19 +160,40 @@ binder_call_barring_query(
     void* data)
 {
     BinderCallBarring* self = ofono_call_barring_get_data(b);
+    char* key = g_strdup_printf("%s/%d", lock, cls);
+    gboolean refresh;
+    GBytes* cached = binder_ss_cache_get(self->cache, self->watch->imsi,
+        BINDER_SS_CACHE_CALL_BARRING, key, &refresh);
+    BinderCallBarringCbData* cbd;
+    GBinderWriter writer;
+    RadioRequest* req;
+
+    DBG_(self, "lock: %s, services to query: 0x%02x", lock, cls);
+    if (cached) {
+        struct ofono_error err;
+        const gint32* response = g_bytes_get_data(cached, NULL);
+
+        DBG_(self, "Cached active services: %d%s", *response,
+            refresh ? ", refreshing" : "");
+        cb(binder_error_ok(&err), *response, data);
+        if (!refresh) {
+            g_free(key);
+            return;
+        }
+
+        /* The caller has been served, just update the cache */
+        cb = NULL;
+    }
 
     /*
      * getFacilityLockForApp(int32_t serial, string facility,
      *      string password, int32_t serviceClass, string appId);
      */
-    GBinderWriter writer;
-    RadioRequest* req = radio_request_new2(self->g,
-        RADIO_REQ_GET_FACILITY_LOCK_FOR_APP, &writer,
-        binder_call_barring_query_cb,
-        binder_call_barring_callback_data_free,
-        binder_call_barring_callback_data_new(self, BINDER_CB(cb), data));
-
-    DBG_(self, "lock: %s, services to query: 0x%02x", lock, cls);
+    cbd = binder_call_barring_callback_data_new(self, BINDER_CB(cb), data);
+    cbd->cache_key = key;
+    req = radio_request_new2(self->g, RADIO_REQ_GET_FACILITY_LOCK_FOR_APP,
+        &writer, binder_call_barring_query_cb,
+        binder_call_barring_callback_data_free, cbd);
     binder_append_hidl_string(&writer, lock);   /* facility */
     binder_append_hidl_string(&writer, "");     /* password */
     gbinder_writer_append_int32(&writer, cls);  /* serviceClass */
@@ -185,6 +225,9 @@ binder_call_barring_set_cb(
              * retry - the number of retries remaining, or -1 if unknown
              */
             if (error == RADIO_ERROR_NONE) {
+                /* Facilities may overlap (e.g. AB), drop them all */
+                binder_ss_cache_invalidate(cbd->self->cache,
+                    BINDER_SS_CACHE_CALL_BARRING);
                 cb(binder_error_ok(&err), cbd->data);
                 return;
             } else {
@@ -320,6 +363,8 @@ binder_call_barring_probe(
     self->b = b;
     self->card = binder_sim_card_ref(modem->sim_card);
     self->g = radio_request_group_new(modem->client);
+    self->cache = modem->ss_cache;
+    self->watch = ofono_watch_new(binder_modem_get_path(modem));
     self->log_prefix = binder_dup_prefix(modem->log_prefix);
     self->register_id = g_idle_add(binder_call_barring_register, self);
 
@@ -342,6 +387,7 @@ binder_call_barring_remove(
     binder_sim_card_unref(self->card);
     radio_request_group_cancel(self->g);
     radio_request_group_unref(self->g);
+    ofono_watch_unref(self->watch);
     g_free(self->log_prefix);
     g_free(self);
 
@@ -16,10 +16,12 @@
 #include "binder_call_forwarding.h"
 #include "binder_log.h"
 #include "binder_modem.h"
+#include "binder_ss_cache.h"
 #include "binder_util.h"
 
 #include <ofono/call-forwarding.h>
 #include <ofono/log.h>
+#include <ofono/watch.h>
 
 #include <radio_request.h>
 #include <radio_request_group.h>
@@ -27,21 +29,42 @@
 #include <gbinder_reader.h>
 #include <gbinder_writer.h>
 
+/* Condition types, as defined by 3GPP TS 27.007 */
+enum binder_call_forwarding_reason {
+    CF_REASON_UNCONDITIONAL,
+    CF_REASON_BUSY,
+    CF_REASON_NO_REPLY,
+    CF_REASON_NOT_REACHABLE,
+    CF_REASON_COUNT /* Individual conditions only */
+};
+
+typedef struct binder_call_forwarding_cbd BinderCallForwardingCbData;
+
 typedef struct binder_call_forwarding {
     struct ofono_call_forwarding* f;
     RadioRequestGroup* g;
+    BinderSsCache* cache;
+    struct ofono_watch* watch;
     char* log_prefix;
     guint register_id;
+    gboolean prefetch_disabled;
+    BinderCallForwardingCbData* prefetch[CF_REASON_COUNT];
 } BinderCallForwarding;
 
-typedef struct binder_call_forwarding_cbd {
+struct binder_call_forwarding_cbd {
+    BinderCallForwarding* self;
+    char* cache_key;
+    guint cache_gen;
+    int type;
+    int cls;
+    gboolean prefetch;
     union call_forwarding_cb {
         ofono_call_forwarding_query_cb_t query;
         ofono_call_forwarding_set_cb_t set;
         BinderCallback ptr;
     } cb;
     gpointer data;
-} BinderCallForwardingCbData;
+};
 
 #define CF_TIME_DEFAULT (0)
 
@@ -54,11 +77,15 @@ binder_call_forwarding_get_data(struct ofono_call_forwarding* f)
 static
 BinderCallForwardingCbData*
 binder_call_forwarding_callback_data_new(
+    BinderCallForwarding* self,
     BinderCallback cb,
     void* data)
 {
     BinderCallForwardingCbData* cbd = g_slice_new0(BinderCallForwardingCbData);
 
+    cbd->self = self;
+    cbd->cache_gen = binder_ss_cache_generation(self->cache,
+        BINDER_SS_CACHE_CALL_FORWARDING);
     cbd->cb.ptr = cb;
     cbd->data = data;
     return cbd;
@@ -67,13 +94,20 @@ binder_call_forwarding_callback_data_new(
 static
 void
 binder_call_forwarding_callback_data_free(
-    gpointer cbd)
+    gpointer data)
 {
+    BinderCallForwardingCbData* cbd = data;
+    BinderCallForwarding* self = cbd->self;
+
+    if (cbd->prefetch && self->prefetch[cbd->type] == cbd) {
+        self->prefetch[cbd->type] = NULL;
+    }
+    g_free(cbd->cache_key);
     g_slice_free(BinderCallForwardingCbData, cbd);
 }
 
 static
-void
+BinderCallForwardingCbData*
 binder_call_forwarding_call(
     BinderCallForwarding* self,
     RADIO_REQ code,
@@ -83,6 +117,7 @@ binder_call_forwarding_call(
     const struct ofono_phone_number* number,
     int time,
     RadioRequestCompleteFunc complete,
+    char* cache_key, /* Takes ownership */
     BinderCallback cb,
     void* data)
 {
@@ -91,13 +126,15 @@ binder_call_forwarding_call(
      * setCallForward(int32_t serial, CallForwardInfo callInfo);
      */
     GBinderWriter writer;
+    BinderCallForwardingCbData* cbd =
+        binder_call_forwarding_callback_data_new(self, cb, data);
     RadioRequest* req = radio_request_new2(self->g, code, &writer, complete,
-        binder_call_forwarding_callback_data_free,
-        binder_call_forwarding_callback_data_new(cb, data));
+        binder_call_forwarding_callback_data_free, cbd);
     RadioCallForwardInfo* info = gbinder_writer_new0(&writer,
         RadioCallForwardInfo);
     guint parent;
 
+    cbd->cache_key = cache_key;
     info->status = action;
     info->reason = reason;
     info->serviceClass = cls;
@@ -114,6 +151,7 @@ binder_call_forwarding_call(
 
     radio_request_submit(req);
     radio_request_unref(req);
+    return cbd;
 }
 
 static
@@ -133,6 +171,9 @@ binder_call_forwarding_set_cb(
     if (status == RADIO_TX_STATUS_OK) {
         if (resp == RADIO_RESP_SET_CALL_FORWARD) {
             if (error == RADIO_ERROR_NONE) {
+                /* Conditions may overlap, drop them all */
+                binder_ss_cache_invalidate(cbd->self->cache,
+                    BINDER_SS_CACHE_CALL_FORWARDING);
                 cb(binder_error_ok(&err), cbd->data);
                 return;
             } else {
@@ -159,7 +200,7 @@ binder_call_forwarding_set(
 {
     binder_call_forwarding_call(self, RADIO_REQ_SET_CALL_FORWARD,
         action, reason, cls, number, time, binder_call_forwarding_set_cb,
-        BINDER_CB(cb), data);
+        NULL, BINDER_CB(cb), data);
 }
 
 static
@@ -235,6 +276,7 @@ binder_call_forwarding_query_ok(
     const GBinderReader* args)
 {
     struct ofono_error err;
+    BinderCallForwarding* self = cbd->self;
     const RadioCallForwardInfo* infos;
     struct ofono_call_forwarding_condition* list = NULL;
     GBinderReader reader;
@@ -260,10 +302,29 @@ binder_call_forwarding_query_ok(
                 MIN(OFONO_MAX_PHONE_NUMBER_LENGTH, info->number.len));
         }
     }
-    cbd->cb.query(binder_error_ok(&err), count, list, cbd->data);
+    binder_ss_cache_put(self->cache, self->watch->imsi,
+        BINDER_SS_CACHE_CALL_FORWARDING, cbd->cache_gen, cbd->cache_key,
+        list, count * sizeof(*list));
+    if (cbd->cb.query) {
+        cbd->cb.query(binder_error_ok(&err), count, list, cbd->data);
+    } else {
+        DBG_(self, "%s %s", cbd->cache_key, cbd->prefetch ?
+            "prefetched" : "refreshed");
+    }
     g_free(list);
 }
 
+static
+BinderCallForwardingCbData*
+binder_call_forwarding_query_submit(
+    BinderCallForwarding* self,
+    int type,
+    int cls,
+    char* key, /* Takes ownership */
+    gboolean prefetch,
+    ofono_call_forwarding_query_cb_t cb,
+    void* data);
+
 static
 void
 binder_call_forwarding_query_cb(
@@ -276,6 +337,7 @@ binder_call_forwarding_query_cb(
 {
     struct ofono_error err;
     const BinderCallForwardingCbData* cbd = user_data;
+    BinderCallForwarding* self = cbd->self;
 
     if (status == RADIO_TX_STATUS_OK) {
         if (resp == RADIO_RESP_GET_CALL_FORWARD_STATUS) {
@@ -289,7 +351,113 @@ binder_call_forwarding_query_cb(
             ofono_error("Unexpected getCallForwardStatus response %d", resp);
         }
     }
-    cbd->cb.query(binder_error_failure(&err), 0, NULL, cbd->data);
+
+    if (cbd->prefetch) {
+        /*
+         * Some RILs don't cope with concurrent SS requests. Stop
+         * prefetching and give the query a second chance on its own.
+         */
+        DBG_(self, "%s prefetch failed", cbd->cache_key);
+        self->prefetch_disabled = TRUE;
+        if (cbd->cb.query) {
+            binder_call_forwarding_query_submit(self, cbd->type, cbd->cls,
+                g_strdup(cbd->cache_key), FALSE, cbd->cb.query, cbd->data);
+            return;
+        }
+    }
+
+    if (cbd->cb.query) {
+        cbd->cb.query(binder_error_failure(&err), 0, NULL, cbd->data);
+    }
+}
+
+static
+BinderCallForwardingCbData*
+binder_call_forwarding_query_submit(
+    BinderCallForwarding* self,
+    int type,
+    int cls,
+    char* key,
+    gboolean prefetch,
+    ofono_call_forwarding_query_cb_t cb,
+    void* data)
+{
+    BinderCallForwardingCbData* cbd = binder_call_forwarding_call(self,
+        RADIO_REQ_GET_CALL_FORWARD_STATUS, RADIO_CALL_FORWARD_INTERROGATE,
+        type, cls, NULL, CF_TIME_DEFAULT, binder_call_forwarding_query_cb,
+        key, BINDER_CB(cb), data);
+
+    cbd->type = type;
+    cbd->cls = cls;
+    cbd->prefetch = prefetch;
+    return cbd;
+}
+
+static
+char*
+binder_call_forwarding_cache_key(
+    int type,
+    int cls)
+{
+    return g_strdup_printf("%d/%d", type, cls);
+}
+
+/*
+ * ofono queries the conditions one after another, each taking a
+ * network round trip. When it asks for the first one, the rest get
+ * requested right away too, in a single burst. The results end up
+ * in the cache, and the queries which are still in flight when ofono
+ * gets to them pick up the callback instead of being submitted again.
+ */
+static
+void
+binder_call_forwarding_prefetch(
+    BinderCallForwarding* self,
+    int cls)
+{
+    int type;
+
+    for (type = CF_REASON_UNCONDITIONAL + 1; type < CF_REASON_COUNT;
+         type++) {
+        char* key;
+        gboolean refresh;
+
+        if (self->prefetch[type]) {
+            continue;
+        }
+
+        key = binder_call_forwarding_cache_key(type, cls);
+        binder_ss_cache_get(self->cache, self->watch->imsi,
+            BINDER_SS_CACHE_CALL_FORWARDING, key, &refresh);
+        if (refresh) {
+            self->prefetch[type] = binder_call_forwarding_query_submit(self,
+                type, cls, key, TRUE, NULL, NULL);
+        } else {
+            g_free(key);
+        }
+    }
+}
+
+static
+gboolean
+binder_call_forwarding_join_prefetch(
+    BinderCallForwarding* self,
+    int type,
+    int cls,
+    ofono_call_forwarding_query_cb_t cb,
+    void* data)
+{
+    if (type >= 0 && type < CF_REASON_COUNT) {
+        BinderCallForwardingCbData* cbd = self->prefetch[type];
+
+        if (cbd && cbd->cls == cls && !cbd->cb.query) {
+            DBG_(self, "%s is being prefetched", cbd->cache_key);
+            cbd->cb.query = cb;
+            cbd->data = data;
+            return TRUE;
+        }
+    }
+    return FALSE;
 }
 
 static
@@ -302,6 +470,9 @@ binder_call_forwarding_query(
     void* data)
 {
     BinderCallForwarding* self = binder_call_forwarding_get_data(f);
+    GBytes* cached;
+    gboolean refresh;
+    char* key;
 
     DBG_(self, "%d", type);
 
@@ -311,9 +482,39 @@ binder_call_forwarding_query(
         DBG_(self, "cls %d => %d", cls, RADIO_SERVICE_CLASS_NONE);
         cls = RADIO_SERVICE_CLASS_NONE;
     }
-    binder_call_forwarding_call(self, RADIO_REQ_GET_CALL_FORWARD_STATUS,
-        RADIO_CALL_FORWARD_INTERROGATE, type, cls, NULL, CF_TIME_DEFAULT,
-        binder_call_forwarding_query_cb, BINDER_CB(cb), data);
+
+    key = binder_call_forwarding_cache_key(type, cls);
+    cached = binder_ss_cache_get(self->cache, self->watch->imsi,
+        BINDER_SS_CACHE_CALL_FORWARDING, key, &refresh);
+    if (cached) {
+        struct ofono_error err;
+        gsize size;
+        const struct ofono_call_forwarding_condition* list =
+            g_bytes_get_data(cached, &size);
+
+        DBG_(self, "%s cached%s", key, refresh ? ", refreshing" : "");
+        cb(binder_error_ok(&err), size / sizeof(*list), list, data);
+        if (!refresh) {
+            g_free(key);
+            return;
+        }
+
+        /* The caller has been served, just update the cache */
+        cb = NULL;
+    } else if (binder_call_forwarding_join_prefetch(self, type, cls,
+        cb, data)) {
+        g_free(key);
+        return;
+    }
+
+    binder_call_forwarding_query_submit(self, type, cls, key, FALSE,
+        cb, data);
+
+    /* Prefetching only makes sense if the results can be cached */
+    if (type == CF_REASON_UNCONDITIONAL && !self->prefetch_disabled &&
+        binder_ss_cache_active(self->cache, self->watch->imsi)) {
+        binder_call_forwarding_prefetch(self, cls);
+    }
 }
 
 static
@@ -341,6 +542,8 @@ binder_call_forwarding_probe(
 
     self->f = f;
     self->g = radio_request_group_new(modem->client);
+    self->cache = modem->ss_cache;
+    self->watch = ofono_watch_new(binder_modem_get_path(modem));
     self->log_prefix = binder_dup_prefix(modem->log_prefix);
     self->register_id = g_idle_add(binder_call_forwarding_register, self);
 
@@ -362,6 +565,7 @@ binder_call_forwarding_remove(
     }
     radio_request_group_cancel(self->g);
     radio_request_group_unref(self->g);
+    ofono_watch_unref(self->watch);
     g_free(self->log_prefix);
     g_free(self);
 
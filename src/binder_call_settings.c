@@ -16,10 +16,12 @@
 #include "binder_call_settings.h"
 #include "binder_log.h"
 #include "binder_modem.h"
+#include "binder_ss_cache.h"
 #include "binder_util.h"
 
 #include <ofono/call-settings.h>
 #include <ofono/log.h>
+#include <ofono/watch.h>
 
 #include <radio_request.h>
 #include <radio_request_group.h>
@@ -30,10 +32,25 @@
 typedef struct binder_call_settings {
     struct ofono_call_settings* s;
     RadioRequestGroup* g;
+    BinderSsCache* cache;
+    struct ofono_watch* watch;
+    GHashTable* queries; /* key => BinderCallSettingsCbData (not owned) */
     char* log_prefix;
     guint register_id;
 } BinderCallSettings;
 
+typedef enum binder_call_settings_query_type {
+    QUERY_NONE,
+    QUERY_CLIP,
+    QUERY_CLIR,
+    QUERY_CW
+} BINDER_CALL_SETTINGS_QUERY;
+
+typedef struct binder_call_settings_waiter {
+    BinderCallback cb;
+    gpointer data;
+} BinderCallSettingsWaiter;
+
 typedef struct binder_call_settings_cbd {
     BinderCallSettings* self;
     union call_settings_cb {
@@ -43,6 +60,10 @@ typedef struct binder_call_settings_cbd {
         BinderCallback ptr;
     } cb;
     gpointer data;
+    BINDER_CALL_SETTINGS_QUERY query;
+    char* cache_key;
+    guint cache_gen;
+    GSList* waiters; /* Overlapping queries */
 } BinderCallSettingsCbData;
 
 #define DBG_(self,fmt,args...) DBG("%s" fmt, (self)->log_prefix, ##args)
@@ -68,27 +89,29 @@ binder_call_settings_callback_data_new(
 
 static
 void
-binder_call_settings_callback_data_free(
-    gpointer cbd)
+binder_call_settings_waiter_free(
+    gpointer waiter)
 {
-    g_slice_free(BinderCallSettingsCbData, cbd);
+    g_slice_free(BinderCallSettingsWaiter, waiter);
 }
 
 static
 void
-binder_call_settings_call(
-    BinderCallSettings* self,
-    RADIO_REQ code,
-    RadioRequestCompleteFunc complete,
-    BinderCallback cb,
-    void* data)
+binder_call_settings_callback_data_free(
+    gpointer data)
 {
-    RadioRequest* req = radio_request_new2(self->g, code, NULL, complete,
-        binder_call_settings_callback_data_free,
-        binder_call_settings_callback_data_new(self, cb, data));
+    BinderCallSettingsCbData* cbd = data;
 
-    radio_request_submit(req);
-    radio_request_unref(req);
+    if (cbd->cache_key) {
+        GHashTable* queries = cbd->self->queries;
+
+        if (g_hash_table_lookup(queries, cbd->cache_key) == cbd) {
+            g_hash_table_remove(queries, cbd->cache_key);
+        }
+        g_free(cbd->cache_key);
+    }
+    g_slist_free_full(cbd->waiters, binder_call_settings_waiter_free);
+    g_slice_free(BinderCallSettingsCbData, cbd);
 }
 
 static
@@ -106,6 +129,8 @@ binder_call_settings_set_cb(
     ofono_call_settings_set_cb_t cb = cbd->cb.set;
 
     if (status == RADIO_TX_STATUS_OK && error == RADIO_ERROR_NONE) {
+        binder_ss_cache_invalidate(cbd->self->cache,
+            BINDER_SS_CACHE_CALL_SETTINGS);
         cb(binder_error_ok(&err), cbd->data);
     } else {
         cb(binder_error_failure(&err), cbd->data);
@@ -138,112 +163,96 @@ binder_call_settings_cw_set(
     radio_request_unref(req);
 }
 
-static
-gboolean
-binder_call_settings_cw_query_ok(
-    const BinderCallSettingsCbData* cbd,
-    const GBinderReader* args)
-{
-    struct ofono_error err;
-    ofono_call_settings_status_cb_t cb = cbd->cb.status;
-    GBinderReader reader;
-    gboolean enable;
-    gint32 cls;
-
-    /*
-     * getCallWaitingResponse(RadioResponseInfo, bool enable,
-     *     int32_t serviceClass);
-     */
-    gbinder_reader_copy(&reader, args);
-    if (gbinder_reader_read_bool(&reader, &enable) &&
-        gbinder_reader_read_int32(&reader, &cls)) {
-        if (enable) {
-            DBG_(cbd->self, "CW enabled for %d", cls);
-            cb(binder_error_ok(&err), cls, cbd->data);
-        } else {
-            DBG_(cbd->self, "CW disabled");
-            cb(binder_error_ok(&err), 0, cbd->data);
-        }
-        return TRUE;
-    }
-    ofono_warn("Unexpected getCallWaitingResponse payload");
-    return FALSE;
-}
-
 static
 void
-binder_call_settings_cw_query_cb(
-    RadioRequest* req,
-    RADIO_TX_STATUS status,
-    RADIO_RESP resp,
-    RADIO_ERROR error,
-    const GBinderReader* args,
-    void* user_data)
+binder_call_settings_deliver(
+    BINDER_CALL_SETTINGS_QUERY query,
+    BinderCallback cb,
+    void* data,
+    const struct ofono_error* err,
+    int v1,
+    int v2)
 {
-    struct ofono_error err;
-    const BinderCallSettingsCbData* cbd = user_data;
-
-    if (status == RADIO_TX_STATUS_OK) {
-        if (resp == RADIO_RESP_GET_CALL_WAITING) {
-            if (error == RADIO_ERROR_NONE) {
-                if (binder_call_settings_cw_query_ok(cbd, args)) {
-                    return;
-                }
-            } else {
-                ofono_warn("CW query error %d", error);
-            }
+    if (cb) {
+        if (query == QUERY_CLIR) {
+            ((ofono_call_settings_clir_cb_t)cb)(err, v1, v2, data);
         } else {
-            ofono_error("Unexpected getCallWaiting response %d", resp);
+            ((ofono_call_settings_status_cb_t)cb)(err, v1, data);
         }
     }
-    cbd->cb.status(binder_error_failure(&err), -1, cbd->data);
 }
 
 static
-void binder_call_settings_cw_query(
-    struct ofono_call_settings* s,
-    int cls,
-    ofono_call_settings_status_cb_t cb,
-    void* data)
+void
+binder_call_settings_query_done(
+    const BinderCallSettingsCbData* cbd,
+    const struct ofono_error* err,
+    int v1,
+    int v2)
 {
-    BinderCallSettings* self = binder_call_settings_get_data(s);
+    GSList* l;
 
-    /* getCallWaiting(int32_t serial, int32_t serviceClass); */
-    GBinderWriter writer;
-    RadioRequest* req = radio_request_new2(self->g,
-        RADIO_REQ_GET_CALL_WAITING, &writer,
-        binder_call_settings_cw_query_cb,
-        binder_call_settings_callback_data_free,
-        binder_call_settings_callback_data_new(self, BINDER_CB(cb), data));
-
-    gbinder_writer_append_int32(&writer, cls);  /* serviceClass */
+    binder_call_settings_deliver(cbd->query, cbd->cb.ptr, cbd->data,
+        err, v1, v2);
+    for (l = cbd->waiters; l; l = l->next) {
+        const BinderCallSettingsWaiter* w = l->data;
 
-    radio_request_submit(req);
-    radio_request_unref(req);
+        binder_call_settings_deliver(cbd->query, w->cb, w->data, err, v1, v2);
+    }
 }
 
 static
 gboolean
-binder_call_settings_clip_query_ok(
+binder_call_settings_query_parse(
     const BinderCallSettingsCbData* cbd,
-    const GBinderReader* args)
+    const GBinderReader* args,
+    gint32* v)
 {
-    struct ofono_error err;
     GBinderReader reader;
-    gint32 status;
+    gboolean enable;
 
-    /* getClipResponse(RadioResponseInfo, ClipStatus status); */
     gbinder_reader_copy(&reader, args);
-    if (gbinder_reader_read_int32(&reader, &status)) {
-        cbd->cb.status(binder_error_ok(&err), status, cbd->data);
-        return TRUE;
+    switch (cbd->query) {
+    case QUERY_CW:
+        /*
+         * getCallWaitingResponse(RadioResponseInfo, bool enable,
+         *     int32_t serviceClass);
+         */
+        if (gbinder_reader_read_bool(&reader, &enable) &&
+            gbinder_reader_read_int32(&reader, v)) {
+            if (enable) {
+                DBG_(cbd->self, "CW enabled for %d", v[0]);
+            } else {
+                DBG_(cbd->self, "CW disabled");
+                v[0] = 0;
+            }
+            return TRUE;
+        }
+        ofono_warn("Unexpected getCallWaitingResponse payload");
+        break;
+    case QUERY_CLIP:
+        /* getClipResponse(RadioResponseInfo, ClipStatus status); */
+        if (gbinder_reader_read_int32(&reader, v)) {
+            return TRUE;
+        }
+        break;
+    case QUERY_CLIR:
+        /* getClirResponse(RadioResponseInfo info, int32_t n, int32_t m); */
+        if (gbinder_reader_read_int32(&reader, v) &&
+            gbinder_reader_read_int32(&reader, v + 1)) {
+            return TRUE;
+        }
+        ofono_warn("Unexpected getClirResponse payload");
+        break;
+    case QUERY_NONE:
+        break;
     }
     return FALSE;
 }
 
 static
 void
-binder_call_settings_clip_query_cb(
+binder_call_settings_query_cb(
     RadioRequest* req,
     RADIO_TX_STATUS status,
     RADIO_RESP resp,
@@ -253,86 +262,131 @@ binder_call_settings_clip_query_cb(
 {
     struct ofono_error err;
     const BinderCallSettingsCbData* cbd = user_data;
+    BinderCallSettings* self = cbd->self;
+    const RADIO_RESP expected = (cbd->query == QUERY_CW) ?
+        RADIO_RESP_GET_CALL_WAITING : (cbd->query == QUERY_CLIR) ?
+        RADIO_RESP_GET_CLIR : RADIO_RESP_GET_CLIP;
 
     if (status == RADIO_TX_STATUS_OK) {
-        if (resp == RADIO_RESP_GET_CLIP) {
+        if (resp == expected) {
             if (error == RADIO_ERROR_NONE) {
-                if (binder_call_settings_clip_query_ok(cbd, args)) {
+                gint32 v[2] = { -1, -1 };
+
+                if (binder_call_settings_query_parse(cbd, args, v)) {
+                    binder_ss_cache_put(self->cache, self->watch->imsi,
+                        BINDER_SS_CACHE_CALL_SETTINGS, cbd->cache_gen,
+                        cbd->cache_key, v, sizeof(v));
+                    binder_call_settings_query_done(cbd,
+                        binder_error_ok(&err), v[0], v[1]);
                     return;
                 }
             } else {
-                ofono_warn("CLIP query error %d", error);
+                ofono_warn("%s query error %d", cbd->cache_key, error);
             }
         } else {
-            ofono_error("Unexpected getClip response %d", resp);
+            ofono_error("Unexpected %s query response %d", cbd->cache_key,
+                resp);
         }
     }
-    cbd->cb.status(binder_error_failure(&err), -1, cbd->data);
+    binder_call_settings_query_done(cbd, binder_error_failure(&err), -1, -1);
 }
 
+/*
+ * Results are cached (see binder_ss_cache.h) and overlapping queries
+ * share the request which is already in flight.
+ */
 static
 void
-binder_call_settings_clip_query(
-    struct ofono_call_settings* s,
-    ofono_call_settings_status_cb_t cb,
+binder_call_settings_query(
+    BinderCallSettings* self,
+    BINDER_CALL_SETTINGS_QUERY query,
+    int cls,
+    BinderCallback cb,
     void* data)
 {
-    BinderCallSettings* self = binder_call_settings_get_data(s);
+    char* key = (query == QUERY_CW) ? g_strdup_printf("cw/%d", cls) :
+        g_strdup((query == QUERY_CLIR) ? "clir" : "clip");
+    BinderCallSettingsCbData* cbd;
+    RadioRequest* req;
+    GBinderWriter writer;
+    gboolean refresh;
+    GBytes* cached = binder_ss_cache_get(self->cache, self->watch->imsi,
+        BINDER_SS_CACHE_CALL_SETTINGS, key, &refresh);
+
+    if (cached) {
+        struct ofono_error err;
+        const gint32* v = g_bytes_get_data(cached, NULL);
+
+        DBG_(self, "%s cached%s", key, refresh ? ", refreshing" : "");
+        binder_call_settings_deliver(query, cb, data, binder_error_ok(&err),
+            v[0], v[1]);
+        if (!refresh) {
+            g_free(key);
+            return;
+        }
 
-    DBG_(self, "");
-    /* getClip(int32_t serial); */
-    binder_call_settings_call(self, RADIO_REQ_GET_CLIP,
-        binder_call_settings_clip_query_cb, BINDER_CB(cb), data);
+        /* The caller has been served, just update the cache */
+        cb = NULL;
+    }
+
+    cbd = g_hash_table_lookup(self->queries, key);
+    if (cbd) {
+        DBG_(self, "%s is in progress", key);
+        if (cb) {
+            BinderCallSettingsWaiter* w = g_slice_new(BinderCallSettingsWaiter);
+
+            w->cb = cb;
+            w->data = data;
+            cbd->waiters = g_slist_append(cbd->waiters, w);
+        }
+        g_free(key);
+        return;
+    }
+
+    /*
+     * getClip(int32_t serial);
+     * getClir(int32_t serial);
+     * getCallWaiting(int32_t serial, int32_t serviceClass);
+     */
+    DBG_(self, "%s", key);
+    cbd = binder_call_settings_callback_data_new(self, cb, data);
+    cbd->query = query;
+    cbd->cache_key = key;
+    cbd->cache_gen = binder_ss_cache_generation(self->cache,
+        BINDER_SS_CACHE_CALL_SETTINGS);
+    req = radio_request_new2(self->g, (query == QUERY_CW) ?
+        RADIO_REQ_GET_CALL_WAITING : (query == QUERY_CLIR) ?
+        RADIO_REQ_GET_CLIR : RADIO_REQ_GET_CLIP, &writer,
+        binder_call_settings_query_cb,
+        binder_call_settings_callback_data_free, cbd);
+    if (query == QUERY_CW) {
+        gbinder_writer_append_int32(&writer, cls);  /* serviceClass */
+    }
+    g_hash_table_insert(self->queries, key, cbd);
+    radio_request_submit(req);
+    radio_request_unref(req);
 }
 
 static
-gboolean
-binder_call_settings_clir_ok(
-    const BinderCallSettingsCbData* cbd,
-    const GBinderReader* args)
+void binder_call_settings_cw_query(
+    struct ofono_call_settings* s,
+    int cls,
+    ofono_call_settings_status_cb_t cb,
+    void* data)
 {
-    struct ofono_error err;
-    GBinderReader reader;
-    gint32 n, m;
-
-    /* getClirResponse(RadioResponseInfo info, int32_t n, int32_t m); */
-    gbinder_reader_copy(&reader, args);
-    if (gbinder_reader_read_int32(&reader, &n) &&
-        gbinder_reader_read_int32(&reader, &m)) {
-        cbd->cb.clir(binder_error_ok(&err), n, m, cbd->data);
-        return TRUE;
-    }
-    ofono_warn("Unexpected getClirResponse payload");
-    return FALSE;
+    binder_call_settings_query(binder_call_settings_get_data(s),
+        QUERY_CW, cls, BINDER_CB(cb), data);
 }
 
 static
 void
-binder_call_settings_clir_cb(
-    RadioRequest* req,
-    RADIO_TX_STATUS status,
-    RADIO_RESP resp,
-    RADIO_ERROR error,
-    const GBinderReader* args,
-    void* user_data)
+binder_call_settings_clip_query(
+    struct ofono_call_settings* s,
+    ofono_call_settings_status_cb_t cb,
+    void* data)
 {
-    struct ofono_error err;
-    const BinderCallSettingsCbData* cbd = user_data;
-
-    if (status == RADIO_TX_STATUS_OK) {
-        if (resp == RADIO_RESP_GET_CLIR) {
-            if (error == RADIO_ERROR_NONE) {
-                if (binder_call_settings_clir_ok(cbd, args)) {
-                    return;
-                }
-            } else {
-                ofono_warn("CW query error %d", error);
-            }
-        } else {
-            ofono_error("Unexpected getClir response %d", resp);
-        }
-    }
-    cbd->cb.clir(binder_error_failure(&err), -1, -1, cbd->data);
+    binder_call_settings_query(binder_call_settings_get_data(s),
+        QUERY_CLIP, 0, BINDER_CB(cb), data);
 }
 
 static
@@ -342,12 +396,8 @@ binder_call_settings_clir_query(
     ofono_call_settings_clir_cb_t cb,
     void* data)
 {
-    BinderCallSettings* self = binder_call_settings_get_data(s);
-
-    DBG_(self, "");
-    /* getClir(int32_t serial); */
-    binder_call_settings_call(self, RADIO_REQ_GET_CLIR,
-       binder_call_settings_clir_cb , BINDER_CB(cb), data);
+    binder_call_settings_query(binder_call_settings_get_data(s),
+        QUERY_CLIR, 0, BINDER_CB(cb), data);
 }
 
 static
@@ -401,6 +451,9 @@ binder_call_settings_probe(
 
     self->s = s;
     self->g = radio_request_group_new(modem->client);
+    self->cache = modem->ss_cache;
+    self->watch = ofono_watch_new(binder_modem_get_path(modem));
+    self->queries = g_hash_table_new(g_str_hash, g_str_equal);
     self->log_prefix = binder_dup_prefix(modem->log_prefix);
     self->register_id = g_idle_add(binder_call_settings_register, self);
 
@@ -422,6 +475,8 @@ binder_call_settings_remove(
     }
     radio_request_group_cancel(self->g);
     radio_request_group_unref(self->g);
+    g_hash_table_destroy(self->queries);
+    ofono_watch_unref(self->watch);
     g_free(self->log_prefix);
     g_free(self);
 
@@ -14,8 +14,10 @@
  */
 
 #include "binder_cbs.h"
+#include "binder_cbs_util.h"
 #include "binder_log.h"
 #include "binder_modem.h"
+#include "binder_retry.h"
 #include "binder_util.h"
 
 #include <ofono/cbs.h>
@@ -29,24 +31,36 @@
 #include <gbinder_writer.h>
 
 #include <gutil_macros.h>
-#include <gutil_strv.h>
 
 typedef struct binder_cbs {
     struct ofono_cbs* cbs;
     RadioRequestGroup* g;
     char* log_prefix;
+    BinderRetry retry;
     guint register_id;
     gulong event_id;
+    gulong reset_event_id;
+    GArray* applied; /* BinderCbsRange, NULL if unknown or deactivated */
+    BinderCbsRecent recent;
+    guint dropped;
+    guint pending; /* Requests in flight */
 } BinderCbs;
 
 typedef struct binder_cbs_cbd {
     BinderCbs* self;
     ofono_cbs_set_cb_t cb;
     gpointer data;
+    GArray* ranges; /* BinderCbsRange being applied */
 } BinderCbsCbData;
 
-#define CBS_CHECK_RETRY_MS    1000
-#define CBS_CHECK_RETRY_COUNT 30
+/*
+ * The modem answers INVALID_STATE until it's ready for CB. Backing off
+ * 1, 2, 4 and then 8 seconds, 6 retries give it about half a minute,
+ * the same as the fixed 1 second delay and 30 retries used to.
+ */
+#define CBS_CHECK_RETRY_MS     1000
+#define CBS_CHECK_RETRY_MAX_MS 8000
+#define CBS_CHECK_RETRY_COUNT  6
 
 #define DBG_(cd,fmt,args...) DBG("%s" fmt, (cd)->log_prefix, ##args)
 
@@ -65,17 +79,35 @@ binder_cbs_callback_data_new(
     cbd->self = self;
     cbd->cb = cb;
     cbd->data = data;
+    self->pending++;
     return cbd;
 }
 
 static
 void
 binder_cbs_callback_data_free(
-    gpointer cbd)
+    gpointer data)
 {
+    BinderCbsCbData* cbd = data;
+
+    cbd->self->pending--;
+    if (cbd->ranges) {
+        g_array_free(cbd->ranges, TRUE);
+    }
     g_slice_free(BinderCbsCbData, cbd);
 }
 
+static
+void
+binder_cbs_forget_applied(
+    BinderCbs* self)
+{
+    if (self->applied) {
+        g_array_free(self->applied, TRUE);
+        self->applied = NULL;
+    }
+}
+
 static
 gboolean
 binder_cbs_retry(
@@ -86,7 +118,15 @@ binder_cbs_retry(
     const GBinderReader* args,
     void* user_data)
 {
-    return error == RADIO_ERROR_INVALID_STATE;
+    BinderCbsCbData* cbd = user_data;
+    BinderCbs* self = cbd->self;
+
+    if (error == RADIO_ERROR_INVALID_STATE) {
+        return binder_retry_request(&self->retry, req, CBS_CHECK_RETRY_COUNT);
+    } else {
+        binder_retry_reset(&self->retry);
+        return FALSE;
+    }
 }
 
 static
@@ -101,10 +141,15 @@ binder_cbs_activate_cb(
 {
     struct ofono_error err;
     BinderCbsCbData* cbd = user_data;
+    BinderCbs* self = cbd->self;
 
+    binder_cbs_forget_applied(self);
     if (status == RADIO_TX_STATUS_OK) {
         if (resp == RADIO_RESP_SET_GSM_BROADCAST_ACTIVATION) {
             if (error == RADIO_ERROR_NONE) {
+                /* Remember what has been applied */
+                self->applied = cbd->ranges;
+                cbd->ranges = NULL;
                 cbd->cb(binder_error_ok(&err), cbd->data);
                 return;
             } else {
@@ -123,18 +168,19 @@ static
 void
 binder_cbs_activate(
     BinderCbs* self,
-    gboolean activate,
+    GArray* ranges, /* Takes ownership, NULL to deactivate */
     ofono_cbs_set_cb_t cb,
     void* data)
 {
     /* setGsmBroadcastActivation(int32_t serial, bool activate); */
+    const gboolean activate = (ranges != NULL);
     GBinderWriter writer;
+    BinderCbsCbData* cbd = binder_cbs_callback_data_new(self, cb, data);
     RadioRequest* req = radio_request_new2(self->g,
         RADIO_REQ_SET_GSM_BROADCAST_ACTIVATION, &writer,
-        binder_cbs_activate_cb,
-        binder_cbs_callback_data_free,
-        binder_cbs_callback_data_new(self, cb, data));
+        binder_cbs_activate_cb, binder_cbs_callback_data_free, cbd);
 
+    cbd->ranges = ranges;
     gbinder_writer_append_bool(&writer, activate);  /* activate */
     DBG_(self, "%sactivating CB", activate ? "" : "de");
     radio_request_set_retry_func(req, binder_cbs_retry);
@@ -159,7 +205,9 @@ binder_cbs_set_config_cb(
     if (status == RADIO_TX_STATUS_OK) {
         if (resp == RADIO_RESP_SET_GSM_BROADCAST_CONFIG) {
             if (error == RADIO_ERROR_NONE) {
-                binder_cbs_activate(cbd->self, TRUE, cbd->cb, cbd->data);
+                binder_cbs_activate(cbd->self, cbd->ranges, cbd->cb,
+                    cbd->data);
+                cbd->ranges = NULL;
                 return;
             } else {
                 ofono_warn("Failed to set broadcast config, error %d", error);
@@ -169,6 +217,7 @@ binder_cbs_set_config_cb(
                 resp);
         }
     }
+    binder_cbs_forget_applied(cbd->self);
     cbd->cb(binder_error_failure(&err), cbd->data);
 }
 
@@ -176,25 +225,25 @@ static
 void
 binder_cbs_set_config(
     BinderCbs* self,
-    const char* topics,
+    GArray* ranges, /* Takes ownership */
     ofono_cbs_set_cb_t cb,
     void* data)
 {
     /* setGsmBroadcastConfig(int32_t serial, vec<GsmBroadcastSmsConfigInfo>); */
     GBinderWriter writer;
+    BinderCbsCbData* cbd = binder_cbs_callback_data_new(self, cb, data);
     RadioRequest* req = radio_request_new2(self->g,
         RADIO_REQ_SET_GSM_BROADCAST_CONFIG, &writer,
-        binder_cbs_set_config_cb,
-        binder_cbs_callback_data_free,
-        binder_cbs_callback_data_new(self, cb, data));
+        binder_cbs_set_config_cb, binder_cbs_callback_data_free, cbd);
 
     GBinderParent parent;
     GBinderHidlVec* vec = gbinder_writer_new0(&writer, GBinderHidlVec);
     RadioGsmBroadcastSmsConfig* configs = NULL;
-    char** list = topics ? g_strsplit(topics, ",", 0) : NULL;
-    const guint count = gutil_strv_length(list);
+    const BinderCbsRange* r = (const BinderCbsRange*) ranges->data;
+    const guint count = ranges->len;
     guint i;
 
+    cbd->ranges = ranges;
     vec->count = count;
     vec->owns_buffer = TRUE;
     vec->data.ptr = configs = gbinder_writer_malloc0(&writer,
@@ -202,20 +251,11 @@ binder_cbs_set_config(
 
     for (i = 0; i < count; i++) {
         RadioGsmBroadcastSmsConfig* config = configs + i;
-        const char* entry = list[i];
-        const char* delim = strchr(entry, '-');
 
         config->selected = TRUE;
         config->toCodeScheme = 0xff;
-        if (delim) {
-            char** range = g_strsplit(entry, "-", 0);
-
-            config->fromServiceId = atoi(range[0]);
-            config->toServiceId = atoi(range[1]);
-            g_strfreev(range);
-        } else {
-            config->fromServiceId = config->toServiceId = atoi(entry);
-        }
+        config->fromServiceId = r[i].from;
+        config->toServiceId = r[i].to;
     }
 
     /* Every vector, even the one without data, requires two buffer objects */
@@ -225,12 +265,11 @@ binder_cbs_set_config(
     gbinder_writer_append_buffer_object_with_parent(&writer, configs,
         sizeof(configs[0]) * count, &parent);
 
-    DBG_(self, "configuring CB");
+    DBG_(self, "configuring CB (%u range(s))", count);
     radio_request_set_retry_func(req, binder_cbs_retry);
     radio_request_set_retry(req, CBS_CHECK_RETRY_MS, CBS_CHECK_RETRY_COUNT);
     radio_request_submit(req);
     radio_request_unref(req);
-    g_strfreev(list);
 }
 
 static
@@ -242,9 +281,19 @@ binder_cbs_set_topics(
     void* data)
 {
     BinderCbs* self = binder_cbs_get_data(cbs);
+    GArray* ranges = binder_cbs_parse_topics(topics);
 
     DBG_(self, "%s", topics);
-    binder_cbs_set_config(self, topics, cb, data);
+    if (binder_cbs_ranges_equal(ranges, self->applied)) {
+        struct ofono_error err;
+
+        /* Nothing has changed, skip the round trip to the modem */
+        DBG_(self, "CB config is unchanged");
+        g_array_free(ranges, TRUE);
+        cb(binder_error_ok(&err), data);
+    } else {
+        binder_cbs_set_config(self, ranges, cb, data);
+    }
 }
 
 static
@@ -257,7 +306,24 @@ binder_cbs_clear_topics(
     BinderCbs* self = binder_cbs_get_data(cbs);
 
     DBG_(self, "");
-    binder_cbs_activate(self, FALSE, cb, data);
+    binder_cbs_activate(self, NULL, cb, data);
+}
+
+static
+void
+binder_cbs_deliver(
+    BinderCbs* self,
+    const guint8* pdu,
+    guint len)
+{
+    if (binder_cbs_recent_check(&self->recent, pdu, len,
+        g_get_monotonic_time())) {
+        self->dropped++;
+        DBG_(self, "dropping repeated page %02x%02x %02x%02x %02x",
+            pdu[0], pdu[1], pdu[2], pdu[3], pdu[5]);
+    } else {
+        ofono_cbs_notify(self->cbs, pdu, len);
+    }
 }
 
 static
@@ -285,7 +351,7 @@ binder_cbs_notify(
 
             if (G_ALIGN4(pdu_len) == (len - 4)) {
                 DBG_(self, "%u bytes", pdu_len);
-                ofono_cbs_notify(self->cbs, ptr + 4, pdu_len);
+                binder_cbs_deliver(self, ptr + 4, pdu_len);
                 return;
             }
         }
@@ -294,7 +360,41 @@ binder_cbs_notify(
          * But I've seen cell broadcasts arriving without the length,
          * simply as a blob.
          */
-        ofono_cbs_notify(self->cbs, ptr, (guint) len);
+        binder_cbs_deliver(self, ptr, (guint) len);
+    }
+}
+
+static
+void
+binder_cbs_replay_done(
+    const struct ofono_error* error,
+    void* data)
+{
+    if (error->type != OFONO_ERROR_TYPE_NO_ERROR) {
+        ofono_warn("Failed to restore CB config");
+    }
+}
+
+static
+void
+binder_cbs_modem_reset(
+    RadioClient* client,
+    RADIO_IND code,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderCbs* self = user_data;
+
+    /* The modem may have lost the config, apply it again */
+    if (self->pending) {
+        /* Whatever is in flight will update the config anyway */
+        DBG_(self, "CB config is being changed, not replaying");
+    } else if (self->applied) {
+        GArray* ranges = self->applied;
+
+        DBG_(self, "replaying CB config");
+        self->applied = NULL;
+        binder_cbs_set_config(self, ranges, binder_cbs_replay_done, NULL);
     }
 }
 
@@ -311,6 +411,8 @@ binder_cbs_register(
     DBG_(self, "registering for CB");
     self->event_id = radio_client_add_indication_handler(client,
         RADIO_IND_NEW_BROADCAST_SMS, binder_cbs_notify, self);
+    self->reset_event_id = radio_client_add_indication_handler(client,
+        RADIO_IND_MODEM_RESET, binder_cbs_modem_reset, self);
     ofono_cbs_register(self->cbs);
     return G_SOURCE_REMOVE;
 }
@@ -328,6 +430,8 @@ binder_cbs_probe(
     self->cbs = cbs;
     self->g = radio_request_group_new(modem->client); /* Keeps ref to client */
     self->log_prefix = binder_dup_prefix(modem->log_prefix);
+    binder_retry_init(&self->retry, self->log_prefix, "cbs",
+        CBS_CHECK_RETRY_MS, CBS_CHECK_RETRY_MAX_MS);
     self->register_id = g_idle_add(binder_cbs_register, self);
 
     DBG_(self, "");
@@ -343,12 +447,19 @@ binder_cbs_remove(
     BinderCbs* self = binder_cbs_get_data(cbs);
 
     DBG_(self, "");
+    if (self->dropped) {
+        ofono_info("%scbs: %u repeated page(s) dropped", self->log_prefix,
+            self->dropped);
+    }
     if (self->register_id) {
         g_source_remove(self->register_id);
     }
     radio_client_remove_handler(self->g->client, self->event_id);
+    radio_client_remove_handler(self->g->client, self->reset_event_id);
     radio_request_group_cancel(self->g);
     radio_request_group_unref(self->g);
+    binder_retry_deinit(&self->retry);
+    binder_cbs_forget_applied(self);
     g_free(self->log_prefix);
     g_free(self);
 
@@ -0,0 +1,137 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_cbs_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static
+int
+binder_cbs_range_compare(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const BinderCbsRange* r1 = a;
+    const BinderCbsRange* r2 = b;
+
+    return (r1->from < r2->from) ? (-1) : (r1->from > r2->from) ? 1 :
+        (r1->to < r2->to) ? (-1) : (r1->to > r2->to) ? 1 : 0;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+GArray*
+binder_cbs_parse_topics(
+    const char* topics)
+{
+    GArray* ranges = g_array_new(FALSE, FALSE, sizeof(BinderCbsRange));
+
+    if (topics) {
+        const char* ptr = topics;
+
+        while (*ptr) {
+            BinderCbsRange r;
+            char* end;
+
+            r.from = r.to = (guint) strtoul(ptr, &end, 10);
+            if (*end == '-') {
+                r.to = (guint) strtoul(end + 1, &end, 10);
+            }
+            if (r.from > r.to) {
+                const guint tmp = r.from;
+
+                r.from = r.to;
+                r.to = tmp;
+            }
+            if (r.from <= BINDER_CBS_MAX_SERVICE_ID) {
+                r.to = MIN(r.to, BINDER_CBS_MAX_SERVICE_ID);
+                g_array_append_val(ranges, r);
+            }
+            ptr = strchr(end, ',');
+            if (!ptr) {
+                break;
+            }
+            ptr++;
+        }
+    }
+
+    if (ranges->len > 1) {
+        BinderCbsRange* r = (BinderCbsRange*) ranges->data;
+        guint i, n = 0;
+
+        g_array_sort(ranges, binder_cbs_range_compare);
+        for (i = 1; i < ranges->len; i++) {
+            if (r[i].from <= r[n].to + 1) {
+                r[n].to = MAX(r[n].to, r[i].to);
+            } else {
+                r[++n] = r[i];
+            }
+        }
+        g_array_set_size(ranges, n + 1);
+    }
+    return ranges;
+}
+
+gboolean
+binder_cbs_ranges_equal(
+    const GArray* r1,
+    const GArray* r2)
+{
+    return r1 && r2 && r1->len == r2->len && !memcmp(r1->data, r2->data,
+        sizeof(BinderCbsRange) * r1->len);
+}
+
+gboolean
+binder_cbs_recent_check(
+    BinderCbsRecent* recent,
+    const guint8* pdu,
+    guint len,
+    gint64 now)
+{
+    if (len >= BINDER_CBS_PAGE_ID_SIZE) {
+        const gint64 min = now - BINDER_CBS_RECENT_MAX_AGE_SEC *
+            G_USEC_PER_SEC;
+        BinderCbsPage* page;
+        guint i;
+
+        for (i = 0; i < BINDER_CBS_RECENT_PAGES; i++) {
+            page = recent->page + i;
+            if (page->time > min &&
+                !memcmp(page->id, pdu, BINDER_CBS_PAGE_ID_SIZE)) {
+                /* Refresh the timestamp while the network keeps repeating */
+                page->time = now;
+                return TRUE;
+            }
+        }
+
+        /* Remember this one, replacing the oldest entry */
+        page = recent->page + recent->next;
+        recent->next = (recent->next + 1) % BINDER_CBS_RECENT_PAGES;
+        memcpy(page->id, pdu, BINDER_CBS_PAGE_ID_SIZE);
+        page->time = now;
+    }
+    return FALSE;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,88 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_CBS_UTIL_H
+#define BINDER_CBS_UTIL_H
+
+#include "binder_types.h"
+
+typedef struct binder_cbs_range {
+    guint from;
+    guint to;
+} BinderCbsRange;
+
+#define BINDER_CBS_MAX_SERVICE_ID (0xffff)
+
+/*
+ * Parses the comma separated list of topics and ranges (e.g. "4370-4383,
+ * 4370,919") into the sorted list of disjoint ranges, with overlapping
+ * and adjacent ranges merged. Reversed ranges are swapped, the service
+ * ids are capped at BINDER_CBS_MAX_SERVICE_ID. Never returns NULL.
+ */
+GArray*
+binder_cbs_parse_topics(
+    const char* topics)
+    G_GNUC_WARN_UNUSED_RESULT
+    BINDER_INTERNAL;
+
+gboolean
+binder_cbs_ranges_equal(
+    const GArray* r1,
+    const GArray* r2)
+    BINDER_INTERNAL;
+
+/*
+ * The first 6 octets of a CB page (serial number, message identifier,
+ * data coding scheme and page parameter, see TS 23.041 section 9.4.1.2)
+ * identify it. The network keeps repeating ETWS/CMAS alerts every few
+ * seconds, and such repeats are dropped.
+ */
+#define BINDER_CBS_PAGE_ID_SIZE (6)
+#define BINDER_CBS_RECENT_PAGES (32)
+#define BINDER_CBS_RECENT_MAX_AGE_SEC (60)
+
+typedef struct binder_cbs_page {
+    guint8 id[BINDER_CBS_PAGE_ID_SIZE];
+    gint64 time; /* Monotonic microseconds, zero if slot is unused */
+} BinderCbsPage;
+
+typedef struct binder_cbs_recent {
+    BinderCbsPage page[BINDER_CBS_RECENT_PAGES];
+    guint next;
+} BinderCbsRecent;
+
+/*
+ * Returns TRUE if the page has been seen within the last
+ * BINDER_CBS_RECENT_MAX_AGE_SEC seconds, otherwise remembers it
+ * (replacing the oldest entry) and returns FALSE. The structure
+ * is zero-initialized.
+ */
+gboolean
+binder_cbs_recent_check(
+    BinderCbsRecent* recent,
+    const guint8* pdu,
+    guint len,
+    gint64 now)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_CBS_UTIL_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -16,6 +16,9 @@
 #include "binder_cell_info.h"
 #include "binder_sim_card.h"
 #include "binder_radio.h"
+#include "binder_retry.h"
+#include "binder_decoder.h"
+#include "binder_stats.h"
 #include "binder_util.h"
 #include "binder_log.h"
 
@@ -33,6 +36,11 @@
 #define DEFAULT_UPDATE_RATE_MS  (10000) /* 10 sec */
 #define MAX_RETRIES             (5)
 
+/* Adaptive rate: back off after this many updates without mobility */
+#define ADAPTIVE_STABLE_UPDATES (3)
+/* Serving cell signal change (in dB) which counts as mobility */
+#define ADAPTIVE_SIGNAL_SWING   (6)
+
 enum binder_cell_info_event {
     CELL_INFO_EVENT_1_0,
     CELL_INFO_EVENT_1_2,
@@ -52,14 +60,66 @@ typedef struct binder_cell_info {
     gulong radio_state_event_id;
     gulong sim_status_event_id;
     gboolean sim_card_ready;
-    int update_rate_ms;
+    int update_rate_ms;     /* Requested by ofono (the lower bound) */
+    int adaptive_rate_ms;   /* Applied, between update and max rate */
+    int max_rate_ms;        /* Zero disables adaptation */
+    guint max_neighbours;   /* Per cell type, zero means no limit */
+    guint stable_updates;
     char* log_prefix;
     gulong event_id[CELL_INFO_EVENT_COUNT];
     RadioRequest* query_req;
     RadioRequest* set_rate_req;
+    BinderRetry retry;
     gboolean enabled;
+    GPtrArray* cell_pool;   /* Spare struct ofono_cell allocations */
+    guint cell_max;         /* High-water mark of the cell count */
+    BinderDecoder* decoder;
+    guint decode_serial;    /* Bumped when pending results become stale */
 } BinderCellInfo;
 
+/*
+ * What the conversion needs, copied out of the parcel which is only
+ * valid for the duration of the callback. The mcc and mnc strings are
+ * copied too, they are the only pointers which the conversion follows.
+ * Any other pointers inside the identity structures must not be used.
+ */
+#define CELL_INFO_PLMN_SIZE     (8)
+
+typedef struct binder_cell_info_raw {
+    enum ofono_cell_type type;
+    gboolean registered;
+    char mcc[CELL_INFO_PLMN_SIZE];
+    char mnc[CELL_INFO_PLMN_SIZE];
+    union binder_cell_info_raw_data {
+        struct binder_cell_info_raw_gsm {
+            RadioCellIdentityGsm id;
+            RadioSignalStrengthGsm ss;
+        } gsm;
+        struct binder_cell_info_raw_wcdma {
+            RadioCellIdentityWcdma id;
+            RadioSignalStrengthWcdma ss;
+        } wcdma;
+        struct binder_cell_info_raw_lte {
+            RadioCellIdentityLte id;
+            RadioSignalStrengthLte ss;
+        } lte;
+        struct binder_cell_info_raw_nr {
+            RadioCellIdentityNr id;
+            RadioSignalStrengthNr ss;
+        } nr;
+    } data;
+} BinderCellInfoRaw;
+
+typedef struct binder_cell_info_decode {
+    BinderCellInfo* self;
+    guint serial;
+    guint max_neighbours;
+    GArray* raw;            /* BinderCellInfoRaw, freed by the decoder */
+    GPtrArray* spare;       /* Taken from the pool by the main thread */
+    GPtrArray* cells;       /* Allocated by the decoder */
+    GPtrArray* dropped;     /* Allocated on demand by the decoder */
+} BinderCellInfoDecode;
+
 enum binder_cell_info_signal {
     SIGNAL_CELLS_CHANGED,
     SIGNAL_COUNT
@@ -77,13 +137,21 @@ G_DEFINE_TYPE(BinderCellInfo, binder_cell_info, G_TYPE_OBJECT)
 
 #define DBG_(self,fmt,args...) DBG("%s" fmt, (self)->log_prefix, ##args)
 
-/*
- * binder_cell_info_list_equal() assumes that zero-initialized
- * struct ofono_cell gets allocated regardless of the cell type,
- * even if a part of the structure remains unused.
- */
+static void binder_cell_info_set_rate(BinderCellInfo* self);
 
-#define binder_cell_new() g_new0(struct ofono_cell, 1)
+static
+void
+binder_cell_info_cell_free(
+    BinderCellInfo* self,
+    struct ofono_cell* cell)
+{
+    /* Keep enough spare cells for the largest list seen so far */
+    if (self->cell_pool->len < self->cell_max) {
+        g_ptr_array_add(self->cell_pool, cell);
+    } else {
+        g_free(cell);
+    }
+}
 
 static
 const char*
@@ -130,38 +198,116 @@ binder_cell_info_list_compare(
 }
 
 static
-gboolean
-binder_cell_info_list_equal(
-    const ofono_cell_ptr* l1,
-    const ofono_cell_ptr* l2)
+void
+binder_cell_info_clear(
+    BinderCellInfo* self)
 {
-    if (l1 && l2) {
-        while (*l1 && *l2) {
-            if (memcmp(*l1, *l2, sizeof(struct ofono_cell))) {
-                return FALSE;
-            }
-            l1++;
-            l2++;
+    /* Whatever is being decoded is no longer relevant */
+    self->decode_serial++;
+    if (self->cells && self->cells[0]) {
+        struct ofono_cell** ptr;
+
+        for (ptr = self->cells; *ptr; ptr++) {
+            binder_cell_info_cell_free(self, *ptr);
         }
-        return !*l1 && !*l2;
-    } else {
-        return (!l1 || !*l1) && (!l2 || !*l2);
+        g_free(self->cells);
+        self->info.cells = self->cells = g_new0(struct ofono_cell*, 1);
+        g_signal_emit(self, binder_cell_info_signals[SIGNAL_CELLS_CHANGED], 0);
     }
 }
 
 static
-void
-binder_cell_info_clear(
+int
+binder_cell_info_signal_db(
+    const struct ofono_cell* cell)
+{
+    int value;
+
+    /* Something proportional to dB, good enough for comparison */
+    switch (cell->type) {
+    case OFONO_CELL_TYPE_GSM:
+        value = cell->info.gsm.signalStrength;
+        return (value == OFONO_CELL_INVALID_VALUE) ? value : (2 * value);
+    case OFONO_CELL_TYPE_WCDMA:
+        value = cell->info.wcdma.signalStrength;
+        return (value == OFONO_CELL_INVALID_VALUE) ? value : (2 * value);
+    case OFONO_CELL_TYPE_LTE:
+        return cell->info.lte.rsrp;
+    case OFONO_CELL_TYPE_NR:
+        return cell->info.nr.ssRsrp;
+    }
+    return OFONO_CELL_INVALID_VALUE;
+}
+
+/*
+ * The cells have the same location. Neighbour signal fluctuations are
+ * ignored, what matters is registration and serving cell signal swing.
+ */
+static
+gboolean
+binder_cell_info_moved(
+    const struct ofono_cell* c1,
+    const struct ofono_cell* c2)
+{
+    if (c1->registered != c2->registered) {
+        return TRUE;
+    } else if (c2->registered) {
+        const int db1 = binder_cell_info_signal_db(c1);
+        const int db2 = binder_cell_info_signal_db(c2);
+
+        return (db1 == OFONO_CELL_INVALID_VALUE) !=
+            (db2 == OFONO_CELL_INVALID_VALUE) ||
+            ABS(db1 - db2) >= ADAPTIVE_SIGNAL_SWING;
+    }
+    return FALSE;
+}
+
+static
+gboolean
+binder_cell_info_adaptive(
     BinderCellInfo* self)
 {
-    if (self->cells && self->cells[0]) {
-        gutil_ptrv_free((void**)self->cells);
-        self->info.cells = self->cells = g_new0(struct ofono_cell*, 1);
-        g_signal_emit(self, binder_cell_info_signals[SIGNAL_CELLS_CHANGED], 0);
+    return self->enabled && self->update_rate_ms > 0 &&
+        self->max_rate_ms > self->update_rate_ms;
+}
+
+static
+void
+binder_cell_info_adapt_rate(
+    BinderCellInfo* self,
+    gboolean moved)
+{
+    if (binder_cell_info_adaptive(self)) {
+        int rate = self->adaptive_rate_ms;
+
+        if (moved) {
+            /* Back to the rate requested by ofono */
+            self->stable_updates = 0;
+            rate = self->update_rate_ms;
+        } else if (++(self->stable_updates) >= ADAPTIVE_STABLE_UPDATES) {
+            self->stable_updates = 0;
+            rate = MIN(rate * 2, self->max_rate_ms);
+        }
+
+        if (self->adaptive_rate_ms != rate) {
+            DBG_(self, "%s, %d => %d ms", moved ? "moving" : "stable",
+                self->adaptive_rate_ms, rate);
+            self->adaptive_rate_ms = rate;
+            if (self->sim_card_ready) {
+                binder_cell_info_set_rate(self);
+            }
+        }
     }
 }
 
-/* NULL-terminates and takes ownership of GPtrArray */
+/*
+ * NULL-terminates and takes ownership of GPtrArray. Both the current
+ * and the new (sorted by binder_cell_info_decode_cells) lists are sorted
+ * by location, which allows to walk them
+ * side by side. Unchanged cells keep their existing allocations, the
+ * signal is only emitted if at least one cell has been added, removed
+ * or changed.
+ */
 static
 void
 binder_cell_info_update_cells(
@@ -169,24 +315,114 @@ binder_cell_info_update_cells(
     GPtrArray* l)
 {
     if (l) {
-        g_ptr_array_sort(l, binder_cell_info_list_compare);
-        g_ptr_array_add(l, NULL);
+        struct ofono_cell** old = self->cells;
+        guint added = 0, removed = 0, changed = 0, i = 0;
+        gboolean moved = FALSE;
 
-        DBG_(self, "%d cell(s)", (int)(l->len - 1));
-        if (!binder_cell_info_list_equal(self->cells,
-           (struct ofono_cell**)l->pdata)) {
-            gutil_ptrv_free((void**)self->cells);
+        DBG_(self, "%u cell(s)", l->len);
+        if (self->cell_max < l->len) {
+            self->cell_max = l->len;
+        }
+        while (i < l->len) {
+            struct ofono_cell* cell = l->pdata[i];
+            const int diff = *old ?
+                ofono_cell_compare_location(*old, cell) : 1;
+
+            if (diff < 0) {
+                /* Old cell is gone */
+                binder_cell_info_cell_free(self, *old++);
+                removed++;
+            } else if (diff > 0) {
+                /* New cell */
+                added++;
+                i++;
+            } else {
+                if (memcmp(*old, cell, sizeof(*cell))) {
+                    if (binder_cell_info_moved(*old, cell)) {
+                        moved = TRUE;
+                    }
+                    binder_cell_info_cell_free(self, *old);
+                    changed++;
+                } else {
+                    /* Reuse the existing allocation */
+                    l->pdata[i] = *old;
+                    binder_cell_info_cell_free(self, cell);
+                }
+                old++;
+                i++;
+            }
+        }
+        while (*old) {
+            binder_cell_info_cell_free(self, *old++);
+            removed++;
+        }
+
+        binder_cell_info_adapt_rate(self, moved || added || removed);
+        if (added || removed || changed) {
+            DBG_(self, "%u added, %u removed, %u changed", added,
+                removed, changed);
+            g_free(self->cells);
+            g_ptr_array_add(l, NULL);
             self->info.cells = self->cells = (struct ofono_cell **)
                 g_ptr_array_free(l, FALSE);
             g_signal_emit(self, binder_cell_info_signals
                 [SIGNAL_CELLS_CHANGED], 0);
         } else {
-            g_ptr_array_set_free_func(l, g_free);
+            /* The array contains the same pointers as self->cells */
             g_ptr_array_free(l, TRUE);
         }
     }
 }
 
+/* Larger is stronger, only meaningful for the cells of the same type */
+static
+int
+binder_cell_info_strength(
+    const struct ofono_cell* cell)
+{
+    int value = OFONO_CELL_INVALID_VALUE;
+
+    switch (cell->type) {
+    case OFONO_CELL_TYPE_GSM:
+        value = cell->info.gsm.signalStrength;
+        break;
+    case OFONO_CELL_TYPE_WCDMA:
+        value = cell->info.wcdma.signalStrength;
+        break;
+    case OFONO_CELL_TYPE_LTE:
+        /* RSRP is reported as dBm multiplied by -1 */
+        value = cell->info.lte.rsrp;
+        return (value == OFONO_CELL_INVALID_VALUE) ? G_MININT : (-value);
+    case OFONO_CELL_TYPE_NR:
+        value = cell->info.nr.ssRsrp;
+        return (value == OFONO_CELL_INVALID_VALUE) ? G_MININT : (-value);
+    }
+    return (value == OFONO_CELL_INVALID_VALUE) ? G_MININT : value;
+}
+
+/* By type, then the registered ones, then from the strongest down */
+static
+gint
+binder_cell_info_strength_compare(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const struct ofono_cell* c1 = *(struct ofono_cell**)a;
+    const struct ofono_cell* c2 = *(struct ofono_cell**)b;
+
+    if (c1->type != c2->type) {
+        return (c1->type < c2->type) ? -1 : 1;
+    } else if (c1->registered != c2->registered) {
+        return c1->registered ? -1 : 1;
+    } else {
+        const int s1 = binder_cell_info_strength(c1);
+        const int s2 = binder_cell_info_strength(c2);
+
+        return (s1 == s2) ? ofono_cell_compare_location(c1, c2) :
+            (s1 > s2) ? -1 : 1;
+    }
+}
+
 static
 void
 binder_cell_info_invalidate(
@@ -222,164 +458,132 @@ binder_cell_info_invalidate_nr(
 }
 
 static
-struct ofono_cell*
-binder_cell_info_new_cell_gsm(
-    gboolean registered,
-    const RadioCellIdentityGsm* id,
-    const RadioSignalStrengthGsm* ss)
+void
+binder_cell_info_raw_string(
+    GBinderHidlString* str,
+    char* buf,
+    gsize size)
 {
-    struct ofono_cell* cell = binder_cell_new();
-    struct ofono_cell_info_gsm* gsm = &cell->info.gsm;
+    gsize len;
+    const char* view = binder_hidl_string_view(str, &len);
+
+    /* Anything that doesn't fit isn't a valid mcc or mnc anyway */
+    if (view && len < size) {
+        memcpy(buf, view, len);
+        buf[len] = 0;
+        str->data.str = buf;
+        str->len = len;
+    } else {
+        str->data.str = NULL;
+        str->len = 0;
+    }
+}
 
-    cell->type = OFONO_CELL_TYPE_GSM;
-    cell->registered = registered;
+static
+BinderCellInfoRaw*
+binder_cell_info_raw_add(
+    GArray* raw,
+    enum ofono_cell_type type,
+    gboolean registered)
+{
+    BinderCellInfoRaw* cell;
 
-    binder_cell_info_invalidate(gsm, sizeof(*gsm));
-    gutil_parse_int(id->mcc.data.str, 10, &gsm->mcc);
-    gutil_parse_int(id->mnc.data.str, 10, &gsm->mnc);
-    gsm->lac = id->lac;
-    gsm->cid = id->cid;
-    gsm->arfcn = id->arfcn;
-    gsm->bsic = id->bsic;
-    gsm->signalStrength = ss->signalStrength;
-    gsm->bitErrorRate = ss->bitErrorRate;
-    gsm->timingAdvance = ss->timingAdvance;
-    DBG("[gsm] reg=%d%s%s%s%s%s%s%s%s%s", registered,
-        binder_cell_info_int_format(gsm->mcc, ",mcc=%d"),
-        binder_cell_info_int_format(gsm->mnc, ",mnc=%d"),
-        binder_cell_info_int_format(gsm->lac, ",lac=%d"),
-        binder_cell_info_int_format(gsm->cid, ",cid=%d"),
-        binder_cell_info_int_format(gsm->arfcn, ",arfcn=%d"),
-        binder_cell_info_int_format(gsm->bsic, ",bsic=%d"),
-        binder_cell_info_int_format(gsm->signalStrength, ",strength=%d"),
-        binder_cell_info_int_format(gsm->bitErrorRate, ",err=%d"),
-        binder_cell_info_int_format(gsm->timingAdvance, ",t=%d"));
+    g_array_set_size(raw, raw->len + 1);
+    cell = &g_array_index(raw, BinderCellInfoRaw, raw->len - 1);
+    cell->type = type;
+    cell->registered = registered;
     return cell;
 }
 
 static
-struct
-ofono_cell*
-binder_cell_info_new_cell_wcdma(
+void
+binder_cell_info_raw_gsm(
+    GArray* raw,
+    gboolean registered,
+    const RadioCellIdentityGsm* id,
+    const RadioSignalStrengthGsm* ss)
+{
+    BinderCellInfoRaw* cell = binder_cell_info_raw_add(raw,
+        OFONO_CELL_TYPE_GSM, registered);
+    struct binder_cell_info_raw_gsm* gsm = &cell->data.gsm;
+
+    gsm->id = *id;
+    gsm->ss = *ss;
+    binder_cell_info_raw_string(&gsm->id.mcc, cell->mcc, sizeof(cell->mcc));
+    binder_cell_info_raw_string(&gsm->id.mnc, cell->mnc, sizeof(cell->mnc));
+}
+
+static
+void
+binder_cell_info_raw_wcdma(
+    GArray* raw,
     gboolean registered,
     const RadioCellIdentityWcdma* id,
     const RadioSignalStrengthWcdma* ss)
 {
-    struct ofono_cell* cell = binder_cell_new();
-    struct ofono_cell_info_wcdma* wcdma = &cell->info.wcdma;
-
-    cell->type = OFONO_CELL_TYPE_WCDMA;
-    cell->registered = registered;
-
-    binder_cell_info_invalidate(wcdma, sizeof(*wcdma));
-    gutil_parse_int(id->mcc.data.str, 10, &wcdma->mcc);
-    gutil_parse_int(id->mnc.data.str, 10, &wcdma->mnc);
-    wcdma->lac = id->lac;
-    wcdma->cid = id->cid;
-    wcdma->psc = id->psc;
-    wcdma->uarfcn = id->uarfcn;
-    wcdma->signalStrength = ss->signalStrength;
-    wcdma->bitErrorRate = ss->bitErrorRate;
-    DBG("[wcdma] reg=%d%s%s%s%s%s%s%s", registered,
-        binder_cell_info_int_format(wcdma->mcc, ",mcc=%d"),
-        binder_cell_info_int_format(wcdma->mnc, ",mnc=%d"),
-        binder_cell_info_int_format(wcdma->lac, ",lac=%d"),
-        binder_cell_info_int_format(wcdma->cid, ",cid=%d"),
-        binder_cell_info_int_format(wcdma->psc, ",psc=%d"),
-        binder_cell_info_int_format(wcdma->signalStrength, ",strength=%d"),
-        binder_cell_info_int_format(wcdma->bitErrorRate, ",err=%d"));
-    return cell;
+    BinderCellInfoRaw* cell = binder_cell_info_raw_add(raw,
+        OFONO_CELL_TYPE_WCDMA, registered);
+    struct binder_cell_info_raw_wcdma* wcdma = &cell->data.wcdma;
+
+    wcdma->id = *id;
+    wcdma->ss = *ss;
+    binder_cell_info_raw_string(&wcdma->id.mcc, cell->mcc, sizeof(cell->mcc));
+    binder_cell_info_raw_string(&wcdma->id.mnc, cell->mnc, sizeof(cell->mnc));
 }
 
 static
-struct ofono_cell*
-binder_cell_info_new_cell_lte(
+void
+binder_cell_info_raw_lte(
+    GArray* raw,
     gboolean registered,
     const RadioCellIdentityLte* id,
     const RadioSignalStrengthLte* ss)
 {
-    struct ofono_cell* cell = binder_cell_new();
-    struct ofono_cell_info_lte* lte = &cell->info.lte;
-
-    cell->type = OFONO_CELL_TYPE_LTE;
-    cell->registered = registered;
-
-    binder_cell_info_invalidate(lte, sizeof(*lte));
-    gutil_parse_int(id->mcc.data.str, 10, &lte->mcc);
-    gutil_parse_int(id->mnc.data.str, 10, &lte->mnc);
-    lte->ci = id->ci;
-    lte->pci = id->pci;
-    lte->tac = id->tac;
-    lte->earfcn = id->earfcn;
-    lte->signalStrength = ss->signalStrength;
-    lte->rsrp = ss->rsrp;
-    lte->rsrq = ss->rsrq;
-    lte->rssnr = ss->rssnr;
-    lte->cqi = ss->cqi;
-    lte->timingAdvance = ss->timingAdvance;
-    DBG("[lte] reg=%d%s%s%s%s%s%s%s%s%s%s%s", registered,
-        binder_cell_info_int_format(lte->mcc, ",mcc=%d"),
-        binder_cell_info_int_format(lte->mnc, ",mnc=%d"),
-        binder_cell_info_int_format(lte->ci, ",ci=%d"),
-        binder_cell_info_int_format(lte->pci, ",pci=%d"),
-        binder_cell_info_int_format(lte->tac, ",tac=%d"),
-        binder_cell_info_int_format(lte->signalStrength, ",strength=%d"),
-        binder_cell_info_int_format(lte->rsrp, ",rsrp=%d"),
-        binder_cell_info_int_format(lte->rsrq, ",rsrq=%d"),
-        binder_cell_info_int_format(lte->rssnr, ",rssnr=%d"),
-        binder_cell_info_int_format(lte->cqi, ",cqi=%d"),
-        binder_cell_info_int_format(lte->timingAdvance, ",t=%d"));
-    return cell;
+    BinderCellInfoRaw* cell = binder_cell_info_raw_add(raw,
+        OFONO_CELL_TYPE_LTE, registered);
+    struct binder_cell_info_raw_lte* lte = &cell->data.lte;
+
+    lte->id = *id;
+    lte->ss = *ss;
+    binder_cell_info_raw_string(&lte->id.mcc, cell->mcc, sizeof(cell->mcc));
+    binder_cell_info_raw_string(&lte->id.mnc, cell->mnc, sizeof(cell->mnc));
 }
+
 static
-struct ofono_cell*
-binder_cell_info_new_cell_nr(
+void
+binder_cell_info_raw_nr(
+    GArray* raw,
     gboolean registered,
     const RadioCellIdentityNr* id,
     const RadioSignalStrengthNr* ss)
 {
-    struct ofono_cell* cell = binder_cell_new();
-    struct ofono_cell_info_nr* nr = &cell->info.nr;
-
-    cell->type = OFONO_CELL_TYPE_NR;
-    cell->registered = registered;
+    BinderCellInfoRaw* cell = binder_cell_info_raw_add(raw,
+        OFONO_CELL_TYPE_NR, registered);
+    struct binder_cell_info_raw_nr* nr = &cell->data.nr;
+
+    nr->id = *id;
+    nr->ss = *ss;
+    binder_cell_info_raw_string(&nr->id.mcc, cell->mcc, sizeof(cell->mcc));
+    binder_cell_info_raw_string(&nr->id.mnc, cell->mnc, sizeof(cell->mnc));
+}
 
-    binder_cell_info_invalidate_nr(nr);
-    gutil_parse_int(id->mcc.data.str, 10, &nr->mcc);
-    gutil_parse_int(id->mnc.data.str, 10, &nr->mnc);
-    nr->nci = id->nci;
-    nr->pci = id->pci;
-    nr->tac = id->tac;
-    nr->nrarfcn = id->nrarfcn;
-    nr->ssRsrp = ss->ssRsrp;
-    nr->ssRsrq = ss->ssRsrq;
-    nr->ssSinr = ss->ssSinr;
-    nr->csiRsrp = ss->csiRsrp;
-    nr->csiRsrq = ss->csiRsrq;
-    nr->csiSinr = ss->csiSinr;
-    DBG("[nr] reg=%d%s%s%s%s%s%s%s%s%s%s%s", registered,
-        binder_cell_info_int_format(nr->mcc, ",mcc=%d"),
-        binder_cell_info_int_format(nr->mnc, ",mnc=%d"),
-        binder_cell_info_int64_format(nr->nci, ",nci=%" G_GINT64_FORMAT),
-        binder_cell_info_int_format(nr->pci, ",pci=%d"),
-        binder_cell_info_int_format(nr->tac, ",tac=%d"),
-        binder_cell_info_int_format(nr->ssRsrp, ",ssRsrp=%d"),
-        binder_cell_info_int_format(nr->ssRsrq, ",ssRsrq=%d"),
-        binder_cell_info_int_format(nr->ssSinr, ",ssSinr=%d"),
-        binder_cell_info_int_format(nr->csiRsrp, ",csiRsrp=%d"),
-        binder_cell_info_int_format(nr->csiRsrq, ",csiRsrq=%d"),
-        binder_cell_info_int_format(nr->csiSinr, ",csiSinr=%d"));
-    return cell;
+static
+GArray*
+binder_cell_info_raw_new(
+    gsize count)
+{
+    binder_stats_alloc(2, sizeof(GArray) + count * sizeof(BinderCellInfoRaw));
+    return g_array_sized_new(FALSE, FALSE, sizeof(BinderCellInfoRaw), count);
 }
 
 static
-GPtrArray*
-binder_cell_info_array_new_1_0(
+GArray*
+binder_cell_info_raw_new_1_0(
     const RadioCellInfo* cells,
     gsize count)
 {
     gsize i;
-    GPtrArray* l = g_ptr_array_sized_new(count + 1);
+    GArray* raw = binder_cell_info_raw_new(count);
 
     for (i = 0; i < count; i++) {
         const RadioCellInfo* cell = cells + i;
@@ -393,25 +597,25 @@ binder_cell_info_array_new_1_0(
         case RADIO_CELL_INFO_GSM:
             gsm = cell->gsm.data.ptr;
             for (j = 0; j < cell->gsm.count; j++) {
-                g_ptr_array_add(l, binder_cell_info_new_cell_gsm(reg,
+                binder_cell_info_raw_gsm(raw, reg,
                     &gsm[j].cellIdentityGsm,
-                    &gsm[j].signalStrengthGsm));
+                    &gsm[j].signalStrengthGsm);
             }
             continue;
         case RADIO_CELL_INFO_LTE:
             lte = cell->lte.data.ptr;
             for (j = 0; j < cell->lte.count; j++) {
-                g_ptr_array_add(l, binder_cell_info_new_cell_lte(reg,
+                binder_cell_info_raw_lte(raw, reg,
                     &lte[j].cellIdentityLte,
-                    &lte[j].signalStrengthLte));
+                    &lte[j].signalStrengthLte);
             }
             continue;
         case RADIO_CELL_INFO_WCDMA:
             wcdma = cell->wcdma.data.ptr;
             for (j = 0; j < cell->wcdma.count; j++) {
-                g_ptr_array_add(l, binder_cell_info_new_cell_wcdma(reg,
+                binder_cell_info_raw_wcdma(raw, reg,
                     &wcdma[j].cellIdentityWcdma,
-                    &wcdma[j].signalStrengthWcdma));
+                    &wcdma[j].signalStrengthWcdma);
             }
             continue;
         case RADIO_CELL_INFO_CDMA:
@@ -420,17 +624,17 @@ binder_cell_info_array_new_1_0(
         }
         DBG("unsupported cell type %d", cell->cellInfoType);
     }
-    return l;
+    return raw;
 }
 
 static
-GPtrArray*
-binder_cell_info_array_new_1_2(
+GArray*
+binder_cell_info_raw_new_1_2(
     const RadioCellInfo_1_2* cells,
     gsize count)
 {
     gsize i;
-    GPtrArray* l = g_ptr_array_sized_new(count + 1);
+    GArray* raw = binder_cell_info_raw_new(count);
 
     for (i = 0; i < count; i++) {
         const RadioCellInfo_1_2* cell = cells + i;
@@ -444,25 +648,25 @@ binder_cell_info_array_new_1_2(
         case RADIO_CELL_INFO_GSM:
             gsm = cell->gsm.data.ptr;
             for (j = 0; j < cell->gsm.count; j++) {
-                g_ptr_array_add(l, binder_cell_info_new_cell_gsm(registered,
+                binder_cell_info_raw_gsm(raw, registered,
                     &gsm[j].cellIdentityGsm.base,
-                    &gsm[j].signalStrengthGsm));
+                    &gsm[j].signalStrengthGsm);
             }
             continue;
         case RADIO_CELL_INFO_LTE:
             lte = cell->lte.data.ptr;
             for (j = 0; j < cell->lte.count; j++) {
-                g_ptr_array_add(l, binder_cell_info_new_cell_lte(registered,
+                binder_cell_info_raw_lte(raw, registered,
                     &lte[j].cellIdentityLte.base,
-                    &lte[j].signalStrengthLte));
+                    &lte[j].signalStrengthLte);
             }
             continue;
         case RADIO_CELL_INFO_WCDMA:
             wcdma = cell->wcdma.data.ptr;
             for (j = 0; j < cell->wcdma.count; j++) {
-                g_ptr_array_add(l, binder_cell_info_new_cell_wcdma(registered,
+                binder_cell_info_raw_wcdma(raw, registered,
                     &wcdma[j].cellIdentityWcdma.base,
-                    &wcdma[j].signalStrengthWcdma.base));
+                    &wcdma[j].signalStrengthWcdma.base);
             }
             continue;
         case RADIO_CELL_INFO_CDMA:
@@ -471,17 +675,17 @@ binder_cell_info_array_new_1_2(
         }
         DBG("unsupported cell type %d", cell->cellInfoType);
     }
-    return l;
+    return raw;
 }
 
 static
-GPtrArray*
-binder_cell_info_array_new_1_4(
+GArray*
+binder_cell_info_raw_new_1_4(
     const RadioCellInfo_1_4* cells,
     gsize count)
 {
     gsize i;
-    GPtrArray* l = g_ptr_array_sized_new(count + 1);
+    GArray* raw = binder_cell_info_raw_new(count);
 
     for (i = 0; i < count; i++) {
         const RadioCellInfo_1_4* cell = cells + i;
@@ -489,24 +693,24 @@ binder_cell_info_array_new_1_4(
 
         switch ((RADIO_CELL_INFO_TYPE_1_4)cell->cellInfoType) {
         case RADIO_CELL_INFO_1_4_GSM:
-            g_ptr_array_add(l, binder_cell_info_new_cell_gsm(registered,
+            binder_cell_info_raw_gsm(raw, registered,
                 &cell->info.gsm.cellIdentityGsm.base,
-                &cell->info.gsm.signalStrengthGsm));
+                &cell->info.gsm.signalStrengthGsm);
             continue;
         case RADIO_CELL_INFO_1_4_LTE:
-            g_ptr_array_add(l, binder_cell_info_new_cell_lte(registered,
+            binder_cell_info_raw_lte(raw, registered,
                 &cell->info.lte.base.cellIdentityLte.base,
-                &cell->info.lte.base.signalStrengthLte));
+                &cell->info.lte.base.signalStrengthLte);
             continue;
         case RADIO_CELL_INFO_1_4_WCDMA:
-            g_ptr_array_add(l, binder_cell_info_new_cell_wcdma(registered,
+            binder_cell_info_raw_wcdma(raw, registered,
                 &cell->info.wcdma.cellIdentityWcdma.base,
-                &cell->info.wcdma.signalStrengthWcdma.base));
+                &cell->info.wcdma.signalStrengthWcdma.base);
             continue;
         case RADIO_CELL_INFO_1_4_NR:
-            g_ptr_array_add(l, binder_cell_info_new_cell_nr(registered,
+            binder_cell_info_raw_nr(raw, registered,
                 &cell->info.nr.cellIdentity,
-                &cell->info.nr.signalStrength));
+                &cell->info.nr.signalStrength);
             continue;
         case RADIO_CELL_INFO_1_4_TD_SCDMA:
         case RADIO_CELL_INFO_1_4_CDMA:
@@ -514,17 +718,17 @@ binder_cell_info_array_new_1_4(
         }
         DBG("unsupported cell type %d", cell->cellInfoType);
     }
-    return l;
+    return raw;
 }
 
 static
-GPtrArray*
-binder_cell_info_array_new_1_5(
+GArray*
+binder_cell_info_raw_new_1_5(
     const RadioCellInfo_1_5* cells,
     gsize count)
 {
     gsize i;
-    GPtrArray* l = g_ptr_array_sized_new(count + 1);
+    GArray* raw = binder_cell_info_raw_new(count);
 
     for (i = 0; i < count; i++) {
         const RadioCellInfo_1_5* cell = cells + i;
@@ -532,24 +736,24 @@ binder_cell_info_array_new_1_5(
 
         switch ((RADIO_CELL_INFO_TYPE_1_5)cell->cellInfoType) {
         case RADIO_CELL_INFO_1_5_GSM:
-            g_ptr_array_add(l, binder_cell_info_new_cell_gsm(registered,
+            binder_cell_info_raw_gsm(raw, registered,
                 &cell->info.gsm.cellIdentityGsm.base.base,
-                &cell->info.gsm.signalStrengthGsm));
+                &cell->info.gsm.signalStrengthGsm);
             continue;
         case RADIO_CELL_INFO_1_5_LTE:
-            g_ptr_array_add(l, binder_cell_info_new_cell_lte(registered,
+            binder_cell_info_raw_lte(raw, registered,
                 &cell->info.lte.cellIdentityLte.base.base,
-                &cell->info.lte.signalStrengthLte));
+                &cell->info.lte.signalStrengthLte);
             continue;
         case RADIO_CELL_INFO_1_5_WCDMA:
-            g_ptr_array_add(l, binder_cell_info_new_cell_wcdma(registered,
+            binder_cell_info_raw_wcdma(raw, registered,
                 &cell->info.wcdma.cellIdentityWcdma.base.base,
-                &cell->info.wcdma.signalStrengthWcdma.base));
+                &cell->info.wcdma.signalStrengthWcdma.base);
             continue;
         case RADIO_CELL_INFO_1_5_NR:
-            g_ptr_array_add(l, binder_cell_info_new_cell_nr(registered,
+            binder_cell_info_raw_nr(raw, registered,
                 &cell->info.nr.cellIdentityNr.base,
-                &cell->info.nr.signalStrengthNr));
+                &cell->info.nr.signalStrengthNr);
             continue;
         case RADIO_CELL_INFO_1_5_TD_SCDMA:
         case RADIO_CELL_INFO_1_5_CDMA:
@@ -557,7 +761,391 @@ binder_cell_info_array_new_1_5(
         }
         DBG("unsupported cell type %d", cell->cellInfoType);
     }
-    return l;
+    return raw;
+}
+
+/*
+ * The functions below, down to binder_cell_info_decode_cells, may run
+ * on the decoder thread and touch nothing but the decode structure.
+ *
+ * binder_cell_info_update_cells() assumes that zero-initialized
+ * struct ofono_cell gets allocated regardless of the cell type,
+ * even if a part of the structure remains unused.
+ */
+
+static
+struct ofono_cell*
+binder_cell_info_decode_cell_new(
+    BinderCellInfoDecode* decode)
+{
+    GPtrArray* spare = decode->spare;
+
+    if (spare->len > 0) {
+        struct ofono_cell* cell = g_ptr_array_remove_index_fast(spare,
+            spare->len - 1);
+
+        memset(cell, 0, sizeof(*cell));
+        return cell;
+    } else {
+        return g_new0(struct ofono_cell, 1);
+    }
+}
+
+static
+void
+binder_cell_info_decode_gsm(
+    struct ofono_cell* cell,
+    const struct binder_cell_info_raw_gsm* raw)
+{
+    struct ofono_cell_info_gsm* gsm = &cell->info.gsm;
+    const RadioCellIdentityGsm* id = &raw->id;
+    const RadioSignalStrengthGsm* ss = &raw->ss;
+
+    binder_cell_info_invalidate(gsm, sizeof(*gsm));
+    binder_hidl_string_parse_int(&id->mcc, &gsm->mcc);
+    binder_hidl_string_parse_int(&id->mnc, &gsm->mnc);
+    gsm->lac = id->lac;
+    gsm->cid = id->cid;
+    gsm->arfcn = id->arfcn;
+    gsm->bsic = id->bsic;
+    gsm->signalStrength = ss->signalStrength;
+    gsm->bitErrorRate = ss->bitErrorRate;
+    gsm->timingAdvance = ss->timingAdvance;
+}
+
+static
+void
+binder_cell_info_decode_wcdma(
+    struct ofono_cell* cell,
+    const struct binder_cell_info_raw_wcdma* raw)
+{
+    struct ofono_cell_info_wcdma* wcdma = &cell->info.wcdma;
+    const RadioCellIdentityWcdma* id = &raw->id;
+    const RadioSignalStrengthWcdma* ss = &raw->ss;
+
+    binder_cell_info_invalidate(wcdma, sizeof(*wcdma));
+    binder_hidl_string_parse_int(&id->mcc, &wcdma->mcc);
+    binder_hidl_string_parse_int(&id->mnc, &wcdma->mnc);
+    wcdma->lac = id->lac;
+    wcdma->cid = id->cid;
+    wcdma->psc = id->psc;
+    wcdma->uarfcn = id->uarfcn;
+    wcdma->signalStrength = ss->signalStrength;
+    wcdma->bitErrorRate = ss->bitErrorRate;
+}
+
+static
+void
+binder_cell_info_decode_lte(
+    struct ofono_cell* cell,
+    const struct binder_cell_info_raw_lte* raw)
+{
+    struct ofono_cell_info_lte* lte = &cell->info.lte;
+    const RadioCellIdentityLte* id = &raw->id;
+    const RadioSignalStrengthLte* ss = &raw->ss;
+
+    binder_cell_info_invalidate(lte, sizeof(*lte));
+    binder_hidl_string_parse_int(&id->mcc, &lte->mcc);
+    binder_hidl_string_parse_int(&id->mnc, &lte->mnc);
+    lte->ci = id->ci;
+    lte->pci = id->pci;
+    lte->tac = id->tac;
+    lte->earfcn = id->earfcn;
+    lte->signalStrength = ss->signalStrength;
+    lte->rsrp = ss->rsrp;
+    lte->rsrq = ss->rsrq;
+    lte->rssnr = ss->rssnr;
+    lte->cqi = ss->cqi;
+    lte->timingAdvance = ss->timingAdvance;
+}
+
+static
+void
+binder_cell_info_decode_nr(
+    struct ofono_cell* cell,
+    const struct binder_cell_info_raw_nr* raw)
+{
+    struct ofono_cell_info_nr* nr = &cell->info.nr;
+    const RadioCellIdentityNr* id = &raw->id;
+    const RadioSignalStrengthNr* ss = &raw->ss;
+
+    binder_cell_info_invalidate_nr(nr);
+    binder_hidl_string_parse_int(&id->mcc, &nr->mcc);
+    binder_hidl_string_parse_int(&id->mnc, &nr->mnc);
+    nr->nci = id->nci;
+    nr->pci = id->pci;
+    nr->tac = id->tac;
+    nr->nrarfcn = id->nrarfcn;
+    nr->ssRsrp = ss->ssRsrp;
+    nr->ssRsrq = ss->ssRsrq;
+    nr->ssSinr = ss->ssSinr;
+    nr->csiRsrp = ss->csiRsrp;
+    nr->csiRsrq = ss->csiRsrq;
+    nr->csiSinr = ss->csiSinr;
+}
+
+static
+void
+binder_cell_info_decode_convert(
+    BinderCellInfoDecode* decode)
+{
+    GArray* raw = decode->raw;
+    GPtrArray* l = g_ptr_array_sized_new(raw->len + 1);
+    guint i;
+
+    for (i = 0; i < raw->len; i++) {
+        const BinderCellInfoRaw* src = &g_array_index(raw,
+            BinderCellInfoRaw, i);
+        struct ofono_cell* cell = binder_cell_info_decode_cell_new(decode);
+
+        cell->type = src->type;
+        cell->registered = src->registered;
+        switch (src->type) {
+        case OFONO_CELL_TYPE_GSM:
+            binder_cell_info_decode_gsm(cell, &src->data.gsm);
+            break;
+        case OFONO_CELL_TYPE_WCDMA:
+            binder_cell_info_decode_wcdma(cell, &src->data.wcdma);
+            break;
+        case OFONO_CELL_TYPE_LTE:
+            binder_cell_info_decode_lte(cell, &src->data.lte);
+            break;
+        case OFONO_CELL_TYPE_NR:
+            binder_cell_info_decode_nr(cell, &src->data.nr);
+            break;
+        }
+        g_ptr_array_add(l, cell);
+    }
+
+    g_array_free(raw, TRUE);
+    decode->raw = NULL;
+    decode->cells = l;
+}
+
+static
+void
+binder_cell_info_decode_drop(
+    BinderCellInfoDecode* decode,
+    struct ofono_cell* cell)
+{
+    if (!decode->dropped) {
+        decode->dropped = g_ptr_array_new();
+    }
+    g_ptr_array_add(decode->dropped, cell);
+}
+
+static
+void
+binder_cell_info_decode_sort(
+    BinderCellInfoDecode* decode)
+{
+    GPtrArray* l = decode->cells;
+    const guint max = decode->max_neighbours;
+    guint i, j;
+
+    /* Dropped cells are returned to the pool on the main thread */
+    if (max && l->len > max) {
+        enum ofono_cell_type type = OFONO_CELL_TYPE_GSM;
+        guint n = 0;
+
+        /* Keep the strongest neighbours of each type */
+        g_ptr_array_sort(l, binder_cell_info_strength_compare);
+        for (i = j = 0; i < l->len; i++) {
+            struct ofono_cell* cell = l->pdata[i];
+
+            if (!i || cell->type != type) {
+                type = cell->type;
+                n = 0;
+            }
+            if (cell->registered || n++ < max) {
+                l->pdata[j++] = cell;
+            } else {
+                binder_cell_info_decode_drop(decode, cell);
+            }
+        }
+        g_ptr_array_set_size(l, j);
+    }
+
+    g_ptr_array_sort(l, binder_cell_info_list_compare);
+
+    /*
+     * Some modems report the same cell more than once (e.g. the serving
+     * cell again as a neighbour). Duplicates end up next to each other,
+     * keep the registered one.
+     */
+    for (i = j = 1; i < l->len; i++) {
+        struct ofono_cell* cell = l->pdata[i];
+        struct ofono_cell* prev = l->pdata[j - 1];
+
+        if (ofono_cell_compare_location(prev, cell)) {
+            l->pdata[j++] = cell;
+        } else if (cell->registered && !prev->registered) {
+            l->pdata[j - 1] = cell;
+            binder_cell_info_decode_drop(decode, prev);
+        } else {
+            binder_cell_info_decode_drop(decode, cell);
+        }
+    }
+    if (l->len) {
+        g_ptr_array_set_size(l, j);
+    }
+}
+
+static
+void
+binder_cell_info_decode_cells(
+    gpointer data)
+{
+    BinderCellInfoDecode* decode = data;
+
+    binder_cell_info_decode_convert(decode);
+    binder_cell_info_decode_sort(decode);
+}
+
+static
+void
+binder_cell_info_cell_dbg(
+    const struct ofono_cell* cell)
+{
+    const gboolean registered = cell->registered;
+    const struct ofono_cell_info_gsm* gsm;
+    const struct ofono_cell_info_wcdma* wcdma;
+    const struct ofono_cell_info_lte* lte;
+    const struct ofono_cell_info_nr* nr;
+
+    switch (cell->type) {
+    case OFONO_CELL_TYPE_GSM:
+        gsm = &cell->info.gsm;
+        DBG("[gsm] reg=%d%s%s%s%s%s%s%s%s%s", registered,
+            binder_cell_info_int_format(gsm->mcc, ",mcc=%d"),
+            binder_cell_info_int_format(gsm->mnc, ",mnc=%d"),
+            binder_cell_info_int_format(gsm->lac, ",lac=%d"),
+            binder_cell_info_int_format(gsm->cid, ",cid=%d"),
+            binder_cell_info_int_format(gsm->arfcn, ",arfcn=%d"),
+            binder_cell_info_int_format(gsm->bsic, ",bsic=%d"),
+            binder_cell_info_int_format(gsm->signalStrength,
+                ",strength=%d"),
+            binder_cell_info_int_format(gsm->bitErrorRate, ",err=%d"),
+            binder_cell_info_int_format(gsm->timingAdvance, ",t=%d"));
+        break;
+    case OFONO_CELL_TYPE_WCDMA:
+        wcdma = &cell->info.wcdma;
+        DBG("[wcdma] reg=%d%s%s%s%s%s%s%s", registered,
+            binder_cell_info_int_format(wcdma->mcc, ",mcc=%d"),
+            binder_cell_info_int_format(wcdma->mnc, ",mnc=%d"),
+            binder_cell_info_int_format(wcdma->lac, ",lac=%d"),
+            binder_cell_info_int_format(wcdma->cid, ",cid=%d"),
+            binder_cell_info_int_format(wcdma->psc, ",psc=%d"),
+            binder_cell_info_int_format(wcdma->signalStrength,
+                ",strength=%d"),
+            binder_cell_info_int_format(wcdma->bitErrorRate, ",err=%d"));
+        break;
+    case OFONO_CELL_TYPE_LTE:
+        lte = &cell->info.lte;
+        DBG("[lte] reg=%d%s%s%s%s%s%s%s%s%s%s%s", registered,
+            binder_cell_info_int_format(lte->mcc, ",mcc=%d"),
+            binder_cell_info_int_format(lte->mnc, ",mnc=%d"),
+            binder_cell_info_int_format(lte->ci, ",ci=%d"),
+            binder_cell_info_int_format(lte->pci, ",pci=%d"),
+            binder_cell_info_int_format(lte->tac, ",tac=%d"),
+            binder_cell_info_int_format(lte->signalStrength,
+                ",strength=%d"),
+            binder_cell_info_int_format(lte->rsrp, ",rsrp=%d"),
+            binder_cell_info_int_format(lte->rsrq, ",rsrq=%d"),
+            binder_cell_info_int_format(lte->rssnr, ",rssnr=%d"),
+            binder_cell_info_int_format(lte->cqi, ",cqi=%d"),
+            binder_cell_info_int_format(lte->timingAdvance, ",t=%d"));
+        break;
+    case OFONO_CELL_TYPE_NR:
+        nr = &cell->info.nr;
+        DBG("[nr] reg=%d%s%s%s%s%s%s%s%s%s%s%s", registered,
+            binder_cell_info_int_format(nr->mcc, ",mcc=%d"),
+            binder_cell_info_int_format(nr->mnc, ",mnc=%d"),
+            binder_cell_info_int64_format(nr->nci, ",nci=%"
+                G_GINT64_FORMAT),
+            binder_cell_info_int_format(nr->pci, ",pci=%d"),
+            binder_cell_info_int_format(nr->tac, ",tac=%d"),
+            binder_cell_info_int_format(nr->ssRsrp, ",ssRsrp=%d"),
+            binder_cell_info_int_format(nr->ssRsrq, ",ssRsrq=%d"),
+            binder_cell_info_int_format(nr->ssSinr, ",ssSinr=%d"),
+            binder_cell_info_int_format(nr->csiRsrp, ",csiRsrp=%d"),
+            binder_cell_info_int_format(nr->csiRsrq, ",csiRsrq=%d"),
+            binder_cell_info_int_format(nr->csiSinr, ",csiSinr=%d"));
+        break;
+    }
+}
+
+static
+void
+binder_cell_info_decode_done(
+    gpointer data)
+{
+    BinderCellInfoDecode* decode = data;
+    BinderCellInfo* self = decode->self;
+    GPtrArray* l = decode->cells;
+    guint i;
+
+    /* Whatever the decoder hasn't used goes back to the pool */
+    for (i = 0; i < decode->spare->len; i++) {
+        binder_cell_info_cell_free(self, decode->spare->pdata[i]);
+    }
+    g_ptr_array_free(decode->spare, TRUE);
+
+    if (decode->dropped) {
+        DBG_(self, "%u cell(s) dropped", decode->dropped->len);
+        for (i = 0; i < decode->dropped->len; i++) {
+            binder_cell_info_cell_free(self, decode->dropped->pdata[i]);
+        }
+        g_ptr_array_free(decode->dropped, TRUE);
+    }
+
+    if (decode->serial == self->decode_serial && self->enabled) {
+        for (i = 0; i < l->len; i++) {
+            binder_cell_info_cell_dbg(l->pdata[i]);
+        }
+        binder_cell_info_update_cells(self, l);
+    } else {
+        DBG_(self, "dropping stale cell list");
+        for (i = 0; i < l->len; i++) {
+            binder_cell_info_cell_free(self, l->pdata[i]);
+        }
+        g_ptr_array_free(l, TRUE);
+    }
+    g_object_unref(self);
+    gutil_slice_free(decode);
+}
+
+/* Takes ownership of the array */
+static
+void
+binder_cell_info_submit(
+    BinderCellInfo* self,
+    GArray* raw)
+{
+    BinderCellInfoDecode* decode = g_slice_new(BinderCellInfoDecode);
+    GPtrArray* pool = self->cell_pool;
+    const guint n = MIN(pool->len, raw->len);
+    guint i;
+
+    /* The pool belongs to the main thread, hand some cells over */
+    decode->spare = g_ptr_array_sized_new(n);
+    for (i = 0; i < n; i++) {
+        g_ptr_array_add(decode->spare, g_ptr_array_remove_index_fast(pool,
+            pool->len - 1));
+    }
+    if (raw->len > n) {
+        binder_stats_alloc(raw->len - n, (raw->len - n) *
+            sizeof(struct ofono_cell));
+    }
+
+    decode->self = g_object_ref(self);
+    decode->serial = self->decode_serial;
+    decode->max_neighbours = self->max_neighbours;
+    decode->raw = raw;
+    decode->cells = NULL;
+    decode->dropped = NULL;
+    binder_decoder_submit(self->decoder, "cell_info",
+        binder_cell_info_decode_cells, binder_cell_info_decode_done, decode);
 }
 
 static
@@ -571,8 +1159,8 @@ binder_cell_info_list_1_0(
         RadioCellInfo, &count);
 
     if (cells) {
-        binder_cell_info_update_cells(self,
-            binder_cell_info_array_new_1_0(cells, count));
+        binder_cell_info_submit(self,
+            binder_cell_info_raw_new_1_0(cells, count));
     } else {
         ofono_warn("Failed to parse cellInfoList payload");
     }
@@ -589,8 +1177,8 @@ binder_cell_info_list_1_2(
         RadioCellInfo_1_2, &count);
 
     if (cells) {
-        binder_cell_info_update_cells(self,
-            binder_cell_info_array_new_1_2(cells, count));
+        binder_cell_info_submit(self,
+            binder_cell_info_raw_new_1_2(cells, count));
     } else {
         ofono_warn("Failed to parse cellInfoList_1_2 payload");
     }
@@ -607,8 +1195,8 @@ binder_cell_info_list_1_4(
         RadioCellInfo_1_4, &count);
 
     if (cells) {
-        binder_cell_info_update_cells(self,
-            binder_cell_info_array_new_1_4(cells, count));
+        binder_cell_info_submit(self,
+            binder_cell_info_raw_new_1_4(cells, count));
     } else {
         ofono_warn("Failed to parse cellInfoList_1_4 payload");
     }
@@ -625,86 +1213,85 @@ binder_cell_info_list_1_5(
         RadioCellInfo_1_5, &count);
 
     if (cells) {
-        binder_cell_info_update_cells(self,
-            binder_cell_info_array_new_1_5(cells, count));
+        binder_cell_info_submit(self,
+            binder_cell_info_raw_new_1_5(cells, count));
     } else {
         ofono_warn("Failed to parse cellInfoList_1_5 payload");
     }
 }
 
-static
-void
-binder_cell_info_list_changed_1_0(
-    RadioClient* client,
-    RADIO_IND code,
-    const GBinderReader* args,
-    gpointer user_data)
-{
-    BinderCellInfo* self = THIS(user_data);
-
-    GASSERT(code == RADIO_IND_CELL_INFO_LIST);
-    if (self->enabled) {
-        GBinderReader reader;
-
-        gbinder_reader_copy(&reader, args);
-        binder_cell_info_list_1_0(self, &reader);
+/*
+ * Each IRadio version delivers its own flavor of the cell list, both
+ * as an indication and as a getCellInfoList response. Supporting yet
+ * another version is a matter of adding an entry here.
+ */
+typedef struct binder_cell_info_version {
+    RADIO_IND ind;
+    RADIO_RESP resp;
+    void (*parse)(BinderCellInfo* self, GBinderReader* reader);
+} BinderCellInfoVersion;
+
+static const BinderCellInfoVersion binder_cell_info_versions[] = {
+    [CELL_INFO_EVENT_1_0] = {
+        RADIO_IND_CELL_INFO_LIST,
+        RADIO_RESP_GET_CELL_INFO_LIST,
+        binder_cell_info_list_1_0
+    },
+    [CELL_INFO_EVENT_1_2] = {
+        RADIO_IND_CELL_INFO_LIST_1_2,
+        RADIO_RESP_GET_CELL_INFO_LIST_1_2,
+        binder_cell_info_list_1_2
+    },
+    [CELL_INFO_EVENT_1_4] = {
+        RADIO_IND_CELL_INFO_LIST_1_4,
+        RADIO_RESP_GET_CELL_INFO_LIST_1_4,
+        binder_cell_info_list_1_4
+    },
+    [CELL_INFO_EVENT_1_5] = {
+        RADIO_IND_CELL_INFO_LIST_1_5,
+        RADIO_RESP_GET_CELL_INFO_LIST_1_5,
+        binder_cell_info_list_1_5
     }
-}
-
-static
-void
-binder_cell_info_list_changed_1_2(
-    RadioClient* client,
-    RADIO_IND code,
-    const GBinderReader* args,
-    gpointer user_data)
-{
-    BinderCellInfo* self = THIS(user_data);
+};
 
-    GASSERT(code == RADIO_IND_CELL_INFO_LIST_1_2);
-    if (self->enabled) {
-        GBinderReader reader;
-
-        gbinder_reader_copy(&reader, args);
-        binder_cell_info_list_1_2(self, &reader);
-    }
-}
+G_STATIC_ASSERT(G_N_ELEMENTS(binder_cell_info_versions) ==
+    CELL_INFO_EVENT_COUNT);
 
 static
-void
-binder_cell_info_list_changed_1_4(
-    RadioClient* client,
-    RADIO_IND code,
-    const GBinderReader* args,
-    gpointer user_data)
+const BinderCellInfoVersion*
+binder_cell_info_version(
+    RADIO_IND ind,
+    RADIO_RESP resp)
 {
-    BinderCellInfo* self = THIS(user_data);
+    guint i;
 
-    GASSERT(code == RADIO_IND_CELL_INFO_LIST_1_4);
-    if (self->enabled) {
-        GBinderReader reader;
+    for (i = 0; i < CELL_INFO_EVENT_COUNT; i++) {
+        const BinderCellInfoVersion* v = binder_cell_info_versions + i;
 
-        gbinder_reader_copy(&reader, args);
-        binder_cell_info_list_1_4(self, &reader);
+        if ((ind && v->ind == ind) || (resp && v->resp == resp)) {
+            return v;
+        }
     }
+    return NULL;
 }
 
 static
 void
-binder_cell_info_list_changed_1_5(
+binder_cell_info_list_changed(
     RadioClient* client,
     RADIO_IND code,
     const GBinderReader* args,
     gpointer user_data)
 {
     BinderCellInfo* self = THIS(user_data);
+    const BinderCellInfoVersion* v = binder_cell_info_version(code,
+        RADIO_RESP_NONE);
 
-    GASSERT(code == RADIO_IND_CELL_INFO_LIST_1_5);
-    if (self->enabled) {
+    if (self->enabled && v) {
         GBinderReader reader;
 
         gbinder_reader_copy(&reader, args);
-        binder_cell_info_list_1_5(self, &reader);
+        v->parse(self, &reader);
     }
 }
 
@@ -727,25 +1314,16 @@ binder_cell_info_list_cb(
     if (status == RADIO_TX_STATUS_OK) {
         if (error == RADIO_ERROR_NONE) {
             if (self->enabled) {
-                GBinderReader reader;
-
-                gbinder_reader_copy(&reader, args);
-                switch (resp) {
-                case RADIO_RESP_GET_CELL_INFO_LIST:
-                    binder_cell_info_list_1_0(self, &reader);
-                    break;
-                case RADIO_RESP_GET_CELL_INFO_LIST_1_2:
-                    binder_cell_info_list_1_2(self, &reader);
-                    break;
-                case RADIO_RESP_GET_CELL_INFO_LIST_1_4:
-                    binder_cell_info_list_1_4(self, &reader);
-                    break;
-                case RADIO_RESP_GET_CELL_INFO_LIST_1_5:
-                    binder_cell_info_list_1_5(self, &reader);
-                    break;
-                default:
+                const BinderCellInfoVersion* v =
+                    binder_cell_info_version(RADIO_IND_NONE, resp);
+
+                if (v) {
+                    GBinderReader reader;
+
+                    gbinder_reader_copy(&reader, args);
+                    v->parse(self, &reader);
+                } else {
                     ofono_warn("Unexpected getCellInfoList response %d", resp);
-                    break;
                 }
             }
         } else {
@@ -797,9 +1375,11 @@ binder_cell_info_retry(
     switch (error) {
     case RADIO_ERROR_NONE:
     case RADIO_ERROR_RADIO_NOT_AVAILABLE:
+        binder_retry_reset(&self->retry);
         return FALSE;
     default:
-        return self->enabled;
+        return self->enabled && binder_retry_request(&self->retry, req,
+            MAX_RETRIES);
     }
 }
 
@@ -831,7 +1411,8 @@ binder_cell_info_set_rate(
 
     gbinder_writer_append_int32(&writer,
         (self->update_rate_ms >= 0 && self->enabled) ?
-            self->update_rate_ms : INT_MAX);
+            (binder_cell_info_adaptive(self) ? self->adaptive_rate_ms :
+            self->update_rate_ms) : INT_MAX);
 
     radio_request_set_retry(self->set_rate_req, BINDER_RETRY_MS, MAX_RETRIES);
     radio_request_set_retry_func(self->set_rate_req, binder_cell_info_retry);
@@ -964,7 +1545,8 @@ binder_cell_info_set_update_interval_proc(
     BinderCellInfo* self = binder_cell_info_cast(info);
 
     if (self->update_rate_ms != ms) {
-        self->update_rate_ms = ms;
+        self->update_rate_ms = self->adaptive_rate_ms = ms;
+        self->stable_updates = 0;
         DBG_(self, "%d ms", ms);
         if (self->enabled && self->sim_card_ready) {
             binder_cell_info_set_rate(self);
@@ -982,6 +1564,8 @@ binder_cell_info_set_enabled_proc(
 
     if (self->enabled != enabled) {
         self->enabled = enabled;
+        self->adaptive_rate_ms = self->update_rate_ms;
+        self->stable_updates = 0;
         DBG_(self, "%d", enabled);
         binder_cell_info_refresh(self);
         if (self->sim_card_ready) {
@@ -999,38 +1583,36 @@ binder_cell_info_new(
     RadioClient* client,
     const char* log_prefix,
     BinderRadio* radio,
-    BinderSimCard* sim)
+    BinderSimCard* sim,
+    BinderDecoder* decoder,
+    const BinderSlotConfig* config)
 {
     BinderCellInfo* self = g_object_new(THIS_TYPE, 0);
+    guint i;
+
+    self->max_rate_ms = config->cell_info_interval_max_ms;
+    self->max_neighbours = MAX(config->cell_info_max_neighbours, 0);
 
     self->client = radio_client_ref(client);
     self->radio = binder_radio_ref(radio);
     self->sim_card = binder_sim_card_ref(sim);
+    self->decoder = binder_decoder_ref(decoder);
     self->log_prefix = binder_dup_prefix(log_prefix);
+    binder_retry_init(&self->retry, self->log_prefix, "cell info",
+        BINDER_RETRY_MS, BINDER_RETRY_MAX_MS);
 
     DBG_(self, "");
-    self->event_id[CELL_INFO_EVENT_1_0] =
-        radio_client_add_indication_handler(client,
-            RADIO_IND_CELL_INFO_LIST,
-            binder_cell_info_list_changed_1_0, self);
-    self->event_id[CELL_INFO_EVENT_1_2] =
-        radio_client_add_indication_handler(client,
-            RADIO_IND_CELL_INFO_LIST_1_2,
-            binder_cell_info_list_changed_1_2, self);
-    self->event_id[CELL_INFO_EVENT_1_4] =
-        radio_client_add_indication_handler(client,
-            RADIO_IND_CELL_INFO_LIST_1_4,
-            binder_cell_info_list_changed_1_4, self);
-    self->event_id[CELL_INFO_EVENT_1_5] =
-        radio_client_add_indication_handler(client,
-            RADIO_IND_CELL_INFO_LIST_1_5,
-            binder_cell_info_list_changed_1_5, self);
+    for (i = 0; i < CELL_INFO_EVENT_COUNT; i++) {
+        self->event_id[i] = radio_client_add_indication_handler(client,
+            binder_cell_info_versions[i].ind,
+            binder_cell_info_list_changed, self);
+    }
     self->radio_state_event_id =
         binder_radio_add_property_handler(radio,
             BINDER_RADIO_PROPERTY_STATE,
             binder_cell_info_radio_state_cb, self);
     self->sim_status_event_id =
-        binder_sim_card_add_status_changed_handler(sim,
+        binder_sim_card_add_app_changed_handler(sim,
             binder_cell_info_sim_status_cb, self);
     self->sim_card_ready = binder_sim_card_ready(sim);
     binder_cell_info_refresh(self);
@@ -1061,8 +1643,9 @@ binder_cell_info_init(
         binder_cell_info_set_enabled_proc
     };
 
-    self->update_rate_ms = DEFAULT_UPDATE_RATE_MS;
+    self->update_rate_ms = self->adaptive_rate_ms = DEFAULT_UPDATE_RATE_MS;
     self->info.cells = self->cells = g_new0(struct ofono_cell*, 1);
+    self->cell_pool = g_ptr_array_new();
     self->info.proc = &binder_cell_info_proc;
 }
 
@@ -1082,7 +1665,11 @@ binder_cell_info_finalize(
     binder_radio_unref(self->radio);
     binder_sim_card_remove_handler(self->sim_card, self->sim_status_event_id);
     binder_sim_card_unref(self->sim_card);
+    binder_decoder_unref(self->decoder);
     gutil_ptrv_free((void**)self->cells);
+    g_ptr_array_set_free_func(self->cell_pool, g_free);
+    g_ptr_array_free(self->cell_pool, TRUE);
+    binder_retry_deinit(&self->retry);
     g_free(self->log_prefix);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
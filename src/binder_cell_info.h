@@ -25,7 +25,9 @@ binder_cell_info_new(
     RadioClient* client,
     const char* log_prefix,
     BinderRadio* radio,
-    BinderSimCard* sim)
+    BinderSimCard* sim,
+    BinderDecoder* decoder,
+    const BinderSlotConfig* config)
     BINDER_INTERNAL;
 
 #endif /* BINDER_CELL_INFO_H */
@@ -33,6 +33,8 @@ BINDER_BASE_ASSERT_COUNT(BINDER_CONNMAN_PROPERTY_COUNT);
 #define CONNMAN_GET_PROPERTIES "GetProperties"
 #define CONNMAN_GET_TECHNOLOGIES "GetTechnologies"
 #define CONNMAN_PROPERTY_CHANGED "PropertyChanged"
+#define CONNMAN_TECHNOLOGY_ADDED "TechnologyAdded"
+#define CONNMAN_TECHNOLOGY_REMOVED "TechnologyRemoved"
 #define CONNMAN_TECH_CONNECTED "Connected"
 #define CONNMAN_TECH_TETHERING "Tethering"
 
@@ -60,6 +62,8 @@ typedef struct connman_object {
     DBusPendingCall* call;
     guint service_watch;
     guint signal_watch;
+    guint tech_added_watch;
+    guint tech_removed_watch;
     GHashTable* techs;
     ConnManTech* wifi;
 } ConnManObject;
@@ -284,24 +288,32 @@ connman_tech_set_property(
     DBusMessageIter* it)
 {
     DBusMessageIter var;
-    DBusBasicValue value;
+    dbus_bool_t value;
     const char* key = connman_iter_get_string(it);
+    int bit;
+
+    /* Only the properties we care about are looked at */
+    if (!g_ascii_strcasecmp(key, CONNMAN_TECH_CONNECTED)) {
+        bit = CONNMAN_TECH_CONNECTED_BIT;
+    } else if (!g_ascii_strcasecmp(key, CONNMAN_TECH_TETHERING)) {
+        bit = CONNMAN_TECH_TETHERING_BIT;
+    } else {
+        return 0;
+    }
 
     dbus_message_iter_next(it);
     dbus_message_iter_recurse(it, &var);
+    if (dbus_message_iter_get_arg_type(&var) != DBUS_TYPE_BOOLEAN) {
+        return 0;
+    }
+
     dbus_message_iter_get_basic(&var, &value);
-    if (!g_ascii_strcasecmp(key, CONNMAN_TECH_CONNECTED)) {
-        if (dbus_message_iter_get_arg_type(&var) == DBUS_TYPE_BOOLEAN) {
-            connman_set_tech_connected(tech, value.bool_val);
-            return CONNMAN_TECH_CONNECTED_BIT;
-        }
-    } else if (!g_ascii_strcasecmp(key, CONNMAN_TECH_TETHERING)) {
-        if (dbus_message_iter_get_arg_type(&var) == DBUS_TYPE_BOOLEAN) {
-            connman_set_tech_tethering(tech, value.bool_val);
-            return CONNMAN_TECH_TETHERING_BIT;
-        }
+    if (bit == CONNMAN_TECH_CONNECTED_BIT) {
+        connman_set_tech_connected(tech, value);
+    } else {
+        connman_set_tech_tethering(tech, value);
     }
-    return 0;
+    return bit;
 }
 
 static
@@ -343,10 +355,82 @@ connman_tech_property_changed(
         dbus_message_iter_init(msg, &it)) {
         const char* name = connman_iter_get_string(&it);
 
-        if (!connman_tech_set_property(tech, &it)) {
+        if (connman_tech_set_property(tech, &it)) {
+            connman_object_emit_pending_signals(self);
+        } else {
             DBG("%s changed for %s", name, path);
         }
-        connman_object_emit_pending_signals(self);
+    }
+    return TRUE;
+}
+
+static
+void
+connman_add_tech(
+    ConnManObject* self,
+    const char* path,
+    DBusMessageIter* props)
+{
+    ConnManTech* tech = connman_tech_new(self, path);
+
+    DBG("%s", path);
+    if (!g_strcmp0(path, CONNMAN_TECH_PATH_WIFI)) {
+        /* WiFi is a special case */
+        self->wifi = tech;
+    }
+    connman_tech_set_properties(tech, props);
+}
+
+static
+gboolean
+connman_tech_added(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    ConnManObject* self = THIS(user_data);
+    DBusMessageIter it;
+
+    /* TechnologyAdded(object path, dict properties) */
+    if (!self->call && dbus_message_has_signature(msg, "oa{sv}") &&
+        dbus_message_iter_init(msg, &it)) {
+        const char* path = connman_iter_get_string(&it);
+
+        if (!g_hash_table_contains(self->techs, path)) {
+            dbus_message_iter_next(&it);
+            connman_add_tech(self, path, &it);
+            connman_object_emit_pending_signals(self);
+        }
+    }
+    return TRUE;
+}
+
+static
+gboolean
+connman_tech_removed(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    ConnManObject* self = THIS(user_data);
+    DBusMessageIter it;
+
+    /* TechnologyRemoved(object path) */
+    if (!self->call && dbus_message_has_signature(msg, "o") &&
+        dbus_message_iter_init(msg, &it)) {
+        const char* path = connman_iter_get_string(&it);
+        ConnManTech* tech = g_hash_table_lookup(self->techs, path);
+
+        if (tech) {
+            DBG("%s is gone", path);
+            connman_set_tech_connected(tech, FALSE);
+            if (tech == self->wifi) {
+                self->wifi = NULL;
+            }
+            g_hash_table_remove(self->techs, path);
+            connman_update_tethering(self);
+            connman_object_emit_pending_signals(self);
+        }
     }
     return TRUE;
 }
@@ -363,20 +447,11 @@ connman_set_techs(
     while (dbus_message_iter_get_arg_type(&list) == DBUS_TYPE_STRUCT) {
         DBusMessageIter entry;
         const char* path;
-        ConnManTech* tech;
 
         dbus_message_iter_recurse(&list, &entry);
         path = connman_iter_get_string(&entry);
-        tech = connman_tech_new(self, path);
-
-        DBG("%s", path);
-        if (!g_strcmp0(path, CONNMAN_TECH_PATH_WIFI)) {
-            /* WiFi is a special case */
-            self->wifi = tech;
-        }
-
         dbus_message_iter_next(&entry);
-        connman_tech_set_properties(tech, &entry);
+        connman_add_tech(self, path, &entry);
         dbus_message_iter_next(&list);
     }
 }
@@ -488,6 +563,12 @@ connman_init(
     self->signal_watch = g_dbus_add_signal_watch(self->connection,
         CONNMAN_SERVICE, NULL, CONNMAN_TECH_INTERFACE,
         CONNMAN_PROPERTY_CHANGED, connman_tech_property_changed, self, NULL);
+    self->tech_added_watch = g_dbus_add_signal_watch(self->connection,
+        CONNMAN_SERVICE, CONNMAN_PATH, CONNMAN_MANAGER_INTERFACE,
+        CONNMAN_TECHNOLOGY_ADDED, connman_tech_added, self, NULL);
+    self->tech_removed_watch = g_dbus_add_signal_watch(self->connection,
+        CONNMAN_SERVICE, CONNMAN_PATH, CONNMAN_MANAGER_INTERFACE,
+        CONNMAN_TECHNOLOGY_REMOVED, connman_tech_removed, self, NULL);
 }
 
 /*==========================================================================*
@@ -560,6 +641,18 @@ binder_connman_add_property_changed_handler(
         property, G_CALLBACK(callback), user_data) : 0;
 }
 
+gulong
+binder_connman_add_properties_changed_handler(
+    BinderConnman* connman,
+    BinderConnmanPropertiesFunc callback,
+    void* user_data)
+{
+    ConnManObject* self = connman_object_cast(connman);
+
+    return G_LIKELY(self) ? binder_base_add_properties_handler(&self->base,
+        (BinderBasePropertiesFunc) callback, user_data) : 0;
+}
+
 void
 binder_connman_remove_handler(
     BinderConnman* connman,
@@ -607,6 +700,8 @@ connman_object_finalize(
     g_hash_table_destroy(self->techs);
     g_dbus_remove_watch(self->connection, self->service_watch);
     g_dbus_remove_watch(self->connection, self->signal_watch);
+    g_dbus_remove_watch(self->connection, self->tech_added_watch);
+    g_dbus_remove_watch(self->connection, self->tech_removed_watch);
     dbus_connection_unref(self->connection);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
@@ -34,6 +34,8 @@ typedef enum binder_connman_property {
     BINDER_CONNMAN_PROPERTY_COUNT
 } BINDER_CONNMAN_PROPERTY;
 
+#define BINDER_CONNMAN_PROPERTY_BIT(property) (1 << ((property) - 1))
+
 typedef
 void
 (*BinderConnmanPropertyFunc)(
@@ -41,6 +43,13 @@ void
     BINDER_CONNMAN_PROPERTY property,
     void* user_data);
 
+typedef
+void
+(*BinderConnmanPropertiesFunc)(
+    BinderConnman* connman,
+    guint mask, /* BINDER_CONNMAN_PROPERTY_BIT */
+    void* user_data);
+
 BinderConnman*
 binder_connman_new(
     void)
@@ -64,6 +73,13 @@ binder_connman_add_property_changed_handler(
     void* user_data)
     BINDER_INTERNAL;
 
+gulong
+binder_connman_add_properties_changed_handler(
+    BinderConnman* connman,
+    BinderConnmanPropertiesFunc fn,
+    void* user_data)
+    BINDER_INTERNAL;
+
 void
 binder_connman_remove_handler(
     BinderConnman* connman,
@@ -15,9 +15,11 @@
 
 #include "binder_base.h"
 #include "binder_data.h"
+#include "binder_metrics.h"
 #include "binder_radio.h"
 #include "binder_network.h"
 #include "binder_sim_settings.h"
+#include "binder_stats.h"
 #include "binder_util.h"
 #include "binder_log.h"
 
@@ -36,6 +38,8 @@
 #include <gutil_strv.h>
 #include <gutil_macros.h>
 
+#include <string.h>
+
 /* Yes, it does sometimes take minutes in roaming */
 #define SETUP_DATA_CALL_TIMEOUT (300*1000) /* ms */
 
@@ -82,6 +86,7 @@ enum binder_data_io_event_id {
     IO_EVENT_DATA_CALL_LIST_CHANGED_1_0,
     IO_EVENT_DATA_CALL_LIST_CHANGED_1_4,
     IO_EVENT_DATA_CALL_LIST_CHANGED_1_5,
+    IO_EVENT_MODEM_RESET,
     IO_EVENT_DEATH,
     IO_EVENT_COUNT
 };
@@ -92,9 +97,26 @@ enum binder_data_settings_event_id {
     SETTINGS_EVENT_COUNT
 };
 
+/*
+ * Every BinderData gets a bit in the manager's masks, which tell which
+ * slots have requests in flight and which ones hold the data roles.
+ * That keeps checking the state of all slots O(1) regardless of their
+ * number. With more than BINDER_DATA_MANAGER_MAX_INDEX slots the extra
+ * ones are simply scanned.
+ */
+#define BINDER_DATA_MANAGER_MAX_INDEX (32)
+
+typedef struct binder_data_object BinderDataObject;
+
 struct binder_data_manager {
     gint refcount;
     GSList* data_list;
+    BinderDataObject* index[BINDER_DATA_MANAGER_MAX_INDEX];
+    guint32 used_mask;
+    guint32 busy_mask;      /* Requests pending, queued or running */
+    guint32 allowed_mask;   /* BINDER_DATA_FLAG_ALLOWED */
+    guint32 max_speed_mask; /* BINDER_DATA_FLAG_MAX_SPEED */
+    guint unindexed;
     enum binder_data_manager_flags flags;
     RadioConfig* rc;
     RadioRequest* phone_cap_req;
@@ -102,7 +124,56 @@ struct binder_data_manager {
     enum ofono_radio_access_mode non_data_mode;
 };
 
-typedef struct binder_data_object {
+/*
+ * Requests are queued by priority class, FIFO within the class, so that
+ * teardown and allow/disallow don't get stuck behind a slow setup.
+ */
+typedef enum binder_data_request_priority {
+    DATA_REQUEST_PRIORITY_SETUP,
+    DATA_REQUEST_PRIORITY_ALLOW,
+    DATA_REQUEST_PRIORITY_DEACT,
+    DATA_REQUEST_PRIORITY_COUNT
+} BINDER_DATA_REQUEST_PRIORITY;
+
+static const char* binder_data_priority_name[] = {
+    "setup", "allow", "deact"
+};
+G_STATIC_ASSERT(G_N_ELEMENTS(binder_data_priority_name) ==
+    DATA_REQUEST_PRIORITY_COUNT);
+
+static const BinderMetricFamily binder_data_metric_queued = {
+    "binder_data_requests_queued", BINDER_METRIC_GAUGE,
+    "Data requests waiting in the queue"
+};
+static const BinderMetricFamily binder_data_metric_running = {
+    "binder_data_requests_running", BINDER_METRIC_GAUGE,
+    "Data requests being executed"
+};
+static const BinderMetricFamily binder_data_metric_submitted = {
+    "binder_data_requests", BINDER_METRIC_COUNTER,
+    "Data requests submitted from the queue"
+};
+static const BinderMetricFamily binder_data_metric_preempted = {
+    "binder_data_requests_preempted", BINDER_METRIC_COUNTER,
+    "Data requests preempted by higher priority ones"
+};
+static const BinderMetricFamily binder_data_metric_delay = {
+    "binder_data_request_delay_seconds", BINDER_METRIC_COUNTER,
+    "Time spent by data requests in the queue"
+};
+static const BinderMetricFamily binder_data_metric_max_delay = {
+    "binder_data_request_max_delay_seconds", BINDER_METRIC_GAUGE,
+    "Longest time spent by a data request in the queue"
+};
+
+typedef struct binder_data_queue_stats {
+    guint count;
+    guint preempted;
+    gint64 total_delay_us;
+    gint64 max_delay_us;
+} BinderDataQueueStats;
+
+struct binder_data_object {
     BinderBase base;
     BinderData pub;
     RadioRequestGroup* g;
@@ -115,17 +186,22 @@ typedef struct binder_data_object {
 
     BinderDataRequest* req_queue;
     BinderDataRequest* pending_req;
+    BinderDataRequest* parallel_req; /* Setups running alongside */
+    BinderDataQueueStats queue_stats[DATA_REQUEST_PRIORITY_COUNT];
 
     BinderDataOptions options;
     BinderDataProfileConfig profile_config;
     guint slot;
     char* log_prefix;
     RadioRequest* query_req;
+    gboolean call_list_ind_ok; /* dataCallListChanged can be trusted */
+    gboolean call_list_stale; /* May have missed some indications */
     gulong io_event_id[IO_EVENT_COUNT];
     gulong settings_event_id[SETTINGS_EVENT_COUNT];
     GHashTable* grab;
     gboolean downgraded_tech; /* Status 55 workaround */
-} BinderDataObject;
+    guint32 dm_bit; /* Zero if not indexed */
+};
 
 typedef BinderBaseClass BinderDataObjectClass;
 GType binder_data_object_get_type() BINDER_INTERNAL;
@@ -140,7 +216,8 @@ typedef enum binder_data_request_flags {
     DATA_REQUEST_FLAG_COMPLETED = 0x1,
     DATA_REQUEST_FLAG_SUBMISSION_FAILURE = 0x2,
     DATA_REQUEST_FLAG_CANCEL_WHEN_ALLOWED = 0x4,
-    DATA_REQUEST_FLAG_CANCEL_WHEN_DISALLOWED = 0x8
+    DATA_REQUEST_FLAG_CANCEL_WHEN_DISALLOWED = 0x8,
+    DATA_REQUEST_FLAG_PARALLEL = 0x10 /* BinderDataRequestSetup */
 } BINDER_DATA_REQUEST_FLAGS;
 
 struct binder_data_request {
@@ -153,10 +230,13 @@ struct binder_data_request {
     } cb;
     void* arg;
     gboolean (*submit)(BinderDataRequest* dr);
+    gboolean (*preempt)(BinderDataRequest* dr);
     void (*cancel)(BinderDataRequest* dr);
     void (*free)(BinderDataRequest* dr);
     RadioRequest* radio_req;
     BINDER_DATA_REQUEST_FLAGS flags;
+    BINDER_DATA_REQUEST_PRIORITY priority;
+    gint64 queued;
     const char* name;
 };
 
@@ -284,6 +364,25 @@ const GBinderWriterType binder_data_profile_1_5_type = {
     binder_data_profile_1_5_f
 };
 
+enum binder_data_object_signal {
+    SIGNAL_CALL_EVENT,
+    SIGNAL_COUNT
+};
+
+#define SIGNAL_CALL_EVENT_NAME "binder-data-call-event"
+#define SIGNAL_CALL_DETAIL     "%d"
+
+static guint binder_data_object_signals[SIGNAL_COUNT];
+
+typedef struct binder_data_call_closure {
+    GCClosure cclosure;
+    BinderDataCallFunc callback;
+    void* user_data;
+} BinderDataCallClosure;
+
+#define binder_data_call_closure_new() ((BinderDataCallClosure*) \
+    g_closure_new_simple(sizeof(BinderDataCallClosure), NULL))
+
 static struct ofono_debug_desc binder_data_debug_desc OFONO_DEBUG_ATTR = {
     .file = __FILE__,
     .flags = OFONO_DEBUG_FLAG_DEFAULT,
@@ -302,6 +401,11 @@ static void binder_data_manager_check_network_mode(BinderDataManager* dm);
 static void binder_data_call_deact_cid(BinderDataObject* data, int cid);
 static void binder_data_cancel_all_requests(BinderDataObject* data);
 static void binder_data_power_update(BinderDataObject* data);
+static void binder_data_query_call_state(BinderDataObject* data);
+static void binder_data_manager_add_index(BinderDataManager* dm,
+    BinderDataObject* data);
+static void binder_data_manager_remove_index(BinderDataManager* dm,
+    BinderDataObject* data);
 
 static
 guint8
@@ -461,6 +565,44 @@ binder_data_call_compare(
     return ca->cid - cb->cid;
 }
 
+static
+void
+binder_data_call_count_strv(
+    char** strv,
+    guint* blocks,
+    gsize* bytes)
+{
+    if (strv) {
+        char** ptr;
+
+        for (ptr = strv; *ptr; ptr++) {
+            (*blocks)++;
+            (*bytes) += strlen(*ptr) + 1;
+        }
+        (*blocks)++;
+        (*bytes) += (ptr - strv + 1) * sizeof(char*);
+    }
+}
+
+static
+void
+binder_data_call_count_alloc(
+    const BinderDataCall* call)
+{
+    guint blocks = 1;
+    gsize bytes = sizeof(*call);
+
+    if (call->ifname) {
+        blocks++;
+        bytes += strlen(call->ifname) + 1;
+    }
+    binder_data_call_count_strv(call->dnses, &blocks, &bytes);
+    binder_data_call_count_strv(call->gateways, &blocks, &bytes);
+    binder_data_call_count_strv(call->addresses, &blocks, &bytes);
+    binder_data_call_count_strv(call->pcscf, &blocks, &bytes);
+    binder_stats_alloc(blocks, bytes);
+}
+
 static
 BinderDataCall*
 binder_data_call_new_1_0(
@@ -485,6 +627,7 @@ binder_data_call_new_1_0(
         call->status, call->retry_time, call->cid, call->active,
         dc->type.data.str, call->ifname, call->mtu, dc->addresses.data.str,
         dc->dnses.data.str, dc->gateways.data.str, dc->pcscf.data.str);
+    binder_data_call_count_alloc(call);
     return call;
 }
 
@@ -537,6 +680,7 @@ binder_data_call_new_1_4(
         binder_print_strv(call->dnses, " "),
         binder_print_strv(call->gateways, " "),
         binder_print_strv(call->pcscf, " "));
+    binder_data_call_count_alloc(call);
     return call;
 }
 
@@ -567,6 +711,7 @@ binder_data_call_new_1_5(
         binder_print_strv(call->dnses, " "),
         binder_print_strv(call->gateways, " "),
         binder_print_strv(call->pcscf, " "));
+    binder_data_call_count_alloc(call);
     return call;
 }
 
@@ -670,6 +815,148 @@ binder_data_call_list_contains(
     return FALSE;
 }
 
+/*
+ * The matchers compare the data calls in the parcel against the ones
+ * we already have, without allocating anything. That's what happens
+ * most of the time, dataCallListChanged indications are often sent
+ * when nothing has really changed.
+ */
+static
+gboolean
+binder_data_call_matches_1_0(
+    const BinderDataCall* call,
+    const RadioDataCall* dc)
+{
+    return call &&
+        call->status == dc->status &&
+        call->active == dc->active &&
+        call->prot == binder_ofono_proto_from_proto_str(dc->type.data.str) &&
+        call->retry_time == dc->suggestedRetryTime &&
+        call->mtu == dc->mtu &&
+        binder_hidl_string_equal(&dc->ifname, call->ifname) &&
+        binder_hidl_string_split_equal(&dc->dnses, ' ', call->dnses) &&
+        binder_hidl_string_split_equal(&dc->gateways, ' ', call->gateways) &&
+        binder_hidl_string_split_equal(&dc->addresses, ' ', call->addresses) &&
+        binder_hidl_string_split_equal(&dc->pcscf, ' ', call->pcscf);
+}
+
+static
+gboolean
+binder_data_call_matches_1_4(
+    const BinderDataCall* call,
+    const RadioDataCall_1_4* dc)
+{
+    return call &&
+        call->status == dc->cause &&
+        call->active == dc->active &&
+        call->prot == dc->type &&
+        call->retry_time == dc->suggestedRetryTime &&
+        call->mtu == dc->mtu &&
+        binder_hidl_string_equal(&dc->ifname, call->ifname) &&
+        binder_hidl_string_vec_equal(&dc->dnses, call->dnses) &&
+        binder_hidl_string_vec_equal(&dc->gateways, call->gateways) &&
+        binder_hidl_string_vec_equal(&dc->addresses, call->addresses) &&
+        binder_hidl_string_vec_equal(&dc->pcscf, call->pcscf);
+}
+
+static
+gboolean
+binder_data_call_matches_1_5(
+    const BinderDataCall* call,
+    const RadioDataCall_1_5* dc)
+{
+    return call &&
+        call->status == dc->cause &&
+        call->active == dc->active &&
+        call->prot == dc->type &&
+        call->retry_time == dc->suggestedRetryTime &&
+        call->mtu == dc->mtuV4 &&
+        binder_hidl_string_equal(&dc->ifname, call->ifname) &&
+        binder_hidl_string_vec_equal(&dc->dnses, call->dnses) &&
+        binder_hidl_string_vec_equal(&dc->gateways, call->gateways) &&
+        binder_hidl_string_vec_equal(&dc->addresses, call->addresses) &&
+        binder_hidl_string_vec_equal(&dc->pcscf, call->pcscf);
+}
+
+/* These return the current list if nothing has changed */
+static
+GSList*
+binder_data_call_list_parse_1_0(
+    GSList* current,
+    const RadioDataCall* calls,
+    gsize n)
+{
+    if (g_slist_length(current) == n) {
+        gsize i;
+
+        for (i = 0; i < n; i++) {
+            const BinderDataCall* call =
+                binder_data_call_find(current, calls[i].cid);
+
+            if (!binder_data_call_matches_1_0(call, calls + i)) {
+                break;
+            }
+        }
+        if (i == n) {
+            DBG("data calls unchanged");
+            return current;
+        }
+    }
+    return binder_data_call_list_1_0(calls, n);
+}
+
+static
+GSList*
+binder_data_call_list_parse_1_4(
+    GSList* current,
+    const RadioDataCall_1_4* calls,
+    gsize n)
+{
+    if (g_slist_length(current) == n) {
+        gsize i;
+
+        for (i = 0; i < n; i++) {
+            const BinderDataCall* call =
+                binder_data_call_find(current, calls[i].cid);
+
+            if (!binder_data_call_matches_1_4(call, calls + i)) {
+                break;
+            }
+        }
+        if (i == n) {
+            DBG("data calls unchanged");
+            return current;
+        }
+    }
+    return binder_data_call_list_1_4(calls, n);
+}
+
+static
+GSList*
+binder_data_call_list_parse_1_5(
+    GSList* current,
+    const RadioDataCall_1_5* calls,
+    gsize n)
+{
+    if (g_slist_length(current) == n) {
+        gsize i;
+
+        for (i = 0; i < n; i++) {
+            const BinderDataCall* call =
+                binder_data_call_find(current, calls[i].cid);
+
+            if (!binder_data_call_matches_1_5(call, calls + i)) {
+                break;
+            }
+        }
+        if (i == n) {
+            DBG("data calls unchanged");
+            return current;
+        }
+    }
+    return binder_data_call_list_1_5(calls, n);
+}
+
 /* extern */
 BinderDataCall*
 binder_data_call_find(
@@ -687,6 +974,71 @@ binder_data_call_find(
     return NULL;
 }
 
+static
+GQuark
+binder_data_call_quark(
+    int cid)
+{
+    char buf[16];
+
+    snprintf(buf, sizeof(buf), SIGNAL_CALL_DETAIL, cid);
+    return g_quark_from_string(buf);
+}
+
+static
+void
+binder_data_call_event(
+    BinderDataObject* self,
+    guint event,
+    const BinderDataCall* call,
+    BinderDataCallClosure* closure)
+{
+    closure->callback(&self->pub, event, call, closure->user_data);
+}
+
+static
+void
+binder_data_emit_call_event(
+    BinderDataObject* self,
+    BINDER_DATA_CALL_EVENT event,
+    const BinderDataCall* call)
+{
+    g_signal_emit(self, binder_data_object_signals[SIGNAL_CALL_EVENT],
+        binder_data_call_quark(call->cid), event, call);
+}
+
+static
+void
+binder_data_diff_calls(
+    BinderDataObject* self,
+    GSList* l1,
+    GSList* l2)
+{
+    /* Both lists are sorted by cid */
+    while (l1 || l2) {
+        const BinderDataCall* c1 = l1 ? l1->data : NULL;
+        const BinderDataCall* c2 = l2 ? l2->data : NULL;
+
+        if (c1 && (!c2 || c1->cid < c2->cid)) {
+            DBG_(self, "call %d removed", c1->cid);
+            binder_data_emit_call_event(self, BINDER_DATA_CALL_REMOVED, c1);
+            l1 = l1->next;
+        } else if (c2 && (!c1 || c2->cid < c1->cid)) {
+            DBG_(self, "call %d added", c2->cid);
+            binder_data_emit_call_event(self, BINDER_DATA_CALL_ADDED, c2);
+            l2 = l2->next;
+        } else {
+            if (!binder_data_call_equal(c1, c2)) {
+                DBG_(self, "call %d changed", c2->cid);
+                binder_data_emit_call_event(self, BINDER_DATA_CALL_CHANGED,
+                    c2);
+            }
+            l1 = l1->next;
+            l2 = l2->next;
+        }
+    }
+}
+
 static
 void
 binder_data_set_calls(
@@ -698,12 +1050,19 @@ binder_data_set_calls(
     GHashTableIter it;
     gpointer key;
 
-    if (binder_data_call_list_equal(data->calls, list)) {
+    /* Signal handlers may release references to this object */
+    binder_data_object_ref(self);
+    if (list == data->calls) {
+        /* Nothing has changed, see binder_data_call_list_parse_x_x() */
+    } else if (binder_data_call_list_equal(data->calls, list)) {
         binder_data_call_list_free(list);
     } else {
+        GSList* prev = data->calls;
+
         DBG("data calls changed");
-        binder_data_call_list_free(data->calls);
         data->calls = list;
+        binder_data_diff_calls(self, prev, list);
+        binder_data_call_list_free(prev);
         binder_base_queue_property_change(base, BINDER_DATA_PROPERTY_CALLS);
     }
 
@@ -734,6 +1093,7 @@ binder_data_set_calls(
     }
 
     binder_base_emit_queued_signals(base);
+    binder_data_object_unref(self);
 }
 
 static
@@ -798,6 +1158,7 @@ binder_data_call_list_changed(
         data->query_req = NULL;
     }
 
+    data->call_list_stale = FALSE;
     binder_data_set_calls(data, list);
 }
 
@@ -818,7 +1179,8 @@ binder_data_call_list_changed_1_0(
     GASSERT(code == RADIO_IND_DATA_CALL_LIST_CHANGED);
     gbinder_reader_copy(&reader, args);
     calls = gbinder_reader_read_hidl_type_vec(&reader, RadioDataCall, &n);
-    binder_data_call_list_changed(data, binder_data_call_list_1_0(calls, n));
+    binder_data_call_list_changed(data, binder_data_call_list_parse_1_0
+        (data->pub.calls, calls, n));
 }
 
 static
@@ -838,7 +1200,8 @@ binder_data_call_list_changed_1_4(
     GASSERT(code == RADIO_IND_DATA_CALL_LIST_CHANGED_1_4);
     gbinder_reader_copy(&reader, args);
     calls = gbinder_reader_read_hidl_type_vec(&reader, RadioDataCall_1_4, &n);
-    binder_data_call_list_changed(data, binder_data_call_list_1_4(calls, n));
+    binder_data_call_list_changed(data, binder_data_call_list_parse_1_4
+        (data->pub.calls, calls, n));
 }
 
 static
@@ -858,7 +1221,8 @@ binder_data_call_list_changed_1_5(
     GASSERT(code == RADIO_IND_DATA_CALL_LIST_CHANGED_1_5);
     gbinder_reader_copy(&reader, args);
     calls = gbinder_reader_read_hidl_type_vec(&reader, RadioDataCall_1_5, &n);
-    binder_data_call_list_changed(data, binder_data_call_list_1_5(calls, n));
+    binder_data_call_list_changed(data, binder_data_call_list_parse_1_5
+        (data->pub.calls, calls, n));
 }
 
 static
@@ -875,6 +1239,9 @@ void binder_data_query_data_calls_cb(
     GASSERT(data->query_req == req);
     radio_request_unref(data->query_req);
     data->query_req = NULL;
+    if (status == RADIO_TX_STATUS_OK && error == RADIO_ERROR_NONE) {
+        data->call_list_stale = FALSE;
+    }
 
     /*
      * Only RADIO_ERROR_NONE and RADIO_ERROR_RADIO_NOT_AVAILABLE are expected,
@@ -897,7 +1264,8 @@ void binder_data_query_data_calls_cb(
                     gbinder_reader_read_hidl_type_vec(&reader,
                         RadioDataCall, &count);
 
-                list = binder_data_call_list_1_0(calls, count);
+                list = binder_data_call_list_parse_1_0(data->pub.calls,
+                    calls, count);
             } else if (resp == RADIO_RESP_GET_DATA_CALL_LIST_1_4) {
                 /*
                  * getDataCallListResponse_1_4(RadioResponseInfo,
@@ -907,7 +1275,8 @@ void binder_data_query_data_calls_cb(
                     gbinder_reader_read_hidl_type_vec(&reader,
                         RadioDataCall_1_4, &count);
 
-                list = binder_data_call_list_1_4(calls, count);
+                list = binder_data_call_list_parse_1_4(data->pub.calls,
+                    calls, count);
             } else if (resp == RADIO_RESP_GET_DATA_CALL_LIST_1_5) {
                 /*
                  * getDataCallListResponse_1_5(RadioResponseInfo,
@@ -917,7 +1286,8 @@ void binder_data_query_data_calls_cb(
                     gbinder_reader_read_hidl_type_vec(&reader,
                         RadioDataCall_1_5, &count);
 
-                list = binder_data_call_list_1_5(calls, count);
+                list = binder_data_call_list_parse_1_5(data->pub.calls,
+                    calls, count);
             } else {
                 ofono_error("Unexpected getDataCallList response %d", resp);
             }
@@ -934,6 +1304,39 @@ void binder_data_query_data_calls_cb(
  * BinderDataRequest
  *==========================================================================*/
 
+static
+void
+binder_data_update_busy(
+    BinderDataObject* data)
+{
+    BinderDataManager* dm = data->dm;
+
+    if (data->pending_req || data->parallel_req || data->req_queue) {
+        dm->busy_mask |= data->dm_bit;
+    } else {
+        dm->busy_mask &= ~data->dm_bit;
+    }
+}
+
+static
+void
+binder_data_update_roles(
+    BinderDataObject* data)
+{
+    BinderDataManager* dm = data->dm;
+
+    if (data->flags & BINDER_DATA_FLAG_ALLOWED) {
+        dm->allowed_mask |= data->dm_bit;
+    } else {
+        dm->allowed_mask &= ~data->dm_bit;
+    }
+    if (data->flags & BINDER_DATA_FLAG_MAX_SPEED) {
+        dm->max_speed_mask |= data->dm_bit;
+    } else {
+        dm->max_speed_mask &= ~data->dm_bit;
+    }
+}
+
 static
 void
 binder_data_request_free(
@@ -987,39 +1390,142 @@ binder_data_request_cancel_io(
     }
 }
 
+static
+void
+binder_data_request_update_stats(
+    BinderDataRequest* dr)
+{
+    BinderDataObject* data = dr->data;
+    BinderDataQueueStats* stats = data->queue_stats + dr->priority;
+    const gint64 delay = MAX(g_get_monotonic_time() - dr->queued, 0);
+
+    stats->count++;
+    stats->total_delay_us += delay;
+    if (stats->max_delay_us < delay) {
+        stats->max_delay_us = delay;
+    }
+    if (delay >= G_USEC_PER_SEC) {
+        DBG_(data, "%s request %p waited %u ms", dr->name, dr, (guint)
+            (delay / 1000));
+    }
+}
+
+static
+gboolean
+binder_data_request_unlink(
+    BinderDataRequest** list,
+    BinderDataRequest* dr)
+{
+    BinderDataRequest* prev = *list;
+
+    if (prev == dr) {
+        *list = dr->next;
+        dr->next = NULL;
+        return TRUE;
+    }
+
+    while (prev && prev->next != dr) {
+        prev = prev->next;
+    }
+
+    if (prev) {
+        prev->next = dr->next;
+        dr->next = NULL;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+gboolean
+binder_data_request_can_run_with(
+    BinderDataRequest* dr,
+    BinderDataRequest* busy)
+{
+    if (busy->flags & DATA_REQUEST_FLAG_PARALLEL) {
+        BinderDataRequestSetup* s1 = G_CAST(dr, BinderDataRequestSetup, req);
+        BinderDataRequestSetup* s2 = G_CAST(busy,BinderDataRequestSetup,req);
+
+        /* Never two setups for the same APN at the same time */
+        return (s1->apn && s2->apn) ? g_ascii_strcasecmp(s1->apn, s2->apn) :
+            (s1->apn != s2->apn);
+    }
+    return FALSE;
+}
+
+static
+gboolean
+binder_data_request_can_submit(
+    BinderDataObject* data,
+    BinderDataRequest* dr)
+{
+    if (!data->pending_req && !data->parallel_req) {
+        return TRUE;
+    } else if (dr->flags & DATA_REQUEST_FLAG_PARALLEL) {
+        BinderDataRequest* busy = data->parallel_req;
+        guint n = 0;
+
+        if (data->pending_req) {
+            if (!binder_data_request_can_run_with(dr, data->pending_req)) {
+                return FALSE;
+            }
+            n++;
+        }
+        for (; busy; busy = busy->next) {
+            if (!binder_data_request_can_run_with(dr, busy)) {
+                return FALSE;
+            }
+            n++;
+        }
+        return n < data->options.data_call_parallel_setups;
+    }
+    return FALSE;
+}
+
 static
 void
 binder_data_request_submit_next(
     BinderDataObject* data)
 {
-    if (!data->pending_req) {
-        int submission_failure = 0;
+    int submission_failure = 0;
 
-        binder_data_power_update(data);
-        while (data->req_queue) {
-            BinderDataRequest* dr = data->req_queue;
+    binder_data_power_update(data);
+    while (data->req_queue &&
+        binder_data_request_can_submit(data, data->req_queue)) {
+        BinderDataRequest* dr = data->req_queue;
 
-            GASSERT(dr->data == data);
-            data->req_queue = dr->next;
-            dr->next = NULL;
+        GASSERT(dr->data == data);
+        data->req_queue = dr->next;
+        dr->next = NULL;
 
+        binder_data_request_update_stats(dr);
+        if (!data->pending_req) {
             data->pending_req = dr;
-            if (dr->submit(dr)) {
-                DBG_(data, "submitted %s request %p", dr->name, dr);
-                break;
-            } else {
-                DBG_(data, "%s request %p done (or failed)", dr->name, dr);
+        } else {
+            /* Setup running in parallel with the pending one(s) */
+            dr->next = data->parallel_req;
+            data->parallel_req = dr;
+        }
+
+        if (dr->submit(dr)) {
+            DBG_(data, "submitted %s request %p", dr->name, dr);
+        } else {
+            DBG_(data, "%s request %p done (or failed)", dr->name, dr);
+            if (data->pending_req == dr) {
                 data->pending_req = NULL;
-                if (dr->flags & DATA_REQUEST_FLAG_SUBMISSION_FAILURE) {
-                    submission_failure++;
-                }
-                binder_data_request_free(dr);
+            } else {
+                binder_data_request_unlink(&data->parallel_req, dr);
             }
+            binder_data_update_busy(data);
+            if (dr->flags & DATA_REQUEST_FLAG_SUBMISSION_FAILURE) {
+                submission_failure++;
+            }
+            binder_data_request_free(dr);
         }
+    }
 
-        if (!data->pending_req && !submission_failure) {
-            binder_data_manager_check_data(data->dm);
-        }
+    if (!data->pending_req && !data->parallel_req && !submission_failure) {
+        binder_data_manager_check_data(data->dm);
     }
     binder_data_power_update(data);
 }
@@ -1039,24 +1545,12 @@ binder_data_request_do_cancel(
         if (data->pending_req == dr) {
             /* Request has been submitted already */
             data->pending_req = NULL;
-        } else if (data->req_queue == dr) {
-            /* It's the first one in the queue */
-            data->req_queue = dr->next;
-        } else {
-            /* It's somewhere in the queue */
-            BinderDataRequest* prev = data->req_queue;
-
-            while (prev->next && prev->next != dr) {
-                prev = prev->next;
-            }
-
-            /* Assert that it's there */
-            GASSERT(prev);
-            if (prev) {
-                prev->next = dr->next;
-            }
+        } else if (!binder_data_request_unlink(&data->parallel_req, dr)) {
+            /* It's somewhere in the queue (assert that it's there) */
+            GVERIFY(binder_data_request_unlink(&data->req_queue, dr));
         }
 
+        binder_data_update_busy(data);
         binder_data_request_free(dr);
         return TRUE;
     } else {
@@ -1094,35 +1588,71 @@ binder_data_request_finish(
 {
     BinderDataObject* data = dr->data;
 
-    GASSERT(dr == data->pending_req);
-    GASSERT(!dr->next);
-    data->pending_req = NULL;
+    if (dr == data->pending_req) {
+        GASSERT(!dr->next);
+        data->pending_req = NULL;
+    } else {
+        GVERIFY(binder_data_request_unlink(&data->parallel_req, dr));
+    }
 
+    binder_data_update_busy(data);
     binder_data_request_free(dr);
     binder_data_request_submit_next(data);
 }
 
 static
 void
-binder_data_request_queue(
-    BinderDataRequest* dr)
+binder_data_request_insert(
+    BinderDataRequest* dr,
+    gboolean first)
 {
     BinderDataObject* data = dr->data;
+    BinderDataRequest* prev = NULL;
+    BinderDataRequest* next = data->req_queue;
 
-    dr->next = NULL;
+    /* Skip higher priority requests and, unless first, the same ones */
+    while (next && (next->priority > dr->priority ||
+        (!first && next->priority == dr->priority))) {
+        prev = next;
+        next = next->next;
+    }
 
-    if (!data->req_queue) {
-        data->req_queue = dr;
+    dr->next = next;
+    if (prev) {
+        prev->next = dr;
     } else {
-        BinderDataRequest* last = data->req_queue;
-
-        while (last->next) {
-            last = last->next;
-        }
-        last->next = dr;
+        data->req_queue = dr;
     }
+    binder_data_update_busy(data);
+}
+
+static
+void
+binder_data_request_queue(
+    BinderDataRequest* dr)
+{
+    BinderDataObject* data = dr->data;
+    BinderDataRequest* pending = data->pending_req;
 
+    dr->queued = g_get_monotonic_time();
+    binder_data_request_insert(dr, FALSE);
     DBG_(data, "queued %s request %p", dr->name, dr);
+
+    /*
+     * Lower priority request which isn't actually talking to the modem
+     * (e.g. setup waiting for the retry timeout) can step aside and wait
+     * at the head of its class.
+     */
+    if (pending && !data->parallel_req && pending->priority < dr->priority &&
+        pending->preempt && pending->preempt(pending)) {
+        DBG_(data, "%s request %p preempted by %s", pending->name,
+            pending, dr->name);
+        data->queue_stats[pending->priority].preempted++;
+        data->pending_req = NULL;
+        pending->queued = g_get_monotonic_time();
+        binder_data_request_insert(pending, TRUE);
+    }
+
     binder_data_request_submit_next(data);
 }
 
@@ -1167,6 +1697,23 @@ binder_data_call_setup_retry(
     return G_SOURCE_REMOVE;
 }
 
+static
+gboolean
+binder_data_call_setup_preempt(
+    BinderDataRequest* dr)
+{
+    BinderDataRequestSetup* setup = G_CAST(dr, BinderDataRequestSetup, req);
+
+    if (setup->retry_delay_id && !dr->radio_req) {
+        /* The retry will be submitted when it's our turn again */
+        g_source_remove(setup->retry_delay_id);
+        setup->retry_delay_id = 0;
+        setup->retry_count++;
+        return TRUE;
+    }
+    return FALSE;
+}
+
 static
 gboolean
 binder_data_call_retry(
@@ -1315,6 +1862,7 @@ binder_data_call_setup_cb(
                 binder_data_call_compare);
             DBG_(self, "new data call");
             binder_base_queue_property_change(base, BINDER_DATA_PROPERTY_CALLS);
+            binder_data_emit_call_event(self, BINDER_DATA_CALL_ADDED, call);
             free_call = NULL;
         }
     }
@@ -1532,9 +2080,12 @@ binder_data_call_setup_new(
     dr->arg = arg;
     dr->data = data;
     dr->submit = binder_data_call_setup_submit;
+    dr->preempt = binder_data_call_setup_preempt;
     dr->cancel = binder_data_call_setup_cancel;
     dr->free = binder_data_call_setup_free;
-    dr->flags = DATA_REQUEST_FLAG_CANCEL_WHEN_DISALLOWED;
+    dr->flags = DATA_REQUEST_FLAG_CANCEL_WHEN_DISALLOWED |
+        DATA_REQUEST_FLAG_PARALLEL;
+    dr->priority = DATA_REQUEST_PRIORITY_SETUP;
     return dr;
 }
 
@@ -1591,6 +2142,9 @@ binder_data_call_deact_cb(
                 if (call) {
                     DBG_(self, "removing call %d", deact->cid);
                     data->calls = g_slist_remove(data->calls, call);
+                } else {
+                    /* We don't seem to know what's going on */
+                    self->call_list_stale = TRUE;
                 }
             } else {
                 ofono_error("Unexpected deactivateDataCall response %d", resp);
@@ -1602,6 +2156,7 @@ binder_data_call_deact_cb(
     }
 
     if (call) {
+        binder_data_emit_call_event(self, BINDER_DATA_CALL_REMOVED, call);
         binder_data_call_free(call);
         binder_base_emit_property_change(base, BINDER_DATA_PROPERTY_CALLS);
     } else {
@@ -1646,6 +2201,7 @@ binder_data_call_deact_new(
     dr->data = data;
     dr->submit = binder_data_call_deact_submit;
     dr->cancel = binder_data_call_deact_cancel;
+    dr->priority = DATA_REQUEST_PRIORITY_DEACT;
     dr->name = "DEACTIVATE";
     return dr;
 }
@@ -1740,6 +2296,7 @@ binder_data_set_preferred_data_modem_new(
     dr->submit = binder_data_set_preferred_data_modem_submit;
     dr->cancel = binder_data_request_cancel_io;
     dr->flags = DATA_REQUEST_FLAG_CANCEL_WHEN_DISALLOWED;
+    dr->priority = DATA_REQUEST_PRIORITY_ALLOW;
     return dr;
 }
 
@@ -1823,6 +2380,7 @@ binder_data_allow_new(
     dr->submit = binder_data_allow_submit;
     dr->cancel = binder_data_request_cancel_io;
     dr->flags = DATA_REQUEST_FLAG_CANCEL_WHEN_DISALLOWED;
+    dr->priority = DATA_REQUEST_PRIORITY_ALLOW;
     ad->allow = allow;
     return dr;
 }
@@ -1876,6 +2434,22 @@ binder_data_max_allowed_modes(
         OFONO_RADIO_ACCESS_MODE_ALL;
 }
 
+const BinderDataSnapshot*
+binder_data_snapshot_ref(
+    BinderData* data)
+{
+    BinderDataObject* self = binder_data_cast(data);
+
+    return G_LIKELY(self) ? binder_base_snapshot_ref(&self->base) : NULL;
+}
+
+void
+binder_data_snapshot_unref(
+    const BinderDataSnapshot* snapshot)
+{
+    binder_base_snapshot_unref(snapshot);
+}
+
 gulong
 binder_data_add_property_handler(
     BinderData* data,
@@ -1889,6 +2463,32 @@ binder_data_add_property_handler(
         property, G_CALLBACK(callback), user_data) : 0;
 }
 
+gulong
+binder_data_add_call_handler(
+    BinderData* data,
+    int cid,
+    BinderDataCallFunc callback,
+    void* user_data)
+{
+    BinderDataObject* self = binder_data_cast(data);
+
+    if (G_LIKELY(self) && G_LIKELY(callback)) {
+        /* Same trick as in binder_base_add_property_handler() */
+        BinderDataCallClosure* closure = binder_data_call_closure_new();
+        GCClosure* cc = &closure->cclosure;
+
+        cc->closure.data = closure;
+        cc->callback = G_CALLBACK(binder_data_call_event);
+        closure->callback = callback;
+        closure->user_data = user_data;
+
+        return g_signal_connect_closure_by_id(self,
+            binder_data_object_signals[SIGNAL_CALL_EVENT],
+            binder_data_call_quark(cid), &cc->closure, FALSE);
+    }
+    return 0;
+}
+
 void
 binder_data_remove_handler(
     BinderData* data,
@@ -1943,10 +2543,32 @@ void binder_data_client_dead_cb(
 
     DBG_(data, "disconnected");
     data->flags = BINDER_DATA_FLAG_NONE;
+    binder_data_update_roles(data);
     data->restricted_state = 0;
+    data->call_list_stale = TRUE;
     binder_data_cancel_all_requests(data);
 }
 
+static
+void
+binder_data_modem_reset(
+    RadioClient* client,
+    RADIO_IND code,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderDataObject* data = THIS(user_data);
+
+    /* Indications may have been lost, get in sync with the modem */
+    DBG_(data, "modem reset");
+    data->call_list_stale = TRUE;
+    if (data->flags & BINDER_DATA_FLAG_ON) {
+        /* The modem may have forgotten that data is allowed */
+        binder_data_allow_submit_request(data, TRUE);
+    }
+    binder_data_query_call_state(data);
+}
+
 static
 gint
 binder_data_compare_cb(
@@ -1984,6 +2606,16 @@ binder_data_new(
         self->radio = binder_radio_ref(radio);
         self->network = binder_network_ref(network);
 
+        /*
+         * Starting with IRadio 1.4, dataCallListChanged is what Android
+         * itself relies on. Older adaptations are known to be sloppy.
+         */
+        self->call_list_ind_ok = options->call_list_poll ==
+            BINDER_DATA_CALL_LIST_POLL_AUTO &&
+            radio_client_interface(client) >= RADIO_INTERFACE_1_4;
+        DBG_(self, "call list %s", self->call_list_ind_ok ?
+            "event driven" : "polled");
+
         self->io_event_id[IO_EVENT_DATA_CALL_LIST_CHANGED_1_0] =
             radio_client_add_indication_handler(client,
                 RADIO_IND_DATA_CALL_LIST_CHANGED,
@@ -2000,6 +2632,9 @@ binder_data_new(
             radio_client_add_indication_handler(client,
                 RADIO_IND_RESTRICTED_STATE_CHANGED,
                 binder_data_restricted_state_changed, self);
+        self->io_event_id[IO_EVENT_MODEM_RESET] =
+            radio_client_add_indication_handler(client,
+                RADIO_IND_MODEM_RESET, binder_data_modem_reset, self);
         self->io_event_id[IO_EVENT_DEATH] =
             radio_client_add_death_handler(client,
                 binder_data_client_dead_cb, self);
@@ -2014,12 +2649,15 @@ binder_data_new(
                 binder_data_pref_changed, self);
 
         /* Request the current state */
-        binder_data_poll_call_state(data);
+        self->call_list_stale = TRUE;
+        binder_data_query_call_state(self);
 
         /* Order data contexts according to slot numbers */
         dm->data_list = g_slist_insert_sorted(dm->data_list, self,
             binder_data_compare_cb);
+        binder_data_manager_add_index(dm, self);
         binder_data_manager_check_network_mode(dm);
+        binder_base_update_snapshot(&self->base);
         return data;
     }
     return NULL;
@@ -2044,13 +2682,12 @@ binder_data_poll_call_state_retry(
     }
 }
 
+static
 void
-binder_data_poll_call_state(
-    BinderData* data)
+binder_data_query_call_state(
+    BinderDataObject* self)
 {
-    BinderDataObject* self = binder_data_cast(data);
-
-    if (G_LIKELY(self) && !self->query_req) {
+    if (!self->query_req) {
         RadioRequest* ioreq = radio_request_new2(self->g,
             RADIO_REQ_GET_DATA_CALL_LIST, NULL,
             binder_data_query_data_calls_cb, NULL, self);
@@ -2065,6 +2702,21 @@ binder_data_poll_call_state(
     }
 }
 
+void
+binder_data_poll_call_state(
+    BinderData* data)
+{
+    BinderDataObject* self = binder_data_cast(data);
+
+    if (G_LIKELY(self)) {
+        if (!self->call_list_ind_ok || self->call_list_stale) {
+            binder_data_query_call_state(self);
+        } else {
+            DBG_(self, "relying on dataCallListChanged");
+        }
+    }
+}
+
 BinderData*
 binder_data_ref(
     BinderData* data)
@@ -2095,6 +2747,94 @@ binder_data_allowed(
     return binder_data_is_allowed(binder_data_cast(data));
 }
 
+static
+void
+binder_data_queue_depth(
+    BinderDataObject* self,
+    guint* queued,
+    guint* running)
+{
+    const BinderDataRequest* dr;
+
+    memset(queued, 0, sizeof(queued[0]) * DATA_REQUEST_PRIORITY_COUNT);
+    memset(running, 0, sizeof(running[0]) * DATA_REQUEST_PRIORITY_COUNT);
+    for (dr = self->req_queue; dr; dr = dr->next) {
+        queued[dr->priority]++;
+    }
+    for (dr = self->parallel_req; dr; dr = dr->next) {
+        running[dr->priority]++;
+    }
+    if (self->pending_req) {
+        running[self->pending_req->priority]++;
+    }
+}
+
+char*
+binder_data_format_stats(
+    BinderData* data)
+{
+    BinderDataObject* self = binder_data_cast(data);
+
+    if (G_LIKELY(self)) {
+        GString* buf = g_string_new("# priority queued running count "
+            "preempted avg_delay_ms max_delay_ms\n");
+        guint queued[DATA_REQUEST_PRIORITY_COUNT];
+        guint running[DATA_REQUEST_PRIORITY_COUNT];
+        int i;
+
+        binder_data_queue_depth(self, queued, running);
+        for (i = 0; i < DATA_REQUEST_PRIORITY_COUNT; i++) {
+            const BinderDataQueueStats* stats = self->queue_stats + i;
+
+            g_string_append_printf(buf, "%d %u %u %u %u %u %u\n", i,
+                queued[i], running[i], stats->count, stats->preempted,
+                stats->count ? (guint)(stats->total_delay_us /
+                stats->count / 1000) : 0,
+                (guint)(stats->max_delay_us / 1000));
+        }
+        return g_string_free(buf, FALSE);
+    }
+    return NULL;
+}
+
+void
+binder_data_add_metrics(
+    BinderData* data,
+    BinderMetrics* metrics,
+    const char* labels)
+{
+    BinderDataObject* self = binder_data_cast(data);
+
+    if (G_LIKELY(self) && metrics) {
+        guint queued[DATA_REQUEST_PRIORITY_COUNT];
+        guint running[DATA_REQUEST_PRIORITY_COUNT];
+        int i;
+
+        binder_data_queue_depth(self, queued, running);
+        for (i = 0; i < DATA_REQUEST_PRIORITY_COUNT; i++) {
+            const BinderDataQueueStats* stats = self->queue_stats + i;
+            char* prio = binder_metrics_labels("priority",
+                binder_data_priority_name[i], NULL);
+            char* all = binder_metrics_labels_join(labels, prio);
+
+            binder_metrics_add(metrics, &binder_data_metric_queued, all,
+                queued[i]);
+            binder_metrics_add(metrics, &binder_data_metric_running, all,
+                running[i]);
+            binder_metrics_add(metrics, &binder_data_metric_submitted, all,
+                stats->count);
+            binder_metrics_add(metrics, &binder_data_metric_preempted, all,
+                stats->preempted);
+            binder_metrics_add_seconds(metrics, &binder_data_metric_delay,
+                all, stats->total_delay_us);
+            binder_metrics_add_seconds(metrics,
+                &binder_data_metric_max_delay, all, stats->max_delay_us);
+            g_free(all);
+            g_free(prio);
+        }
+    }
+}
+
 static
 void
 binder_data_deactivate_all(
@@ -2117,7 +2857,7 @@ void
 binder_data_power_update(
     BinderDataObject* self)
 {
-    if (self->pending_req || self->req_queue) {
+    if (self->pending_req || self->parallel_req || self->req_queue) {
         binder_radio_power_on(self->radio, self);
     } else {
         binder_radio_power_off(self->radio, self);
@@ -2142,6 +2882,16 @@ binder_data_cancel_requests(
         dr = next;
     }
 
+    dr = self->parallel_req;
+    while (dr) {
+        BinderDataRequest* next = dr->next;
+
+        if (dr->flags & flags) {
+            binder_data_request_cancel(dr);
+        }
+        dr = next;
+    }
+
     if (self->pending_req && (self->pending_req->flags & flags)) {
         binder_data_request_cancel(self->pending_req);
     }
@@ -2155,6 +2905,9 @@ binder_data_cancel_all_requests(
     BinderDataRequest* dr = self->req_queue;
 
     binder_data_request_do_cancel(self->pending_req);
+    while (self->parallel_req) {
+        binder_data_request_do_cancel(self->parallel_req);
+    }
     while (dr) {
         BinderDataRequest* next = dr->next;
 
@@ -2173,6 +2926,7 @@ binder_data_disallow(
     DBG_(self, "disallowed");
     GASSERT(self->flags & BINDER_DATA_FLAG_ALLOWED);
     self->flags &= ~BINDER_DATA_FLAG_ALLOWED;
+    binder_data_update_roles(self);
 
     /*
      * Cancel all requests that can be canceled.
@@ -2203,7 +2957,10 @@ binder_data_max_speed_cb(
     gpointer max_speed)
 {
     if (data != max_speed) {
-        THIS(data)->flags &= ~BINDER_DATA_FLAG_MAX_SPEED;
+        BinderDataObject* obj = THIS(data);
+
+        obj->flags &= ~BINDER_DATA_FLAG_MAX_SPEED;
+        binder_data_update_roles(obj);
     }
 }
 
@@ -2222,6 +2979,33 @@ binder_data_disallow_cb(
     }
 }
 
+/* Calls fn for the slots in the mask, other than the one given */
+static
+void
+binder_data_manager_foreach_other(
+    BinderDataManager* dm,
+    guint32 mask,
+    GFunc fn,
+    BinderDataObject* self)
+{
+    mask &= ~self->dm_bit;
+    while (mask) {
+        const int i = g_bit_nth_lsf(mask, -1);
+
+        mask &= ~(1u << i);
+        fn(dm->index[i], self);
+    }
+    if (G_UNLIKELY(dm->unindexed)) {
+        GSList* l;
+
+        for (l = dm->data_list; l; l = l->next) {
+            if (!THIS(l->data)->dm_bit) {
+                fn(l->data, self);
+            }
+        }
+    }
+}
+
 void
 binder_data_allow(
     BinderData* data,
@@ -2240,10 +3024,12 @@ binder_data_allow(
             if (role == OFONO_SLOT_DATA_INTERNET &&
                 !(self->flags & BINDER_DATA_FLAG_MAX_SPEED)) {
                 self->flags |= BINDER_DATA_FLAG_MAX_SPEED;
+                binder_data_update_roles(self);
                 speed_changed = TRUE;
 
                 /* Clear BINDER_DATA_FLAG_MAX_SPEED for all other slots */
-                g_slist_foreach(dm->data_list, binder_data_max_speed_cb, self);
+                binder_data_manager_foreach_other(dm, dm->max_speed_mask,
+                    binder_data_max_speed_cb, self);
             }
 
             if (self->flags & BINDER_DATA_FLAG_ALLOWED) {
@@ -2257,9 +3043,11 @@ binder_data_allow(
             } else {
                 self->flags |= BINDER_DATA_FLAG_ALLOWED;
                 self->flags &= ~BINDER_DATA_FLAG_ON;
+                binder_data_update_roles(self);
 
                 /* Clear BINDER_DATA_FLAG_ALLOWED for all other slots */
-                g_slist_foreach(dm->data_list, binder_data_disallow_cb, self);
+                binder_data_manager_foreach_other(dm, dm->allowed_mask,
+                    binder_data_disallow_cb, self);
                 binder_data_cancel_requests(self,
                     DATA_REQUEST_FLAG_CANCEL_WHEN_ALLOWED);
                 binder_data_manager_check_data(dm);
@@ -2360,8 +3148,21 @@ binder_data_object_finalize(
     BinderNetwork* network = self->network;
     BinderSimSettings* settings = network->settings;
     BinderDataManager* dm = self->dm;
+    int i;
+
+    for (i = 0; i < DATA_REQUEST_PRIORITY_COUNT; i++) {
+        const BinderDataQueueStats* stats = self->queue_stats + i;
+
+        if (stats->count) {
+            DBG_(self, "priority %d: %u request(s), %u preempted, "
+                "queued %u ms avg, %u ms max", i, stats->count,
+                stats->preempted, (guint)(stats->total_delay_us /
+                stats->count / 1000), (guint)(stats->max_delay_us / 1000));
+        }
+    }
 
     binder_data_cancel_all_requests(self);
+    binder_data_manager_remove_index(dm, self);
     dm->data_list = g_slist_remove(dm->data_list, self);
     binder_data_manager_check_data(dm);
 
@@ -2384,13 +3185,47 @@ binder_data_object_finalize(
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
+static
+gpointer
+binder_data_object_snapshot(
+    BinderBase* base)
+{
+    BinderDataObject* self = THIS(base);
+    const guint n = g_slist_length(self->pub.calls);
+    BinderDataSnapshot* snap;
+    BinderDataSnapshotCall* calls;
+    GSList* l;
+
+    /* The calls are stored right after the snapshot itself */
+    snap = binder_base_snapshot_new(sizeof(*snap) + n * sizeof(*calls), NULL);
+    calls = (BinderDataSnapshotCall*)(snap + 1);
+    snap->allowed = binder_data_is_allowed(self);
+    snap->count = n;
+    snap->calls = calls;
+    for (l = self->pub.calls; l; l = l->next) {
+        const BinderDataCall* call = l->data;
+
+        calls->cid = call->cid;
+        calls->status = call->status;
+        calls->active = call->active;
+        calls->prot = call->prot;
+        calls->mtu = call->mtu;
+        calls++;
+    }
+    return snap;
+}
+
 static
 void
 binder_data_object_class_init(
     BinderDataObjectClass* klass)
 {
-
     G_OBJECT_CLASS(klass)->finalize = binder_data_object_finalize;
+    BINDER_BASE_CLASS(klass)->snapshot = binder_data_object_snapshot;
+    binder_data_object_signals[SIGNAL_CALL_EVENT] =
+        g_signal_new(SIGNAL_CALL_EVENT_NAME, G_OBJECT_CLASS_TYPE(klass),
+            G_SIGNAL_RUN_FIRST | G_SIGNAL_DETAILED, 0, NULL, NULL, NULL,
+            G_TYPE_NONE, 2, G_TYPE_UINT, G_TYPE_POINTER);
 }
 
 /*==========================================================================*
@@ -2542,6 +3377,48 @@ binder_data_manager_set_radio_config(
     }
 }
 
+static
+void
+binder_data_manager_add_index(
+    BinderDataManager* dm,
+    BinderDataObject* data)
+{
+    const guint32 unused = ~dm->used_mask;
+
+    if (unused) {
+        const int i = g_bit_nth_lsf(unused, -1);
+
+        data->dm_bit = 1u << i;
+        dm->used_mask |= data->dm_bit;
+        dm->index[i] = data;
+        binder_data_update_busy(data);
+        binder_data_update_roles(data);
+    } else {
+        DBG_(data, "not indexed");
+        dm->unindexed++;
+    }
+}
+
+static
+void
+binder_data_manager_remove_index(
+    BinderDataManager* dm,
+    BinderDataObject* data)
+{
+    if (data->dm_bit) {
+        const guint32 bit = data->dm_bit;
+
+        dm->index[g_bit_nth_lsf(bit, -1)] = NULL;
+        dm->used_mask &= ~bit;
+        dm->busy_mask &= ~bit;
+        dm->allowed_mask &= ~bit;
+        dm->max_speed_mask &= ~bit;
+        data->dm_bit = 0;
+    } else {
+        dm->unindexed--;
+    }
+}
+
 static
 gboolean
 binder_data_manager_handover(
@@ -2560,16 +3437,20 @@ gboolean
 binder_data_manager_requests_pending(
     BinderDataManager* dm)
 {
-    GSList* l;
+    if (dm->busy_mask) {
+        return TRUE;
+    } else if (G_UNLIKELY(dm->unindexed)) {
+        GSList* l;
 
-    for (l = dm->data_list; l; l = l->next) {
-        BinderDataObject* data = THIS(l->data);
+        for (l = dm->data_list; l; l = l->next) {
+            BinderDataObject* data = THIS(l->data);
 
-        if (data->pending_req || data->req_queue) {
-            return TRUE;
+            if (!data->dm_bit && (data->pending_req ||
+                data->parallel_req || data->req_queue)) {
+                return TRUE;
+            }
         }
     }
-
     return FALSE;
 }
 
@@ -2587,25 +3468,23 @@ binder_data_manager_check_network_mode(
         const enum ofono_radio_access_mode non_data_mask =
             (dm->non_data_mode << 1) - 1;
 
-        /* Find a SIM for internet access */
-        for (l = dm->data_list; l; l = l->next) {
-            BinderDataObject* data = THIS(l->data);
-            BinderNetwork* network = data->network;
-            BinderSimSettings* sim = network->settings;
-            enum ofono_radio_access_mode mode;
-
-            /* Select the first network with internet role */
-            if ((sim->pref > OFONO_RADIO_ACCESS_MODE_GSM) &&
-                (data->flags & BINDER_DATA_FLAG_MAX_SPEED)) {
-                lte_network = network;
-                break;
+        /* The SIM selected for internet access, if there is one */
+        if (dm->max_speed_mask && !dm->unindexed) {
+            BinderDataObject* data =
+                dm->index[g_bit_nth_lsf(dm->max_speed_mask, -1)];
+
+            if (data->network->settings->pref > OFONO_RADIO_ACCESS_MODE_GSM) {
+                lte_network = data->network;
             }
+        } else {
+            for (l = dm->data_list; l && !lte_network; l = l->next) {
+                BinderDataObject* data = THIS(l->data);
+                BinderSimSettings* sim = data->network->settings;
 
-            /* At the same time, look for a suitable slot */
-            mode = binder_network_max_supported_mode(network);
-            if (mode > best_mode) {
-                best_network = network;
-                best_mode = mode;
+                if ((sim->pref > OFONO_RADIO_ACCESS_MODE_GSM) &&
+                    (data->flags & BINDER_DATA_FLAG_MAX_SPEED)) {
+                    lte_network = data->network;
+                }
             }
         }
 
@@ -2613,6 +3492,16 @@ binder_data_manager_check_network_mode(
          * If there's no SIM selected for internet access
          * then use a slot with highest capabilities for LTE.
          */
+        for (l = dm->data_list; l && !lte_network; l = l->next) {
+            BinderNetwork* network = THIS(l->data)->network;
+            const enum ofono_radio_access_mode mode =
+                binder_network_max_supported_mode(network);
+
+            if (mode > best_mode) {
+                best_network = network;
+                best_mode = mode;
+            }
+        }
         if (!lte_network) {
             lte_network = best_network;
         }
@@ -2641,13 +3530,18 @@ binder_data_manager_allowed(
     BinderDataManager* dm)
 {
     if (dm) {
-        GSList* l;
+        if (dm->allowed_mask) {
+            /* No more than one slot at a time has data allowed */
+            return dm->index[g_bit_nth_lsf(dm->allowed_mask, -1)];
+        } else if (G_UNLIKELY(dm->unindexed)) {
+            GSList* l;
 
-        for (l = dm->data_list; l; l = l->next) {
-            BinderDataObject* data = THIS(l->data);
+            for (l = dm->data_list; l; l = l->next) {
+                BinderDataObject* data = THIS(l->data);
 
-            if (data->flags & BINDER_DATA_FLAG_ALLOWED) {
-                return data;
+                if (data->flags & BINDER_DATA_FLAG_ALLOWED) {
+                    return data;
+                }
             }
         }
     }
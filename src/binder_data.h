@@ -50,6 +50,12 @@ struct binder_data {
     GSList* calls;
 };
 
+typedef enum binder_data_call_event {
+    BINDER_DATA_CALL_ADDED,
+    BINDER_DATA_CALL_CHANGED,
+    BINDER_DATA_CALL_REMOVED
+} BINDER_DATA_CALL_EVENT;
+
 typedef enum binder_data_manager_flags {
     BINDER_DATA_MANAGER_NO_FLAGS = 0x00,
     BINDER_DATA_MANAGER_3GLTE_HANDOVER = 0x01
@@ -60,14 +66,36 @@ typedef enum binder_data_allow_data {
     BINDER_ALLOW_DATA_ENABLED
 } BINDER_DATA_ALLOW_DATA;
 
+typedef enum binder_data_call_list_poll {
+    BINDER_DATA_CALL_LIST_POLL_AUTO,    /* Only when indications may be lost */
+    BINDER_DATA_CALL_LIST_POLL_ALWAYS
+} BINDER_DATA_CALL_LIST_POLL;
+
 typedef struct binder_data_options {
     BINDER_DATA_ALLOW_DATA allow_data;
+    BINDER_DATA_CALL_LIST_POLL call_list_poll;
     unsigned int data_call_retry_limit;
     unsigned int data_call_retry_delay_ms;
+    unsigned int data_call_parallel_setups;
 } BinderDataOptions;
 
 typedef struct binder_data_request BinderDataRequest;
 
+/* Immutable copy of the public state, safe to use from any thread */
+typedef struct binder_data_snapshot_call {
+    int cid;
+    RADIO_DATA_CALL_FAIL_CAUSE status;
+    RADIO_DATA_CALL_ACTIVE_STATUS active;
+    enum ofono_gprs_proto prot;
+    int mtu;
+} BinderDataSnapshotCall;
+
+typedef struct binder_data_snapshot {
+    gboolean allowed;
+    guint count;
+    const BinderDataSnapshotCall* calls;
+} BinderDataSnapshot;
+
 typedef
 void
 (*BinderDataPropertyFunc)(
@@ -75,6 +103,15 @@ void
     BINDER_DATA_PROPERTY property,
     void* user_data);
 
+/* The call pointer is only valid for the duration of the callback */
+typedef
+void
+(*BinderDataCallFunc)(
+    BinderData* data,
+    BINDER_DATA_CALL_EVENT event,
+    const BinderDataCall* call,
+    void* user_data);
+
 typedef
 void
 (*BinderDataCallSetupFunc)(
@@ -154,11 +191,35 @@ binder_data_allowed(
     BinderData* data)
     BINDER_INTERNAL;
 
+/* Request queue depth and delays per priority class */
+char*
+binder_data_format_stats(
+    BinderData* data)
+    G_GNUC_WARN_UNUSED_RESULT
+    BINDER_INTERNAL;
+
+void
+binder_data_add_metrics(
+    BinderData* data,
+    BinderMetrics* metrics,
+    const char* labels)
+    BINDER_INTERNAL;
+
 void
 binder_data_poll_call_state(
     BinderData* data)
     BINDER_INTERNAL;
 
+const BinderDataSnapshot*
+binder_data_snapshot_ref(
+    BinderData* data)
+    BINDER_INTERNAL;
+
+void
+binder_data_snapshot_unref(
+    const BinderDataSnapshot* snapshot)
+    BINDER_INTERNAL;
+
 gulong
 binder_data_add_property_handler(
     BinderData* data,
@@ -167,6 +228,14 @@ binder_data_add_property_handler(
     void* user_data)
     BINDER_INTERNAL;
 
+gulong
+binder_data_add_call_handler(
+    BinderData* data,
+    int cid,
+    BinderDataCallFunc cb,
+    void* user_data)
+    BINDER_INTERNAL;
+
 void
 binder_data_remove_handler(
     BinderData* data,
@@ -0,0 +1,324 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_decoder.h"
+#include "binder_log.h"
+#include "binder_metrics.h"
+
+#include <ofono/log.h>
+
+#include <gutil_macros.h>
+
+#define BINDER_DECODER_STATS_FILE "decoder.stats"
+#define BINDER_DECODER_STATS_SUFFIX "-" BINDER_DECODER_STATS_FILE
+
+typedef struct binder_decoder_stats {
+    guint jobs;
+    guint64 main_us;        /* Main loop time, total */
+    guint64 max_main_us;
+    guint64 latency_us;     /* From submission to completion, total */
+    guint64 max_latency_us;
+} BinderDecoderStats;
+
+static const BinderMetricFamily binder_decoder_metric_jobs = {
+    "binder_decoder_jobs", BINDER_METRIC_COUNTER,
+    "Decoded parcels"
+};
+static const BinderMetricFamily binder_decoder_metric_main = {
+    "binder_decoder_main_loop_seconds", BINDER_METRIC_COUNTER,
+    "Main loop time spent on decoded parcels"
+};
+static const BinderMetricFamily binder_decoder_metric_latency = {
+    "binder_decoder_latency_seconds", BINDER_METRIC_COUNTER,
+    "Time from submission to completion"
+};
+static const BinderMetricFamily binder_decoder_metric_max_latency = {
+    "binder_decoder_max_latency_seconds", BINDER_METRIC_GAUGE,
+    "Longest time from submission to completion"
+};
+
+typedef struct binder_decoder_job {
+    BinderDecoder* decoder;
+    const char* name;
+    BinderDecoderFunc decode;
+    BinderDecoderFunc done;
+    gpointer data;
+    gint64 submitted;
+    gint64 decode_us;
+} BinderDecoderJob;
+
+struct binder_decoder {
+    gint ref_count;
+    char* name;
+    GThreadPool* pool;
+    GHashTable* stats;      /* name => BinderDecoderStats */
+    gboolean stats_dirty;
+};
+
+static
+void
+binder_decoder_job_done(
+    BinderDecoderJob* job)
+{
+    BinderDecoder* self = job->decoder;
+    const gint64 start = g_get_monotonic_time();
+    BinderDecoderStats* stats;
+    guint64 main_us, latency_us;
+
+    job->done(job->data);
+
+    /* Inline decoding is all main loop time */
+    main_us = g_get_monotonic_time() - start;
+    latency_us = g_get_monotonic_time() - job->submitted;
+    if (!self->pool) {
+        main_us += job->decode_us;
+    }
+
+    stats = g_hash_table_lookup(self->stats, job->name);
+    if (!stats) {
+        stats = g_new0(BinderDecoderStats, 1);
+        g_hash_table_insert(self->stats, (gpointer)job->name, stats);
+    }
+    stats->jobs++;
+    stats->main_us += main_us;
+    stats->latency_us += latency_us;
+    if (stats->max_main_us < main_us) {
+        stats->max_main_us = main_us;
+    }
+    if (stats->max_latency_us < latency_us) {
+        stats->max_latency_us = latency_us;
+    }
+    self->stats_dirty = TRUE;
+    DBG("%s%s%s main %u us, total %u us (%s)", self->name ? self->name :
+        "", self->name ? " " : "", job->name, (guint)main_us,
+        (guint)latency_us, self->pool ? "threaded" : "inline");
+
+    binder_decoder_unref(self);
+    gutil_slice_free(job);
+}
+
+static
+void
+binder_decoder_job_decode(
+    BinderDecoderJob* job)
+{
+    const gint64 start = g_get_monotonic_time();
+
+    job->decode(job->data);
+    job->decode_us = g_get_monotonic_time() - start;
+}
+
+static
+gboolean
+binder_decoder_job_done_cb(
+    gpointer user_data)
+{
+    binder_decoder_job_done(user_data);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+binder_decoder_thread_func(
+    gpointer job,
+    gpointer user_data)
+{
+    binder_decoder_job_decode(job);
+
+    /* Back to the main loop, idle sources of equal priority are FIFO */
+    g_idle_add_full(G_PRIORITY_DEFAULT, binder_decoder_job_done_cb, job,
+        NULL);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderDecoder*
+binder_decoder_new(
+    const char* name,
+    gboolean threaded)
+{
+    BinderDecoder* self = g_new0(BinderDecoder, 1);
+
+    self->name = g_strdup(name);
+    g_atomic_int_set(&self->ref_count, 1);
+    self->stats = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+        g_free);
+    if (threaded) {
+        GError* error = NULL;
+
+        /* One exclusive thread keeps the jobs in order */
+        self->pool = g_thread_pool_new(binder_decoder_thread_func, self,
+            1, TRUE, &error);
+        if (!self->pool) {
+            ofono_warn("Failed to start decoder thread: %s", error->message);
+            g_error_free(error);
+        }
+    }
+    DBG("%s%s%s", self->name ? self->name : "", self->name ? " " : "",
+        self->pool ? "threaded" : "inline");
+    return self;
+}
+
+BinderDecoder*
+binder_decoder_ref(
+    BinderDecoder* self)
+{
+    if (G_LIKELY(self)) {
+        g_atomic_int_inc(&self->ref_count);
+    }
+    return self;
+}
+
+void
+binder_decoder_unref(
+    BinderDecoder* self)
+{
+    if (G_LIKELY(self) && g_atomic_int_dec_and_test(&self->ref_count)) {
+        /* Every job holds a reference, i.e. the pool is idle */
+        if (self->pool) {
+            g_thread_pool_free(self->pool, FALSE, TRUE);
+        }
+        g_hash_table_destroy(self->stats);
+        g_free(self->name);
+        g_free(self);
+    }
+}
+
+void
+binder_decoder_submit(
+    BinderDecoder* self,
+    const char* name,
+    BinderDecoderFunc decode,
+    BinderDecoderFunc done,
+    gpointer data)
+{
+    if (self) {
+        BinderDecoderJob* job = g_slice_new0(BinderDecoderJob);
+
+        job->decoder = binder_decoder_ref(self);
+        job->name = name;
+        job->decode = decode;
+        job->done = done;
+        job->data = data;
+        job->submitted = g_get_monotonic_time();
+        if (self->pool) {
+            g_thread_pool_push(self->pool, job, NULL);
+        } else {
+            binder_decoder_job_decode(job);
+            binder_decoder_job_done(job);
+        }
+    } else {
+        decode(data);
+        done(data);
+    }
+}
+
+char*
+binder_decoder_format_stats(
+    BinderDecoder* self)
+{
+    GString* buf = g_string_new(NULL);
+
+    if (self) {
+        GHashTableIter it;
+        gpointer key, value;
+
+        g_string_append_printf(buf, "# mode %s\n", self->pool ?
+            "threaded" : "inline");
+        g_string_append(buf, "# name jobs avg_main_us max_main_us"
+            " avg_latency_us max_latency_us\n");
+        g_hash_table_iter_init(&it, self->stats);
+        while (g_hash_table_iter_next(&it, &key, &value)) {
+            const BinderDecoderStats* stats = value;
+
+            g_string_append_printf(buf, "%s %u %" G_GUINT64_FORMAT " %"
+                G_GUINT64_FORMAT " %" G_GUINT64_FORMAT " %"
+                G_GUINT64_FORMAT "\n", (const char*)key, stats->jobs,
+                stats->main_us / stats->jobs, stats->max_main_us,
+                stats->latency_us / stats->jobs, stats->max_latency_us);
+        }
+    }
+    return g_string_free(buf, FALSE);
+}
+
+void
+binder_decoder_add_metrics(
+    BinderDecoder* self,
+    BinderMetrics* metrics,
+    const char* labels)
+{
+    if (self && metrics) {
+        GHashTableIter it;
+        gpointer key, value;
+
+        g_hash_table_iter_init(&it, self->stats);
+        while (g_hash_table_iter_next(&it, &key, &value)) {
+            const BinderDecoderStats* stats = value;
+            char* job = binder_metrics_labels("job", key, NULL);
+            char* all = binder_metrics_labels_join(labels, job);
+
+            binder_metrics_add(metrics, &binder_decoder_metric_jobs, all,
+                stats->jobs);
+            binder_metrics_add_seconds(metrics, &binder_decoder_metric_main,
+                all, stats->main_us);
+            binder_metrics_add_seconds(metrics,
+                &binder_decoder_metric_latency, all, stats->latency_us);
+            binder_metrics_add_seconds(metrics,
+                &binder_decoder_metric_max_latency, all,
+                stats->max_latency_us);
+            g_free(all);
+            g_free(job);
+        }
+    }
+}
+
+gboolean
+binder_decoder_write_stats(
+    BinderDecoder* self,
+    const char* dir)
+{
+    gboolean ok = FALSE;
+
+    if (self && dir && self->stats_dirty) {
+        char* file = self->name ?
+            g_strconcat(self->name, BINDER_DECODER_STATS_SUFFIX, NULL) :
+            g_strdup(BINDER_DECODER_STATS_FILE);
+        char* path = g_build_filename(dir, file, NULL);
+        char* text = binder_decoder_format_stats(self);
+        GError* error = NULL;
+
+        if (g_file_set_contents(path, text, -1, &error)) {
+            self->stats_dirty = FALSE;
+            ok = TRUE;
+        } else {
+            ofono_warn("Failed to write %s: %s", path, error->message);
+            g_error_free(error);
+        }
+        g_free(text);
+        g_free(path);
+        g_free(file);
+    }
+    return ok;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
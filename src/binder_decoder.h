@@ -0,0 +1,94 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_DECODER_H
+#define BINDER_DECODER_H
+
+#include "binder_types.h"
+
+/*
+ * Runs the expensive part of turning a parcel into ofono structures.
+ * What's copied out of the parcel (which is only valid for the duration
+ * of the callback) is handed over to the decode function, which runs
+ * either on the worker thread or right away on the main thread,
+ * depending on how the decoder was created. The done function is always
+ * invoked on the main thread, in submission order.
+ *
+ * The decode function must not touch anything but its data. In both
+ * modes the decoder measures how long the main loop was kept busy and
+ * the overall latency, so that the modes can be compared.
+ *
+ * Each threaded decoder has its own thread. Giving each slot its own
+ * decoder keeps heavy lists on one slot from delaying the others.
+ */
+
+typedef
+void
+(*BinderDecoderFunc)(
+    gpointer data);
+
+BinderDecoder*
+binder_decoder_new(
+    const char* name, /* NULL for the shared one */
+    gboolean threaded)
+    BINDER_INTERNAL;
+
+BinderDecoder*
+binder_decoder_ref(
+    BinderDecoder* decoder)
+    BINDER_INTERNAL;
+
+void
+binder_decoder_unref(
+    BinderDecoder* decoder)
+    BINDER_INTERNAL;
+
+/* NULL decoder runs everything synchronously and doesn't count */
+void
+binder_decoder_submit(
+    BinderDecoder* decoder,
+    const char* name,
+    BinderDecoderFunc decode,
+    BinderDecoderFunc done,
+    gpointer data)
+    BINDER_INTERNAL;
+
+char*
+binder_decoder_format_stats(
+    BinderDecoder* decoder)
+    BINDER_INTERNAL;
+
+void
+binder_decoder_add_metrics(
+    BinderDecoder* decoder,
+    BinderMetrics* metrics,
+    const char* labels)
+    BINDER_INTERNAL;
+
+gboolean
+binder_decoder_write_stats(
+    BinderDecoder* decoder,
+    const char* dir)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_DECODER_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
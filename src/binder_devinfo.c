@@ -14,6 +14,7 @@
  */
 
 #include "binder_devinfo.h"
+#include "binder_identity.h"
 #include "binder_modem.h"
 #include "binder_util.h"
 
@@ -30,7 +31,8 @@
 
 enum binder_devinfo_cb_tag {
     DEVINFO_QUERY_SERIAL = 1,
-    DEVINFO_QUERY_SVN
+    DEVINFO_QUERY_SVN,
+    DEVINFO_QUERY_REVISION
 };
 
 typedef struct binder_devinfo {
@@ -38,8 +40,11 @@ typedef struct binder_devinfo {
     RadioRequestGroup* g;
     GUtilIdleQueue* iq;
     char* log_prefix;
+    char* path;
     char* imeisv;
     char* imei;
+    char* baseband; /* Remembered from the previous run */
+    gboolean baseband_checked;
 } BinderDevInfo;
 
 typedef struct binder_devinfo_callback_data {
@@ -94,6 +99,7 @@ binder_devinfo_query_revision_ok(
     const BinderDevInfoCbData* cbd,
     const GBinderReader* args)
 {
+    BinderDevInfo* self = cbd->self;
     struct ofono_error err;
     GBinderReader reader;
     const char* res;
@@ -101,8 +107,15 @@ binder_devinfo_query_revision_ok(
     /* getBasebandVersionResponse(RadioResponseInfo, string version); */
     gbinder_reader_copy(&reader, args);
     res = gbinder_reader_read_hidl_string_c(&reader);
-    DBG_(cbd->self, "%s", res);
-    cbd->cb(binder_error_ok(&err), res ? res : "", cbd->data);
+    DBG_(self, "%s", res);
+    if (res && res[0] && g_strcmp0(self->baseband, res)) {
+        g_free(self->baseband);
+        self->baseband = g_strdup(res);
+        binder_identity_set(self->path, BINDER_IDENTITY_BASEBAND, res);
+    }
+    if (cbd->cb) {
+        cbd->cb(binder_error_ok(&err), res ? res : "", cbd->data);
+    }
 }
 
 static
@@ -130,28 +143,47 @@ binder_devinfo_query_revision_cb(
             ofono_error("Unexpected getBasebandVersion response %d", resp);
         }
     }
-    cbd->cb(binder_error_failure(&err), NULL, cbd->data);
+    if (cbd->cb) {
+        cbd->cb(binder_error_failure(&err), NULL, cbd->data);
+    }
 }
 
 static
 void
-binder_devinfo_query_revision(
-    struct ofono_devinfo* di,
+binder_devinfo_query_revision_submit(
+    BinderDevInfo* self,
     ofono_devinfo_query_cb_t cb,
     void* data)
 {
-    BinderDevInfo* self = binder_devinfo_get_data(di);
     RadioRequest* req = radio_request_new2(self->g,
         RADIO_REQ_GET_BASEBAND_VERSION, NULL,
         binder_devinfo_query_revision_cb,
         binder_devinfo_callback_data_free,
         binder_devinfo_callback_data_new(self, cb, data));
 
-    DBG_(self, "");
+    self->baseband_checked = TRUE;
     radio_request_submit(req);
     radio_request_unref(req);
 }
 
+static
+void
+binder_devinfo_query_revision_cached_cb(
+    gpointer user_data)
+{
+    BinderDevInfoCbData* cbd = user_data;
+    BinderDevInfo* self = cbd->self;
+    struct ofono_error error;
+
+    DBG_(self, "%s (cached)", self->baseband);
+    cbd->cb(binder_error_ok(&error), self->baseband, cbd->data);
+
+    /* Validate the remembered value, no one is waiting for it */
+    if (!self->baseband_checked) {
+        binder_devinfo_query_revision_submit(self, NULL, NULL);
+    }
+}
+
 static
 void
 binder_devinfo_query_serial_cb(
@@ -197,6 +229,24 @@ binder_devinfo_query(
         binder_devinfo_callback_data_free);
 }
 
+static
+void
+binder_devinfo_query_revision(
+    struct ofono_devinfo* di,
+    ofono_devinfo_query_cb_t cb,
+    void* data)
+{
+    BinderDevInfo* self = binder_devinfo_get_data(di);
+
+    DBG_(self, "");
+    if (self->baseband) {
+        binder_devinfo_query(self, DEVINFO_QUERY_REVISION,
+            binder_devinfo_query_revision_cached_cb, cb, data);
+    } else {
+        binder_devinfo_query_revision_submit(self, cb, data);
+    }
+}
+
 static
 void
 binder_devinfo_query_serial(
@@ -251,6 +301,9 @@ binder_devinfo_probe(
     DBG_(self, "%s", modem->imei);
     self->g = radio_request_group_new(modem->client);
     self->di = di;
+    self->path = g_strdup(modem->path);
+    self->baseband = binder_identity_get(self->path,
+        BINDER_IDENTITY_BASEBAND);
     self->imeisv = g_strdup(modem->imeisv);
     self->imei = g_strdup(modem->imei);
     self->iq = gutil_idle_queue_new();
@@ -273,6 +326,8 @@ binder_devinfo_remove(
     gutil_idle_queue_cancel_all(self->iq);
     gutil_idle_queue_unref(self->iq);
     g_free(self->log_prefix);
+    g_free(self->baseband);
+    g_free(self->path);
     g_free(self->imeisv);
     g_free(self->imei);
     g_free(self);
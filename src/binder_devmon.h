@@ -17,6 +17,7 @@
 #define BINDER_DEVMON_H
 
 #include "binder_types.h"
+#include "binder_devmon_state.h"
 
 #include <ofono/slot.h>
 
@@ -41,10 +42,15 @@ struct binder_devmon {
  * This Device Monitor uses sendDeviceState() call to let the modem
  * choose the right power saving strategy. It basically mirrors the
  * logic of DeviceStateMonitor class in Android.
+ *
+ * Both implementations react to the same BinderDevmonState, so that
+ * the device state is evaluated once per burst of events for all of
+ * them. Each request is only sent when its value has changed.
  */
 BinderDevmon*
 binder_devmon_ds_new(
-    const BinderSlotConfig* config)
+    const BinderSlotConfig* config,
+    BinderDevmonState* state)
     BINDER_INTERNAL;
 
 /*
@@ -53,7 +59,8 @@ binder_devmon_ds_new(
  */
 BinderDevmon*
 binder_devmon_if_new(
-    const BinderSlotConfig* config)
+    const BinderSlotConfig* config,
+    BinderDevmonState* state)
     BINDER_INTERNAL;
 
 /*
@@ -13,16 +13,13 @@
  *  GNU General Public License for more details.
  */
 
+#include "binder_batman.h"
 #include "binder_devmon.h"
-#include "binder_connman.h"
+#include "binder_devmon_state.h"
 #include "binder_log.h"
 
 #include <ofono/log.h>
 
-#include <mce_battery.h>
-#include <mce_charger.h>
-#include <mce_display.h>
-
 #include <radio_client.h>
 #include <radio_request.h>
 
@@ -32,55 +29,18 @@
 
 #include <batman/batman-wrappers.h>
 
-#include <sys/inotify.h>
-#include <limits.h>
-#include <errno.h>
-
-#define BATMAN_SCREEN_PATH "/var/lib/batman/screen"
-#define EVENT_BUF_LEN     (10 * (sizeof(struct inotify_event) + NAME_MAX + 1))
-
-enum binder_devmon_ds_battery_event {
-    BATTERY_EVENT_VALID,
-    BATTERY_EVENT_STATUS,
-    BATTERY_EVENT_COUNT
-};
-
-enum binder_devmon_ds_charger_event {
-    CHARGER_EVENT_VALID,
-    CHARGER_EVENT_STATE,
-    CHARGER_EVENT_COUNT
-};
-
-enum binder_devmon_ds_display_event {
-    DISPLAY_EVENT_VALID,
-    DISPLAY_EVENT_STATE,
-    DISPLAY_EVENT_COUNT
-};
-
-enum binder_devmon_ds_connman_event {
-    CONNMAN_EVENT_VALID,
-    CONNMAN_EVENT_TETHERING,
-    CONNMAN_EVENT_COUNT
-};
-
 typedef struct binder_devmon_ds {
     BinderDevmon pub;
-    BinderConnman* connman;
-    MceBattery* battery;
-    MceCharger* charger;
-    MceDisplay* display;
+    BinderDevmonState* state;
     int cell_info_interval_short_ms;
     int cell_info_interval_long_ms;
-    UpClient* upower;
+    BinderBatman* batman;
 } DevMon;
 
 typedef struct binder_devmon_ds_io {
     BinderDevmonIo pub;
-    BinderConnman* connman;
+    BinderDevmonState* state;
     struct ofono_slot* slot;
-    MceBattery* battery;
-    MceCharger* charger;
-    MceDisplay* display;
     RadioClient* client;
     RadioRequest* low_data_req;
     RadioRequest* charging_req;
@@ -88,16 +48,12 @@ typedef struct binder_devmon_ds_io {
     gboolean charging;
     gboolean low_data_supported;
     gboolean charging_supported;
-    gulong connman_event_id[CONNMAN_EVENT_COUNT];
-    gulong battery_event_id[BATTERY_EVENT_COUNT];
-    gulong charger_event_id[CHARGER_EVENT_COUNT];
-    gulong display_event_id[DISPLAY_EVENT_COUNT];
+    gulong state_event_id;
+    gulong reset_event_id;
     int cell_info_interval_short_ms;
     int cell_info_interval_long_ms;
-    UpClient* upower;
-    int batman_inotify_fd;
-    int batman_screen_wd;
-    guint batman_watch_source;
+    BinderBatman* batman;
+    gulong batman_event_id;
 } DevMonIo;
 
 #define DBG_(self,fmt,args...) \
@@ -109,18 +65,6 @@ static inline DevMon* binder_devmon_ds_cast(BinderDevmon* pub)
 static inline DevMonIo* binder_devmon_ds_io_cast(BinderDevmonIo* pub)
     { return G_CAST(pub, DevMonIo, pub); }
 
-static inline gboolean binder_devmon_ds_tethering_on(BinderConnman* connman)
-    { return connman->valid && connman->tethering; }
-
-static inline gboolean binder_devmon_ds_battery_ok(MceBattery* battery)
-    { return battery->valid && battery->status >= MCE_BATTERY_OK; }
-
-static inline gboolean binder_devmon_ds_charging(MceCharger* charger)
-    { return charger->valid && charger->state == MCE_CHARGER_ON; }
-
-static inline gboolean binder_devmon_ds_display_on(MceDisplay* display)
-    { return display->valid && display->state != MCE_DISPLAY_STATE_OFF; }
-
 static
 void
 binder_devmon_ds_io_low_data_state_sent(
@@ -207,7 +151,7 @@ void
 binder_devmon_ds_io_update_charging(
     DevMonIo* self)
 {
-    const gboolean charging = binder_devmon_ds_charging(self->charger);
+    const gboolean charging = self->state->charging;
 
     if (self->charging != charging) {
         self->charging = charging;
@@ -226,10 +170,9 @@ void
 binder_devmon_ds_io_update_low_data(
     DevMonIo* self)
 {
-    const gboolean low_data =
-        !binder_devmon_ds_tethering_on(self->connman) &&
-        !binder_devmon_ds_charging(self->charger) &&
-        !binder_devmon_ds_display_on(self->display);
+    const BinderDevmonState* state = self->state;
+    const gboolean low_data = !state->tethering && !state->charging &&
+        !state->display_on;
 
     if (self->low_data != low_data) {
         self->low_data = low_data;
@@ -248,131 +191,49 @@ void
 binder_devmon_ds_io_set_cell_info_update_interval(
     DevMonIo* self)
 {
-    ofono_slot_set_cell_info_update_interval(self->slot, self,
-        (binder_devmon_ds_display_on(self->display) &&
-            (binder_devmon_ds_charging(self->charger) ||
-                binder_devmon_ds_battery_ok(self->battery))) ?
-                    self->cell_info_interval_short_ms :
-                    self->cell_info_interval_long_ms);
-}
-
-static
-void
-binder_devmon_ds_io_connman_cb(
-    BinderConnman* connman,
-    BINDER_CONNMAN_PROPERTY property,
-    void* user_data)
-{
-    binder_devmon_ds_io_update_low_data((DevMonIo*)user_data);
-}
+    const BinderDevmonState* state = self->state;
 
-static
-void
-binder_devmon_ds_io_battery_cb(
-    MceBattery* battery,
-    void* user_data)
-{
-    binder_devmon_ds_io_set_cell_info_update_interval((DevMonIo*)user_data);
+    ofono_slot_set_cell_info_update_interval(self->slot, self,
+        (state->display_on && (state->charging || state->battery_ok)) ?
+            self->cell_info_interval_short_ms :
+            self->cell_info_interval_long_ms);
 }
 
 static
 void
-binder_devmon_ds_io_display_cb(
-    MceDisplay* display,
+binder_devmon_ds_io_state_cb(
+    BinderDevmonState* state,
+    BINDER_DEVMON_STATE_PROPERTY property,
     void* user_data)
 {
     DevMonIo* self = user_data;
 
+    /* Invoked once per burst of device events */
     binder_devmon_ds_io_update_low_data(self);
+    binder_devmon_ds_io_update_charging(self);
     binder_devmon_ds_io_set_cell_info_update_interval(self);
 }
 
 static
 void
-binder_devmon_ds_io_charger_cb(
-    MceCharger* charger,
+binder_devmon_ds_io_batman_cb(
+    BinderBatman* batman,
+    BINDER_BATMAN_PROPERTY property,
     void* user_data)
 {
     DevMonIo* self = user_data;
-
-    binder_devmon_ds_io_update_low_data(self);
-    binder_devmon_ds_io_update_charging(self);
-    binder_devmon_ds_io_set_cell_info_update_interval(self);
-}
-
-static
-gboolean
-handle_batman_inotify_events_ds(
-    GIOChannel* channel,
-    GIOCondition condition,
-    gpointer user_data)
-{
-    DevMonIo* self = user_data;
-
-    if (channel) {
-        gchar buf[EVENT_BUF_LEN];
-        gsize bytes_read;
-        GError* error = NULL;
-
-        if (condition & (G_IO_HUP | G_IO_ERR | G_IO_NVAL)) {
-            DBG_(self, "inotify watch failed, condition: %d", condition);
-            self->batman_watch_source = 0;
-            return G_SOURCE_REMOVE;
-        }
-
-        GIOStatus status = g_io_channel_read_chars(channel, buf, sizeof(buf),
-            &bytes_read, &error);
-
-        if (status == G_IO_STATUS_ERROR) {
-            if (error) {
-                DBG_(self, "inotify read failed, error: %s", error->message);
-                g_error_free(error);
-            }
-            self->batman_watch_source = 0;
-            return G_SOURCE_REMOVE;
-        }
-
-        if (bytes_read == 0) {
-            DBG_(self, "No bytes read from inotify");
-            return G_SOURCE_CONTINUE;
-        }
-    }
-
-    int state = BATMAN_UNKNOWN;
-    int display = 0;
-
-    FILE *screen_file = fopen(BATMAN_SCREEN_PATH, "r");
-    if (screen_file != NULL) {
-        char screen_state[4];
-        if (fgets(screen_state, sizeof(screen_state), screen_file) != NULL) {
-            if (strncmp(screen_state, "yes", 3) == 0)
-                display = 1;
-            DBG_(self, "screen state: %s", screen_state);
-        } else {
-            DBG_(self, "Failed to read screen state");
-        }
-        fclose(screen_file);
-    } else {
-        DBG_(self, "Failed to open screen state file: %s", strerror(errno));
-    }
-
-    state = get_battery_state(self->upower);
-    DBG_(self, "Battery state: %s",
-         state == BATMAN_NO_BATTERY ? "no battery" :
-         state == BATMAN_CHARGING ? "charging" :
-         state == BATMAN_DISCHARGING ? "discharging" :
-         state == BATMAN_FULLY_CHARGED ? "fully charged" : "unknown");
-
-    // Handle low data state changes
-    const gboolean low_data = (display == 0 && state == BATMAN_DISCHARGING);
+    const int state = batman->battery_state;
+    const gboolean display = batman->display_on;
+    const gboolean low_data = !display && state == BATMAN_DISCHARGING;
+    const gboolean charging = (state == BATMAN_CHARGING ||
+        state == BATMAN_FULLY_CHARGED);
+    int cell_info_interval;
+
+    /* Handle low data state changes */
     if (self->low_data != low_data) {
         DBG_(self, "Low data changed from %s to %s (screen:%d battery:%s)",
-             self->low_data ? "true" : "false", low_data ? "true" : "false",
-             display,
-             state == BATMAN_NO_BATTERY ? "no battery" :
-             state == BATMAN_CHARGING ? "charging" :
-             state == BATMAN_DISCHARGING ? "discharging" :
-             state == BATMAN_FULLY_CHARGED ? "fully charged" : "unknown");
+            self->low_data ? "true" : "false", low_data ? "true" : "false",
+            display, binder_batman_battery_state_name(state));
         self->low_data = low_data;
         if (self->low_data_supported) {
             radio_request_drop(self->low_data_req);
@@ -382,11 +243,10 @@ handle_batman_inotify_events_ds(
         }
     }
 
-    // Handle charging state changes
-    const gboolean charging = (state == BATMAN_CHARGING || state == BATMAN_FULLY_CHARGED);
+    /* Handle charging state changes */
     if (self->charging != charging) {
         DBG_(self, "Charging changed from %s to %s",
-             self->charging ? "true" : "false", charging ? "true" : "false");
+            self->charging ? "true" : "false", charging ? "true" : "false");
         self->charging = charging;
         if (self->charging_supported) {
             radio_request_drop(self->charging_req);
@@ -396,61 +256,41 @@ handle_batman_inotify_events_ds(
         }
     }
 
-    gint cell_info_interval = (display || charging) ?
-                               self->cell_info_interval_short_ms :
-                               self->cell_info_interval_long_ms;
-
+    cell_info_interval = (display || charging) ?
+        self->cell_info_interval_short_ms :
+        self->cell_info_interval_long_ms;
     DBG_(self, "Setting cell info interval: %d (display:%d charging:%d)",
-         cell_info_interval, display, charging);
-
-    ofono_slot_set_cell_info_update_interval(self->slot, self, cell_info_interval);
-    return G_SOURCE_CONTINUE;
+        cell_info_interval, display, charging);
+    ofono_slot_set_cell_info_update_interval(self->slot, self,
+        cell_info_interval);
 }
 
 static
 void
-binder_devmon_ds_io_init_batman_watch(
-    DevMonIo* self)
+binder_devmon_ds_io_modem_reset(
+    RadioClient* client,
+    RADIO_IND code,
+    const GBinderReader* args,
+    gpointer user_data)
 {
-    GIOChannel* channel;
+    DevMonIo* self = user_data;
 
-    self->batman_inotify_fd = inotify_init();
-    if (self->batman_inotify_fd < 0) {
-        DBG_(self, "Failed to initialize inotify: %s", strerror(errno));
-        return;
+    /* The modem doesn't remember the device state across resets */
+    DBG_(self, "Replaying device state");
+    if (self->low_data_supported) {
+        radio_request_drop(self->low_data_req);
+        self->low_data_req = binder_devmon_ds_io_send_device_state(self,
+            RADIO_DEVICE_STATE_LOW_DATA_EXPECTED, self->low_data,
+            binder_devmon_ds_io_low_data_state_sent);
     }
-
-    DBG_(self, "inotify initialized successfully, fd=%d", self->batman_inotify_fd);
-
-    self->batman_screen_wd = inotify_add_watch(self->batman_inotify_fd,
-        BATMAN_SCREEN_PATH, IN_MODIFY | IN_CLOSE_WRITE);
-
-    if (self->batman_screen_wd < 0) {
-        DBG_(self, "Failed to add watch: %s", strerror(errno));
-        close(self->batman_inotify_fd);
-        self->batman_inotify_fd = -1;
-        return;
+    if (self->charging_supported) {
+        radio_request_drop(self->charging_req);
+        self->charging_req = binder_devmon_ds_io_send_device_state(self,
+            RADIO_DEVICE_STATE_CHARGING_STATE, self->charging,
+            binder_devmon_ds_io_charging_state_sent);
     }
-
-    DBG_(self, "watcher successfully added, wd=%d", self->batman_screen_wd);
-
-    channel = g_io_channel_unix_new(self->batman_inotify_fd);
-    g_io_channel_set_encoding(channel, NULL, NULL);
-    g_io_channel_set_flags(channel, G_IO_FLAG_NONBLOCK, NULL);
-    g_io_channel_set_buffered(channel, FALSE);
-
-    self->batman_watch_source = g_io_add_watch(channel,
-        G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
-        handle_batman_inotify_events_ds, self);
-
-    DBG_(self, "GIO watcher added, source=%u", self->batman_watch_source);
-
-    g_io_channel_unref(channel);
-
-    handle_batman_inotify_events_ds(NULL, G_IO_IN, self);
 }
 
-
 static
 void
 binder_devmon_ds_io_free(
@@ -458,31 +298,19 @@ binder_devmon_ds_io_free(
 {
     DevMonIo* self = binder_devmon_ds_io_cast(io);
 
-    binder_connman_remove_all_handlers(self->connman, self->connman_event_id);
-    binder_connman_unref(self->connman);
-
-    mce_battery_remove_all_handlers(self->battery, self->battery_event_id);
-    mce_battery_unref(self->battery);
-
-    mce_charger_remove_all_handlers(self->charger, self->charger_event_id);
-    mce_charger_unref(self->charger);
-
-    mce_display_remove_all_handlers(self->display, self->display_event_id);
-    mce_display_unref(self->display);
+    binder_devmon_state_remove_handler(self->state, self->state_event_id);
+    binder_devmon_state_unref(self->state);
 
     radio_request_drop(self->low_data_req);
     radio_request_drop(self->charging_req);
+    radio_client_remove_handler(self->client, self->reset_event_id);
     radio_client_unref(self->client);
 
     ofono_slot_drop_cell_info_requests(self->slot, self);
     ofono_slot_unref(self->slot);
 
-    if (self->batman_watch_source)
-        g_source_remove(self->batman_watch_source);
-    if (self->batman_screen_wd >= 0)
-        inotify_rm_watch(self->batman_inotify_fd, self->batman_screen_wd);
-    if (self->batman_inotify_fd >= 0)
-        close(self->batman_inotify_fd);
+    binder_batman_remove_handler(self->batman, self->batman_event_id);
+    binder_batman_unref(self->batman);
 
     g_free(self);
 }
@@ -503,50 +331,29 @@ binder_devmon_ds_start_io(
     self->client = radio_client_ref(client);
     self->slot = ofono_slot_ref(slot);
 
-    self->connman = binder_connman_ref(ds->connman);
-    self->connman_event_id[CONNMAN_EVENT_VALID] =
-        binder_connman_add_property_changed_handler(self->connman,
-            BINDER_CONNMAN_PROPERTY_VALID,
-            binder_devmon_ds_io_connman_cb, self);
-    self->connman_event_id[CONNMAN_EVENT_TETHERING] =
-        binder_connman_add_property_changed_handler(self->connman,
-            BINDER_CONNMAN_PROPERTY_TETHERING,
-            binder_devmon_ds_io_connman_cb, self);
-
-    self->battery = mce_battery_ref(ds->battery);
-    self->battery_event_id[BATTERY_EVENT_VALID] =
-        mce_battery_add_valid_changed_handler(self->battery,
-            binder_devmon_ds_io_battery_cb, self);
-    self->battery_event_id[BATTERY_EVENT_STATUS] =
-        mce_battery_add_status_changed_handler(self->battery,
-            binder_devmon_ds_io_battery_cb, self);
-
-    self->charger = mce_charger_ref(ds->charger);
-    self->charger_event_id[CHARGER_EVENT_VALID] =
-        mce_charger_add_valid_changed_handler(self->charger,
-            binder_devmon_ds_io_charger_cb, self);
-    self->charger_event_id[CHARGER_EVENT_STATE] =
-        mce_charger_add_state_changed_handler(self->charger,
-            binder_devmon_ds_io_charger_cb, self);
-
-    self->display = mce_display_ref(ds->display);
-    self->display_event_id[DISPLAY_EVENT_VALID] =
-        mce_display_add_valid_changed_handler(self->display,
-            binder_devmon_ds_io_display_cb, self);
-    self->display_event_id[DISPLAY_EVENT_STATE] =
-        mce_display_add_state_changed_handler(self->display,
-            binder_devmon_ds_io_display_cb, self);
+    self->state = binder_devmon_state_ref(ds->state);
+    self->state_event_id =
+        binder_devmon_state_add_profile_changed_handler(self->state,
+            binder_devmon_ds_io_state_cb, self);
+    self->reset_event_id = radio_client_add_indication_handler(client,
+        RADIO_IND_MODEM_RESET, binder_devmon_ds_io_modem_reset, self);
 
     self->cell_info_interval_short_ms = ds->cell_info_interval_short_ms;
     self->cell_info_interval_long_ms = ds->cell_info_interval_long_ms;
 
-    self->upower = ds->upower;
+    self->batman = binder_batman_ref(ds->batman);
+    self->batman_event_id =
+        binder_batman_add_state_changed_handler(self->batman,
+            binder_devmon_ds_io_batman_cb, self);
 
     binder_devmon_ds_io_update_low_data(self);
     binder_devmon_ds_io_update_charging(self);
     binder_devmon_ds_io_set_cell_info_update_interval(self);
 
-    binder_devmon_ds_io_init_batman_watch(self);
+    if (self->batman->valid) {
+        binder_devmon_ds_io_batman_cb(self->batman,
+            BINDER_BATMAN_PROPERTY_STATE, self);
+    }
 
     return &self->pub;
 }
@@ -558,11 +365,8 @@ binder_devmon_ds_free(
 {
     DevMon* self = binder_devmon_ds_cast(devmon);
 
-    binder_connman_unref(self->connman);
-    mce_battery_unref(self->battery);
-    mce_charger_unref(self->charger);
-    mce_display_unref(self->display);
-    g_object_unref(self->upower);
+    binder_devmon_state_unref(self->state);
+    binder_batman_unref(self->batman);
     g_free(self);
 }
 
@@ -572,17 +376,15 @@ binder_devmon_ds_free(
 
 BinderDevmon*
 binder_devmon_ds_new(
-    const BinderSlotConfig* config)
+    const BinderSlotConfig* config,
+    BinderDevmonState* state)
 {
     DevMon* self = g_new0(DevMon, 1);
 
     self->pub.free = binder_devmon_ds_free;
     self->pub.start_io = binder_devmon_ds_start_io;
-    self->connman = binder_connman_new();
-    self->battery = mce_battery_new();
-    self->charger = mce_charger_new();
-    self->display = mce_display_new();
-    self->upower = up_client_new();
+    self->state = binder_devmon_state_ref(state);
+    self->batman = binder_batman_new();
     self->cell_info_interval_short_ms = config->cell_info_interval_short_ms;
     self->cell_info_interval_long_ms = config->cell_info_interval_long_ms;
     return &self->pub;
@@ -13,15 +13,13 @@
  *  GNU General Public License for more details.
  */
 
+#include "binder_batman.h"
 #include "binder_devmon.h"
+#include "binder_devmon_state.h"
 #include "binder_log.h"
 
 #include <ofono/log.h>
 
-#include <mce_battery.h>
-#include <mce_charger.h>
-#include <mce_display.h>
-
 #include <radio_client.h>
 #include <radio_request.h>
 
@@ -29,82 +27,53 @@
 
 #include <gutil_macros.h>
 
-#include <batman/batman-wrappers.h>
-
-#include <sys/inotify.h>
-#include <limits.h>
-#include <errno.h>
-
-#define BATMAN_SCREEN_PATH "/var/lib/batman/screen"
-#define EVENT_BUF_LEN     (10 * (sizeof(struct inotify_event) + NAME_MAX + 1))
-
-enum binder_devmon_if_battery_event {
-    BATTERY_EVENT_VALID,
-    BATTERY_EVENT_STATUS,
-    BATTERY_EVENT_COUNT
-};
+#include <string.h>
 
-enum binder_devmon_if_charger_event {
-    CHARGER_EVENT_VALID,
-    CHARGER_EVENT_STATE,
-    CHARGER_EVENT_COUNT
-};
-
-enum binder_devmon_if_display_event {
-    DISPLAY_EVENT_VALID,
-    DISPLAY_EVENT_STATE,
-    DISPLAY_EVENT_COUNT
-};
+#include <batman/batman-wrappers.h>
 
 typedef struct binder_devmon_if {
     BinderDevmon pub;
-    MceBattery* battery;
-    MceCharger* charger;
-    MceDisplay* display;
+    BinderDevmonState* state;
     int cell_info_interval_short_ms;
     int cell_info_interval_long_ms;
-    UpClient* upower;
+    BinderDevmonProfile profile[BINDER_DEVMON_PROFILE_COUNT];
+    BinderBatman* batman;
 } DevMon;
 
 typedef struct binder_devmon_if_io {
     BinderDevmonIo pub;
+    BinderDevmonState* state;
     struct ofono_slot* slot;
-    MceBattery* battery;
-    MceCharger* charger;
-    MceDisplay* display;
     RadioClient* client;
     RadioRequest* req;
-    gboolean display_on;
+    BINDER_DEVMON_PROFILE profile_id;
+    int ind_filter; /* The last one sent, -1 if none */
     gboolean ind_filter_supported;
-    gulong battery_event_id[BATTERY_EVENT_COUNT];
-    gulong charger_event_id[CHARGER_EVENT_COUNT];
-    gulong display_event_id[DISPLAY_EVENT_COUNT];
+    gulong state_event_id;
+    gulong reset_event_id;
     int cell_info_interval_short_ms;
     int cell_info_interval_long_ms;
-    UpClient* upower;
-    int batman_inotify_fd;
-    int batman_screen_wd;
-    guint batman_watch_source;
+    BinderDevmonProfile profile[BINDER_DEVMON_PROFILE_COUNT];
+    BinderBatman* batman;
+    gulong batman_event_id;
 } DevMonIo;
 
 #define DBG_(self,fmt,args...) \
     DBG("%s: " fmt, radio_client_slot((self)->client), ##args)
 
+static const char* binder_devmon_if_profile_name[] = {
+    "screen-on", "screen-on-low-battery", "screen-off-charging",
+    "screen-off-idle", "tethering"
+};
+G_STATIC_ASSERT(G_N_ELEMENTS(binder_devmon_if_profile_name) ==
+    BINDER_DEVMON_PROFILE_COUNT);
+
 inline static DevMon* binder_devmon_if_cast(BinderDevmon* pub)
     { return G_CAST(pub, DevMon, pub); }
 
 inline static DevMonIo* binder_devmon_if_io_cast(BinderDevmonIo* pub)
     { return G_CAST(pub, DevMonIo, pub); }
 
-static inline gboolean binder_devmon_if_battery_ok(MceBattery* battery)
-    { return battery->valid && battery->status >= MCE_BATTERY_OK; }
-
-static inline gboolean binder_devmon_if_charging(MceCharger* charger)
-    { return charger->valid && charger->state == MCE_CHARGER_ON; }
-
-static gboolean binder_devmon_if_display_on(MceDisplay* display)
-    { return display->valid && display->state != MCE_DISPLAY_STATE_OFF; }
-
 static
 void
 binder_devmon_if_io_indication_filter_sent(
@@ -134,12 +103,34 @@ binder_devmon_if_io_indication_filter_sent(
     }
 }
 
+static
+BINDER_DEVMON_PROFILE
+binder_devmon_if_io_select_profile(
+    DevMonIo* self)
+{
+    const BinderDevmonState* state = self->state;
+
+    if (state->tethering &&
+        self->profile[BINDER_DEVMON_PROFILE_TETHERING].enabled) {
+        return BINDER_DEVMON_PROFILE_TETHERING;
+    } else if (state->display_on) {
+        return (state->charging || state->battery_ok) ?
+            BINDER_DEVMON_PROFILE_SCREEN_ON :
+            BINDER_DEVMON_PROFILE_SCREEN_ON_LOW_BATTERY;
+    } else {
+        return state->charging ?
+            BINDER_DEVMON_PROFILE_SCREEN_OFF_CHARGING :
+            BINDER_DEVMON_PROFILE_SCREEN_OFF_IDLE;
+    }
+}
+
 static
 void
 binder_devmon_if_io_set_indication_filter(
     DevMonIo* self)
 {
     if (self->ind_filter_supported) {
+        const BinderDevmonProfile* profile = self->profile + self->profile_id;
         GBinderWriter args;
         RADIO_REQ code;
         gint32 value;
@@ -152,32 +143,39 @@ binder_devmon_if_io_set_indication_filter(
          *
          * and both produce IRadioResponse.setIndicationFilterResponse()
          *
-         * However setIndicationFilter_1_2 comments says "If unset, defaults
-         * to @1.2::IndicationFilter:ALL" and it's unclear what "unset" means
-         * wrt a bitmask. How is "unset" different from NONE which is zero.
-         * To be on the safe side, let's always set the most innocently
-         * looking bit which I think is DATA_CALL_DORMANCY.
+         * The bits which the interface doesn't know about are dropped.
          */
         if (radio_client_interface(self->client) < RADIO_INTERFACE_1_2) {
             code = RADIO_REQ_SET_INDICATION_FILTER;
-            value = self->display_on ? RADIO_IND_FILTER_ALL :
-                RADIO_IND_FILTER_DATA_CALL_DORMANCY;
+            value = profile->ind_filter & RADIO_IND_FILTER_ALL;
         } else if (radio_client_interface(self->client) < RADIO_INTERFACE_1_5) {
             code = RADIO_REQ_SET_INDICATION_FILTER_1_2;
-            value = self->display_on ? RADIO_IND_FILTER_ALL_1_2 :
-                RADIO_IND_FILTER_DATA_CALL_DORMANCY;
+            value = profile->ind_filter & RADIO_IND_FILTER_ALL_1_2;
         } else {
             code = RADIO_REQ_SET_INDICATION_FILTER_1_5;
-            value = self->display_on ? RADIO_IND_FILTER_ALL_1_5 :
-                RADIO_IND_FILTER_DATA_CALL_DORMANCY;
+            value = profile->ind_filter & RADIO_IND_FILTER_ALL_1_5;
         }
 
-        radio_request_drop(self->req);
-        self->req = radio_request_new(self->client, code, &args,
-            binder_devmon_if_io_indication_filter_sent, NULL, self);
-        gbinder_writer_append_int32(&args, value);
-        DBG_(self, "Setting indication filter: 0x%02x", value);
-        radio_request_submit(self->req);
+        /*
+         * However setIndicationFilter_1_2 comments says "If unset, defaults
+         * to @1.2::IndicationFilter:ALL" and it's unclear what "unset" means
+         * wrt a bitmask. How is "unset" different from NONE which is zero.
+         * To be on the safe side, let's never send zero and set the most
+         * innocently looking bit which I think is DATA_CALL_DORMANCY.
+         */
+        if (!value) {
+            value = RADIO_IND_FILTER_DATA_CALL_DORMANCY;
+        }
+
+        if (self->ind_filter != value) {
+            self->ind_filter = value;
+            radio_request_drop(self->req);
+            self->req = radio_request_new(self->client, code, &args,
+                binder_devmon_if_io_indication_filter_sent, NULL, self);
+            gbinder_writer_append_int32(&args, value);
+            DBG_(self, "Setting indication filter: 0x%02x", value);
+            radio_request_submit(self->req);
+        }
     }
 }
 
@@ -187,165 +185,75 @@ binder_devmon_if_io_set_cell_info_update_interval(
     DevMonIo* self)
 {
     ofono_slot_set_cell_info_update_interval(self->slot, self,
-        (self->display_on && (binder_devmon_if_charging(self->charger) ||
-            binder_devmon_if_battery_ok(self->battery))) ?
-                self->cell_info_interval_short_ms :
-                self->cell_info_interval_long_ms);
+        self->profile[self->profile_id].cell_info_interval_ms);
 }
 
 static
 void
-binder_devmon_if_io_battery_cb(
-    MceBattery* battery,
-    void* user_data)
+binder_devmon_if_io_apply_profile(
+    DevMonIo* self)
 {
-    binder_devmon_if_io_set_cell_info_update_interval((DevMonIo*)user_data);
-}
+    const BINDER_DEVMON_PROFILE id = binder_devmon_if_io_select_profile(self);
 
-static
-void binder_devmon_if_io_charger_cb(
-    MceCharger* charger,
-    void* user_data)
-{
-    binder_devmon_if_io_set_cell_info_update_interval((DevMonIo*)user_data);
+    if (self->profile_id != id) {
+        self->profile_id = id;
+        DBG_(self, "Profile %s", binder_devmon_if_profile_name[id]);
+    }
+    binder_devmon_if_io_set_indication_filter(self);
+    binder_devmon_if_io_set_cell_info_update_interval(self);
 }
 
 static
 void
-binder_devmon_if_io_display_cb(
-    MceDisplay* display,
+binder_devmon_if_io_state_cb(
+    BinderDevmonState* state,
+    BINDER_DEVMON_STATE_PROPERTY property,
     void* user_data)
 {
     DevMonIo* self = user_data;
-    const gboolean display_on = binder_devmon_if_display_on(display);
 
-    if (self->display_on != display_on) {
-        self->display_on = display_on;
-        binder_devmon_if_io_set_indication_filter(self);
-        binder_devmon_if_io_set_cell_info_update_interval(self);
-    }
+    /* Invoked once per burst of device events */
+    binder_devmon_if_io_apply_profile(self);
 }
 
 static
-gboolean
-handle_batman_inotify_events_if(
-    GIOChannel* channel,
-    GIOCondition condition,
-    gpointer user_data)
+void
+binder_devmon_if_io_batman_cb(
+    BinderBatman* batman,
+    BINDER_BATMAN_PROPERTY property,
+    void* user_data)
 {
     DevMonIo* self = user_data;
-
-    if (channel) {
-        gchar buf[EVENT_BUF_LEN];
-        gsize bytes_read;
-        GError* error = NULL;
-
-        if (condition & (G_IO_HUP | G_IO_ERR | G_IO_NVAL)) {
-            DBG_(self, "inotify watch failed, condition: %d", condition);
-            self->batman_watch_source = 0;
-            return G_SOURCE_REMOVE;
-        }
-
-        GIOStatus status = g_io_channel_read_chars(channel, buf, sizeof(buf),
-            &bytes_read, &error);
-
-        if (status == G_IO_STATUS_ERROR) {
-            if (error) {
-                DBG_(self, "inotify read error: %s", error->message);
-                g_error_free(error);
-            }
-            self->batman_watch_source = 0;
-            return G_SOURCE_REMOVE;
-        }
-
-        if (bytes_read == 0) {
-            DBG_(self, "No bytes read from inotify");
-            return G_SOURCE_CONTINUE;
-        }
-    }
-
-    int state = BATMAN_UNKNOWN;
-    int display = 0;
-    int battery_state = -1;
-
-    FILE *screen_file = fopen(BATMAN_SCREEN_PATH, "r");
-    if (screen_file != NULL) {
-        char screen_state[4];
-        if (fgets(screen_state, sizeof(screen_state), screen_file) != NULL) {
-            if (strncmp(screen_state, "yes", 3) == 0)
-                display = 1;
-            DBG_(self, "screen state: %s", screen_state);
-        } else {
-            DBG_(self, "Failed to read screen state");
-        }
-        fclose(screen_file);
-    } else {
-        DBG_(self, "Failed to open screen state file: %s", strerror(errno));
-    }
-
-    state = get_battery_state(self->upower);
-    DBG_(self, "Battery state: %s",
-         state == BATMAN_NO_BATTERY ? "no battery" :
-         state == BATMAN_CHARGING ? "charging" :
-         state == BATMAN_DISCHARGING ? "discharging" :
-         state == BATMAN_FULLY_CHARGED ? "fully charged" : "unknown");
-
-    const gboolean charging = (battery_state == BATMAN_CHARGING || battery_state == BATMAN_FULLY_CHARGED);
-    gint cell_info_interval = (display || charging) ?
-                               self->cell_info_interval_short_ms :
-                               self->cell_info_interval_long_ms;
+    const int state = batman->battery_state;
+    const gboolean display = batman->display_on;
+    const gboolean charging = (state == BATMAN_CHARGING ||
+        state == BATMAN_FULLY_CHARGED);
+    const int cell_info_interval = (display || charging) ?
+        self->cell_info_interval_short_ms :
+        self->cell_info_interval_long_ms;
 
     DBG_(self, "Setting cell info interval: %d (display:%d charging:%d)",
-         cell_info_interval, display, charging);
-
-    ofono_slot_set_cell_info_update_interval(self->slot, self, cell_info_interval);
-    return G_SOURCE_CONTINUE;
+        cell_info_interval, display, charging);
+    ofono_slot_set_cell_info_update_interval(self->slot, self,
+        cell_info_interval);
 }
 
 static
 void
-binder_devmon_if_io_init_batman_watch(
-    DevMonIo* self)
+binder_devmon_if_io_modem_reset(
+    RadioClient* client,
+    RADIO_IND code,
+    const GBinderReader* args,
+    gpointer user_data)
 {
-    GIOChannel* channel;
-
-    self->batman_inotify_fd = inotify_init();
-    if (self->batman_inotify_fd < 0) {
-        DBG_(self, "Failed to initialize inotify: %s", strerror(errno));
-        return;
-    }
-
-    DBG_(self, "inotify initialized successfully, fd=%d", self->batman_inotify_fd);
-
-    self->batman_screen_wd = inotify_add_watch(self->batman_inotify_fd,
-        BATMAN_SCREEN_PATH, IN_MODIFY | IN_CLOSE_WRITE);
-
-    if (self->batman_screen_wd < 0) {
-        DBG_(self, "Failed to add watch: %s", strerror(errno));
-        close(self->batman_inotify_fd);
-        self->batman_inotify_fd = -1;
-        return;
-    }
-
-    DBG_(self, "watcher successfully added, wd=%d", self->batman_screen_wd);
-
-    channel = g_io_channel_unix_new(self->batman_inotify_fd);
-    g_io_channel_set_encoding(channel, NULL, NULL);
-    g_io_channel_set_flags(channel, G_IO_FLAG_NONBLOCK, NULL);
-    g_io_channel_set_buffered(channel, FALSE);
-
-    self->batman_watch_source = g_io_add_watch(channel,
-        G_IO_IN | G_IO_HUP | G_IO_ERR | G_IO_NVAL,
-        handle_batman_inotify_events_if, self);
-
-    DBG_(self, "GIO watcher added, source=%u", self->batman_watch_source);
-
-    g_io_channel_unref(channel);
+    DevMonIo* self = user_data;
 
-    handle_batman_inotify_events_if(NULL, G_IO_IN, self);
+    /* The modem doesn't remember the filter across resets */
+    DBG_(self, "Replaying indication filter");
+    self->ind_filter = -1;
+    binder_devmon_if_io_set_indication_filter(self);
 }
 
-
 static
 void
 binder_devmon_if_io_free(
@@ -353,27 +261,18 @@ binder_devmon_if_io_free(
 {
     DevMonIo* self = binder_devmon_if_io_cast(io);
 
-    mce_battery_remove_all_handlers(self->battery, self->battery_event_id);
-    mce_battery_unref(self->battery);
-
-    mce_charger_remove_all_handlers(self->charger, self->charger_event_id);
-    mce_charger_unref(self->charger);
-
-    mce_display_remove_all_handlers(self->display, self->display_event_id);
-    mce_display_unref(self->display);
+    binder_devmon_state_remove_handler(self->state, self->state_event_id);
+    binder_devmon_state_unref(self->state);
 
     radio_request_drop(self->req);
+    radio_client_remove_handler(self->client, self->reset_event_id);
     radio_client_unref(self->client);
 
     ofono_slot_drop_cell_info_requests(self->slot, self);
     ofono_slot_unref(self->slot);
 
-    if (self->batman_watch_source)
-        g_source_remove(self->batman_watch_source);
-    if (self->batman_screen_wd >= 0)
-        inotify_rm_watch(self->batman_inotify_fd, self->batman_screen_wd);
-    if (self->batman_inotify_fd >= 0)
-        close(self->batman_inotify_fd);
+    binder_batman_remove_handler(self->batman, self->batman_event_id);
+    binder_batman_unref(self->batman);
 
     g_free(self);
 }
@@ -393,40 +292,32 @@ binder_devmon_if_start_io(
     self->client = radio_client_ref(client);
     self->slot = ofono_slot_ref(slot);
 
-    self->battery = mce_battery_ref(impl->battery);
-    self->battery_event_id[BATTERY_EVENT_VALID] =
-        mce_battery_add_valid_changed_handler(self->battery,
-            binder_devmon_if_io_battery_cb, self);
-    self->battery_event_id[BATTERY_EVENT_STATUS] =
-        mce_battery_add_status_changed_handler(self->battery,
-            binder_devmon_if_io_battery_cb, self);
-
-    self->charger = mce_charger_ref(impl->charger);
-    self->charger_event_id[CHARGER_EVENT_VALID] =
-        mce_charger_add_valid_changed_handler(self->charger,
-            binder_devmon_if_io_charger_cb, self);
-    self->charger_event_id[CHARGER_EVENT_STATE] =
-        mce_charger_add_state_changed_handler(self->charger,
-            binder_devmon_if_io_charger_cb, self);
-
-    self->display = mce_display_ref(impl->display);
-    self->display_on = binder_devmon_if_display_on(self->display);
-    self->display_event_id[DISPLAY_EVENT_VALID] =
-        mce_display_add_valid_changed_handler(self->display,
-            binder_devmon_if_io_display_cb, self);
-    self->display_event_id[DISPLAY_EVENT_STATE] =
-        mce_display_add_state_changed_handler(self->display,
-            binder_devmon_if_io_display_cb, self);
+    self->state = binder_devmon_state_ref(impl->state);
+    self->ind_filter = -1;
+    self->state_event_id =
+        binder_devmon_state_add_profile_changed_handler(self->state,
+            binder_devmon_if_io_state_cb, self);
+    self->reset_event_id = radio_client_add_indication_handler(client,
+        RADIO_IND_MODEM_RESET, binder_devmon_if_io_modem_reset, self);
 
     self->cell_info_interval_short_ms = impl->cell_info_interval_short_ms;
     self->cell_info_interval_long_ms = impl->cell_info_interval_long_ms;
+    memcpy(self->profile, impl->profile, sizeof(self->profile));
+    self->profile_id = binder_devmon_if_io_select_profile(self);
 
-    self->upower = impl->upower;
+    self->batman = binder_batman_ref(impl->batman);
+    self->batman_event_id =
+        binder_batman_add_state_changed_handler(self->batman,
+            binder_devmon_if_io_batman_cb, self);
 
+    DBG_(self, "Profile %s", binder_devmon_if_profile_name[self->profile_id]);
     binder_devmon_if_io_set_indication_filter(self);
     binder_devmon_if_io_set_cell_info_update_interval(self);
 
-    binder_devmon_if_io_init_batman_watch(self);
+    if (self->batman->valid) {
+        binder_devmon_if_io_batman_cb(self->batman,
+            BINDER_BATMAN_PROPERTY_STATE, self);
+    }
 
     return &self->pub;
 }
@@ -438,10 +329,8 @@ binder_devmon_if_free(
 {
     DevMon* self = binder_devmon_if_cast(devmon);
 
-    mce_battery_unref(self->battery);
-    mce_charger_unref(self->charger);
-    mce_display_unref(self->display);
-    g_object_unref(self->upower);
+    binder_devmon_state_unref(self->state);
+    binder_batman_unref(self->batman);
     g_free(self);
 }
 
@@ -451,18 +340,18 @@ binder_devmon_if_free(
 
 BinderDevmon*
 binder_devmon_if_new(
-    const BinderSlotConfig* config)
+    const BinderSlotConfig* config,
+    BinderDevmonState* state)
 {
     DevMon* self = g_new0(DevMon, 1);
 
     self->pub.free = binder_devmon_if_free;
     self->pub.start_io = binder_devmon_if_start_io;
-    self->battery = mce_battery_new();
-    self->charger = mce_charger_new();
-    self->display = mce_display_new();
-    self->upower = up_client_new();
+    self->state = binder_devmon_state_ref(state);
+    self->batman = binder_batman_new();
     self->cell_info_interval_short_ms = config->cell_info_interval_short_ms;
     self->cell_info_interval_long_ms = config->cell_info_interval_long_ms;
+    memcpy(self->profile, config->devmon_profile, sizeof(self->profile));
     return &self->pub;
 }
 
@@ -0,0 +1,469 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_base.h"
+#include "binder_connman.h"
+#include "binder_devmon_state.h"
+#include "binder_log.h"
+#include "binder_util.h"
+#include "binder_wakeup.h"
+
+#include <ofono/log.h>
+
+#include <mce_battery.h>
+#include <mce_charger.h>
+#include <mce_display.h>
+
+#include <gutil_macros.h>
+
+BINDER_BASE_ASSERT_COUNT(BINDER_DEVMON_STATE_PROPERTY_COUNT);
+
+enum devmon_state_battery_event {
+    BATTERY_EVENT_VALID,
+    BATTERY_EVENT_STATUS,
+    BATTERY_EVENT_COUNT
+};
+
+enum devmon_state_charger_event {
+    CHARGER_EVENT_VALID,
+    CHARGER_EVENT_STATE,
+    CHARGER_EVENT_COUNT
+};
+
+enum devmon_state_display_event {
+    DISPLAY_EVENT_VALID,
+    DISPLAY_EVENT_STATE,
+    DISPLAY_EVENT_COUNT
+};
+
+enum devmon_state_connman_event {
+    CONNMAN_EVENT_PROPERTIES,
+    CONNMAN_EVENT_COUNT
+};
+
+/* The only connman properties which affect the profile */
+#define CONNMAN_PROPERTY_MASK ( \
+    BINDER_CONNMAN_PROPERTY_BIT(BINDER_CONNMAN_PROPERTY_VALID) | \
+    BINDER_CONNMAN_PROPERTY_BIT(BINDER_CONNMAN_PROPERTY_TETHERING))
+
+typedef struct devmon_state_object DevmonStateObject;
+
+/*
+ * Hysteresis for a boolean input. The new value is only accepted after
+ * it has been stable for on_delay_ms (for FALSE -> TRUE transitions) or
+ * off_delay_ms (for TRUE -> FALSE). Changes which get reverted before
+ * that are counted as suppressed.
+ */
+typedef struct devmon_state_filter {
+    DevmonStateObject* obj;
+    const char* name;
+    gboolean value;
+    guint on_delay_ms;
+    guint off_delay_ms;
+    guint timer_id;
+    guint accepted;
+    guint suppressed;
+} DevmonStateFilter;
+
+typedef BinderBaseClass DevmonStateObjectClass;
+struct devmon_state_object {
+    BinderBase base;
+    BinderDevmonState pub;
+    BinderConnman* connman;
+    MceBattery* battery;
+    MceCharger* charger;
+    MceDisplay* display;
+    gulong connman_event_id[CONNMAN_EVENT_COUNT];
+    gulong battery_event_id[BATTERY_EVENT_COUNT];
+    gulong charger_event_id[CHARGER_EVENT_COUNT];
+    gulong display_event_id[DISPLAY_EVENT_COUNT];
+    DevmonStateFilter display_filter;
+    DevmonStateFilter charger_filter;
+    guint update_id;
+};
+
+GType devmon_state_object_get_type() BINDER_INTERNAL;
+G_DEFINE_TYPE(DevmonStateObject, devmon_state_object, BINDER_TYPE_BASE)
+#define PARENT_CLASS devmon_state_object_parent_class
+#define THIS_TYPE devmon_state_object_get_type()
+#define THIS(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, THIS_TYPE, DevmonStateObject)
+
+static inline
+DevmonStateObject*
+devmon_state_object_cast(
+    BinderDevmonState* state)
+{
+    return G_LIKELY(state) ?
+        THIS(G_CAST(state, DevmonStateObject, pub)) :
+        NULL;
+}
+
+static inline gboolean devmon_state_display_on(MceDisplay* display)
+    { return display->valid && display->state != MCE_DISPLAY_STATE_OFF; }
+
+static inline gboolean devmon_state_charging(MceCharger* charger)
+    { return charger->valid && charger->state == MCE_CHARGER_ON; }
+
+static void devmon_state_object_schedule_update(DevmonStateObject* self);
+
+static
+void
+devmon_state_filter_init(
+    DevmonStateFilter* filter,
+    DevmonStateObject* obj,
+    const char* name,
+    gboolean value,
+    int on_delay_ms,
+    int off_delay_ms)
+{
+    filter->obj = obj;
+    filter->name = name;
+    filter->value = value;
+    filter->on_delay_ms = MAX(on_delay_ms, 0);
+    filter->off_delay_ms = MAX(off_delay_ms, 0);
+}
+
+static
+void
+devmon_state_filter_deinit(
+    DevmonStateFilter* filter)
+{
+    if (filter->timer_id) {
+        g_source_remove(filter->timer_id);
+        filter->timer_id = 0;
+    }
+    DBG("%s: %u transition(s) accepted, %u suppressed", filter->name,
+        filter->accepted, filter->suppressed);
+}
+
+static
+void
+devmon_state_filter_accept(
+    DevmonStateFilter* filter,
+    gboolean value)
+{
+    filter->value = value;
+    filter->accepted++;
+    devmon_state_object_schedule_update(filter->obj);
+}
+
+static
+gboolean
+devmon_state_filter_timer_cb(
+    gpointer user_data)
+{
+    DevmonStateFilter* filter = user_data;
+
+    binder_wakeup("devmon debounce");
+    filter->timer_id = 0;
+    devmon_state_filter_accept(filter, !filter->value);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+devmon_state_filter_input(
+    DevmonStateFilter* filter,
+    gboolean value)
+{
+    if (value == filter->value) {
+        if (filter->timer_id) {
+            /* Flipped back before the new value has settled */
+            g_source_remove(filter->timer_id);
+            filter->timer_id = 0;
+            filter->suppressed++;
+            DBG("%s %s transition suppressed (%u)", filter->name,
+                value ? "off" : "on", filter->suppressed);
+        }
+    } else if (!filter->timer_id) {
+        const guint delay = value ? filter->on_delay_ms :
+            filter->off_delay_ms;
+
+        if (delay) {
+            filter->timer_id = binder_timeout_add_coarse(delay,
+                devmon_state_filter_timer_cb, filter);
+        } else {
+            devmon_state_filter_accept(filter, value);
+        }
+    }
+}
+
+static
+void
+devmon_state_object_compute(
+    DevmonStateObject* self,
+    BinderDevmonState* state)
+{
+    MceBattery* battery = self->battery;
+    BinderConnman* connman = self->connman;
+
+    state->display_on = self->display_filter.value;
+    state->charging = self->charger_filter.value;
+    state->battery_ok = battery->valid && battery->status >= MCE_BATTERY_OK;
+    state->tethering = connman && connman->valid && connman->tethering;
+}
+
+static
+void
+devmon_state_object_update(
+    DevmonStateObject* self)
+{
+    BinderDevmonState* pub = &self->pub;
+    BinderDevmonState state;
+
+    devmon_state_object_compute(self, &state);
+    if (pub->display_on != state.display_on ||
+        pub->charging != state.charging ||
+        pub->battery_ok != state.battery_ok ||
+        pub->tethering != state.tethering) {
+        DBG("display %s, charging %s, battery %s, tethering %s",
+            state.display_on ? "on" : "off", state.charging ? "on" : "off",
+            state.battery_ok ? "ok" : "low", state.tethering ? "on" : "off");
+        *pub = state;
+        binder_base_emit_property_change(&self->base,
+            BINDER_DEVMON_STATE_PROPERTY_PROFILE);
+    }
+}
+
+static
+gboolean
+devmon_state_object_update_cb(
+    gpointer user_data)
+{
+    DevmonStateObject* self = THIS(user_data);
+
+    self->update_id = 0;
+    devmon_state_object_update(self);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+devmon_state_object_schedule_update(
+    DevmonStateObject* self)
+{
+    /* Coalesce everything that arrives within the same main loop pass */
+    if (!self->update_id) {
+        self->update_id = g_idle_add(devmon_state_object_update_cb, self);
+    }
+}
+
+static
+void
+devmon_state_object_connman_cb(
+    BinderConnman* connman,
+    guint mask,
+    void* user_data)
+{
+    binder_wakeup("connman");
+
+    /* Ignore e.g. WiFi connection changes */
+    if (mask & CONNMAN_PROPERTY_MASK) {
+        devmon_state_object_schedule_update(THIS(user_data));
+    }
+}
+
+static
+void
+devmon_state_object_battery_cb(
+    MceBattery* battery,
+    void* user_data)
+{
+    binder_wakeup("mce battery");
+    devmon_state_object_schedule_update(THIS(user_data));
+}
+
+static
+void
+devmon_state_object_charger_cb(
+    MceCharger* charger,
+    void* user_data)
+{
+    DevmonStateObject* self = THIS(user_data);
+
+    binder_wakeup("mce charger");
+    devmon_state_filter_input(&self->charger_filter,
+        devmon_state_charging(charger));
+}
+
+static
+void
+devmon_state_object_display_cb(
+    MceDisplay* display,
+    void* user_data)
+{
+    DevmonStateObject* self = THIS(user_data);
+
+    binder_wakeup("mce display");
+    devmon_state_filter_input(&self->display_filter,
+        devmon_state_display_on(display));
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderDevmonState*
+binder_devmon_state_new(
+    const BinderSlotConfig* config)
+{
+    DevmonStateObject* self = g_object_new(THIS_TYPE, NULL);
+
+    self->connman = binder_connman_new();
+    self->connman_event_id[CONNMAN_EVENT_PROPERTIES] =
+        binder_connman_add_properties_changed_handler(self->connman,
+            devmon_state_object_connman_cb, self);
+
+    self->battery = mce_battery_new();
+    self->battery_event_id[BATTERY_EVENT_VALID] =
+        mce_battery_add_valid_changed_handler(self->battery,
+            devmon_state_object_battery_cb, self);
+    self->battery_event_id[BATTERY_EVENT_STATUS] =
+        mce_battery_add_status_changed_handler(self->battery,
+            devmon_state_object_battery_cb, self);
+
+    self->charger = mce_charger_new();
+    self->charger_event_id[CHARGER_EVENT_VALID] =
+        mce_charger_add_valid_changed_handler(self->charger,
+            devmon_state_object_charger_cb, self);
+    self->charger_event_id[CHARGER_EVENT_STATE] =
+        mce_charger_add_state_changed_handler(self->charger,
+            devmon_state_object_charger_cb, self);
+
+    self->display = mce_display_new();
+    self->display_event_id[DISPLAY_EVENT_VALID] =
+        mce_display_add_valid_changed_handler(self->display,
+            devmon_state_object_display_cb, self);
+    self->display_event_id[DISPLAY_EVENT_STATE] =
+        mce_display_add_state_changed_handler(self->display,
+            devmon_state_object_display_cb, self);
+
+    /* The initial state is accepted without delay */
+    devmon_state_filter_init(&self->display_filter, self, "display",
+        devmon_state_display_on(self->display),
+        config->display_on_delay_ms, config->display_off_delay_ms);
+    devmon_state_filter_init(&self->charger_filter, self, "charger",
+        devmon_state_charging(self->charger),
+        config->charger_delay_ms, config->charger_delay_ms);
+    devmon_state_object_compute(self, &self->pub);
+    return &self->pub;
+}
+
+BinderDevmonState*
+binder_devmon_state_ref(
+    BinderDevmonState* state)
+{
+    DevmonStateObject* self = devmon_state_object_cast(state);
+
+    if (G_LIKELY(self)) {
+        g_object_ref(self);
+    }
+    return state;
+}
+
+void
+binder_devmon_state_unref(
+    BinderDevmonState* state)
+{
+    DevmonStateObject* self = devmon_state_object_cast(state);
+
+    if (G_LIKELY(self)) {
+        g_object_unref(self);
+    }
+}
+
+gulong
+binder_devmon_state_add_profile_changed_handler(
+    BinderDevmonState* state,
+    BinderDevmonStateFunc callback,
+    void* user_data)
+{
+    DevmonStateObject* self = devmon_state_object_cast(state);
+
+    return G_LIKELY(self) ? binder_base_add_property_handler(&self->base,
+        BINDER_DEVMON_STATE_PROPERTY_PROFILE, G_CALLBACK(callback),
+        user_data) : 0;
+}
+
+void
+binder_devmon_state_remove_handler(
+    BinderDevmonState* state,
+    gulong id)
+{
+    if (G_LIKELY(id)) {
+        DevmonStateObject* self = devmon_state_object_cast(state);
+
+        if (G_LIKELY(self)) {
+            g_signal_handler_disconnect(self, id);
+        }
+    }
+}
+
+/*==========================================================================*
+ * Internals
+ *==========================================================================*/
+
+static
+void
+devmon_state_object_init(
+    DevmonStateObject* self)
+{
+}
+
+static
+void
+devmon_state_object_finalize(
+    GObject* object)
+{
+    DevmonStateObject* self = THIS(object);
+
+    if (self->update_id) {
+        g_source_remove(self->update_id);
+    }
+    devmon_state_filter_deinit(&self->display_filter);
+    devmon_state_filter_deinit(&self->charger_filter);
+
+    binder_connman_remove_all_handlers(self->connman, self->connman_event_id);
+    binder_connman_unref(self->connman);
+
+    mce_battery_remove_all_handlers(self->battery, self->battery_event_id);
+    mce_battery_unref(self->battery);
+
+    mce_charger_remove_all_handlers(self->charger, self->charger_event_id);
+    mce_charger_unref(self->charger);
+
+    mce_display_remove_all_handlers(self->display, self->display_event_id);
+    mce_display_unref(self->display);
+
+    G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
+}
+
+static
+void
+devmon_state_object_class_init(
+    DevmonStateObjectClass* klass)
+{
+    G_OBJECT_CLASS(klass)->finalize = devmon_state_object_finalize;
+    BINDER_BASE_CLASS(klass)->public_offset =
+        G_STRUCT_OFFSET(DevmonStateObject, pub);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
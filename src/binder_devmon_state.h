@@ -0,0 +1,87 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_DEVMON_STATE_H
+#define BINDER_DEVMON_STATE_H
+
+#include "binder_types.h"
+
+/*
+ * Device state shared by all device monitors of the slot. Display,
+ * battery, charger and tethering events are collected into a single
+ * profile which is re-evaluated once per burst of events. Display
+ * and charger changes are additionally debounced, i.e. only taken
+ * into account after they have been stable for the configured time.
+ * Handlers are only invoked if the resulting profile has actually
+ * changed.
+ */
+
+typedef struct binder_devmon_state {
+    gboolean display_on;
+    gboolean charging;
+    gboolean battery_ok;
+    gboolean tethering;
+} BinderDevmonState;
+
+typedef enum binder_devmon_state_property {
+    BINDER_DEVMON_STATE_PROPERTY_ANY,
+    BINDER_DEVMON_STATE_PROPERTY_PROFILE,
+    BINDER_DEVMON_STATE_PROPERTY_COUNT
+} BINDER_DEVMON_STATE_PROPERTY;
+
+typedef
+void
+(*BinderDevmonStateFunc)(
+    BinderDevmonState* state,
+    BINDER_DEVMON_STATE_PROPERTY property,
+    void* user_data);
+
+BinderDevmonState*
+binder_devmon_state_new(
+    const BinderSlotConfig* config)
+    BINDER_INTERNAL;
+
+BinderDevmonState*
+binder_devmon_state_ref(
+    BinderDevmonState* state)
+    BINDER_INTERNAL;
+
+void
+binder_devmon_state_unref(
+    BinderDevmonState* state)
+    BINDER_INTERNAL;
+
+gulong
+binder_devmon_state_add_profile_changed_handler(
+    BinderDevmonState* state,
+    BinderDevmonStateFunc fn,
+    void* user_data)
+    BINDER_INTERNAL;
+
+void
+binder_devmon_state_remove_handler(
+    BinderDevmonState* state,
+    gulong id)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_DEVMON_STATE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -27,12 +27,6 @@
 #include <ofono/netreg.h>
 #include <ofono/watch.h>
 
-enum binder_gprs_network_events {
-    NETWORK_EVENT_DATA_STATE,
-    NETWORK_EVENT_MAX_DATA_CALLS,
-    NETWORK_EVENT_COUNT
-};
-
 typedef struct binder_gprs {
     struct ofono_gprs* gprs;
     struct ofono_watch* watch;
@@ -40,7 +34,7 @@ typedef struct binder_gprs {
     BinderNetwork* network;
     enum ofono_netreg_status reg_status;
     gboolean attached;
-    gulong network_event_id[NETWORK_EVENT_COUNT];
+    gulong network_event_id;
     gulong data_event_id;
     guint set_attached_id;
     guint init_id;
@@ -191,27 +185,25 @@ binder_gprs_allow_data_changed(
 
 static
 void
-binder_gprs_max_data_calls_changed(
+binder_gprs_network_changed(
     BinderNetwork* net,
-    BINDER_NETWORK_PROPERTY property,
+    guint mask,
     void* user_data)
 {
     BinderGprs* self = user_data;
+    const guint max_data_calls_bit =
+        BINDER_NETWORK_PROPERTY_BIT(BINDER_NETWORK_PROPERTY_MAX_DATA_CALLS);
+    const guint data_state_bit =
+        BINDER_NETWORK_PROPERTY_BIT(BINDER_NETWORK_PROPERTY_DATA_STATE);
 
-    if (net->max_data_calls > 0) {
+    /* Data state and max data calls often change together */
+    if ((mask & max_data_calls_bit) && net->max_data_calls > 0) {
         DBG_(self, "setting max cids to %d", net->max_data_calls);
         ofono_gprs_set_cid_range(self->gprs, 1, net->max_data_calls);
     }
-}
-
-static
-void
-binder_gprs_data_registration_state_changed(
-    BinderNetwork* net,
-    BINDER_NETWORK_PROPERTY property,
-    void* user_data)
-{
-    binder_gprs_data_update_registration_state((BinderGprs*)user_data);
+    if (mask & data_state_bit) {
+        binder_gprs_data_update_registration_state(self);
+    }
 }
 
 static
@@ -240,14 +232,8 @@ binder_gprs_register(
     struct ofono_gprs* gprs = self->gprs;
 
     self->init_id = 0;
-    self->network_event_id[NETWORK_EVENT_DATA_STATE] =
-        binder_network_add_property_handler(network,
-            BINDER_NETWORK_PROPERTY_DATA_STATE,
-            binder_gprs_data_registration_state_changed, self);
-    self->network_event_id[NETWORK_EVENT_MAX_DATA_CALLS] =
-        binder_network_add_property_handler(network,
-            BINDER_NETWORK_PROPERTY_MAX_DATA_CALLS,
-            binder_gprs_max_data_calls_changed, self);
+    self->network_event_id = binder_network_add_properties_handler(network,
+        binder_gprs_network_changed, self);
     self->data_event_id =
         binder_data_add_property_handler(self->data,
             BINDER_DATA_PROPERTY_ALLOWED,
@@ -304,7 +290,7 @@ binder_gprs_remove(
         g_source_remove(self->init_id);
     }
 
-    binder_network_remove_all_handlers(self->network, self->network_event_id);
+    binder_network_remove_handler(self->network, self->network_event_id);
     binder_network_unref(self->network);
 
     binder_data_remove_handler(self->data, self->data_event_id);
@@ -41,6 +41,25 @@ typedef struct binder_gprs_context_call {
     unsigned int cid;
 } BinderGprsContextCall;
 
+typedef struct binder_gprs_context_addr {
+    int family; /* AF_UNSPEC if there's no address */
+    union {
+        struct in_addr v4;
+        struct in6_addr v6;
+    } ip;
+    guint prefix;
+} BinderGprsContextAddr;
+
+/* What has been passed to ofono, to avoid repeating the same thing */
+typedef struct binder_gprs_context_settings {
+    BinderGprsContextAddr ipv4;
+    BinderGprsContextAddr ipv6;
+    BinderGprsContextAddr gw4;
+    BinderGprsContextAddr gw6;
+    char** dns[2];      /* IPv4, IPv6 */
+    char** pcscf[2];    /* IPv4, IPv6 */
+} BinderGprsContextSettings;
+
 typedef struct binder_gprs_context {
     struct ofono_gprs_context* gc;
     struct ofono_watch* watch;
@@ -51,6 +70,7 @@ typedef struct binder_gprs_context {
     guint active_ctx_cid;
     gulong calls_changed_id;
     BinderDataCall* active_call;
+    BinderGprsContextSettings settings;
     BinderGprsContextCall activate;
     BinderGprsContextCall deactivate;
 } BinderGprsContext;
@@ -61,26 +81,7 @@ static inline BinderGprsContext*
 binder_gprs_context_get_data(struct ofono_gprs_context *gprs)
     {  return ofono_gprs_context_get_data(gprs); }
 
-static
-char*
-binder_gprs_context_netmask(
-    const char* bits)
-{
-    guint nbits;
-
-    if (gutil_parse_uint(bits, 0, &nbits) && nbits < 33) {
-        const char* str;
-        struct in_addr in;
-
-        in.s_addr = htonl((nbits == 32) ? 0xffffffff :
-            ((1u << nbits)-1) << (32-nbits));
-        str = inet_ntoa(in);
-        if (str) {
-            return g_strdup(str);
-        }
-    }
-    return NULL;
-}
+static void binder_gprs_context_reset_settings(BinderGprsContext* self);
 
 static
 int
@@ -114,6 +115,7 @@ binder_gprs_context_free_active_call(
         ofono_mtu_limit_free(self->mtu_limit);
         self->mtu_limit = NULL;
     }
+    binder_gprs_context_reset_settings(self);
 }
 
 static
@@ -172,105 +174,221 @@ binder_gprs_context_set_disconnected(
     }
 }
 
+static
+gboolean
+binder_gprs_context_parse_addr(
+    const char* str,
+    int af,
+    BinderGprsContextAddr* addr)
+{
+    const char* slash = strchr(str, '/');
+    const guint max_prefix = (af == AF_INET) ? 32 : 128;
+    char buf[INET6_ADDRSTRLEN];
+
+    if (slash) {
+        const gsize len = slash - str;
+
+        if (len >= sizeof(buf)) {
+            return FALSE;
+        }
+        memcpy(buf, str, len);
+        buf[len] = 0;
+        str = buf;
+    }
+
+    memset(addr, 0, sizeof(*addr));
+    if (inet_pton(af, str, &addr->ip) > 0) {
+        guint prefix;
+
+        addr->family = af;
+        if (slash && gutil_parse_uint(slash + 1, 0, &prefix) &&
+            prefix <= max_prefix) {
+            addr->prefix = prefix;
+        } else if (af == AF_INET) {
+            /* Same default as we always had */
+            addr->prefix = 24;
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
 static
 void
-binder_gprs_context_set_address(
-    struct ofono_gprs_context *gc,
-    const BinderDataCall* call)
+binder_gprs_context_parse_first(
+    char* const* list,
+    BinderGprsContextAddr* ipv4,
+    BinderGprsContextAddr* ipv6)
 {
-    const char* ip_addr = NULL;
-    char* ip_mask = NULL;
-    const char* ipv6_addr = NULL;
-    unsigned char ipv6_prefix_length = 0;
-    char* tmp_ip_addr = NULL;
-    char* tmp_ipv6_addr = NULL;
-    char* const* list = call->addresses;
-    const int n = gutil_strv_length(list);
-    int i;
-
-    for (i = 0; i < n && (!ipv6_addr || !ip_addr); i++) {
-        const char* addr = list[i];
-
-        switch (binder_gprs_context_address_family(addr)) {
-        case AF_INET:
-            if (!ip_addr) {
-                const char* s = strchr(addr, '/');
-
-                if (s) {
-                    const gsize len = s - addr;
-                    tmp_ip_addr = g_strndup(addr, len);
-                    ip_addr = tmp_ip_addr;
-                    ip_mask = binder_gprs_context_netmask(s+1);
-                } else {
-                    ip_addr = addr;
-                }
-                if (!ip_mask) {
-                    ip_mask = g_strdup("255.255.255.0");
-                }
+    memset(ipv4, 0, sizeof(*ipv4));
+    memset(ipv6, 0, sizeof(*ipv6));
+    if (list) {
+        char* const* ptr;
+
+        /* Pick the first valid address for each protocol */
+        for (ptr = list; *ptr && (!ipv4->family || !ipv6->family); ptr++) {
+            BinderGprsContextAddr* addr;
+            int af = binder_gprs_context_address_family(*ptr);
+
+            switch (af) {
+            case AF_INET:
+                addr = ipv4;
+                break;
+            case AF_INET6:
+                addr = ipv6;
+                break;
+            default:
+                continue;
             }
-            break;
-        case AF_INET6:
-            if (!ipv6_addr) {
-                const char* s = strchr(addr, '/');
-
-                if (s) {
-                    const gsize len = s - addr;
-                    const int prefix = atoi(s + 1);
-
-                    tmp_ipv6_addr = g_strndup(addr, len);
-                    ipv6_addr = tmp_ipv6_addr;
-                    if (prefix >= 0 && prefix <= 128) {
-                        ipv6_prefix_length = prefix;
-                    }
-                } else {
-                    ipv6_addr = addr;
-                }
+            if (!addr->family) {
+                binder_gprs_context_parse_addr(*ptr, af, addr);
             }
         }
     }
+}
 
-    ofono_gprs_context_set_ipv4_address(gc, ip_addr, TRUE);
-    ofono_gprs_context_set_ipv4_netmask(gc, ip_mask);
-    ofono_gprs_context_set_ipv6_address(gc, ipv6_addr);
-    ofono_gprs_context_set_ipv6_prefix_length(gc, ipv6_prefix_length);
+static
+const char*
+binder_gprs_context_addr_str(
+    const BinderGprsContextAddr* addr,
+    char* buf)
+{
+    return addr->family ? inet_ntop(addr->family, &addr->ip, buf,
+        INET6_ADDRSTRLEN) : NULL;
+}
 
-    if (!ip_addr && !ipv6_addr) {
-        ofono_error("GPRS context: No IP address");
+static
+gboolean
+binder_gprs_context_addr_update(
+    BinderGprsContextAddr* cached,
+    const BinderGprsContextAddr* addr,
+    gboolean force)
+{
+    if (force || memcmp(cached, addr, sizeof(*addr))) {
+        *cached = *addr;
+        return TRUE;
     }
+    return FALSE;
+}
 
-    /* Allocate temporary strings */
-    g_free(ip_mask);
-    g_free(tmp_ip_addr);
-    g_free(tmp_ipv6_addr);
+static
+gboolean
+binder_gprs_context_strv_update(
+    char*** cached,
+    char** list,
+    gboolean force)
+{
+    if (force || !gutil_strv_equal(*cached, list)) {
+        g_strfreev(*cached);
+        *cached = list;
+        return TRUE;
+    }
+    g_strfreev(list);
+    return FALSE;
 }
 
 static
 void
-binder_gprs_context_set_gateway(
-    struct ofono_gprs_context *gc,
-    const BinderDataCall* call)
+binder_gprs_context_reset_settings(
+    BinderGprsContext* self)
 {
-    const char* ip_gw = NULL;
-    const char* ipv6_gw = NULL;
-    char* const* list = call->gateways;
-    const int n = gutil_strv_length(list);
-    int i;
-
-    /* Pick 1 gw for each protocol*/
-    for (i = 0; i < n && (!ipv6_gw || !ip_gw); i++) {
-        const char* addr = list[i];
-        switch (binder_gprs_context_address_family(addr)) {
-        case AF_INET:
-            if (!ip_gw) ip_gw = addr;
-            break;
-        case AF_INET6:
-            if (!ipv6_gw) ipv6_gw = addr;
-            break;
+    BinderGprsContextSettings* settings = &self->settings;
+
+    g_strfreev(settings->dns[0]);
+    g_strfreev(settings->dns[1]);
+    g_strfreev(settings->pcscf[0]);
+    g_strfreev(settings->pcscf[1]);
+    memset(settings, 0, sizeof(*settings));
+}
+
+static
+gboolean
+binder_gprs_context_set_address(
+    BinderGprsContext* self,
+    const BinderDataCall* call,
+    gboolean force)
+{
+    struct ofono_gprs_context* gc = self->gc;
+    BinderGprsContextSettings* settings = &self->settings;
+    BinderGprsContextAddr ipv4, ipv6;
+    char buf[INET6_ADDRSTRLEN];
+    gboolean changed = FALSE;
+
+    binder_gprs_context_parse_first(call->addresses, &ipv4, &ipv6);
+    if (!ipv4.family && !ipv6.family) {
+        ofono_error("GPRS context: No IP address");
+    }
+
+    if (binder_gprs_context_addr_update(&settings->ipv4, &ipv4, force)) {
+        DBG_(self, "IPv4 address changed");
+        ofono_gprs_context_set_ipv4_address(gc,
+            binder_gprs_context_addr_str(&ipv4, buf), TRUE);
+        if (ipv4.family) {
+            struct in_addr mask;
+
+            mask.s_addr = htonl(ipv4.prefix ?
+                (0xffffffff << (32 - ipv4.prefix)) : 0);
+            ofono_gprs_context_set_ipv4_netmask(gc, inet_ntop(AF_INET,
+                &mask, buf, sizeof(buf)));
+        } else {
+            ofono_gprs_context_set_ipv4_netmask(gc, NULL);
         }
+        changed = TRUE;
     }
 
-    ofono_gprs_context_set_ipv4_gateway(gc, ip_gw);
-    ofono_gprs_context_set_ipv6_gateway(gc, ipv6_gw);
+    if (binder_gprs_context_addr_update(&settings->ipv6, &ipv6, force)) {
+        DBG_(self, "IPv6 address changed");
+        ofono_gprs_context_set_ipv6_address(gc,
+            binder_gprs_context_addr_str(&ipv6, buf));
+        ofono_gprs_context_set_ipv6_prefix_length(gc, ipv6.prefix);
+        changed = TRUE;
+    }
+    return changed;
+}
+
+static
+gboolean
+binder_gprs_context_set_gateway(
+    BinderGprsContext* self,
+    const BinderDataCall* call,
+    gboolean force)
+{
+    struct ofono_gprs_context* gc = self->gc;
+    BinderGprsContextSettings* settings = &self->settings;
+    BinderGprsContextAddr ipv4, ipv6;
+    char buf[INET6_ADDRSTRLEN];
+    gboolean changed = FALSE;
+
+    binder_gprs_context_parse_first(call->gateways, &ipv4, &ipv6);
+
+    /* Gateways don't have prefixes */
+    ipv4.prefix = ipv6.prefix = 0;
+    if (binder_gprs_context_addr_update(&settings->gw4, &ipv4, force)) {
+        ofono_gprs_context_set_ipv4_gateway(gc,
+            binder_gprs_context_addr_str(&ipv4, buf));
+        changed = TRUE;
+    }
+    if (binder_gprs_context_addr_update(&settings->gw6, &ipv6, force)) {
+        ofono_gprs_context_set_ipv6_gateway(gc,
+            binder_gprs_context_addr_str(&ipv6, buf));
+        changed = TRUE;
+    }
+    return changed;
+}
+
+static
+char**
+binder_gprs_context_strv_from_array(
+    GPtrArray* array)
+{
+    /* Empty lists are passed to ofono as NULL */
+    if (array->len) {
+        g_ptr_array_add(array, NULL);
+        return (char**)g_ptr_array_free(array, FALSE);
+    } else {
+        g_ptr_array_free(array, TRUE);
+        return NULL;
+    }
 }
 
 typedef
@@ -280,66 +398,75 @@ void
     const char** list);
 
 static
-void
+gboolean
 binder_gprs_context_set_servers(
-    struct ofono_gprs_context* gc,
+    BinderGprsContext* self,
     char* const* list,
+    char** cached[2],
     ofono_gprs_context_list_setter_t set_ipv4,
-    ofono_gprs_context_list_setter_t set_ipv6)
+    ofono_gprs_context_list_setter_t set_ipv6,
+    gboolean force)
 {
-    int i;
-    const char** ip_list = NULL, ** ip_ptr = NULL;
-    const char** ipv6_list = NULL, ** ipv6_ptr = NULL;
-    const int n = gutil_strv_length(list);
-
-    for (i = 0; i < n; i++) {
-        const char *addr = list[i];
-
-        switch (binder_gprs_context_address_family(addr)) {
-        case AF_INET:
-            if (!ip_ptr) {
-                ip_list = g_new0(const char *, n - i + 1);
-                ip_ptr = ip_list;
-            }
-            *ip_ptr++ = addr;
-            break;
-        case AF_INET6:
-            if (!ipv6_ptr) {
-                ipv6_list = g_new0(const char *, n - i + 1);
-                ipv6_ptr = ipv6_list;
+    GPtrArray* ip_list = g_ptr_array_new();
+    GPtrArray* ipv6_list = g_ptr_array_new();
+    char** ip_strv;
+    char** ipv6_strv;
+    gboolean changed = FALSE;
+
+    if (list) {
+        char* const* ptr;
+
+        for (ptr = list; *ptr; ptr++) {
+            const char *addr = *ptr;
+
+            switch (binder_gprs_context_address_family(addr)) {
+            case AF_INET:
+                g_ptr_array_add(ip_list, g_strdup(addr));
+                break;
+            case AF_INET6:
+                g_ptr_array_add(ipv6_list, g_strdup(addr));
+                break;
             }
-            *ipv6_ptr++ = addr;
-            break;
         }
     }
 
-    set_ipv4(gc, ip_list);
-    set_ipv6(gc, ipv6_list);
-
-    g_free(ip_list);
-    g_free(ipv6_list);
+    ip_strv = binder_gprs_context_strv_from_array(ip_list);
+    ipv6_strv = binder_gprs_context_strv_from_array(ipv6_list);
+    if (binder_gprs_context_strv_update(cached + 0, ip_strv, force)) {
+        set_ipv4(self->gc, (const char**)cached[0]);
+        changed = TRUE;
+    }
+    if (binder_gprs_context_strv_update(cached + 1, ipv6_strv, force)) {
+        set_ipv6(self->gc, (const char**)cached[1]);
+        changed = TRUE;
+    }
+    return changed;
 }
 
 static
-void
+gboolean
 binder_gprs_context_set_dns_servers(
-    struct ofono_gprs_context* gc,
-    const BinderDataCall* call)
+    BinderGprsContext* self,
+    const BinderDataCall* call,
+    gboolean force)
 {
-    binder_gprs_context_set_servers(gc, call->dnses,
+    return binder_gprs_context_set_servers(self, call->dnses,
+        self->settings.dns,
         ofono_gprs_context_set_ipv4_dns_servers,
-        ofono_gprs_context_set_ipv6_dns_servers);
+        ofono_gprs_context_set_ipv6_dns_servers, force);
 }
 
 static
-void
+gboolean
 binder_gprs_context_set_proxy_cscf(
-    struct ofono_gprs_context* gc,
-    const BinderDataCall* call)
+    BinderGprsContext* self,
+    const BinderDataCall* call,
+    gboolean force)
 {
-    binder_gprs_context_set_servers(gc, call->pcscf,
+    return binder_gprs_context_set_servers(self, call->pcscf,
+        self->settings.pcscf,
         ofono_gprs_context_set_ipv4_proxy_cscf,
-        ofono_gprs_context_set_ipv6_proxy_cscf);
+        ofono_gprs_context_set_ipv6_proxy_cscf, force);
 }
 
 /* Only compares the stuff that's important to us */
@@ -390,9 +517,10 @@ binder_gprs_context_data_call_change(
 
 static
 void
-binder_gprs_context_call_list_changed(
+binder_gprs_context_call_event(
     BinderData* data,
-    BINDER_DATA_PROPERTY property,
+    BINDER_DATA_CALL_EVENT event,
+    const BinderDataCall* call,
     void* arg)
 {
     BinderGprsContext* self = arg;
@@ -401,26 +529,24 @@ binder_gprs_context_call_list_changed(
     /*
      * self->active_call can't be NULL here because this callback
      * is only registered when we have the active call and released
-     * when active call is dropped.
+     * when active call is dropped. We only get events for our cid.
      */
     BinderDataCall* prev_call = self->active_call;
-    const BinderDataCall* call = binder_data_call_find(data->calls,
-        prev_call->cid);
+    gboolean pushed = FALSE;
     int change = 0;
 
-    if (call && call->active != RADIO_DATA_CALL_INACTIVE) {
+    GASSERT(call->cid == prev_call->cid);
+    if (event != BINDER_DATA_CALL_REMOVED &&
+        call->active != RADIO_DATA_CALL_INACTIVE) {
         /* Compare it against the last known state */
         change = binder_gprs_context_data_call_change(call, prev_call);
     } else {
         ofono_error("Clearing active context");
         binder_gprs_context_set_disconnected(self);
-        call = NULL;
+        return;
     }
 
-    if (!call) {
-        /* We are not interested */
-        return;
-    } else if (!change) {
+    if (!change) {
         DBG_(self, "call %u didn't change", call->cid);
         return;
     } else {
@@ -442,29 +568,39 @@ binder_gprs_context_call_list_changed(
     if (change & DATA_CALL_IFNAME_CHANGED) {
         DBG_(self, "interface changed");
         ofono_gprs_context_set_interface(gc, call->ifname);
+        pushed = TRUE;
     }
 
-    if (change & DATA_CALL_ADDRESS_CHANGED) {
+    /* Only the settings which have actually changed get pushed to ofono */
+    if ((change & DATA_CALL_ADDRESS_CHANGED) &&
+        binder_gprs_context_set_address(self, call, FALSE)) {
         DBG_(self, "address changed");
-        binder_gprs_context_set_address(gc, call);
+        pushed = TRUE;
     }
 
-    if (change & DATA_CALL_GATEWAY_CHANGED) {
+    if ((change & DATA_CALL_GATEWAY_CHANGED) &&
+        binder_gprs_context_set_gateway(self, call, FALSE)) {
         DBG_(self, "gateway changed");
-        binder_gprs_context_set_gateway(gc, call);
+        pushed = TRUE;
     }
 
-    if (change & DATA_CALL_DNS_CHANGED) {
+    if ((change & DATA_CALL_DNS_CHANGED) &&
+        binder_gprs_context_set_dns_servers(self, call, FALSE)) {
         DBG_(self, "name server(s) changed");
-        binder_gprs_context_set_dns_servers(gc, call);
+        pushed = TRUE;
     }
 
-    if (change & DATA_CALL_PCSCF_CHANGED) {
+    if ((change & DATA_CALL_PCSCF_CHANGED) &&
+        binder_gprs_context_set_proxy_cscf(self, call, FALSE)) {
         DBG_(self, "P-CSCF changed");
-        binder_gprs_context_set_proxy_cscf(gc, call);
+        pushed = TRUE;
     }
 
-    ofono_gprs_context_signal_change(gc, self->active_ctx_cid);
+    if (pushed) {
+        ofono_gprs_context_signal_change(gc, self->active_ctx_cid);
+    } else {
+        DBG_(self, "no effective changes");
+    }
     binder_data_call_free(prev_call);
 }
 
@@ -500,17 +636,17 @@ binder_gprs_context_activate_primary_cb(
 
         GASSERT(!self->calls_changed_id);
         binder_data_remove_handler(self->data, self->calls_changed_id);
-        self->calls_changed_id = binder_data_add_property_handler(self->data,
-            BINDER_DATA_PROPERTY_CALLS, binder_gprs_context_call_list_changed,
-            self);
+        self->calls_changed_id = binder_data_add_call_handler(self->data,
+            call->cid, binder_gprs_context_call_event, self);
 
         self->active_ctx_cid = self->activate.cid;
         binder_gprs_context_set_active_call(self, call);
         ofono_gprs_context_set_interface(gc, call->ifname);
-        binder_gprs_context_set_address(gc, call);
-        binder_gprs_context_set_gateway(gc, call);
-        binder_gprs_context_set_dns_servers(gc, call);
-        binder_gprs_context_set_proxy_cscf(gc, call);
+        binder_gprs_context_reset_settings(self);
+        binder_gprs_context_set_address(self, call, TRUE);
+        binder_gprs_context_set_gateway(self, call, TRUE);
+        binder_gprs_context_set_dns_servers(self, call, TRUE);
+        binder_gprs_context_set_proxy_cscf(self, call, TRUE);
         binder_error_init_ok(&error);
     }
 
@@ -692,6 +828,7 @@ binder_gprs_context_remove(
     binder_data_unref(self->data);
     binder_network_unref(self->network);
     binder_data_call_free(self->active_call);
+    binder_gprs_context_reset_settings(self);
     ofono_mtu_limit_free(self->mtu_limit);
     ofono_watch_unref(self->watch);
 
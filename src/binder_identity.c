@@ -0,0 +1,88 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_identity.h"
+#include "binder_log.h"
+
+#include <ofono/log.h>
+#include <ofono/storage.h>
+
+#define BINDER_IDENTITY_FILE "binder-identity"
+
+static
+char*
+binder_identity_path()
+{
+    return g_build_filename(ofono_storage_dir(), BINDER_IDENTITY_FILE, NULL);
+}
+
+char*
+binder_identity_get(
+    const char* path,
+    const char* key)
+{
+    char* value = NULL;
+
+    if (path && key) {
+        GKeyFile* keyfile = g_key_file_new();
+        char* file = binder_identity_path();
+
+        if (g_key_file_load_from_file(keyfile, file, 0, NULL)) {
+            value = g_key_file_get_string(keyfile, path, key, NULL);
+        }
+        g_key_file_unref(keyfile);
+        g_free(file);
+    }
+    return value;
+}
+
+void
+binder_identity_set(
+    const char* path,
+    const char* key,
+    const char* value)
+{
+    if (path && key && value) {
+        GKeyFile* keyfile = g_key_file_new();
+        char* file = binder_identity_path();
+        char* prev;
+
+        g_key_file_load_from_file(keyfile, file, 0, NULL);
+        prev = g_key_file_get_string(keyfile, path, key, NULL);
+
+        /* Don't touch the file unless something has changed */
+        if (g_strcmp0(prev, value)) {
+            GError* error = NULL;
+
+            DBG("%s %s %s", path, key, value);
+            g_key_file_set_string(keyfile, path, key, value);
+            if (!g_key_file_save_to_file(keyfile, file, &error)) {
+                ofono_warn("Failed to save %s: %s", file, error->message);
+                g_error_free(error);
+            }
+        }
+        g_key_file_unref(keyfile);
+        g_free(prev);
+        g_free(file);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,55 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_IDENTITY_H
+#define BINDER_IDENTITY_H
+
+#include "binder_types.h"
+
+/*
+ * Device identity (IMEI, IMEISV, baseband version and the detected
+ * radio interface version) remembered across restarts, one group per
+ * slot path. Stored values are only a hint which allows to proceed
+ * without waiting for the modem (or hwservicemanager), they still get
+ * validated by the corresponding query.
+ */
+
+#define BINDER_IDENTITY_IMEI      "IMEI"
+#define BINDER_IDENTITY_IMEISV    "IMEISV"
+#define BINDER_IDENTITY_BASEBAND  "Baseband"
+#define BINDER_IDENTITY_RADIO_INTERFACE "RadioInterface"
+
+char*
+binder_identity_get(
+    const char* path,
+    const char* key) /* Caller frees the result with g_free */
+    BINDER_INTERNAL;
+
+void
+binder_identity_set(
+    const char* path,
+    const char* key,
+    const char* value)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_IDENTITY_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -16,6 +16,7 @@
 #include "binder_base.h"
 #include "binder_ims_reg.h"
 #include "binder_log.h"
+#include "binder_metrics.h"
 #include "binder_util.h"
 
 #include "binder_ext_ims.h"
@@ -44,6 +45,13 @@ typedef struct binder_ims_reg_object {
     BinderImsReg pub;
     BinderExtIms* ext;
     RadioRequestGroup* g;
+    RadioRequest* query_req;
+    gboolean query_again;
+    guint debounce_ms;
+    guint debounce_id;
+    guint stat_indications;
+    guint stat_queries;
+    guint stat_avoided;
     char* log_prefix;
     gulong ext_event_id[EVENT_EXT_COUNT];
     gulong event_id[EVENT_COUNT];
@@ -61,6 +69,24 @@ G_DEFINE_TYPE(BinderImsRegObject, binder_ims_reg_object, BINDER_TYPE_BASE)
 /* Assumptions */
 BINDER_BASE_ASSERT_COUNT(BINDER_IMS_REG_PROPERTY_COUNT);
 
+static const BinderMetricFamily binder_ims_reg_metric_inds = {
+    "binder_ims_reg_indications", BINDER_METRIC_COUNTER,
+    "IMS network state change indications"
+};
+static const BinderMetricFamily binder_ims_reg_metric_queries = {
+    "binder_ims_reg_queries", BINDER_METRIC_COUNTER,
+    "IMS registration state queries"
+};
+static const BinderMetricFamily binder_ims_reg_metric_avoided = {
+    "binder_ims_reg_queries_avoided", BINDER_METRIC_COUNTER,
+    "IMS registration state queries avoided by coalescing indications"
+};
+
+static
+void
+binder_ims_reg_query(
+    BinderImsRegObject* self);
+
 static inline BinderImsRegObject* binder_ims_reg_cast(BinderImsReg* ims)
     { return ims ? THIS(G_CAST(ims, BinderImsRegObject, pub)) : NULL; }
 static inline void binder_ims_reg_object_ref(BinderImsRegObject* self)
@@ -83,6 +109,10 @@ binder_ims_reg_query_done(
     BinderImsReg* ims = &self->pub;
     gboolean registered = FALSE;
 
+    GASSERT(self->query_req == req);
+    radio_request_unref(self->query_req);
+    self->query_req = NULL;
+
     if (status != RADIO_TX_STATUS_OK) {
         ofono_error("getImsRegistrationState failed");
     } else if (resp != RADIO_RESP_GET_IMS_REGISTRATION_STATE) {
@@ -112,6 +142,12 @@ binder_ims_reg_query_done(
         binder_base_queue_property_change(base,
             BINDER_IMS_REG_PROPERTY_REGISTERED);
     }
+
+    /* The state may have changed again while we were waiting */
+    if (self->query_again) {
+        self->query_again = FALSE;
+        binder_ims_reg_query(self);
+    }
     binder_base_emit_queued_signals(base);
 }
 
@@ -120,12 +156,39 @@ void
 binder_ims_reg_query(
     BinderImsRegObject* self)
 {
-    RadioRequest* req = radio_request_new2(self->g,
-        RADIO_REQ_GET_IMS_REGISTRATION_STATE, NULL,
-        binder_ims_reg_query_done, NULL, self);
+    if (self->debounce_id) {
+        /* This query covers the pending indications too */
+        g_source_remove(self->debounce_id);
+        self->debounce_id = 0;
+    }
+    if (self->query_req) {
+        /* Repeat the query once this one completes */
+        if (self->query_again) {
+            self->stat_avoided++;
+            DBG_(self, "%u queries avoided", self->stat_avoided);
+        } else {
+            self->query_again = TRUE;
+        }
+    } else {
+        self->stat_queries++;
+        self->query_req = radio_request_new2(self->g,
+            RADIO_REQ_GET_IMS_REGISTRATION_STATE, NULL,
+            binder_ims_reg_query_done, NULL, self);
+        radio_request_submit(self->query_req);
+    }
+}
+
+static
+gboolean
+binder_ims_reg_debounce_cb(
+    gpointer user_data)
+{
+    BinderImsRegObject* self = THIS(user_data);
 
-    radio_request_submit(req);
-    radio_request_unref(req);
+    GASSERT(self->debounce_id);
+    self->debounce_id = 0;
+    binder_ims_reg_query(self);
+    return G_SOURCE_REMOVE;
 }
 
 static
@@ -139,7 +202,22 @@ binder_ims_reg_state_changed(
     BinderImsRegObject* self = THIS(user_data);
 
     DBG_(self, "");
-    binder_ims_reg_query(self);
+    self->stat_indications++;
+    if (!self->debounce_ms) {
+        binder_ims_reg_query(self);
+    } else {
+        /*
+         * The indication carries no state. Wait until they stop
+         * coming and query the state once.
+         */
+        if (self->debounce_id) {
+            g_source_remove(self->debounce_id);
+            self->stat_avoided++;
+            DBG_(self, "%u queries avoided", self->stat_avoided);
+        }
+        self->debounce_id = g_timeout_add(self->debounce_ms,
+            binder_ims_reg_debounce_cb, self);
+    }
 }
 
 static
@@ -179,6 +257,7 @@ BinderImsReg*
 binder_ims_reg_new(
     RadioClient* client,
     BinderExtSlot* ext_slot,
+    guint debounce_ms,
     const char* log_prefix)
 {
     BinderImsReg* ims = NULL;
@@ -202,6 +281,7 @@ binder_ims_reg_new(
         } else {
             DBG_(self, "using ims radio api");
             self->g = radio_request_group_new(client); /* Keeps ref to client */
+            self->debounce_ms = debounce_ms;
 
             /* Register event handler */
             self->event_id[EVENT_IMS_NETWORK_STATE_CHANGED] =
@@ -280,6 +360,25 @@ binder_ims_reg_remove_handlers(
     gutil_disconnect_handlers(binder_ims_reg_cast(ims), ids, count);
 }
 
+void
+binder_ims_reg_add_metrics(
+    BinderImsReg* ims,
+    BinderMetrics* metrics,
+    const char* labels)
+{
+    BinderImsRegObject* self = binder_ims_reg_cast(ims);
+
+    /* The extension pushes the state, there's nothing to count */
+    if (self && self->g && metrics) {
+        binder_metrics_add(metrics, &binder_ims_reg_metric_inds, labels,
+            self->stat_indications);
+        binder_metrics_add(metrics, &binder_ims_reg_metric_queries, labels,
+            self->stat_queries);
+        binder_metrics_add(metrics, &binder_ims_reg_metric_avoided, labels,
+            self->stat_avoided);
+    }
+}
+
 /*==========================================================================*
  * Internals
  *==========================================================================*/
@@ -308,9 +407,13 @@ binder_ims_reg_object_finalize(
         RadioRequestGroup* g = self->g;
 
         radio_client_remove_all_handlers(g->client, self->event_id);
+        radio_request_drop(self->query_req);
         radio_request_group_cancel(g);
         radio_request_group_unref(g);
     }
+    if (self->debounce_id) {
+        g_source_remove(self->debounce_id);
+    }
     g_free(self->log_prefix);
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
@@ -42,6 +42,7 @@ BinderImsReg*
 binder_ims_reg_new(
     RadioClient* client,
     BinderExtSlot* ext_slot,
+    guint debounce_ms,
     const char* log_prefix);
 
 BinderImsReg*
@@ -78,6 +79,13 @@ binder_ims_reg_remove_handlers(
 #define binder_ims_reg_remove_all_handlers(ims, ids) \
     binder_ims_reg_remove_handlers(ims, ids, G_N_ELEMENTS(ids))
 
+void
+binder_ims_reg_add_metrics(
+    BinderImsReg* ims,
+    BinderMetrics* metrics,
+    const char* labels)
+    BINDER_INTERNAL;
+
 #endif /* BINDER_IMS_REG_H */
 
 /*
@@ -20,6 +20,19 @@
 #include <gutil_log.h>
 #include <ofono/log.h>
 
+/*
+ * The arguments of DBG() are only evaluated if the debug descriptor
+ * is enabled. BINDER_LOG() does the same for GLogModule based output,
+ * i.e. the arguments aren't computed unless the module is enabled at
+ * the requested level. Costlier preparations can be wrapped into an
+ * explicit gutil_log_enabled() check.
+ */
+#define BINDER_LOG(module,level,fmt,args...) do { \
+        if (gutil_log_enabled(module, level)) { \
+            gutil_log(module, level, fmt, ##args); \
+        } \
+    } while (0)
+
 #endif /* BINDER_LOG_H */
 
 /*
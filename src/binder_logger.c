@@ -14,6 +14,7 @@
  */
 
 #include "binder_logger.h"
+#include "binder_log.h"
 #include "binder_util.h"
 
 #include <radio_config.h>
@@ -42,14 +43,54 @@ typedef struct binder_logger_callbacks {
     void (*drop_object)(BinderLogger* logger);
 } BinderLoggerCallbacks;
 
+/*
+ * Capture records are stored back to back in a preallocated ring buffer,
+ * each one is this header followed by the raw parcel data. The oldest
+ * records get overwritten when the buffer fills up. The same layout is
+ * used in the capture file, after the file header.
+ */
+typedef struct binder_logger_capture_record {
+    guint64 timestamp;      /* Monotonic time, microseconds */
+    guint32 code;
+    guint32 serial;
+    guint32 length;         /* Number of bytes following the header */
+    guint32 orig_length;    /* Original size of the parcel */
+    guint32 type;           /* BINDER_LOGGER_CAPTURE_TYPE */
+    guint32 reserved;
+} BinderLoggerCaptureRecord;
+
+typedef struct binder_logger_capture_header {
+    char magic[8];
+    guint32 version;
+    guint32 count;          /* Number of records */
+} BinderLoggerCaptureHeader;
+
+typedef enum binder_logger_capture_type {
+    BINDER_LOGGER_CAPTURE_REQ,
+    BINDER_LOGGER_CAPTURE_RESP,
+    BINDER_LOGGER_CAPTURE_IND
+} BINDER_LOGGER_CAPTURE_TYPE;
+
+typedef struct binder_logger_ring {
+    guint8* buf;
+    gsize size;
+    gsize head;             /* Offset of the oldest record */
+    gsize used;
+    guint count;
+} BinderLoggerRing;
+
 struct binder_logger {
     const BinderLoggerCallbacks* cb;
     gpointer object;
     gulong event_id[EVENT_COUNT];
     char* prefix;
+    BinderLoggerRing* ring;
 };
 
 #define CONFIG_PREFIX "config"
+#define CAPTURE_MAGIC "BNDRCAP"
+#define CAPTURE_VERSION (1)
+#define CAPTURE_MIN_SIZE (4096)
 
 GLogModule binder_logger_module = {
     .max_level = GLOG_LEVEL_VERBOSE,
@@ -73,14 +114,20 @@ binder_logger_trace_req(
 {
     const BinderLoggerCallbacks* cb = logger->cb;
     static const GLogModule* log = &binder_logger_module;
-    const gsize header_size = cb->rpc_header_size(logger->object, code);
-    const char* name = cb->req_name(code);
+    gsize header_size;
+    const char* name;
     GBinderWriter writer;
     const guint8* data;
     guint32 serial;
     gsize size;
 
+    if (!gutil_log_enabled(log, GLOG_LEVEL_VERBOSE)) {
+        return;
+    }
+
     /* Use writer API to fetch the raw data and extract the serial */
+    header_size = cb->rpc_header_size(logger->object, code);
+    name = cb->req_name(code);
     gbinder_local_request_init_writer(args, &writer);
     data = gbinder_writer_get_data(&writer, &size);
     serial = (size >= header_size + 4) ? *(guint32*)(data + header_size) : 0;
@@ -104,12 +151,20 @@ binder_logger_trace_resp(
 {
     static const GLogModule* log = &binder_logger_module;
     const BinderLoggerCallbacks* cb = logger->cb;
-    const char* name = cb->resp_name(code);
-    const char* error = (info->error == RADIO_ERROR_NONE) ? NULL :
-        binder_radio_error_string(info->error);
-    const char* arg1 = name ? name : error;
-    const char* arg2 = name ? error : NULL;
+    const char* name;
+    const char* error;
+    const char* arg1;
+    const char* arg2;
+
+    if (!gutil_log_enabled(log, GLOG_LEVEL_VERBOSE)) {
+        return;
+    }
 
+    name = cb->resp_name(code);
+    error = (info->error == RADIO_ERROR_NONE) ? NULL :
+        binder_radio_error_string(info->error);
+    arg1 = name ? name : error;
+    arg2 = name ? error : NULL;
     if (arg2) {
         gutil_log(log, GLOG_LEVEL_VERBOSE, "%s> [%08x] %u %s %s",
             logger->prefix, info->serial, code, arg1, arg2);
@@ -129,12 +184,14 @@ binder_logger_trace_ind(
     RADIO_IND code,
     const GBinderReader* args)
 {
-    const BinderLoggerCallbacks* cb = logger->cb;
-    const char* name = cb->ind_name(code);
     static const GLogModule* log = &binder_logger_module;
 
-    gutil_log(log, GLOG_LEVEL_VERBOSE, "%s> %u %s",
-        logger->prefix, code, name ? name : "");
+    if (gutil_log_enabled(log, GLOG_LEVEL_VERBOSE)) {
+        const char* name = logger->cb->ind_name(code);
+
+        gutil_log(log, GLOG_LEVEL_VERBOSE, "%s> %u %s",
+            logger->prefix, code, name ? name : "");
+    }
 }
 
 static
@@ -165,6 +222,113 @@ binder_logger_dump_reader(
         data, size);
 }
 
+/*==========================================================================*
+ * Capture ring buffer
+ *==========================================================================*/
+
+static
+BinderLoggerRing*
+binder_logger_ring_new(
+    gsize size)
+{
+    BinderLoggerRing* ring = g_new0(BinderLoggerRing, 1);
+
+    ring->size = MAX(size, CAPTURE_MIN_SIZE);
+    ring->buf = g_malloc(ring->size);
+    return ring;
+}
+
+static
+void
+binder_logger_ring_free(
+    BinderLoggerRing* ring)
+{
+    if (ring) {
+        g_free(ring->buf);
+        g_free(ring);
+    }
+}
+
+static
+void
+binder_logger_ring_read(
+    const BinderLoggerRing* ring,
+    gsize offset,
+    void* out,
+    gsize len)
+{
+    const gsize pos = offset % ring->size;
+    const gsize n = MIN(len, ring->size - pos);
+
+    memcpy(out, ring->buf + pos, n);
+    if (n < len) {
+        memcpy(((guint8*)out) + n, ring->buf, len - n);
+    }
+}
+
+static
+void
+binder_logger_ring_write(
+    BinderLoggerRing* ring,
+    const void* data,
+    gsize len)
+{
+    const gsize pos = (ring->head + ring->used) % ring->size;
+    const gsize n = MIN(len, ring->size - pos);
+
+    memcpy(ring->buf + pos, data, n);
+    if (n < len) {
+        memcpy(ring->buf, ((const guint8*)data) + n, len - n);
+    }
+    ring->used += len;
+}
+
+static
+void
+binder_logger_ring_drop_oldest(
+    BinderLoggerRing* ring)
+{
+    BinderLoggerCaptureRecord rec;
+    const gsize n = sizeof(rec);
+
+    binder_logger_ring_read(ring, ring->head, &rec, n);
+    ring->head = (ring->head + n + rec.length) % ring->size;
+    ring->used -= n + rec.length;
+    ring->count--;
+}
+
+static
+void
+binder_logger_capture(
+    BinderLogger* logger,
+    BINDER_LOGGER_CAPTURE_TYPE type,
+    guint32 code,
+    guint32 serial,
+    const void* data,
+    gsize size)
+{
+    BinderLoggerRing* ring = logger->ring;
+    BinderLoggerCaptureRecord rec;
+    /* Don't let a single huge parcel wipe out the entire history */
+    const gsize max = ring->size / 4 - sizeof(rec);
+    const gsize len = MIN(size, max);
+
+    while (ring->size - ring->used < sizeof(rec) + len) {
+        binder_logger_ring_drop_oldest(ring);
+    }
+
+    rec.timestamp = g_get_monotonic_time();
+    rec.code = code;
+    rec.serial = serial;
+    rec.length = len;
+    rec.orig_length = size;
+    rec.type = type;
+    rec.reserved = 0;
+    binder_logger_ring_write(ring, &rec, sizeof(rec));
+    binder_logger_ring_write(ring, data, len);
+    ring->count++;
+}
+
 /*==========================================================================*
  * RadioInstance implementation
  *==========================================================================*/
@@ -213,7 +377,7 @@ binder_logger_radio_trace_ack_cb(
 {
     BinderLogger* logger = user_data;
 
-    gutil_log(&binder_logger_module, GLOG_LEVEL_VERBOSE, "%s> [%08x] "
+    BINDER_LOG(&binder_logger_module, GLOG_LEVEL_VERBOSE, "%s> [%08x] "
         "acknowledgeRequest", logger->prefix, serial);
 }
 
@@ -252,6 +416,59 @@ binder_logger_radio_dump_ind_cb(
     binder_logger_dump_reader(args);
 }
 
+static
+void
+binder_logger_radio_capture_req_cb(
+    RadioInstance* radio,
+    RADIO_REQ code,
+    GBinderLocalRequest* args,
+    gpointer user_data)
+{
+    BinderLogger* logger = user_data;
+    const gsize header_size = radio_instance_rpc_header_size(radio, code);
+    GBinderWriter writer;
+    const guint8* data;
+    gsize size;
+
+    gbinder_local_request_init_writer(args, &writer);
+    data = gbinder_writer_get_data(&writer, &size);
+    binder_logger_capture(logger, BINDER_LOGGER_CAPTURE_REQ, code,
+        (size >= header_size + 4) ? *(guint32*)(data + header_size) : 0,
+        data, size);
+}
+
+static
+void
+binder_logger_radio_capture_resp_cb(
+    RadioInstance* radio,
+    RADIO_RESP code,
+    const RadioResponseInfo* info,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    gsize size;
+    const guint8* data = gbinder_reader_get_data(args, &size);
+
+    binder_logger_capture((BinderLogger*)user_data,
+        BINDER_LOGGER_CAPTURE_RESP, code, info->serial, data, size);
+}
+
+static
+void
+binder_logger_radio_capture_ind_cb(
+    RadioInstance* radio,
+    RADIO_IND code,
+    RADIO_IND_TYPE type,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    gsize size;
+    const guint8* data = gbinder_reader_get_data(args, &size);
+
+    binder_logger_capture((BinderLogger*)user_data,
+        BINDER_LOGGER_CAPTURE_IND, code, 0, data, size);
+}
+
 static
 const char*
 binder_logger_radio_req_name(
@@ -533,12 +750,67 @@ binder_logger_new_config_dump(
         binder_logger_config_dump_resp_cb, binder_logger_config_dump_ind_cb);
 }
 
+BinderLogger*
+binder_logger_new_radio_capture(
+    RadioInstance* radio,
+    const char* prefix,
+    gsize size)
+{
+    BinderLogger* logger = binder_logger_radio_new(radio, prefix,
+        RADIO_INSTANCE_PRIORITY_HIGHEST - 1,
+        binder_logger_radio_capture_req_cb,
+        binder_logger_radio_capture_resp_cb,
+        binder_logger_radio_capture_ind_cb, NULL);
+
+    if (logger) {
+        logger->ring = binder_logger_ring_new(size);
+    }
+    return logger;
+}
+
+gboolean
+binder_logger_capture_write(
+    BinderLogger* logger,
+    const char* path)
+{
+    BinderLoggerRing* ring = logger ? logger->ring : NULL;
+
+    if (ring && path) {
+        BinderLoggerCaptureHeader* header;
+        const gsize total = sizeof(*header) + ring->used;
+        guint8* buf = g_malloc(total);
+        GError* error = NULL;
+        gboolean ok;
+
+        header = (BinderLoggerCaptureHeader*)buf;
+        memset(header, 0, sizeof(*header));
+        memcpy(header->magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+        header->version = CAPTURE_VERSION;
+        header->count = ring->count;
+
+        /* Oldest record first */
+        binder_logger_ring_read(ring, ring->head, buf + sizeof(*header),
+            ring->used);
+        ok = g_file_set_contents(path, (char*)buf, total, &error);
+        if (ok) {
+            DBG("%s%u record(s) => %s", logger->prefix, ring->count, path);
+        } else {
+            ofono_warn("Failed to write %s: %s", path, error->message);
+            g_error_free(error);
+        }
+        g_free(buf);
+        return ok;
+    }
+    return FALSE;
+}
+
 void
 binder_logger_free(
     BinderLogger* logger)
 {
     if (logger) {
         logger->cb->drop_object(logger);
+        binder_logger_ring_free(logger->ring);
         g_free(logger->prefix);
         g_free(logger);
     }
@@ -30,6 +30,24 @@ binder_logger_new_radio_dump(
     const char* prefix)
     BINDER_INTERNAL;
 
+/*
+ * Capture logger copies raw parcels into a preallocated ring buffer
+ * of the given size. The contents of the buffer can be written to
+ * a file with binder_logger_capture_write().
+ */
+BinderLogger*
+binder_logger_new_radio_capture(
+    RadioInstance* instance,
+    const char* prefix,
+    gsize size)
+    BINDER_INTERNAL;
+
+gboolean
+binder_logger_capture_write(
+    BinderLogger* logger,
+    const char* path)
+    BINDER_INTERNAL;
+
 BinderLogger*
 binder_logger_new_config_trace(
     RadioConfig* config)
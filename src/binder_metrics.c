@@ -0,0 +1,307 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_metrics.h"
+
+#include <ofono/log.h>
+
+#include <errno.h>
+#include <stdarg.h>
+#include <string.h>
+
+struct binder_metrics {
+    GPtrArray* families;    /* In order of appearance */
+    GHashTable* samples;    /* BinderMetricFamily* => GString */
+};
+
+static
+void
+binder_metrics_string_free(
+    gpointer str)
+{
+    g_string_free(str, TRUE);
+}
+
+static
+void
+binder_metrics_append_seconds(
+    GString* buf,
+    guint64 us)
+{
+    char str[G_ASCII_DTOSTR_BUF_SIZE];
+
+    /* Locale independent, and exact for whole microseconds */
+    g_string_append(buf, g_ascii_formatd(str, sizeof(str), "%.6f",
+        us / 1000000.0));
+}
+
+static
+GString*
+binder_metrics_sample(
+    BinderMetrics* self,
+    const BinderMetricFamily* family,
+    const char* suffix,
+    const char* labels,
+    const char* le)
+{
+    GString* buf = g_hash_table_lookup(self->samples, family);
+    const gboolean have_labels = labels && labels[0];
+
+    if (!buf) {
+        static const char* types[] = { "counter", "gauge", "histogram" };
+
+        buf = g_string_new(NULL);
+        g_string_append_printf(buf, "# TYPE %s %s\n", family->name,
+            types[family->type]);
+        if (family->help) {
+            g_string_append_printf(buf, "# HELP %s %s\n", family->name,
+                family->help);
+        }
+        g_ptr_array_add(self->families, (gpointer)family);
+        g_hash_table_insert(self->samples, (gpointer)family, buf);
+    }
+
+    g_string_append(buf, family->name);
+    if (suffix) {
+        g_string_append(buf, suffix);
+    }
+    if (have_labels || le) {
+        g_string_append_c(buf, '{');
+        if (have_labels) {
+            g_string_append(buf, labels);
+        }
+        if (le) {
+            g_string_append_printf(buf, "%sle=\"%s\"", have_labels ?
+                "," : "", le);
+        }
+        g_string_append_c(buf, '}');
+    }
+    g_string_append_c(buf, ' ');
+    return buf;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderMetrics*
+binder_metrics_new(
+    void)
+{
+    BinderMetrics* self = g_new0(BinderMetrics, 1);
+
+    self->families = g_ptr_array_new();
+    self->samples = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+        NULL, binder_metrics_string_free);
+    return self;
+}
+
+void
+binder_metrics_free(
+    BinderMetrics* self)
+{
+    if (self) {
+        g_ptr_array_free(self->families, TRUE);
+        g_hash_table_destroy(self->samples);
+        g_free(self);
+    }
+}
+
+char*
+binder_metrics_labels(
+    const char* name,
+    ...)
+{
+    GString* buf = g_string_new(NULL);
+    va_list va;
+
+    va_start(va, name);
+    while (name) {
+        const char* value = va_arg(va, const char*);
+        const char* ptr;
+
+        if (buf->len) {
+            g_string_append_c(buf, ',');
+        }
+        g_string_append(buf, name);
+        g_string_append(buf, "=\"");
+        for (ptr = value ? value : ""; *ptr; ptr++) {
+            switch (*ptr) {
+            case '\\':
+                g_string_append(buf, "\\\\");
+                break;
+            case '"':
+                g_string_append(buf, "\\\"");
+                break;
+            case '\n':
+                g_string_append(buf, "\\n");
+                break;
+            default:
+                g_string_append_c(buf, *ptr);
+                break;
+            }
+        }
+        g_string_append_c(buf, '"');
+        name = va_arg(va, const char*);
+    }
+    va_end(va);
+    return g_string_free(buf, FALSE);
+}
+
+char*
+binder_metrics_labels_join(
+    const char* labels1,
+    const char* labels2)
+{
+    if (labels1 && labels1[0]) {
+        return (labels2 && labels2[0]) ?
+            g_strconcat(labels1, ",", labels2, NULL) :
+            g_strdup(labels1);
+    } else {
+        return g_strdup(labels2 ? labels2 : "");
+    }
+}
+
+void
+binder_metrics_add(
+    BinderMetrics* self,
+    const BinderMetricFamily* family,
+    const char* labels,
+    guint64 value)
+{
+    if (self && family) {
+        GString* buf = binder_metrics_sample(self, family,
+            (family->type == BINDER_METRIC_COUNTER) ? "_total" : NULL,
+            labels, NULL);
+
+        g_string_append_printf(buf, "%" G_GUINT64_FORMAT "\n", value);
+    }
+}
+
+void
+binder_metrics_add_seconds(
+    BinderMetrics* self,
+    const BinderMetricFamily* family,
+    const char* labels,
+    guint64 us)
+{
+    if (self && family) {
+        GString* buf = binder_metrics_sample(self, family,
+            (family->type == BINDER_METRIC_COUNTER) ? "_total" : NULL,
+            labels, NULL);
+
+        binder_metrics_append_seconds(buf, us);
+        g_string_append_c(buf, '\n');
+    }
+}
+
+void
+binder_metrics_add_histogram(
+    BinderMetrics* self,
+    const BinderMetricFamily* family,
+    const char* labels,
+    const guint* buckets,
+    guint count,
+    guint64 sum_us)
+{
+    if (self && family) {
+        guint64 total = 0;
+        guint i, last = 0;
+        GString* buf;
+
+        /* Skip empty buckets at the top end */
+        for (i = 0; i < count; i++) {
+            if (buckets[i]) {
+                last = i + 1;
+            }
+        }
+
+        for (i = 0; i < last; i++) {
+            char le[G_ASCII_DTOSTR_BUF_SIZE];
+
+            total += buckets[i];
+            g_ascii_formatd(le, sizeof(le), "%.6f",
+                (((guint64)1) << i) / 1000000.0);
+            buf = binder_metrics_sample(self, family, "_bucket", labels, le);
+            g_string_append_printf(buf, "%" G_GUINT64_FORMAT "\n", total);
+        }
+
+        buf = binder_metrics_sample(self, family, "_bucket", labels, "+Inf");
+        g_string_append_printf(buf, "%" G_GUINT64_FORMAT "\n", total);
+        buf = binder_metrics_sample(self, family, "_count", labels, NULL);
+        g_string_append_printf(buf, "%" G_GUINT64_FORMAT "\n", total);
+        buf = binder_metrics_sample(self, family, "_sum", labels, NULL);
+        binder_metrics_append_seconds(buf, sum_us);
+        g_string_append_c(buf, '\n');
+    }
+}
+
+char*
+binder_metrics_format(
+    BinderMetrics* self)
+{
+    GString* out = g_string_new(NULL);
+
+    if (self) {
+        guint i;
+
+        for (i = 0; i < self->families->len; i++) {
+            const GString* buf = g_hash_table_lookup(self->samples,
+                self->families->pdata[i]);
+
+            g_string_append_len(out, buf->str, buf->len);
+        }
+    }
+    g_string_append(out, "# EOF\n");
+    return g_string_free(out, FALSE);
+}
+
+gboolean
+binder_metrics_write(
+    BinderMetrics* self,
+    const char* path)
+{
+    gboolean ok = FALSE;
+
+    if (path) {
+        char* dir = g_path_get_dirname(path);
+        char* text = binder_metrics_format(self);
+        GError* error = NULL;
+
+        if (g_mkdir_with_parents(dir, 0755) < 0) {
+            ofono_warn("Failed to create %s: %s", dir, strerror(errno));
+        }
+
+        /* g_file_set_contents() writes a temporary file and renames it */
+        if (g_file_set_contents(path, text, -1, &error)) {
+            ok = TRUE;
+        } else {
+            ofono_warn("Failed to write %s: %s", path, error->message);
+            g_error_free(error);
+        }
+        g_free(text);
+        g_free(dir);
+    }
+    return ok;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,117 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_METRICS_H
+#define BINDER_METRICS_H
+
+#include "binder_types.h"
+
+/*
+ * OpenMetrics text exposition. Modules add samples to the metric
+ * families which they define statically, samples are grouped by
+ * family in the order in which the families were first used, as
+ * the format requires. Label strings are built with
+ * binder_metrics_labels() which takes care of escaping.
+ */
+
+typedef enum binder_metric_type {
+    BINDER_METRIC_COUNTER,
+    BINDER_METRIC_GAUGE,
+    BINDER_METRIC_HISTOGRAM
+} BINDER_METRIC_TYPE;
+
+typedef struct binder_metric_family {
+    const char* name;   /* Without _total, _bucket etc. suffixes */
+    BINDER_METRIC_TYPE type;
+    const char* help;
+} BinderMetricFamily;
+
+BinderMetrics*
+binder_metrics_new(
+    void)
+    BINDER_INTERNAL;
+
+void
+binder_metrics_free(
+    BinderMetrics* metrics)
+    BINDER_INTERNAL;
+
+/* NULL terminated list of name/value pairs */
+char*
+binder_metrics_labels(
+    const char* name,
+    ...)
+    G_GNUC_NULL_TERMINATED
+    G_GNUC_WARN_UNUSED_RESULT
+    BINDER_INTERNAL;
+
+/* Appends the two (possibly empty or NULL) label strings */
+char*
+binder_metrics_labels_join(
+    const char* labels1,
+    const char* labels2)
+    G_GNUC_WARN_UNUSED_RESULT
+    BINDER_INTERNAL;
+
+void
+binder_metrics_add(
+    BinderMetrics* metrics,
+    const BinderMetricFamily* family,
+    const char* labels,
+    guint64 value)
+    BINDER_INTERNAL;
+
+/* Microseconds are exposed as seconds */
+void
+binder_metrics_add_seconds(
+    BinderMetrics* metrics,
+    const BinderMetricFamily* family,
+    const char* labels,
+    guint64 us)
+    BINDER_INTERNAL;
+
+/* Bucket i counts values in [2^(i-1), 2^i) microseconds */
+void
+binder_metrics_add_histogram(
+    BinderMetrics* metrics,
+    const BinderMetricFamily* family,
+    const char* labels,
+    const guint* buckets,
+    guint count,
+    guint64 sum_us)
+    BINDER_INTERNAL;
+
+char*
+binder_metrics_format(
+    BinderMetrics* metrics)
+    G_GNUC_WARN_UNUSED_RESULT
+    BINDER_INTERNAL;
+
+/* Atomically replaces the file */
+gboolean
+binder_metrics_write(
+    BinderMetrics* metrics,
+    const char* path)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_METRICS_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -14,6 +14,7 @@
  */
 
 #include "binder_modem.h"
+#include "binder_metrics.h"
 #include "binder_network.h"
 #include "binder_radio.h"
 #include "binder_sim_card.h"
@@ -77,6 +78,12 @@ typedef struct binder_modem_online_request {
     ofono_modem_online_cb_t cb;
     void* data;
     guint timeout_id;
+    gint64 start;
+    /* Transition timing, reported as metrics */
+    guint count;
+    guint timeouts;
+    guint64 total_us;
+    guint64 max_us;
 } BinderModemOnlineRequest;
 
 struct binder_modem_priv {
@@ -100,6 +107,23 @@ struct binder_modem_priv {
 
 #define RADIO_POWER_TAG(md) (md)
 
+static const BinderMetricFamily binder_modem_metric_transitions = {
+    "binder_modem_online_transitions", BINDER_METRIC_COUNTER,
+    "Completed online/offline transitions"
+};
+static const BinderMetricFamily binder_modem_metric_timeouts = {
+    "binder_modem_online_timeouts", BINDER_METRIC_COUNTER,
+    "Online/offline transitions which have timed out"
+};
+static const BinderMetricFamily binder_modem_metric_time = {
+    "binder_modem_online_transition_seconds", BINDER_METRIC_COUNTER,
+    "Time spent waiting for the radio to reach the requested state"
+};
+static const BinderMetricFamily binder_modem_metric_max_time = {
+    "binder_modem_online_transition_max_seconds", BINDER_METRIC_GAUGE,
+    "Longest online/offline transition"
+};
+
 #define DBG_(self,fmt,args...) DBG("%s" fmt, (self)->log_prefix, ##args)
 
 static BinderModemPriv* binder_modem_cast(BinderModem* modem)
@@ -129,6 +153,16 @@ void
 binder_modem_online_request_ok(
     BinderModemOnlineRequest* req)
 {
+    if (req->cb) {
+        const guint64 us = MAX(g_get_monotonic_time() - req->start, 0);
+
+        req->count++;
+        req->total_us += us;
+        if (req->max_us < us) {
+            req->max_us = us;
+        }
+        DBG_(req->self, "%s in %u ms", req->name, (guint) (us / 1000));
+    }
     if (req->timeout_id) {
         g_source_remove(req->timeout_id);
         req->timeout_id = 0;
@@ -175,7 +209,10 @@ binder_modem_online_request_timeout(
 
     GASSERT(req->timeout_id);
     req->timeout_id = 0;
-    DBG_(req->self, "%s", req->name);
+    if (req->cb) {
+        req->timeouts++;
+    }
+    DBG_(req->self, "%s timed out", req->name);
     binder_modem_online_request_done(req);
     binder_modem_update_online_state(req->self);
     return G_SOURCE_REMOVE;
@@ -197,9 +234,17 @@ binder_modem_online_check(
 static
 void
 binder_modem_schedule_online_check(
-    BinderModemPriv* self)
+    BinderModemPriv* self,
+    gboolean online)
 {
-    if (!self->online_check_id) {
+    const RADIO_STATE state = self->pub.radio->state;
+
+    /*
+     * Otherwise the request gets completed by the radio state change.
+     * The ofono callback is never invoked before set_online returns.
+     */
+    if (!self->online_check_id && (online ? (state == RADIO_STATE_ON) :
+        (state == RADIO_STATE_OFF || state == RADIO_STATE_UNAVAILABLE))) {
         self->online_check_id = g_idle_add(binder_modem_online_check, self);
     }
 }
@@ -412,12 +457,14 @@ binder_modem_set_online(
 
     req->cb = cb;
     req->data = data;
+    req->start = g_get_monotonic_time();
     if (req->timeout_id) {
         g_source_remove(req->timeout_id);
     }
+    /* Safety net, the state change normally arrives much sooner */
     req->timeout_id = g_timeout_add_seconds(ONLINE_TIMEOUT_SECS,
         binder_modem_online_request_timeout, req);
-    binder_modem_schedule_online_check(self);
+    binder_modem_schedule_online_check(self, online);
 }
 
 static
@@ -536,6 +583,38 @@ binder_modem_cleanup()
     ofono_modem_driver_unregister(&binder_modem_driver);
 }
 
+void
+binder_modem_add_metrics(
+    BinderModem* modem,
+    BinderMetrics* metrics,
+    const char* labels)
+{
+    if (modem && metrics) {
+        BinderModemPriv* self = binder_modem_cast(modem);
+        const BinderModemOnlineRequest* reqs[2];
+        guint i;
+
+        reqs[0] = &self->set_online;
+        reqs[1] = &self->set_offline;
+        for (i = 0; i < G_N_ELEMENTS(reqs); i++) {
+            const BinderModemOnlineRequest* req = reqs[i];
+            char* dir = binder_metrics_labels("state", req->name, NULL);
+            char* all = binder_metrics_labels_join(labels, dir);
+
+            binder_metrics_add(metrics, &binder_modem_metric_transitions,
+                all, req->count);
+            binder_metrics_add(metrics, &binder_modem_metric_timeouts,
+                all, req->timeouts);
+            binder_metrics_add_seconds(metrics, &binder_modem_metric_time,
+                all, req->total_us);
+            binder_metrics_add_seconds(metrics,
+                &binder_modem_metric_max_time, all, req->max_us);
+            g_free(all);
+            g_free(dir);
+        }
+    }
+}
+
 BinderModem*
 binder_modem_create(
     RadioClient* client,
@@ -548,6 +627,9 @@ binder_modem_create(
     BinderRadio* radio,
     BinderNetwork* network,
     BinderSimCard* card,
+    BinderSimIoCache* sim_io_cache,
+    BinderSsCache* ss_cache,
+    BinderStats* stats,
     BinderData* data,
     BinderSimSettings* settings,
     struct ofono_cell_info* cell_info)
@@ -575,12 +657,16 @@ binder_modem_create(
         modem->radio = binder_radio_ref(radio);
         modem->network = binder_network_ref(network);
         modem->sim_card = binder_sim_card_ref(card);
+        modem->sim_io_cache = sim_io_cache;
+        modem->ss_cache = ss_cache;
+        modem->stats = stats;
         modem->sim_settings = binder_sim_settings_ref(settings);
         modem->cell_info = ofono_cell_info_ref(cell_info);
         modem->data = binder_data_ref(data);
         modem->watch = ofono_watch_new(path);
         modem->client = radio_client_ref(client);
-        modem->ims = binder_ims_reg_new(client, ext, log_prefix);
+        modem->ims = binder_ims_reg_new(client, ext,
+            config->ims_state_debounce_ms, log_prefix);
         modem->ext = binder_ext_slot_ref(ext);
         self->g = radio_request_group_new(client);
         self->last_known_iccid = g_strdup(modem->watch->iccid);
@@ -36,7 +36,10 @@ struct binder_modem {
     BinderNetwork* network;
     BinderRadio* radio;
     BinderSimCard* sim_card;
+    BinderSimIoCache* sim_io_cache;
     BinderSimSettings* sim_settings;
+    BinderSsCache* ss_cache;
+    BinderStats* stats;
     BinderSlotConfig config;
 };
 
@@ -63,11 +66,21 @@ binder_modem_create(
     BinderRadio* radio,
     BinderNetwork* network,
     BinderSimCard* card,
+    BinderSimIoCache* sim_io_cache,
+    BinderSsCache* ss_cache,
+    BinderStats* stats,
     BinderData* data,
     BinderSimSettings* settings,
     struct ofono_cell_info* cell_info)
     BINDER_INTERNAL;
 
+void
+binder_modem_add_metrics(
+    BinderModem* modem,
+    BinderMetrics* metrics,
+    const char* labels)
+    BINDER_INTERNAL;
+
 #endif /* BINDER_MODEM_H */
 
 /*
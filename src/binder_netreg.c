@@ -17,6 +17,7 @@
 #include "binder_netreg.h"
 #include "binder_network.h"
 #include "binder_oplist.h"
+#include "binder_req_share.h"
 #include "binder_util.h"
 #include "binder_log.h"
 
@@ -69,9 +70,20 @@ typedef struct binder_netreg {
     gboolean replace_strange_oper;
     int signal_strength_dbm_weak;
     int signal_strength_dbm_strong;
+    int signal_strength_window_ms;
+    int signal_strength_thresholds;
     int network_selection_timeout_ms;
+    int network_scan_settle_ms;
+    int operator_list_cache_ms;
+    BinderNetRegOpListCache oplist_cache;
+    int strength_percent; /* Last reported to ofono core, or -1 */
+    int strength_pending; /* Most recent value received within the window */
+    guint strength_window_id;
+    guint strength_merged; /* Superseded within the window */
+    guint strength_dropped; /* Didn't change the percentage */
     RadioRequest* register_req;
-    RadioRequest* strength_req;
+    BinderReqShare* share;
+    gulong strength_call_id;
     char* log_prefix;
     guint init_id;
     guint notify_id;
@@ -93,6 +105,15 @@ typedef struct binder_netreg_cbd {
     gpointer data;
 } BinderNetRegCbData;
 
+typedef struct binder_netreg_oplist_cache {
+    BinderOpList* oplist;
+    char mcc[OFONO_MAX_MCC_LENGTH + 1];
+    char mnc[OFONO_MAX_MNC_LENGTH + 1];
+    int lac;
+    int ci;
+    gint64 time;
+} BinderNetRegOpListCache;
+
 struct binder_netreg_scan {
     RadioRequest* req;
     BinderOpList* oplist;
@@ -100,27 +121,42 @@ struct binder_netreg_scan {
     gpointer data;
     gboolean stop; /* startNetworkScan succeeded */
     guint timeout_id;
+    guint settle_id;
 };
 
 typedef struct binder_netreg_radio_type {
     enum ofono_radio_access_mode mode;
     RADIO_ACCESS_NETWORKS ran;
     RADIO_NETWORK_SCAN_SPECIFIER_1_5_TYPE spec_1_5_type;
+    gint32 measurement; /* SignalMeasurementType for IRadio 1.5 */
 } BinderNetRegRadioType;
 
+/* android.hardware.radio@1.5::SignalMeasurementType */
+#define SIGNAL_MEASUREMENT_RSSI   (1)
+#define SIGNAL_MEASUREMENT_RSCP   (2)
+#define SIGNAL_MEASUREMENT_RSRP   (3)
+#define SIGNAL_MEASUREMENT_SSRSRP (6)
+
+/* Capped by BINDER_MAX_SLOT_SIGNAL_THRESHOLDS in binder_plugin.c */
+#define SIGNAL_THRESHOLDS_MAX     (4)
+#define SIGNAL_HYSTERESIS_DB      (2)
+
 static const BinderNetRegRadioType binder_netreg_radio_types[] = {
     {
          OFONO_RADIO_ACCESS_MODE_GSM,
          RADIO_ACCESS_NETWORKS_GERAN,
-         RADIO_NETWORK_SCAN_SPECIFIER_1_5_GERAN
+         RADIO_NETWORK_SCAN_SPECIFIER_1_5_GERAN,
+         SIGNAL_MEASUREMENT_RSSI
     },{
          OFONO_RADIO_ACCESS_MODE_UMTS,
          RADIO_ACCESS_NETWORKS_UTRAN,
-         RADIO_NETWORK_SCAN_SPECIFIER_1_5_UTRAN
+         RADIO_NETWORK_SCAN_SPECIFIER_1_5_UTRAN,
+         SIGNAL_MEASUREMENT_RSCP
     },{
          OFONO_RADIO_ACCESS_MODE_LTE,
          RADIO_ACCESS_NETWORKS_EUTRAN,
-         RADIO_NETWORK_SCAN_SPECIFIER_1_5_EUTRAN
+         RADIO_NETWORK_SCAN_SPECIFIER_1_5_EUTRAN,
+         SIGNAL_MEASUREMENT_RSRP
     }
 };
 
@@ -128,19 +164,23 @@ static const BinderNetRegRadioType binder_netreg_radio_types_1_5[] = {
     {
          OFONO_RADIO_ACCESS_MODE_GSM,
          RADIO_ACCESS_NETWORKS_GERAN,
-         RADIO_NETWORK_SCAN_SPECIFIER_1_5_GERAN
+         RADIO_NETWORK_SCAN_SPECIFIER_1_5_GERAN,
+         SIGNAL_MEASUREMENT_RSSI
     },{
          OFONO_RADIO_ACCESS_MODE_UMTS,
          RADIO_ACCESS_NETWORKS_UTRAN,
-         RADIO_NETWORK_SCAN_SPECIFIER_1_5_UTRAN
+         RADIO_NETWORK_SCAN_SPECIFIER_1_5_UTRAN,
+         SIGNAL_MEASUREMENT_RSCP
     },{
          OFONO_RADIO_ACCESS_MODE_LTE,
          RADIO_ACCESS_NETWORKS_EUTRAN,
-         RADIO_NETWORK_SCAN_SPECIFIER_1_5_EUTRAN
+         RADIO_NETWORK_SCAN_SPECIFIER_1_5_EUTRAN,
+         SIGNAL_MEASUREMENT_RSRP
     },{
          OFONO_RADIO_ACCESS_MODE_NR,
          RADIO_ACCESS_NETWORKS_NGRAN,
-         RADIO_NETWORK_SCAN_SPECIFIER_1_5_NGRAN
+         RADIO_NETWORK_SCAN_SPECIFIER_1_5_NGRAN,
+         SIGNAL_MEASUREMENT_SSRSRP
     }
 };
 
@@ -266,6 +306,9 @@ binder_netreg_registration_status(
     DBG_(self, "");
     cb(binder_error_ok(&error), binder_netreg_check_status(self, reg->status),
         reg->lac, reg->ci, reg->access_tech, data);
+
+    /* Refresh the state in the background if it's getting old */
+    binder_network_query_registration_state(self->network);
 }
 
 static
@@ -283,6 +326,7 @@ binder_netreg_current_operator_cb(
     self->current_operator_id = 0;
 
     cb(binder_error_ok(&error), self->network->operator, cbd->data);
+    binder_network_query_registration_state(self->network);
     return G_SOURCE_REMOVE;
 }
 
@@ -378,6 +422,66 @@ binder_netreg_process_operators(
     }
 }
 
+static
+void
+binder_netreg_oplist_cache_clear(
+    BinderNetReg* self)
+{
+    BinderNetRegOpListCache* cache = &self->oplist_cache;
+
+    binder_oplist_free(cache->oplist);
+    memset(cache, 0, sizeof(*cache));
+}
+
+static
+void
+binder_netreg_oplist_cache_update(
+    BinderNetReg* self,
+    const BinderOpList* oplist)
+{
+    const struct ofono_network_operator* op = self->network->operator;
+
+    binder_netreg_oplist_cache_clear(self);
+    if (self->operator_list_cache_ms > 0 && op && oplist->count) {
+        BinderNetRegOpListCache* cache = &self->oplist_cache;
+        const BinderRegistrationState* reg = &self->network->voice;
+
+        /* The list is only reused in the same place */
+        cache->oplist = binder_oplist_copy(oplist);
+        g_strlcpy(cache->mcc, op->mcc, sizeof(cache->mcc));
+        g_strlcpy(cache->mnc, op->mnc, sizeof(cache->mnc));
+        cache->lac = reg->lac;
+        cache->ci = reg->ci;
+        cache->time = g_get_monotonic_time();
+    }
+}
+
+static
+const BinderOpList*
+binder_netreg_oplist_cache_lookup(
+    BinderNetReg* self)
+{
+    BinderNetRegOpListCache* cache = &self->oplist_cache;
+
+    if (cache->oplist) {
+        const struct ofono_network_operator* op = self->network->operator;
+        const BinderRegistrationState* reg = &self->network->voice;
+        const gint64 age_ms = (g_get_monotonic_time() - cache->time) / 1000;
+
+        if (age_ms >= self->operator_list_cache_ms) {
+            DBG_(self, "operator list has expired");
+        } else if (!op || strcmp(op->mcc, cache->mcc) ||
+            strcmp(op->mnc, cache->mnc) || reg->lac != cache->lac ||
+            reg->ci != cache->ci) {
+            DBG_(self, "location has changed");
+        } else {
+            return cache->oplist;
+        }
+        binder_netreg_oplist_cache_clear(self);
+    }
+    return NULL;
+}
+
 static
 BinderNetRegScan*
 binder_netreg_scan_new(
@@ -406,6 +510,9 @@ binder_netreg_scan_free(
         if (scan->timeout_id) {
             g_source_remove(scan->timeout_id);
         }
+        if (scan->settle_id) {
+            g_source_remove(scan->settle_id);
+        }
         if (scan->stop) {
             RadioRequest* req = radio_request_new(self->client,
                 RADIO_REQ_STOP_NETWORK_SCAN, NULL, NULL, NULL, NULL);
@@ -426,23 +533,26 @@ binder_netreg_scan_complete(
     BinderNetRegScan* scan)
 {
     if (scan) {
+        BinderOpList* oplist = scan->oplist;
+
+        scan->oplist = NULL;
+        if (oplist) {
+            binder_netreg_process_operators(self, oplist);
+            binder_netreg_oplist_cache_update(self, oplist);
+        }
         if (scan->cb) {
             struct ofono_error ok;
             ofono_netreg_operator_list_cb_t cb = scan->cb;
 
             scan->cb = NULL;
             binder_error_init_ok(&ok);
-            if (scan->oplist) {
-                BinderOpList* oplist = scan->oplist;
-
-                scan->oplist = NULL;
-                binder_netreg_process_operators(self, oplist);
+            if (oplist) {
                 cb(&ok, oplist->count, oplist->op, scan->data);
-                binder_oplist_free(oplist);
             } else {
                 cb(&ok, 0, NULL, scan->data);
             }
         }
+        binder_oplist_free(oplist);
         binder_netreg_scan_free(self, scan);
     }
 }
@@ -470,10 +580,13 @@ binder_netreg_oplist_fill(
     guint i;
 
     /* This allocates the list if necessary */
-    oplist = binder_oplist_set_count(oplist, count);
+    oplist = binder_oplist_reserve(oplist, count);
     for (i = 0; i < count; i++) {
         const RadioOperatorInfo* src = ops + i;
-        struct ofono_network_operator* dest = oplist->op + i;
+        struct ofono_network_operator op;
+        struct ofono_network_operator* dest = &op;
+
+        memset(dest, 0, sizeof(*dest));
 
         /* Try to use long by default */
         if (src->alphaLong.len) {
@@ -504,6 +617,7 @@ binder_netreg_oplist_fill(
             dest->name, dest->mcc, dest->mnc,
             binder_ofono_access_technology_string(dest->tech),
             binder_radio_op_status_string(src->status));
+        oplist = binder_oplist_add(oplist, dest);
     }
 
     return oplist;
@@ -525,6 +639,23 @@ binder_netreg_scan_timeoult_cb(
     return G_SOURCE_REMOVE;
 }
 
+static
+gboolean
+binder_netreg_scan_settle_cb(
+    gpointer user_data)
+{
+    BinderNetReg* self = user_data;
+    BinderNetRegScan* scan = self->scan;
+
+    /* Timer gets cancelled when scan is done, no need to check for NULL */
+    scan->settle_id = 0;
+    self->scan = NULL;
+    DBG_(self, "no new operators for %d ms, %u total",
+        self->network_scan_settle_ms, scan->oplist->count);
+    binder_netreg_scan_complete(self, scan);
+    return G_SOURCE_REMOVE;
+}
+
 static
 void
 binder_netreg_start_scan_cb(
@@ -839,10 +970,32 @@ binder_netreg_list_operators(
     void* data)
 {
     BinderNetReg* self = binder_netreg_get_data(netreg);
-    BinderNetRegScan* scan = binder_netreg_scan_new(cb, data);
+    const BinderOpList* cached = binder_netreg_oplist_cache_lookup(self);
+    BinderNetRegScan* scan;
 
-    /* Drop the pending request if there is one */
-    binder_netreg_scan_drop(self, self->scan);
+    if (cached) {
+        struct ofono_error ok;
+
+        DBG_(self, "%u cached operators", cached->count);
+        cb(binder_error_ok(&ok), cached->count, cached->op, data);
+        if (self->scan) {
+            /* Something is already in progress */
+            return;
+        }
+
+        /* Refresh the list in the background */
+        scan = binder_netreg_scan_new(NULL, NULL);
+    } else if (self->scan && !self->scan->cb) {
+        /* Let the background scan deliver the results */
+        DBG_(self, "waiting for the background scan");
+        self->scan->cb = cb;
+        self->scan->data = data;
+        return;
+    } else {
+        scan = binder_netreg_scan_new(cb, data);
+        /* Drop the pending request if there is one */
+        binder_netreg_scan_drop(self, self->scan);
+    }
     self->scan = scan;
 
     /*
@@ -889,13 +1042,25 @@ binder_netreg_scan_op_copy_name(
     }
 }
 
+static
+void
+binder_netreg_scan_op_add(
+    BinderNetRegScan* scan,
+    const struct ofono_network_operator* op)
+{
+    /* The same operator is reported for every cell it has been seen on */
+    scan->oplist = binder_oplist_add(scan->oplist, op);
+}
+
 static
 void
 binder_netreg_scan_op_convert_gsm(
+    BinderNetRegScan* scan,
     gboolean registered,
-    const RadioCellIdentityGsm_1_2* src,
-    struct ofono_network_operator* dest)
+    const RadioCellIdentityGsm_1_2* src)
 {
+    struct ofono_network_operator op;
+    struct ofono_network_operator* dest = &op;
     const RadioCellIdentityGsm* gsm = &src->base;
 
     memset(dest, 0, sizeof(*dest));
@@ -910,15 +1075,18 @@ binder_netreg_scan_op_convert_gsm(
         registered, dest->name, dest->mcc, dest->mnc,
         binder_ofono_access_technology_string(dest->tech),
         binder_radio_op_status_string(dest->status));
+    binder_netreg_scan_op_add(scan, dest);
 }
 
 static
 void
 binder_netreg_scan_op_convert_wcdma(
+    BinderNetRegScan* scan,
     gboolean registered,
-    const RadioCellIdentityWcdma_1_2* src,
-    struct ofono_network_operator* dest)
+    const RadioCellIdentityWcdma_1_2* src)
 {
+    struct ofono_network_operator op;
+    struct ofono_network_operator* dest = &op;
     const RadioCellIdentityWcdma* wcdma = &src->base;
 
     memset(dest, 0, sizeof(*dest));
@@ -933,15 +1101,18 @@ binder_netreg_scan_op_convert_wcdma(
         registered, dest->name, dest->mcc, dest->mnc,
         binder_ofono_access_technology_string(dest->tech),
         binder_radio_op_status_string(dest->status));
+    binder_netreg_scan_op_add(scan, dest);
 }
 
 static
 void
 binder_netreg_scan_op_convert_lte(
+    BinderNetRegScan* scan,
     gboolean registered,
-    const RadioCellIdentityLte_1_2* src,
-    struct ofono_network_operator* dest)
+    const RadioCellIdentityLte_1_2* src)
 {
+    struct ofono_network_operator op;
+    struct ofono_network_operator* dest = &op;
     const RadioCellIdentityLte* lte = &src->base;
 
     memset(dest, 0, sizeof(*dest));
@@ -956,15 +1127,18 @@ binder_netreg_scan_op_convert_lte(
         registered, dest->name, dest->mcc, dest->mnc,
         binder_ofono_access_technology_string(dest->tech),
         binder_radio_op_status_string(dest->status));
+    binder_netreg_scan_op_add(scan, dest);
 }
 
 static
 void
 binder_netreg_scan_op_convert_nr(
+    BinderNetRegScan* scan,
     gboolean registered,
-    const RadioCellIdentityNr* src,
-    struct ofono_network_operator* dest)
+    const RadioCellIdentityNr* src)
 {
+    struct ofono_network_operator op;
+    struct ofono_network_operator* dest = &op;
     const RadioCellIdentityNr* nr = src;
 
     memset(dest, 0, sizeof(*dest));
@@ -979,21 +1153,7 @@ binder_netreg_scan_op_convert_nr(
         registered, dest->name, dest->mcc, dest->mnc,
         binder_ofono_access_technology_string(dest->tech),
         binder_radio_op_status_string(dest->status));
-}
-
-static
-struct ofono_network_operator*
-binder_netreg_scan_op_append(
-    BinderNetRegScan* scan)
-{
-    const guint i = scan->oplist ? scan->oplist->count : 0;
-
-    /*
-     * Return a pointer to the newly allocated zero-initialized struct
-     * ofono_network_operator
-     */
-    scan->oplist = binder_oplist_set_count(scan->oplist, i + 1);
-    return scan->oplist->op + i;
+    binder_netreg_scan_op_add(scan, dest);
 }
 
 static
@@ -1022,9 +1182,12 @@ binder_netreg_scan_result_notify(
         if (result) {
             guint i;
             const guint n = result->networkInfos.count;
+            const guint count = scan->oplist ? scan->oplist->count : 0;
 
             DBG_(self, "status=%d, error=%d, %u networks", result->status,
                 result->error, n);
+            /* Usually there's one operator per cell */
+            scan->oplist = binder_oplist_reserve(scan->oplist, n);
             if (code == RADIO_IND_NETWORK_SCAN_RESULT_1_2) {
                 const RadioCellInfo_1_2* cells = result->networkInfos.data.ptr;
 
@@ -1036,19 +1199,16 @@ binder_netreg_scan_result_notify(
                     guint j;
 
                     for (j = 0; j < cell->gsm.count; j++) {
-                        binder_netreg_scan_op_convert_gsm(cell->registered,
-                            &gsm[j].cellIdentityGsm,
-                            binder_netreg_scan_op_append(scan));
+                        binder_netreg_scan_op_convert_gsm(scan,
+                            cell->registered, &gsm[j].cellIdentityGsm);
                     }
                     for (j = 0; j < cell->wcdma.count; j++) {
-                        binder_netreg_scan_op_convert_wcdma(cell->registered,
-                            &wcdma[j].cellIdentityWcdma,
-                            binder_netreg_scan_op_append(scan));
+                        binder_netreg_scan_op_convert_wcdma(scan,
+                            cell->registered, &wcdma[j].cellIdentityWcdma);
                     }
                     for (j = 0; j < cell->lte.count; j++) {
-                        binder_netreg_scan_op_convert_lte(cell->registered,
-                            &lte[j].cellIdentityLte,
-                            binder_netreg_scan_op_append(scan));
+                        binder_netreg_scan_op_convert_lte(scan,
+                            cell->registered, &lte[j].cellIdentityLte);
                     }
                 }
             } else if (code == RADIO_IND_NETWORK_SCAN_RESULT_1_4) {
@@ -1059,24 +1219,22 @@ binder_netreg_scan_result_notify(
 
                     switch ((RADIO_CELL_INFO_TYPE_1_4)cell->cellInfoType) {
                     case RADIO_CELL_INFO_1_4_GSM:
-                        binder_netreg_scan_op_convert_gsm(cell->registered,
-                            &cell->info.gsm.cellIdentityGsm,
-                            binder_netreg_scan_op_append(scan));
+                        binder_netreg_scan_op_convert_gsm(scan,
+                            cell->registered, &cell->info.gsm.cellIdentityGsm);
                         break;
                     case RADIO_CELL_INFO_1_4_WCDMA:
-                        binder_netreg_scan_op_convert_wcdma(cell->registered,
-                            &cell->info.wcdma.cellIdentityWcdma,
-                            binder_netreg_scan_op_append(scan));
+                        binder_netreg_scan_op_convert_wcdma(scan,
+                            cell->registered,
+                            &cell->info.wcdma.cellIdentityWcdma);
                         break;
                     case RADIO_CELL_INFO_1_4_LTE:
-                        binder_netreg_scan_op_convert_lte(cell->registered,
-                            &cell->info.lte.base.cellIdentityLte,
-                            binder_netreg_scan_op_append(scan));
+                        binder_netreg_scan_op_convert_lte(scan,
+                            cell->registered,
+                            &cell->info.lte.base.cellIdentityLte);
                         break;
                     case RADIO_CELL_INFO_1_4_NR:
-                        binder_netreg_scan_op_convert_nr(cell->registered,
-                            &cell->info.nr.cellIdentity,
-                            binder_netreg_scan_op_append(scan));
+                        binder_netreg_scan_op_convert_nr(scan,
+                            cell->registered, &cell->info.nr.cellIdentity);
                         break;
                     case RADIO_CELL_INFO_1_4_CDMA:
                     case RADIO_CELL_INFO_1_4_TD_SCDMA:
@@ -1091,24 +1249,24 @@ binder_netreg_scan_result_notify(
 
                     switch ((RADIO_CELL_INFO_TYPE_1_5)cell->cellInfoType) {
                     case RADIO_CELL_INFO_1_5_GSM:
-                        binder_netreg_scan_op_convert_gsm(cell->registered,
-                            &cell->info.gsm.cellIdentityGsm.base,
-                            binder_netreg_scan_op_append(scan));
+                        binder_netreg_scan_op_convert_gsm(scan,
+                            cell->registered,
+                            &cell->info.gsm.cellIdentityGsm.base);
                         break;
                     case RADIO_CELL_INFO_1_5_WCDMA:
-                        binder_netreg_scan_op_convert_wcdma(cell->registered,
-                            &cell->info.wcdma.cellIdentityWcdma.base,
-                            binder_netreg_scan_op_append(scan));
+                        binder_netreg_scan_op_convert_wcdma(scan,
+                            cell->registered,
+                            &cell->info.wcdma.cellIdentityWcdma.base);
                         break;
                     case RADIO_CELL_INFO_1_5_LTE:
-                        binder_netreg_scan_op_convert_lte(cell->registered,
-                            &cell->info.lte.cellIdentityLte.base,
-                            binder_netreg_scan_op_append(scan));
+                        binder_netreg_scan_op_convert_lte(scan,
+                            cell->registered,
+                            &cell->info.lte.cellIdentityLte.base);
                         break;
                     case RADIO_CELL_INFO_1_5_NR:
-                        binder_netreg_scan_op_convert_nr(cell->registered,
-                            &cell->info.nr.cellIdentityNr.base,
-                            binder_netreg_scan_op_append(scan));
+                        binder_netreg_scan_op_convert_nr(scan,
+                            cell->registered,
+                            &cell->info.nr.cellIdentityNr.base);
                         break;
                     case RADIO_CELL_INFO_1_5_CDMA:
                     case RADIO_CELL_INFO_1_5_TD_SCDMA:
@@ -1123,6 +1281,16 @@ binder_netreg_scan_result_notify(
                 binder_netreg_scan_complete(self, scan);
             } else {
                 DBG_(self, "expecting more scan results");
+                if (self->network_scan_settle_ms > 0 && scan->oplist &&
+                    scan->oplist->count > count) {
+                    /* Restart the timer whenever something new shows up */
+                    if (scan->settle_id) {
+                        g_source_remove(scan->settle_id);
+                    }
+                    scan->settle_id = g_timeout_add
+                        (self->network_scan_settle_ms,
+                        binder_netreg_scan_settle_cb, self);
+                }
             }
         } else {
             DBG_(self, "failed to parse scan result");
@@ -1468,6 +1636,59 @@ binder_netreg_percent_from_dbm(
         (100 * (dbm - min_dbm) / (max_dbm - min_dbm));
 }
 
+static
+void
+binder_netreg_strength_report(
+    BinderNetReg* self,
+    int percent)
+{
+    self->strength_percent = percent;
+    ofono_netreg_strength_notify(self->netreg, percent);
+}
+
+static
+gboolean
+binder_netreg_strength_window_cb(
+    gpointer user_data)
+{
+    BinderNetReg* self = user_data;
+
+    self->strength_window_id = 0;
+    if (self->strength_pending != self->strength_percent) {
+        DBG_(self, "%d%% (%u merged, %u dropped)", self->strength_pending,
+            self->strength_merged, self->strength_dropped);
+        binder_netreg_strength_report(self, self->strength_pending);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * The first change is reported immediately and opens the window.
+ * Whatever arrives within the window only updates the pending value
+ * which gets reported (if it's different) when the window closes.
+ */
+static
+void
+binder_netreg_strength_update(
+    BinderNetReg* self,
+    int percent)
+{
+    if (self->strength_window_id) {
+        self->strength_pending = percent;
+        self->strength_merged++;
+    } else if (percent == self->strength_percent) {
+        self->strength_dropped++;
+    } else {
+        binder_netreg_strength_report(self, percent);
+        if (self->signal_strength_window_ms > 0) {
+            self->strength_pending = percent;
+            self->strength_window_id =
+                g_timeout_add(self->signal_strength_window_ms,
+                    binder_netreg_strength_window_cb, self);
+        }
+    }
+}
+
 static
 void
 binder_netreg_strength_notify(
@@ -1511,7 +1732,7 @@ binder_netreg_strength_notify(
         const int percent = binder_netreg_percent_from_dbm(self, dbm);
 
         DBG_(self, "%d dBm (%d%%)", dbm, percent);
-        ofono_netreg_strength_notify(self->netreg, percent);
+        binder_netreg_strength_update(self, percent);
     }
 }
 
@@ -1528,9 +1749,8 @@ static void binder_netreg_strength_cb(
     ofono_netreg_strength_cb_t cb = cbd->cb.strength;
     struct ofono_error err;
 
-    GASSERT(self->strength_req == req);
-    radio_request_unref(self->strength_req);
-    self->strength_req = NULL;
+    GASSERT(self->strength_call_id);
+    self->strength_call_id = 0;
 
     if (status == RADIO_TX_STATUS_OK) {
         if (error == RADIO_ERROR_NONE) {
@@ -1574,6 +1794,7 @@ static void binder_netreg_strength_cb(
 
                 /* Success */
                 DBG_(self, "%d dBm (%d%%)", dbm, percent);
+                self->strength_percent = percent;
                 cb(binder_error_ok(&err), percent, cbd->data);
                 return;
             }
@@ -1595,22 +1816,20 @@ binder_netreg_strength(
     void* data)
 {
     BinderNetReg* self = binder_netreg_get_data(netreg);
-    RadioRequest* req = radio_request_new(self->client,
+    BinderNetRegCbData* cbd = binder_netreg_cbd_new(self, BINDER_CB(cb), data);
+    const gulong prev_id = self->strength_call_id;
+
+    /* Joins the query which is already in flight, if there is one */
+    self->strength_call_id = binder_req_share_submit(self->share,
         (radio_client_interface(self->client) >= RADIO_INTERFACE_1_4) ?
         RADIO_REQ_GET_SIGNAL_STRENGTH_1_4 : RADIO_REQ_GET_SIGNAL_STRENGTH,
-        NULL, binder_netreg_strength_cb, binder_netreg_cbd_destroy,
-        binder_netreg_cbd_new(self, BINDER_CB(cb), data));
-
-    radio_request_set_retry(req, BINDER_RETRY_MS, -1);
-    radio_request_drop(self->strength_req);
-    if (radio_request_submit(req)) {
-        self->strength_req = req; /* Keep the ref */
-    } else {
+        NULL, 0, 0, binder_netreg_strength_cb, binder_netreg_cbd_destroy, cbd);
+    binder_req_share_cancel(self->share, prev_id);
+    if (!self->strength_call_id) {
         struct ofono_error err;
 
         DBG_(self, "failed to query signal strength");
-        radio_request_unref(req);
-        self->strength_req = NULL;
+        binder_netreg_cbd_free(cbd);
         cb(binder_error_failure(&err), -1, data);
     }
 }
@@ -1679,9 +1898,9 @@ binder_netreg_modem_reset_notify(
 
     /* Drop pending requests */
     radio_request_drop(self->register_req);
-    radio_request_drop(self->strength_req);
+    binder_req_share_cancel(self->share, self->strength_call_id);
     self->register_req = NULL;
-    self->strength_req = NULL;
+    self->strength_call_id = 0;
 
     /* And complete the scan (successfully if there were any results) */
     if (self->scan) {
@@ -1696,6 +1915,167 @@ binder_netreg_modem_reset_notify(
     }
 }
 
+static
+void
+binder_netreg_signal_criteria_cb(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    if (status == RADIO_TX_STATUS_OK) {
+        if (resp == RADIO_RESP_SET_SIGNAL_STRENGTH_REPORTING_CRITERIA ||
+            resp == RADIO_RESP_SET_SIGNAL_STRENGTH_REPORTING_CRITERIA_1_5) {
+            if (error != RADIO_ERROR_NONE) {
+                /* Not fatal, the modem keeps its own criteria */
+                DBG("setSignalStrengthReportingCriteria error %s",
+                    binder_radio_error_string(error));
+            }
+        } else {
+            ofono_error("Unexpected setSignalStrengthReportingCriteria"
+                " response %d", resp);
+        }
+    }
+}
+
+static
+void
+binder_netreg_signal_criteria_submit(
+    BinderNetReg* self,
+    RadioRequest* req,
+    const BinderNetRegRadioType* type)
+{
+    if (!radio_request_submit(req)) {
+        DBG_(self, "failed to set signal criteria for ran %d", type->ran);
+    }
+    radio_request_unref(req);
+}
+
+static
+void
+binder_netreg_set_signal_criteria(
+    BinderNetReg* self)
+{
+    const RADIO_INTERFACE iface = radio_client_interface(self->client);
+    const int n = self->signal_strength_thresholds;
+    const int weak = self->signal_strength_dbm_weak;
+    const int range = self->signal_strength_dbm_strong - weak;
+    const int step = range / (n + 1);
+    const gint32 hysteresis_db = MAX(MIN(SIGNAL_HYSTERESIS_DB, step - 1), 0);
+    gint32 thresholds[SIGNAL_THRESHOLDS_MAX];
+    guint i;
+
+    if (n <= 0 || iface < RADIO_INTERFACE_1_2) {
+        return;
+    }
+
+    /*
+     * Spread the thresholds evenly over signalStrengthRange so that
+     * the modem only wakes us up when the signal moves to another
+     * band rather than on every dB of fluctuation.
+     */
+    GASSERT(n <= SIGNAL_THRESHOLDS_MAX);
+    for (i = 0; i < (guint) n; i++) {
+        thresholds[i] = weak + range * (i + 1) / (n + 1);
+    }
+
+    DBG_(self, "%d thresholds in [%d,%d], hysteresis %d dB, %d ms", n,
+        weak, self->signal_strength_dbm_strong, hysteresis_db,
+        self->signal_strength_window_ms);
+
+    if (iface < RADIO_INTERFACE_1_5) {
+        for (i = 0; i < N_RADIO_TYPES; i++) {
+            const BinderNetRegRadioType* type = binder_netreg_radio_types + i;
+            GBinderWriter writer;
+            RadioRequest* req;
+
+            if (!(self->techs & type->mode)) {
+                continue;
+            }
+
+            /*
+             * setSignalStrengthReportingCriteria(int32 serial,
+             *     int32 hysteresisMs, int32 hysteresisDb,
+             *     vec<int32> thresholdsDbm, AccessNetwork accessNetwork);
+             */
+            req = radio_request_new(self->client,
+                RADIO_REQ_SET_SIGNAL_STRENGTH_REPORTING_CRITERIA, &writer,
+                binder_netreg_signal_criteria_cb, NULL, NULL);
+            gbinder_writer_append_int32(&writer,
+                self->signal_strength_window_ms);
+            gbinder_writer_append_int32(&writer, hysteresis_db);
+            gbinder_writer_append_hidl_vec(&writer, thresholds, n,
+                sizeof(thresholds[0]));
+            gbinder_writer_append_int32(&writer, type->ran);
+            binder_netreg_signal_criteria_submit(self, req, type);
+        }
+    } else {
+        /*
+         * typedef struct radio_signal_threshold_info {
+         *     gint32 signalMeasurement;
+         *     gint32 hysteresisMs;
+         *     gint32 hysteresisDb;
+         *     GBinderHidlVec thresholds; // vec<int32_t>
+         *     guint8 isEnabled;
+         * } RadioSignalThresholdInfo_1_5;
+         */
+        typedef struct radio_signal_threshold_info {
+            gint32 signalMeasurement;
+            gint32 hysteresisMs;
+            gint32 hysteresisDb;
+            GBinderHidlVec thresholds;
+            guint8 isEnabled;
+        } RadioSignalThresholdInfo_1_5;
+        G_STATIC_ASSERT(sizeof(RadioSignalThresholdInfo_1_5) == 40);
+
+        static const GBinderWriterField radio_signal_threshold_info_f[] = {
+            GBINDER_WRITER_FIELD_HIDL_VEC_INT32
+                (RadioSignalThresholdInfo_1_5, thresholds),
+            GBINDER_WRITER_FIELD_END()
+        };
+        static const GBinderWriterType radio_signal_threshold_info_t = {
+            GBINDER_WRITER_STRUCT_NAME_AND_SIZE(RadioSignalThresholdInfo_1_5),
+            radio_signal_threshold_info_f
+        };
+
+        for (i = 0; i < N_RADIO_TYPES_1_5; i++) {
+            const BinderNetRegRadioType* type =
+                binder_netreg_radio_types_1_5 + i;
+            RadioSignalThresholdInfo_1_5* info;
+            GBinderWriter writer;
+            RadioRequest* req;
+
+            if (!(self->techs & type->mode)) {
+                continue;
+            }
+
+            /*
+             * setSignalStrengthReportingCriteria_1_5(int32 serial,
+             *     SignalThresholdInfo signalThresholdInfo,
+             *     AccessNetwork accessNetwork);
+             */
+            req = radio_request_new(self->client,
+                RADIO_REQ_SET_SIGNAL_STRENGTH_REPORTING_CRITERIA_1_5, &writer,
+                binder_netreg_signal_criteria_cb, NULL, NULL);
+            info = gbinder_writer_new0(&writer, RadioSignalThresholdInfo_1_5);
+            info->signalMeasurement = type->measurement;
+            info->hysteresisMs = self->signal_strength_window_ms;
+            info->hysteresisDb = hysteresis_db;
+            info->thresholds.count = n;
+            info->thresholds.owns_buffer = TRUE;
+            info->thresholds.data.ptr = gbinder_writer_memdup(&writer,
+                thresholds, n * sizeof(thresholds[0]));
+            info->isEnabled = TRUE;
+            gbinder_writer_append_struct(&writer, info,
+                &radio_signal_threshold_info_t, NULL);
+            gbinder_writer_append_int32(&writer, type->ran);
+            binder_netreg_signal_criteria_submit(self, req, type);
+        }
+    }
+}
+
 static
 gboolean
 binder_netreg_register(
@@ -1756,6 +2136,9 @@ binder_netreg_register(
         radio_client_add_indication_handler(self->client,
             RADIO_IND_MODEM_RESET,
             binder_netreg_modem_reset_notify, self);
+
+    /* Let the modem filter insignificant signal strength changes */
+    binder_netreg_set_signal_criteria(self);
     return G_SOURCE_REMOVE;
 }
 
@@ -1774,6 +2157,7 @@ binder_netreg_probe(
 
     DBG_(self, "%p", netreg);
     self->client = radio_client_ref(modem->client);
+    self->share = binder_req_share_new(modem->client, modem->log_prefix);
     self->watch = ofono_watch_new(binder_modem_get_path(modem));
     self->network = binder_network_ref(modem->network);
     self->netreg = netreg;
@@ -1782,7 +2166,12 @@ binder_netreg_probe(
     self->replace_strange_oper = config->replace_strange_oper;
     self->signal_strength_dbm_weak = config->signal_strength_dbm_weak;
     self->signal_strength_dbm_strong = config->signal_strength_dbm_strong;
+    self->signal_strength_window_ms = config->signal_strength_window_ms;
+    self->signal_strength_thresholds = config->signal_strength_thresholds;
     self->network_selection_timeout_ms = config->network_selection_timeout_ms;
+    self->network_scan_settle_ms = config->network_scan_settle_ms;
+    self->operator_list_cache_ms = config->operator_list_cache_ms;
+    self->strength_percent = -1;
 
     ofono_netreg_set_data(netreg, self);
     self->init_id = g_idle_add(binder_netreg_register, self);
@@ -1810,8 +2199,15 @@ binder_netreg_remove(
         g_source_remove(self->current_operator_id);
     }
 
+    if (self->strength_window_id) {
+        g_source_remove(self->strength_window_id);
+    }
+
+    DBG_(self, "signal strength: %u merged, %u dropped",
+        self->strength_merged, self->strength_dropped);
     radio_request_drop(self->register_req);
-    radio_request_drop(self->strength_req);
+    binder_req_share_cancel(self->share, self->strength_call_id);
+    binder_req_share_unref(self->share);
 
     ofono_watch_unref(self->watch);
     binder_network_remove_all_handlers(self->network, self->network_event_id);
@@ -1821,6 +2217,7 @@ binder_netreg_remove(
     radio_client_unref(self->client);
 
     binder_netreg_scan_drop(self, self->scan);
+    binder_netreg_oplist_cache_clear(self);
     g_free(self->log_prefix);
     g_free(self);
 
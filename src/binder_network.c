@@ -19,15 +19,18 @@
 #include "binder_network.h"
 #include "binder_radio.h"
 #include "binder_radio_caps.h"
+#include "binder_req_share.h"
 #include "binder_sim_card.h"
 #include "binder_sim_settings.h"
 #include "binder_util.h"
+#include "binder_wakeup.h"
 
 #include <ofono/netreg.h>
 #include <ofono/watch.h>
 #include <ofono/misc.h>
 #include <ofono/gprs.h>
 #include <ofono/log.h>
+#include <ofono/storage.h>
 
 #include <radio_client.h>
 #include <radio_request.h>
@@ -40,12 +43,31 @@
 #include <gutil_misc.h>
 
 #define SET_PREF_MODE_HOLDOFF_SEC BINDER_RETRY_SECS
+/* Inputs must stay unchanged this long before the pref mode is set */
+#define SET_PREF_MODE_SETTLE_MS (250)
 #define INTINITE_TIMEOUT UINT_MAX
 #define MAX_DATA_CALLS 16
 
+/* Last known state, per IMSI */
+#define NETWORK_CACHE_FILE "binder-network"
+#define NETWORK_CACHE_PREF_MODES "PrefModes"
+#define NETWORK_CACHE_DATA_PROFILES "DataProfiles"
+#define NETWORK_CACHE_ATTACH_APN "InitialAttachApn"
+
+/* Polled state younger than this is served without querying the modem */
+#define POLL_STATE_TTL_MS (5000)
+
+typedef enum binder_network_poll {
+    POLL_OPERATOR,
+    POLL_VOICE,
+    POLL_DATA,
+    POLL_COUNT
+} BINDER_NETWORK_POLL;
+
 typedef enum binder_network_timer {
     TIMER_SET_RAT_HOLDOFF,
     TIMER_FORCE_CHECK_PREF_MODE,
+    TIMER_RECONCILE_PREF_MODE,
     TIMER_COUNT
 } BINDER_NETWORK_TIMER;
 
@@ -62,15 +84,24 @@ enum binder_network_radio_caps_mgr_events {
 };
 
 enum binder_network_sim_events {
-    SIM_EVENT_STATUS_CHANGED,
+    SIM_EVENT_STATE_CHANGED,
+    SIM_EVENT_APP_CHANGED,
     SIM_EVENT_IO_ACTIVE_CHANGED,
     SIM_EVENT_COUNT
 };
 
+enum binder_network_settings_events {
+    SETTINGS_EVENT_PREF,
+    SETTINGS_EVENT_IMSI,
+    SETTINGS_EVENT_COUNT
+};
+
 enum binder_network_ind_events {
     IND_NETWORK_STATE,
     IND_MODEM_RESET,
+    IND_CURRENT_PHYSICAL_CHANNEL_CONFIGS,
     IND_CURRENT_PHYSICAL_CHANNEL_CONFIGS_1_4,
+    IND_CURRENT_LINK_CAPACITY_ESTIMATE,
     IND_COUNT
 };
 
@@ -80,6 +111,63 @@ enum binder_network_watch_event {
     WATCH_EVENT_COUNT
 };
 
+/*
+ * Requests whose code (or flavor) depends on the IRadio version. The
+ * entry is picked once when the object is created, newer interfaces
+ * inherit everything from the older ones unless stated otherwise.
+ */
+typedef struct binder_network_iface {
+    RADIO_INTERFACE version;
+    RADIO_REQ get_data_reg_state;
+    RADIO_REQ set_lce_criteria;     /* RADIO_REQ_NONE if unsupported */
+    gboolean pref_net_type_bitmap;  /* get/setPreferredNetworkTypeBitmap */
+    gboolean ngran;                 /* AccessNetwork includes NGRAN */
+} BinderNetworkIface;
+
+static const BinderNetworkIface binder_network_ifaces[] = {
+    {
+        RADIO_INTERFACE_1_0,
+        RADIO_REQ_GET_DATA_REGISTRATION_STATE,
+        RADIO_REQ_NONE,
+        FALSE,
+        FALSE
+    },{
+        RADIO_INTERFACE_1_2,
+        RADIO_REQ_GET_DATA_REGISTRATION_STATE,
+        RADIO_REQ_SET_LINK_CAPACITY_REPORTING_CRITERIA,
+        FALSE,
+        FALSE
+    },{
+        RADIO_INTERFACE_1_4,
+        RADIO_REQ_GET_DATA_REGISTRATION_STATE,
+        RADIO_REQ_SET_LINK_CAPACITY_REPORTING_CRITERIA,
+        TRUE,
+        FALSE
+    },{
+        RADIO_INTERFACE_1_5,
+        RADIO_REQ_GET_DATA_REGISTRATION_STATE_1_5,
+        RADIO_REQ_SET_LINK_CAPACITY_REPORTING_CRITERIA_1_5,
+        TRUE,
+        TRUE
+    }
+};
+
+static
+const BinderNetworkIface*
+binder_network_iface(
+    RADIO_INTERFACE version)
+{
+    const BinderNetworkIface* iface = binder_network_ifaces;
+    guint i;
+
+    for (i = 1; i < G_N_ELEMENTS(binder_network_ifaces); i++) {
+        if (binder_network_ifaces[i].version <= version) {
+            iface = binder_network_ifaces + i;
+        }
+    }
+    return iface;
+}
+
 typedef struct binder_network_location {
     int lac;
     int ci;
@@ -103,6 +191,7 @@ typedef struct binder_network_object {
     BinderBase base;
     BinderNetwork pub;
     RadioRequestGroup* g;
+    const BinderNetworkIface* iface;
     BinderRadio* radio;
     BinderRadioCaps* caps;
     BinderSimCard* simcard;
@@ -117,13 +206,16 @@ typedef struct binder_network_object {
     RadioRequest* operator_poll_req;
     RadioRequest* voice_poll_req;
     RadioRequest* data_poll_req;
-    RadioRequest* query_rat_req;
+    gint64 poll_time[POLL_COUNT];
+    gulong query_rat_call_id;
+    gulong initial_rat_call_id;
     RadioRequest* set_rat_req;
     RadioRequest* set_data_profiles_req;
     RadioRequest* set_ia_apn_req;
+    BinderReqShare* share;
     guint timer[TIMER_COUNT];
     gulong ind_id[IND_COUNT];
-    gulong settings_event_id;
+    gulong settings_event_id[SETTINGS_EVENT_COUNT];
     gulong caps_raf_event_id;
     gulong caps_mgr_event_id[RADIO_CAPS_MGR_EVENT_COUNT];
     gulong radio_event_id[RADIO_EVENT_COUNT];
@@ -133,9 +225,23 @@ typedef struct binder_network_object {
     gboolean set_initial_attach_apn;
     struct ofono_network_operator operator;
     gboolean assert_rat;
+    gboolean pref_queried;
+    gboolean reconcile_immediate;
+    gboolean reconcile_needed;
+    guint pref_requests_sent;
+    guint pref_requests_avoided;
     gboolean force_gsm_when_radio_off;
+    enum ofono_radio_access_mode techs;
+    BinderLceConfig lce_config;
     BinderDataProfileConfig data_profile_config;
     GSList* data_profiles;
+    guint data_profiles_hash;
+    gboolean data_profiles_hash_known;
+    gboolean data_profiles_reset; /* Don't trust the cache */
+    guint ia_apn_hash;
+    guint ia_apn_pending_hash;
+    gboolean ia_apn_hash_known;
+    gboolean ia_apn_replay; /* The modem has been reset */
 } BinderNetworkObject;
 
 typedef BinderBaseClass BinderNetworkObjectClass;
@@ -190,6 +296,79 @@ binder_network_stop_timer(
     }
 }
 
+static
+char*
+binder_network_cache_path()
+{
+    return g_build_filename(ofono_storage_dir(), NETWORK_CACHE_FILE, NULL);
+}
+
+static
+gboolean
+binder_network_cache_get(
+    BinderNetworkObject* self,
+    const char* key,
+    int* value)
+{
+    const char* imsi = self->pub.settings->imsi;
+    gboolean found = FALSE;
+
+    if (imsi) {
+        GKeyFile* keyfile = g_key_file_new();
+        char* path = binder_network_cache_path();
+
+        if (g_key_file_load_from_file(keyfile, path, 0, NULL)) {
+            GError* error = NULL;
+
+            *value = g_key_file_get_integer(keyfile, imsi, key, &error);
+            if (error) {
+                g_error_free(error);
+            } else {
+                found = TRUE;
+            }
+        }
+        g_key_file_unref(keyfile);
+        g_free(path);
+    }
+    return found;
+}
+
+static
+void
+binder_network_cache_set(
+    BinderNetworkObject* self,
+    const char* key,
+    int value)
+{
+    const char* imsi = self->pub.settings->imsi;
+
+    if (imsi) {
+        GKeyFile* keyfile = g_key_file_new();
+        char* path = binder_network_cache_path();
+        GError* error = NULL;
+
+        g_key_file_load_from_file(keyfile, path, 0, NULL);
+
+        /* Don't touch the file unless something has changed */
+        if (g_key_file_get_integer(keyfile, imsi, key, &error) != value ||
+            error) {
+            GError* save_error = NULL;
+
+            g_key_file_set_integer(keyfile, imsi, key, value);
+            if (!g_key_file_save_to_file(keyfile, path, &save_error)) {
+                ofono_warn("Failed to save %s: %s", path,
+                    save_error->message);
+                g_error_free(save_error);
+            }
+        }
+        if (error) {
+            g_error_free(error);
+        }
+        g_key_file_unref(keyfile);
+        g_free(path);
+    }
+}
+
 static
 void
 binder_network_reset_state(
@@ -246,13 +425,18 @@ binder_network_poll_operator_ok(
      * getOperatorResponse(RadioResponseInfo, string longName,
      *     string shortName, string numeric);
      */
-    const char* lalpha = gbinder_reader_read_hidl_string_c(reader);
-    const char* salpha = gbinder_reader_read_hidl_string_c(reader);
-    const char* numeric = gbinder_reader_read_hidl_string_c(reader);
+    gsize llen, slen;
+    const char* lalpha = binder_hidl_string_view
+        (gbinder_reader_read_hidl_struct(reader, GBinderHidlString), &llen);
+    const char* salpha = binder_hidl_string_view
+        (gbinder_reader_read_hidl_struct(reader, GBinderHidlString), &slen);
+    const char* numeric = binder_hidl_string_view
+        (gbinder_reader_read_hidl_struct(reader, GBinderHidlString), NULL);
     BinderNetwork* net = &self->pub;
     struct ofono_network_operator op;
     gboolean changed = FALSE;
 
+    /* The strings are borrowed from the parcel, nothing is copied */
     memset(&op, 0, sizeof(op));
     op.tech = OFONO_ACCESS_TECHNOLOGY_NONE;
     if (binder_parse_mcc_mnc(numeric, &op)) {
@@ -260,10 +444,10 @@ binder_network_poll_operator_ok(
             op.tech = net->voice.access_tech;
         }
         op.status = OFONO_OPERATOR_STATUS_CURRENT;
-        if (lalpha) {
-            g_strlcpy(op.name, lalpha, sizeof(op.name));
-        } else if (salpha) {
-            g_strlcpy(op.name, salpha, sizeof(op.name));
+        if (llen) {
+            memcpy(op.name, lalpha, MIN(llen, sizeof(op.name) - 1));
+        } else if (slen) {
+            memcpy(op.name, salpha, MIN(slen, sizeof(op.name) - 1));
         } else {
             g_strlcpy(op.name, numeric, sizeof(op.name));
         }
@@ -313,6 +497,7 @@ binder_network_poll_operator_cb(
             if (error == RADIO_ERROR_NONE) {
                 GBinderReader reader;
 
+                self->poll_time[POLL_OPERATOR] = g_get_monotonic_time();
                 gbinder_reader_copy(&reader, args);
                 binder_network_poll_operator_ok(self, &reader);
             } else {
@@ -635,6 +820,7 @@ binder_network_poll_voice_state_cb(
             if (reg) {
                 BinderNetwork* net = &self->pub;
 
+                self->poll_time[POLL_VOICE] = g_get_monotonic_time();
                 DBG_(self, "%s,%s,%d,%d,%d,%d",
                      ofono_netreg_status_to_string(reg->status),
                      ofono_access_technology_to_string(reg->access_tech),
@@ -809,6 +995,7 @@ binder_network_poll_data_state_cb(
                 BinderBase* base = &self->base;
                 BinderNetwork* net = &self->pub;
 
+                self->poll_time[POLL_DATA] = g_get_monotonic_time();
                 DBG_(self, "%s,%s,%d,%d,%d,%d,%d",
                      ofono_netreg_status_to_string(reg->status),
                      ofono_access_technology_to_string(reg->access_tech),
@@ -878,22 +1065,12 @@ void
 binder_network_poll_registration_state(
     BinderNetworkObject* self)
 {
-    RadioClient* client = self->g->client;
-    const RADIO_INTERFACE iface = radio_client_interface(client);
-
     self->voice_poll_req = binder_network_poll_and_retry(self,
         self->voice_poll_req, RADIO_REQ_GET_VOICE_REGISTRATION_STATE,
         binder_network_poll_voice_state_cb);
-
-    if (iface >= RADIO_INTERFACE_1_5) {
-        self->data_poll_req = binder_network_poll_and_retry(self,
-            self->data_poll_req, RADIO_REQ_GET_DATA_REGISTRATION_STATE_1_5,
-            binder_network_poll_data_state_cb);
-    } else {
-        self->data_poll_req = binder_network_poll_and_retry(self,
-            self->data_poll_req, RADIO_REQ_GET_DATA_REGISTRATION_STATE,
-            binder_network_poll_data_state_cb);
-    }
+    self->data_poll_req = binder_network_poll_and_retry(self,
+        self->data_poll_req, self->iface->get_data_reg_state,
+        binder_network_poll_data_state_cb);
 }
 
 static
@@ -908,6 +1085,55 @@ binder_network_poll_state(
     binder_network_poll_registration_state(self);
 }
 
+static
+gboolean
+binder_network_poll_fresh(
+    BinderNetworkObject* self,
+    BINDER_NETWORK_POLL poll)
+{
+    const gint64 t = self->poll_time[poll];
+
+    return t && (g_get_monotonic_time() - t) < (POLL_STATE_TTL_MS * 1000);
+}
+
+static
+void
+binder_network_poll_stale_state(
+    BinderNetworkObject* self)
+{
+    if (binder_network_poll_fresh(self, POLL_OPERATOR)) {
+        DBG_(self, "operator is fresh");
+    } else {
+        self->operator_poll_req = binder_network_poll_and_retry(self,
+            self->operator_poll_req, RADIO_REQ_GET_OPERATOR,
+            binder_network_poll_operator_cb);
+    }
+
+    if (binder_network_poll_fresh(self, POLL_VOICE)) {
+        DBG_(self, "voice registration is fresh");
+    } else {
+        self->voice_poll_req = binder_network_poll_and_retry(self,
+            self->voice_poll_req, RADIO_REQ_GET_VOICE_REGISTRATION_STATE,
+            binder_network_poll_voice_state_cb);
+    }
+
+    if (binder_network_poll_fresh(self, POLL_DATA)) {
+        DBG_(self, "data registration is fresh");
+    } else {
+        self->data_poll_req = binder_network_poll_and_retry(self,
+            self->data_poll_req, self->iface->get_data_reg_state,
+            binder_network_poll_data_state_cb);
+    }
+}
+
+static
+void
+binder_network_poll_invalidate(
+    BinderNetworkObject* self)
+{
+    memset(self->poll_time, 0, sizeof(self->poll_time));
+}
+
 static
 RADIO_PREF_NET_TYPE
 binder_network_mode_to_pref(
@@ -1197,6 +1423,42 @@ binder_network_data_profiles_equal(
     }
 }
 
+static
+guint
+binder_network_data_profiles_hash_init(
+    BinderNetworkObject* self)
+{
+    const BinderDataProfileConfig* dpc = &self->data_profile_config;
+    guint h = self->iface->version;
+
+    /* The ids affect supportedApnTypesBitmap */
+    h = h * 31 + dpc->default_profile_id;
+    h = h * 31 + dpc->mms_profile_id;
+    return h;
+}
+
+static
+guint
+binder_network_data_profiles_hash_add(
+    guint h,
+    const struct ofono_gprs_primary_context* ctx,
+    RADIO_DATA_PROFILE_ID id)
+{
+    BinderNetworkDataProfile profile;
+
+    /* Hash exactly what would end up in the request */
+    binder_network_data_profile_init(&profile, ctx, id);
+    h = h * 31 + profile.id;
+    h = h * 31 + profile.type;
+    h = h * 31 + profile.auth_method;
+    h = h * 31 + profile.proto;
+    h = h * 31 + profile.enabled;
+    h = h * 31 + g_str_hash(profile.apn);
+    h = h * 31 + g_str_hash(profile.username);
+    h = h * 31 + g_str_hash(profile.password);
+    return h;
+}
+
 static inline
 void
 binder_network_data_profiles_free(
@@ -1222,9 +1484,22 @@ binder_network_set_data_profiles_done(
     radio_request_unref(self->set_data_profiles_req);
     self->set_data_profiles_req = NULL;
 
-    if (error != RADIO_ERROR_NONE) {
-        ofono_error("Error setting data profiles: %s",
-            binder_radio_error_string(error));
+    if (status != RADIO_TX_STATUS_OK || error != RADIO_ERROR_NONE) {
+        if (status == RADIO_TX_STATUS_OK) {
+            ofono_error("Error setting data profiles: %s",
+                binder_radio_error_string(error));
+        } else {
+            ofono_error("Failed to set data profiles");
+        }
+        /* Try again next time, nothing is known to be applied */
+        self->data_profiles_hash_known = FALSE;
+        binder_network_data_profiles_free(self->data_profiles);
+        self->data_profiles = NULL;
+    } else {
+        /* The modem keeps them across restarts, and so do we */
+        self->data_profiles_reset = FALSE;
+        binder_network_cache_set(self, NETWORK_CACHE_DATA_PROFILES,
+            self->data_profiles_hash);
     }
 
     binder_network_check_initial_attach_apn(self);
@@ -1237,7 +1512,7 @@ binder_network_set_data_profiles(
 {
     RadioClient* client = self->g->client;
     const BinderDataProfileConfig* dpc = &self->data_profile_config;
-    const RADIO_INTERFACE iface = radio_client_interface(client);
+    const RADIO_INTERFACE iface = self->iface->version;
     const guint n = g_slist_length(self->data_profiles);
     RadioRequest* req;
     GBinderWriter writer;
@@ -1307,6 +1582,8 @@ binder_network_check_data_profiles(
 
     if (gprs) {
         GSList* l = NULL;
+        guint hash = binder_network_data_profiles_hash_init(self);
+        int cached;
 
         const struct ofono_gprs_primary_context* internet =
             ofono_gprs_context_settings_by_type(gprs,
@@ -1318,6 +1595,19 @@ binder_network_check_data_profiles(
             ofono_gprs_context_settings_by_type(gprs,
                 OFONO_GPRS_CONTEXT_TYPE_IMS);
 
+        if (internet) {
+            hash = binder_network_data_profiles_hash_add(hash, internet,
+                dpc->default_profile_id);
+        }
+        if (mms) {
+            hash = binder_network_data_profiles_hash_add(hash, mms,
+                dpc->mms_profile_id);
+        }
+        if (ims) {
+            hash = binder_network_data_profiles_hash_add(hash, ims,
+                RADIO_DATA_PROFILE_IMS);
+        }
+
         if (internet) {
             DBG_(self, "internet apn \"%s\"", internet->apn);
             l = g_slist_append(l, binder_network_data_profile_new(internet,
@@ -1336,6 +1626,25 @@ binder_network_check_data_profiles(
                 RADIO_DATA_PROFILE_IMS));
         }
 
+        if (!self->data_profiles_hash_known && !self->data_profiles_reset &&
+            binder_network_cache_get(self, NETWORK_CACHE_DATA_PROFILES,
+            &cached)) {
+            /* What we have applied before the restart */
+            self->data_profiles_hash = cached;
+            self->data_profiles_hash_known = TRUE;
+        }
+
+        if (self->data_profiles_hash_known &&
+            self->data_profiles_hash == hash) {
+            /* Still remember them, in case if they need to be replayed */
+            DBG_(self, "data profiles %08x are up to date", hash);
+            binder_network_data_profiles_free(self->data_profiles);
+            self->data_profiles = l;
+            return;
+        }
+
+        self->data_profiles_hash = hash;
+        self->data_profiles_hash_known = TRUE;
         if (binder_network_data_profiles_equal(self->data_profiles, l)) {
             binder_network_data_profiles_free(l);
         } else {
@@ -1372,13 +1681,41 @@ binder_network_can_set_initial_attach_apn(
         !self->set_data_profiles_req;
 }
 
+static
+void
+binder_network_set_initial_attach_apn_done(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    void* user_data)
+{
+    BinderNetworkObject* self = THIS(user_data);
+
+    GASSERT(self->set_ia_apn_req == req);
+    radio_request_unref(self->set_ia_apn_req);
+    self->set_ia_apn_req = NULL;
+
+    if (status == RADIO_TX_STATUS_OK && error == RADIO_ERROR_NONE) {
+        /* The modem keeps it across resets, remember what it has */
+        self->ia_apn_hash = self->ia_apn_pending_hash;
+        self->ia_apn_hash_known = TRUE;
+        binder_network_cache_set(self, NETWORK_CACHE_ATTACH_APN,
+            self->ia_apn_hash);
+    } else {
+        ofono_error("Error setting initial attach apn: %s",
+            binder_radio_error_string(error));
+    }
+}
+
 static
 void
 binder_network_set_initial_attach_apn(
     BinderNetworkObject* self,
     const struct ofono_gprs_primary_context* ctx)
 {
-    const RADIO_INTERFACE iface = radio_client_interface(self->g->client);
+    const RADIO_INTERFACE iface = self->iface->version;
     const BinderDataProfileConfig* dpc = &self->data_profile_config;
     BinderNetworkDataProfile profile;
     RadioRequest* req;
@@ -1389,7 +1726,7 @@ binder_network_set_initial_attach_apn(
     if (iface >= RADIO_INTERFACE_1_5) {
         /* setInitialAttachApn_1_4(int32 serial, DataProfileInfo profile); */
         req = radio_request_new2(self->g, RADIO_REQ_SET_INITIAL_ATTACH_APN_1_5,
-            &writer, NULL, NULL, NULL);
+            &writer, binder_network_set_initial_attach_apn_done, NULL, self);
 
         gbinder_writer_append_struct(&writer,
             binder_network_new_radio_data_profile_1_5(&writer, &profile, dpc),
@@ -1397,7 +1734,7 @@ binder_network_set_initial_attach_apn(
     } else if (iface >= RADIO_INTERFACE_1_4) {
         /* setInitialAttachApn_1_4(int32 serial, DataProfileInfo profile); */
         req = radio_request_new2(self->g, RADIO_REQ_SET_INITIAL_ATTACH_APN_1_4,
-            &writer, NULL, NULL, NULL);
+            &writer, binder_network_set_initial_attach_apn_done, NULL, self);
 
         gbinder_writer_append_struct(&writer,
             binder_network_new_radio_data_profile_1_4(&writer, &profile, dpc),
@@ -1408,7 +1745,7 @@ binder_network_set_initial_attach_apn(
          *     bool modemCognitive, bool isRoaming);
          */
         req = radio_request_new2(self->g, RADIO_REQ_SET_INITIAL_ATTACH_APN,
-            &writer, NULL, NULL, NULL);
+            &writer, binder_network_set_initial_attach_apn_done, NULL, self);
 
         gbinder_writer_append_struct(&writer,
             binder_network_new_radio_data_profile(&writer, &profile, dpc),
@@ -1438,8 +1775,31 @@ binder_network_try_set_initial_attach_apn(
                 OFONO_GPRS_CONTEXT_TYPE_INTERNET);
 
         if (ctx) {
+            const guint hash = binder_network_data_profiles_hash_add
+                (binder_network_data_profiles_hash_init(self), ctx,
+                    RADIO_DATA_PROFILE_DEFAULT);
+            int cached;
+
+            if (!self->ia_apn_hash_known &&
+                binder_network_cache_get(self, NETWORK_CACHE_ATTACH_APN,
+                &cached)) {
+                /* What we have applied before the restart */
+                self->ia_apn_hash = cached;
+                self->ia_apn_hash_known = TRUE;
+            }
+
             self->set_initial_attach_apn = FALSE;
-            binder_network_set_initial_attach_apn(self, ctx);
+            if (!self->ia_apn_replay && self->ia_apn_hash_known &&
+                self->ia_apn_hash == hash) {
+                DBG_(self, "initial attach apn \"%s\" is up to date",
+                    ctx->apn);
+                radio_request_drop(self->set_ia_apn_req);
+                self->set_ia_apn_req = NULL;
+            } else {
+                self->ia_apn_replay = FALSE;
+                self->ia_apn_pending_hash = hash;
+                binder_network_set_initial_attach_apn(self, ctx);
+            }
         }
     }
 }
@@ -1496,6 +1856,7 @@ binder_network_set_pref_holdoff_cb(
 {
     BinderNetworkObject* self = THIS(user_data);
 
+    binder_wakeup("network pref mode holdoff");
     GASSERT(self->timer[TIMER_SET_RAT_HOLDOFF]);
     self->timer[TIMER_SET_RAT_HOLDOFF] = 0;
 
@@ -1503,6 +1864,18 @@ binder_network_set_pref_holdoff_cb(
     return G_SOURCE_REMOVE;
 }
 
+static
+void
+binder_network_pref_changed(
+    BinderNetworkObject* self)
+{
+    /* Don't join the queries which may have been answered before that */
+    binder_req_share_invalidate(self->share,
+        RADIO_REQ_GET_PREFERRED_NETWORK_TYPE);
+    binder_req_share_invalidate(self->share,
+        RADIO_REQ_GET_PREFERRED_NETWORK_TYPE_BITMAP);
+}
+
 static
 void
 binder_network_set_pref_cb(
@@ -1523,6 +1896,7 @@ binder_network_set_pref_cb(
         ofono_error("Error %d setting pref mode", error);
     }
 
+    binder_network_pref_changed(self);
     binder_network_query_pref_mode(self);
 }
 
@@ -1544,10 +1918,9 @@ binder_network_set_pref(
         !card->sim_io_active &&
         !self->timer[TIMER_SET_RAT_HOLDOFF]) {
         RadioClient* client = self->g->client;
-        const RADIO_INTERFACE iface = radio_client_interface(client);
         GBinderWriter writer;
 
-        if (iface >= RADIO_INTERFACE_1_4) {
+        if (self->iface->pref_net_type_bitmap) {
             BinderRadioCaps* caps = self->caps;
             RADIO_ACCESS_FAMILY raf = binder_raf_from_pref(rat);
 
@@ -1575,6 +1948,8 @@ binder_network_set_pref(
         if (radio_request_submit(self->set_rat_req)) {
             /* We have submitted the request, clear the assertion flag */
             self->assert_rat = FALSE;
+            self->pref_requests_sent++;
+            binder_network_pref_changed(self);
         }
 
         /* And don't do it too often */
@@ -1587,21 +1962,10 @@ binder_network_set_pref(
 }
 
 static
-void
-binder_network_update_pref_mode(
-    BinderNetworkObject* self,
-    RADIO_PREF_NET_TYPE rat)
-{
-    if (self->rat != rat || self->assert_rat) {
-        binder_network_set_pref(self, rat);
-    }
-}
-
-static
-void
-binder_network_check_pref_mode(
+gboolean
+binder_network_pref_mode_target(
     BinderNetworkObject* self,
-    gboolean immediate)
+    RADIO_PREF_NET_TYPE* pref)
 {
     BinderRadio* radio = self->radio;
 
@@ -1618,38 +1982,109 @@ binder_network_check_pref_mode(
         const enum ofono_radio_access_mode actual =
             binder_access_modes_from_pref(self->rat);
 
-        if (self->timer[TIMER_FORCE_CHECK_PREF_MODE]) {
-            binder_network_stop_timer(self, TIMER_FORCE_CHECK_PREF_MODE);
-            /*
-             * TIMER_FORCE_CHECK_PREF_MODE is scheduled by
-             * binder_network_settings_pref_changed_cb and is meant
-             * to force radio tech check right now.
-             */
-            immediate = TRUE;
+        if (actual != expected || self->assert_rat) {
+            *pref = binder_network_mode_to_pref(self, expected);
+            return self->rat != *pref || self->assert_rat;
         }
+    }
+    return FALSE;
+}
 
-        if (self->raf && actual != expected) {
-            DBG_(self, "rat %d raf 0x%08x (%s), expected %s",
-                self->rat, self->raf,
-                ofono_radio_access_mode_to_string(actual),
-                ofono_radio_access_mode_to_string(expected));
-        }
+static
+void
+binder_network_reconcile_pref_mode(
+    BinderNetworkObject* self)
+{
+    RADIO_PREF_NET_TYPE pref;
+    const gboolean needed = self->reconcile_needed;
+    const gboolean immediate = self->reconcile_immediate;
+
+    self->reconcile_needed = FALSE;
+    self->reconcile_immediate = FALSE;
+    if (immediate) {
+        binder_network_stop_timer(self, TIMER_SET_RAT_HOLDOFF);
+    }
 
-        if (immediate) {
-            binder_network_stop_timer(self, TIMER_SET_RAT_HOLDOFF);
+    if (binder_network_pref_mode_target(self, &pref)) {
+        DBG_(self, "rat %d raf 0x%08x (%s), expected %s", self->rat,
+            self->raf, ofono_radio_access_mode_to_string
+            (binder_access_modes_from_pref(self->rat)),
+            ofono_radio_access_mode_to_string
+            (binder_access_modes_from_pref(pref)));
+        if (!self->timer[TIMER_SET_RAT_HOLDOFF]) {
+            binder_network_set_pref(self, pref);
+        } else {
+            /* OK, later */
+            DBG_(self, "need to set rat mode %d", pref);
         }
+    } else if (needed) {
+        /* Whatever wanted the change has been undone in the meantime */
+        self->pref_requests_avoided++;
+        DBG_(self, "rat mode %d is fine after all", self->rat);
+    }
+}
 
-        if (actual != expected || self->assert_rat) {
-            const RADIO_PREF_NET_TYPE pref =
-                binder_network_mode_to_pref(self, expected);
+static
+gboolean
+binder_network_reconcile_pref_mode_cb(
+    gpointer user_data)
+{
+    BinderNetworkObject* self = THIS(user_data);
 
-            if (!self->timer[TIMER_SET_RAT_HOLDOFF]) {
-                binder_network_update_pref_mode(self, pref);
-            } else {
-                /* OK, later */
-                DBG_(self, "need to set rat mode %d", pref);
-            }
+    binder_wakeup("network pref mode reconcile");
+    GASSERT(self->timer[TIMER_RECONCILE_PREF_MODE]);
+    self->timer[TIMER_RECONCILE_PREF_MODE] = 0;
+    binder_network_reconcile_pref_mode(self);
+    return G_SOURCE_REMOVE;
+}
+
+/*
+ * Data SIM switches, radio caps changes and settings updates tend to
+ * come in bursts, each of them touching one of the inputs. Rather than
+ * reacting to every single one of them, the desired mode is recomputed
+ * from all the inputs once they have settled down, and at most one
+ * request is issued per burst. The immediate check (which also skips
+ * the holdoff) only waits until the current burst has been dispatched.
+ */
+static
+void
+binder_network_check_pref_mode(
+    BinderNetworkObject* self,
+    gboolean immediate)
+{
+    RADIO_PREF_NET_TYPE pref;
+    guint* timer = self->timer + TIMER_RECONCILE_PREF_MODE;
+
+    if (self->timer[TIMER_FORCE_CHECK_PREF_MODE]) {
+        binder_network_stop_timer(self, TIMER_FORCE_CHECK_PREF_MODE);
+        /*
+         * TIMER_FORCE_CHECK_PREF_MODE is scheduled by
+         * binder_network_settings_pref_changed_cb and is meant
+         * to force radio tech check right now.
+         */
+        immediate = TRUE;
+    }
+
+    if (binder_network_pref_mode_target(self, &pref)) {
+        if (self->reconcile_needed) {
+            /* This one gets merged with the pending one */
+            self->pref_requests_avoided++;
         }
+        self->reconcile_needed = TRUE;
+    }
+
+    if (immediate) {
+        if (!self->reconcile_immediate) {
+            self->reconcile_immediate = TRUE;
+            binder_network_stop_timer(self, TIMER_RECONCILE_PREF_MODE);
+            *timer = g_idle_add(binder_network_reconcile_pref_mode_cb,
+                self);
+        }
+    } else if (self->reconcile_needed && !self->reconcile_immediate) {
+        /* Restart the settle timer */
+        binder_network_stop_timer(self, TIMER_RECONCILE_PREF_MODE);
+        *timer = binder_timeout_add_coarse(SET_PREF_MODE_SETTLE_MS,
+            binder_network_reconcile_pref_mode_cb, self);
     }
 }
 
@@ -1662,6 +2097,40 @@ binder_network_assert_pref_mode(
     binder_network_check_pref_mode(self, FALSE);
 }
 
+/*
+ * Until the modem tells us what the actual preferred mode is, use
+ * the last known one for this SIM. Otherwise the technology would be
+ * shown as unknown for a good part of the startup.
+ */
+static
+void
+binder_network_pref_cache_load(
+    BinderNetworkObject* self)
+{
+    BinderNetwork* net = &self->pub;
+    int modes;
+
+    if (!self->pref_queried &&
+        binder_network_cache_get(self, NETWORK_CACHE_PREF_MODES, &modes) &&
+        net->pref_modes != (enum ofono_radio_access_mode)modes) {
+        DBG_(self, "cached pref modes 0x%02x (%s)", modes,
+            ofono_radio_access_mode_to_string(modes));
+        net->pref_modes = modes;
+        binder_base_emit_property_change(&self->base,
+            BINDER_NETWORK_PROPERTY_PREF_MODES);
+    }
+}
+
+static
+void
+binder_network_pref_queried(
+    BinderNetworkObject* self)
+{
+    self->pref_queried = TRUE;
+    binder_network_cache_set(self, NETWORK_CACHE_PREF_MODES,
+        self->pub.pref_modes);
+}
+
 static
 gboolean
 binder_network_query_rat_done(
@@ -1772,8 +2241,12 @@ binder_network_initial_pref_query_done(
         RADIO_ERROR error,
         const GBinderReader* args))
 {
+    GASSERT(self->initial_rat_call_id);
+    self->initial_rat_call_id = 0;
+
     binder_network_object_ref(self);
     if (handle(self, status, resp, error, args)) {
+        binder_network_pref_queried(self);
         /*
          * At startup, the device may have an inconsistency between
          * voice and data network modes, so it needs to be asserted.
@@ -1816,24 +2289,18 @@ void
 binder_network_initial_rat_query(
     BinderNetworkObject* self)
 {
-    RadioClient* client = self->g->client;
-    const RADIO_INTERFACE iface = radio_client_interface(client);
-    RadioRequest* req;
-
-    if (iface >= RADIO_INTERFACE_1_4) {
+    binder_req_share_cancel(self->share, self->initial_rat_call_id);
+    if (self->iface->pref_net_type_bitmap) {
         /* getPreferredNetworkTypeBitmap(int32 serial) */
-        req = radio_request_new2(self->g,
-            RADIO_REQ_GET_PREFERRED_NETWORK_TYPE_BITMAP, NULL,
+        self->initial_rat_call_id = binder_req_share_submit(self->share,
+            RADIO_REQ_GET_PREFERRED_NETWORK_TYPE_BITMAP, NULL, 0, 0,
             binder_network_initial_raf_query_cb, NULL, self);
     } else {
         /* getPreferredNetworkType(int32 serial) */
-        req = radio_request_new2(self->g,
-            RADIO_REQ_GET_PREFERRED_NETWORK_TYPE, NULL,
+        self->initial_rat_call_id = binder_req_share_submit(self->share,
+            RADIO_REQ_GET_PREFERRED_NETWORK_TYPE, NULL, 0, 0,
             binder_network_initial_rat_query_cb, NULL, self);
     }
-
-    radio_request_submit(req);
-    radio_request_unref(req);
 }
 
 static
@@ -1851,14 +2318,15 @@ binder_network_pref_query_done(
         RADIO_ERROR error,
         const GBinderReader* args))
 {
-    GASSERT(self->query_rat_req);
-    radio_request_unref(self->query_rat_req);
-    self->query_rat_req = NULL;
+    GASSERT(self->query_rat_call_id);
+    self->query_rat_call_id = 0;
 
     binder_network_object_ref(self);
-    if (handle(self, status, resp, error, args) &&
-        binder_network_can_set_pref_mode(self)) {
-        binder_network_check_pref_mode(self, FALSE);
+    if (handle(self, status, resp, error, args)) {
+        binder_network_pref_queried(self);
+        if (binder_network_can_set_pref_mode(self)) {
+            binder_network_check_pref_mode(self, FALSE);
+        }
     }
     binder_network_object_unref(self);
 }
@@ -1896,31 +2364,24 @@ void
 binder_network_query_pref_mode(
     BinderNetworkObject* self)
 {
-    RadioClient* client = self->g->client;
-    const RADIO_INTERFACE iface = radio_client_interface(client);
-    RadioRequest* req;
+    const gulong prev_id = self->query_rat_call_id;
 
-    if (iface >= RADIO_INTERFACE_1_4) {
+    /*
+     * Submit the new query before cancelling the previous one, so that
+     * the one in flight (if any) gets reused rather than resubmitted.
+     */
+    if (self->iface->pref_net_type_bitmap) {
         /* getPreferredNetworkTypeBitmap(int32 serial); */
-        req = radio_request_new(client,
-            RADIO_REQ_GET_PREFERRED_NETWORK_TYPE_BITMAP, NULL,
-            binder_network_raf_query_cb, NULL, self);
+        self->query_rat_call_id = binder_req_share_submit(self->share,
+            RADIO_REQ_GET_PREFERRED_NETWORK_TYPE_BITMAP, NULL, 0,
+            INTINITE_TIMEOUT, binder_network_raf_query_cb, NULL, self);
     } else {
         /* getPreferredNetworkType(int32 serial); */
-        req = radio_request_new(client,
-            RADIO_REQ_GET_PREFERRED_NETWORK_TYPE, NULL,
-            binder_network_rat_query_cb, NULL, self);
-    }
-
-    radio_request_set_retry_func(req, binder_network_retry);
-    radio_request_set_retry(req, BINDER_RETRY_MS, -1);
-    radio_request_set_timeout(req, INTINITE_TIMEOUT);
-    radio_request_drop(self->query_rat_req);
-    self->query_rat_req = req; /* Keep the ref */
-    if (!radio_request_submit(req)) {
-        radio_request_drop(self->query_rat_req);
-        self->query_rat_req = NULL;
+        self->query_rat_call_id = binder_req_share_submit(self->share,
+            RADIO_REQ_GET_PREFERRED_NETWORK_TYPE, NULL, 0,
+            INTINITE_TIMEOUT, binder_network_rat_query_cb, NULL, self);
     }
+    binder_req_share_cancel(self->share, prev_id);
 }
 
 enum ofono_radio_access_mode
@@ -2032,25 +2493,138 @@ binder_network_modem_reset_cb(
     GASSERT(code == RADIO_IND_MODEM_RESET);
 
     /* Drop all pending requests */
+    binder_network_poll_invalidate(self);
     radio_request_drop(self->operator_poll_req);
     radio_request_drop(self->voice_poll_req);
     radio_request_drop(self->data_poll_req);
-    radio_request_drop(self->query_rat_req);
+    binder_req_share_cancel(self->share, self->query_rat_call_id);
     radio_request_drop(self->set_rat_req);
     radio_request_drop(self->set_data_profiles_req);
     radio_request_drop(self->set_ia_apn_req);
     self->operator_poll_req = NULL;
     self->voice_poll_req = NULL;
     self->data_poll_req = NULL;
-    self->query_rat_req = NULL;
+    self->query_rat_call_id = 0;
     self->set_rat_req = NULL;
     self->set_data_profiles_req = NULL;
     self->set_ia_apn_req  = NULL;
 
+    /*
+     * What the modem had before the reset may be lost. Replay the last
+     * applied data profiles right away, the initial attach APN follows
+     * as soon as they are set. The preferred mode is queried meanwhile
+     * and only set if the modem has something else.
+     */
     binder_network_initial_rat_query(self);
+    self->ia_apn_replay = TRUE;
+    self->data_profiles_hash_known = FALSE;
+    self->data_profiles_reset = TRUE;
+    if (self->data_profiles) {
+        DBG_(self, "replaying data profiles");
+        binder_network_set_data_profiles(self);
+    } else {
+        binder_network_check_data_profiles(self);
+    }
     binder_network_reset_initial_attach_apn(self);
 }
 
+/* android.hardware.radio@1.2::PhysicalChannelConfig */
+typedef struct binder_network_phys_chan {
+    gint32 status;                 /* CellConnectionStatus */
+    gint32 cellBandwidthDownlink;  /* kHz */
+} BinderNetworkPhysChan;
+G_STATIC_ASSERT(sizeof(BinderNetworkPhysChan) == 8);
+
+/*
+ * android.hardware.radio@1.4::PhysicalChannelConfig, RadioFrequencyInfo
+ * is a safe_union i.e. the discriminator followed by the value.
+ */
+typedef struct binder_network_phys_chan_1_4 {
+    BinderNetworkPhysChan base;
+    gint32 rat;                  /* RadioTechnology */
+    guint8 rfInfoType;           /* RF_INFO_RANGE or RF_INFO_CHANNEL */
+    gint32 rfInfo;               /* FrequencyRange or channelNumber */
+    GBinderHidlVec contextIds;   /* vec<int32_t> */
+    guint32 physicalCellId;
+} BinderNetworkPhysChan_1_4;
+G_STATIC_ASSERT(sizeof(BinderNetworkPhysChan_1_4) == 48);
+
+#define RF_INFO_RANGE   (0)
+#define RF_INFO_CHANNEL (1)
+
+static
+void
+binder_network_carrier_init(
+    BinderComponentCarrier* cc,
+    const BinderNetworkPhysChan* base)
+{
+    cc->rat = RADIO_TECH_LTE;
+    cc->status = base->status;
+    cc->bandwidth_khz = base->cellBandwidthDownlink;
+    cc->frequency_range = 0;
+    cc->channel = -1;
+    cc->pci = -1;
+}
+
+static
+void
+binder_network_set_carriers(
+    BinderNetworkObject* self,
+    BinderCarriers* carriers)
+{
+    BinderCarriers* cur = &self->pub.carriers;
+    gboolean nr_connected = FALSE;
+    guint i, nr = 0, lte = 0;
+
+    carriers->total_bandwidth_khz = 0;
+    for (i = 0; i < carriers->count; i++) {
+        const BinderComponentCarrier* cc = carriers->carrier + i;
+
+        if (cc->status == RADIO_CELL_CONNECTION_PRIMARY_SERVING ||
+            cc->status == RADIO_CELL_CONNECTION_SECONDARY_SERVING) {
+            if (cc->bandwidth_khz > 0) {
+                carriers->total_bandwidth_khz += cc->bandwidth_khz;
+            }
+            if (cc->rat == RADIO_TECH_NR) {
+                nr++;
+                if (cc->status == RADIO_CELL_CONNECTION_SECONDARY_SERVING) {
+                    nr_connected = TRUE;
+                }
+            } else {
+                lte++;
+            }
+        }
+    }
+
+    /* NR carriers on top of an LTE anchor is EN-DC rather than CA */
+    carriers->endc = (lte > 0 && nr > 0);
+    carriers->ca = (lte > 1 || nr > 1);
+    if (self->nr_connected != nr_connected) {
+        DBG_(self, "NSA 5G %sconnected", nr_connected ? "" : "dis");
+        self->nr_connected = nr_connected;
+    }
+
+    if (memcmp(cur, carriers, sizeof(*cur))) {
+        DBG_(self, "%u carrier(s), %u kHz%s%s", carriers->count,
+            carriers->total_bandwidth_khz, carriers->ca ? ", CA" : "",
+            carriers->endc ? ", EN-DC" : "");
+        *cur = *carriers;
+        binder_base_emit_property_change(&self->base,
+            BINDER_NETWORK_PROPERTY_CARRIERS);
+    }
+}
+
+static
+void
+binder_network_clear_carriers(
+    BinderNetworkObject* self)
+{
+    BinderCarriers none;
+
+    memset(&none, 0, sizeof(none));
+    binder_network_set_carriers(self, &none);
+}
+
 static
 void
 binder_network_current_physical_channel_configs_cb(
@@ -2060,28 +2634,192 @@ binder_network_current_physical_channel_configs_cb(
     gpointer user_data)
 {
     BinderNetworkObject* self = THIS(user_data);
+    BinderCarriers carriers;
     GBinderReader reader;
-    gboolean nr_connected = FALSE;
+    gsize count = 0;
+    guint i;
 
+    /*
+     * Parsed straight into the fixed-size model, carriers beyond
+     * BINDER_NETWORK_MAX_CARRIERS are dropped.
+     */
+    memset(&carriers, 0, sizeof(carriers));
     gbinder_reader_copy(&reader, args);
-
     if (code == RADIO_IND_CURRENT_PHYSICAL_CHANNEL_CONFIGS_1_4) {
-        gsize count;
-        guint i;
-        const RadioPhysicalChannelConfig_1_4* configs = gbinder_reader_read_hidl_type_vec(&reader,
-            RadioPhysicalChannelConfig_1_4, &count);
-
-        for (i = 0; i < count; i++) {
-            if (configs[i].rat == RADIO_TECH_NR &&
-                configs[i].base.connectionStatus == RADIO_CELL_CONNECTION_SECONDARY_SERVING) {
-                DBG_(self, "NSA 5G connected");
-                nr_connected = TRUE;
+        const BinderNetworkPhysChan_1_4* configs =
+            gbinder_reader_read_hidl_type_vec(&reader,
+                BinderNetworkPhysChan_1_4, &count);
+
+        for (i = 0; i < count && i < BINDER_NETWORK_MAX_CARRIERS; i++) {
+            const BinderNetworkPhysChan_1_4* config = configs + i;
+            BinderComponentCarrier* cc = carriers.carrier + i;
+
+            binder_network_carrier_init(cc, &config->base);
+            cc->rat = config->rat;
+            cc->pci = config->physicalCellId;
+            if (config->rfInfoType == RF_INFO_RANGE) {
+                cc->frequency_range = config->rfInfo;
+            } else if (config->rfInfoType == RF_INFO_CHANNEL) {
+                cc->channel = config->rfInfo;
             }
         }
+    } else if (code == RADIO_IND_CURRENT_PHYSICAL_CHANNEL_CONFIGS) {
+        /* IRadio 1.2 doesn't tell RAT, it's assumed to be LTE */
+        const BinderNetworkPhysChan* configs =
+            gbinder_reader_read_hidl_type_vec(&reader,
+                BinderNetworkPhysChan, &count);
+
+        for (i = 0; i < count && i < BINDER_NETWORK_MAX_CARRIERS; i++) {
+            binder_network_carrier_init(carriers.carrier + i, configs + i);
+        }
     } else {
-        ofono_warn("Unexpected current physical channel configs code %d", code);
+        ofono_warn("Unexpected current physical channel configs code %d",
+            code);
+        return;
+    }
+
+    if (count > BINDER_NETWORK_MAX_CARRIERS) {
+        DBG_(self, "%u carrier(s) ignored", (guint)
+            (count - BINDER_NETWORK_MAX_CARRIERS));
+    }
+    carriers.count = MIN(count, BINDER_NETWORK_MAX_CARRIERS);
+    binder_network_set_carriers(self, &carriers);
+}
+
+static
+void
+binder_network_set_link_capacity(
+    BinderNetworkObject* self,
+    guint dl_kbps,
+    guint ul_kbps)
+{
+    BinderLinkCapacity* lce = &self->pub.link_capacity;
+
+    if (lce->dl_kbps != dl_kbps || lce->ul_kbps != ul_kbps) {
+        DBG_(self, "link capacity %u/%u kbps", dl_kbps, ul_kbps);
+        lce->dl_kbps = dl_kbps;
+        lce->ul_kbps = ul_kbps;
+        binder_base_emit_property_change(&self->base,
+            BINDER_NETWORK_PROPERTY_LINK_CAPACITY);
+    }
+}
+
+static
+void
+binder_network_link_capacity_estimate_cb(
+    RadioClient* client,
+    RADIO_IND code,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    /*
+     * typedef struct radio_link_capacity_estimate {
+     *     guint32 downlinkCapacityKbps;
+     *     guint32 uplinkCapacityKbps;
+     * } RadioLinkCapacityEstimate;
+     */
+    typedef struct radio_link_capacity_estimate {
+        guint32 downlinkCapacityKbps;
+        guint32 uplinkCapacityKbps;
+    } RadioLinkCapacityEstimate;
+
+    BinderNetworkObject* self = THIS(user_data);
+    const RadioLinkCapacityEstimate* lce;
+    GBinderReader reader;
+
+    /* currentLinkCapacityEstimate(RadioIndicationType, LinkCapacityEstimate) */
+    GASSERT(code == RADIO_IND_CURRENT_LINK_CAPACITY_ESTIMATE);
+    gbinder_reader_copy(&reader, args);
+    lce = gbinder_reader_read_hidl_struct(&reader, RadioLinkCapacityEstimate);
+    if (lce) {
+        binder_network_set_link_capacity(self, lce->downlinkCapacityKbps,
+            lce->uplinkCapacityKbps);
+    } else {
+        ofono_warn("Failed to parse link capacity estimate");
+    }
+}
+
+static
+void
+binder_network_set_lce_criteria_cb(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    if (status == RADIO_TX_STATUS_OK) {
+        if (resp == RADIO_RESP_SET_LINK_CAPACITY_REPORTING_CRITERIA ||
+            resp == RADIO_RESP_SET_LINK_CAPACITY_REPORTING_CRITERIA_1_5) {
+            if (error != RADIO_ERROR_NONE) {
+                DBG("setLinkCapacityReportingCriteria error %s",
+                    binder_radio_error_string(error));
+            }
+        } else {
+            ofono_error("Unexpected setLinkCapacityReportingCriteria"
+                " response %d", resp);
+        }
+    }
+}
+
+static
+void
+binder_network_set_lce_criteria(
+    BinderNetworkObject* self)
+{
+    static const struct binder_network_lce_ran {
+        enum ofono_radio_access_mode mode;
+        RADIO_ACCESS_NETWORKS ran;
+    } rans[] = {
+        { OFONO_RADIO_ACCESS_MODE_GSM, RADIO_ACCESS_NETWORKS_GERAN },
+        { OFONO_RADIO_ACCESS_MODE_UMTS, RADIO_ACCESS_NETWORKS_UTRAN },
+        { OFONO_RADIO_ACCESS_MODE_LTE, RADIO_ACCESS_NETWORKS_EUTRAN },
+        { OFONO_RADIO_ACCESS_MODE_NR, RADIO_ACCESS_NETWORKS_NGRAN }
+    };
+    const BinderLceConfig* lce = &self->lce_config;
+    const RADIO_REQ code = self->iface->set_lce_criteria;
+    guint i;
+
+    if ((!lce->dl_count && !lce->ul_count) || code == RADIO_REQ_NONE) {
+        return;
+    }
+
+    DBG_(self, "%u/%u link capacity thresholds, %d ms", lce->dl_count,
+        lce->ul_count, lce->hysteresis_ms);
+    for (i = 0; i < G_N_ELEMENTS(rans); i++) {
+        GBinderWriter writer;
+        RadioRequest* req;
+
+        /* NGRAN only exists in IRadio 1.5 AccessNetwork */
+        if (!(self->techs & rans[i].mode) ||
+            (rans[i].ran == RADIO_ACCESS_NETWORKS_NGRAN &&
+             !self->iface->ngran)) {
+            continue;
+        }
+
+        /*
+         * setLinkCapacityReportingCriteria(int32 serial,
+         *     int32 hysteresisMs, int32 hysteresisDlKbps,
+         *     int32 hysteresisUlKbps, vec<int32> thresholdsDownlinkKbps,
+         *     vec<int32> thresholdsUplinkKbps, AccessNetwork accessNetwork);
+         *
+         * Zero kbps hysteresis, the thresholds are expected to be
+         * far enough apart.
+         */
+        req = radio_request_new2(self->g, code, &writer,
+            binder_network_set_lce_criteria_cb, NULL, NULL);
+        gbinder_writer_append_int32(&writer, lce->hysteresis_ms);
+        gbinder_writer_append_int32(&writer, 0);
+        gbinder_writer_append_int32(&writer, 0);
+        gbinder_writer_append_hidl_vec(&writer, lce->dl_kbps, lce->dl_count,
+            sizeof(lce->dl_kbps[0]));
+        gbinder_writer_append_hidl_vec(&writer, lce->ul_kbps, lce->ul_count,
+            sizeof(lce->ul_kbps[0]));
+        gbinder_writer_append_int32(&writer, rans[i].ran);
+        radio_request_submit(req);
+        radio_request_unref(req);
     }
-    self->nr_connected = nr_connected;
 }
 
 static
@@ -2097,6 +2835,11 @@ binder_network_radio_state_cb(
     if (radio->state == RADIO_STATE_ON) {
         binder_network_poll_state(self);
         binder_network_try_set_initial_attach_apn(self);
+        binder_network_set_lce_criteria(self);
+    } else {
+        binder_network_poll_invalidate(self);
+        binder_network_set_link_capacity(self, 0, 0);
+        binder_network_clear_carriers(self);
     }
 }
 
@@ -2130,6 +2873,16 @@ binder_network_check_pref_mode_cb(
     return G_SOURCE_REMOVE;
 }
 
+static
+void
+binder_network_settings_imsi_changed_cb(
+    BinderSimSettings* settings,
+    BINDER_SIM_SETTINGS_PROPERTY property,
+    void* user_data)
+{
+    binder_network_pref_cache_load(THIS(user_data));
+}
+
 static
 void
 binder_network_settings_pref_changed_cb(
@@ -2225,10 +2978,12 @@ binder_network_new(
 
     net->settings = binder_sim_settings_ref(settings);
     self->g = radio_request_group_new(client); /* Keeps ref to client */
+    self->iface = binder_network_iface(radio_client_interface(client));
     self->radio = binder_radio_ref(radio);
     self->simcard = binder_sim_card_ref(simcard);
     self->watch = ofono_watch_new(path);
     self->log_prefix = binder_dup_prefix(log_prefix);
+    self->share = binder_req_share_new(client, log_prefix);
     DBG_(self, "");
 
     /* Copy relevant config values */
@@ -2236,6 +2991,8 @@ binder_network_new(
     self->umts_network_mode = config->umts_network_mode;
     self->network_mode_timeout_ms = config->network_mode_timeout_ms;
     self->force_gsm_when_radio_off = config->force_gsm_when_radio_off;
+    self->techs = config->techs;
+    self->lce_config = config->lce;
     self->data_profile_config = *dpc;
 
     /* Register listeners */
@@ -2247,10 +3004,18 @@ binder_network_new(
         radio_client_add_indication_handler(client,
             RADIO_IND_MODEM_RESET,
             binder_network_modem_reset_cb, self);
+    self->ind_id[IND_CURRENT_PHYSICAL_CHANNEL_CONFIGS] =
+        radio_client_add_indication_handler(client,
+            RADIO_IND_CURRENT_PHYSICAL_CHANNEL_CONFIGS,
+            binder_network_current_physical_channel_configs_cb, self);
     self->ind_id[IND_CURRENT_PHYSICAL_CHANNEL_CONFIGS_1_4] =
         radio_client_add_indication_handler(client,
             RADIO_IND_CURRENT_PHYSICAL_CHANNEL_CONFIGS_1_4,
             binder_network_current_physical_channel_configs_cb, self);
+    self->ind_id[IND_CURRENT_LINK_CAPACITY_ESTIMATE] =
+        radio_client_add_indication_handler(client,
+            RADIO_IND_CURRENT_LINK_CAPACITY_ESTIMATE,
+            binder_network_link_capacity_estimate_cb, self);
 
     self->radio_event_id[RADIO_EVENT_STATE_CHANGED] =
         binder_radio_add_property_handler(self->radio,
@@ -2261,16 +3026,23 @@ binder_network_new(
             BINDER_RADIO_PROPERTY_ONLINE,
             binder_network_radio_online_cb, self);
 
-    self->simcard_event_id[SIM_EVENT_STATUS_CHANGED] =
-        binder_sim_card_add_status_changed_handler(self->simcard,
+    self->simcard_event_id[SIM_EVENT_STATE_CHANGED] =
+        binder_sim_card_add_state_changed_handler(self->simcard,
+            binder_network_sim_status_changed_cb, self);
+    self->simcard_event_id[SIM_EVENT_APP_CHANGED] =
+        binder_sim_card_add_app_changed_handler(self->simcard,
             binder_network_sim_status_changed_cb, self);
     self->simcard_event_id[SIM_EVENT_IO_ACTIVE_CHANGED] =
         binder_sim_card_add_sim_io_active_changed_handler(self->simcard,
             binder_network_sim_status_changed_cb, self);
-    self->settings_event_id =
+    self->settings_event_id[SETTINGS_EVENT_PREF] =
         binder_sim_settings_add_property_handler(settings,
             BINDER_SIM_SETTINGS_PROPERTY_PREF,
             binder_network_settings_pref_changed_cb, self);
+    self->settings_event_id[SETTINGS_EVENT_IMSI] =
+        binder_sim_settings_add_property_handler(settings,
+            BINDER_SIM_SETTINGS_PROPERTY_IMSI,
+            binder_network_settings_imsi_changed_cb, self);
 
     self->watch_ids[WATCH_EVENT_GPRS] =
         ofono_watch_add_gprs_changed_handler(self->watch,
@@ -2279,7 +3051,8 @@ binder_network_new(
         ofono_watch_add_gprs_settings_changed_handler(self->watch,
             binder_network_watch_gprs_settings_cb, self);
 
-    /* Query the initial state */
+    /* Query the initial state, show the last known one meanwhile */
+    binder_network_pref_cache_load(self);
     binder_network_initial_rat_query(self);
 
     if (radio->state == RADIO_STATE_ON) {
@@ -2293,6 +3066,7 @@ binder_network_new(
         binder_network_check_data_profiles(self);
     }
     binder_network_try_set_initial_attach_apn(self);
+    binder_base_update_snapshot(&self->base);
     return net;
 }
 
@@ -2327,9 +3101,9 @@ binder_network_query_registration_state(
 {
     BinderNetworkObject* self = binder_network_cast(net);
 
-    if (self) {
+    if (self && self->radio->state == RADIO_STATE_ON) {
         DBG_(self, "");
-        binder_network_poll_registration_state(self);
+        binder_network_poll_stale_state(self);
     }
 }
 
@@ -2344,6 +3118,8 @@ binder_network_set_allowed_modes(
     if (G_LIKELY(self)) {
         const gboolean changed = (net->allowed_modes != modes);
 
+        /* Allowed and preferred modes may change together */
+        binder_base_begin_batch(&self->base);
         if (changed) {
             net->allowed_modes = modes;
             DBG_(self, "allowed modes 0x%02x (%s)", modes,
@@ -2355,6 +3131,7 @@ binder_network_set_allowed_modes(
         if (changed || force_check) {
             binder_network_check_pref_mode(self, TRUE);
         }
+        binder_base_commit_batch(&self->base);
     }
 }
 
@@ -2374,6 +3151,22 @@ binder_network_set_radio_caps(
     }
 }
 
+const BinderNetworkSnapshot*
+binder_network_snapshot_ref(
+    BinderNetwork* net)
+{
+    BinderNetworkObject* self = binder_network_cast(net);
+
+    return G_LIKELY(self) ? binder_base_snapshot_ref(&self->base) : NULL;
+}
+
+void
+binder_network_snapshot_unref(
+    const BinderNetworkSnapshot* snapshot)
+{
+    binder_base_snapshot_unref(snapshot);
+}
+
 gulong
 binder_network_add_property_handler(
     BinderNetwork* net,
@@ -2387,6 +3180,18 @@ binder_network_add_property_handler(
         property, G_CALLBACK(callback), user_data) : 0;
 }
 
+gulong
+binder_network_add_properties_handler(
+    BinderNetwork* net,
+    BinderNetworkPropertiesFunc callback,
+    void* user_data)
+{
+    BinderNetworkObject* self = binder_network_cast(net);
+
+    return G_LIKELY(self) ? binder_base_add_properties_handler(&self->base,
+        (BinderBasePropertiesFunc) callback, user_data) : 0;
+}
+
 void
 binder_network_remove_handler(
     BinderNetwork* net,
@@ -2435,7 +3240,8 @@ binder_network_object_finalize(
     BinderNetwork* net = &self->pub;
     BINDER_NETWORK_TIMER tid;
 
-    DBG_(self, "");
+    DBG_(self, "%u pref mode request(s), %u avoided",
+        self->pref_requests_sent, self->pref_requests_avoided);
     for (tid=0; tid<TIMER_COUNT; tid++) {
         binder_network_stop_timer(self, tid);
     }
@@ -2443,7 +3249,9 @@ binder_network_object_finalize(
     radio_request_drop(self->operator_poll_req);
     radio_request_drop(self->voice_poll_req);
     radio_request_drop(self->data_poll_req);
-    radio_request_drop(self->query_rat_req);
+    binder_req_share_cancel(self->share, self->query_rat_call_id);
+    binder_req_share_cancel(self->share, self->initial_rat_call_id);
+    binder_req_share_unref(self->share);
     radio_request_drop(self->set_rat_req);
     radio_request_drop(self->set_data_profiles_req);
     radio_request_drop(self->set_ia_apn_req);
@@ -2460,7 +3268,8 @@ binder_network_object_finalize(
     binder_radio_unref(self->radio);
     binder_sim_card_remove_all_handlers(self->simcard, self->simcard_event_id);
     binder_sim_card_unref(self->simcard);
-    binder_sim_settings_remove_handler(net->settings, self->settings_event_id);
+    binder_sim_settings_remove_all_handlers(net->settings,
+        self->settings_event_id);
     binder_sim_settings_unref(net->settings);
 
     g_slist_free_full(self->data_profiles, g_free);
@@ -2469,14 +3278,40 @@ binder_network_object_finalize(
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
 }
 
+static
+gpointer
+binder_network_object_snapshot(
+    BinderBase* base)
+{
+    BinderNetworkObject* self = THIS(base);
+    const BinderNetwork* net = &self->pub;
+    BinderNetworkSnapshot* snap = binder_base_snapshot_new(sizeof(*snap),
+        NULL);
+
+    snap->voice = net->voice;
+    snap->data = net->data;
+    snap->max_data_calls = net->max_data_calls;
+    if (net->operator) {
+        snap->have_operator = TRUE;
+        snap->operator = *net->operator;
+    }
+    snap->pref_modes = net->pref_modes;
+    snap->allowed_modes = net->allowed_modes;
+    snap->link_capacity = net->link_capacity;
+    snap->carriers = net->carriers;
+    return snap;
+}
+
 static
 void
 binder_network_object_class_init(
     BinderNetworkObjectClass* klass)
 {
+    BinderBaseClass* base_class = BINDER_BASE_CLASS(klass);
+
     G_OBJECT_CLASS(klass)->finalize = binder_network_object_finalize;
-    BINDER_BASE_CLASS(klass)->public_offset =
-        G_STRUCT_OFFSET(BinderNetworkObject, pub);
+    base_class->public_offset = G_STRUCT_OFFSET(BinderNetworkObject, pub);
+    base_class->snapshot = binder_network_object_snapshot;
 }
 
 /*
@@ -29,9 +29,13 @@ typedef enum binder_network_property {
     BINDER_NETWORK_PROPERTY_OPERATOR,
     BINDER_NETWORK_PROPERTY_PREF_MODES,
     BINDER_NETWORK_PROPERTY_ALLOWED_MODES,
+    BINDER_NETWORK_PROPERTY_LINK_CAPACITY,
+    BINDER_NETWORK_PROPERTY_CARRIERS,
     BINDER_NETWORK_PROPERTY_COUNT
 } BINDER_NETWORK_PROPERTY;
 
+#define BINDER_NETWORK_PROPERTY_BIT(property) (1 << ((property) - 1))
+
 typedef struct binder_registration_state {
     enum ofono_netreg_status status;
     enum ofono_access_technology access_tech;
@@ -41,6 +45,32 @@ typedef struct binder_registration_state {
     int ci;
 } BinderRegistrationState;
 
+/* Estimated link capacity, zeros if unknown */
+typedef struct binder_link_capacity {
+    guint dl_kbps;
+    guint ul_kbps;
+} BinderLinkCapacity;
+
+/* Component carriers, as reported by currentPhysicalChannelConfigs */
+#define BINDER_NETWORK_MAX_CARRIERS (8)
+
+typedef struct binder_component_carrier {
+    RADIO_TECH rat;
+    int status;           /* RADIO_CELL_CONNECTION_* */
+    int bandwidth_khz;    /* Downlink */
+    int frequency_range;  /* RADIO_FREQUENCY_RANGE_*, 0 if unknown */
+    int channel;          /* ARFCN, -1 if unknown */
+    int pci;              /* Physical cell id, -1 if unknown */
+} BinderComponentCarrier;
+
+typedef struct binder_carriers {
+    guint count;
+    guint total_bandwidth_khz;  /* Serving carriers only */
+    gboolean ca;                /* Carrier aggregation */
+    gboolean endc;              /* LTE + NR dual connectivity */
+    BinderComponentCarrier carrier[BINDER_NETWORK_MAX_CARRIERS];
+} BinderCarriers;
+
 struct binder_network {
     BinderSimSettings* settings;
     BinderRegistrationState voice;
@@ -49,8 +79,23 @@ struct binder_network {
     const struct ofono_network_operator* operator;
     enum ofono_radio_access_mode pref_modes;     /* Mask */
     enum ofono_radio_access_mode allowed_modes;  /* Mask */
+    BinderLinkCapacity link_capacity;
+    BinderCarriers carriers;
 };
 
+/* Immutable copy of the public state, safe to use from any thread */
+typedef struct binder_network_snapshot {
+    BinderRegistrationState voice;
+    BinderRegistrationState data;
+    int max_data_calls;
+    gboolean have_operator;
+    struct ofono_network_operator operator;
+    enum ofono_radio_access_mode pref_modes;     /* Mask */
+    enum ofono_radio_access_mode allowed_modes;  /* Mask */
+    BinderLinkCapacity link_capacity;
+    BinderCarriers carriers;
+} BinderNetworkSnapshot;
+
 typedef
 void
 (*BinderNetworkPropertyFunc)(
@@ -58,6 +103,13 @@ void
     BINDER_NETWORK_PROPERTY property,
     void* user_data);
 
+typedef
+void
+(*BinderNetworkPropertiesFunc)(
+    BinderNetwork* net,
+    guint mask, /* BINDER_NETWORK_PROPERTY_BIT */
+    void* user_data);
+
 BinderNetwork*
 binder_network_new(
     const char* path,
@@ -97,11 +149,26 @@ binder_network_max_supported_mode(
     BinderNetwork* self)
     BINDER_INTERNAL;
 
+/*
+ * Refreshes the registration state and the current operator, unless
+ * they have been polled within the last few seconds and are still
+ * considered up to date.
+ */
 void
 binder_network_query_registration_state(
     BinderNetwork* net)
     BINDER_INTERNAL;
 
+const BinderNetworkSnapshot*
+binder_network_snapshot_ref(
+    BinderNetwork* net)
+    BINDER_INTERNAL;
+
+void
+binder_network_snapshot_unref(
+    const BinderNetworkSnapshot* snapshot)
+    BINDER_INTERNAL;
+
 gulong
 binder_network_add_property_handler(
     BinderNetwork* net,
@@ -110,6 +177,13 @@ binder_network_add_property_handler(
     void* user_data)
     BINDER_INTERNAL;
 
+gulong
+binder_network_add_properties_handler(
+    BinderNetwork* net,
+    BinderNetworkPropertiesFunc callback,
+    void* user_data)
+    BINDER_INTERNAL;
+
 void
 binder_network_remove_handler(
     BinderNetwork* net,
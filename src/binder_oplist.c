@@ -17,11 +17,75 @@
 
 #include <ofono/netreg.h>
 
+#include <gutil_macros.h>
+
+typedef struct binder_oplist_priv {
+    BinderOpList pub;
+    GArray* array;
+    GHashTable* index; /* Key => position + 1 */
+} BinderOpListPriv;
+
+static inline BinderOpListPriv* binder_oplist_cast(BinderOpList* oplist)
+    { return G_CAST(oplist, BinderOpListPriv, pub); }
+
+static
+void
+binder_oplist_sync(
+    BinderOpListPriv* priv)
+{
+    priv->pub.op = (struct ofono_network_operator*) priv->array->data;
+    priv->pub.count = priv->array->len;
+}
+
+static
+char*
+binder_oplist_key(
+    const struct ofono_network_operator* op)
+{
+    return g_strdup_printf("%s%s:%d", op->mcc, op->mnc, op->tech);
+}
+
+static
+void
+binder_oplist_build_index(
+    BinderOpListPriv* priv)
+{
+    guint i;
+
+    priv->index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    for (i = 0; i < priv->pub.count; i++) {
+        g_hash_table_insert(priv->index, binder_oplist_key(priv->pub.op + i),
+            GUINT_TO_POINTER(i + 1));
+    }
+}
+
+static
+void
+binder_oplist_drop_index(
+    BinderOpListPriv* priv)
+{
+    if (priv->index) {
+        g_hash_table_destroy(priv->index);
+        priv->index = NULL;
+    }
+}
+
 BinderOpList*
 binder_oplist_new()
 {
-    return (BinderOpList*) g_array_new(FALSE, TRUE,
-        sizeof(struct ofono_network_operator));
+    return binder_oplist_new_sized(0);
+}
+
+BinderOpList*
+binder_oplist_new_sized(
+    guint reserved)
+{
+    BinderOpListPriv* priv = g_slice_new0(BinderOpListPriv);
+
+    priv->array = g_array_sized_new(FALSE, TRUE,
+        sizeof(struct ofono_network_operator), reserved);
+    binder_oplist_sync(priv);
+    return &priv->pub;
 }
 
 BinderOpList*
@@ -29,10 +93,36 @@ binder_oplist_set_count(
     BinderOpList* oplist,
     guint count)
 {
+    BinderOpListPriv* priv;
+
     if (!oplist) {
-        oplist = binder_oplist_new();
+        oplist = binder_oplist_new_sized(count);
+    }
+
+    /* The caller is going to fill the new entries, forget the index */
+    priv = binder_oplist_cast(oplist);
+    binder_oplist_drop_index(priv);
+    g_array_set_size(priv->array, count);
+    binder_oplist_sync(priv);
+    return oplist;
+}
+
+BinderOpList*
+binder_oplist_reserve(
+    BinderOpList* oplist,
+    guint extra)
+{
+    if (!oplist) {
+        oplist = binder_oplist_new_sized(extra);
+    } else if (extra) {
+        BinderOpListPriv* priv = binder_oplist_cast(oplist);
+        const guint len = priv->array->len;
+
+        /* GArray never shrinks its buffer */
+        g_array_set_size(priv->array, len + extra);
+        g_array_set_size(priv->array, len);
+        binder_oplist_sync(priv);
     }
-    g_array_set_size((GArray*)oplist, count);
     return oplist;
 }
 
@@ -41,19 +131,84 @@ binder_oplist_append(
     BinderOpList* oplist,
     const struct ofono_network_operator* op)
 {
+    BinderOpListPriv* priv;
+
     if (!oplist) {
         oplist = binder_oplist_new();
     }
-    g_array_append_vals((GArray*)oplist, op, 1);
+
+    priv = binder_oplist_cast(oplist);
+    g_array_append_vals(priv->array, op, 1);
+    binder_oplist_sync(priv);
+    if (priv->index) {
+        g_hash_table_insert(priv->index, binder_oplist_key(op),
+            GUINT_TO_POINTER(priv->pub.count));
+    }
     return oplist;
 }
 
+BinderOpList*
+binder_oplist_add(
+    BinderOpList* oplist,
+    const struct ofono_network_operator* op)
+{
+    BinderOpListPriv* priv;
+    char* key;
+    guint pos;
+
+    if (!oplist) {
+        oplist = binder_oplist_new();
+    }
+
+    priv = binder_oplist_cast(oplist);
+    if (!priv->index) {
+        binder_oplist_build_index(priv);
+    }
+
+    key = binder_oplist_key(op);
+    pos = GPOINTER_TO_UINT(g_hash_table_lookup(priv->index, key));
+    if (pos) {
+        struct ofono_network_operator* dest = priv->pub.op + (pos - 1);
+
+        if (op->status == OFONO_OPERATOR_STATUS_CURRENT) {
+            dest->status = op->status;
+        }
+        if (!dest->name[0] && op->name[0]) {
+            g_strlcpy(dest->name, op->name, sizeof(dest->name));
+        }
+        g_free(key);
+    } else {
+        g_array_append_vals(priv->array, op, 1);
+        binder_oplist_sync(priv);
+        g_hash_table_insert(priv->index, key,
+            GUINT_TO_POINTER(priv->pub.count));
+    }
+    return oplist;
+}
+
+BinderOpList*
+binder_oplist_copy(
+    const BinderOpList* oplist)
+{
+    if (oplist) {
+        BinderOpList* copy = binder_oplist_set_count(NULL, oplist->count);
+
+        memcpy(copy->op, oplist->op, oplist->count * sizeof(oplist->op[0]));
+        return copy;
+    }
+    return NULL;
+}
+
 void
 binder_oplist_free(
     BinderOpList* oplist)
 {
     if (oplist) {
-        g_array_free((GArray*)oplist, TRUE);
+        BinderOpListPriv* priv = binder_oplist_cast(oplist);
+
+        binder_oplist_drop_index(priv);
+        g_array_free(priv->array, TRUE);
+        gutil_slice_free(priv);
     }
 }
 
@@ -20,8 +20,14 @@
 
 /*
  * This is basically a GArray providing better type safety at compile time.
- * If NULL is passed to binder_oplist_set_count() and binder_oplist_append()
- * they allocate a new list with binder_oplist_new() and return it.
+ * If NULL is passed to binder_oplist_set_count(), binder_oplist_reserve(),
+ * binder_oplist_append() and binder_oplist_add() they allocate a new list
+ * with binder_oplist_new() and return it.
+ *
+ * binder_oplist_add() skips the operators which are already in the list
+ * (same MCC, MNC and access technology) and uses a hash table to find
+ * them. The duplicate may still upgrade the status of the existing entry
+ * to current, or supply the missing name.
  */
 typedef struct binder_oplist {
     struct ofono_network_operator* op;
@@ -38,12 +44,34 @@ binder_oplist_set_count(
     guint count)
     BINDER_INTERNAL;
 
+BinderOpList*
+binder_oplist_new_sized(
+    guint reserved)
+    BINDER_INTERNAL;
+
+BinderOpList*
+binder_oplist_reserve(
+    BinderOpList* oplist,
+    guint extra)
+    BINDER_INTERNAL;
+
 BinderOpList*
 binder_oplist_append(
     BinderOpList* oplist,
     const struct ofono_network_operator* op)
     BINDER_INTERNAL;
 
+BinderOpList*
+binder_oplist_add(
+    BinderOpList* oplist,
+    const struct ofono_network_operator* op)
+    BINDER_INTERNAL;
+
+BinderOpList*
+binder_oplist_copy(
+    const BinderOpList* oplist)
+    BINDER_INTERNAL;
+
 void
 binder_oplist_free(
     BinderOpList* oplist)
@@ -20,27 +20,37 @@
 #include "binder_cbs.h"
 #include "binder_cell_info.h"
 #include "binder_data.h"
+#include "binder_decoder.h"
 #include "binder_devinfo.h"
 #include "binder_devmon.h"
 #include "binder_gprs.h"
 #include "binder_gprs_context.h"
+#include "binder_identity.h"
 #include "binder_ims.h"
+#include "binder_ims_reg.h"
 #include "binder_log.h"
 #include "binder_logger.h"
+#include "binder_metrics.h"
 #include "binder_modem.h"
 #include "binder_netreg.h"
 #include "binder_network.h"
 #include "binder_radio.h"
 #include "binder_radio_caps.h"
 #include "binder_radio_settings.h"
+#include "binder_retry.h"
 #include "binder_sim.h"
 #include "binder_sim_card.h"
+#include "binder_sim_io_cache.h"
+#include "binder_ss_cache.h"
 #include "binder_sim_settings.h"
 #include "binder_sms.h"
+#include "binder_stats.h"
+#include "binder_stats_dbus.h"
 #include "binder_stk.h"
 #include "binder_ussd.h"
 #include "binder_util.h"
 #include "binder_voicecall.h"
+#include "binder_wakeup.h"
 
 #include "binder_ext_plugin.h"
 #include "binder_ext_slot.h"
@@ -67,6 +77,7 @@
 #include <gutil_strv.h>
 
 #include <gio/gio.h>
+#include <glib-unix.h>
 
 #include <linux/capability.h>
 #include <sys/types.h>
@@ -75,14 +86,19 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <signal.h>
 #include <pwd.h>
 #include <grp.h>
+#include <stdio.h>
 
 #define BINDER_SLOT_NUMBER_AUTOMATIC (0xffffffff)
 #define BINDER_GET_DEVICE_IDENTITY_RETRIES_LAST 2
 
 #define BINDER_CONF_FILE                "binder.conf"
 #define BINDER_CONF_LIST_DELIMITER      ','
+#define BINDER_CONF_SNAPSHOT_FILE       "binder-config"
+#define BINDER_CONF_SNAPSHOT_GROUP      "binder-config-snapshot"
+#define BINDER_CONF_SNAPSHOT_SOURCES    "Sources"
 #define BINDER_SLOT_RADIO_INTERFACE_1_0 "1.0"
 #define BINDER_SLOT_RADIO_INTERFACE_1_1 "1.1"
 #define BINDER_SLOT_RADIO_INTERFACE_1_2 "1.2"
@@ -114,8 +130,13 @@ static const char* const binder_radio_ifaces[] = {
 #define BINDER_CONF_PLUGIN_3GLTE_HANDOVER     "3GLTEHandover"
 #define BINDER_CONF_PLUGIN_MAX_NON_DATA_MODE  "MaxNonDataMode"
 #define BINDER_CONF_PLUGIN_SET_RADIO_CAP      "SetRadioCapability"
+#define BINDER_CONF_PLUGIN_FAST_CAPS_HANDOVER "FastCapsHandover"
+#define BINDER_CONF_PLUGIN_DECODE_THREAD      "DecodeThread"
+#define BINDER_CONF_PLUGIN_SLOT_THREADS       "SlotThreads"
 #define BINDER_CONF_PLUGIN_EXPECT_SLOTS       "ExpectSlots"
 #define BINDER_CONF_PLUGIN_IGNORE_SLOTS       "IgnoreSlots"
+#define BINDER_CONF_PLUGIN_STATS_DIR          "StatsDir"
+#define BINDER_CONF_PLUGIN_METRICS_FILE       "MetricsFile"
 
 /* Slot specific */
 #define BINDER_CONF_SLOT_PATH                 "path"
@@ -123,20 +144,51 @@ static const char* const binder_radio_ifaces[] = {
 #define BINDER_CONF_SLOT_EXT_PLUGIN           "extPlugin"
 #define BINDER_CONF_SLOT_RADIO_INTERFACE      "radioInterface"
 #define BINDER_CONF_SLOT_START_TIMEOUT_MS     "startTimeout"
+#define BINDER_CONF_SLOT_PARALLEL_STARTUP     "parallelStartup"
+#define BINDER_CONF_SLOT_FAST_BOOT            "fastBoot"
 #define BINDER_CONF_SLOT_REQUEST_TIMEOUT_MS   "timeout"
 #define BINDER_CONF_SLOT_DISABLE_FEATURES     "disableFeatures"
 #define BINDER_CONF_SLOT_EMPTY_PIN_QUERY      "emptyPinQuery"
 #define BINDER_CONF_SLOT_DEVMON               "deviceStateTracking"
+#define BINDER_CONF_SLOT_DISPLAY_ON_DELAY     "displayOnDelay"
+#define BINDER_CONF_SLOT_DISPLAY_OFF_DELAY    "displayOffDelay"
+#define BINDER_CONF_SLOT_CHARGER_DELAY        "chargerDelay"
+/* Prefixed with the devmon profile name, e.g. screenOffIdleIndicationFilter */
+#define BINDER_CONF_SLOT_IND_FILTER_SUFFIX    "IndicationFilter"
+#define BINDER_CONF_SLOT_CELL_INFO_SUFFIX     "CellInfoInterval"
 #define BINDER_CONF_SLOT_USE_DATA_PROFILES    "useDataProfiles"
 #define BINDER_CONF_SLOT_DEFAULT_DATA_PROFILE_ID "defaultDataProfileId"
 #define BINDER_CONF_SLOT_MMS_DATA_PROFILE_ID  "mmsDataProfileId"
 #define BINDER_CONF_SLOT_ALLOW_DATA_REQ       "allowDataReq"
+#define BINDER_CONF_SLOT_DATA_CALL_PARALLEL   "parallelDataCallSetups"
+#define BINDER_CONF_SLOT_DATA_CALL_LIST_POLL  "dataCallListPolling"
 #define BINDER_CONF_SLOT_USE_NETWORK_SCAN     "useNetworkScan"
 #define BINDER_CONF_SLOT_REPLACE_STRANGE_OPER "replaceStrangeOperatorNames"
+#define BINDER_CONF_SLOT_NETWORK_SCAN_SETTLE  "networkScanSettle"
+#define BINDER_CONF_SLOT_OPERATOR_LIST_CACHE  "operatorListCacheTime"
 #define BINDER_CONF_SLOT_SIGNAL_STRENGTH_RANGE "signalStrengthRange"
+#define BINDER_CONF_SLOT_SIGNAL_STRENGTH_WINDOW "signalStrengthWindow"
+#define BINDER_CONF_SLOT_SIGNAL_STRENGTH_THRESHOLDS "signalStrengthThresholds"
+#define BINDER_CONF_SLOT_CELL_INFO_INTERVAL_MAX "cellInfoIntervalMax"
+#define BINDER_CONF_SLOT_CELL_INFO_MAX_NEIGHBOURS "cellInfoMaxNeighbours"
+#define BINDER_CONF_SLOT_LCE_DOWNLINK         "linkCapacityDownlink"
+#define BINDER_CONF_SLOT_LCE_UPLINK           "linkCapacityUplink"
+#define BINDER_CONF_SLOT_LCE_HYSTERESIS       "linkCapacityHysteresis"
 #define BINDER_CONF_SLOT_LTE_MODE             "lteNetworkMode"
 #define BINDER_CONF_SLOT_UMTS_MODE            "umtsNetworkMode"
 #define BINDER_CONF_SLOT_TECHNOLOGIES         "technologies"
+#define BINDER_CONF_SLOT_CAPTURE_BUFFER_SIZE  "captureBufferSize"
+#define BINDER_CONF_SLOT_SIM_IO_CONCURRENCY   "simIoConcurrency"
+#define BINDER_CONF_SLOT_SIM_RECORD_PREFETCH  "simRecordPrefetch"
+#define BINDER_CONF_SLOT_SIM_STATUS_DEBOUNCE  "simStatusDebounce"
+#define BINDER_CONF_SLOT_SIM_CHANNEL_IDLE     "simChannelIdleTimeout"
+#define BINDER_CONF_SLOT_SMS_SEND_WINDOW      "smsSendWindow"
+#define BINDER_CONF_SLOT_SMS_ADAPTIVE_ROUTING "smsAdaptiveRouting"
+#define BINDER_CONF_SLOT_SMS_FALLBACK_TIMEOUT "smsFallbackTimeout"
+#define BINDER_CONF_SLOT_CLCC_POLL_WINDOW     "clccPollWindow"
+#define BINDER_CONF_SLOT_DTMF_BURST           "dtmfBurst"
+#define BINDER_CONF_SLOT_SS_CACHE_TIME        "suppServicesCacheTime"
+#define BINDER_CONF_SLOT_IMS_STATE_DEBOUNCE   "imsStateDebounce"
 
 /* Defaults */
 #define BINDER_DEFAULT_RADIO_INTERFACE        RADIO_INTERFACE_1_2
@@ -150,8 +202,14 @@ static const char* const binder_radio_ifaces[] = {
 #define BINDER_DEFAULT_SLOT_UMTS_MODE         RADIO_PREF_NET_GSM_WCDMA_AUTO
 #define BINDER_DEFAULT_SLOT_NETWORK_MODE_TIMEOUT_MS (20*1000) /* ms */
 #define BINDER_DEFAULT_SLOT_NETWORK_SELECTION_TIMEOUT_MS (100*1000) /* ms */
+#define BINDER_DEFAULT_SLOT_NETWORK_SCAN_SETTLE_MS (0) /* Full scan */
+#define BINDER_DEFAULT_SLOT_OPERATOR_LIST_CACHE_MS (0) /* No cache */
 #define BINDER_DEFAULT_SLOT_DBM_WEAK          (-100) /* 0.0000000001 mW */
 #define BINDER_DEFAULT_SLOT_DBM_STRONG        (-60)  /* 0.000001 mW */
+#define BINDER_DEFAULT_SLOT_SIGNAL_THRESHOLDS (0)
+#define BINDER_DEFAULT_SLOT_LCE_HYSTERESIS_MS (3000)
+#define BINDER_MAX_SLOT_SIGNAL_THRESHOLDS     (4)
+#define BINDER_DEFAULT_SLOT_SIGNAL_STRENGTH_WINDOW_MS (1000) /* ms */
 #define BINDER_DEFAULT_SLOT_FEATURES          BINDER_FEATURE_ALL
 #define BINDER_DEFAULT_SLOT_EMPTY_PIN_QUERY   TRUE
 #define BINDER_DEFAULT_SLOT_RADIO_POWER_CYCLE FALSE
@@ -165,12 +223,47 @@ static const char* const binder_radio_ifaces[] = {
 #define BINDER_DEFAULT_SLOT_FLAGS             OFONO_SLOT_NO_FLAGS
 #define BINDER_DEFAULT_SLOT_CELL_INFO_INTERVAL_SHORT_MS (2000) /* 2 sec */
 #define BINDER_DEFAULT_SLOT_CELL_INFO_INTERVAL_LONG_MS  (30000) /* 30 sec */
+#define BINDER_DEFAULT_SLOT_CELL_INFO_INTERVAL_MAX_MS   (0) /* Not adaptive */
+#define BINDER_DEFAULT_SLOT_CELL_INFO_MAX_NEIGHBOURS    (0) /* No limit */
 #define BINDER_DEFAULT_SLOT_REQ_TIMEOUT_MS    0 /* Use library default */
 #define BINDER_DEFAULT_SLOT_START_TIMEOUT_MS  (30*1000) /* 30 sec */
+#define BINDER_DEFAULT_SLOT_PARALLEL_STARTUP  FALSE
+#define BINDER_DEFAULT_SLOT_FAST_BOOT         FALSE
 #define BINDER_DEFAULT_SLOT_DEVMON            BINDER_DEVMON_ALL
+#define BINDER_DEFAULT_SLOT_DISPLAY_ON_DELAY_MS (250) /* ms */
+#define BINDER_DEFAULT_SLOT_DISPLAY_OFF_DELAY_MS (1000) /* ms */
+#define BINDER_DEFAULT_SLOT_CHARGER_DELAY_MS  (1000) /* ms */
+#define BINDER_DEFAULT_IND_FILTER_ON          RADIO_IND_FILTER_ALL_1_5
+#define BINDER_DEFAULT_IND_FILTER_OFF RADIO_IND_FILTER_DATA_CALL_DORMANCY
 #define BINDER_DEFAULT_SLOT_ALLOW_DATA        BINDER_ALLOW_DATA_ENABLED
 #define BINDER_DEFAULT_SLOT_DATA_CALL_RETRY_LIMIT 4
 #define BINDER_DEFAULT_SLOT_DATA_CALL_RETRY_DELAY_MS 200 /* ms */
+#define BINDER_DEFAULT_SLOT_DATA_CALL_PARALLEL 1 /* Serialized */
+#define BINDER_DEFAULT_SLOT_DATA_CALL_LIST_POLL BINDER_DATA_CALL_LIST_POLL_AUTO
+#define BINDER_DEFAULT_SLOT_CAPTURE_BUFFER_SIZE 0 /* Disabled */
+#define BINDER_MAX_SLOT_CAPTURE_BUFFER_SIZE_KB (64 * 1024) /* 64 MiB */
+#define BINDER_DEFAULT_SLOT_SIM_IO_CONCURRENCY 1
+#define BINDER_DEFAULT_SLOT_SIM_RECORD_PREFETCH 4
+#define BINDER_DEFAULT_SLOT_SIM_STATUS_DEBOUNCE_MS (100) /* ms */
+#define BINDER_DEFAULT_SLOT_SIM_CHANNEL_IDLE_MS (0) /* Disabled */
+#define BINDER_DEFAULT_SLOT_SMS_SEND_WINDOW   1 /* Strictly sequential */
+#define BINDER_DEFAULT_SLOT_SMS_ADAPTIVE_ROUTING FALSE
+#define BINDER_DEFAULT_SLOT_SMS_FALLBACK_TIMEOUT_MS (0) /* No timeout */
+#define BINDER_DEFAULT_SLOT_CLCC_POLL_WINDOW_MS (100) /* ms */
+#define BINDER_DEFAULT_SLOT_DTMF_BURST        FALSE
+#define BINDER_DEFAULT_SLOT_SS_CACHE_TIME_MS  (300000) /* 5 minutes */
+#define BINDER_DEFAULT_SLOT_IMS_STATE_DEBOUNCE_MS (0) /* Query right away */
+
+#define BINDER_CAPTURE_FILE_PREFIX            "binder-"
+#define BINDER_CAPTURE_FILE_SUFFIX            ".cap"
+#define BINDER_SIM_IO_CACHE_DIR               "binder-simio"
+#define BINDER_STARTUP_REPORT_FILE            "startup.json"
+
+/* How often the stats files are updated (if anything has changed) */
+#define BINDER_STATS_WRITE_INTERVAL_SEC       (60)
+
+/* Minimum time for which fastBoot keeps the radio powered up */
+#define BINDER_FAST_BOOT_MIN_HOLD_MS          (10*1000) /* 10 sec */
 
 /* The overall start timeout is the longest slot timeout plus this */
 #define BINDER_SLOT_REGISTRATION_TIMEOUT_MS         (10*1000) /* 10 sec */
@@ -179,10 +272,24 @@ static const char* const binder_radio_ifaces[] = {
 #define BINDER_ERROR_ID_DEATH                 "binder-death"
 #define BINDER_ERROR_ID_CAPS_SWITCH_ABORTED   "binder-caps-switch-aborted"
 
+static const BinderMetricFamily binder_plugin_metric_power_ups = {
+    "binder_power_up_transitions", BINDER_METRIC_COUNTER,
+    "Transitions of all online slots from powered off to powered on"
+};
+static const BinderMetricFamily binder_plugin_metric_power_up_time = {
+    "binder_power_up_seconds", BINDER_METRIC_COUNTER,
+    "Time spent waiting for all online slots to power up"
+};
+static const BinderMetricFamily binder_plugin_metric_power_up_max = {
+    "binder_power_up_max_seconds", BINDER_METRIC_GAUGE,
+    "Longest power up transition"
+};
+
 enum binder_plugin_client_events {
     CLIENT_EVENT_CONNECTED,
     CLIENT_EVENT_DEATH,
     CLIENT_EVENT_RADIO_STATE_CHANGED,
+    CLIENT_EVENT_MODEM_RESET,
     CLIENT_EVENT_COUNT
 };
 
@@ -197,6 +304,24 @@ enum binder_slot_events {
     SLOT_EVENT_COUNT
 };
 
+/* Milestones of the slot bring-up, in the order they normally occur */
+typedef enum binder_slot_startup_phase {
+    STARTUP_PHASE_SERVICE,      /* Radio client created */
+    STARTUP_PHASE_CONNECTED,    /* Radio client connected */
+    STARTUP_PHASE_IMEI,         /* getDeviceIdentity completed */
+    STARTUP_PHASE_SIM_STATUS,   /* First SIM status received */
+    STARTUP_PHASE_RADIO_CAPS,   /* getRadioCapability completed */
+    STARTUP_PHASE_SLOT,         /* Slot registered with ofono */
+    STARTUP_PHASE_MODEM,        /* Modem object created */
+    STARTUP_PHASE_COUNT
+} BINDER_SLOT_STARTUP_PHASE;
+
+static const char* const binder_slot_startup_phase_names[] = {
+    "service", "connected", "imei", "sim", "caps", "slot", "modem"
+};
+G_STATIC_ASSERT(G_N_ELEMENTS(binder_slot_startup_phase_names) ==
+    STARTUP_PHASE_COUNT);
+
 typedef enum binder_set_radio_cap_opt {
     BINDER_SET_RADIO_CAP_AUTO,
     BINDER_SET_RADIO_CAP_ENABLED,
@@ -229,8 +354,13 @@ typedef struct binder_plugin_identity {
 typedef struct binder_plugin_settings {
     BINDER_DATA_MANAGER_FLAGS dm_flags;
     BINDER_SET_RADIO_CAP_OPT set_radio_cap;
+    gboolean fast_caps_handover;
+    gboolean decode_thread;
+    gboolean slot_threads;
     BinderPluginIdentity identity;
     enum ofono_radio_access_mode non_data_mode;
+    char* stats_dir;
+    char* metrics_file;
 } BinderPluginSettings;
 
 typedef struct ofono_slot_driver_data {
@@ -243,11 +373,20 @@ typedef struct ofono_slot_driver_data {
     BinderLogger* radio_config_dump;
     BinderDataManager* data_manager;
     BinderRadioCapsManager* caps_manager;
+    BinderDecoder* decoder;
     BinderPluginSettings settings;
     gulong caps_manager_event_id;
     gulong radio_config_watch_id;
     gulong list_call_id;
     guint start_timeout_id;
+    guint stats_timer_id;
+    guint reload_id;
+    gint64 start_time;
+    gint64 started_time;
+    gint64 power_start; /* Zero unless some radio is powering up */
+    guint power_transitions;
+    guint64 power_total_us;
+    guint64 power_max_us;
     char* dev;
     GSList* slots;
 } BinderPlugin;
@@ -264,6 +403,7 @@ typedef struct binder_slot {
     BinderPlugin* plugin;
     BinderLogger* log_trace;
     BinderLogger* log_dump;
+    BinderLogger* log_capture;
     BinderData* data;
     BinderDevmon* devmon;
     BinderDevmonIo* devmon_io;
@@ -273,7 +413,12 @@ typedef struct binder_slot {
     BinderRadioCaps* caps;
     BinderRadioCapsRequest* caps_req;
     BinderSimCard* sim_card;
+    BinderSimIoCache* sim_io_cache;
+    BinderSsCache* ss_cache;
     BinderSimSettings* sim_settings;
+    BinderStats* stats;
+    BinderDecoder* decoder; /* With SlotThreads */
+    BinderStatsDbus* stats_dbus;
     BinderSlotConfig config;
     BinderDataOptions data_opt;
     struct ofono_slot* handle;
@@ -282,7 +427,11 @@ typedef struct binder_slot {
     enum ofono_slot_flags slot_flags;
     RadioRequest* imei_req;
     RadioRequest* caps_check_req;
+    gboolean imei_check; /* Remembered identity is not validated yet */
+    gboolean detect_version; /* radioInterface is not configured */
+    gint64 death_time; /* Monotonic, zero unless recovering */
     gulong radio_watch_id;
+    gulong radio_event_id;
     gulong list_call_id;
     gulong connected_id;
     gulong client_event_id[CLIENT_EVENT_COUNT];
@@ -295,8 +444,15 @@ typedef struct binder_slot {
     char* imei;
     char* imeisv;
     int req_timeout_ms; /* Request timeout, in milliseconds */
+    gsize capture_size; /* Capture buffer size, in bytes */
     guint start_timeout_ms;
     guint start_timeout_id;
+    gboolean parallel_startup;
+    gboolean fast_boot;
+    gboolean early_power;
+    gulong early_power_online_id;
+    guint early_power_timeout_id;
+    gint64 startup_time[STARTUP_PHASE_COUNT]; /* Monotonic, zero if not yet */
 } BinderSlot;
 
 typedef struct binder_plugin_module {
@@ -347,6 +503,25 @@ void
 binder_plugin_slot_check_radio_client(
     BinderSlot* slot);
 
+static
+void
+binder_plugin_slot_service_registration_proc(
+    GBinderServiceManager* sm,
+    const char* name,
+    void* slot);
+
+static
+const char*
+binder_plugin_radio_interface_name(
+    RADIO_INTERFACE interface);
+
+static
+void
+binder_plugin_slot_get_device_identity(
+    BinderSlot* slot,
+    gboolean blocking,
+    int retries);
+
 static
 void
 binder_plugin_check_config_client(
@@ -357,6 +532,11 @@ void
 binder_plugin_manager_started(
     BinderPlugin* plugin);
 
+static
+void
+binder_plugin_power_transition_check(
+    BinderPlugin* plugin);
+
 static
 void
 binder_logger_trace_notify(
@@ -367,6 +547,11 @@ void
 binder_logger_dump_notify(
     struct ofono_debug_desc* desc);
 
+static
+void
+binder_logger_capture_notify(
+    struct ofono_debug_desc* desc);
+
 static struct ofono_debug_desc binder_logger_trace OFONO_DEBUG_ATTR = {
     .name = "binder_trace",
     .flags = OFONO_DEBUG_FLAG_DEFAULT | OFONO_DEBUG_FLAG_HIDE_NAME,
@@ -379,6 +564,13 @@ static struct ofono_debug_desc binder_logger_dump OFONO_DEBUG_ATTR = {
     .notify = binder_logger_dump_notify
 };
 
+/* Enabling this one writes the capture buffers to files */
+static struct ofono_debug_desc binder_logger_capture OFONO_DEBUG_ATTR = {
+    .name = "binder_capture",
+    .flags = OFONO_DEBUG_FLAG_DEFAULT | OFONO_DEBUG_FLAG_HIDE_NAME,
+    .notify = binder_logger_capture_notify
+};
+
 static inline gboolean binder_plugin_multisim(BinderPlugin* plugin)
     { return plugin->slots && plugin->slots->next; }
 
@@ -487,6 +679,38 @@ binder_logger_trace_update_slot(
     }
 }
 
+static
+void
+binder_logger_capture_write_slot(
+    BinderSlot* slot)
+{
+    if (slot->log_capture) {
+        char* file = g_strconcat(BINDER_CAPTURE_FILE_PREFIX, slot->name,
+            BINDER_CAPTURE_FILE_SUFFIX, NULL);
+        char* path = g_build_filename(ofono_storage_dir(), file, NULL);
+
+        binder_logger_capture_write(slot->log_capture, path);
+        g_free(path);
+        g_free(file);
+    }
+}
+
+static
+void
+binder_plugin_slot_startup_phase(
+    BinderSlot* slot,
+    BINDER_SLOT_STARTUP_PHASE phase)
+{
+    /* Only the first occurrence counts */
+    if (!slot->startup_time[phase]) {
+        const gint64 now = g_get_monotonic_time();
+
+        slot->startup_time[phase] = now;
+        DBG("%s %s +%d ms", slot->name, binder_slot_startup_phase_names
+            [phase], (int)((now - slot->plugin->start_time) / 1000));
+    }
+}
+
 static
 void
 binder_plugin_check_if_started(
@@ -513,6 +737,77 @@ binder_plugin_check_if_started(
     }
 }
 
+static
+void
+binder_plugin_slot_release_early_power(
+    BinderSlot* slot)
+{
+    if (slot->early_power) {
+        DBG("%s releasing early power request", slot->name);
+        slot->early_power = FALSE;
+        binder_radio_remove_handler(slot->radio,
+            slot->early_power_online_id);
+        slot->early_power_online_id = 0;
+        if (slot->early_power_timeout_id) {
+            g_source_remove(slot->early_power_timeout_id);
+            slot->early_power_timeout_id = 0;
+        }
+        /* The modem has its own power request if it needs the radio */
+        binder_radio_power_off(slot->radio, slot);
+    }
+}
+
+static
+void
+binder_plugin_slot_early_power_online_cb(
+    BinderRadio* radio,
+    BINDER_RADIO_PROPERTY property,
+    void* user_data)
+{
+    if (radio->online) {
+        binder_plugin_slot_release_early_power((BinderSlot*)user_data);
+    }
+}
+
+static
+gboolean
+binder_plugin_slot_early_power_timeout(
+    gpointer user_data)
+{
+    BinderSlot* slot = user_data;
+
+    /* The modem didn't go online in time (e.g. it's in flight mode) */
+    slot->early_power_timeout_id = 0;
+    binder_plugin_slot_release_early_power(slot);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+binder_plugin_slot_early_power_on(
+    BinderSlot* slot)
+{
+    /*
+     * Unless the slot is known to be disabled, power the radio up right
+     * away, so that RF bring-up overlaps with the identity, SIM status
+     * and capability queries. The request is dropped when ofono puts
+     * the modem online (after that the modem's own request keeps the
+     * radio on) or when the startup timeout expires.
+     */
+    if (slot->fast_boot && (!slot->handle || slot->handle->enabled)) {
+        DBG("%s powering up early", slot->name);
+        slot->early_power = TRUE;
+        slot->early_power_online_id =
+            binder_radio_add_property_handler(slot->radio,
+                BINDER_RADIO_PROPERTY_ONLINE,
+                binder_plugin_slot_early_power_online_cb, slot);
+        slot->early_power_timeout_id = g_timeout_add(MAX(slot->
+            start_timeout_ms, BINDER_FAST_BOOT_MIN_HOLD_MS),
+            binder_plugin_slot_early_power_timeout, slot);
+        binder_radio_power_on(slot->radio, slot);
+    }
+}
+
 static
 void
 binder_plugin_slot_shutdown(
@@ -558,8 +853,12 @@ binder_plugin_slot_shutdown(
         }
 
         if (slot->radio) {
+            binder_plugin_slot_release_early_power(slot);
+            binder_radio_remove_handler(slot->radio, slot->radio_event_id);
             binder_radio_unref(slot->radio);
+            slot->radio_event_id = 0;
             slot->radio = NULL;
+            binder_plugin_power_transition_check(slot->plugin);
         }
 
         if (slot->network) {
@@ -579,8 +878,10 @@ binder_plugin_slot_shutdown(
         if (slot->client) {
             binder_logger_free(slot->log_trace);
             binder_logger_free(slot->log_dump);
+            binder_logger_free(slot->log_capture);
             slot->log_trace = NULL;
             slot->log_dump = NULL;
+            slot->log_capture = NULL;
 
             radio_request_drop(slot->caps_check_req);
             radio_request_drop(slot->imei_req);
@@ -590,6 +891,7 @@ binder_plugin_slot_shutdown(
             radio_client_remove_all_handlers(slot->client,
                 slot->client_event_id);
 
+            binder_stats_set_instance(slot->stats, NULL);
             radio_instance_unref(slot->instance);
             radio_client_unref(slot->client);
             slot->instance = NULL;
@@ -601,6 +903,74 @@ binder_plugin_slot_shutdown(
     }
 }
 
+static
+gboolean
+binder_plugin_slot_power_settled(
+    BinderSlot* slot)
+{
+    const BinderRadio* radio = slot->radio;
+
+    /* Powering down isn't timed, another user may keep the radio on */
+    return !radio || !radio->online || radio->state == RADIO_STATE_ON;
+}
+
+static
+void
+binder_plugin_power_transition_check(
+    BinderPlugin* plugin)
+{
+    guint online = 0, settled = 0, total = 0;
+    GSList* l;
+
+    for (l = plugin->slots; l; l = l->next) {
+        BinderSlot* slot = l->data;
+
+        if (slot->radio) {
+            total++;
+            if (slot->radio->online) {
+                online++;
+            }
+            if (binder_plugin_slot_power_settled(slot)) {
+                settled++;
+            }
+        }
+    }
+
+    /*
+     * All slots are powered up in parallel. The transition starts when
+     * the first slot is asked to go online and ends when all of those
+     * which are supposed to be online are actually on. That's what
+     * leaving the airplane mode looks like to the user.
+     */
+    if (settled < total) {
+        if (!plugin->power_start) {
+            plugin->power_start = g_get_monotonic_time();
+        }
+    } else if (plugin->power_start) {
+        const guint64 us = MAX(g_get_monotonic_time() -
+            plugin->power_start, 0);
+
+        plugin->power_start = 0;
+        plugin->power_transitions++;
+        plugin->power_total_us += us;
+        if (plugin->power_max_us < us) {
+            plugin->power_max_us = us;
+        }
+        ofono_info("%u slot(s) powered up in %u ms", online,
+            (guint) (us / 1000));
+    }
+}
+
+static
+void
+binder_plugin_slot_radio_changed(
+    BinderRadio* radio,
+    BINDER_RADIO_PROPERTY property,
+    void* user_data)
+{
+    binder_plugin_power_transition_check(((BinderSlot*)user_data)->plugin);
+}
+
 /*
  * It seems to be necessary to kick (with RADIO_REQ_SET_RADIO_POWER)
  * the modems with power on after one of the modems has been powered
@@ -638,6 +1008,21 @@ binder_plugin_radio_state_changed(
     }
 }
 
+static
+void
+binder_plugin_modem_reset(
+    RadioClient* client,
+    RADIO_IND code,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderSlot* slot = user_data;
+
+    /* Whatever we knew about the network side settings is now stale */
+    DBG("%s", slot->name);
+    binder_ss_cache_reset(slot->ss_cache);
+}
+
 static
 enum ofono_slot_sim_presence
 binder_plugin_sim_presence(BinderSlot *slot)
@@ -693,11 +1078,24 @@ binder_plugin_modem_check(
         DBG("%s registering modem", slot->name);
         modem = binder_modem_create(slot->client, slot->name, slot->path,
             slot->imei, slot->imeisv, &slot->config, slot->ext_slot,
-            slot->radio, slot->network, slot->sim_card, slot->data,
-            slot->sim_settings, slot->cell_info);
+            slot->radio, slot->network, slot->sim_card, slot->sim_io_cache,
+            slot->ss_cache, slot->stats, slot->data, slot->sim_settings,
+            slot->cell_info);
 
         if (modem) {
+            BinderPlugin* plugin = slot->plugin;
+
             slot->modem = modem;
+            binder_stats_dbus_free(slot->stats_dbus);
+            slot->stats_dbus = binder_stats_dbus_new(modem,
+                slot->decoder ? slot->decoder : plugin->decoder,
+                plugin->caps_manager);
+            binder_plugin_slot_startup_phase(slot, STARTUP_PHASE_MODEM);
+            if (slot->death_time) {
+                ofono_info("%s recovered in %d ms", slot->name, (int)
+                    ((g_get_monotonic_time() - slot->death_time) / 1000));
+                slot->death_time = 0;
+            }
         } else {
             binder_plugin_slot_shutdown(slot, TRUE);
         }
@@ -717,6 +1115,7 @@ binder_plugin_slot_enabled_changed(
         binder_plugin_modem_check(slot);
         radio_instance_set_enabled(slot->instance, TRUE);
     } else {
+        binder_plugin_slot_release_early_power(slot);
         radio_instance_set_enabled(slot->instance, FALSE);
         binder_plugin_slot_shutdown(slot, FALSE);
     }
@@ -747,6 +1146,7 @@ binder_plugin_slot_startup_check(
             slot->slot_flags);
 
         if (ofono_slot) {
+            binder_plugin_slot_startup_phase(slot, STARTUP_PHASE_SLOT);
             radio_instance_set_enabled(slot->instance, ofono_slot->enabled);
             ofono_slot_set_cell_info(ofono_slot, slot->cell_info);
             slot->slot_event_id[SLOT_EVENT_DATA_ROLE] =
@@ -760,6 +1160,14 @@ binder_plugin_slot_startup_check(
         }
     }
 
+    /* Validate the remembered identity once the slot is up and running */
+    if (slot->imei_check && slot->handle && !slot->imei_req &&
+        radio_client_connected(slot->client)) {
+        DBG("%s validating identity", slot->name);
+        slot->imei_check = FALSE;
+        binder_plugin_slot_get_device_identity(slot, FALSE, -1);
+    }
+
     binder_plugin_modem_check(slot);
     binder_plugin_check_if_started(plugin);
 }
@@ -784,7 +1192,20 @@ binder_plugin_slot_death(
     RadioClient* client,
     void* user_data)
 {
-    binder_plugin_handle_error((BinderSlot*)user_data, "binder service died");
+    BinderSlot* slot = user_data;
+
+    /* Save the last moments of the radio service for post-mortem */
+    binder_logger_capture_write_slot(slot);
+    slot->death_time = g_get_monotonic_time();
+    if (slot->imei) {
+        /*
+         * The identity doesn't change when the radio service restarts.
+         * Don't hold back the reconnect with a blocking identity query,
+         * bring the modem back right away and double-check it later.
+         */
+        slot->imei_check = TRUE;
+    }
+    binder_plugin_handle_error(slot, "binder service died");
 }
 
 static
@@ -816,6 +1237,7 @@ binder_plugin_device_identity_cb(
     GASSERT(slot->imei_req == req);
     radio_request_unref(slot->imei_req);
     slot->imei_req = NULL;
+    binder_plugin_slot_startup_phase(slot, STARTUP_PHASE_IMEI);
 
     if (status == RADIO_TX_STATUS_OK) {
         if (resp == RADIO_RESP_GET_DEVICE_IDENTITY) {
@@ -844,6 +1266,14 @@ binder_plugin_device_identity_cb(
                         slot->imei, imei);
                 }
 
+                /* Remember the identity for the next startup */
+                if (imei && imei[0]) {
+                    binder_identity_set(slot->path, BINDER_IDENTITY_IMEI,
+                        imei);
+                    binder_identity_set(slot->path, BINDER_IDENTITY_IMEISV,
+                        imeisv ? imeisv : "");
+                }
+
                 /* We assume that IMEI never changes */
                 if (!slot->imei) {
                     slot->imei = imei ? g_strdup(imei) :
@@ -879,7 +1309,7 @@ binder_plugin_slot_get_device_identity(
         RADIO_REQ_GET_DEVICE_IDENTITY, NULL,
         binder_plugin_device_identity_cb, NULL, slot);
 
-    radio_request_set_blocking(req, TRUE);
+    radio_request_set_blocking(req, blocking);
     radio_request_set_retry(req, BINDER_RETRY_MS, retries);
     radio_request_drop(slot->imei_req);
     if (radio_request_submit(req)) {
@@ -902,6 +1332,7 @@ binder_plugin_slot_sim_state_changed(
     enum ofono_slot_sim_presence presence = binder_plugin_sim_presence(slot);
 
     if (card->status) {
+        binder_plugin_slot_startup_phase(slot, STARTUP_PHASE_SIM_STATUS);
         switch (presence) {
         case OFONO_SLOT_SIM_PRESENT:
             DBG("SIM found in slot %u", slot->config.slot);
@@ -946,13 +1377,15 @@ binder_plugin_slot_radio_caps_cb(
     GASSERT(slot->caps_check_req);
     radio_request_drop(slot->caps_check_req);
     slot->caps_check_req = NULL;
+    binder_plugin_slot_startup_phase(slot, STARTUP_PHASE_RADIO_CAPS);
 
     if (cap) {
         BinderPlugin* plugin = slot->plugin;
 
         if (!plugin->caps_manager) {
             plugin->caps_manager =
-                binder_radio_caps_manager_new(plugin->data_manager);
+                binder_radio_caps_manager_new(plugin->data_manager,
+                    plugin->settings.fast_caps_handover);
             plugin->caps_manager_event_id =
                 binder_radio_caps_manager_add_tx_aborted_handler
                     (plugin->caps_manager, binder_plugin_caps_switch_aborted,
@@ -967,6 +1400,27 @@ binder_plugin_slot_radio_caps_cb(
     }
 }
 
+static
+void
+binder_plugin_slot_load_identity(
+    BinderSlot* slot)
+{
+    char* imei = binder_identity_get(slot->path, BINDER_IDENTITY_IMEI);
+
+    if (imei && imei[0]) {
+        char* imeisv = binder_identity_get(slot->path,
+            BINDER_IDENTITY_IMEISV);
+
+        DBG("%s %s %s (cached)", slot->name, imei, imeisv);
+        slot->imei = imei;
+        slot->imeisv = imeisv ? imeisv : g_strdup("");
+        slot->imei_check = TRUE;
+        binder_plugin_slot_startup_phase(slot, STARTUP_PHASE_IMEI);
+    } else {
+        g_free(imei);
+    }
+}
+
 static
 void
 binder_plugin_slot_connected(
@@ -978,6 +1432,7 @@ binder_plugin_slot_connected(
     GASSERT(radio_client_connected(slot->client));
     GASSERT(!slot->client_event_id[CLIENT_EVENT_CONNECTED]);
     DBG("%s", slot->name);
+    binder_plugin_slot_startup_phase(slot, STARTUP_PHASE_CONNECTED);
 
     /*
      * Ofono modem will be registered after getDeviceIdentity() call
@@ -986,11 +1441,28 @@ binder_plugin_slot_connected(
      * getDeviceIdentity() and retrying the request on failure
      * (hopefully) gives modem and/or adaptation enough time to
      * finish whatever is happening during initialization.
+     *
+     * Unless parallel startup is enabled, the request is blocking,
+     * i.e. SIM status and radio capability queries submitted below
+     * are held back until it completes. Otherwise all of them are
+     * sent to the modem at once.
+     *
+     * If the identity is remembered from the previous run, the slot
+     * is registered right away and the identity gets validated later.
      */
-    binder_plugin_slot_get_device_identity(slot, TRUE, -1);
+    if (!slot->imei) {
+        binder_plugin_slot_load_identity(slot);
+    }
+    if (!slot->imei_check) {
+        binder_plugin_slot_get_device_identity(slot,
+            !slot->parallel_startup, -1);
+    }
 
     GASSERT(!slot->radio);
     slot->radio = binder_radio_new(slot->client, slot->name);
+    slot->radio_event_id = binder_radio_add_property_handler(slot->radio,
+        BINDER_RADIO_PROPERTY_ANY, binder_plugin_slot_radio_changed, slot);
+    binder_plugin_slot_early_power_on(slot);
 
     /* Register RADIO_IND_RADIO_STATE_CHANGED handler only if we need one */
     GASSERT(!slot->client_event_id[CLIENT_EVENT_RADIO_STATE_CHANGED]);
@@ -1001,8 +1473,16 @@ binder_plugin_slot_connected(
                 binder_plugin_radio_state_changed, slot);
     }
 
+    /* The other end may have been restarted, don't trust the cache */
+    GASSERT(!slot->client_event_id[CLIENT_EVENT_MODEM_RESET]);
+    binder_ss_cache_reset(slot->ss_cache);
+    slot->client_event_id[CLIENT_EVENT_MODEM_RESET] =
+        radio_client_add_indication_handler(slot->client,
+            RADIO_IND_MODEM_RESET, binder_plugin_modem_reset, slot);
+
     GASSERT(!slot->sim_card);
-    slot->sim_card = binder_sim_card_new(slot->client, slot->config.slot);
+    slot->sim_card = binder_sim_card_new(slot->client, slot->config.slot,
+        slot->config.sim_status_debounce_ms);
     slot->sim_card_state_event_id =
         binder_sim_card_add_state_changed_handler(slot->sim_card,
             binder_plugin_slot_sim_state_changed, slot);
@@ -1025,8 +1505,16 @@ binder_plugin_slot_connected(
         &slot->config);
 
     GASSERT(!slot->cell_info);
+    if (ps->slot_threads) {
+        if (!slot->decoder) {
+            slot->decoder = binder_decoder_new(slot->name, TRUE);
+        }
+    } else if (!plugin->decoder) {
+        plugin->decoder = binder_decoder_new(NULL, ps->decode_thread);
+    }
     slot->cell_info = binder_cell_info_new(slot->client,
-        slot->name, slot->radio, slot->sim_card);
+        slot->name, slot->radio, slot->sim_card, slot->decoder ?
+        slot->decoder : plugin->decoder, &slot->config);
 
     GASSERT(!slot->caps);
     GASSERT(!slot->caps_check_req);
@@ -1081,6 +1569,52 @@ binder_plugin_service_list_proc(
     return FALSE;
 }
 
+static
+RADIO_INTERFACE
+binder_plugin_listed_radio_interface(
+    char** services,
+    const char* slot_name)
+{
+    int i;
+
+    /* Returns RADIO_INTERFACE_COUNT if the slot is not listed at all */
+    for (i = G_N_ELEMENTS(binder_radio_ifaces) - 1; i >= 0; i--) {
+        char* fqname = g_strconcat(binder_radio_ifaces[i], "/",
+            slot_name, NULL);
+        const gboolean found = gutil_strv_contains(services, fqname);
+
+        g_free(fqname);
+        if (found) {
+            return i;
+        }
+    }
+    return RADIO_INTERFACE_COUNT;
+}
+
+static
+void
+binder_plugin_slot_set_version(
+    BinderSlot* slot,
+    RADIO_INTERFACE version)
+{
+    ofono_info("%s radio interface %s -> %s", slot->name,
+        binder_plugin_radio_interface_name(slot->version),
+        binder_plugin_radio_interface_name(version));
+
+    /* Watch the right interface from now on */
+    slot->version = version;
+    gbinder_servicemanager_remove_handler(slot->svcmgr, slot->radio_watch_id);
+    slot->radio_watch_id =
+        gbinder_servicemanager_add_registration_handler(slot->svcmgr,
+            binder_radio_ifaces[slot->version],
+            binder_plugin_slot_service_registration_proc, slot);
+
+    /* Same as in binder_plugin_create_slot */
+    if (slot->version < RADIO_INTERFACE_1_4) {
+        slot->config.techs &= ~OFONO_RADIO_ACCESS_MODE_NR;
+    }
+}
+
 static
 gboolean
 binder_plugin_slot_service_list_proc(
@@ -1093,9 +1627,26 @@ binder_plugin_slot_service_list_proc(
         slot->name, NULL);
 
     slot->list_call_id = 0;
+    if (!gutil_strv_contains(services, fqname) && slot->detect_version &&
+        !slot->client) {
+        RADIO_INTERFACE version = binder_plugin_listed_radio_interface
+            (services, slot->name);
+
+        if (version != RADIO_INTERFACE_COUNT) {
+            binder_plugin_slot_set_version(slot, version);
+            g_free(fqname);
+            fqname = g_strconcat(binder_radio_ifaces[slot->version], "/",
+                slot->name, NULL);
+        }
+    }
+
     if (gutil_strv_contains(services, fqname)) {
         DBG("found %s", fqname);
         slot->flags |= BINDER_PLUGIN_SLOT_HAVE_RADIO_SERVICE;
+        if (slot->detect_version) {
+            binder_identity_set(slot->path, BINDER_IDENTITY_RADIO_INTERFACE,
+                binder_plugin_radio_interface_name(slot->version));
+        }
     } else {
         DBG("not found %s", fqname);
         slot->flags &= ~BINDER_PLUGIN_SLOT_HAVE_RADIO_SERVICE;
@@ -1243,6 +1794,7 @@ binder_plugin_slot_check_radio_client(
             slot->name, slot->path, slot->config.slot, slot->version);
         slot->client = radio_client_new(slot->instance);
         if (slot->client) {
+            binder_plugin_slot_startup_phase(slot, STARTUP_PHASE_SERVICE);
             radio_client_set_default_timeout(slot->client,
                 slot->req_timeout_ms);
             slot->client_event_id[CLIENT_EVENT_DEATH] =
@@ -1251,6 +1803,11 @@ binder_plugin_slot_check_radio_client(
 
             binder_logger_dump_update_slot(slot);
             binder_logger_trace_update_slot(slot);
+            if (slot->capture_size) {
+                slot->log_capture = binder_logger_new_radio_capture
+                    (slot->instance, slot->name, slot->capture_size);
+            }
+            binder_stats_set_instance(slot->stats, slot->instance);
             binder_plugin_check_data_manager(plugin);
 
             if (radio_client_connected(slot->client)) {
@@ -1337,13 +1894,28 @@ binder_plugin_parse_radio_interface(
     const char* name)
 {
     if (name) {
+        const RADIO_INTERFACE last = G_N_ELEMENTS(binder_radio_ifaces) - 1;
         RADIO_INTERFACE i;
+        guint major, minor;
 
         for (i = RADIO_INTERFACE_1_0; i < RADIO_INTERFACE_COUNT; i++ ) {
             if (!g_strcmp0(name, binder_plugin_radio_interface_name(i))) {
                 return i;
             }
         }
+
+        /*
+         * A newer HIDL service is also registered under all the older
+         * interfaces it extends, i.e. 1.6 and beyond can still be used
+         * as the latest interface we know.
+         */
+        if (sscanf(name, "%u.%u", &major, &minor) == 2 && major == 1 &&
+            minor > last) {
+            ofono_info("Radio interface %s is not supported, using %s",
+                name, binder_plugin_radio_interface_name(last));
+            return last;
+        }
+        ofono_warn("Unexpected radio interface %s", name);
     }
     return BINDER_DEFAULT_RADIO_INTERFACE;
 }
@@ -1426,39 +1998,111 @@ binder_plugin_parse_spec_params(
     return NULL;
 }
 
+static const char* binder_plugin_devmon_profile_name[] = {
+    "screenOn", "screenOnLowBattery", "screenOffCharging", "screenOffIdle",
+    "tethering"
+};
+G_STATIC_ASSERT(G_N_ELEMENTS(binder_plugin_devmon_profile_name) ==
+    BINDER_DEVMON_PROFILE_COUNT);
+
 static
-BinderSlot*
-binder_plugin_create_slot(
-    GBinderServiceManager* sm,
-    const char* name,
-    GKeyFile* file)
+void
+binder_plugin_devmon_profile_defaults(
+    BinderSlotConfig* config)
 {
-    BinderSlot* slot;
-    BinderSlotConfig* config;
-    BinderDataOptions* data_opt;
-    BinderDataProfileConfig* dpc;
-    GError* error = NULL;
-    const char* group = name;
-    GUtilInts* ints;
-    char **strv;
-    char* sval;
-    int ival;
+    BinderDevmonProfile* profile = config->devmon_profile;
+    int i;
+
+    /* These reproduce the behavior which predates the profiles */
+    for (i = 0; i < BINDER_DEVMON_PROFILE_COUNT; i++) {
+        profile[i].enabled = TRUE;
+        profile[i].ind_filter = BINDER_DEFAULT_IND_FILTER_OFF;
+        profile[i].cell_info_interval_ms = config->cell_info_interval_long_ms;
+    }
+    profile[BINDER_DEVMON_PROFILE_SCREEN_ON].ind_filter =
+        BINDER_DEFAULT_IND_FILTER_ON;
+    profile[BINDER_DEVMON_PROFILE_SCREEN_ON].cell_info_interval_ms =
+        config->cell_info_interval_short_ms;
+    profile[BINDER_DEVMON_PROFILE_SCREEN_ON_LOW_BATTERY].ind_filter =
+        BINDER_DEFAULT_IND_FILTER_ON;
+    profile[BINDER_DEVMON_PROFILE_TETHERING].enabled = FALSE;
+}
 
-    /* path */
-    sval = g_key_file_get_string(file, group, BINDER_CONF_SLOT_PATH, NULL);
-    if (sval) {
-        slot = g_new0(BinderSlot, 1);
-        slot->path = sval;
-        DBG("%s: " BINDER_CONF_SLOT_PATH " %s", group, slot->path);
-    } else {
-        /* Path is really required */
-        ofono_error("Missing path for slot %s", name);
-        return NULL;
+static
+guint
+binder_plugin_parse_lce_thresholds(
+    GKeyFile* file,
+    const char* group,
+    const char* key,
+    gint32* kbps)
+{
+    GUtilInts* ints = binder_plugin_config_get_ints(file, group, key);
+    guint i, count = 0, n = 0;
+    const int* values = gutil_ints_get_data(ints, &n);
+
+    /* Positive values in ascending order */
+    for (i = 0; i < n && count < BINDER_LCE_THRESHOLDS_MAX; i++) {
+        if (values[i] > 0 && (!count || values[i] > kbps[count - 1])) {
+            kbps[count++] = values[i];
+        } else {
+            ofono_warn("%s: ignoring %s value %d", group, key, values[i]);
+        }
+    }
+    if (count) {
+        DBG("%s: %s %u threshold(s)", group, key, count);
     }
+    gutil_ints_unref(ints);
+    return count;
+}
 
-    config = &slot->config;
-    data_opt = &slot->data_opt;
-    dpc = &config->data_profile_config;
+static
+void
+binder_plugin_parse_devmon_profiles(
+    BinderSlotConfig* config,
+    GKeyFile* file,
+    const char* group)
+{
+    int i;
+
+    for (i = 0; i < BINDER_DEVMON_PROFILE_COUNT; i++) {
+        BinderDevmonProfile* profile = config->devmon_profile + i;
+        const char* name = binder_plugin_devmon_profile_name[i];
+        char* key = g_strconcat(name, BINDER_CONF_SLOT_IND_FILTER_SUFFIX,
+            NULL);
+        int ival;
+
+        if (ofono_conf_get_mask(file, group, key, &ival,
+            "none", RADIO_IND_FILTER_NONE,
+            "all", RADIO_IND_FILTER_ALL_1_5,
+            "signalStrength", RADIO_IND_FILTER_SIGNAL_STRENGTH,
+            "fullNetworkState", RADIO_IND_FILTER_FULL_NETWORK_STATE,
+            "dataCallDormancy", RADIO_IND_FILTER_DATA_CALL_DORMANCY,
+            "linkCapacityEstimate", RADIO_IND_FILTER_LINK_CAPACITY_ESTIMATE,
+            "physicalChannelConfig", RADIO_IND_FILTER_PHYSICAL_CHANNEL_CONFIG,
+            "registrationFailure", RADIO_IND_FILTER_REGISTRATION_FAILURE,
+            "barringInfo", RADIO_IND_FILTER_BARRING_INFO, NULL)) {
+            DBG("%s: %s 0x%02x", group, key, ival);
+            profile->ind_filter = ival;
+            profile->enabled = TRUE;
+        }
+        g_free(key);
+
+        key = g_strconcat(name, BINDER_CONF_SLOT_CELL_INFO_SUFFIX, NULL);
+        if (ofono_conf_get_integer(file, group, key, &ival) && ival >= 0) {
+            DBG("%s: %s %d ms", group, key, ival);
+            profile->cell_info_interval_ms = ival;
+            profile->enabled = TRUE;
+        }
+        g_free(key);
+    }
+}
+
+static
+void
+binder_plugin_slot_config_defaults(
+    BinderSlotConfig* config)
+{
+    BinderDataProfileConfig* dpc = &config->data_profile_config;
 
     config->slot = BINDER_SLOT_NUMBER_AUTOMATIC;
     config->techs = BINDER_DEFAULT_SLOT_TECHS;
@@ -1468,8 +2112,29 @@ binder_plugin_create_slot(
         BINDER_DEFAULT_SLOT_NETWORK_MODE_TIMEOUT_MS;
     config->network_selection_timeout_ms =
         BINDER_DEFAULT_SLOT_NETWORK_SELECTION_TIMEOUT_MS;
+    config->network_scan_settle_ms =
+        BINDER_DEFAULT_SLOT_NETWORK_SCAN_SETTLE_MS;
+    config->operator_list_cache_ms =
+        BINDER_DEFAULT_SLOT_OPERATOR_LIST_CACHE_MS;
     config->signal_strength_dbm_weak = BINDER_DEFAULT_SLOT_DBM_WEAK;
     config->signal_strength_dbm_strong = BINDER_DEFAULT_SLOT_DBM_STRONG;
+    config->signal_strength_window_ms =
+        BINDER_DEFAULT_SLOT_SIGNAL_STRENGTH_WINDOW_MS;
+    config->signal_strength_thresholds = BINDER_DEFAULT_SLOT_SIGNAL_THRESHOLDS;
+    config->lce.hysteresis_ms = BINDER_DEFAULT_SLOT_LCE_HYSTERESIS_MS;
+    config->sim_io_concurrency = BINDER_DEFAULT_SLOT_SIM_IO_CONCURRENCY;
+    config->sim_record_prefetch = BINDER_DEFAULT_SLOT_SIM_RECORD_PREFETCH;
+    config->sim_status_debounce_ms =
+        BINDER_DEFAULT_SLOT_SIM_STATUS_DEBOUNCE_MS;
+    config->sim_channel_idle_ms = BINDER_DEFAULT_SLOT_SIM_CHANNEL_IDLE_MS;
+    config->sms_send_window = BINDER_DEFAULT_SLOT_SMS_SEND_WINDOW;
+    config->sms_adaptive_routing = BINDER_DEFAULT_SLOT_SMS_ADAPTIVE_ROUTING;
+    config->sms_fallback_timeout_ms =
+        BINDER_DEFAULT_SLOT_SMS_FALLBACK_TIMEOUT_MS;
+    config->clcc_poll_window_ms = BINDER_DEFAULT_SLOT_CLCC_POLL_WINDOW_MS;
+    config->dtmf_burst = BINDER_DEFAULT_SLOT_DTMF_BURST;
+    config->ss_cache_ms = BINDER_DEFAULT_SLOT_SS_CACHE_TIME_MS;
+    config->ims_state_debounce_ms = BINDER_DEFAULT_SLOT_IMS_STATE_DEBOUNCE_MS;
     config->empty_pin_query = BINDER_DEFAULT_SLOT_EMPTY_PIN_QUERY;
     config->radio_power_cycle = BINDER_DEFAULT_SLOT_RADIO_POWER_CYCLE;
     config->confirm_radio_power_on = BINDER_DEFAULT_SLOT_CONFIRM_RADIO_POWER_ON;
@@ -1483,22 +2148,37 @@ binder_plugin_create_slot(
         BINDER_DEFAULT_SLOT_CELL_INFO_INTERVAL_SHORT_MS;
     config->cell_info_interval_long_ms =
         BINDER_DEFAULT_SLOT_CELL_INFO_INTERVAL_LONG_MS;
+    config->cell_info_interval_max_ms =
+        BINDER_DEFAULT_SLOT_CELL_INFO_INTERVAL_MAX_MS;
+    config->cell_info_max_neighbours =
+        BINDER_DEFAULT_SLOT_CELL_INFO_MAX_NEIGHBOURS;
+    config->display_on_delay_ms = BINDER_DEFAULT_SLOT_DISPLAY_ON_DELAY_MS;
+    config->display_off_delay_ms = BINDER_DEFAULT_SLOT_DISPLAY_OFF_DELAY_MS;
+    config->charger_delay_ms = BINDER_DEFAULT_SLOT_CHARGER_DELAY_MS;
+    binder_plugin_devmon_profile_defaults(config);
 
     dpc->use_data_profiles = BINDER_DEFAULT_SLOT_USE_DATA_PROFILES;
     dpc->mms_profile_id = BINDER_DEFAULT_SLOT_MMS_DATA_PROFILE_ID;
     dpc->default_profile_id = BINDER_DEFAULT_SLOT_DATA_PROFILE_ID;
+}
 
-    slot->name = g_strdup(name);
-    slot->svcmgr = gbinder_servicemanager_ref(sm);
-    slot->req_timeout_ms = BINDER_DEFAULT_SLOT_REQ_TIMEOUT_MS;
-    slot->slot_flags = BINDER_DEFAULT_SLOT_FLAGS;
-    slot->start_timeout_ms = BINDER_DEFAULT_SLOT_START_TIMEOUT_MS;
-
-    data_opt->allow_data = BINDER_DEFAULT_SLOT_ALLOW_DATA;
-    data_opt->data_call_retry_limit =
-        BINDER_DEFAULT_SLOT_DATA_CALL_RETRY_LIMIT;
-    data_opt->data_call_retry_delay_ms =
-        BINDER_DEFAULT_SLOT_DATA_CALL_RETRY_DELAY_MS;
+/*
+ * Parses the part of the slot configuration which ends up in
+ * BinderSlotConfig. Nothing gets created here, so it's also used
+ * for reloading the configuration.
+ */
+static
+void
+binder_plugin_parse_slot_config(
+    BinderSlotConfig* config,
+    GKeyFile* file,
+    const char* group)
+{
+    BinderDataProfileConfig* dpc = &config->data_profile_config;
+    GError* error = NULL;
+    GUtilInts* ints;
+    char **strv;
+    int ival;
 
     /* slot */
     ival = g_key_file_get_integer(file, group,
@@ -1512,55 +2192,6 @@ binder_plugin_create_slot(
 
     /* Everything else may be in the [Settings] section */
 
-    /* extPlugin */
-    sval = ofono_conf_get_string(file, group, BINDER_CONF_SLOT_EXT_PLUGIN);
-    if (sval) {
-        GHashTable* params = g_hash_table_new_full(g_str_hash, g_str_equal,
-            g_free, g_free);
-        char* name = binder_plugin_parse_spec_params(sval, params);
-
-        if (name) {
-            slot->ext_plugin = binder_ext_plugin_get(name);
-            if (slot->ext_plugin) {
-                DBG("%s: " BINDER_CONF_SLOT_EXT_PLUGIN " %s", group, sval);
-                slot->ext_params = g_hash_table_ref(params);
-                binder_ext_plugin_ref(slot->ext_plugin);
-            } else {
-                ofono_warn("Unknown extension plugin '%s'", name);
-            }
-            g_free(name);
-        } else {
-            ofono_warn("Failed to parse extension spec '%s'", sval);
-        }
-        g_hash_table_unref(params);
-        g_free(sval);
-    }
-
-    /* radioInterface */
-    sval = ofono_conf_get_string(file, group,
-        BINDER_CONF_SLOT_RADIO_INTERFACE);
-    if (sval) {
-        DBG("%s: " BINDER_CONF_SLOT_RADIO_INTERFACE " %s", group, sval);
-        slot->version = binder_plugin_parse_radio_interface(sval);
-        g_free(sval);
-    } else {
-        slot->version = binder_plugin_detect_radio_interface(slot->svcmgr, slot->name);
-    }
-
-    /* startTimeout */
-    if (ofono_conf_get_integer(file, group,
-        BINDER_CONF_SLOT_START_TIMEOUT_MS, &ival) && ival >= 0) {
-        DBG("%s: " BINDER_CONF_SLOT_START_TIMEOUT_MS " %d ms", group, ival);
-        slot->start_timeout_ms = ival;
-    }
-
-    /* timeout */
-    if (ofono_conf_get_integer(file, group,
-        BINDER_CONF_SLOT_REQUEST_TIMEOUT_MS, &ival) && ival >= 0) {
-        DBG("%s: " BINDER_CONF_SLOT_REQUEST_TIMEOUT_MS " %d ms", group, ival);
-        slot->req_timeout_ms = ival;
-    }
-
     /* disableFeatures */
     if (ofono_conf_get_mask(file, group,
         BINDER_CONF_SLOT_DISABLE_FEATURES, &ival,
@@ -1580,31 +2211,30 @@ binder_plugin_create_slot(
         DBG("%s: " BINDER_CONF_SLOT_DISABLE_FEATURES " 0x%04x", group, ival);
     }
 
-    /* deviceStateTracking */
-    if (ofono_conf_get_mask(file, group,
-        BINDER_CONF_SLOT_DEVMON, &ival,
-        "none", BINDER_DEVMON_NONE,
-        "all", BINDER_DEVMON_ALL,
-        "ds", BINDER_DEVMON_DS,
-        "if", BINDER_DEVMON_IF, NULL) && ival) {
-        DBG("%s: " BINDER_CONF_SLOT_DEVMON " 0x%04x", group, ival);
-    } else {
-        ival = BINDER_DEFAULT_SLOT_DEVMON;
+    /* displayOnDelay */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_DISPLAY_ON_DELAY, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_DISPLAY_ON_DELAY " %d ms", group, ival);
+        config->display_on_delay_ms = ival;
     }
 
-    if (ival != BINDER_DEVMON_NONE) {
-        BinderDevmon* devmon[3];
-        int n = 0;
+    /* displayOffDelay */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_DISPLAY_OFF_DELAY, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_DISPLAY_OFF_DELAY " %d ms", group, ival);
+        config->display_off_delay_ms = ival;
+    }
 
-        if (ival & BINDER_DEVMON_DS) {
-            devmon[n++] = binder_devmon_ds_new(config);
-        }
-        if (ival & BINDER_DEVMON_IF) {
-            devmon[n++] = binder_devmon_if_new(config);
-        }
-        slot->devmon = binder_devmon_combine(devmon, n);
+    /* chargerDelay */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_CHARGER_DELAY, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_CHARGER_DELAY " %d ms", group, ival);
+        config->charger_delay_ms = ival;
     }
 
+    /* <profile>IndicationFilter and <profile>CellInfoInterval */
+    binder_plugin_parse_devmon_profiles(config, file, group);
+
     /* emptyPinQuery */
     if (ofono_conf_get_boolean(file, group,
         BINDER_CONF_SLOT_EMPTY_PIN_QUERY, &config->empty_pin_query)) {
@@ -1633,16 +2263,6 @@ binder_plugin_create_slot(
         DBG("%s: " BINDER_CONF_SLOT_MMS_DATA_PROFILE_ID " %d", group, ival);
     }
 
-    /* allowDataReq */
-    if (ofono_conf_get_enum(file, group,
-        BINDER_CONF_SLOT_ALLOW_DATA_REQ, &ival,
-        "on", BINDER_ALLOW_DATA_ENABLED,
-        "off", BINDER_ALLOW_DATA_DISABLED, NULL)) {
-        DBG("%s: " BINDER_CONF_SLOT_ALLOW_DATA_REQ " %s", group,
-            (ival == BINDER_ALLOW_DATA_ENABLED) ? "enabled": "disabled");
-        slot->data_opt.allow_data = ival;
-    }
-
     /* technologies */
     strv = ofono_conf_get_strings(file, group, BINDER_CONF_SLOT_TECHNOLOGIES, ',');
     if (strv) {
@@ -1679,11 +2299,6 @@ binder_plugin_create_slot(
         g_strfreev(strv);
     }
 
-    /* limit technologies based on radioInterface */
-    if (slot->version < RADIO_INTERFACE_1_4) {
-        config->techs &= ~OFONO_RADIO_ACCESS_MODE_NR;
-    }
-
     /* lteNetworkMode */
     if (ofono_conf_get_integer(file, group,
         BINDER_CONF_SLOT_LTE_MODE, &ival)) {
@@ -1691,45 +2306,415 @@ binder_plugin_create_slot(
         config->lte_network_mode = ival;
     }
 
-    /* umtsNetworkMode */
-    if (ofono_conf_get_integer(file, group,
-        BINDER_CONF_SLOT_UMTS_MODE, &ival)) {
-        DBG("%s: " BINDER_CONF_SLOT_UMTS_MODE " %d", group, ival);
-        config->umts_network_mode = ival;
+    /* umtsNetworkMode */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_UMTS_MODE, &ival)) {
+        DBG("%s: " BINDER_CONF_SLOT_UMTS_MODE " %d", group, ival);
+        config->umts_network_mode = ival;
+    }
+
+    /* useNetworkScan */
+    if (ofono_conf_get_boolean(file, group,
+        BINDER_CONF_SLOT_USE_NETWORK_SCAN,
+        &config->use_network_scan)) {
+        DBG("%s: " BINDER_CONF_SLOT_USE_NETWORK_SCAN " %s", group,
+            config->use_network_scan ? "yes" : "no");
+    }
+
+    /* replaceStrangeOperatorNames */
+    if (ofono_conf_get_boolean(file, group,
+        BINDER_CONF_SLOT_REPLACE_STRANGE_OPER,
+        &config->replace_strange_oper)) {
+        DBG("%s: " BINDER_CONF_SLOT_REPLACE_STRANGE_OPER " %s", group,
+            config->replace_strange_oper ? "yes" : "no");
+    }
+
+    /* networkScanSettle */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_NETWORK_SCAN_SETTLE, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_NETWORK_SCAN_SETTLE " %d ms", group,
+            ival);
+        config->network_scan_settle_ms = ival;
+    }
+
+    /* operatorListCacheTime */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_OPERATOR_LIST_CACHE, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_OPERATOR_LIST_CACHE " %d ms", group,
+            ival);
+        config->operator_list_cache_ms = ival;
+    }
+
+    /* signalStrengthRange */
+    ints = binder_plugin_config_get_ints(file, group,
+        BINDER_CONF_SLOT_SIGNAL_STRENGTH_RANGE);
+    if (gutil_ints_get_count(ints) == 2) {
+        const int* dbms = gutil_ints_get_data(ints, NULL);
+
+        /* MIN,MAX */
+        if (dbms[0] < dbms[1]) {
+            DBG("%s: " BINDER_CONF_SLOT_SIGNAL_STRENGTH_RANGE " [%d,%d]",
+                group, dbms[0], dbms[1]);
+            config->signal_strength_dbm_weak = dbms[0];
+            config->signal_strength_dbm_strong = dbms[1];
+        }
+    }
+    gutil_ints_unref(ints);
+
+    /* signalStrengthWindow */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_SIGNAL_STRENGTH_WINDOW, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_SIGNAL_STRENGTH_WINDOW " %d ms", group,
+            ival);
+        config->signal_strength_window_ms = ival;
+    }
+
+    /* signalStrengthThresholds */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_SIGNAL_STRENGTH_THRESHOLDS, &ival) && ival >= 0) {
+        config->signal_strength_thresholds =
+            MIN(ival, BINDER_MAX_SLOT_SIGNAL_THRESHOLDS);
+        DBG("%s: " BINDER_CONF_SLOT_SIGNAL_STRENGTH_THRESHOLDS " %d", group,
+            config->signal_strength_thresholds);
+    }
+
+    /* linkCapacityDownlink, linkCapacityUplink */
+    config->lce.dl_count = binder_plugin_parse_lce_thresholds(file, group,
+        BINDER_CONF_SLOT_LCE_DOWNLINK, config->lce.dl_kbps);
+    config->lce.ul_count = binder_plugin_parse_lce_thresholds(file, group,
+        BINDER_CONF_SLOT_LCE_UPLINK, config->lce.ul_kbps);
+
+    /* linkCapacityHysteresis */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_LCE_HYSTERESIS, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_LCE_HYSTERESIS " %d ms", group, ival);
+        config->lce.hysteresis_ms = ival;
+    }
+
+    /* cellInfoIntervalMax */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_CELL_INFO_INTERVAL_MAX, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_CELL_INFO_INTERVAL_MAX " %d ms", group,
+            ival);
+        config->cell_info_interval_max_ms = ival;
+    }
+
+    /* cellInfoMaxNeighbours */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_CELL_INFO_MAX_NEIGHBOURS, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_CELL_INFO_MAX_NEIGHBOURS " %d", group,
+            ival);
+        config->cell_info_max_neighbours = ival;
+    }
+
+    /* simIoConcurrency */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_SIM_IO_CONCURRENCY, &ival) && ival > 0) {
+        DBG("%s: " BINDER_CONF_SLOT_SIM_IO_CONCURRENCY " %d", group, ival);
+        config->sim_io_concurrency = ival;
+    }
+
+    /* simRecordPrefetch */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_SIM_RECORD_PREFETCH, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_SIM_RECORD_PREFETCH " %d", group, ival);
+        config->sim_record_prefetch = ival;
+    }
+
+    /* simStatusDebounce */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_SIM_STATUS_DEBOUNCE, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_SIM_STATUS_DEBOUNCE " %d ms", group,
+            ival);
+        config->sim_status_debounce_ms = ival;
+    }
+
+    /* simChannelIdleTimeout */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_SIM_CHANNEL_IDLE, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_SIM_CHANNEL_IDLE " %d ms", group, ival);
+        config->sim_channel_idle_ms = ival;
+    }
+
+    /* smsSendWindow */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_SMS_SEND_WINDOW, &ival) && ival > 0) {
+        DBG("%s: " BINDER_CONF_SLOT_SMS_SEND_WINDOW " %d", group, ival);
+        config->sms_send_window = ival;
+    }
+
+    /* smsAdaptiveRouting */
+    if (ofono_conf_get_boolean(file, group,
+        BINDER_CONF_SLOT_SMS_ADAPTIVE_ROUTING,
+        &config->sms_adaptive_routing)) {
+        DBG("%s: " BINDER_CONF_SLOT_SMS_ADAPTIVE_ROUTING " %s", group,
+            config->sms_adaptive_routing ? "yes" : "no");
+    }
+
+    /* smsFallbackTimeout */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_SMS_FALLBACK_TIMEOUT, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_SMS_FALLBACK_TIMEOUT " %d ms", group,
+            ival);
+        config->sms_fallback_timeout_ms = ival;
+    }
+
+    /* clccPollWindow */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_CLCC_POLL_WINDOW, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_CLCC_POLL_WINDOW " %d", group, ival);
+        config->clcc_poll_window_ms = ival;
+    }
+
+    /* dtmfBurst */
+    if (ofono_conf_get_boolean(file, group,
+        BINDER_CONF_SLOT_DTMF_BURST, &config->dtmf_burst)) {
+        DBG("%s: " BINDER_CONF_SLOT_DTMF_BURST " %s", group,
+            config->dtmf_burst ? "yes" : "no");
+    }
+
+    /* suppServicesCacheTime */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_SS_CACHE_TIME, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_SS_CACHE_TIME " %d ms", group, ival);
+        config->ss_cache_ms = ival;
+    }
+
+    /* imsStateDebounce */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_IMS_STATE_DEBOUNCE, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_IMS_STATE_DEBOUNCE " %d ms", group,
+            ival);
+        config->ims_state_debounce_ms = ival;
+    }
+}
+
+static
+gboolean
+binder_plugin_parse_req_timeout(
+    GKeyFile* file,
+    const char* group,
+    int* timeout_ms)
+{
+    int ival;
+
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_REQUEST_TIMEOUT_MS, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_REQUEST_TIMEOUT_MS " %d ms", group, ival);
+        *timeout_ms = ival;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+BinderSlot*
+binder_plugin_create_slot(
+    GBinderServiceManager* sm,
+    const char* name,
+    GKeyFile* file)
+{
+    BinderSlot* slot;
+    BinderSlotConfig* config;
+    BinderDataOptions* data_opt;
+    const char* group = name;
+    char* sim_io_cache_dir;
+    char* sval;
+    int ival;
+
+    /* path */
+    sval = g_key_file_get_string(file, group, BINDER_CONF_SLOT_PATH, NULL);
+    if (sval) {
+        slot = g_new0(BinderSlot, 1);
+        slot->path = sval;
+        DBG("%s: " BINDER_CONF_SLOT_PATH " %s", group, slot->path);
+    } else {
+        /* Path is really required */
+        ofono_error("Missing path for slot %s", name);
+        return NULL;
+    }
+
+    config = &slot->config;
+    data_opt = &slot->data_opt;
+    binder_plugin_slot_config_defaults(config);
+
+    slot->name = g_strdup(name);
+    slot->stats = binder_stats_new(name);
+    sim_io_cache_dir = g_build_filename(ofono_storage_dir(),
+        BINDER_SIM_IO_CACHE_DIR, NULL);
+    slot->sim_io_cache = binder_sim_io_cache_new(name, sim_io_cache_dir);
+    g_free(sim_io_cache_dir);
+    slot->ss_cache = binder_ss_cache_new(name, 0);
+    slot->svcmgr = gbinder_servicemanager_ref(sm);
+    slot->req_timeout_ms = BINDER_DEFAULT_SLOT_REQ_TIMEOUT_MS;
+    slot->slot_flags = BINDER_DEFAULT_SLOT_FLAGS;
+    slot->start_timeout_ms = BINDER_DEFAULT_SLOT_START_TIMEOUT_MS;
+    slot->parallel_startup = BINDER_DEFAULT_SLOT_PARALLEL_STARTUP;
+    slot->fast_boot = BINDER_DEFAULT_SLOT_FAST_BOOT;
+    slot->capture_size = BINDER_DEFAULT_SLOT_CAPTURE_BUFFER_SIZE;
+
+    data_opt->allow_data = BINDER_DEFAULT_SLOT_ALLOW_DATA;
+    data_opt->call_list_poll = BINDER_DEFAULT_SLOT_DATA_CALL_LIST_POLL;
+    data_opt->data_call_retry_limit =
+        BINDER_DEFAULT_SLOT_DATA_CALL_RETRY_LIMIT;
+    data_opt->data_call_retry_delay_ms =
+        BINDER_DEFAULT_SLOT_DATA_CALL_RETRY_DELAY_MS;
+    data_opt->data_call_parallel_setups =
+        BINDER_DEFAULT_SLOT_DATA_CALL_PARALLEL;
+
+    /* extPlugin */
+    sval = ofono_conf_get_string(file, group, BINDER_CONF_SLOT_EXT_PLUGIN);
+    if (sval) {
+        GHashTable* params = g_hash_table_new_full(g_str_hash, g_str_equal,
+            g_free, g_free);
+        char* name = binder_plugin_parse_spec_params(sval, params);
+
+        if (name) {
+            slot->ext_plugin = binder_ext_plugin_get(name);
+            if (slot->ext_plugin) {
+                DBG("%s: " BINDER_CONF_SLOT_EXT_PLUGIN " %s", group, sval);
+                slot->ext_params = g_hash_table_ref(params);
+                binder_ext_plugin_ref(slot->ext_plugin);
+            } else {
+                ofono_warn("Unknown extension plugin '%s'", name);
+            }
+            g_free(name);
+        } else {
+            ofono_warn("Failed to parse extension spec '%s'", sval);
+        }
+        g_hash_table_unref(params);
+        g_free(sval);
+    }
+
+    /* radioInterface */
+    sval = ofono_conf_get_string(file, group,
+        BINDER_CONF_SLOT_RADIO_INTERFACE);
+    if (sval) {
+        DBG("%s: " BINDER_CONF_SLOT_RADIO_INTERFACE " %s", group, sval);
+        slot->version = binder_plugin_parse_radio_interface(sval);
+        g_free(sval);
+    } else {
+        /*
+         * Probing hwservicemanager for each interface version blocks
+         * the startup, so it's only done if nothing is remembered for
+         * this slot. The remembered version is verified (and corrected
+         * if necessary) when the service list arrives.
+         */
+        sval = binder_identity_get(slot->path,
+            BINDER_IDENTITY_RADIO_INTERFACE);
+        if (sval) {
+            DBG("%s: remembered %s", group, sval);
+            slot->version = binder_plugin_parse_radio_interface(sval);
+            g_free(sval);
+        } else {
+            slot->version = binder_plugin_detect_radio_interface
+                (slot->svcmgr, slot->name);
+        }
+        slot->detect_version = TRUE;
+    }
+
+    /* startTimeout */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_START_TIMEOUT_MS, &ival) && ival >= 0) {
+        DBG("%s: " BINDER_CONF_SLOT_START_TIMEOUT_MS " %d ms", group, ival);
+        slot->start_timeout_ms = ival;
+    }
+
+    /* parallelStartup */
+    if (ofono_conf_get_boolean(file, group,
+        BINDER_CONF_SLOT_PARALLEL_STARTUP, &slot->parallel_startup)) {
+        DBG("%s: " BINDER_CONF_SLOT_PARALLEL_STARTUP " %s", group,
+            slot->parallel_startup ? "yes" : "no");
+    }
+
+    /* fastBoot */
+    if (ofono_conf_get_boolean(file, group,
+        BINDER_CONF_SLOT_FAST_BOOT, &slot->fast_boot)) {
+        DBG("%s: " BINDER_CONF_SLOT_FAST_BOOT " %s", group,
+            slot->fast_boot ? "yes" : "no");
+    }
+
+    /* timeout */
+    if (binder_plugin_parse_req_timeout(file, group, &slot->req_timeout_ms)) {
+        binder_stats_set_timeout(slot->stats, slot->req_timeout_ms);
+    }
+
+    /* captureBufferSize */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_CAPTURE_BUFFER_SIZE, &ival) && ival >= 0) {
+        if (ival <= BINDER_MAX_SLOT_CAPTURE_BUFFER_SIZE_KB) {
+            DBG("%s: " BINDER_CONF_SLOT_CAPTURE_BUFFER_SIZE " %d KiB",
+                group, ival);
+            slot->capture_size = (gsize)ival * 1024;
+        } else {
+            ofono_warn("%s: " BINDER_CONF_SLOT_CAPTURE_BUFFER_SIZE
+                " %d KiB is too large, ignored", group, ival);
+        }
+    }
+
+    /* The settings which only affect BinderSlotConfig */
+    binder_plugin_parse_slot_config(config, file, group);
+
+    /* deviceStateTracking */
+    if (ofono_conf_get_mask(file, group,
+        BINDER_CONF_SLOT_DEVMON, &ival,
+        "none", BINDER_DEVMON_NONE,
+        "all", BINDER_DEVMON_ALL,
+        "ds", BINDER_DEVMON_DS,
+        "if", BINDER_DEVMON_IF, NULL) && ival) {
+        DBG("%s: " BINDER_CONF_SLOT_DEVMON " 0x%04x", group, ival);
+    } else {
+        ival = BINDER_DEFAULT_SLOT_DEVMON;
+    }
+
+    if (ival != BINDER_DEVMON_NONE) {
+        BinderDevmonState* state = binder_devmon_state_new(config);
+        BinderDevmon* devmon[3];
+        int n = 0;
+
+        if (ival & BINDER_DEVMON_DS) {
+            devmon[n++] = binder_devmon_ds_new(config, state);
+        }
+        if (ival & BINDER_DEVMON_IF) {
+            devmon[n++] = binder_devmon_if_new(config, state);
+        }
+        slot->devmon = binder_devmon_combine(devmon, n);
+        binder_devmon_state_unref(state);
     }
 
-    /* useNetworkScan */
-    if (ofono_conf_get_boolean(file, group,
-        BINDER_CONF_SLOT_USE_NETWORK_SCAN,
-        &config->use_network_scan)) {
-        DBG("%s: " BINDER_CONF_SLOT_USE_NETWORK_SCAN " %s", group,
-            config->use_network_scan ? "yes" : "no");
+    /* allowDataReq */
+    if (ofono_conf_get_enum(file, group,
+        BINDER_CONF_SLOT_ALLOW_DATA_REQ, &ival,
+        "on", BINDER_ALLOW_DATA_ENABLED,
+        "off", BINDER_ALLOW_DATA_DISABLED, NULL)) {
+        DBG("%s: " BINDER_CONF_SLOT_ALLOW_DATA_REQ " %s", group,
+            (ival == BINDER_ALLOW_DATA_ENABLED) ? "enabled": "disabled");
+        slot->data_opt.allow_data = ival;
     }
 
-    /* replaceStrangeOperatorNames */
-    if (ofono_conf_get_boolean(file, group,
-        BINDER_CONF_SLOT_REPLACE_STRANGE_OPER,
-        &config->replace_strange_oper)) {
-        DBG("%s: " BINDER_CONF_SLOT_REPLACE_STRANGE_OPER " %s", group,
-            config->replace_strange_oper ? "yes" : "no");
+    /* dataCallListPolling */
+    if (ofono_conf_get_enum(file, group,
+        BINDER_CONF_SLOT_DATA_CALL_LIST_POLL, &ival,
+        "auto", BINDER_DATA_CALL_LIST_POLL_AUTO,
+        "always", BINDER_DATA_CALL_LIST_POLL_ALWAYS, NULL)) {
+        DBG("%s: " BINDER_CONF_SLOT_DATA_CALL_LIST_POLL " %s", group,
+            (ival == BINDER_DATA_CALL_LIST_POLL_AUTO) ? "auto" : "always");
+        slot->data_opt.call_list_poll = ival;
     }
 
-    /* signalStrengthRange */
-    ints = binder_plugin_config_get_ints(file, group,
-        BINDER_CONF_SLOT_SIGNAL_STRENGTH_RANGE);
-    if (gutil_ints_get_count(ints) == 2) {
-        const int* dbms = gutil_ints_get_data(ints, NULL);
+    /* parallelDataCallSetups */
+    if (ofono_conf_get_integer(file, group,
+        BINDER_CONF_SLOT_DATA_CALL_PARALLEL, &ival) && ival > 0) {
+        DBG("%s: " BINDER_CONF_SLOT_DATA_CALL_PARALLEL " %d", group, ival);
+        slot->data_opt.data_call_parallel_setups = ival;
+    }
 
-        /* MIN,MAX */
-        if (dbms[0] < dbms[1]) {
-            DBG("%s: " BINDER_CONF_SLOT_SIGNAL_STRENGTH_RANGE " [%d,%d]",
-                group, dbms[0], dbms[1]);
-            config->signal_strength_dbm_weak = dbms[0];
-            config->signal_strength_dbm_strong = dbms[1];
-        }
+    /* limit technologies based on radioInterface */
+    if (slot->version < RADIO_INTERFACE_1_4) {
+        config->techs &= ~OFONO_RADIO_ACCESS_MODE_NR;
     }
-    gutil_ints_unref(ints);
 
+    binder_ss_cache_set_max_age(slot->ss_cache, config->ss_cache_ms);
     return slot;
 }
 
@@ -1742,8 +2727,19 @@ binder_plugin_slot_free(
 
     DBG("%s", slot->name);
     binder_plugin_slot_shutdown(slot, TRUE);
+    binder_stats_dbus_free(slot->stats_dbus);
+    if (plugin) {
+        binder_stats_write(slot->stats, plugin->settings.stats_dir);
+        binder_decoder_write_stats(slot->decoder, plugin->settings.stats_dir);
+    }
+    binder_stats_free(slot->stats);
+    binder_decoder_unref(slot->decoder);
+    binder_sim_io_cache_free(slot->sim_io_cache);
+    binder_ss_cache_free(slot->ss_cache);
     binder_ext_plugin_unref(slot->ext_plugin);
-    plugin->slots = g_slist_remove(plugin->slots, slot);
+    if (plugin) {
+        plugin->slots = g_slist_remove(plugin->slots, slot);
+    }
     ofono_watch_remove_all_handlers(slot->watch, slot->watch_event_id);
     ofono_watch_unref(slot->watch);
     ofono_slot_remove_all_handlers(slot->handle, slot->slot_event_id);
@@ -1921,6 +2917,40 @@ binder_plugin_pattern_match(
     return FALSE;
 }
 
+static
+void
+binder_plugin_parse_path(
+    GKeyFile* file,
+    const char* key,
+    char** value)
+{
+    char* sval = g_key_file_get_string(file, OFONO_COMMON_SETTINGS_GROUP,
+        key, NULL);
+
+    if (sval) {
+        g_strstrip(sval);
+        if (sval[0]) {
+            DBG("%s %s", key, sval);
+            g_free(*value);
+            *value = sval;
+        } else {
+            g_free(sval);
+        }
+    }
+}
+
+static
+void
+binder_plugin_parse_stats_dir(
+    BinderPluginSettings* ps,
+    GKeyFile* file)
+{
+    binder_plugin_parse_path(file, BINDER_CONF_PLUGIN_STATS_DIR,
+        &ps->stats_dir);
+    binder_plugin_parse_path(file, BINDER_CONF_PLUGIN_METRICS_FILE,
+        &ps->metrics_file);
+}
+
 static
 void
 binder_plugin_parse_config_file(
@@ -1975,6 +3005,27 @@ binder_plugin_parse_config_file(
         ps->set_radio_cap = ival;
     }
 
+    /* FastCapsHandover */
+    if (ofono_conf_get_boolean(file, OFONO_COMMON_SETTINGS_GROUP,
+        BINDER_CONF_PLUGIN_FAST_CAPS_HANDOVER, &ps->fast_caps_handover)) {
+        DBG(BINDER_CONF_PLUGIN_FAST_CAPS_HANDOVER " %s",
+            ps->fast_caps_handover ? "yes" : "no");
+    }
+
+    /* DecodeThread */
+    if (ofono_conf_get_boolean(file, OFONO_COMMON_SETTINGS_GROUP,
+        BINDER_CONF_PLUGIN_DECODE_THREAD, &ps->decode_thread)) {
+        DBG(BINDER_CONF_PLUGIN_DECODE_THREAD " %s",
+            ps->decode_thread ? "yes" : "no");
+    }
+
+    /* SlotThreads */
+    if (ofono_conf_get_boolean(file, OFONO_COMMON_SETTINGS_GROUP,
+        BINDER_CONF_PLUGIN_SLOT_THREADS, &ps->slot_threads)) {
+        DBG(BINDER_CONF_PLUGIN_SLOT_THREADS " %s",
+            ps->slot_threads ? "yes" : "no");
+    }
+
     /* Identity */
     sval = g_key_file_get_string(file, OFONO_COMMON_SETTINGS_GROUP,
         BINDER_CONF_PLUGIN_IDENTITY, NULL);
@@ -1984,6 +3035,9 @@ binder_plugin_parse_config_file(
         g_free(sval);
     }
 
+    /* StatsDir */
+    binder_plugin_parse_stats_dir(ps, file);
+
     /* ExpectSlots */
     expect_slots = gutil_strv_remove_all(ofono_conf_get_strings(file,
         OFONO_COMMON_SETTINGS_GROUP, BINDER_CONF_PLUGIN_EXPECT_SLOTS,
@@ -2057,6 +3111,156 @@ binder_plugin_parse_config_file(
     plugin->slots = list;
 }
 
+static
+void
+binder_plugin_config_signature_add(
+    GChecksum* sum,
+    const char* path)
+{
+    struct stat st;
+
+    g_checksum_update(sum, (const guchar*) path, strlen(path) + 1);
+    if (!stat(path, &st)) {
+        const gint64 data[] = {
+            st.st_ino, st.st_size, st.st_mtim.tv_sec, st.st_mtim.tv_nsec
+        };
+
+        g_checksum_update(sum, (const guchar*) data, sizeof(data));
+    }
+}
+
+static
+int
+binder_plugin_config_path_compare(
+    gconstpointer a,
+    gconstpointer b)
+{
+    return strcmp(*(const char**)a, *(const char**)b);
+}
+
+/*
+ * The signature covers the main config file and everything in the
+ * directory next to it, where ofono_conf_merge_files() picks up the
+ * drop-ins (binder.conf => binder.d). Any change invalidates the
+ * snapshot.
+ */
+static
+char*
+binder_plugin_config_signature(
+    const char* path)
+{
+    GChecksum* sum = g_checksum_new(G_CHECKSUM_SHA1);
+    const char* dot = strrchr(path, '.');
+    const char* slash = strrchr(path, '/');
+    char* base = (dot && (!slash || dot > slash)) ?
+        g_strndup(path, dot - path) : g_strdup(path);
+    char* dirname = g_strconcat(base, ".d", NULL);
+    GDir* dir = g_dir_open(dirname, 0, NULL);
+    char* sig;
+
+    binder_plugin_config_signature_add(sum, path);
+    binder_plugin_config_signature_add(sum, dirname);
+    if (dir) {
+        GPtrArray* names = g_ptr_array_new_with_free_func(g_free);
+        const char* name;
+        guint i;
+
+        while ((name = g_dir_read_name(dir)) != NULL) {
+            g_ptr_array_add(names, g_build_filename(dirname, name, NULL));
+        }
+        g_dir_close(dir);
+
+        /* Directory order is arbitrary */
+        g_ptr_array_sort(names, binder_plugin_config_path_compare);
+        for (i = 0; i < names->len; i++) {
+            binder_plugin_config_signature_add(sum, names->pdata[i]);
+        }
+        g_ptr_array_free(names, TRUE);
+    }
+
+    sig = g_strdup(g_checksum_get_string(sum));
+    g_checksum_free(sum);
+    g_free(dirname);
+    g_free(base);
+    return sig;
+}
+
+static
+gboolean
+binder_plugin_load_config_snapshot(
+    GKeyFile* file,
+    const char* snapshot,
+    const char* sig)
+{
+    gboolean ok = FALSE;
+
+    if (g_key_file_load_from_file(file, snapshot, 0, NULL)) {
+        char* saved = g_key_file_get_string(file, BINDER_CONF_SNAPSHOT_GROUP,
+            BINDER_CONF_SNAPSHOT_SOURCES, NULL);
+
+        if (!g_strcmp0(saved, sig)) {
+            g_key_file_remove_group(file, BINDER_CONF_SNAPSHOT_GROUP, NULL);
+            ok = TRUE;
+        }
+        g_free(saved);
+    }
+    return ok;
+}
+
+static
+void
+binder_plugin_save_config_snapshot(
+    GKeyFile* file,
+    const char* snapshot,
+    const char* sig)
+{
+    GError* error = NULL;
+    gsize len = 0;
+    char* data;
+
+    g_key_file_set_string(file, BINDER_CONF_SNAPSHOT_GROUP,
+        BINDER_CONF_SNAPSHOT_SOURCES, sig);
+    data = g_key_file_to_data(file, &len, NULL);
+    g_key_file_remove_group(file, BINDER_CONF_SNAPSHOT_GROUP, NULL);
+    if (!g_file_set_contents(snapshot, data, len, &error)) {
+        DBG("%s", error->message);
+        g_error_free(error);
+    }
+    g_free(data);
+}
+
+/*
+ * binder.conf and its drop-ins are merged once and the result is kept
+ * in the storage directory together with the signature of the sources.
+ * As long as the sources remain intact, the merged config is loaded
+ * from there with a single read.
+ */
+static
+GKeyFile*
+binder_plugin_read_config(
+    const char* path)
+{
+    GKeyFile* file = g_key_file_new();
+    char* sig = binder_plugin_config_signature(path);
+    char* snapshot = g_build_filename(ofono_storage_dir(),
+        BINDER_CONF_SNAPSHOT_FILE, NULL);
+
+    g_key_file_set_list_separator(file, BINDER_CONF_LIST_DELIMITER);
+    if (binder_plugin_load_config_snapshot(file, snapshot, sig)) {
+        DBG("using %s", snapshot);
+    } else {
+        /* Start from scratch */
+        g_key_file_free(file);
+        file = g_key_file_new();
+        g_key_file_set_list_separator(file, BINDER_CONF_LIST_DELIMITER);
+        ofono_conf_merge_files(file, path);
+        binder_plugin_save_config_snapshot(file, snapshot, sig);
+    }
+    g_free(snapshot);
+    g_free(sig);
+    return file;
+}
+
 static
 void
 binder_plugin_load_config(
@@ -2065,10 +3269,7 @@ binder_plugin_load_config(
 {
     const char* dev;
     char* cfg_dev;
-    GKeyFile* file = g_key_file_new();
-
-    g_key_file_set_list_separator(file, BINDER_CONF_LIST_DELIMITER);
-    ofono_conf_merge_files(file, path);
+    GKeyFile* file = binder_plugin_read_config(path);
 
     /* Device */
     cfg_dev = g_key_file_get_string(file, OFONO_COMMON_SETTINGS_GROUP,
@@ -2184,6 +3385,8 @@ binder_plugin_slot_modem_changed(
     if (!watch->modem) {
         GASSERT(slot->modem);
         slot->modem = NULL;
+        binder_stats_dbus_free(slot->stats_dbus);
+        slot->stats_dbus = NULL;
         binder_data_allow(slot->data, OFONO_SLOT_DATA_NONE);
         binder_radio_caps_request_free(slot->caps_req);
         slot->caps_req = NULL;
@@ -2302,6 +3505,184 @@ binder_logger_slot_start(
     binder_plugin_slot_check(slot);
 }
 
+/*
+ * BinderSlotConfig fields which are copied by the objects using them
+ * (atoms, device monitors, the SIM card and such) when those get created.
+ * Changing them on the fly would leave the live objects with a mixture
+ * of old and new values, so they only take effect after a restart.
+ */
+typedef struct binder_plugin_restart_key {
+    const char* key;
+    gsize offset;
+    gsize size;
+} BinderPluginRestartKey;
+
+#define BINDER_RESTART_KEY(key,field) { key, \
+    G_STRUCT_OFFSET(BinderSlotConfig, field), \
+    sizeof(((BinderSlotConfig*)NULL)->field) }
+
+static const BinderPluginRestartKey binder_plugin_restart_keys[] = {
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_EMPTY_PIN_QUERY, empty_pin_query),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_DISPLAY_ON_DELAY,
+        display_on_delay_ms),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_DISPLAY_OFF_DELAY,
+        display_off_delay_ms),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_CHARGER_DELAY, charger_delay_ms),
+    BINDER_RESTART_KEY("*" BINDER_CONF_SLOT_IND_FILTER_SUFFIX ", *"
+        BINDER_CONF_SLOT_CELL_INFO_SUFFIX, devmon_profile),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_USE_DATA_PROFILES ", "
+        BINDER_CONF_SLOT_DEFAULT_DATA_PROFILE_ID ", "
+        BINDER_CONF_SLOT_MMS_DATA_PROFILE_ID, data_profile_config),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_LTE_MODE, lte_network_mode),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_UMTS_MODE, umts_network_mode),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_USE_NETWORK_SCAN, use_network_scan),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_REPLACE_STRANGE_OPER,
+        replace_strange_oper),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_NETWORK_SCAN_SETTLE,
+        network_scan_settle_ms),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_OPERATOR_LIST_CACHE,
+        operator_list_cache_ms),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_SIGNAL_STRENGTH_RANGE,
+        signal_strength_dbm_weak),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_SIGNAL_STRENGTH_RANGE,
+        signal_strength_dbm_strong),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_SIGNAL_STRENGTH_WINDOW,
+        signal_strength_window_ms),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_SIGNAL_STRENGTH_THRESHOLDS,
+        signal_strength_thresholds),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_LCE_DOWNLINK ", "
+        BINDER_CONF_SLOT_LCE_UPLINK ", "
+        BINDER_CONF_SLOT_LCE_HYSTERESIS, lce),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_CELL_INFO_INTERVAL_MAX,
+        cell_info_interval_max_ms),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_CELL_INFO_MAX_NEIGHBOURS,
+        cell_info_max_neighbours),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_SIM_IO_CONCURRENCY,
+        sim_io_concurrency),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_SIM_RECORD_PREFETCH,
+        sim_record_prefetch),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_SIM_STATUS_DEBOUNCE,
+        sim_status_debounce_ms),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_SIM_CHANNEL_IDLE,
+        sim_channel_idle_ms),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_SMS_SEND_WINDOW, sms_send_window),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_SMS_ADAPTIVE_ROUTING,
+        sms_adaptive_routing),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_SMS_FALLBACK_TIMEOUT,
+        sms_fallback_timeout_ms),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_CLCC_POLL_WINDOW,
+        clcc_poll_window_ms),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_DTMF_BURST, dtmf_burst),
+    BINDER_RESTART_KEY(BINDER_CONF_SLOT_IMS_STATE_DEBOUNCE,
+        ims_state_debounce_ms)
+};
+
+/*
+ * Applies the settings which can be safely changed on the fly, i.e. the
+ * request timeout and the SS cache age. The rest of the new values is
+ * only stored in the slot config, where the objects created after the
+ * modem restarts pick it up. The modem's own copy is left alone, so that
+ * the atoms probed before and after the reload see the same values.
+ * The slot number, technologies and feature mask define what kind of
+ * modem is being created and stay put.
+ */
+static
+void
+binder_plugin_slot_apply_config(
+    BinderSlot* slot,
+    const BinderSlotConfig* src,
+    int req_timeout_ms)
+{
+    BinderSlotConfig* config = &slot->config;
+    const char* last_key = NULL;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(binder_plugin_restart_keys); i++) {
+        const BinderPluginRestartKey* key = binder_plugin_restart_keys + i;
+        guint8* dest = G_STRUCT_MEMBER_P(config, key->offset);
+
+        if (memcmp(dest, G_STRUCT_MEMBER_P(src, key->offset), key->size)) {
+            memcpy(dest, G_STRUCT_MEMBER_P(src, key->offset), key->size);
+            /* Signal strength range takes two fields */
+            if (g_strcmp0(key->key, last_key)) {
+                ofono_info("%s: %s changed, takes effect after restart",
+                    slot->name, key->key);
+                last_key = key->key;
+            }
+        }
+    }
+
+    if (config->ss_cache_ms != src->ss_cache_ms) {
+        DBG("%s: ss cache %d => %d ms", slot->name, config->ss_cache_ms,
+            src->ss_cache_ms);
+        config->ss_cache_ms = src->ss_cache_ms;
+        binder_ss_cache_set_max_age(slot->ss_cache, config->ss_cache_ms);
+    }
+
+    if (slot->req_timeout_ms != req_timeout_ms) {
+        DBG("%s: timeout %d => %d ms", slot->name, slot->req_timeout_ms,
+            req_timeout_ms);
+        slot->req_timeout_ms = req_timeout_ms;
+        binder_stats_set_timeout(slot->stats, slot->req_timeout_ms);
+        if (slot->client) {
+            radio_client_set_default_timeout(slot->client,
+                slot->req_timeout_ms);
+        }
+    }
+}
+
+static
+void
+binder_plugin_reload_config(
+    BinderPlugin* plugin)
+{
+    BinderPluginSettings* ps = &plugin->settings;
+    char* path = g_build_filename(ofono_config_dir(), BINDER_CONF_FILE, NULL);
+    GKeyFile* file = binder_plugin_read_config(path);
+    GSList* l;
+
+    ofono_info("Reloading %s", path);
+
+    /* StatsDir and MetricsFile */
+    binder_plugin_parse_stats_dir(ps, file);
+    if (ps->stats_dir && g_mkdir_with_parents(ps->stats_dir, 0755) < 0) {
+        ofono_warn("Failed to create %s: %s", ps->stats_dir,
+            strerror(errno));
+    }
+    if (ps->stats_dir || ps->metrics_file) {
+        if (!plugin->stats_timer_id) {
+            plugin->stats_timer_id =
+                g_timeout_add_seconds(BINDER_STATS_WRITE_INTERVAL_SEC,
+                    binder_plugin_stats_timer, plugin);
+        }
+    }
+
+    /* Parse each slot's group from scratch and apply what's changed */
+    for (l = plugin->slots; l; l = l->next) {
+        BinderSlot* slot = l->data;
+        BinderSlotConfig config;
+        int req_timeout_ms = BINDER_DEFAULT_SLOT_REQ_TIMEOUT_MS;
+
+        memset(&config, 0, sizeof(config));
+        binder_plugin_slot_config_defaults(&config);
+        binder_plugin_parse_slot_config(&config, file, slot->name);
+        binder_plugin_parse_req_timeout(file, slot->name, &req_timeout_ms);
+        binder_plugin_slot_apply_config(slot, &config, req_timeout_ms);
+    }
+
+    g_key_file_free(file);
+    g_free(path);
+}
+
+static
+gboolean
+binder_plugin_reload_signal(
+    gpointer user_data)
+{
+    binder_plugin_reload_config((BinderPlugin*) user_data);
+    return G_SOURCE_CONTINUE;
+}
+
 static BinderPlugin*
 binder_plugin_slot_driver_init(
     struct ofono_slot_manager* sm)
@@ -2320,6 +3701,7 @@ binder_plugin_slot_driver_init(
     for (i = 0; i < G_N_ELEMENTS(binder_plugin_modules); i++) {
         binder_plugin_modules[i].init();
     }
+    plugin->start_time = g_get_monotonic_time();
     plugin->slot_manager = sm;
     binder_plugin_parse_identity(&ps->identity, BINDER_DEFAULT_PLUGIN_IDENTITY);
     ps->set_radio_cap = BINDER_SET_RADIO_CAP_AUTO;
@@ -2405,6 +3787,73 @@ binder_plugin_slot_driver_init(
     return plugin;
 }
 
+static
+void
+binder_plugin_slot_write_stats(
+    BinderSlot* slot)
+{
+    binder_stats_write(slot->stats, slot->plugin->settings.stats_dir);
+    binder_decoder_write_stats(slot->decoder,
+        slot->plugin->settings.stats_dir);
+    binder_sim_card_write_stats(slot->sim_card,
+        slot->plugin->settings.stats_dir, slot->name);
+}
+
+static
+void
+binder_plugin_write_metrics(
+    BinderPlugin* plugin)
+{
+    BinderMetrics* metrics = binder_metrics_new();
+    GSList* l;
+
+    for (l = plugin->slots; l; l = l->next) {
+        BinderSlot* slot = l->data;
+        char* labels = binder_metrics_labels("slot", slot->name, NULL);
+
+        binder_stats_add_metrics(slot->stats, metrics, labels);
+        binder_data_add_metrics(slot->data, metrics, labels);
+        binder_sim_card_add_metrics(slot->sim_card, metrics, labels);
+        if (slot->modem) {
+            binder_modem_add_metrics(slot->modem, metrics, labels);
+            binder_ims_reg_add_metrics(slot->modem->ims, metrics, labels);
+        }
+        binder_decoder_add_metrics(slot->decoder, metrics, labels);
+        g_free(labels);
+    }
+    binder_decoder_add_metrics(plugin->decoder, metrics, NULL);
+    binder_metrics_add(metrics, &binder_plugin_metric_power_ups, NULL,
+        plugin->power_transitions);
+    binder_metrics_add_seconds(metrics, &binder_plugin_metric_power_up_time,
+        NULL, plugin->power_total_us);
+    binder_metrics_add_seconds(metrics, &binder_plugin_metric_power_up_max,
+        NULL, plugin->power_max_us);
+    binder_radio_caps_manager_add_metrics(plugin->caps_manager, metrics);
+    binder_retry_add_metrics(metrics);
+    binder_wakeup_add_metrics(metrics);
+    binder_stats_add_process_metrics(metrics);
+    binder_metrics_write(metrics, plugin->settings.metrics_file);
+    binder_metrics_free(metrics);
+}
+
+static
+gboolean
+binder_plugin_stats_timer(
+    gpointer user_data)
+{
+    BinderPlugin* plugin = user_data;
+
+    binder_plugin_foreach_slot(plugin, binder_plugin_slot_write_stats);
+    binder_radio_caps_manager_write_stats(plugin->caps_manager,
+        plugin->settings.stats_dir);
+    binder_decoder_write_stats(plugin->decoder, plugin->settings.stats_dir);
+    binder_wakeup_write_stats(plugin->settings.stats_dir);
+    if (plugin->settings.metrics_file) {
+        binder_plugin_write_metrics(plugin);
+    }
+    return G_SOURCE_CONTINUE;
+}
+
 static
 void
 binder_plugin_slot_check_plugin_flags_cb(
@@ -2465,6 +3914,21 @@ binder_plugin_slot_driver_start(
     /* And per-slot IRadio services too */
     binder_plugin_foreach_slot(plugin, binder_logger_slot_start);
 
+    /* Stats are always collected but only written if configured */
+    if (ps->stats_dir && g_mkdir_with_parents(ps->stats_dir, 0755) < 0) {
+        ofono_warn("Failed to create %s: %s", ps->stats_dir,
+            strerror(errno));
+    }
+    if (ps->stats_dir || ps->metrics_file) {
+        plugin->stats_timer_id =
+            g_timeout_add_seconds(BINDER_STATS_WRITE_INTERVAL_SEC,
+                binder_plugin_stats_timer, plugin);
+    }
+
+    /* SIGHUP reloads the config */
+    plugin->reload_id = g_unix_signal_add(SIGHUP,
+        binder_plugin_reload_signal, plugin);
+
     /* Return the timeout id that can be used for cancelling the startup */
     return plugin->start_timeout_id;
 }
@@ -2502,9 +3966,24 @@ binder_plugin_slot_driver_cleanup(
             plugin->radio_config_watch_id);
         gbinder_servicemanager_unref(plugin->svcmgr);
         binder_data_manager_unref(plugin->data_manager);
+        binder_radio_caps_manager_write_stats(plugin->caps_manager,
+            plugin->settings.stats_dir);
         binder_radio_caps_manager_remove_handler(plugin->caps_manager,
             plugin->caps_manager_event_id);
         binder_radio_caps_manager_unref(plugin->caps_manager);
+        binder_decoder_write_stats(plugin->decoder,
+            plugin->settings.stats_dir);
+        binder_decoder_unref(plugin->decoder);
+        if (plugin->stats_timer_id) {
+            g_source_remove(plugin->stats_timer_id);
+        }
+        if (plugin->reload_id) {
+            g_source_remove(plugin->reload_id);
+        }
+        binder_wakeup_write_stats(plugin->settings.stats_dir);
+        binder_wakeup_cleanup();
+        g_free(plugin->settings.stats_dir);
+        g_free(plugin->settings.metrics_file);
         g_free(plugin);
     }
 }
@@ -2545,11 +4024,87 @@ binder_logger_dump_notify(
     binder_radio_config_dump_update(plugin);
 }
 
+static
+void
+binder_logger_capture_notify(
+    struct ofono_debug_desc* desc)
+{
+    if (desc->flags & OFONO_DEBUG_FLAG_PRINT) {
+        binder_plugin_foreach_slot(ofono_slot_driver_get_data
+            (binder_driver_reg), binder_logger_capture_write_slot);
+    }
+}
+
+static
+void
+binder_plugin_startup_report(
+    BinderPlugin* plugin)
+{
+    const BinderPluginSettings* ps = &plugin->settings;
+    const gint64 t0 = plugin->start_time;
+    GString* json = g_string_new(NULL);
+    GString* line = g_string_new(NULL);
+    GSList* l;
+
+    /* All times are in milliseconds since the plugin has started */
+    g_string_append_printf(json, "{\n  \"started\": %d,\n  \"slots\": {",
+        (int)((plugin->started_time - t0) / 1000));
+    for (l = plugin->slots; l; l = l->next) {
+        const BinderSlot* slot = l->data;
+        gboolean first = TRUE;
+        guint i;
+
+        g_string_truncate(line, 0);
+        g_string_append_printf(json, "%s\n    \"%s\": {\"timeout\": %u",
+            (l == plugin->slots) ? "" : ",", slot->name,
+            slot->start_timeout_ms);
+        for (i = 0; i < STARTUP_PHASE_COUNT; i++) {
+            const char* phase = binder_slot_startup_phase_names[i];
+            const gint64 t = slot->startup_time[i];
+
+            if (t) {
+                const int ms = (int)((t - t0) / 1000);
+
+                g_string_append_printf(line, "%s%s +%d", first ? "" : ", ",
+                    phase, ms);
+                g_string_append_printf(json, ", \"%s\": %d", phase, ms);
+            } else {
+                g_string_append_printf(line, "%s%s -", first ? "" : ", ",
+                    phase);
+            }
+            first = FALSE;
+        }
+        g_string_append_c(json, '}');
+        ofono_info("%s startup (ms): %s", slot->name, line->str);
+    }
+    g_string_append(json, "\n  }\n}\n");
+
+    if (ps->stats_dir) {
+        char* path = g_build_filename(ps->stats_dir,
+            BINDER_STARTUP_REPORT_FILE, NULL);
+        GError* error = NULL;
+
+        if (!g_file_set_contents(path, json->str, json->len, &error)) {
+            ofono_warn("Failed to write %s: %s", path, error->message);
+            g_error_free(error);
+        }
+        g_free(path);
+    }
+    g_string_free(line, TRUE);
+    g_string_free(json, TRUE);
+}
+
 static
 void
 binder_plugin_manager_started(
     BinderPlugin* plugin)
 {
+    plugin->started_time = g_get_monotonic_time();
+    DBG("started in %d ms", (int)((plugin->started_time -
+        plugin->start_time) / 1000));
+
+    /* Include the slots which didn't make it before they get dropped */
+    binder_plugin_startup_report(plugin);
     binder_plugin_drop_orphan_slots(plugin);
     binder_plugin_check_data_manager(plugin);
     binder_data_manager_check_data(plugin->data_manager);
@@ -16,6 +16,7 @@
 #include "binder_base.h"
 #include "binder_log.h"
 #include "binder_radio.h"
+#include "binder_retry.h"
 #include "binder_util.h"
 
 #include <radio_client.h>
@@ -45,6 +46,7 @@ typedef struct binder_radio_object {
     GHashTable* req_table;
     RadioRequest* pending_req;
     guint retry_id;
+    BinderRetry retry;
     guint state_changed_while_request_pending;
     RADIO_STATE last_known_state;
     gboolean power_cycle;
@@ -52,7 +54,8 @@ typedef struct binder_radio_object {
     gboolean next_state;
 } BinderRadioObject;
 
-#define POWER_RETRY_SECS (1)
+#define POWER_RETRY_MS     (1000)
+#define POWER_RETRY_MAX_MS (16000)
 
 typedef BinderBaseClass BinderRadioObjectClass;
 GType binder_radio_object_get_type() BINDER_INTERNAL;
@@ -135,13 +138,16 @@ binder_radio_check_state(
         if (binder_radio_state_on(self->last_known_state) == should_be_on) {
             /* All is good, cancel pending retry if there is one */
             binder_radio_cancel_retry(self);
+            binder_retry_reset(&self->retry);
         } else if (self->state_changed_while_request_pending) {
             /* Hmm... BINDER's reaction was inadequate, repeat */
             binder_radio_submit_power_request(self, should_be_on);
         } else if (!self->retry_id) {
+            const guint delay = binder_retry_next_delay(&self->retry);
+
             /* There has been no reaction so far, wait a bit */
             DBG_(self, "retry scheduled");
-            self->retry_id = g_timeout_add_seconds(POWER_RETRY_SECS,
+            self->retry_id = binder_timeout_add_coarse(delay,
                 binder_radio_power_request_retry_cb, self);
         }
     }
@@ -343,6 +349,8 @@ binder_radio_new(
     self->client = radio_client_ref(client);
     self->g = radio_request_group_new(client);
     self->log_prefix = binder_dup_prefix(log_prefix);
+    binder_retry_init(&self->retry, self->log_prefix, "power",
+        POWER_RETRY_MS, POWER_RETRY_MAX_MS);
     DBG_(self, "");
 
     self->state_event_id = radio_client_add_indication_handler(client,
@@ -547,6 +555,7 @@ binder_radio_object_finalize(
     radio_client_unref(self->client);
 
     g_hash_table_unref(self->req_table);
+    binder_retry_deinit(&self->retry);
     g_free(self->log_prefix);
 
     G_OBJECT_CLASS(PARENT_CLASS)->finalize(object);
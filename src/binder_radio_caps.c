@@ -15,11 +15,13 @@
 
 #include "binder_log.h"
 #include "binder_data.h"
+#include "binder_metrics.h"
 #include "binder_radio_caps.h"
 #include "binder_radio.h"
 #include "binder_sim_card.h"
 #include "binder_sim_settings.h"
 #include "binder_util.h"
+#include "binder_wakeup.h"
 
 #include <ofono/watch.h>
 #include <ofono/radio-settings.h>
@@ -104,16 +106,90 @@ typedef struct binder_radio_caps_object {
     RadioCapability* new_cap;
 } BinderRadioCapsObject;
 
+/* Everything that binder_radio_caps_score() depends on */
+typedef struct binder_radio_caps_score_key {
+    gboolean usable;
+    enum ofono_radio_access_mode requested_modes;
+    enum ofono_radio_access_mode modes;
+} BinderRadioCapsScoreKey;
+
+/* Steps of the transaction, timed separately */
+typedef enum binder_radio_caps_tx_step {
+    TX_STEP_NONE = -1,
+    TX_STEP_SIM_IO,         /* Waiting for SIM I/O to calm down */
+    TX_STEP_LOCK_IO,        /* Waiting for other requests to complete */
+    TX_STEP_DEACTIVATE,     /* deactivateDataCall */
+    TX_STEP_DATA_OFF,       /* setDataAllowed(false) */
+    TX_STEP_START,
+    TX_STEP_APPLY,
+    TX_STEP_FINISH,
+    TX_STEP_COUNT
+} BINDER_RADIO_CAPS_TX_STEP;
+
+static const char* binder_radio_caps_tx_step_name[] = {
+    "sim_io", "lock_io", "deactivate", "data_off", "start", "apply", "finish"
+};
+G_STATIC_ASSERT(G_N_ELEMENTS(binder_radio_caps_tx_step_name) == TX_STEP_COUNT);
+
+typedef enum binder_radio_caps_tx_result {
+    TX_RESULT_DONE,
+    TX_RESULT_ABORTED,
+    TX_RESULT_NOT_STARTED,
+    TX_RESULT_COUNT
+} BINDER_RADIO_CAPS_TX_RESULT;
+
+static const char* binder_radio_caps_tx_result_name[] = {
+    "done", "aborted", "not_started"
+};
+G_STATIC_ASSERT(G_N_ELEMENTS(binder_radio_caps_tx_result_name) ==
+    TX_RESULT_COUNT);
+
+static const BinderMetricFamily binder_radio_caps_metric_tx = {
+    "binder_radio_caps_transactions", BINDER_METRIC_COUNTER,
+    "Radio capability switch transactions"
+};
+
+/* What went wrong first and where */
+typedef struct binder_radio_caps_tx_fail {
+    int slot;               /* -1 if nothing has failed */
+    BINDER_RADIO_CAPS_TX_STEP step;
+    gboolean timeout;
+} BinderRadioCapsTxFail;
+
+typedef struct binder_radio_caps_tx_record {
+    int session;
+    BINDER_RADIO_CAPS_TX_RESULT result;
+    guint total_ms;
+    guint step_ms[TX_STEP_COUNT];
+    BinderRadioCapsTxFail fail;
+} BinderRadioCapsTxRecord;
+
+#define TX_HISTORY_SIZE (16)
+#define BINDER_RADIO_CAPS_STATS_FILE "radiocaps.stats"
+
 typedef struct binder_radio_caps_manager {
     GObject object;
     GUtilIdlePool* idle_pool;
     GPtrArray* caps_list;
-    GPtrArray* order_list;
+    guint* orders;          /* order_count permutations of caps_list */
+    guint order_count;
+    BinderRadioCapsScoreKey* score_keys; /* Inputs of the last check */
     GPtrArray* requests;
     guint check_id;
     int tx_id;
     int tx_phase_index;
     gboolean tx_failed;
+    gboolean tx_data_off_sent;
+    gboolean fast_handover;
+    BINDER_RADIO_CAPS_TX_STEP tx_step;
+    gint64 tx_start;
+    gint64 tx_step_start;
+    gint64 tx_step_us[TX_STEP_COUNT];
+    BinderRadioCapsTxFail tx_fail;
+    BinderRadioCapsTxRecord tx_history[TX_HISTORY_SIZE];
+    guint tx_history_count;     /* Total, the last ones are in the ring */
+    guint tx_result_count[TX_RESULT_COUNT];
+    gboolean stats_dirty;
     BinderDataManager* data_manager;
 } BinderRadioCapsManager;
 
@@ -255,49 +331,47 @@ binder_radio_caps_manager_remove(
     BinderRadioCapsObject* caps);
 
 static
-void
-binder_radio_caps_permutate(
-    GPtrArray* list,
-    const guint* sample,
-    guint off,
-    guint n)
+guint*
+binder_radio_caps_generate_permutations(
+    guint n,
+    guint* count)
 {
-    if (off < n) {
-        guint i;
-
-        binder_radio_caps_permutate(list, sample, off + 1, n);
-        for (i = off + 1; i < n; i++) {
-            guint* resample = gutil_memdup(sample, sizeof(guint) * n);
-
-            resample[off] = sample[i];
-            resample[i] = sample[off];
-            g_ptr_array_add(list, resample);
-            binder_radio_caps_permutate(list, resample, off + 1, n);
+    /*
+     * In a general case this gives n! of permutations (1, 2,
+     * 6, 24, ...) but typically no more than 2. They are stored
+     * in lexicographic order in a single block, the first one
+     * being the identity.
+     */
+    guint total = 1, i, k;
+    guint* table;
+    guint* order;
+
+    for (i = 2; i <= n; i++) total *= i;
+    table = g_new(guint, MAX(total * n, 1));
+    for (i = 0; i < n; i++) table[i] = i;
+
+    for (k = 1; k < total; k++) {
+        guint j, l;
+
+        /* Next permutation after the previous one */
+        order = table + k * n;
+        memcpy(order, order - n, sizeof(guint) * n);
+        j = n - 1;
+        while (order[j - 1] > order[j]) j--;
+        l = n - 1;
+        while (order[l] < order[j - 1]) l--;
+        i = order[j - 1];
+        order[j - 1] = order[l];
+        order[l] = i;
+        for (l = n - 1; j < l; j++, l--) {
+            i = order[j];
+            order[j] = order[l];
+            order[l] = i;
         }
     }
-}
-
-static
-void
-binder_radio_caps_generate_permutations(
-    GPtrArray* list,
-    guint n)
-{
-    g_ptr_array_set_size(list, 0);
-
-    if (n > 0) {
-        guint i;
-        guint* order = g_new(guint, n);
 
-        /*
-         * In a general case this gives n! of permutations (1, 2,
-         * 6, 24, ...) but typically no more than 2
-         */
-        for (i = 0; i < n; i++) order[i] = i;
-        g_ptr_array_set_free_func(list, g_free);
-        g_ptr_array_add(list, order);
-        binder_radio_caps_permutate(list, order, 0, n);
-    }
+    *count = n ? total : 0;
+    return table;
 }
 
 static
@@ -531,6 +605,20 @@ binder_radio_caps_score(
     }
 }
 
+static
+void
+binder_radio_caps_score_key(
+    const BinderRadioCapsObject* self,
+    BinderRadioCapsScoreKey* key)
+{
+    /* Zero the padding, the keys are compared with memcmp */
+    memset(key, 0, sizeof(*key));
+    key->usable = self->radio->online && self->simcard->status &&
+        self->simcard->status->card_state == RADIO_CARD_STATE_PRESENT;
+    key->requested_modes = self->requested_modes;
+    key->modes = binder_radio_caps_modes(self->cap);
+}
+
 static
 gint
 binder_radio_caps_slot_compare(
@@ -913,6 +1001,15 @@ binder_radio_caps_manager_order_str(
     }
 }
 
+static
+void
+binder_radio_caps_manager_invalidate_scores(
+    BinderRadioCapsManager* self)
+{
+    g_free(self->score_keys);
+    self->score_keys = NULL;
+}
+
 static
 const char*
 binder_radio_caps_manager_role_str(
@@ -1099,6 +1196,84 @@ binder_radio_caps_manager_issue_requests(
     }
 }
 
+static
+void
+binder_radio_caps_manager_tx_step(
+    BinderRadioCapsManager* self,
+    BINDER_RADIO_CAPS_TX_STEP step)
+{
+    const gint64 now = g_get_monotonic_time();
+
+    if (self->tx_step != TX_STEP_NONE) {
+        self->tx_step_us[self->tx_step] += now - self->tx_step_start;
+    }
+    if (step != TX_STEP_NONE) {
+        DBG("transaction %d %s", self->tx_id,
+            binder_radio_caps_tx_step_name[step]);
+    }
+    self->tx_step = step;
+    self->tx_step_start = now;
+}
+
+static
+void
+binder_radio_caps_manager_tx_failed(
+    BinderRadioCapsManager* self,
+    BinderRadioCapsObject* caps,
+    RADIO_TX_STATUS status)
+{
+    BinderRadioCapsTxFail* fail = &self->tx_fail;
+
+    /* Only the first failure is remembered */
+    if (fail->slot < 0) {
+        fail->slot = caps->slot;
+        fail->step = self->tx_step;
+        fail->timeout = (status == RADIO_TX_STATUS_TIMEOUT);
+        DBG_(caps, "transaction %d %s %s", self->tx_id,
+            (self->tx_step == TX_STEP_NONE) ? "-" :
+            binder_radio_caps_tx_step_name[self->tx_step],
+            fail->timeout ? "timed out" : "failed");
+    }
+}
+
+static
+void
+binder_radio_caps_manager_tx_report(
+    BinderRadioCapsManager* self,
+    BINDER_RADIO_CAPS_TX_RESULT result)
+{
+    BinderRadioCapsTxRecord* rec = self->tx_history +
+        (self->tx_history_count++ % TX_HISTORY_SIZE);
+    const BinderRadioCapsTxFail* fail = &self->tx_fail;
+    GString* buf = g_string_new(NULL);
+    int i;
+
+    binder_radio_caps_manager_tx_step(self, TX_STEP_NONE);
+    memset(rec, 0, sizeof(*rec));
+    rec->session = self->tx_id;
+    rec->result = result;
+    rec->total_ms = (g_get_monotonic_time() - self->tx_start) / 1000;
+    rec->fail = *fail;
+    for (i = 0; i < TX_STEP_COUNT; i++) {
+        rec->step_ms[i] = self->tx_step_us[i] / 1000;
+        if (self->tx_step_us[i]) {
+            g_string_append_printf(buf, " %s=%u",
+                binder_radio_caps_tx_step_name[i], rec->step_ms[i]);
+        }
+    }
+    if (fail->slot >= 0) {
+        g_string_append_printf(buf, " (slot %d %s %s)", fail->slot,
+            (fail->step == TX_STEP_NONE) ? "-" :
+            binder_radio_caps_tx_step_name[fail->step],
+            fail->timeout ? "timed out" : "failed");
+    }
+    self->tx_result_count[result]++;
+    self->stats_dirty = TRUE;
+    ofono_info("Radio caps transaction %d %s in %u ms%s", self->tx_id,
+        binder_radio_caps_tx_result_name[result], rec->total_ms, buf->str);
+    g_string_free(buf, TRUE);
+}
+
 static
 void
 binder_radio_caps_manager_next_transaction_cb(
@@ -1120,6 +1295,7 @@ binder_radio_caps_manager_next_transaction(
     binder_radio_caps_manager_foreach(self,
         binder_radio_caps_manager_next_transaction_cb);
     self->tx_failed = FALSE;
+    self->tx_data_off_sent = FALSE;
     self->tx_phase_index = -1;
     self->tx_id++;
     if (self->tx_id <= 0) self->tx_id = 1;
@@ -1139,6 +1315,7 @@ void
 binder_radio_caps_manager_transaction_done(
     BinderRadioCapsManager* self)
 {
+    binder_radio_caps_manager_invalidate_scores(self);
     binder_radio_caps_manager_schedule_check(self);
     binder_data_manager_assert_data_on(self->data_manager);
     binder_radio_caps_manager_foreach(self,
@@ -1190,6 +1367,8 @@ binder_radio_caps_manager_abort_transaction(
 
     /* Generate new transaction id */
     DBG("aborting transaction %d", prev_tx_id);
+    binder_radio_caps_manager_tx_report(self, TX_RESULT_ABORTED);
+    binder_radio_caps_manager_invalidate_scores(self);
     binder_radio_caps_manager_next_transaction(self);
 
     /* Re-associate the modems with the new transaction */
@@ -1250,6 +1429,7 @@ void binder_radio_caps_manager_next_phase_cb(
     }
 
     if (!ok) {
+        binder_radio_caps_manager_tx_failed(self, caps, status);
         if (!self->tx_failed) {
             self->tx_failed = TRUE;
             DBG("transaction %d failed", self->tx_id);
@@ -1283,6 +1463,7 @@ binder_radio_caps_manager_next_phase(
         guint i;
 
         DBG("transaction %d is done", self->tx_id);
+        binder_radio_caps_manager_tx_report(self, TX_RESULT_DONE);
 
         /* Update all caps before emitting signals */
         for (i = 0; i < list->len; i++) {
@@ -1310,6 +1491,8 @@ binder_radio_caps_manager_next_phase(
         const BinderRadioCapsRequestTxPhase* phase =
             binder_radio_caps_tx_phase + (++self->tx_phase_index);
 
+        binder_radio_caps_manager_tx_step(self,
+            TX_STEP_START + self->tx_phase_index);
         binder_radio_caps_manager_issue_requests(self, phase,
             binder_radio_caps_manager_next_phase_cb);
     }
@@ -1324,6 +1507,8 @@ binder_radio_caps_manager_data_off_done(
     if (!binder_radio_caps_manager_tx_pending(self)) {
         if (self->tx_failed) {
             DBG("failed to start the transaction");
+            binder_radio_caps_manager_tx_report(self,
+                TX_RESULT_NOT_STARTED);
             binder_data_manager_assert_data_on(self->data_manager);
             binder_radio_caps_manager_recheck_later(self);
             binder_radio_caps_manager_foreach(self,
@@ -1355,6 +1540,7 @@ binder_radio_caps_manager_data_disallowed(
     DBG_(caps, "tx_pending=%d", caps->tx_pending);
 
     if (status != RADIO_TX_STATUS_OK || error != RADIO_ERROR_NONE) {
+        binder_radio_caps_manager_tx_failed(self, caps, status);
         self->tx_failed = TRUE;
     }
 
@@ -1399,6 +1585,7 @@ binder_radio_caps_manager_deactivate_data_call_done(
     DBG_(caps, "tx_pending=%d", caps->tx_pending);
 
     if (status != RADIO_TX_STATUS_OK || error != RADIO_ERROR_NONE) {
+        binder_radio_caps_manager_tx_failed(self, caps, status);
         self->tx_failed = TRUE;
         /*
          * Something seems to be slightly broken, try requesting the
@@ -1408,12 +1595,18 @@ binder_radio_caps_manager_deactivate_data_call_done(
     }
 
     if (!binder_radio_caps_manager_tx_pending(self)) {
-        if (self->tx_failed) {
+        if (self->tx_data_off_sent) {
+            /* Fast handover, setDataAllowed has been sent in parallel */
+            binder_radio_caps_manager_data_off_done(self, caps);
+        } else if (self->tx_failed) {
             DBG("failed to start the transaction");
+            binder_radio_caps_manager_tx_report(self,
+                TX_RESULT_NOT_STARTED);
             binder_radio_caps_manager_recheck_later(self);
             binder_radio_caps_manager_foreach(self,
                 binder_radio_caps_manager_cancel_cb);
         } else {
+            binder_radio_caps_manager_tx_step(self, TX_STEP_DATA_OFF);
             binder_radio_caps_manager_foreach_tx(self,
                 binder_radio_caps_manager_data_off);
         }
@@ -1432,7 +1625,9 @@ binder_radio_caps_deactivate_data_call(
 
     caps->tx_pending++;
     DBG_(caps, "cid=%u, tx_pending=%d", cid, caps->tx_pending);
-    radio_request_set_blocking(req, TRUE);
+
+    /* In the fast mode, setDataAllowed goes right after it */
+    radio_request_set_blocking(req, !caps->pub.mgr->fast_handover);
     radio_request_set_timeout(req, DEACTIVATE_TIMEOUT_MS);
     radio_request_submit(req);
     radio_request_unref(req);
@@ -1471,13 +1666,24 @@ void
 binder_radio_caps_manager_deactivate_all(
     BinderRadioCapsManager* self)
 {
+    binder_radio_caps_manager_tx_step(self, TX_STEP_DEACTIVATE);
     binder_radio_caps_manager_foreach_tx(self,
         binder_radio_caps_manager_deactivate_all_cb);
     if (!binder_radio_caps_manager_tx_pending(self)) {
         /* No data calls, submit setDataAllowed requests right away */
+        binder_radio_caps_manager_tx_step(self, TX_STEP_DATA_OFF);
+        binder_radio_caps_manager_foreach_tx(self,
+            binder_radio_caps_manager_data_off);
+    } else if (self->fast_handover) {
+        /*
+         * Don't wait for the data calls to go down, disallow data on
+         * all slots at the same time. The transaction starts when all
+         * those requests have completed.
+         */
+        DBG("deactivating data calls and disallowing data together");
+        self->tx_data_off_sent = TRUE;
         binder_radio_caps_manager_foreach_tx(self,
             binder_radio_caps_manager_data_off);
-        GASSERT(binder_radio_caps_manager_tx_pending(self));
     }
 }
 
@@ -1526,6 +1732,8 @@ binder_radio_caps_manager_lock_io_for_transaction(
     gboolean can_start = TRUE;
     guint i;
 
+    binder_radio_caps_manager_tx_step(self, TX_STEP_LOCK_IO);
+
     /*
      * We want to actually start the transaction when all the involved
      * modems stop doing other things. Otherwise some modems get confused
@@ -1627,6 +1835,10 @@ binder_radio_caps_manager_start_transaction(
     /* Start the new request transaction */
     binder_radio_caps_manager_next_transaction(self);
     DBG("transaction %d", self->tx_id);
+    memset(self->tx_step_us, 0, sizeof(self->tx_step_us));
+    self->tx_fail.slot = -1;
+    self->tx_step = TX_STEP_NONE;
+    self->tx_start = g_get_monotonic_time();
 
     for (i = 0; i < list->len; i++) {
         BinderRadioCapsObject* caps = list->pdata[i];
@@ -1647,6 +1859,7 @@ binder_radio_caps_manager_start_transaction(
         DBG("nothing to do!");
     } else if (sim_io_active) {
         DBG("waiting for SIM I/O to calm down");
+        binder_radio_caps_manager_tx_step(self, TX_STEP_SIM_IO);
         binder_radio_caps_manager_foreach_tx(self,
             binder_radio_caps_manager_start_sim_io_watch);
     } else {
@@ -1669,7 +1882,7 @@ binder_radio_caps_manager_set_order(
     guint i;
 
     DBG("%s => %s",
-        binder_radio_caps_manager_order_str(self, self->order_list->pdata[0]),
+        binder_radio_caps_manager_order_str(self, self->orders),
         binder_radio_caps_manager_order_str(self, order));
 
     for (i = 0; i < list->len; i++) {
@@ -1690,21 +1903,45 @@ binder_radio_caps_manager_check(
     BinderRadioCapsManager *self)
 {
     if (binder_radio_caps_manager_can_check(self)) {
-        guint i;
         const GPtrArray* list = self->caps_list;
-        const GPtrArray* permutations = self->order_list;
+        const guint n = list->len;
+        BinderRadioCapsScoreKey* keys = g_new(BinderRadioCapsScoreKey, n);
+        int* scores;
         int highest_score = -INT_MAX, best_index = -1;
+        guint i, k;
 
-        for (i = 0; i < permutations->len; i++) {
-            const guint* order = permutations->pdata[i];
-            int score = 0;
-            guint k;
+        for (k = 0; k < n; k++) {
+            binder_radio_caps_score_key(list->pdata[k], keys + k);
+        }
+
+        if (self->score_keys && !memcmp(self->score_keys, keys,
+            sizeof(*keys) * n)) {
+            /* Nothing that affects the scores has changed */
+            DBG("nothing to do");
+            g_free(keys);
+            return;
+        }
+        g_free(self->score_keys);
+        self->score_keys = keys;
 
-            for (k = 0; k < list->len; k++) {
-                const BinderRadioCapsObject *c1 = list->pdata[k];
-                const BinderRadioCapsObject *c2 = list->pdata[order[k]];
+        /* scores[k*n + j] is the score of slot k having slot j's caps */
+        scores = g_new(int, n * n);
+        for (k = 0; k < n; k++) {
+            const BinderRadioCapsObject* c1 = list->pdata[k];
 
-                score += binder_radio_caps_score(c1, c2->cap);
+            for (i = 0; i < n; i++) {
+                const BinderRadioCapsObject* c2 = list->pdata[i];
+
+                scores[k * n + i] = binder_radio_caps_score(c1, c2->cap);
+            }
+        }
+
+        for (i = 0; i < self->order_count; i++) {
+            const guint* order = self->orders + i * n;
+            int score = 0;
+
+            for (k = 0; k < n; k++) {
+                score += scores[k * n + order[k]];
             }
 
             DBG("%s %d", binder_radio_caps_manager_order_str(self, order),
@@ -1714,10 +1951,11 @@ binder_radio_caps_manager_check(
                 best_index = i;
             }
         }
+        g_free(scores);
 
         if (best_index > 0) {
             binder_radio_caps_manager_set_order(self,
-                permutations->pdata[best_index]);
+                self->orders + best_index * n);
         }
     }
 }
@@ -1729,6 +1967,7 @@ binder_radio_caps_manager_check_cb(
 {
     BinderRadioCapsManager* self = RADIO_CAPS_MANAGER(user_data);
 
+    binder_wakeup("radio caps check");
     GASSERT(self->check_id);
     self->check_id = 0;
     binder_radio_caps_manager_check(self);
@@ -1831,8 +2070,10 @@ binder_radio_caps_manager_list_changed(
     g_ptr_array_sort(self->caps_list, binder_radio_caps_slot_compare);
 
     /* Generate full list of available permutations */
-    binder_radio_caps_generate_permutations(self->order_list,
-        self->caps_list->len);
+    g_free(self->orders);
+    self->orders = binder_radio_caps_generate_permutations
+        (self->caps_list->len, &self->order_count);
+    binder_radio_caps_manager_invalidate_scores(self);
 }
 
 static
@@ -1913,13 +2154,108 @@ binder_radio_caps_manager_unref(
     }
 }
 
+char*
+binder_radio_caps_manager_format_stats(
+    BinderRadioCapsManager* self)
+{
+    if (G_LIKELY(self)) {
+        GString* buf = g_string_new("# transactions");
+        const guint n = MIN(self->tx_history_count, TX_HISTORY_SIZE);
+        guint i;
+        int k;
+
+        for (i = 0; i < TX_RESULT_COUNT; i++) {
+            g_string_append_printf(buf, " %s=%u",
+                binder_radio_caps_tx_result_name[i],
+                self->tx_result_count[i]);
+        }
+        g_string_append(buf, "\n# session result total_ms");
+        for (k = 0; k < TX_STEP_COUNT; k++) {
+            g_string_append_printf(buf, " %s_ms",
+                binder_radio_caps_tx_step_name[k]);
+        }
+        g_string_append(buf, " fail_slot fail_step fail_timeout\n");
+
+        /* Oldest first */
+        for (i = self->tx_history_count - n; i < self->tx_history_count;
+             i++) {
+            const BinderRadioCapsTxRecord* rec = self->tx_history +
+                (i % TX_HISTORY_SIZE);
+            const BinderRadioCapsTxFail* fail = &rec->fail;
+
+            g_string_append_printf(buf, "%d %s %u", rec->session,
+                binder_radio_caps_tx_result_name[rec->result],
+                rec->total_ms);
+            for (k = 0; k < TX_STEP_COUNT; k++) {
+                g_string_append_printf(buf, " %u", rec->step_ms[k]);
+            }
+            if (fail->slot >= 0) {
+                g_string_append_printf(buf, " %d %s %d\n", fail->slot,
+                    (fail->step == TX_STEP_NONE) ? "-" :
+                    binder_radio_caps_tx_step_name[fail->step],
+                    fail->timeout);
+            } else {
+                g_string_append(buf, " - - -\n");
+            }
+        }
+        return g_string_free(buf, FALSE);
+    }
+    return NULL;
+}
+
+void
+binder_radio_caps_manager_add_metrics(
+    BinderRadioCapsManager* self,
+    BinderMetrics* metrics)
+{
+    if (G_LIKELY(self) && metrics) {
+        guint i;
+
+        for (i = 0; i < TX_RESULT_COUNT; i++) {
+            char* labels = binder_metrics_labels("result",
+                binder_radio_caps_tx_result_name[i], NULL);
+
+            binder_metrics_add(metrics, &binder_radio_caps_metric_tx, labels,
+                self->tx_result_count[i]);
+            g_free(labels);
+        }
+    }
+}
+
+gboolean
+binder_radio_caps_manager_write_stats(
+    BinderRadioCapsManager* self,
+    const char* dir)
+{
+    gboolean ok = FALSE;
+
+    if (self && dir && self->stats_dirty) {
+        char* path = g_build_filename(dir, BINDER_RADIO_CAPS_STATS_FILE, NULL);
+        char* text = binder_radio_caps_manager_format_stats(self);
+        GError* error = NULL;
+
+        if (g_file_set_contents(path, text, -1, &error)) {
+            self->stats_dirty = FALSE;
+            ok = TRUE;
+        } else {
+            ofono_warn("Failed to write %s: %s", path, error->message);
+            g_error_free(error);
+        }
+        g_free(text);
+        g_free(path);
+    }
+    return ok;
+}
+
 BinderRadioCapsManager*
 binder_radio_caps_manager_new(
-    BinderDataManager* dm)
+    BinderDataManager* dm,
+    gboolean fast_handover)
 {
     BinderRadioCapsManager* self = g_object_new(RADIO_CAPS_MANAGER_TYPE, 0);
 
     self->data_manager = binder_data_manager_ref(dm);
+    self->fast_handover = fast_handover;
     return self;
 }
 
@@ -1929,9 +2265,12 @@ binder_radio_caps_manager_init(
     BinderRadioCapsManager* self)
 {
     self->caps_list = g_ptr_array_new();
-    self->order_list = g_ptr_array_new();
+    self->orders = binder_radio_caps_generate_permutations(0,
+        &self->order_count);
     self->requests = g_ptr_array_new();
     self->tx_phase_index = -1;
+    self->tx_step = TX_STEP_NONE;
+    self->tx_fail.slot = -1;
     self->idle_pool = gutil_idle_pool_ref
         (gutil_idle_pool_get(&binder_radio_caps_shared_pool));
 }
@@ -1944,10 +2283,11 @@ binder_radio_caps_manager_finalize(
     BinderRadioCapsManager* self = RADIO_CAPS_MANAGER(object);
 
     GASSERT(!self->caps_list->len);
-    GASSERT(!self->order_list->len);
+    GASSERT(!self->order_count);
     GASSERT(!self->requests->len);
     g_ptr_array_free(self->caps_list, TRUE);
-    g_ptr_array_free(self->order_list, TRUE);
+    g_free(self->orders);
+    g_free(self->score_keys);
     g_ptr_array_free(self->requests, TRUE);
     if (self->check_id) {
         g_source_remove(self->check_id);
@@ -51,10 +51,15 @@ binder_radio_caps_check(
     G_GNUC_WARN_UNUSED_RESULT
     BINDER_INTERNAL;
 
-/* There must be a single BinderRadioCapsManager shared by all modems */
+/*
+ * There must be a single BinderRadioCapsManager shared by all modems.
+ * With fast handover, data calls are deactivated and data is disallowed
+ * at the same time rather than one after another.
+ */
 BinderRadioCapsManager*
 binder_radio_caps_manager_new(
-    BinderDataManager* data)
+    BinderDataManager* data,
+    gboolean fast_handover)
     BINDER_INTERNAL;
 
 BinderRadioCapsManager*
@@ -67,6 +72,29 @@ binder_radio_caps_manager_unref(
     BinderRadioCapsManager* mgr)
     BINDER_INTERNAL;
 
+/*
+ * Transaction counts plus the last few transactions with the time
+ * spent in each step, and the slot and step which failed first.
+ */
+char*
+binder_radio_caps_manager_format_stats(
+    BinderRadioCapsManager* mgr)
+    G_GNUC_WARN_UNUSED_RESULT
+    BINDER_INTERNAL;
+
+void
+binder_radio_caps_manager_add_metrics(
+    BinderRadioCapsManager* mgr,
+    BinderMetrics* metrics)
+    BINDER_INTERNAL;
+
+/* Writes radiocaps.stats if anything has changed */
+gboolean
+binder_radio_caps_manager_write_stats(
+    BinderRadioCapsManager* mgr,
+    const char* dir)
+    BINDER_INTERNAL;
+
 gulong
 binder_radio_caps_manager_add_tx_aborted_handler(
     BinderRadioCapsManager* mgr,
@@ -0,0 +1,414 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_req_share.h"
+#include "binder_retry.h"
+#include "binder_util.h"
+
+#include <ofono/log.h>
+
+#include <radio_client.h>
+#include <radio_request.h>
+#include <radio_util.h>
+
+#include <gbinder_writer.h>
+
+#include <gutil_macros.h>
+
+typedef struct binder_req_share_key {
+    RADIO_REQ code;
+    guint nargs;
+    gint32 args[BINDER_REQ_SHARE_MAX_ARGS];
+} BinderReqShareKey;
+
+typedef struct binder_req_share_entry {
+    BinderReqShareKey key;
+    BinderReqShare* share;
+    RadioRequest* req;
+    GSList* calls;
+    BinderRetry retry;
+    gboolean completing;
+    gboolean stale;
+} BinderReqShareEntry;
+
+typedef struct binder_req_share_call {
+    gulong id;
+    BinderReqShareEntry* entry;
+    RadioRequestCompleteFunc complete;
+    GDestroyNotify destroy;
+    void* user_data;
+} BinderReqShareCall;
+
+struct binder_req_share {
+    gint refcount;
+    RadioClient* client;
+    char* log_prefix;
+    GHashTable* entries;
+    GSList* stale;      /* Still in flight but can't be joined */
+    GHashTable* calls;
+    gulong last_id;
+    guint submitted;
+    guint joined;
+};
+
+static GHashTable* binder_req_share_table = NULL;
+
+#define DBG_(self,fmt,args...) DBG("%s" fmt, (self)->log_prefix, ##args)
+
+static
+guint
+binder_req_share_key_hash(
+    gconstpointer data)
+{
+    const BinderReqShareKey* key = data;
+    guint h = key->code;
+    guint i;
+
+    for (i = 0; i < key->nargs; i++) {
+        h = h * 31 + (guint)key->args[i];
+    }
+    return h;
+}
+
+static
+gboolean
+binder_req_share_key_equal(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const BinderReqShareKey* k1 = a;
+    const BinderReqShareKey* k2 = b;
+
+    return k1->code == k2->code && k1->nargs == k2->nargs &&
+        !memcmp(k1->args, k2->args, k1->nargs * sizeof(k1->args[0]));
+}
+
+static
+void
+binder_req_share_call_free(
+    BinderReqShareCall* call)
+{
+    if (call->destroy) {
+        call->destroy(call->user_data);
+    }
+    g_slice_free(BinderReqShareCall, call);
+}
+
+static
+void
+binder_req_share_entry_free(
+    BinderReqShareEntry* entry)
+{
+    binder_retry_deinit(&entry->retry);
+    radio_request_unref(entry->req);
+    g_slice_free(BinderReqShareEntry, entry);
+}
+
+static
+void
+binder_req_share_entry_detach(
+    BinderReqShareEntry* entry)
+{
+    BinderReqShare* self = entry->share;
+
+    if (entry->stale) {
+        self->stale = g_slist_remove(self->stale, entry);
+    } else {
+        g_hash_table_steal(self->entries, &entry->key);
+    }
+}
+
+static
+void
+binder_req_share_entry_cancel(
+    BinderReqShareEntry* entry)
+{
+    radio_request_cancel(entry->req);
+    g_slist_free_full(entry->calls, (GDestroyNotify)
+        binder_req_share_call_free);
+    binder_req_share_entry_free(entry);
+}
+
+static
+gboolean
+binder_req_share_retry(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    void* user_data)
+{
+    BinderReqShareEntry* entry = user_data;
+
+    switch (error) {
+    case RADIO_ERROR_NONE:
+    case RADIO_ERROR_RADIO_NOT_AVAILABLE:
+        binder_retry_reset(&entry->retry);
+        return FALSE;
+    default:
+        return binder_retry_request(&entry->retry, req, -1);
+    }
+}
+
+static
+void
+binder_req_share_complete(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderReqShareEntry* entry = user_data;
+    BinderReqShare* self = binder_req_share_ref(entry->share);
+
+    /* Identical queries submitted from now on get a new transaction */
+    binder_req_share_entry_detach(entry);
+    entry->completing = TRUE;
+
+    /* The callbacks may cancel the calls which haven't been invoked yet */
+    while (entry->calls) {
+        BinderReqShareCall* call = entry->calls->data;
+
+        entry->calls = g_slist_delete_link(entry->calls, entry->calls);
+        g_hash_table_remove(self->calls, GSIZE_TO_POINTER(call->id));
+        if (call->complete) {
+            call->complete(req, status, resp, error, args, call->user_data);
+        }
+        binder_req_share_call_free(call);
+    }
+
+    binder_req_share_entry_free(entry);
+    binder_req_share_unref(self);
+}
+
+static
+void
+binder_req_share_free(
+    BinderReqShare* self)
+{
+    GHashTableIter it;
+    gpointer value;
+
+    DBG_(self, "%u submitted, %u joined", self->submitted, self->joined);
+    g_hash_table_remove(binder_req_share_table, self->client);
+    if (!g_hash_table_size(binder_req_share_table)) {
+        g_hash_table_destroy(binder_req_share_table);
+        binder_req_share_table = NULL;
+    }
+
+    /* Normally, all calls have been cancelled by now */
+    g_hash_table_iter_init(&it, self->entries);
+    while (g_hash_table_iter_next(&it, NULL, &value)) {
+        g_hash_table_iter_steal(&it);
+        binder_req_share_entry_cancel(value);
+    }
+    g_slist_free_full(self->stale, (GDestroyNotify)
+        binder_req_share_entry_cancel);
+
+    g_hash_table_destroy(self->entries);
+    g_hash_table_destroy(self->calls);
+    radio_client_unref(self->client);
+    g_free(self->log_prefix);
+    g_free(self);
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderReqShare*
+binder_req_share_new(
+    RadioClient* client,
+    const char* log_prefix)
+{
+    BinderReqShare* self = binder_req_share_table ?
+        g_hash_table_lookup(binder_req_share_table, client) : NULL;
+
+    if (self) {
+        return binder_req_share_ref(self);
+    }
+
+    self = g_new0(BinderReqShare, 1);
+    g_atomic_int_set(&self->refcount, 1);
+    self->client = radio_client_ref(client);
+    self->log_prefix = binder_dup_prefix(log_prefix);
+    self->entries = g_hash_table_new(binder_req_share_key_hash,
+        binder_req_share_key_equal);
+    self->calls = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    if (!binder_req_share_table) {
+        binder_req_share_table = g_hash_table_new(g_direct_hash,
+            g_direct_equal);
+    }
+    g_hash_table_insert(binder_req_share_table, client, self);
+    return self;
+}
+
+BinderReqShare*
+binder_req_share_ref(
+    BinderReqShare* self)
+{
+    if (G_LIKELY(self)) {
+        GASSERT(self->refcount > 0);
+        g_atomic_int_inc(&self->refcount);
+    }
+    return self;
+}
+
+void
+binder_req_share_unref(
+    BinderReqShare* self)
+{
+    if (G_LIKELY(self)) {
+        GASSERT(self->refcount > 0);
+        if (g_atomic_int_dec_and_test(&self->refcount)) {
+            binder_req_share_free(self);
+        }
+    }
+}
+
+gulong
+binder_req_share_submit(
+    BinderReqShare* self,
+    RADIO_REQ code,
+    const gint32* args,
+    guint nargs,
+    guint timeout_ms,
+    RadioRequestCompleteFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    BinderReqShareEntry* entry;
+    BinderReqShareCall* call;
+    BinderReqShareKey key;
+
+    if (G_UNLIKELY(!self) || G_UNLIKELY(nargs > BINDER_REQ_SHARE_MAX_ARGS)) {
+        return 0;
+    }
+
+    memset(&key, 0, sizeof(key));
+    key.code = code;
+    key.nargs = nargs;
+    if (nargs) {
+        memcpy(key.args, args, nargs * sizeof(args[0]));
+    }
+
+    entry = g_hash_table_lookup(self->entries, &key);
+    if (entry) {
+        self->joined++;
+        DBG_(self, "joining %s", radio_req_name(code));
+    } else {
+        GBinderWriter writer;
+        guint i;
+
+        entry = g_slice_new0(BinderReqShareEntry);
+        entry->key = key;
+        entry->share = self;
+        binder_retry_init(&entry->retry, self->log_prefix,
+            "shared query", BINDER_RETRY_MS, BINDER_RETRY_MAX_MS);
+        entry->req = radio_request_new(self->client, code, &writer,
+            binder_req_share_complete, NULL, entry);
+        for (i = 0; i < nargs; i++) {
+            gbinder_writer_append_int32(&writer, args[i]);
+        }
+        radio_request_set_retry(entry->req, BINDER_RETRY_MS, -1);
+        radio_request_set_retry_func(entry->req, binder_req_share_retry);
+        if (timeout_ms) {
+            radio_request_set_timeout(entry->req, timeout_ms);
+        }
+        if (!radio_request_submit(entry->req)) {
+            DBG_(self, "failed to submit %s", radio_req_name(code));
+            binder_req_share_entry_free(entry);
+            return 0;
+        }
+        self->submitted++;
+        g_hash_table_insert(self->entries, &entry->key, entry);
+    }
+
+    call = g_slice_new0(BinderReqShareCall);
+    call->id = ++self->last_id;
+    call->entry = entry;
+    call->complete = complete;
+    call->destroy = destroy;
+    call->user_data = user_data;
+    entry->calls = g_slist_append(entry->calls, call);
+    g_hash_table_insert(self->calls, GSIZE_TO_POINTER(call->id), call);
+    return call->id;
+}
+
+void
+binder_req_share_cancel(
+    BinderReqShare* self,
+    gulong id)
+{
+    if (G_LIKELY(self) && G_LIKELY(id)) {
+        BinderReqShareCall* call = g_hash_table_lookup(self->calls,
+            GSIZE_TO_POINTER(id));
+
+        if (call) {
+            BinderReqShareEntry* entry = call->entry;
+
+            g_hash_table_remove(self->calls, GSIZE_TO_POINTER(id));
+            entry->calls = g_slist_remove(entry->calls, call);
+            binder_req_share_call_free(call);
+
+            /* Nobody is waiting for the response anymore */
+            if (!entry->calls && !entry->completing) {
+                binder_req_share_entry_detach(entry);
+                radio_request_cancel(entry->req);
+                binder_req_share_entry_free(entry);
+            }
+        }
+    }
+}
+
+void
+binder_req_share_invalidate(
+    BinderReqShare* self,
+    RADIO_REQ code)
+{
+    if (G_LIKELY(self)) {
+        GHashTableIter it;
+        gpointer value;
+
+        /*
+         * The queries in flight keep their callers, but whoever
+         * submits the same query from now on gets a new transaction.
+         */
+        g_hash_table_iter_init(&it, self->entries);
+        while (g_hash_table_iter_next(&it, NULL, &value)) {
+            BinderReqShareEntry* entry = value;
+
+            if (entry->key.code == code) {
+                DBG_(self, "invalidating %s", radio_req_name(code));
+                g_hash_table_iter_steal(&it);
+                entry->stale = TRUE;
+                self->stale = g_slist_prepend(self->stale, entry);
+            }
+        }
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
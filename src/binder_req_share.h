@@ -0,0 +1,97 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_REQ_SHARE_H
+#define BINDER_REQ_SHARE_H
+
+#include "binder_types.h"
+
+#include <radio_request.h>
+
+/*
+ * Coalescing of read-only queries. If an identical query (the same
+ * request code and the same int32 arguments) is already in flight,
+ * the caller joins it instead of submitting another transaction,
+ * and the response is passed to all the callers which have joined.
+ * There's one instance per RadioClient, shared by all the modules
+ * of the slot.
+ *
+ * The RadioRequest passed to the completion callback is the shared
+ * one and must not be referenced or dropped by the callback. Failed
+ * queries are retried with exponential backoff (each query has its own
+ * one), unless the error is RADIO_ERROR_RADIO_NOT_AVAILABLE.
+ *
+ * binder_req_share_submit() returns zero if the request couldn't be
+ * submitted, in which case the destroy notification is not invoked.
+ * Cancelling a call doesn't affect the other callers waiting for the
+ * same response.
+ *
+ * binder_req_share_invalidate() should be called after submitting a
+ * request which changes what the queries with the given code return.
+ * The calls already waiting get the response they have asked for, but
+ * nobody else can join those queries anymore.
+ */
+
+#define BINDER_REQ_SHARE_MAX_ARGS (4)
+
+BinderReqShare*
+binder_req_share_new(
+    RadioClient* client,
+    const char* log_prefix)
+    BINDER_INTERNAL;
+
+BinderReqShare*
+binder_req_share_ref(
+    BinderReqShare* share)
+    BINDER_INTERNAL;
+
+void
+binder_req_share_unref(
+    BinderReqShare* share)
+    BINDER_INTERNAL;
+
+gulong
+binder_req_share_submit(
+    BinderReqShare* share,
+    RADIO_REQ code,
+    const gint32* args,
+    guint nargs,
+    guint timeout_ms,
+    RadioRequestCompleteFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+    BINDER_INTERNAL;
+
+void
+binder_req_share_cancel(
+    BinderReqShare* share,
+    gulong id)
+    BINDER_INTERNAL;
+
+void
+binder_req_share_invalidate(
+    BinderReqShare* share,
+    RADIO_REQ code)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_REQ_SHARE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
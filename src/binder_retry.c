@@ -0,0 +1,185 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_metrics.h"
+#include "binder_retry.h"
+
+#include <ofono/log.h>
+
+#include <radio_request.h>
+
+#include <string.h>
+
+/*
+ * Process wide totals per policy name, for metrics. There are only a
+ * few names and they are string literals, so a small fixed table does.
+ */
+#define BINDER_RETRY_TOTALS (16)
+
+typedef struct binder_retry_totals {
+    const char* name;
+    guint retries;
+    guint resets;
+} BinderRetryTotals;
+
+static BinderRetryTotals binder_retry_totals[BINDER_RETRY_TOTALS];
+
+static const BinderMetricFamily binder_retry_metric_retries = {
+    "binder_retries", BINDER_METRIC_COUNTER,
+    "Retries after a failure"
+};
+static const BinderMetricFamily binder_retry_metric_resets = {
+    "binder_retry_recoveries", BINDER_METRIC_COUNTER,
+    "Failure sequences which ended with a success"
+};
+
+static
+BinderRetryTotals*
+binder_retry_totals_get(
+    const char* name)
+{
+    guint i;
+
+    if (name) {
+        for (i = 0; i < BINDER_RETRY_TOTALS; i++) {
+            BinderRetryTotals* totals = binder_retry_totals + i;
+
+            if (!totals->name) {
+                totals->name = name;
+                return totals;
+            } else if (!strcmp(totals->name, name)) {
+                return totals;
+            }
+        }
+    }
+    return NULL;
+}
+
+void
+binder_retry_init(
+    BinderRetry* retry,
+    const char* log_prefix,
+    const char* name,
+    guint delay_ms,
+    guint max_delay_ms)
+{
+    memset(retry, 0, sizeof(*retry));
+    retry->log_prefix = log_prefix ? log_prefix : "";
+    retry->name = name;
+    retry->delay_ms = MAX(delay_ms, 1);
+    retry->max_delay_ms = MAX(max_delay_ms, retry->delay_ms);
+    retry->jitter_pct = BINDER_RETRY_JITTER_PCT;
+}
+
+void
+binder_retry_deinit(
+    BinderRetry* retry)
+{
+    if (retry->retries) {
+        DBG("%s%s: %u retries, %u recoveries, longest streak %u",
+            retry->log_prefix, retry->name, retry->retries, retry->resets,
+            MAX(retry->longest, retry->attempt));
+    }
+}
+
+guint
+binder_retry_next_delay(
+    BinderRetry* retry)
+{
+    BinderRetryTotals* totals;
+    guint delay = retry->delay_ms;
+    guint i;
+
+    /* Double the delay for each consecutive failure, up to the cap */
+    for (i = 0; i < retry->attempt && delay < retry->max_delay_ms; i++) {
+        delay *= 2;
+    }
+    delay = MIN(delay, retry->max_delay_ms);
+
+    /* Spread it by +/- jitter_pct percent */
+    if (retry->jitter_pct) {
+        const gint32 spread = (gint32)(delay * retry->jitter_pct / 100);
+
+        if (spread > 0) {
+            delay += g_random_int_range(-spread, spread + 1);
+        }
+    }
+
+    retry->attempt++;
+    retry->retries++;
+    totals = binder_retry_totals_get(retry->name);
+    if (totals) {
+        totals->retries++;
+    }
+    DBG("%s%s: retry #%u in %u ms", retry->log_prefix, retry->name,
+        retry->attempt, delay);
+    return delay;
+}
+
+void
+binder_retry_reset(
+    BinderRetry* retry)
+{
+    BinderRetryTotals* totals;
+
+    if (retry->attempt) {
+        if (retry->longest < retry->attempt) {
+            retry->longest = retry->attempt;
+        }
+        retry->resets++;
+        retry->attempt = 0;
+        totals = binder_retry_totals_get(retry->name);
+        if (totals) {
+            totals->resets++;
+        }
+    }
+}
+
+gboolean
+binder_retry_request(
+    BinderRetry* retry,
+    RadioRequest* req,
+    int max_count)
+{
+    radio_request_set_retry(req, binder_retry_next_delay(retry), max_count);
+    return TRUE;
+}
+
+void
+binder_retry_add_metrics(
+    BinderMetrics* metrics)
+{
+    guint i;
+
+    for (i = 0; i < BINDER_RETRY_TOTALS && binder_retry_totals[i].name; i++) {
+        const BinderRetryTotals* totals = binder_retry_totals + i;
+        char* labels = binder_metrics_labels("policy", totals->name, NULL);
+
+        binder_metrics_add(metrics, &binder_retry_metric_retries, labels,
+            totals->retries);
+        binder_metrics_add(metrics, &binder_retry_metric_resets, labels,
+            totals->resets);
+        g_free(labels);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
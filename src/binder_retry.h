@@ -0,0 +1,98 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_RETRY_H
+#define BINDER_RETRY_H
+
+#include "binder_types.h"
+
+#include <radio_types.h>
+
+/*
+ * Retry policy with exponential backoff. Each consecutive failure
+ * doubles the delay, up to the cap, and the delay is randomly spread
+ * by the jitter percentage so that retries issued by different slots
+ * and modules don't end up in lockstep. A successful attempt resets
+ * the delay back to the initial one.
+ *
+ * The policy is embedded into the object which owns the retry loop,
+ * the counters are logged when it gets deinitialized. The log prefix
+ * and the name are not copied and must outlive the policy.
+ */
+typedef struct binder_retry {
+    const char* log_prefix;
+    const char* name;
+    guint delay_ms;
+    guint max_delay_ms;
+    guint jitter_pct;
+    guint attempt;   /* Consecutive failures */
+    guint retries;   /* Total number of retries */
+    guint resets;    /* Number of failure sequences that have ended */
+    guint longest;   /* The longest sequence of failures */
+} BinderRetry;
+
+#define BINDER_RETRY_MAX_MS     (60000)
+#define BINDER_RETRY_JITTER_PCT (20)
+
+void
+binder_retry_init(
+    BinderRetry* retry,
+    const char* log_prefix,
+    const char* name,
+    guint delay_ms,
+    guint max_delay_ms)
+    BINDER_INTERNAL;
+
+void
+binder_retry_deinit(
+    BinderRetry* retry)
+    BINDER_INTERNAL;
+
+guint
+binder_retry_next_delay(
+    BinderRetry* retry)
+    BINDER_INTERNAL;
+
+void
+binder_retry_reset(
+    BinderRetry* retry)
+    BINDER_INTERNAL;
+
+/*
+ * To be called by RadioRequestRetryFunc right before it returns TRUE,
+ * updates the delay of the retry which is about to be scheduled.
+ */
+gboolean
+binder_retry_request(
+    BinderRetry* retry,
+    RadioRequest* req,
+    int max_count)
+    BINDER_INTERNAL;
+
+/* Process wide totals per policy name */
+void
+binder_retry_add_metrics(
+    BinderMetrics* metrics)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_RETRY_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -16,8 +16,11 @@
 #include "binder_log.h"
 #include "binder_modem.h"
 #include "binder_sim.h"
+#include "binder_sim_apdu.h"
 #include "binder_sim_card.h"
+#include "binder_sim_io_cache.h"
 #include "binder_util.h"
+#include "binder_wakeup.h"
 
 #include <ofono/log.h>
 #include <ofono/misc.h>
@@ -43,6 +46,7 @@
 #define EF_STATUS_VALID 1
 
 /* Commands defined for TS 27.007 +CRSM */
+#define CMD_SELECT        164 /* 0xA4   */
 #define CMD_READ_BINARY   176 /* 0xB0   */
 #define CMD_READ_RECORD   178 /* 0xB2   */
 #define CMD_GET_RESPONSE  192 /* 0xC0   */
@@ -55,6 +59,13 @@
 /* FID/path of SIM/USIM root directory */
 static const char ROOTMF[] = "3F00";
 
+/* P2 coding for SELECT (see TS 102.221) */
+#define SELECT_RETURN_FCP  (0x04)
+#define SELECT_NO_RESPONSE (0x0C)
+
+/* Maximum short Le for a single READ BINARY */
+#define SESSION_READ_CHUNK (0xFF)
+
 /* P2 coding (modes) for READ RECORD and UPDATE RECORD (see TS 102.221) */
 #define MODE_SELECTED (0x00) /* Currently selected EF */
 #define MODE_CURRENT  (0x04) /* P1='00' denotes the current record */
@@ -63,7 +74,7 @@ static const char ROOTMF[] = "3F00";
 #define MODE_PREVIOUS (0x03) /* Previous record */
 
 enum binder_sim_card_event {
-    SIM_CARD_STATUS_EVENT,
+    SIM_CARD_STATE_EVENT,
     SIM_CARD_APP_EVENT,
     SIM_CARD_EVENT_COUNT
 };
@@ -73,15 +84,56 @@ enum binder_sim_io_event {
     IO_EVENT_COUNT
 };
 
+/* Scheduling priorities of the pipelined reads */
+enum binder_sim_io_priority {
+    SIM_IO_PRIORITY_HIGH,   /* File info and transparent files */
+    SIM_IO_PRIORITY_LOW,    /* Record scanning and verification */
+    SIM_IO_PRIORITY_COUNT
+};
+
+/*
+ * Facility lock state of the current app. Concurrent queries for
+ * the same facility share a single getFacilityLockForApp request.
+ */
+typedef struct binder_sim_fac_lock {
+    struct binder_sim* self;
+    int locked;         /* Negative if unknown */
+    guint serial;       /* Bumped on invalidation */
+    guint query_serial; /* Value of serial when the query was submitted */
+    GSList* waiters;    /* BinderSimFacLockWaiter, if query is pending */
+} BinderSimFacLock;
+
+typedef struct binder_sim_fac_lock_waiter {
+    ofono_query_facility_lock_cb_t cb;
+    void* data;
+} BinderSimFacLockWaiter;
+
 typedef struct binder_sim {
     struct ofono_sim* sim;
     struct ofono_watch* watch;
     enum ofono_sim_password_type ofono_passwd_state;
     BinderSimCard* card;
+    BinderSimIoCache* cache;
+    GQueue cache_hits;
+    guint cache_hit_id;
+    guint io_max;       /* Max number of concurrent reads */
+    guint io_active;    /* Number of pipelined reads in progress */
+    GQueue io_queue[SIM_IO_PRIORITY_COUNT];
+    guint prefetch_max;         /* Number of records to read ahead */
+    GHashTable* prefetch;       /* key => GSList of BinderSimIoWait */
+    GHashTable* prefetched;     /* Prefetched but not yet requested */
+    guint prefetch_sent;
+    guint prefetch_hits;
     RadioRequestGroup* g;
     RadioRequest* query_pin_retries_req;
     GList* pin_cbd_list;
     int retries[OFONO_SIM_PASSWORD_INVALID];
+    guint retries_queried; /* binder_sim_retry_query_types bits */
+    BinderSimFacLock fac_lock[OFONO_SIM_PASSWORD_INVALID];
+    char* fac_lock_aid;
+    GHashTable* channels;   /* Open logical channel => AID (GBytes) */
+    GSList* idle_channels;  /* BinderSimChannel */
+    guint channel_idle_ms;
     gboolean empty_pin_query_allowed;
     gboolean inserted;
     guint idle_id; /* Used by register and SIM reset callbacks */
@@ -89,6 +141,7 @@ typedef struct binder_sim {
     gulong card_event_id[SIM_CARD_EVENT_COUNT];
     gulong io_event_id[IO_EVENT_COUNT];
     gulong sim_state_watch_id;
+    gulong iccid_watch_id;
     char *log_prefix;
 
     /* query_passwd_state context */
@@ -119,8 +172,34 @@ typedef struct binder_sim_cbd_io {
     } cb;
     gpointer data;
     gpointer req_id; /* Actually RadioRequest pointer (but not a ref) */
+    char* cache_key;
+    guint cmd;
+    guint fid;
+    GBytes* cached;
+    GBytes* aid;          /* iccOpenLogicalChannel */
+    RadioRequestCompleteFunc complete;
+    RadioRequest* queued; /* Waiting to be submitted (a ref) */
+    gboolean pipelined;   /* Counted in io_active */
+    gboolean verifying;   /* Cache entry verification not done yet */
 } BinderSimCbdIo;
 
+/* Record read waiting for the prefetch of the same record to complete */
+typedef struct binder_sim_io_wait {
+    int fid;
+    guint p1, p2, p3;
+    GBytes* path;
+    ofono_sim_read_cb_t cb;
+    void* data;
+} BinderSimIoWait;
+
+typedef struct binder_sim_file_info {
+    guint flen;
+    guint rlen;
+    guint str;
+    guchar faccess[3];
+    guchar fstatus;
+} BinderSimFileInfo;
+
 typedef struct binder_sim_session_cbd {
     BinderSim* self;
     BinderSimCard* card;
@@ -130,8 +209,46 @@ typedef struct binder_sim_session_cbd {
     int channel;
     int cla;
     gpointer req_id; /* Actually RadioRequest pointer (but not a ref) */
+    GDestroyNotify destroy; /* Called for data when cbd is freed */
 } BinderSimSessionCbData;
 
+typedef struct binder_sim_apdu {
+    guint8 ins;
+    guint8 p1;
+    guint8 p2;
+    guint8 p3;
+    char* hex_data;
+    gboolean collect;
+} BinderSimApdu;
+
+typedef struct binder_sim_apdu_script BinderSimApduScript;
+
+typedef
+void
+(*BinderSimApduScriptFunc)(
+    BinderSimApduScript* script,
+    const struct ofono_error* err);
+
+/*
+ * A sequence of APDUs executed back to back on a logical channel. The
+ * next command is submitted directly from the completion of the previous
+ * one, '61 xx' and '6C xx' procedure bytes are handled inside the script
+ * and the data returned by the commands flagged for collection is
+ * accumulated. The completion callback is invoked once, either after the
+ * last command or after the first failure.
+ */
+struct binder_sim_apdu_script {
+    BinderSimSessionCbData* cbd;
+    GPtrArray* apdus;
+    guint index;
+    guint resends; /* '6C xx' resends of the current command */
+    GByteArray* collected;
+    GByteArray* response; /* Data returned by the current command */
+    BinderSimApduScriptFunc done;
+    GCallback cb;
+    gpointer data;
+};
+
 typedef struct binder_sim_pin_cbd {
     BinderSim* self;
     ofono_sim_lock_unlock_cb_t cb;
@@ -170,6 +287,23 @@ typedef struct binder_sim_list_apps {
     void* data;
 } BinderSimListApps;
 
+/*
+ * Logical channel which has been closed by ofono but is being kept
+ * open in case if another session to the same AID gets opened soon.
+ */
+typedef struct binder_sim_channel {
+    BinderSim* self;
+    GBytes* aid;
+    int channel;
+    guint idle_id;
+} BinderSimChannel;
+
+static
+void
+binder_sim_drop_idle_channels(
+    BinderSim* self,
+    gboolean close);
+
 static
 void
 binder_sim_query_retry_count_cb(
@@ -180,6 +314,11 @@ binder_sim_query_retry_count_cb(
     const GBinderReader* args,
     gpointer user_data);
 
+static
+void
+binder_sim_io_next(
+    BinderSim* self);
+
 #define DBG_(self,fmt,args...) DBG("%s" fmt, (self)->log_prefix, ##args)
 
 static inline BinderSim* binder_sim_get_data(struct ofono_sim* sim)
@@ -210,7 +349,27 @@ binder_sim_cbd_io_free(
 
     binder_sim_card_sim_io_finished(cbd->card, cbd->req_id);
     binder_sim_card_unref(cbd->card);
-    gutil_slice_free(cbd);
+    if (cbd->verifying) {
+        /* Failed, cancelled or never submitted, let the next hit retry */
+        binder_sim_io_cache_verify_failed(cbd->self->cache, cbd->cache_key);
+    }
+    if (cbd->cached) {
+        g_bytes_unref(cbd->cached);
+    }
+    if (cbd->aid) {
+        g_bytes_unref(cbd->aid);
+    }
+    g_free(cbd->cache_key);
+    if (cbd->pipelined) {
+        BinderSim* self = cbd->self;
+
+        GASSERT(self->io_active > 0);
+        self->io_active--;
+        gutil_slice_free(cbd);
+        binder_sim_io_next(self);
+    } else {
+        gutil_slice_free(cbd);
+    }
 }
 
 static
@@ -257,6 +416,9 @@ binder_sim_session_cbd_unref(
     if (--(cbd->ref_count) < 1) {
         binder_sim_card_sim_io_finished(cbd->card, cbd->req_id);
         binder_sim_card_unref(cbd->card);
+        if (cbd->destroy) {
+            cbd->destroy(cbd->data);
+        }
         gutil_slice_free(cbd);
     }
 }
@@ -501,6 +663,37 @@ binder_sim_io_response_ok(
     return FALSE;
 }
 
+static
+gboolean
+binder_sim_parse_file_info(
+    BinderSimFileInfo* info,
+    const guint8* data,
+    guint len)
+{
+    memset(info, 0, sizeof(*info));
+    info->fstatus = EF_STATUS_VALID;
+    if (len) {
+        if (data[0] == 0x62) {
+            return ofono_parse_get_response_3g(data, len, &info->flen,
+                &info->rlen, &info->str, info->faccess, NULL);
+        } else {
+            return ofono_parse_get_response_2g(data, len, &info->flen,
+                &info->rlen, &info->str, info->faccess, &info->fstatus);
+        }
+    }
+    return FALSE;
+}
+
+static
+gboolean
+binder_sim_cbd_io_cache_put(
+    BinderSimCbdIo* cbd,
+    const BinderSimIoResponse* res)
+{
+    return binder_sim_io_cache_put(cbd->self->cache, cbd->cache_key,
+        cbd->fid, res->sw1, res->sw2, res->data, res->data_len);
+}
+
 static
 void
 binder_sim_file_info_cb(
@@ -527,27 +720,14 @@ binder_sim_file_info_cb(
                 DBG_(self, "No SIM card");
             } else if (binder_sim_io_response_ok(res) &&
                 error == RADIO_ERROR_NONE) {
-                gboolean ok = FALSE;
-                guchar faccess[3] = { 0x00, 0x00, 0x00 };
-                guchar fstatus = EF_STATUS_VALID;
-                unsigned int flen = 0, rlen = 0, str = 0;
-
-                if (res->data_len) {
-                    if (res->data[0] == 0x62) {
-                        ok = ofono_parse_get_response_3g(res->data,
-                            res->data_len, &flen, &rlen, &str, faccess,
-                            NULL);
-                    } else {
-                        ok = ofono_parse_get_response_2g(res->data,
-                            res->data_len, &flen, &rlen, &str, faccess,
-                            &fstatus);
-                    }
-                }
+                BinderSimFileInfo info;
 
-                if (ok) {
+                if (binder_sim_parse_file_info(&info, res->data,
+                    res->data_len)) {
                     /* Success */
-                    cb(binder_error_ok(&err), flen, str, rlen, faccess,
-                       fstatus, cbd->data);
+                    binder_sim_cbd_io_cache_put(cbd, res);
+                    cb(binder_error_ok(&err), info.flen, info.str, info.rlen,
+                       info.faccess, info.fstatus, cbd->data);
                     binder_sim_io_response_free(res);
                     return;
                 } else {
@@ -570,10 +750,125 @@ binder_sim_file_info_cb(
     cb(&err, -1, -1, -1, NULL, EF_STATUS_INVALIDATED, cbd->data);
 }
 
+static
+void
+binder_sim_cache_hit(
+    BinderSim* self,
+    BinderSimCbdIo* cbd)
+{
+    struct ofono_error err;
+    gsize len = 0;
+    const guint8* data = g_bytes_get_data(cbd->cached, &len);
+
+    DBG_(self, "cmd=0x%.2X,fid=0x%.4X (cached)", cbd->cmd, cbd->fid);
+    if (cbd->cmd == CMD_GET_RESPONSE) {
+        ofono_sim_file_info_cb_t cb = cbd->cb.file_info;
+        BinderSimFileInfo info;
+
+        if (self->inserted && binder_sim_parse_file_info(&info, data, len)) {
+            cb(binder_error_ok(&err), info.flen, info.str, info.rlen,
+               info.faccess, info.fstatus, cbd->data);
+        } else {
+            cb(binder_error_failure(&err), -1, -1, -1, NULL,
+                EF_STATUS_INVALIDATED, cbd->data);
+        }
+    } else {
+        ofono_sim_read_cb_t cb = cbd->cb.read;
+
+        if (self->inserted) {
+            cb(binder_error_ok(&err), data, len, cbd->data);
+        } else {
+            cb(binder_error_failure(&err), NULL, 0, cbd->data);
+        }
+    }
+}
+
 static
 gboolean
-binder_sim_request_io(
+binder_sim_cache_hits_cb(
+    gpointer user_data)
+{
+    BinderSim* self = user_data;
+    BinderSimCbdIo* cbd = g_queue_pop_head(&self->cache_hits);
+    gboolean done = g_queue_is_empty(&self->cache_hits);
+
+    /* One completion per iteration, then let the main loop breathe */
+    if (done) {
+        self->cache_hit_id = 0;
+    }
+    binder_sim_cache_hit(self, cbd);
+    binder_sim_cbd_io_free(cbd);
+    return done ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+static
+gboolean
+binder_sim_io_start_pipelined(
+    BinderSim* self,
+    BinderSimCbdIo* cbd,
+    RadioRequest* req)
+{
+    self->io_active++;
+    cbd->pipelined = TRUE;
+    if (binder_sim_cbd_io_start(cbd, req)) {
+        return TRUE;
+    } else {
+        cbd->pipelined = FALSE;
+        self->io_active--;
+        return FALSE;
+    }
+}
+
+static
+void
+binder_sim_io_next(
+    BinderSim* self)
+{
+    while (self->io_active < self->io_max) {
+        BinderSimCbdIo* cbd = NULL;
+        RadioRequest* req;
+        int i;
+
+        for (i = 0; i < SIM_IO_PRIORITY_COUNT && !cbd; i++) {
+            cbd = g_queue_pop_head(self->io_queue + i);
+        }
+
+        if (!cbd) {
+            break;
+        }
+
+        req = cbd->queued;
+        cbd->queued = NULL;
+        if (!binder_sim_io_start_pipelined(self, cbd, req)) {
+            /* ofono is waiting for the completion, let it know */
+            cbd->complete(req, RADIO_TX_STATUS_FAILED, RADIO_RESP_NONE,
+                RADIO_ERROR_GENERIC_FAILURE, NULL, cbd);
+        }
+        radio_request_unref(req); /* Frees cbd if the request has failed */
+    }
+}
+
+static
+void
+binder_sim_io_cancel_queued(
+    BinderSim* self)
+{
+    int i;
+
+    for (i = 0; i < SIM_IO_PRIORITY_COUNT; i++) {
+        BinderSimCbdIo* cbd;
+
+        while ((cbd = g_queue_pop_head(self->io_queue + i)) != NULL) {
+            radio_request_unref(cbd->queued);
+        }
+    }
+}
+
+static
+gboolean
+binder_sim_submit_io(
     BinderSim* self,
+    BinderSimCbdIo* cbd,
     guint cmd,
     int fid,
     guint p1,
@@ -583,12 +878,10 @@ binder_sim_request_io(
     const guchar* path,
     guint path_len,
     RadioRequestCompleteFunc complete,
-    BinderCallback cb,
-    void* data)
+    enum binder_sim_io_priority priority)
 {
     static const char empty[] = "";
     const char* aid = binder_sim_card_app_aid(self->card);
-    BinderSimCbdIo* cbd = binder_sim_cbd_io_new(self, cb, data);
     guint parent;
     gboolean ok;
 
@@ -622,13 +915,189 @@ binder_sim_request_io(
     binder_append_hidl_string_data(&writer, io, pin2, parent);
     binder_append_hidl_string_data(&writer, io, aid, parent);
 
-    radio_request_set_blocking(req, TRUE);
     radio_request_set_timeout(req, SIM_IO_TIMEOUT_SECS * 1000);
-    ok = binder_sim_cbd_io_start(cbd, req);
+    cbd->complete = complete;
+    if (self->io_max > 1 && cbd->cache_key /* i.e. it's a read */) {
+        /*
+         * Reads don't need to block each other (or anything else),
+         * but the number of those in flight is limited.
+         */
+        if (self->io_active < self->io_max) {
+            ok = binder_sim_io_start_pipelined(self, cbd, req);
+        } else {
+            DBG_(self, "queued (%u active)", self->io_active);
+            cbd->queued = radio_request_ref(req);
+            g_queue_push_tail(self->io_queue + priority, cbd);
+            ok = TRUE;
+        }
+    } else {
+        radio_request_set_blocking(req, TRUE);
+        ok = binder_sim_cbd_io_start(cbd, req);
+    }
     radio_request_unref(req);
     return ok;
 }
 
+static
+void
+binder_sim_cache_verify_cb(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderSimCbdIo* cbd = user_data;
+    BinderSim* self = cbd->self;
+
+    if (status == RADIO_TX_STATUS_OK && resp == RADIO_RESP_ICC_IO_FOR_APP &&
+        error == RADIO_ERROR_NONE && self->inserted) {
+        BinderSimIoResponse* res = binder_sim_io_response_new(args);
+
+        if (binder_sim_io_response_ok(res)) {
+            /* The entry gets marked as verified either way */
+            cbd->verifying = FALSE;
+            if (binder_sim_cbd_io_cache_put(cbd, res)) {
+                /*
+                 * The stored copy was stale, the rest of it can't be
+                 * trusted either. Make ofono re-read everything.
+                 */
+                ofono_info("SIM file 0x%04X has changed", cbd->fid);
+                binder_sim_io_cache_drop_unverified(self->cache);
+                ofono_sim_refresh_full(self->sim);
+            }
+        }
+        binder_sim_io_response_free(res);
+    }
+}
+
+static
+void
+binder_sim_io_wait_free(
+    gpointer data)
+{
+    BinderSimIoWait* wait = data;
+
+    if (wait->path) {
+        g_bytes_unref(wait->path);
+    }
+    gutil_slice_free(wait);
+}
+
+static
+gboolean
+binder_sim_prefetch_wait(
+    BinderSim* self,
+    const char* key,
+    int fid,
+    guint p1,
+    guint p2,
+    guint p3,
+    const guchar* path,
+    guint path_len,
+    ofono_sim_read_cb_t cb,
+    void* data)
+{
+    gpointer value;
+
+    if (g_hash_table_lookup_extended(self->prefetch, key, NULL, &value)) {
+        BinderSimIoWait* wait = g_slice_new0(BinderSimIoWait);
+
+        DBG_(self, "waiting for record %u of 0x%04X", p1, fid);
+        wait->fid = fid;
+        wait->p1 = p1;
+        wait->p2 = p2;
+        wait->p3 = p3;
+        wait->path = path_len ? g_bytes_new(path, path_len) : NULL;
+        wait->cb = cb;
+        wait->data = data;
+        g_hash_table_insert(self->prefetch, g_strdup(key),
+            g_slist_prepend(value, wait));
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+gboolean
+binder_sim_request_io(
+    BinderSim* self,
+    guint cmd,
+    int fid,
+    guint p1,
+    guint p2,
+    guint p3,
+    const char* hex_data,
+    const guchar* path,
+    guint path_len,
+    RadioRequestCompleteFunc complete,
+    BinderCallback cb,
+    void* data)
+{
+    BinderSimCbdIo* cbd = binder_sim_cbd_io_new(self, cb, data);
+
+    cbd->cmd = cmd;
+    cbd->fid = fid;
+    switch (cmd) {
+    case CMD_GET_RESPONSE:
+    case CMD_READ_BINARY:
+    case CMD_READ_RECORD:
+        cbd->cache_key = binder_sim_io_cache_key(binder_sim_card_app_aid
+            (self->card), path, path_len, fid, cmd, p1, p2, p3);
+        if (self->inserted) {
+            gboolean verify;
+            const BinderSimIoCacheEntry* entry =
+                binder_sim_io_cache_get(self->cache, cbd->cache_key, &verify);
+
+            if (entry) {
+                if (g_hash_table_remove(self->prefetched, cbd->cache_key)) {
+                    self->prefetch_hits++;
+                    DBG_(self, "prefetch hit (%u/%u)", self->prefetch_hits,
+                        self->prefetch_sent);
+                }
+
+                /* Complete it asynchronously, like a real request */
+                cbd->cached = g_bytes_ref(entry->data);
+                g_queue_push_tail(&self->cache_hits, cbd);
+                if (!self->cache_hit_id) {
+                    self->cache_hit_id = g_idle_add(binder_sim_cache_hits_cb,
+                        self);
+                }
+                if (verify) {
+                    /* The entry came from the storage, double-check it */
+                    BinderSimCbdIo* vcbd = binder_sim_cbd_io_new(self,
+                        NULL, NULL);
+
+                    vcbd->cmd = cmd;
+                    vcbd->fid = fid;
+                    vcbd->cache_key = g_strdup(cbd->cache_key);
+                    vcbd->verifying = TRUE;
+                    binder_sim_submit_io(self, vcbd, cmd, fid, p1, p2, p3,
+                        NULL, path, path_len, binder_sim_cache_verify_cb,
+                        SIM_IO_PRIORITY_LOW);
+                }
+                return TRUE;
+            } else if (cmd == CMD_READ_RECORD && binder_sim_prefetch_wait(self,
+                cbd->cache_key, fid, p1, p2, p3, path, path_len,
+                cbd->cb.read, data)) {
+                binder_sim_cbd_io_free(cbd);
+                return TRUE;
+            }
+        }
+        break;
+    case CMD_UPDATE_BINARY:
+    case CMD_UPDATE_RECORD:
+        binder_sim_io_cache_invalidate_file(self->cache, fid);
+        break;
+    }
+
+    /* Reading records one by one is most likely a background scan */
+    return binder_sim_submit_io(self, cbd, cmd, fid, p1, p2, p3, hex_data,
+        path, path_len, complete, (cmd == CMD_READ_RECORD && p1 > 1) ?
+        SIM_IO_PRIORITY_LOW : SIM_IO_PRIORITY_HIGH);
+}
+
 static
 void
 binder_sim_ofono_read_file_info(
@@ -676,6 +1145,7 @@ binder_sim_read_cb(
             } else if (binder_sim_io_response_ok(res) &&
                 error == RADIO_ERROR_NONE) {
                 /* Success */
+                binder_sim_cbd_io_cache_put(cbd, res);
                 cb(binder_error_ok(&err), res->data, res->data_len, cbd->data);
                 binder_sim_io_response_free(res);
                 return;
@@ -718,34 +1188,171 @@ binder_sim_read(
 
 static
 void
-binder_sim_ofono_read_file_transparent(
-    struct ofono_sim* sim,
-    int fileid,
-    int start,
-    int length,
-    const unsigned char* path,
-    unsigned int path_len,
-    ofono_sim_read_cb_t cb,
-    void* data)
+binder_sim_prefetch_cb(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    gpointer user_data)
 {
-    binder_sim_read(sim, CMD_READ_BINARY, fileid, (start >> 8), (start & 0xff),
-        length, path, path_len, cb, data);
+    BinderSimCbdIo* cbd = user_data;
+    BinderSim* self = cbd->self;
+    gpointer key, value;
+
+    if (status == RADIO_TX_STATUS_OK && resp == RADIO_RESP_ICC_IO_FOR_APP &&
+        error == RADIO_ERROR_NONE && self->inserted) {
+        BinderSimIoResponse* res = binder_sim_io_response_new(args);
+
+        if (binder_sim_io_response_ok(res)) {
+            binder_sim_cbd_io_cache_put(cbd, res);
+            g_hash_table_add(self->prefetched, g_strdup(cbd->cache_key));
+        }
+        binder_sim_io_response_free(res);
+    }
+
+    if (g_hash_table_lookup_extended(self->prefetch, cbd->cache_key,
+        &key, &value)) {
+        GSList* waiters = g_slist_reverse(value);
+        GSList* l;
+
+        g_hash_table_steal(self->prefetch, key);
+        g_free(key);
+
+        /*
+         * These are normally served from the cache now. If prefetch
+         * has failed, they get submitted the usual way.
+         */
+        for (l = waiters; l; l = l->next) {
+            BinderSimIoWait* wait = l->data;
+            gsize len = 0;
+            const guchar* path = wait->path ?
+                g_bytes_get_data(wait->path, &len) : NULL;
+
+            if (!binder_sim_request_io(self, CMD_READ_RECORD, wait->fid,
+                wait->p1, wait->p2, wait->p3, NULL, path, len,
+                binder_sim_read_cb, BINDER_CB(wait->cb), wait->data)) {
+                struct ofono_error err;
+
+                wait->cb(binder_error_failure(&err), NULL, 0, wait->data);
+            }
+        }
+        g_slist_free_full(waiters, binder_sim_io_wait_free);
+    }
 }
 
 static
-void
-binder_sim_ofono_read_file_linear(
-    struct ofono_sim* sim,
-    int fileid,
-    int record,
-    int length,
-    const unsigned char* path,
-    unsigned int path_len,
-    ofono_sim_read_cb_t cb,
-    void *data)
+guint
+binder_sim_record_count(
+    BinderSim* self,
+    const char* aid,
+    int fid,
+    const guchar* path,
+    guint path_len)
+{
+    /* Use file info fetched by the ofono core, if it's in the cache */
+    char* key = binder_sim_io_cache_key(aid, path, path_len, fid,
+        CMD_GET_RESPONSE, 0, 0, 15);
+    const BinderSimIoCacheEntry* entry =
+        binder_sim_io_cache_peek(self->cache, key);
+    guint count = 0;
+
+    if (entry) {
+        BinderSimFileInfo info;
+        gsize len = 0;
+        const guint8* data = g_bytes_get_data(entry->data, &len);
+
+        if (binder_sim_parse_file_info(&info, data, len) && info.rlen) {
+            count = info.flen / info.rlen;
+        }
+    }
+    g_free(key);
+    return count;
+}
+
+static
+void
+binder_sim_prefetch_records(
+    BinderSim* self,
+    int fid,
+    int record,
+    int length,
+    const guchar* path,
+    guint path_len)
+{
+    if (self->prefetch_max && self->inserted && record > 0 &&
+        binder_sim_io_cache_active(self->cache)) {
+        const char* aid = binder_sim_card_app_aid(self->card);
+        const guint count = binder_sim_record_count(self, aid, fid, path,
+            path_len);
+
+        /* Skip single record files, and those of unknown size */
+        if (count > 1) {
+            const guint last = MIN(record + self->prefetch_max, count);
+            guint r;
+
+            for (r = record + 1; r <= last; r++) {
+                char* key = binder_sim_io_cache_key(aid, path, path_len, fid,
+                    CMD_READ_RECORD, r, MODE_ABSOLUTE, length);
+
+                if (binder_sim_io_cache_peek(self->cache, key) ||
+                    g_hash_table_contains(self->prefetch, key)) {
+                    g_free(key);
+                } else {
+                    BinderSimCbdIo* cbd = binder_sim_cbd_io_new(self, NULL,
+                        NULL);
+
+                    cbd->cmd = CMD_READ_RECORD;
+                    cbd->fid = fid;
+                    cbd->cache_key = g_strdup(key);
+                    g_hash_table_insert(self->prefetch, key, NULL);
+                    self->prefetch_sent++;
+                    if (!binder_sim_submit_io(self, cbd, CMD_READ_RECORD,
+                        fid, r, MODE_ABSOLUTE, length, NULL, path, path_len,
+                        binder_sim_prefetch_cb, SIM_IO_PRIORITY_LOW)) {
+                        g_hash_table_remove(self->prefetch, key);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static
+void
+binder_sim_ofono_read_file_transparent(
+    struct ofono_sim* sim,
+    int fileid,
+    int start,
+    int length,
+    const unsigned char* path,
+    unsigned int path_len,
+    ofono_sim_read_cb_t cb,
+    void* data)
+{
+    binder_sim_read(sim, CMD_READ_BINARY, fileid, (start >> 8), (start & 0xff),
+        length, path, path_len, cb, data);
+}
+
+static
+void
+binder_sim_ofono_read_file_linear(
+    struct ofono_sim* sim,
+    int fileid,
+    int record,
+    int length,
+    const unsigned char* path,
+    unsigned int path_len,
+    ofono_sim_read_cb_t cb,
+    void *data)
 {
     binder_sim_read(sim, CMD_READ_RECORD, fileid, record, MODE_ABSOLUTE,
         length, path, path_len, cb, data);
+
+    /* The core is going to read the whole file, record by record */
+    binder_sim_prefetch_records(binder_sim_get_data(sim), fileid, record,
+        length, path, path_len);
 }
 
 static
@@ -1103,6 +1710,24 @@ binder_sim_check_perm_lock(
     }
 }
 
+static
+void
+binder_sim_invalidate_fac_locks(
+    BinderSim* self)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(self->fac_lock); i++) {
+        BinderSimFacLock* fl = self->fac_lock + i;
+
+        fl->self = self;
+        fl->locked = -1;
+        fl->serial++;
+    }
+    g_free(self->fac_lock_aid);
+    self->fac_lock_aid = NULL;
+}
+
 static
 void
 binder_sim_invalidate_passwd_state(
@@ -1111,6 +1736,8 @@ binder_sim_invalidate_passwd_state(
     guint i;
 
     self->ofono_passwd_state = OFONO_SIM_PASSWORD_INVALID;
+    self->retries_queried = 0;
+    binder_sim_invalidate_fac_locks(self);
     for (i = 0; i < OFONO_SIM_PASSWORD_INVALID; i++) {
         self->retries[i] = -1;
     }
@@ -1119,15 +1746,6 @@ binder_sim_invalidate_passwd_state(
     binder_sim_finish_passwd_state_query(self, OFONO_SIM_PASSWORD_INVALID);
 }
 
-static
-void
-binder_sim_app_changed_cb(
-    BinderSimCard* sim,
-    void *user_data)
-{
-    binder_sim_check_perm_lock((BinderSim*)user_data);
-}
-
 static
 void
 binder_sim_status_changed_cb(
@@ -1157,14 +1775,26 @@ binder_sim_status_changed_cb(
         }
     } else {
         binder_sim_invalidate_passwd_state(self);
+        binder_sim_drop_idle_channels(self, FALSE);
         if (self->inserted) {
             self->inserted = FALSE;
+            binder_sim_io_cache_set_iccid(self->cache, NULL);
             ofono_info("No SIM card");
             ofono_sim_inserted_notify(self->sim, FALSE);
         }
     }
 }
 
+static
+void
+binder_sim_app_changed_cb(
+    BinderSimCard* sim,
+    void *user_data)
+{
+    /* The password state only depends on the selected app */
+    binder_sim_status_changed_cb(sim, user_data);
+}
+
 static
 void
 binder_sim_state_changed_cb(
@@ -1181,6 +1811,17 @@ binder_sim_state_changed_cb(
     }
 }
 
+static
+void
+binder_sim_iccid_changed_cb(
+    struct ofono_watch* watch,
+    void* data)
+{
+    BinderSim* self = data;
+
+    binder_sim_io_cache_set_iccid(self->cache, watch->iccid);
+}
+
 static
 RadioRequest*
 binder_sim_enter_sim_pin_req(
@@ -1326,18 +1967,26 @@ binder_sim_query_retry_count(
     if (self->empty_pin_query_allowed) {
         guint i = start_index;
 
-        /* Find the first unknown retry count that we can query. */
+        /*
+         * Find the first unknown retry count that we can query.
+         * Each of them is queried at most once until the card
+         * changes or a PIN operation is performed. If the query
+         * fails, the count remains unknown, asking the SIM again
+         * every time ofono wants to know won't make it any better.
+         */
         while (i < G_N_ELEMENTS(binder_sim_retry_query_types)) {
             const BinderSimRetryQuery* query =
                 binder_sim_retry_query_types + i;
 
-            if (self->retries[query->passwd_type] < 0) {
+            if (self->retries[query->passwd_type] < 0 &&
+                !(self->retries_queried & (1u << i))) {
                 RadioRequest* req = query->new_req(self, query->code,
                     binder_sim_query_retry_count_cb,
                     binder_sim_retry_query_cbd_free,
                     binder_sim_retry_query_cbd_new(self, i, cb, data));
 
                 DBG_(self, "querying %s retry count...", query->name);
+                self->retries_queried |= (1u << i);
                 if (radio_request_submit(req)) {
                     return req;
                 } else {
@@ -1437,6 +2086,7 @@ binder_sim_query_passwd_state_timeout_cb(
 {
     BinderSim* self = user_data;
 
+    binder_wakeup("sim passwd state timeout");
     GASSERT(self->query_passwd_state_cb);
     self->query_passwd_state_timeout_id = 0;
     binder_sim_finish_passwd_state_query(self, OFONO_SIM_PASSWORD_INVALID);
@@ -1498,6 +2148,7 @@ binder_sim_pin_change_state_timeout_cb(
     BinderSim* self = cbd->self;
     struct ofono_error err;
 
+    binder_wakeup("sim pin state timeout");
     DBG_(self, "oops...");
     cbd->timeout_id = 0;
     self->pin_cbd_list = g_list_remove(self->pin_cbd_list, cbd);
@@ -1562,6 +2213,10 @@ binder_sim_pin_change_state_cb(
     }
 
     DBG_(self, "result=%d type=%d retry_count=%d", error, type, retry_count);
+
+    /* Retry counts and locks may have changed, allow querying them again */
+    self->retries_queried = 0;
+    binder_sim_invalidate_fac_locks(self);
     if (error == RADIO_ERROR_NONE && retry_count == 0) {
         enum ofono_sim_password_type pin_type = ofono_sim_puk2pin(type);
         /*
@@ -1905,14 +2560,13 @@ binder_sim_query_facility_lock_retry(
 }
 
 static
-void
-binder_sim_query_facility_lock(
-    struct ofono_sim* sim,
+gboolean
+binder_sim_query_facility_lock_submit(
+    BinderSim* self,
     enum ofono_sim_password_type type,
     ofono_query_facility_lock_cb_t cb,
     void* data)
 {
-    BinderSim* self = binder_sim_get_data(sim);
     const char* fac = binder_sim_facility_code(type);
     BinderSimCbdIo* cbd = binder_sim_cbd_io_new(self, BINDER_CB(cb), data);
     gboolean ok;
@@ -1941,10 +2595,93 @@ binder_sim_query_facility_lock(
     DBG_(self, "%s", fac);
     ok = binder_sim_cbd_io_start(cbd, req);
     radio_request_unref(req);
+    return ok;
+}
 
-    if (!ok) {
-        struct ofono_error err;
+static
+void
+binder_sim_fac_lock_waiter_free(
+    gpointer data)
+{
+    g_slice_free(BinderSimFacLockWaiter, data);
+}
+
+static
+void
+binder_sim_query_facility_lock_done(
+    const struct ofono_error* error,
+    ofono_bool_t locked,
+    void* data)
+{
+    BinderSimFacLock* fl = data;
+    GSList* waiters = g_slist_reverse(fl->waiters);
+    GSList* l;
+
+    /* Unless the cache has been invalidated in the meantime */
+    if (error->type == OFONO_ERROR_TYPE_NO_ERROR &&
+        fl->query_serial == fl->serial) {
+        fl->locked = locked;
+    }
+
+    fl->waiters = NULL;
+    for (l = waiters; l; l = l->next) {
+        const BinderSimFacLockWaiter* w = l->data;
+
+        w->cb(error, locked, w->data);
+    }
+    g_slist_free_full(waiters, binder_sim_fac_lock_waiter_free);
+}
+
+static
+void
+binder_sim_query_facility_lock(
+    struct ofono_sim* sim,
+    enum ofono_sim_password_type type,
+    ofono_query_facility_lock_cb_t cb,
+    void* data)
+{
+    BinderSim* self = binder_sim_get_data(sim);
+    const char* aid = binder_sim_card_app_aid(self->card);
+    struct ofono_error err;
+
+    if (g_strcmp0(self->fac_lock_aid, aid)) {
+        /* The states belong to the app */
+        binder_sim_invalidate_fac_locks(self);
+        self->fac_lock_aid = g_strdup(aid);
+    }
+
+    if ((guint)type < G_N_ELEMENTS(self->fac_lock)) {
+        BinderSimFacLock* fl = self->fac_lock + type;
+        BinderSimFacLockWaiter* w;
+
+        if (fl->locked >= 0) {
+            DBG_(self, "%s %d (cached)", binder_sim_facility_code(type),
+                fl->locked);
+            cb(binder_error_ok(&err), fl->locked, data);
+            return;
+        }
 
+        w = g_slice_new(BinderSimFacLockWaiter);
+        w->cb = cb;
+        w->data = data;
+        if (fl->waiters) {
+            /* The query is already pending */
+            DBG_(self, "%s (pending)", binder_sim_facility_code(type));
+            fl->waiters = g_slist_prepend(fl->waiters, w);
+            return;
+        }
+
+        fl->waiters = g_slist_prepend(NULL, w);
+        fl->query_serial = fl->serial;
+        if (binder_sim_query_facility_lock_submit(self, type,
+            binder_sim_query_facility_lock_done, fl)) {
+            return;
+        }
+
+        /* This completes the waiter */
+        binder_sim_query_facility_lock_done(binder_error_failure(&err),
+            FALSE, fl);
+    } else {
         cb(binder_error_failure(&err), FALSE, data);
     }
 }
@@ -2050,6 +2787,8 @@ binder_sim_open_channel_cb(
                 if (binder_read_int32(args, &channel)) {
                     /* Success */
                     DBG_(cbd->self, "%u", channel);
+                    g_hash_table_replace(cbd->self->channels,
+                        GINT_TO_POINTER(channel), g_bytes_ref(cbd->aid));
                     cb(binder_error_ok(&err), channel, cbd->data);
                     return;
                 } else {
@@ -2067,6 +2806,103 @@ binder_sim_open_channel_cb(
     cb(binder_error_failure(&err), 0, cbd->data);
 }
 
+static
+void
+binder_sim_channel_free(
+    BinderSimChannel* ch)
+{
+    if (ch->idle_id) {
+        g_source_remove(ch->idle_id);
+    }
+    g_bytes_unref(ch->aid);
+    g_slice_free(BinderSimChannel, ch);
+}
+
+static
+void
+binder_sim_channel_close(
+    BinderSim* self,
+    RadioRequestGroup* g,
+    int channel)
+{
+    /* iccCloseLogicalChannel(int32 serial, int32 channelId); */
+    GBinderWriter writer;
+    RadioRequest* req = g ?
+        radio_request_new2(g, RADIO_REQ_ICC_CLOSE_LOGICAL_CHANNEL,
+            &writer, NULL, NULL, NULL) :
+        radio_request_new(self->g->client, RADIO_REQ_ICC_CLOSE_LOGICAL_CHANNEL,
+            &writer, NULL, NULL, NULL);
+
+    DBG_(self, "closing idle channel %d", channel);
+    gbinder_writer_append_int32(&writer, channel);  /* channelId */
+    radio_request_set_timeout(req, SIM_IO_TIMEOUT_SECS * 1000);
+    radio_request_submit(req);
+    radio_request_unref(req);
+}
+
+static
+gboolean
+binder_sim_channel_idle_cb(
+    gpointer user_data)
+{
+    BinderSimChannel* ch = user_data;
+    BinderSim* self = ch->self;
+
+    binder_wakeup("sim channel idle");
+    ch->idle_id = 0;
+    self->idle_channels = g_slist_remove(self->idle_channels, ch);
+    g_hash_table_remove(self->channels, GINT_TO_POINTER(ch->channel));
+    binder_sim_channel_close(self, self->g, ch->channel);
+    binder_sim_channel_free(ch);
+    return G_SOURCE_REMOVE;
+}
+
+static
+BinderSimChannel*
+binder_sim_find_idle_channel(
+    BinderSim* self,
+    GBytes* aid)
+{
+    GSList* l;
+
+    for (l = self->idle_channels; l; l = l->next) {
+        BinderSimChannel* ch = l->data;
+
+        if (g_bytes_equal(ch->aid, aid)) {
+            return ch;
+        }
+    }
+    return NULL;
+}
+
+static
+void
+binder_sim_drop_idle_channels(
+    BinderSim* self,
+    gboolean close)
+{
+    GSList* list = self->idle_channels;
+    GSList* l;
+
+    /*
+     * The channels are gone anyway if the card has been removed.
+     * Otherwise (i.e. on exit) they need to be closed explicitly.
+     */
+    self->idle_channels = NULL;
+    for (l = list; l; l = l->next) {
+        BinderSimChannel* ch = l->data;
+
+        if (close) {
+            binder_sim_channel_close(self, NULL, ch->channel);
+        }
+        binder_sim_channel_free(ch);
+    }
+    g_slist_free(list);
+    if (!close) {
+        g_hash_table_remove_all(self->channels);
+    }
+}
+
 static
 void
 binder_sim_open_channel(
@@ -2077,15 +2913,34 @@ binder_sim_open_channel(
     void* data)
 {
     BinderSim* self = binder_sim_get_data(sim);
-    BinderSimCbdIo* cbd = binder_sim_cbd_io_new(self, BINDER_CB(cb), data);
+    GBytes* aid_bytes = g_bytes_new(aid, len);
+    BinderSimChannel* ch = binder_sim_find_idle_channel(self, aid_bytes);
+    BinderSimCbdIo* cbd;
+    GBinderWriter writer;
+    RadioRequest* req;
+    char *aid_hex;
     gboolean ok;
 
+    if (ch) {
+        struct ofono_error err;
+        const int channel = ch->channel;
+
+        /* There's no need to open another one */
+        DBG_(self, "reusing channel %d", channel);
+        self->idle_channels = g_slist_remove(self->idle_channels, ch);
+        binder_sim_channel_free(ch);
+        g_bytes_unref(aid_bytes);
+        cb(binder_error_ok(&err), channel, data);
+        return;
+    }
+
     /* iccOpenLogicalChannel(int32 serial, string aid, int32 p2); */
-    GBinderWriter writer;
-    RadioRequest* req = radio_request_new2(self->g,
+    cbd = binder_sim_cbd_io_new(self, BINDER_CB(cb), data);
+    cbd->aid = aid_bytes;
+    req = radio_request_new2(self->g,
         RADIO_REQ_ICC_OPEN_LOGICAL_CHANNEL, &writer,
         binder_sim_open_channel_cb, binder_sim_cbd_io_free, cbd);
-    char *aid_hex = binder_encode_hex(aid, len);
+    aid_hex = binder_encode_hex(aid, len);
 
     DBG_(self, "%s", aid_hex);
     gbinder_writer_add_cleanup(&writer, g_free, aid_hex);
@@ -2140,12 +2995,34 @@ binder_sim_close_channel(
     void* data)
 {
     BinderSim* self = binder_sim_get_data(sim);
-    BinderSimCbdIo* cbd = binder_sim_cbd_io_new(self, BINDER_CB(cb), data);
+    GBytes* aid = g_hash_table_lookup(self->channels,
+        GINT_TO_POINTER(channel));
+    BinderSimCbdIo* cbd;
+    GBinderWriter writer;
+    RadioRequest* req;
     gboolean ok;
 
+    if (self->channel_idle_ms && aid &&
+        !binder_sim_find_idle_channel(self, aid)) {
+        BinderSimChannel* ch = g_slice_new0(BinderSimChannel);
+        struct ofono_error err;
+
+        /* Keep it open for a while, it may be needed again soon */
+        DBG_(self, "keeping channel %d open", channel);
+        ch->self = self;
+        ch->aid = g_bytes_ref(aid);
+        ch->channel = channel;
+        ch->idle_id = binder_timeout_add_coarse(self->channel_idle_ms,
+            binder_sim_channel_idle_cb, ch);
+        self->idle_channels = g_slist_prepend(self->idle_channels, ch);
+        cb(binder_error_ok(&err), data);
+        return;
+    }
+
     /* iccCloseLogicalChannel(int32 serial, int32 channelId); */
-    GBinderWriter writer;
-    RadioRequest* req = radio_request_new2(self->g,
+    g_hash_table_remove(self->channels, GINT_TO_POINTER(channel));
+    cbd = binder_sim_cbd_io_new(self, BINDER_CB(cb), data);
+    req = radio_request_new2(self->g,
         RADIO_REQ_ICC_CLOSE_LOGICAL_CHANNEL, &writer,
         binder_sim_close_channel_cb, binder_sim_cbd_io_free, cbd);
 
@@ -2335,6 +3212,260 @@ binder_sim_logical_access(
     g_free(tmp);
 }
 
+static
+void
+binder_sim_apdu_free(
+    gpointer data)
+{
+    BinderSimApdu* apdu = data;
+
+    g_free(apdu->hex_data);
+    gutil_slice_free(apdu);
+}
+
+static
+void
+binder_sim_apdu_script_free(
+    gpointer data)
+{
+    BinderSimApduScript* script = data;
+
+    g_ptr_array_free(script->apdus, TRUE);
+    g_byte_array_free(script->collected, TRUE);
+    g_byte_array_free(script->response, TRUE);
+    gutil_slice_free(script);
+}
+
+static
+BinderSimApduScript*
+binder_sim_apdu_script_new(
+    BinderSim* self,
+    int channel,
+    BinderSimApduScriptFunc done,
+    GCallback cb,
+    void* data)
+{
+    BinderSimApduScript* script = g_slice_new0(BinderSimApduScript);
+    BinderSimSessionCbData* cbd = binder_sim_session_cbd_new(self, channel,
+        binder_sim_apdu_cla(channel), NULL, script);
+
+    /* The script lives as long as its session cbd */
+    cbd->destroy = binder_sim_apdu_script_free;
+    script->cbd = cbd;
+    script->apdus = g_ptr_array_new_with_free_func(binder_sim_apdu_free);
+    script->collected = g_byte_array_new();
+    script->response = g_byte_array_new();
+    script->done = done;
+    script->cb = cb;
+    script->data = data;
+    return script;
+}
+
+static
+void
+binder_sim_apdu_script_add(
+    BinderSimApduScript* script,
+    int ins,
+    int p1,
+    int p2,
+    int p3,
+    const guint8* data,
+    guint len,
+    gboolean collect)
+{
+    BinderSimApdu* apdu = g_slice_new0(BinderSimApdu);
+
+    apdu->ins = ins;
+    apdu->p1 = p1;
+    apdu->p2 = p2;
+    apdu->p3 = p3;
+    apdu->hex_data = len ? binder_encode_hex(data, len) : NULL;
+    apdu->collect = collect;
+    g_ptr_array_add(script->apdus, apdu);
+}
+
+static
+void
+binder_sim_apdu_script_add_select(
+    BinderSimApduScript* script,
+    int fileid,
+    const guint8* path,
+    guint path_len,
+    int p2)
+{
+    guint8 fid[2];
+    guint i;
+
+    /* Select the path components one by one, then the file itself */
+    for (i = 0; i + 1 < path_len; i += 2) {
+        binder_sim_apdu_script_add(script, CMD_SELECT, 0, SELECT_NO_RESPONSE,
+            2, path + i, 2, FALSE);
+    }
+    fid[0] = (guint8)(fileid >> 8);
+    fid[1] = (guint8)fileid;
+    binder_sim_apdu_script_add(script, CMD_SELECT, 0, p2, 2, fid, 2,
+        p2 != SELECT_NO_RESPONSE);
+}
+
+static
+void
+binder_sim_apdu_script_finish(
+    BinderSimApduScript* script,
+    const struct ofono_error* err)
+{
+    DBG_(script->cbd->self, "%u/%u commands, %u bytes", script->index,
+        script->apdus->len, script->collected->len);
+    script->done(script, err);
+}
+
+static
+void
+binder_sim_apdu_script_cb(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    gpointer user_data);
+
+static
+void
+binder_sim_apdu_script_submit(
+    BinderSimApduScript* script,
+    int ins,
+    int p1,
+    int p2,
+    int p3,
+    const char* hex_data)
+{
+    if (!binder_sim_logical_access_transmit(script->cbd, ins, p1, p2, p3,
+        hex_data, binder_sim_apdu_script_cb)) {
+        struct ofono_error err;
+
+        binder_sim_apdu_script_finish(script, binder_error_failure(&err));
+    }
+}
+
+static
+void
+binder_sim_apdu_script_next(
+    BinderSimApduScript* script)
+{
+    if (script->index < script->apdus->len) {
+        const BinderSimApdu* apdu = script->apdus->pdata[script->index];
+
+        script->resends = 0;
+        g_byte_array_set_size(script->response, 0);
+        binder_sim_apdu_script_submit(script, apdu->ins, apdu->p1, apdu->p2,
+            apdu->p3, apdu->hex_data);
+    } else {
+        struct ofono_error err;
+
+        binder_sim_apdu_script_finish(script, binder_error_ok(&err));
+    }
+}
+
+static
+void
+binder_sim_apdu_script_cb(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderSimSessionCbData* cbd = user_data;
+    BinderSimApduScript* script = cbd->data;
+    struct ofono_error err;
+
+    cbd->req_id = 0;
+    binder_error_init_failure(&err);
+    if (status == RADIO_TX_STATUS_OK) {
+        if (resp == RADIO_RESP_ICC_TRANSMIT_APDU_LOGICAL_CHANNEL) {
+            BinderSimIoResponse* res = binder_sim_io_response_new(args);
+
+            if (res && error == RADIO_ERROR_NONE) {
+                const BinderSimApdu* apdu = script->apdus->pdata
+                    [script->index];
+
+                if (res->data_len) {
+                    g_byte_array_append(script->response, res->data,
+                        res->data_len);
+                }
+
+                /* See binder_sim_logical_access_cb */
+                switch (binder_sim_apdu_step(res->sw1, script->resends)) {
+                case BINDER_SIM_APDU_STEP_GET_RESPONSE:
+                    binder_sim_apdu_script_submit(script, CMD_GET_RESPONSE,
+                        0, 0, res->sw2, NULL);
+                    break;
+                case BINDER_SIM_APDU_STEP_RESEND:
+                    script->resends++;
+                    g_byte_array_set_size(script->response, 0);
+                    binder_sim_apdu_script_submit(script, apdu->ins,
+                        apdu->p1, apdu->p2, res->sw2, apdu->hex_data);
+                    break;
+                case BINDER_SIM_APDU_STEP_FAIL:
+                    ofono_warn("Command %02X keeps asking for a resend",
+                        apdu->ins);
+                    binder_sim_apdu_script_finish(script,
+                        binder_error_sim(&err, res->sw1, res->sw2));
+                    break;
+                case BINDER_SIM_APDU_STEP_DONE:
+                    if (binder_sim_io_response_ok(res)) {
+                        if (apdu->collect) {
+                            g_byte_array_append(script->collected,
+                                script->response->data,
+                                script->response->len);
+                        }
+                        script->index++;
+                        binder_sim_apdu_script_next(script);
+                    } else {
+                        binder_sim_apdu_script_finish(script,
+                            binder_error_sim(&err, res->sw1, res->sw2));
+                    }
+                    break;
+                }
+                binder_sim_io_response_free(res);
+                return;
+            }
+            binder_sim_io_response_free(res);
+        } else {
+            ofono_error("Unexpected iccTransmitApduLogicalChannel response %d",
+                resp);
+        }
+    }
+    binder_sim_apdu_script_finish(script, &err);
+}
+
+static
+void
+binder_sim_apdu_script_run(
+    BinderSimApduScript* script)
+{
+    BinderSimSessionCbData* cbd = script->cbd;
+
+    binder_sim_apdu_script_next(script);
+    binder_sim_session_cbd_unref(cbd);
+}
+
+static
+void
+binder_sim_session_read_done(
+    BinderSimApduScript* script,
+    const struct ofono_error* err)
+{
+    ofono_sim_read_cb_t cb = (ofono_sim_read_cb_t) script->cb;
+
+    if (err->type == OFONO_ERROR_TYPE_NO_ERROR) {
+        cb(err, script->collected->data, script->collected->len,
+            script->data);
+    } else {
+        cb(err, NULL, 0, script->data);
+    }
+}
+
 static
 void
 binder_sim_session_read_binary(
@@ -2348,10 +3479,38 @@ binder_sim_session_read_binary(
     ofono_sim_read_cb_t cb,
     void* data)
 {
-    struct ofono_error error;
+    BinderSim* self = binder_sim_get_data(sim);
+    BinderSimApduScript* script = binder_sim_apdu_script_new(self, session,
+        binder_sim_session_read_done, G_CALLBACK(cb), data);
+    int off = start, end = start + length;
+    gboolean ok = TRUE;
+
+    DBG_(self, "%u %04X %d..%d", session, fileid, start, end);
+    binder_sim_apdu_script_add_select(script, fileid, path, path_len,
+        SELECT_NO_RESPONSE);
+    while (ok && off < end) {
+        const int n = MIN(end - off, SESSION_READ_CHUNK);
+        guint8 p1, p2;
+
+        ok = binder_sim_apdu_binary_offset(off, &p1, &p2);
+        if (ok) {
+            binder_sim_apdu_script_add(script, CMD_READ_BINARY, p1, p2, n,
+                NULL, 0, TRUE);
+            off += n;
+        }
+    }
+
+    if (ok) {
+        binder_sim_apdu_script_run(script);
+    } else {
+        BinderSimSessionCbData* cbd = script->cbd;
+        struct ofono_error err;
 
-    ofono_error("session_read_binary not implemented");
-    cb(binder_error_failure(&error), NULL, 0, data);
+        /* Completes the request and drops the script */
+        ofono_warn("Can't read %04X at offset %d", fileid, off);
+        binder_sim_apdu_script_finish(script, binder_error_failure(&err));
+        binder_sim_session_cbd_unref(cbd);
+    }
 }
 
 static
@@ -2367,10 +3526,42 @@ binder_sim_session_read_record(
     ofono_sim_read_cb_t cb,
     void* data)
 {
-    struct ofono_error error;
+    BinderSim* self = binder_sim_get_data(sim);
+    BinderSimApduScript* script = binder_sim_apdu_script_new(self, channel,
+        binder_sim_session_read_done, G_CALLBACK(cb), data);
 
-    ofono_error("session_read_record not implemented");
-    cb(binder_error_failure(&error), NULL, 0, data);
+    DBG_(self, "%u %04X #%d", channel, fileid, record);
+    binder_sim_apdu_script_add_select(script, fileid, path, path_len,
+        SELECT_NO_RESPONSE);
+    binder_sim_apdu_script_add(script, CMD_READ_RECORD, record,
+        MODE_ABSOLUTE, length, NULL, 0, TRUE);
+    binder_sim_apdu_script_run(script);
+}
+
+static
+void
+binder_sim_session_read_info_done(
+    BinderSimApduScript* script,
+    const struct ofono_error* err)
+{
+    ofono_sim_file_info_cb_t cb = (ofono_sim_file_info_cb_t) script->cb;
+
+    if (err->type == OFONO_ERROR_TYPE_NO_ERROR) {
+        BinderSimFileInfo info;
+
+        if (binder_sim_parse_file_info(&info, script->collected->data,
+            script->collected->len)) {
+            cb(err, info.flen, info.str, info.rlen, info.faccess,
+                info.fstatus, script->data);
+        } else {
+            struct ofono_error error;
+
+            cb(binder_error_failure(&error), -1, -1, -1, NULL, 0,
+                script->data);
+        }
+    } else {
+        cb(err, -1, -1, -1, NULL, 0, script->data);
+    }
 }
 
 static
@@ -2384,10 +3575,14 @@ binder_sim_session_read_info(
     ofono_sim_file_info_cb_t cb,
     void* data)
 {
-    struct ofono_error error;
+    BinderSim* self = binder_sim_get_data(sim);
+    BinderSimApduScript* script = binder_sim_apdu_script_new(self, channel,
+        binder_sim_session_read_info_done, G_CALLBACK(cb), data);
 
-    ofono_error("session_read_info not implemented");
-    cb(binder_error_failure(&error), -1, -1, -1, NULL, 0, data);
+    DBG_(self, "%u %04X", channel, fileid);
+    binder_sim_apdu_script_add_select(script, fileid, path, path_len,
+        SELECT_RETURN_FCP);
+    binder_sim_apdu_script_run(script);
 }
 
 static
@@ -2405,6 +3600,8 @@ binder_sim_refresh_cb(
      * so we could be more descrete here. However I have't actually
      * seen that in real life, let's just refresh everything for now.
      */
+    binder_sim_io_cache_clear(self->cache);
+    g_hash_table_remove_all(self->prefetched);
     ofono_sim_refresh_full(self->sim);
 }
 
@@ -2423,8 +3620,8 @@ binder_sim_register(
     ofono_sim_register(self->sim);
 
     /* Register for change notifications */
-    self->card_event_id[SIM_CARD_STATUS_EVENT] =
-        binder_sim_card_add_status_changed_handler(self->card,
+    self->card_event_id[SIM_CARD_STATE_EVENT] =
+        binder_sim_card_add_state_changed_handler(self->card,
             binder_sim_status_changed_cb, self);
     self->card_event_id[SIM_CARD_APP_EVENT] =
         binder_sim_card_add_app_changed_handler(self->card,
@@ -2432,6 +3629,10 @@ binder_sim_register(
     self->sim_state_watch_id =
         ofono_watch_add_sim_state_changed_handler(self->watch,
             binder_sim_state_changed_cb, self);
+    self->iccid_watch_id =
+        ofono_watch_add_iccid_changed_handler(self->watch,
+            binder_sim_iccid_changed_cb, self);
+    binder_sim_io_cache_set_iccid(self->cache, self->watch->iccid);
 
     /* And IRadio events */
     self->io_event_id[IO_EVENT_SIM_REFRESH] =
@@ -2457,6 +3658,18 @@ binder_sim_probe(
     self->log_prefix = binder_dup_prefix(modem->log_prefix);
     self->empty_pin_query_allowed = modem->config.empty_pin_query;
     self->card = binder_sim_card_ref(modem->sim_card);
+    self->cache = modem->sim_io_cache;
+    self->io_max = MAX(modem->config.sim_io_concurrency, 1);
+    /* Read-ahead would only delay the serialized requests */
+    self->prefetch_max = (self->io_max > 1) ?
+        modem->config.sim_record_prefetch : 0;
+    self->channel_idle_ms = modem->config.sim_channel_idle_ms;
+    self->channels = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+        NULL, (GDestroyNotify) g_bytes_unref);
+    self->prefetch = g_hash_table_new_full(g_str_hash, g_str_equal,
+        g_free, NULL);
+    self->prefetched = g_hash_table_new_full(g_str_hash, g_str_equal,
+        g_free, NULL);
     self->g = radio_request_group_new(modem->client); /* Keeps ref to client */
     self->watch = ofono_watch_new(binder_modem_get_path(modem));
     self->sim = sim;
@@ -2471,6 +3684,9 @@ binder_sim_probe(
 static void binder_sim_remove(struct ofono_sim *sim)
 {
     BinderSim* self = binder_sim_get_data(sim);
+    GHashTableIter it;
+    gpointer value;
+    guint i;
 
     DBG_(self, "");
 
@@ -2479,9 +3695,24 @@ static void binder_sim_remove(struct ofono_sim *sim)
 
     radio_client_remove_all_handlers(self->g->client, self->io_event_id);
     radio_request_drop(self->query_pin_retries_req);
+    binder_sim_drop_idle_channels(self, TRUE);
+    g_hash_table_destroy(self->channels);
+    self->io_max = 0;
+    binder_sim_io_cancel_queued(self);
     radio_request_group_cancel(self->g);
     radio_request_group_unref(self->g);
 
+    if (self->prefetch_sent) {
+        DBG_(self, "%u record(s) prefetched, %u used", self->prefetch_sent,
+            self->prefetch_hits);
+    }
+    g_hash_table_iter_init(&it, self->prefetch);
+    while (g_hash_table_iter_next(&it, NULL, &value)) {
+        g_slist_free_full(value, binder_sim_io_wait_free);
+    }
+    g_hash_table_destroy(self->prefetch);
+    g_hash_table_destroy(self->prefetched);
+
     if (self->list_apps_id) {
         g_source_remove(self->list_apps_id);
     }
@@ -2490,6 +3721,14 @@ static void binder_sim_remove(struct ofono_sim *sim)
         g_source_remove(self->idle_id);
     }
 
+    if (self->cache_hit_id) {
+        g_source_remove(self->cache_hit_id);
+    }
+    while (!g_queue_is_empty(&self->cache_hits)) {
+        binder_sim_cbd_io_free(g_queue_pop_head(&self->cache_hits));
+    }
+    binder_sim_io_cache_set_iccid(self->cache, NULL);
+
     if (self->query_passwd_state_timeout_id) {
         g_source_remove(self->query_passwd_state_timeout_id);
     }
@@ -2500,11 +3739,18 @@ static void binder_sim_remove(struct ofono_sim *sim)
     }
 
     ofono_watch_remove_handler(self->watch, self->sim_state_watch_id);
+    ofono_watch_remove_handler(self->watch, self->iccid_watch_id);
     ofono_watch_unref(self->watch);
 
     binder_sim_card_remove_all_handlers(self->card, self->card_event_id);
     binder_sim_card_unref(self->card);
 
+    for (i = 0; i < G_N_ELEMENTS(self->fac_lock); i++) {
+        /* Requests have been cancelled, waiters are never completed */
+        g_slist_free_full(self->fac_lock[i].waiters,
+            binder_sim_fac_lock_waiter_free);
+    }
+    g_free(self->fac_lock_aid);
     g_free(self->log_prefix);
     g_free(self);
 
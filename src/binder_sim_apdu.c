@@ -0,0 +1,67 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_sim_apdu.h"
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+int
+binder_sim_apdu_cla(
+    int channel)
+{
+    /* TS 102.221 10.1.1 Coding of Class Byte */
+    return (channel < 4) ? channel : (0x40 | ((channel - 4) & 0x0f));
+}
+
+gboolean
+binder_sim_apdu_binary_offset(
+    int offset,
+    guint8* p1,
+    guint8* p2)
+{
+    if (offset >= 0 && offset <= BINDER_SIM_APDU_MAX_OFFSET) {
+        *p1 = (guint8)(offset >> 8);
+        *p2 = (guint8)offset;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+BINDER_SIM_APDU_STEP
+binder_sim_apdu_step(
+    guint sw1,
+    guint resends)
+{
+    switch (sw1) {
+    case 0x61:
+        return BINDER_SIM_APDU_STEP_GET_RESPONSE;
+    case 0x6C:
+        /* TS 102 221 10.2.1.3 Wrong length, resend with Le */
+        return (resends < BINDER_SIM_APDU_MAX_RESENDS) ?
+            BINDER_SIM_APDU_STEP_RESEND : BINDER_SIM_APDU_STEP_FAIL;
+    default:
+        return BINDER_SIM_APDU_STEP_DONE;
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
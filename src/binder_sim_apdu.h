@@ -0,0 +1,69 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_SIM_APDU_H
+#define BINDER_SIM_APDU_H
+
+#include "binder_types.h"
+
+/* TS 102 221 11.1.3 READ BINARY offset is 15 bits, b8 of P1 means SFI */
+#define BINDER_SIM_APDU_MAX_OFFSET (0x7fff)
+
+/* How many times the same command may be resent on '6C xx' */
+#define BINDER_SIM_APDU_MAX_RESENDS (2)
+
+typedef enum binder_sim_apdu_step {
+    BINDER_SIM_APDU_STEP_DONE,          /* Check the status words */
+    BINDER_SIM_APDU_STEP_GET_RESPONSE,  /* '61 xx' Fetch xx more bytes */
+    BINDER_SIM_APDU_STEP_RESEND,        /* '6C xx' Resend with Le = xx */
+    BINDER_SIM_APDU_STEP_FAIL           /* Too many resends */
+} BINDER_SIM_APDU_STEP;
+
+int
+binder_sim_apdu_cla(
+    int channel)
+    BINDER_INTERNAL;
+
+/*
+ * Encodes the READ BINARY / UPDATE BINARY offset into P1 and P2.
+ * Returns FALSE if the offset can't be addressed that way.
+ */
+gboolean
+binder_sim_apdu_binary_offset(
+    int offset,
+    guint8* p1,
+    guint8* p2)
+    BINDER_INTERNAL;
+
+/*
+ * Decides what to do with the procedure bytes. The caller counts the
+ * resends of the current command and resets the count when moving to
+ * the next one.
+ */
+BINDER_SIM_APDU_STEP
+binder_sim_apdu_step(
+    guint sw1,
+    guint resends)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_SIM_APDU_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -13,6 +13,7 @@
  *  GNU General Public License for more details.
  */
 
+#include "binder_metrics.h"
 #include "binder_sim_card.h"
 #include "binder_radio.h"
 #include "binder_util.h"
@@ -48,6 +49,8 @@
  * it doesn't depend that much on the system load. */
 #define SIM_IO_IDLE_LOOPS (10)
 
+#define BINDER_SIM_CARD_STATS_SUFFIX "-simcard.stats"
+
 enum binder_sim_card_event {
     EVENT_SIM_STATUS_CHANGED,
     EVENT_UICC_SUBSCRIPTION_STATUS_CHANGED,
@@ -64,8 +67,35 @@ typedef struct binder_sim_card_object {
     guint sim_io_idle_id;
     guint sim_io_idle_count;
     GHashTable* sim_io_pending;
+    guint status_debounce_ms;
+    guint status_window_id;
+    gboolean status_pending; /* Indication received within the window */
+    RADIO_APP_STATE sub_app_state;
+    gint64 present_time;
+    int subscribed_ms;
+    guint stat_indications;
+    guint stat_queries;
+    guint stat_subscriptions;
+    gboolean stats_dirty;
 } BinderSimCardObject;
 
+static const BinderMetricFamily binder_sim_card_metric_inds = {
+    "binder_sim_status_indications", BINDER_METRIC_COUNTER,
+    "SIM status change indications"
+};
+static const BinderMetricFamily binder_sim_card_metric_queries = {
+    "binder_sim_status_queries", BINDER_METRIC_COUNTER,
+    "SIM status queries"
+};
+static const BinderMetricFamily binder_sim_card_metric_subscriptions = {
+    "binder_sim_subscriptions", BINDER_METRIC_COUNTER,
+    "UICC subscription requests"
+};
+static const BinderMetricFamily binder_sim_card_metric_sim_io = {
+    "binder_sim_io_pending", BINDER_METRIC_GAUGE,
+    "SIM I/O requests in progress"
+};
+
 enum binder_sim_card_signal {
     SIGNAL_STATUS_RECEIVED,
     SIGNAL_STATUS_CHANGED,
@@ -290,6 +320,9 @@ binder_sim_card_subscribe(
     /* N.B. Some adaptations never reply to SET_UICC_SUBSCRIPTION request */
     radio_request_drop(self->sub_req);
     self->sub_req = req;
+    self->sub_app_state = card->status->apps[app_index].app_state;
+    self->stat_subscriptions++;
+    self->stats_dirty = TRUE;
 
     /*
      * Don't allow any requests other that GET_SIM_STATUS until
@@ -332,18 +365,45 @@ binder_sim_card_update_app(
     int app_index;
 
     if (status->card_state == RADIO_CARD_STATE_PRESENT) {
+        if (!self->present_time) {
+            self->present_time = g_get_monotonic_time();
+            self->subscribed_ms = -1;
+        }
         if (status->gsm_umts_index >= 0 &&
             status->gsm_umts_index < status->num_apps) {
             app_index = status->gsm_umts_index;
+            if (self->subscribed_ms < 0) {
+                self->subscribed_ms = (int)((g_get_monotonic_time() -
+                    self->present_time) / 1000);
+                self->stats_dirty = TRUE;
+                DBG("slot %u subscribed in %d ms", card->slot,
+                    self->subscribed_ms);
+            }
             binder_sim_card_subscription_done(self);
         } else {
             app_index = binder_sim_card_select_app(status);
             if (app_index >= 0 && !self->sub_start_timer) {
-                binder_sim_card_subscribe(self, app_index);
+                const RADIO_APP_STATE app_state =
+                    status->apps[app_index].app_state;
+
+                if (!self->sub_req) {
+                    binder_sim_card_subscribe(self, app_index);
+                } else if (self->sub_app_state != app_state) {
+                    /*
+                     * The app has moved on, the modem may be ready
+                     * to accept the subscription now. Don't wait for
+                     * the retry timer.
+                     */
+                    DBG("app state %d => %d, retrying subscription",
+                        self->sub_app_state, app_state);
+                    self->sub_app_state = app_state;
+                    radio_request_retry(self->sub_req);
+                }
             }
         }
     } else {
         app_index = -1;
+        self->present_time = 0;
         binder_sim_card_subscription_done(self);
     }
 
@@ -473,6 +533,68 @@ binder_sim_card_status_new(
     return status;
 }
 
+static
+gboolean
+binder_sim_card_status_matches(
+    const BinderSimCardStatus* status,
+    const RadioCardStatus* radio_status)
+{
+    const guint num_apps = radio_status->apps.count;
+
+    if (status &&
+        status->card_state == radio_status->cardState &&
+        status->pin_state == radio_status->universalPinState &&
+        status->gsm_umts_index ==
+            radio_status->gsmUmtsSubscriptionAppIndex &&
+        status->ims_index == radio_status->imsSubscriptionAppIndex &&
+        status->num_apps == num_apps) {
+        const RadioAppStatus* radio_apps = radio_status->apps.data.ptr;
+        guint i;
+
+        for (i = 0; i < num_apps; i++) {
+            const RadioAppStatus* radio_app = radio_apps + i;
+            const BinderSimCardApp* app = status->apps + i;
+
+            if (app->app_type != radio_app->appType ||
+                app->app_state != radio_app->appState ||
+                app->perso_substate != radio_app->persoSubstate ||
+                app->pin_replaced != radio_app->pinReplaced ||
+                app->pin1_state != radio_app->pin1 ||
+                app->pin2_state != radio_app->pin2 ||
+                g_strcmp0(app->aid, radio_app->aid.data.str) ||
+                g_strcmp0(app->label, radio_app->label.data.str)) {
+                return FALSE;
+            }
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static
+void
+binder_sim_card_status_received(
+    BinderSimCardObject* self,
+    const RadioCardStatus* radio_status)
+{
+    BinderSimCard* card = &self->card;
+
+    if (binder_sim_card_status_matches(card->status, radio_status)) {
+        /*
+         * Most of simStatusChanged indications don't actually change
+         * anything. Keep the current status (and the app pointer) as
+         * is, don't allocate anything and don't wake up everyone.
+         */
+        DBG("status unchanged for slot %u", card->slot);
+        binder_sim_card_update_app(self);
+        g_signal_emit(self, binder_sim_card_signals
+            [SIGNAL_STATUS_RECEIVED], 0);
+    } else {
+        binder_sim_card_update_status(self,
+            binder_sim_card_status_new(radio_status));
+    }
+}
+
 static
 void
 binder_sim_card_status_cb(
@@ -490,41 +612,37 @@ binder_sim_card_status_cb(
     self->status_req = NULL;
 
     if (status == RADIO_TX_STATUS_OK && error == RADIO_ERROR_NONE) {
-        const RadioCardStatus* status_1_0;
         const RadioCardStatus_1_2* status_1_2;
         const RadioCardStatus_1_4* status_1_4;
         const RadioCardStatus_1_5* status_1_5;
-        BinderSimCardStatus* status = NULL;
+        const RadioCardStatus* status = NULL;
         GBinderReader reader;
 
         gbinder_reader_copy(&reader, args);
         switch (resp) {
         case RADIO_RESP_GET_ICC_CARD_STATUS:
-            status_1_0 = gbinder_reader_read_hidl_struct(&reader,
+            status = gbinder_reader_read_hidl_struct(&reader,
                 RadioCardStatus);
-            if (status_1_0) {
-                status = binder_sim_card_status_new(status_1_0);
-            }
             break;
         case RADIO_RESP_GET_ICC_CARD_STATUS_1_2:
             status_1_2 = gbinder_reader_read_hidl_struct(&reader,
                 RadioCardStatus_1_2);
             if (status_1_2) {
-                status = binder_sim_card_status_new(&status_1_2->base);
+                status = &status_1_2->base;
             }
             break;
         case RADIO_RESP_GET_ICC_CARD_STATUS_RESPONSE_1_4:
             status_1_4 = gbinder_reader_read_hidl_struct(&reader,
                 RadioCardStatus_1_4);
             if (status_1_4) {
-                status = binder_sim_card_status_new(&status_1_4->base);
+                status = &status_1_4->base;
             }
             break;
         case RADIO_RESP_GET_ICC_CARD_STATUS_1_5:
             status_1_5 = gbinder_reader_read_hidl_struct(&reader,
                 RadioCardStatus_1_5);
             if (status_1_5) {
-                status = binder_sim_card_status_new(&status_1_5->base.base);
+                status = &status_1_5->base.base;
             }
             break;
         default:
@@ -532,7 +650,7 @@ binder_sim_card_status_cb(
         }
 
         if (status) {
-            binder_sim_card_update_status(self, status);
+            binder_sim_card_status_received(self, status);
         }
     }
     binder_sim_card_tx_check(self);
@@ -543,6 +661,10 @@ void
 binder_sim_card_get_status(
     BinderSimCardObject* self)
 {
+    /* This query covers the pending indications too */
+    self->status_pending = FALSE;
+    self->stat_queries++;
+    self->stats_dirty = TRUE;
     if (self->status_req) {
         /* Retry right away, don't wait for retry timeout to expire */
         radio_request_retry(self->status_req);
@@ -601,6 +723,21 @@ binder_sim_card_sim_io_idle_cb(
     }
 }
 
+static
+gboolean
+binder_sim_card_status_window_cb(
+    gpointer user_data)
+{
+    BinderSimCardObject* self = THIS(user_data);
+
+    GASSERT(self->status_window_id);
+    self->status_window_id = 0;
+    if (self->status_pending) {
+        binder_sim_card_get_status(self);
+    }
+    return G_SOURCE_REMOVE;
+}
+
 static
 void
 binder_sim_card_status_changed(
@@ -609,7 +746,25 @@ binder_sim_card_status_changed(
     const GBinderReader* args,
     gpointer user_data)
 {
-    binder_sim_card_get_status(THIS(user_data));
+    BinderSimCardObject* self = THIS(user_data);
+
+    self->stat_indications++;
+    self->stats_dirty = TRUE;
+    if (self->status_window_id) {
+        /*
+         * Some RILs fire a whole bunch of these during SIM bring-up.
+         * The rest of the burst is covered by a single query when
+         * the window closes.
+         */
+        self->status_pending = TRUE;
+    } else {
+        /* The first one is handled immediately and opens the window */
+        binder_sim_card_get_status(self);
+        if (self->status_debounce_ms) {
+            self->status_window_id = g_timeout_add(self->status_debounce_ms,
+                binder_sim_card_status_window_cb, self);
+        }
+    }
 }
 
 /*==========================================================================*
@@ -619,13 +774,15 @@ binder_sim_card_status_changed(
 BinderSimCard*
 binder_sim_card_new(
     RadioClient* client,
-    guint slot)
+    guint slot,
+    guint status_debounce_ms)
 {
     BinderSimCardObject* self = g_object_new(THIS_TYPE, NULL);
     BinderSimCard *card = &self->card;
 
     DBG("%u", slot);
     card->slot = slot;
+    self->status_debounce_ms = status_debounce_ms;
     self->g = radio_request_group_new(client); /* Keeps ref to client */
 
     self->event_id[EVENT_SIM_STATUS_CHANGED] =
@@ -735,6 +892,70 @@ binder_sim_card_ready(
           card->app->perso_substate == RADIO_PERSO_SUBSTATE_READY));
 }
 
+char*
+binder_sim_card_format_stats(
+    BinderSimCard* card)
+{
+    BinderSimCardObject* self = binder_sim_card_cast(card);
+
+    return self ? g_strdup_printf("# indications queries coalesced"
+        " subscriptions subscribed_ms sim_io_pending\n%u %u %u %u %d %u\n",
+        self->stat_indications, self->stat_queries,
+        self->stat_indications > self->stat_queries ?
+        (self->stat_indications - self->stat_queries) : 0,
+        self->stat_subscriptions, self->subscribed_ms,
+        g_hash_table_size(self->sim_io_pending)) : NULL;
+}
+
+void
+binder_sim_card_add_metrics(
+    BinderSimCard* card,
+    BinderMetrics* metrics,
+    const char* labels)
+{
+    BinderSimCardObject* self = binder_sim_card_cast(card);
+
+    if (self && metrics) {
+        binder_metrics_add(metrics, &binder_sim_card_metric_inds, labels,
+            self->stat_indications);
+        binder_metrics_add(metrics, &binder_sim_card_metric_queries, labels,
+            self->stat_queries);
+        binder_metrics_add(metrics, &binder_sim_card_metric_subscriptions,
+            labels, self->stat_subscriptions);
+        binder_metrics_add(metrics, &binder_sim_card_metric_sim_io, labels,
+            g_hash_table_size(self->sim_io_pending));
+    }
+}
+
+gboolean
+binder_sim_card_write_stats(
+    BinderSimCard* card,
+    const char* dir,
+    const char* name)
+{
+    BinderSimCardObject* self = binder_sim_card_cast(card);
+    gboolean ok = FALSE;
+
+    if (self && dir && name && self->stats_dirty) {
+        char* file = g_strconcat(name, BINDER_SIM_CARD_STATS_SUFFIX, NULL);
+        char* path = g_build_filename(dir, file, NULL);
+        char* text = binder_sim_card_format_stats(card);
+        GError* error = NULL;
+
+        if (g_file_set_contents(path, text, -1, &error)) {
+            self->stats_dirty = FALSE;
+            ok = TRUE;
+        } else {
+            ofono_warn("Failed to write %s: %s", path, error->message);
+            g_error_free(error);
+        }
+        g_free(text);
+        g_free(path);
+        g_free(file);
+    }
+    return ok;
+}
+
 gulong
 binder_sim_card_add_status_received_handler(
     BinderSimCard* card,
@@ -826,6 +1047,7 @@ binder_sim_card_init(
     BinderSimCardObject* self)
 {
     self->sim_io_pending = g_hash_table_new(g_direct_hash, g_direct_equal);
+    self->subscribed_ms = -1;
 }
 
 static
@@ -842,6 +1064,9 @@ binder_sim_card_finalize(
     if (self->sub_start_timer) {
         g_source_remove(self->sub_start_timer);
     }
+    if (self->status_window_id) {
+        g_source_remove(self->status_window_id);
+    }
     g_hash_table_destroy(self->sim_io_pending);
 
     radio_request_drop(self->status_req);
@@ -57,7 +57,8 @@ void
 BinderSimCard*
 binder_sim_card_new(
     RadioClient* client,
-    guint slot)
+    guint slot,
+    guint status_debounce_ms)
     BINDER_INTERNAL;
 
 BinderSimCard*
@@ -97,6 +98,26 @@ binder_sim_card_ready(
     BinderSimCard* card)
     BINDER_INTERNAL;
 
+char*
+binder_sim_card_format_stats(
+    BinderSimCard* card)
+    G_GNUC_WARN_UNUSED_RESULT
+    BINDER_INTERNAL;
+
+void
+binder_sim_card_add_metrics(
+    BinderSimCard* card,
+    BinderMetrics* metrics,
+    const char* labels)
+    BINDER_INTERNAL;
+
+gboolean
+binder_sim_card_write_stats(
+    BinderSimCard* card,
+    const char* dir,
+    const char* name)
+    BINDER_INTERNAL;
+
 gulong
 binder_sim_card_add_status_received_handler(
     BinderSimCard* card,
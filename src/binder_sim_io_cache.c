@@ -0,0 +1,548 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_sim_io_cache.h"
+#include "binder_log.h"
+#include "binder_util.h"
+
+#include <gutil_macros.h>
+
+#include <glib/gstdio.h>
+
+#define BINDER_SIM_IO_CACHE_SAVE_DELAY_SEC (5)
+
+#define KEY_FID   "fid"
+#define KEY_SW1   "sw1"
+#define KEY_SW2   "sw2"
+#define KEY_DATA  "data"
+
+struct binder_sim_io_cache {
+    char* log_prefix;
+    char* storage_dir;
+    char* iccid;        /* Owner of the cached data */
+    gboolean active;    /* ICCID of the current card matches */
+    gboolean dirty;     /* Storage needs to be updated */
+    guint save_id;
+    GHashTable* files;  /* key => BinderSimIoCacheEntry */
+    guint hits;
+    guint misses;
+};
+
+#define DBG_(self,fmt,args...) DBG("%s" fmt, (self)->log_prefix, ##args)
+
+/*
+ * Files which can only be changed by the operator (over the air, which
+ * is followed by SIM refresh). Those are worth keeping across restarts.
+ * Personal data (the phone book and its extension records) is kept in
+ * memory only and never written to the storage.
+ */
+static const guint binder_sim_io_cache_static_files[] = {
+    0x2F05, /* EF_PL */
+    0x6F05, /* EF_LI */
+    0x6F14, /* EF_CPHS_ONS */
+    0x6F16, /* EF_CPHS_INFO */
+    0x6F18, /* EF_CPHS_ONS_SHORT */
+    0x6F38, /* EF_SST/EF_UST */
+    0x6F3E, /* EF_GID1 */
+    0x6F3F, /* EF_GID2 */
+    0x6F46, /* EF_SPN */
+    0x6F56, /* EF_EST */
+    0x6FAD, /* EF_AD */
+    0x6FB7, /* EF_ECC */
+    0x6FC5, /* EF_PNN */
+    0x6FC6, /* EF_OPL */
+    0x6FCD  /* EF_SPDI */
+};
+
+/*
+ * Files which the baseband updates on its own (location, forbidden
+ * networks, status of messages and call forwarding). Any cached copy
+ * of those may be stale, so they are never cached at all.
+ */
+static const guint binder_sim_io_cache_volatile_files[] = {
+    0x6F11, /* EF_CPHS_MWIS */
+    0x6F13, /* EF_CPHS_CFF */
+    0x6F20, /* EF_KC */
+    0x6F39, /* EF_ACM */
+    0x6F3C, /* EF_SMS */
+    0x6F43, /* EF_SMSS */
+    0x6F52, /* EF_KCGPRS */
+    0x6F73, /* EF_PSLOCI */
+    0x6F7B, /* EF_FPLMN */
+    0x6F7E, /* EF_LOCI */
+    0x6FCA, /* EF_MWIS */
+    0x6FCB, /* EF_CFIS */
+    0x6FE3  /* EF_EPSLOCI */
+};
+
+static
+gboolean
+binder_sim_io_cache_fid_in(
+    guint fid,
+    const guint* list,
+    guint count)
+{
+    guint i;
+
+    for (i = 0; i < count; i++) {
+        if (list[i] == fid) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static
+gboolean
+binder_sim_io_cache_is_volatile(
+    guint fid)
+{
+    return binder_sim_io_cache_fid_in(fid,
+        binder_sim_io_cache_volatile_files,
+        G_N_ELEMENTS(binder_sim_io_cache_volatile_files));
+}
+
+static
+gboolean
+binder_sim_io_cache_is_static(
+    guint fid)
+{
+    return binder_sim_io_cache_fid_in(fid,
+        binder_sim_io_cache_static_files,
+        G_N_ELEMENTS(binder_sim_io_cache_static_files));
+}
+
+static
+BinderSimIoCacheEntry*
+binder_sim_io_cache_entry_new(
+    guint fid,
+    guint sw1,
+    guint sw2,
+    GBytes* data)
+{
+    BinderSimIoCacheEntry* entry = g_slice_new0(BinderSimIoCacheEntry);
+
+    entry->fid = fid;
+    entry->sw1 = sw1;
+    entry->sw2 = sw2;
+    entry->data = data;
+    return entry;
+}
+
+static
+void
+binder_sim_io_cache_entry_free(
+    gpointer data)
+{
+    BinderSimIoCacheEntry* entry = data;
+
+    g_bytes_unref(entry->data);
+    gutil_slice_free(entry);
+}
+
+static
+char*
+binder_sim_io_cache_path(
+    BinderSimIoCache* self)
+{
+    return (self->storage_dir && self->iccid) ?
+        g_build_filename(self->storage_dir, self->iccid, NULL) : NULL;
+}
+
+static
+void
+binder_sim_io_cache_save(
+    BinderSimIoCache* self)
+{
+    char* path = binder_sim_io_cache_path(self);
+
+    self->dirty = FALSE;
+    if (self->save_id) {
+        g_source_remove(self->save_id);
+        self->save_id = 0;
+    }
+
+    if (path) {
+        GKeyFile* k = g_key_file_new();
+        GHashTableIter it;
+        gpointer key, value;
+        guint count = 0;
+
+        g_hash_table_iter_init(&it, self->files);
+        while (g_hash_table_iter_next(&it, &key, &value)) {
+            const BinderSimIoCacheEntry* entry = value;
+
+            if (binder_sim_io_cache_is_static(entry->fid)) {
+                gsize len = 0;
+                const void* data = g_bytes_get_data(entry->data, &len);
+                char* hex = binder_encode_hex(data, len);
+
+                g_key_file_set_integer(k, key, KEY_FID, entry->fid);
+                g_key_file_set_integer(k, key, KEY_SW1, entry->sw1);
+                g_key_file_set_integer(k, key, KEY_SW2, entry->sw2);
+                g_key_file_set_string(k, key, KEY_DATA, hex);
+                g_free(hex);
+                count++;
+            }
+        }
+
+        if (count) {
+            GError* error = NULL;
+            gsize size = 0;
+            char* text = g_key_file_to_data(k, &size, NULL);
+
+            g_mkdir_with_parents(self->storage_dir, 0700);
+            if (g_file_set_contents(path, text, size, &error)) {
+                DBG_(self, "saved %u file(s) to %s", count, path);
+            } else {
+                ofono_warn("Failed to write %s: %s", path, error->message);
+                g_error_free(error);
+            }
+            g_free(text);
+        } else {
+            g_unlink(path);
+        }
+        g_key_file_unref(k);
+        g_free(path);
+    }
+}
+
+static
+gboolean
+binder_sim_io_cache_save_cb(
+    gpointer user_data)
+{
+    BinderSimIoCache* self = user_data;
+
+    self->save_id = 0;
+    binder_sim_io_cache_save(self);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+binder_sim_io_cache_changed(
+    BinderSimIoCache* self)
+{
+    if (self->storage_dir) {
+        self->dirty = TRUE;
+        if (!self->save_id) {
+            self->save_id = g_timeout_add_seconds
+                (BINDER_SIM_IO_CACHE_SAVE_DELAY_SEC,
+                    binder_sim_io_cache_save_cb, self);
+        }
+    }
+}
+
+static
+void
+binder_sim_io_cache_load(
+    BinderSimIoCache* self)
+{
+    char* path = binder_sim_io_cache_path(self);
+    GKeyFile* k = g_key_file_new();
+
+    if (path && g_key_file_load_from_file(k, path, 0, NULL)) {
+        gboolean skipped = FALSE;
+        gsize i, n = 0;
+        char** groups = g_key_file_get_groups(k, &n);
+
+        for (i = 0; i < n; i++) {
+            const char* key = groups[i];
+            const int fid = g_key_file_get_integer(k, key, KEY_FID, NULL);
+            char* hex = g_key_file_get_string(k, key, KEY_DATA, NULL);
+            guint len = 0;
+            void* data = hex ? binder_decode_hex(hex, -1, &len) : NULL;
+
+            if (binder_sim_io_cache_is_static(fid) && (data || !len)) {
+                g_hash_table_replace(self->files, g_strdup(key),
+                    binder_sim_io_cache_entry_new(fid,
+                        g_key_file_get_integer(k, key, KEY_SW1, NULL),
+                        g_key_file_get_integer(k, key, KEY_SW2, NULL),
+                        g_bytes_new_take(data, len)));
+            } else {
+                skipped = TRUE;
+                g_free(data);
+            }
+            g_free(hex);
+        }
+        if (skipped) {
+            /* Rewrite the file without what's no longer persisted */
+            binder_sim_io_cache_changed(self);
+        }
+        DBG_(self, "loaded %u file(s) from %s",
+            g_hash_table_size(self->files), path);
+        g_strfreev(groups);
+    }
+    g_key_file_unref(k);
+    g_free(path);
+}
+
+static
+void
+binder_sim_io_cache_flush(
+    BinderSimIoCache* self)
+{
+    if (self->dirty) {
+        binder_sim_io_cache_save(self);
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderSimIoCache*
+binder_sim_io_cache_new(
+    const char* log_prefix,
+    const char* storage_dir)
+{
+    BinderSimIoCache* self = g_new0(BinderSimIoCache, 1);
+
+    self->log_prefix = binder_dup_prefix(log_prefix);
+    self->storage_dir = g_strdup(storage_dir);
+    self->files = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+        binder_sim_io_cache_entry_free);
+    return self;
+}
+
+void
+binder_sim_io_cache_free(
+    BinderSimIoCache* self)
+{
+    if (self) {
+        binder_sim_io_cache_flush(self);
+        g_hash_table_destroy(self->files);
+        g_free(self->log_prefix);
+        g_free(self->storage_dir);
+        g_free(self->iccid);
+        g_free(self);
+    }
+}
+
+void
+binder_sim_io_cache_set_iccid(
+    BinderSimIoCache* self,
+    const char* iccid)
+{
+    if (self) {
+        if (!iccid) {
+            /*
+             * The card is gone. Whatever is in the storage stays there
+             * and gets reloaded (unverified) if the same card comes back,
+             * since it may be modified elsewhere in the meantime.
+             */
+            binder_sim_io_cache_flush(self);
+            DBG_(self, "dropping %u file(s)", g_hash_table_size(self->files));
+            g_hash_table_remove_all(self->files);
+            self->hits = self->misses = 0;
+            self->active = FALSE;
+            g_free(self->iccid);
+            self->iccid = NULL;
+        } else {
+            if (g_strcmp0(self->iccid, iccid)) {
+                binder_sim_io_cache_flush(self);
+                g_hash_table_remove_all(self->files);
+                self->hits = self->misses = 0;
+                g_free(self->iccid);
+                self->iccid = g_strdup(iccid);
+                binder_sim_io_cache_load(self);
+            }
+            self->active = TRUE;
+        }
+        DBG_(self, "%s %s", self->iccid ? self->iccid : "-",
+            self->active ? "active" : "inactive");
+    }
+}
+
+void
+binder_sim_io_cache_clear(
+    BinderSimIoCache* self)
+{
+    if (self && g_hash_table_size(self->files)) {
+        DBG_(self, "%u file(s), %u hit(s), %u miss(es)",
+            g_hash_table_size(self->files), self->hits, self->misses);
+        g_hash_table_remove_all(self->files);
+        self->hits = self->misses = 0;
+        binder_sim_io_cache_changed(self);
+    }
+}
+
+void
+binder_sim_io_cache_drop_unverified(
+    BinderSimIoCache* self)
+{
+    if (self) {
+        GHashTableIter it;
+        gpointer value;
+
+        g_hash_table_iter_init(&it, self->files);
+        while (g_hash_table_iter_next(&it, NULL, &value)) {
+            const BinderSimIoCacheEntry* entry = value;
+
+            if (!entry->verified) {
+                g_hash_table_iter_remove(&it);
+            }
+        }
+        binder_sim_io_cache_changed(self);
+    }
+}
+
+void
+binder_sim_io_cache_invalidate_file(
+    BinderSimIoCache* self,
+    guint fid)
+{
+    if (self) {
+        GHashTableIter it;
+        gpointer value;
+
+        g_hash_table_iter_init(&it, self->files);
+        while (g_hash_table_iter_next(&it, NULL, &value)) {
+            const BinderSimIoCacheEntry* entry = value;
+
+            if (entry->fid == fid) {
+                g_hash_table_iter_remove(&it);
+                if (binder_sim_io_cache_is_static(fid)) {
+                    binder_sim_io_cache_changed(self);
+                }
+            }
+        }
+    }
+}
+
+char*
+binder_sim_io_cache_key(
+    const char* aid,
+    const guchar* path,
+    guint path_len,
+    guint fid,
+    guint cmd,
+    guint p1,
+    guint p2,
+    guint p3)
+{
+    char* hex = (path && path_len) ? binder_encode_hex(path, path_len) : NULL;
+    char* key = g_strdup_printf("%s:%s:%04X:%02X:%u:%u:%u", aid ? aid : "",
+        hex ? hex : "", fid, cmd, p1, p2, p3);
+
+    g_free(hex);
+    return key;
+}
+
+gboolean
+binder_sim_io_cache_active(
+    BinderSimIoCache* self)
+{
+    return self && self->active;
+}
+
+/* Same as binder_sim_io_cache_get() but without any side effects */
+const BinderSimIoCacheEntry*
+binder_sim_io_cache_peek(
+    BinderSimIoCache* self,
+    const char* key)
+{
+    return (self && self->active && key) ?
+        g_hash_table_lookup(self->files, key) : NULL;
+}
+
+const BinderSimIoCacheEntry*
+binder_sim_io_cache_get(
+    BinderSimIoCache* self,
+    const char* key,
+    gboolean* verify)
+{
+    gboolean need_verify = FALSE;
+    BinderSimIoCacheEntry* entry = NULL;
+
+    if (self && self->active && key) {
+        entry = g_hash_table_lookup(self->files, key);
+        if (entry) {
+            self->hits++;
+            DBG_(self, "%s hit (%u/%u)%s", key, self->hits, self->hits +
+                self->misses, entry->verified ? "" : " unverified");
+            if (!entry->verified && !entry->verifying) {
+                /* Caller is supposed to re-read it in the background */
+                entry->verifying = need_verify = TRUE;
+            }
+        } else {
+            self->misses++;
+        }
+    }
+    if (verify) {
+        *verify = need_verify;
+    }
+    return entry;
+}
+
+void
+binder_sim_io_cache_verify_failed(
+    BinderSimIoCache* self,
+    const char* key)
+{
+    BinderSimIoCacheEntry* entry = (self && key) ?
+        g_hash_table_lookup(self->files, key) : NULL;
+
+    if (entry && !entry->verified) {
+        DBG_(self, "%s verification failed", key);
+        entry->verifying = FALSE;
+    }
+}
+
+gboolean
+binder_sim_io_cache_put(
+    BinderSimIoCache* self,
+    const char* key,
+    guint fid,
+    guint sw1,
+    guint sw2,
+    const void* data,
+    gsize len)
+{
+    gboolean changed = FALSE;
+
+    if (self && self->active && key && binder_sim_io_cache_is_volatile(fid)) {
+        /* Don't keep it, and don't serve anything stale either */
+        g_hash_table_remove(self->files, key);
+    } else if (self && self->active && key) {
+        GBytes* bytes = g_bytes_new(data, len);
+        BinderSimIoCacheEntry* entry = g_hash_table_lookup(self->files, key);
+
+        if (entry && entry->fid == fid && entry->sw1 == sw1 &&
+            entry->sw2 == sw2 && g_bytes_equal(entry->data, bytes)) {
+            /* The card agrees with what we had */
+            g_bytes_unref(bytes);
+        } else {
+            changed = (entry != NULL);
+            entry = binder_sim_io_cache_entry_new(fid, sw1, sw2, bytes);
+            g_hash_table_replace(self->files, g_strdup(key), entry);
+            if (binder_sim_io_cache_is_static(fid)) {
+                binder_sim_io_cache_changed(self);
+            }
+        }
+        entry->verified = TRUE;
+        entry->verifying = FALSE;
+    }
+    return changed;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
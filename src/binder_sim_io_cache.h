@@ -0,0 +1,136 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_SIM_IO_CACHE_H
+#define BINDER_SIM_IO_CACHE_H
+
+#include "binder_types.h"
+
+/*
+ * Cache of successful iccIOForApp read responses, owned by the slot
+ * and therefore surviving re-creation of the modem and its atoms.
+ * The contents belong to a particular ICCID. The cache is inactive
+ * (neither lookups nor updates are performed) until the ICCID of the
+ * current card is known, which also means that EF_ICCID itself is
+ * never cached. Removing the card drops everything held in memory.
+ * Files updated by the baseband on its own (EF_LOCI, EF_FPLMN, EF_MWIS,
+ * EF_CFIS and such) are never cached either.
+ *
+ * If the storage directory is given, responses for the files which
+ * are not expected to change behind our back are also stored there,
+ * one file per ICCID. Entries loaded from the storage are served
+ * immediately but remain unverified until the same request has been
+ * completed by the card. binder_sim_io_cache_get() tells the caller
+ * when it's the time to do that.
+ */
+
+typedef struct binder_sim_io_cache_entry {
+    guint fid;
+    guint sw1, sw2;
+    GBytes* data;
+    gboolean verified;  /* Confirmed by the card since it got inserted */
+    gboolean verifying; /* Verification has been requested */
+} BinderSimIoCacheEntry;
+
+BinderSimIoCache*
+binder_sim_io_cache_new(
+    const char* log_prefix,
+    const char* storage_dir)
+    BINDER_INTERNAL;
+
+void
+binder_sim_io_cache_free(
+    BinderSimIoCache* cache)
+    BINDER_INTERNAL;
+
+void
+binder_sim_io_cache_set_iccid(
+    BinderSimIoCache* cache,
+    const char* iccid)
+    BINDER_INTERNAL;
+
+void
+binder_sim_io_cache_clear(
+    BinderSimIoCache* cache)
+    BINDER_INTERNAL;
+
+void
+binder_sim_io_cache_drop_unverified(
+    BinderSimIoCache* cache)
+    BINDER_INTERNAL;
+
+void
+binder_sim_io_cache_invalidate_file(
+    BinderSimIoCache* cache,
+    guint fid)
+    BINDER_INTERNAL;
+
+char*
+binder_sim_io_cache_key(
+    const char* aid,
+    const guchar* path,
+    guint path_len,
+    guint fid,
+    guint cmd,
+    guint p1,
+    guint p2,
+    guint p3)
+    BINDER_INTERNAL;
+
+gboolean
+binder_sim_io_cache_active(
+    BinderSimIoCache* cache)
+    BINDER_INTERNAL;
+
+const BinderSimIoCacheEntry*
+binder_sim_io_cache_peek(
+    BinderSimIoCache* cache,
+    const char* key)
+    BINDER_INTERNAL;
+
+const BinderSimIoCacheEntry*
+binder_sim_io_cache_get(
+    BinderSimIoCache* cache,
+    const char* key,
+    gboolean* verify)
+    BINDER_INTERNAL;
+
+/* Clears the verifying flag so that the next hit asks for a re-read */
+void
+binder_sim_io_cache_verify_failed(
+    BinderSimIoCache* cache,
+    const char* key)
+    BINDER_INTERNAL;
+
+gboolean
+binder_sim_io_cache_put(
+    BinderSimIoCache* cache,
+    const char* key,
+    guint fid,
+    guint sw1,
+    guint sw2,
+    const void* data,
+    gsize len)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_SIM_IO_CACHE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -40,6 +40,14 @@
 
 #define BINDER_SMS_ACK_RETRY_MS    1000
 #define BINDER_SMS_ACK_RETRY_COUNT 10
+#define BINDER_SMS_ACK_SLOW_MS     2000
+
+/* Adaptive routing (smsAdaptiveRouting) */
+#define BINDER_SMS_PATH_MAX_FAILURES 2
+#define BINDER_SMS_PATH_COOLDOWN_MS  60000
+
+/* TP-Status-Report-Request bit of the SMS-SUBMIT first octet */
+#define SMS_SUBMIT_SRR          0x20
 
 #define SIM_EFSMS_FILEID        0x6F3C
 #define EFSMS_LENGTH            176
@@ -59,6 +67,13 @@ enum binder_sms_ext_events {
     SMS_EXT_EVENT_COUNT
 };
 
+typedef enum binder_sms_path {
+    SMS_PATH_EXT,
+    SMS_PATH_IMS,
+    SMS_PATH_GSM,
+    SMS_PATH_COUNT
+} SMS_PATH;
+
 /*
  * Note: use_standard_ims_sms_api is initialized to zero (FALSE) and stays
  * that way. It's a leftover from the experiments with IRadio.sendImsSms
@@ -71,6 +86,40 @@ enum binder_sms_ext_events {
  * In other words, the IRadio.sendImsSms stuff is likely to be deleted
  * at some point, don't pay too much attention to it.
  */
+typedef struct binder_sms_send_wait {
+    ofono_sms_submit_cb_t cb;
+    void* data;
+    struct ofono_error err;
+    int msg_ref;
+    gboolean last;
+} BinderSmsSendWait;
+
+/* Throughput accounting, only reported in the log */
+typedef struct binder_sms_counters {
+    gint64 start;
+    guint tx_radio;
+    guint tx_ext;
+    guint tx_failed;
+    guint rx_radio;
+    guint rx_ext;
+    guint64 tx_total_us;
+    guint64 tx_max_us;
+} BinderSmsCounters;
+
+/*
+ * Per-path health, used by adaptive routing. A path is skipped for
+ * BINDER_SMS_PATH_COOLDOWN_MS after BINDER_SMS_PATH_MAX_FAILURES
+ * failures in a row, or while its recent latency is more than twice
+ * that of GSM. Stale latency doesn't count, so that the preferred
+ * path gets another chance once in a while.
+ */
+typedef struct binder_sms_path_stats {
+    guint64 avg_us;
+    gint64 updated_at;
+    gint64 failed_at;
+    guint failures;
+} BinderSmsPathStats;
+
 typedef struct binder_sms {
     struct ofono_sms* sms;
     struct ofono_watch* watch;
@@ -78,12 +127,28 @@ typedef struct binder_sms {
     char* log_prefix;
     gboolean use_standard_ims_sms_api;
     guint ext_send_id;
+    guint ext_timeout_id;
+    struct binder_sms_submit_cbd* ext_cbd;
+    guint fallback_timeout_ms;
+    gboolean adaptive_routing;
+    BinderSmsPathStats path[SMS_PATH_COUNT];
     BinderExtSms* sms_ext;
     BinderImsReg* ims_reg;
     RadioRequestGroup* g;
     gulong ext_event[SMS_EXT_EVENT_COUNT];
     gulong radio_event[SMS_RADIO_EVENT_COUNT];
     guint register_id;
+    guint ack_pending;
+    guint ack_count;
+    gint64 ack_max_us;
+    guint send_window;
+    guint send_pending;
+    gboolean send_strict;
+    gboolean send_failed;
+    guint send_done_id;
+    BinderSmsSendWait send_done;
+    BinderSmsSendWait send_wait;
+    BinderSmsCounters counters;
 } BinderSms;
 
 typedef struct binder_sms_cbd {
@@ -103,8 +168,19 @@ typedef struct binder_sms_submit_cbd {
     int tpdu_len;
     ofono_sms_submit_cb_t cb;
     gpointer data;
+    gint64 start;
+    int flags;
+    SMS_PATH path;
+    gboolean early;
+    gboolean resent;
+    gboolean abandoned;
 } BinderSmsSubmitCbData;
 
+typedef struct binder_sms_ack_data {
+    BinderSms* self;
+    gint64 start;
+} BinderSmsAckData;
+
 typedef struct binder_sms_sim_read_data {
     BinderSms* self;
     int record;
@@ -127,6 +203,27 @@ binder_sms_send(
     ofono_sms_submit_cb_t cb,
     void* data);
 
+static
+void
+binder_sms_submit_cb(
+    RadioRequest* req,
+    RADIO_TX_STATUS status,
+    RADIO_RESP resp,
+    RADIO_ERROR error,
+    const GBinderReader* args,
+    gpointer user_data);
+
+static
+void
+binder_sms_gsm_message(
+    BinderSms* self,
+    GBinderWriter* writer,
+    RadioGsmSmsMessage* msg,
+    const unsigned char* pdu,
+    int pdu_len,
+    int tpdu_len,
+    const GBinderParent* parent);
+
 #define DBG_(self,fmt,args...) DBG("%s" fmt, (self)->log_prefix, ##args)
 #define SMS_TYPE_STR(ext) \
     ((binder_ext_sms_get_interface_flags(ext) & \
@@ -135,6 +232,127 @@ binder_sms_send(
 static inline BinderSms* binder_sms_get_data(struct ofono_sms *sms)
     { return ofono_sms_get_data(sms); }
 
+static
+void
+binder_sms_path_update(
+    BinderSms* self,
+    SMS_PATH path,
+    gboolean ok,
+    guint64 us,
+    gint64 now)
+{
+    BinderSmsPathStats* stats = self->path + path;
+
+    if (ok) {
+        /* Exponentially weighted, 1/4 of the new sample */
+        stats->avg_us = stats->avg_us ? (3 * stats->avg_us + us) / 4 : us;
+        stats->updated_at = now;
+        stats->failures = 0;
+    } else {
+        stats->failed_at = now;
+        stats->failures++;
+    }
+}
+
+static
+gboolean
+binder_sms_path_preferred(
+    BinderSms* self,
+    SMS_PATH path)
+{
+    if (self->adaptive_routing) {
+        const gint64 now = g_get_monotonic_time();
+        const gint64 cooldown = BINDER_SMS_PATH_COOLDOWN_MS * 1000;
+        const BinderSmsPathStats* stats = self->path + path;
+        const BinderSmsPathStats* gsm = self->path + SMS_PATH_GSM;
+
+        if (stats->failures >= BINDER_SMS_PATH_MAX_FAILURES &&
+            (now - stats->failed_at) < cooldown) {
+            DBG_(self, "path %d is failing", path);
+            return FALSE;
+        }
+        if (stats->avg_us && gsm->avg_us && !gsm->failures &&
+            (now - stats->updated_at) < cooldown &&
+            (now - gsm->updated_at) < cooldown &&
+            stats->avg_us > 2 * gsm->avg_us) {
+            DBG_(self, "path %d is slow (%u us vs %u us)", path,
+                (guint) stats->avg_us, (guint) gsm->avg_us);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+static
+void
+binder_sms_count_tx(
+    BinderSms* self,
+    const BinderSmsSubmitCbData* cbd,
+    gboolean ext,
+    gboolean ok)
+{
+    BinderSmsCounters* c = &self->counters;
+    const gint64 now = g_get_monotonic_time();
+    const guint64 us = MAX(now - cbd->start, 0);
+
+    if (!c->start) {
+        c->start = cbd->start;
+    }
+    if (!ok) {
+        c->tx_failed++;
+    } else if (ext) {
+        c->tx_ext++;
+    } else {
+        c->tx_radio++;
+    }
+    c->tx_total_us += us;
+    if (c->tx_max_us < us) {
+        c->tx_max_us = us;
+    }
+    binder_sms_path_update(self, cbd->path, ok, us, now);
+    DBG_(self, "%ssegment %s in %u us", ext ? "ext " : "", ok ? "sent" :
+        "failed", (guint) us);
+}
+
+static
+void
+binder_sms_count_rx(
+    BinderSms* self,
+    gboolean ext)
+{
+    BinderSmsCounters* c = &self->counters;
+
+    if (!c->start) {
+        c->start = g_get_monotonic_time();
+    }
+    if (ext) {
+        c->rx_ext++;
+    } else {
+        c->rx_radio++;
+    }
+}
+
+static
+void
+binder_sms_counters_report(
+    BinderSms* self)
+{
+    const BinderSmsCounters* c = &self->counters;
+
+    if (c->start) {
+        const guint tx = c->tx_radio + c->tx_ext + c->tx_failed;
+        const guint rx = c->rx_radio + c->rx_ext;
+        const gint64 secs = MAX((g_get_monotonic_time() - c->start) /
+            G_USEC_PER_SEC, 1);
+
+        ofono_info("%ssms: sent %u+%u (%u failed), received %u+%u, "
+            "%.2f/%.2f per sec, segment avg %u us max %u us",
+            self->log_prefix, c->tx_radio, c->tx_ext, c->tx_failed,
+            c->rx_radio, c->rx_ext, (double) tx / secs, (double) rx / secs,
+            tx ? (guint) (c->tx_total_us / tx) : 0, (guint) c->tx_max_us);
+    }
+}
+
 static
 BinderSmsCbData*
 binder_sms_cbd_new(
@@ -176,6 +394,7 @@ binder_sms_submit_cbd_new(
     cbd->tpdu_len = tpdu_len;
     cbd->cb = cb;
     cbd->data = data;
+    cbd->start = g_get_monotonic_time();
     return cbd;
 }
 
@@ -362,6 +581,158 @@ binder_sms_can_send_ext_message(
         binder_sms_can_send_ims_message(self));
 }
 
+static
+void
+binder_sms_send_complete(
+    BinderSms* self,
+    const struct ofono_error* error,
+    int msg_ref,
+    gboolean last,
+    ofono_sms_submit_cb_t cb,
+    void* data)
+{
+    if (self->send_pending) {
+        BinderSmsSendWait* wait = &self->send_wait;
+
+        /* Wait for the early completed segments to get confirmed */
+        DBG_(self, "waiting for %u segment(s)", self->send_pending);
+        GASSERT(!wait->cb);
+        wait->cb = cb;
+        wait->data = data;
+        wait->err = *error;
+        wait->msg_ref = msg_ref;
+        wait->last = last;
+    } else {
+        struct ofono_error err = *error;
+
+        if (self->send_failed) {
+            /* One of the early completed segments didn't make it */
+            self->send_failed = FALSE;
+            if (err.type == OFONO_ERROR_TYPE_NO_ERROR) {
+                binder_error_init_failure(&err);
+            }
+        }
+        if (last) {
+            /* End of message */
+            self->send_strict = FALSE;
+        }
+        cb(&err, msg_ref, data);
+    }
+}
+
+static
+void
+binder_sms_send_pending_done(
+    BinderSms* self)
+{
+    GASSERT(self->send_pending);
+    self->send_pending--;
+    if (!self->send_pending && self->send_wait.cb) {
+        const BinderSmsSendWait wait = self->send_wait;
+
+        memset(&self->send_wait, 0, sizeof(self->send_wait));
+        binder_sms_send_complete(self, &wait.err, wait.msg_ref, wait.last,
+            wait.cb, wait.data);
+    }
+}
+
+static
+gboolean
+binder_sms_send_done_cb(
+    gpointer user_data)
+{
+    BinderSms* self = user_data;
+    const BinderSmsSendWait done = self->send_done;
+    struct ofono_error err;
+
+    self->send_done_id = 0;
+    memset(&self->send_done, 0, sizeof(self->send_done));
+    done.cb(binder_error_ok(&err), 0, done.data);
+    return G_SOURCE_REMOVE;
+}
+
+static
+gboolean
+binder_sms_send_early(
+    BinderSms* self,
+    const unsigned char* pdu,
+    int pdu_len,
+    int tpdu_len,
+    BINDER_SMS_SEND_FLAGS flags)
+{
+    /*
+     * Segments of a concatenated SMS (all but the last one) may be
+     * reported as sent before the modem has confirmed them, as long
+     * as the window isn't full. Not if a status report is requested
+     * though, because then ofono needs the message reference.
+     */
+    return (flags & BINDER_SMS_SEND_FLAG_EXPECT_MORE) &&
+        !self->send_strict && !self->send_done_id &&
+        (self->send_pending + 1) < self->send_window &&
+        tpdu_len > 0 && !(pdu[pdu_len - tpdu_len] & SMS_SUBMIT_SRR);
+}
+
+static
+gboolean
+binder_sms_send_gsm(
+    BinderSms* self,
+    BinderSmsSubmitCbData* cbd,
+    const unsigned char* pdu,
+    int pdu_len,
+    int tpdu_len,
+    BINDER_SMS_SEND_FLAGS flags)
+{
+    /*
+     * sendSms(serial, GsmSmsMessage message);
+     * sendSMSExpectMore(serial, GsmSmsMessage message);
+     */
+    GBinderWriter writer;
+    RadioRequest* req = radio_request_new2(self->g,
+        (flags & BINDER_SMS_SEND_FLAG_EXPECT_MORE) ?
+        RADIO_REQ_SEND_SMS_EXPECT_MORE : RADIO_REQ_SEND_SMS, &writer,
+        binder_sms_submit_cb, binder_sms_submit_cbd_free, cbd);
+    gboolean ok;
+
+    cbd->flags = flags;
+    cbd->path = SMS_PATH_GSM;
+    binder_sms_gsm_message(self, &writer,
+        gbinder_writer_new0(&writer, RadioGsmSmsMessage),
+        pdu, pdu_len, tpdu_len, NULL);
+    ok = radio_request_submit(req);
+    radio_request_unref(req);
+    return ok;
+}
+
+static
+void
+binder_sms_send_early_cb(
+    BinderSmsSubmitCbData* cbd,
+    gboolean ok)
+{
+    BinderSms* self = cbd->self;
+
+    if (!ok) {
+        /* Stop pipelining for the rest of this message */
+        self->send_strict = TRUE;
+        if (!cbd->resent && cbd->pdu) {
+            BinderSmsSubmitCbData* resend = binder_sms_submit_cbd_new(self,
+                cbd->pdu, cbd->pdu_len, cbd->tpdu_len, NULL, NULL);
+
+            DBG_(self, "resending the segment");
+            resend->early = TRUE;
+            resend->resent = TRUE;
+            if (binder_sms_send_gsm(self, resend, cbd->pdu, cbd->pdu_len,
+                cbd->tpdu_len, cbd->flags)) {
+                /* The resent segment takes the place of this one */
+                return;
+            }
+        }
+        ofono_error("Failed to send SMS segment");
+        self->send_failed = TRUE;
+    }
+    binder_sms_send_pending_done(self);
+}
+
 static
 void
 binder_sms_submit_cb(
@@ -373,9 +744,19 @@ binder_sms_submit_cb(
     gpointer user_data)
 {
     BinderSmsSubmitCbData* cbd = user_data;
-    ofono_sms_submit_cb_t cb = cbd->cb;
+    BinderSms* self = cbd->self;
+    const gboolean last = !(cbd->flags & BINDER_SMS_SEND_FLAG_EXPECT_MORE);
     struct ofono_error err;
 
+    binder_sms_count_tx(self, cbd, FALSE, status == RADIO_TX_STATUS_OK &&
+        error == RADIO_ERROR_NONE);
+    if (cbd->early) {
+        /* This one has already been reported to ofono as sent */
+        binder_sms_send_early_cb(cbd, status == RADIO_TX_STATUS_OK &&
+            error == RADIO_ERROR_NONE);
+        return;
+    }
+
     binder_error_init_failure(&err);
     if (status == RADIO_TX_STATUS_OK) {
         const gboolean ims = (resp == RADIO_RESP_SEND_IMS_SMS);
@@ -412,7 +793,8 @@ binder_sms_submit_cb(
                         err.error = res->errorCode;
                     } else {
                         /* Success */
-                        cb(binder_error_ok(&err), res->messageRef, cbd->data);
+                        binder_sms_send_complete(self, binder_error_ok(&err),
+                            res->messageRef, last, cbd->cb, cbd->data);
                         return;
                     }
                 }
@@ -430,9 +812,61 @@ binder_sms_submit_cb(
         } else {
             ofono_error("Unexpected send sms response %d", resp);
         }
+    } else if (status == RADIO_TX_STATUS_TIMEOUT &&
+        cbd->path == SMS_PATH_IMS && cbd->pdu) {
+        /* IMS SMS is taking too long (smsFallbackTimeout), try GSM */
+        ofono_warn("%sims sms timed out", self->log_prefix);
+        binder_sms_send(cbd->self, cbd->pdu, cbd->pdu_len,
+            cbd->tpdu_len, BINDER_SMS_SEND_FLAG_FORCE_GSM,
+            cbd->cb, cbd->data);
+        return;
     }
     /* Error path */
-    cb(&err, 0, cbd->data);
+    binder_sms_send_complete(self, &err, 0, last, cbd->cb, cbd->data);
+}
+
+static
+void
+binder_sms_ext_send_done(
+    BinderSms* self)
+{
+    self->ext_send_id = 0;
+    self->ext_cbd = NULL;
+    if (self->ext_timeout_id) {
+        g_source_remove(self->ext_timeout_id);
+        self->ext_timeout_id = 0;
+    }
+}
+
+static
+gboolean
+binder_sms_ext_timeout_cb(
+    gpointer user_data)
+{
+    BinderSms* self = user_data;
+    BinderSmsSubmitCbData* cbd = self->ext_cbd;
+    const guint id = self->ext_send_id;
+    void* pdu = gutil_memdup(cbd->pdu, cbd->pdu_len);
+    const int pdu_len = cbd->pdu_len;
+    const int tpdu_len = cbd->tpdu_len;
+    ofono_sms_submit_cb_t cb = cbd->cb;
+    void* data = cbd->data;
+
+    /*
+     * The extension is taking too long (smsFallbackTimeout). Its
+     * result will be ignored if it arrives after all, and cbd may
+     * be gone after the cancel call.
+     */
+    ofono_warn("%sext sms timed out", self->log_prefix);
+    self->ext_timeout_id = 0;
+    binder_sms_count_tx(self, cbd, TRUE, FALSE);
+    cbd->abandoned = TRUE;
+    binder_sms_ext_send_done(self);
+    binder_ext_sms_cancel(self->sms_ext, id);
+    binder_sms_send(self, pdu, pdu_len, tpdu_len,
+        BINDER_SMS_SEND_FLAG_FORCE_GSM, cb, data);
+    g_free(pdu);
+    return G_SOURCE_REMOVE;
 }
 
 static
@@ -447,7 +881,15 @@ binder_sms_submit_ext_cb(
     BinderSms* self = cbd->self;
     struct ofono_error err;
 
-    self->ext_send_id = 0;
+    if (cbd->abandoned) {
+        /* Has already been resent over GSM */
+        DBG_(self, "late ext sms result %d", result);
+        return;
+    }
+
+    binder_sms_ext_send_done(self);
+    binder_sms_count_tx(self, cbd, TRUE,
+        result == BINDER_EXT_SMS_SEND_RESULT_OK);
     switch (result) {
     case BINDER_EXT_SMS_SEND_RESULT_OK:
         /* SMS has been sent */
@@ -563,15 +1005,20 @@ binder_sms_send(
 
     DBG("pdu_len: %d, tpdu_len: %d flags: 0x%02x", pdu_len, tpdu_len, flags);
     if (!(flags & BINDER_SMS_SEND_FLAG_FORCE_GSM) &&
-        binder_sms_can_send_ext_message(self)) {
+        binder_sms_can_send_ext_message(self) &&
+        binder_sms_path_preferred(self, SMS_PATH_EXT)) {
         const int smsc_len = pdu_len - tpdu_len;
         const void* tpdu = pdu + smsc_len;
         char* smsc = (smsc_len > 1) ? g_strndup((char*)pdu, smsc_len) : NULL;
 
         /* Vendor specific mechanism */
-        binder_ext_sms_cancel(self->sms_ext, self->ext_send_id);
+        const guint prev_id = self->ext_send_id;
+
+        binder_sms_ext_send_done(self);
+        binder_ext_sms_cancel(self->sms_ext, prev_id);
         /* Copy the PDU for GSM SMS fallback */
         cbd = binder_sms_submit_cbd_new(self, pdu,pdu_len,tpdu_len, cb, data);
+        cbd->path = SMS_PATH_EXT;
         self->ext_send_id = binder_ext_sms_send(self->sms_ext, smsc,
             tpdu, tpdu_len, 0, (flags & BINDER_SMS_SEND_FLAG_EXPECT_MORE) ?
             BINDER_EXT_SMS_SEND_EXPECT_MORE : BINDER_EXT_SMS_SEND_NO_FLAGS,
@@ -579,43 +1026,62 @@ binder_sms_send(
         g_free(smsc);
         if (self->ext_send_id) {
             /* Request submitted */
+            self->ext_cbd = cbd;
+            if (self->fallback_timeout_ms) {
+                self->ext_timeout_id = g_timeout_add(self->fallback_timeout_ms,
+                    binder_sms_ext_timeout_cb, self);
+            }
             return;
         }
         /* cbd will be reused */
     }
 
     if ((flags & BINDER_SMS_SEND_FLAG_FORCE_GSM) ||
-        !binder_sms_can_send_ims_message(self)) {
-        /*
-         * sendSms(serial, GsmSmsMessage message);
-         * sendSMSExpectMore(serial, GsmSmsMessage message);
-         */
-        GBinderWriter writer;
-        RadioRequest* req = radio_request_new2(self->g,
-            (flags & BINDER_SMS_SEND_FLAG_EXPECT_MORE) ?
-            RADIO_REQ_SEND_SMS_EXPECT_MORE : RADIO_REQ_SEND_SMS, &writer,
-            binder_sms_submit_cb, binder_sms_submit_cbd_free,
-            cbd ? cbd : /* No need to copy the PDU */
-            binder_sms_submit_cbd_new(self, NULL, 0, 0, cb, data));
-
-        binder_sms_gsm_message(self, &writer,
-            gbinder_writer_new0(&writer, RadioGsmSmsMessage),
-            pdu, pdu_len, tpdu_len, NULL);
-        if (radio_request_submit(req)) {
-            radio_request_unref(req);
+        !binder_sms_can_send_ims_message(self) ||
+        !binder_sms_path_preferred(self, SMS_PATH_IMS)) {
+        const gboolean early = binder_sms_send_early(self, pdu, pdu_len,
+            tpdu_len, flags);
+
+        if (!cbd) {
+            /* The PDU is only needed if the segment may have to be resent */
+            cbd = early ?
+                binder_sms_submit_cbd_new(self, pdu, pdu_len, tpdu_len,
+                    cb, data) :
+                binder_sms_submit_cbd_new(self, NULL, 0, 0, cb, data);
+        }
+        cbd->early = early;
+        if (binder_sms_send_gsm(self, cbd, pdu, pdu_len, tpdu_len, flags)) {
             /* Request submitted */
+            if (early) {
+                /* Let ofono submit the next segment */
+                self->send_pending++;
+                DBG_(self, "%u segment(s) in flight", self->send_pending);
+                self->send_done.cb = cb;
+                self->send_done.data = data;
+                self->send_done_id = g_idle_add(binder_sms_send_done_cb,
+                    self);
+            }
             return;
         }
+        /* cbd has been freed by binder_sms_send_gsm() */
     } else if (self->use_standard_ims_sms_api) {
         /* sendImsSms(serial, ImsSmsMessage message); */
         GBinderWriter writer;
-        RadioRequest* req = radio_request_new2(self->g,
-            RADIO_REQ_SEND_IMS_SMS, &writer,
-            binder_sms_submit_cb, binder_sms_submit_cbd_free,
-            cbd ? cbd :  /* Copy the PDU for GSM SMS fallback */
-            binder_sms_submit_cbd_new(self, pdu, pdu_len, tpdu_len, cb, data));
+        RadioRequest* req;
+
+        if (!cbd) {
+            /* Copy the PDU for GSM SMS fallback */
+            cbd = binder_sms_submit_cbd_new(self, pdu, pdu_len, tpdu_len,
+                cb, data);
+        }
+        cbd->path = SMS_PATH_IMS;
+        req = radio_request_new2(self->g, RADIO_REQ_SEND_IMS_SMS, &writer,
+            binder_sms_submit_cb, binder_sms_submit_cbd_free, cbd);
 
         DBG("sending ims message");
+        if (self->fallback_timeout_ms) {
+            radio_request_set_timeout(req, self->fallback_timeout_ms);
+        }
         binder_sms_ims_message(self, &writer, pdu, pdu_len, tpdu_len);
         if (radio_request_submit(req)) {
             radio_request_unref(req);
@@ -647,6 +1113,17 @@ binder_sms_submit(
         BINDER_SMS_SEND_FLAGS_NONE, cb, data);
 }
 
+static
+void
+binder_sms_ack_data_free(
+    gpointer user_data)
+{
+    BinderSmsAckData* ack = user_data;
+
+    ack->self->ack_pending--;
+    gutil_slice_free(ack);
+}
+
 static
 void
 binder_sms_ack_cb(
@@ -657,6 +1134,26 @@ binder_sms_ack_cb(
     const GBinderReader* args,
     gpointer user_data)
 {
+    BinderSmsAckData* ack = user_data;
+    BinderSms* self = ack->self;
+    const gint64 latency = g_get_monotonic_time() - ack->start;
+
+    /*
+     * The network won't deliver the next message until this one has
+     * been acknowledged, and it retransmits the message if the ack
+     * takes too long. Keep an eye on that.
+     */
+    self->ack_count++;
+    if (self->ack_max_us < latency) {
+        self->ack_max_us = latency;
+    }
+    if (latency >= BINDER_SMS_ACK_SLOW_MS * 1000) {
+        ofono_warn("SMS acknowledgement took %d ms",
+            (int)(latency / 1000));
+    }
+    DBG_(self, "ack #%u, %d ms (max %d ms)", self->ack_count,
+        (int)(latency / 1000), (int)(self->ack_max_us / 1000));
+
     if (status == RADIO_TX_STATUS_OK) {
         if (resp == RADIO_RESP_ACKNOWLEDGE_LAST_INCOMING_GSM_SMS) {
             if (error != RADIO_ERROR_NONE) {
@@ -684,11 +1181,21 @@ binder_sms_ack(
      * acknowledgeLastIncomingGsmSms(int32 serial, bool success,
      *     SmsAcknowledgeFailCause cause);
      */
+    BinderSmsAckData* ack = g_slice_new(BinderSmsAckData);
     RadioRequest* req = radio_request_new2(self->g,
         RADIO_REQ_ACKNOWLEDGE_LAST_INCOMING_GSM_SMS, &writer,
-        binder_sms_ack_cb, NULL, NULL);
-
-    DBG_(self, "%s", ok ? "ok" : "fail");
+        binder_sms_ack_cb, binder_sms_ack_data_free, ack);
+
+    ack->self = self;
+    ack->start = g_get_monotonic_time();
+    self->ack_pending++;
+    if (self->ack_pending > 1) {
+        /* Shouldn't happen, the network waits for the previous ack */
+        DBG_(self, "%s, %u acks pending", ok ? "ok" : "fail",
+            self->ack_pending);
+    } else {
+        DBG_(self, "%s", ok ? "ok" : "fail");
+    }
     gbinder_writer_append_bool(&writer, ok);
     gbinder_writer_append_int32(&writer, ok ? RADIO_SMS_ACK_FAIL_NONE :
         RADIO_SMS_ACK_FAIL_UNSPECIFIED_ERROR);
@@ -731,14 +1238,21 @@ binder_sms_incoming(
             DBG_(self, "smsc: %s", binder_print_hex(pdu, smsc_len));
             DBG_(self, "tpdu: %s", binder_print_hex(pdu + smsc_len, tpdu_len));
 
+            /*
+             * The PDU is received, what ofono does with it doesn't
+             * affect the ack. Send the ack first, so that its round
+             * trip overlaps with the processing and the network can
+             * deliver the next message (if there is one) sooner.
+             */
             switch (code) {
             case RADIO_IND_NEW_SMS:
-                ofono_sms_deliver_notify(self->sms, pdu, pdu_len, tpdu_len);
                 binder_sms_ack(self, TRUE);
+                binder_sms_count_rx(self, FALSE);
+                ofono_sms_deliver_notify(self->sms, pdu, pdu_len, tpdu_len);
                 break;
             case RADIO_IND_NEW_SMS_STATUS_REPORT:
-                ofono_sms_status_notify(self->sms, pdu, pdu_len, tpdu_len);
                 binder_sms_ack(self, TRUE);
+                ofono_sms_status_notify(self->sms, pdu, pdu_len, tpdu_len);
                 break;
             default:
                 binder_sms_ack(self, FALSE);
@@ -786,9 +1300,11 @@ binder_sms_ext_incoming(
     guint pdu_len,
     void* user_data)
 {
+    BinderSms* self = user_data;
+
     ofono_info("incoming %ssms, %u bytes", SMS_TYPE_STR(ext), pdu_len);
-    if (binder_sms_notify((BinderSms*) user_data, pdu, pdu_len,
-        ofono_sms_deliver_notify)) {
+    binder_sms_count_rx(self, TRUE);
+    if (binder_sms_notify(self, pdu, pdu_len, ofono_sms_deliver_notify)) {
         binder_ext_sms_ack_incoming(ext, TRUE);
     } else {
         ofono_error("Unable to parse %sSMS notification", SMS_TYPE_STR(ext));
@@ -977,6 +1493,9 @@ binder_sms_probe(
     DBG_(self, "");
 
     self->sms = sms;
+    self->send_window = modem->config.sms_send_window;
+    self->adaptive_routing = modem->config.sms_adaptive_routing;
+    self->fallback_timeout_ms = modem->config.sms_fallback_timeout_ms;
     self->watch = ofono_watch_new(binder_modem_get_path(modem));
     self->sim_context = ofono_sim_context_create(self->watch->sim);
     self->ims_reg = binder_ims_reg_ref(modem->ims);
@@ -1002,6 +1521,7 @@ binder_sms_remove(
     BinderSms* self = binder_sms_get_data(sms);
 
     DBG_(self, "");
+    binder_sms_counters_report(self);
 
     if (self->sim_context) {
         ofono_sim_context_free(self->sim_context);
@@ -1011,9 +1531,16 @@ binder_sms_remove(
         g_source_remove(self->register_id);
     }
 
+    if (self->send_done_id) {
+        g_source_remove(self->send_done_id);
+    }
+
     if (self->sms_ext) {
+        const guint id = self->ext_send_id;
+
         binder_ext_sms_remove_all_handlers(self->sms_ext, self->ext_event);
-        binder_ext_sms_cancel(self->sms_ext, self->ext_send_id);
+        binder_sms_ext_send_done(self);
+        binder_ext_sms_cancel(self->sms_ext, id);
         binder_ext_sms_unref(self->sms_ext);
     }
 
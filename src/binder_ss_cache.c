@@ -0,0 +1,236 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_ss_cache.h"
+#include "binder_log.h"
+#include "binder_util.h"
+
+#include <gutil_macros.h>
+
+typedef struct binder_ss_cache_entry {
+    GBytes* data;
+    gint64 time; /* Monotonic, microseconds */
+} BinderSsCacheEntry;
+
+struct binder_ss_cache {
+    char* log_prefix;
+    char* imsi;         /* Owner of the cached data */
+    gint64 max_age_us;
+    GHashTable* groups[BINDER_SS_CACHE_GROUP_COUNT];
+    guint generation[BINDER_SS_CACHE_GROUP_COUNT];
+    guint hits;
+    guint refreshes;
+    guint misses;
+};
+
+#define DBG_(self,fmt,args...) DBG("%s" fmt, (self)->log_prefix, ##args)
+
+static
+void
+binder_ss_cache_entry_free(
+    gpointer data)
+{
+    BinderSsCacheEntry* entry = data;
+
+    g_bytes_unref(entry->data);
+    g_slice_free(BinderSsCacheEntry, entry);
+}
+
+static
+void
+binder_ss_cache_clear(
+    BinderSsCache* self)
+{
+    int i;
+
+    for (i = 0; i < BINDER_SS_CACHE_GROUP_COUNT; i++) {
+        self->generation[i]++;
+        g_hash_table_remove_all(self->groups[i]);
+    }
+}
+
+static
+gboolean
+binder_ss_cache_check_imsi(
+    BinderSsCache* self,
+    const char* imsi)
+{
+    if (g_strcmp0(self->imsi, imsi)) {
+        if (self->imsi) {
+            DBG_(self, "dropping entries for the old IMSI");
+            binder_ss_cache_clear(self);
+        }
+        g_free(self->imsi);
+        self->imsi = g_strdup(imsi);
+    }
+
+    /* The cache remains inactive until the IMSI is known */
+    return self->imsi && self->max_age_us > 0;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderSsCache*
+binder_ss_cache_new(
+    const char* log_prefix,
+    int max_age_ms)
+{
+    BinderSsCache* self = g_new0(BinderSsCache, 1);
+    int i;
+
+    self->log_prefix = binder_dup_prefix(log_prefix);
+    self->max_age_us = ((gint64) MAX(max_age_ms, 0)) * 1000;
+    for (i = 0; i < BINDER_SS_CACHE_GROUP_COUNT; i++) {
+        self->groups[i] = g_hash_table_new_full(g_str_hash, g_str_equal,
+            g_free, binder_ss_cache_entry_free);
+    }
+    return self;
+}
+
+void
+binder_ss_cache_free(
+    BinderSsCache* self)
+{
+    if (self) {
+        int i;
+
+        DBG_(self, "%u hit(s), %u refresh(es), %u miss(es)", self->hits,
+            self->refreshes, self->misses);
+        for (i = 0; i < BINDER_SS_CACHE_GROUP_COUNT; i++) {
+            g_hash_table_destroy(self->groups[i]);
+        }
+        g_free(self->imsi);
+        g_free(self->log_prefix);
+        g_free(self);
+    }
+}
+
+void
+binder_ss_cache_set_max_age(
+    BinderSsCache* self,
+    int max_age_ms)
+{
+    if (self) {
+        self->max_age_us = ((gint64) MAX(max_age_ms, 0)) * 1000;
+        if (!self->max_age_us) {
+            binder_ss_cache_clear(self);
+        }
+    }
+}
+
+gboolean
+binder_ss_cache_active(
+    BinderSsCache* self,
+    const char* imsi)
+{
+    return self && binder_ss_cache_check_imsi(self, imsi);
+}
+
+GBytes*
+binder_ss_cache_get(
+    BinderSsCache* self,
+    const char* imsi,
+    BINDER_SS_CACHE_GROUP group,
+    const char* key,
+    gboolean* refresh)
+{
+    if (self && binder_ss_cache_check_imsi(self, imsi)) {
+        const BinderSsCacheEntry* entry =
+            g_hash_table_lookup(self->groups[group], key);
+
+        if (entry) {
+            const gint64 age = g_get_monotonic_time() - entry->time;
+            const gboolean stale = (age >= self->max_age_us);
+
+            if (stale) {
+                self->refreshes++;
+                DBG_(self, "%s is %d s old", key, (int)(age / 1000000));
+            } else {
+                self->hits++;
+            }
+            if (refresh) {
+                *refresh = stale;
+            }
+            return entry->data;
+        }
+        self->misses++;
+    }
+    if (refresh) {
+        *refresh = TRUE;
+    }
+    return NULL;
+}
+
+guint
+binder_ss_cache_generation(
+    BinderSsCache* self,
+    BINDER_SS_CACHE_GROUP group)
+{
+    return self ? self->generation[group] : 0;
+}
+
+void
+binder_ss_cache_put(
+    BinderSsCache* self,
+    const char* imsi,
+    BINDER_SS_CACHE_GROUP group,
+    guint generation,
+    const char* key,
+    const void* data,
+    gsize size)
+{
+    if (self && self->generation[group] == generation &&
+        binder_ss_cache_check_imsi(self, imsi)) {
+        BinderSsCacheEntry* entry = g_slice_new(BinderSsCacheEntry);
+
+        entry->data = g_bytes_new(data, size);
+        entry->time = g_get_monotonic_time();
+        g_hash_table_replace(self->groups[group], g_strdup(key), entry);
+    }
+}
+
+void
+binder_ss_cache_reset(
+    BinderSsCache* self)
+{
+    if (self) {
+        DBG_(self, "");
+        binder_ss_cache_clear(self);
+    }
+}
+
+void
+binder_ss_cache_invalidate(
+    BinderSsCache* self,
+    BINDER_SS_CACHE_GROUP group)
+{
+    if (self) {
+        self->generation[group]++;
+        if (g_hash_table_size(self->groups[group])) {
+            DBG_(self, "invalidating group %d", group);
+            g_hash_table_remove_all(self->groups[group]);
+        }
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
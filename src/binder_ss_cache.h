@@ -0,0 +1,113 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_SS_CACHE_H
+#define BINDER_SS_CACHE_H
+
+#include "binder_types.h"
+
+/*
+ * Cache of supplementary service query results, owned by the slot
+ * and therefore surviving re-creation of the modem and its atoms.
+ * The contents belong to a particular IMSI and get dropped as soon
+ * as a different (or no) IMSI is passed in.
+ *
+ * Entries younger than the configured time are served without
+ * touching the network. Older ones are still served (the network
+ * doesn't normally change those behind our back) but the caller
+ * is asked to refresh them in the background. A successful set
+ * operation or a relevant SS notification invalidates the entire
+ * group, since e.g. "all conditional" forwarding affects several
+ * conditions at once. Results of the queries submitted before the
+ * invalidation are not stored, that's what the generation is for.
+ * After a modem reset or reconnect everything gets dropped.
+ */
+
+typedef enum binder_ss_cache_group {
+    BINDER_SS_CACHE_CALL_FORWARDING,
+    BINDER_SS_CACHE_CALL_BARRING,
+    BINDER_SS_CACHE_CALL_SETTINGS,
+    BINDER_SS_CACHE_GROUP_COUNT
+} BINDER_SS_CACHE_GROUP;
+
+BinderSsCache*
+binder_ss_cache_new(
+    const char* log_prefix,
+    int max_age_ms)
+    BINDER_INTERNAL;
+
+void
+binder_ss_cache_free(
+    BinderSsCache* cache)
+    BINDER_INTERNAL;
+
+void
+binder_ss_cache_set_max_age(
+    BinderSsCache* cache,
+    int max_age_ms)
+    BINDER_INTERNAL;
+
+gboolean
+binder_ss_cache_active(
+    BinderSsCache* cache,
+    const char* imsi)
+    BINDER_INTERNAL;
+
+GBytes*
+binder_ss_cache_get(
+    BinderSsCache* cache,
+    const char* imsi,
+    BINDER_SS_CACHE_GROUP group,
+    const char* key,
+    gboolean* refresh)
+    BINDER_INTERNAL;
+
+guint
+binder_ss_cache_generation(
+    BinderSsCache* cache,
+    BINDER_SS_CACHE_GROUP group)
+    BINDER_INTERNAL;
+
+void
+binder_ss_cache_put(
+    BinderSsCache* cache,
+    const char* imsi,
+    BINDER_SS_CACHE_GROUP group,
+    guint generation,
+    const char* key,
+    const void* data,
+    gsize size)
+    BINDER_INTERNAL;
+
+void
+binder_ss_cache_reset(
+    BinderSsCache* cache)
+    BINDER_INTERNAL;
+
+void
+binder_ss_cache_invalidate(
+    BinderSsCache* cache,
+    BINDER_SS_CACHE_GROUP group)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_SS_CACHE_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,777 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_metrics.h"
+#include "binder_stats.h"
+#include "binder_wakeup.h"
+
+#include <radio_instance.h>
+#include <radio_util.h>
+
+#include <gbinder_local_request.h>
+#include <gbinder_reader.h>
+#include <gbinder_writer.h>
+
+#include <gutil_misc.h>
+
+#include <string.h>
+
+#define BINDER_STATS_DEFAULT_TIMEOUT_MS (30000)
+#define BINDER_STATS_MAX_PENDING_US     (10 * 60 * G_USEC_PER_SEC)
+#define BINDER_STATS_SWEEP_INTERVAL_US  (G_USEC_PER_SEC)
+#define BINDER_STATS_FILE_SUFFIX        ".stats"
+#define BINDER_STATS_PROC_STATUS        "/proc/self/status"
+#define BINDER_STATS_PEAK_RSS_TAG       "VmHWM:"
+
+enum binder_stats_events {
+    EVENT_REQ,
+    EVENT_RESP,
+    EVENT_IND,
+    EVENT_IND_DONE,
+    EVENT_COUNT
+};
+
+typedef struct binder_stats_ind {
+    BinderStatsIndInfo pub;
+    gint64 rate_start;
+    guint rate;
+} BinderStatsInd;
+
+typedef struct binder_stats_latency {
+    guint count;
+    guint64 total_us;
+    guint hist[BINDER_STATS_BUCKETS];
+} BinderStatsLatency;
+
+enum binder_stats_call_latency {
+    CALL_LATENCY_MO_SETUP,  /* Dial to alerting */
+    CALL_LATENCY_MT_SETUP,  /* First indication to ringing */
+    CALL_LATENCY_ANSWER,    /* Answer to active */
+    CALL_LATENCY_COUNT
+};
+
+typedef struct binder_stats_pending {
+    BinderStatsReqInfo* info;
+    gint64 start;
+    gboolean timed_out;
+} BinderStatsPending;
+
+struct binder_stats {
+    char* name;
+    RadioInstance* instance;
+    gulong event_id[EVENT_COUNT];
+    GHashTable* reqs;       /* code => BinderStatsReqInfo */
+    GHashTable* pending;    /* serial => BinderStatsPending */
+    GHashTable* inds;       /* code => BinderStatsInd */
+    gint64 timeout_us;
+    gint64 last_sweep;
+    gboolean dirty;
+    guint calls;            /* Reported so far */
+    BinderStatsCallInfo call[BINDER_STATS_CALL_HISTORY]; /* Ring buffer */
+    BinderStatsLatency call_latency[CALL_LATENCY_COUNT];
+};
+
+static const BinderMetricFamily binder_stats_metric_req_duration = {
+    "binder_request_duration_seconds", BINDER_METRIC_HISTOGRAM,
+    "Time from request to response"
+};
+static const BinderMetricFamily binder_stats_metric_req_errors = {
+    "binder_request_errors", BINDER_METRIC_COUNTER,
+    "Requests completed with an error"
+};
+static const BinderMetricFamily binder_stats_metric_req_timeouts = {
+    "binder_request_timeouts", BINDER_METRIC_COUNTER,
+    "Requests not completed within the timeout"
+};
+static const BinderMetricFamily binder_stats_metric_inds = {
+    "binder_indications", BINDER_METRIC_COUNTER,
+    "Indications received"
+};
+static const BinderMetricFamily binder_stats_metric_ind_bytes = {
+    "binder_indication_bytes", BINDER_METRIC_COUNTER,
+    "Indication parcel data received"
+};
+static const BinderMetricFamily binder_stats_metric_ind_max_rate = {
+    "binder_indication_max_rate", BINDER_METRIC_GAUGE,
+    "Most indications received within a second"
+};
+static const BinderMetricFamily binder_stats_metric_ind_allocs = {
+    "binder_indication_allocs", BINDER_METRIC_COUNTER,
+    "Heap blocks allocated by indication handlers"
+};
+static const BinderMetricFamily binder_stats_metric_ind_alloc_bytes = {
+    "binder_indication_alloc_bytes", BINDER_METRIC_COUNTER,
+    "Heap memory allocated by indication handlers"
+};
+static const BinderMetricFamily binder_stats_metric_call_setup = {
+    "binder_call_setup_duration_seconds", BINDER_METRIC_HISTOGRAM,
+    "Time from dial to alerting (mo) or from indication to ringing (mt)"
+};
+static const BinderMetricFamily binder_stats_metric_call_answer = {
+    "binder_call_answer_duration_seconds", BINDER_METRIC_HISTOGRAM,
+    "Time from answer to active"
+};
+static const BinderMetricFamily binder_stats_metric_peak_rss = {
+    "binder_peak_rss_bytes", BINDER_METRIC_GAUGE,
+    "Peak resident set size of the process"
+};
+
+/* Indication being handled, if any */
+static BinderStatsInd* binder_stats_current_ind = NULL;
+
+static
+void
+binder_stats_pending_free(
+    gpointer data)
+{
+    g_slice_free(BinderStatsPending, data);
+}
+
+static
+BinderStatsReqInfo*
+binder_stats_req_info(
+    BinderStats* self,
+    guint code)
+{
+    gpointer key = GUINT_TO_POINTER(code);
+    BinderStatsReqInfo* info = g_hash_table_lookup(self->reqs, key);
+
+    if (!info) {
+        info = g_new0(BinderStatsReqInfo, 1);
+        info->code = code;
+        g_hash_table_insert(self->reqs, key, info);
+    }
+    return info;
+}
+
+static
+void
+binder_stats_sweep(
+    BinderStats* self,
+    gint64 now)
+{
+    GHashTableIter it;
+    gpointer value;
+
+    self->last_sweep = now;
+    g_hash_table_iter_init(&it, self->pending);
+    while (g_hash_table_iter_next(&it, NULL, &value)) {
+        BinderStatsPending* pending = value;
+        const gint64 age = now - pending->start;
+
+        if (age > BINDER_STATS_MAX_PENDING_US) {
+            /* The response is not going to arrive */
+            g_hash_table_iter_remove(&it);
+        } else if (!pending->timed_out && age > self->timeout_us) {
+            /* Keep it, it may still complete */
+            pending->timed_out = TRUE;
+            pending->info->timeouts++;
+            self->dirty = TRUE;
+        }
+    }
+}
+
+static
+void
+binder_stats_latency_add(
+    BinderStatsLatency* latency,
+    gint64 from,
+    gint64 to)
+{
+    if (from && to) {
+        const guint64 us = MAX(to - from, 0);
+
+        latency->count++;
+        latency->total_us += us;
+        latency->hist[MIN(g_bit_storage(us), BINDER_STATS_BUCKETS - 1)]++;
+    }
+}
+
+static
+void
+binder_stats_req_cb(
+    RadioInstance* radio,
+    RADIO_REQ code,
+    GBinderLocalRequest* args,
+    gpointer user_data)
+{
+    BinderStats* self = user_data;
+    const gsize header_size = radio_instance_rpc_header_size(radio, code);
+    const gint64 now = g_get_monotonic_time();
+    GBinderWriter writer;
+    const guint8* data;
+    guint32 serial;
+    gsize size;
+
+    /* Fetch the serial the same way as BinderLogger does */
+    gbinder_local_request_init_writer(args, &writer);
+    data = gbinder_writer_get_data(&writer, &size);
+    serial = (size >= header_size + 4) ? *(guint32*)(data + header_size) : 0;
+
+    if (now > self->last_sweep + BINDER_STATS_SWEEP_INTERVAL_US) {
+        binder_stats_sweep(self, now);
+    }
+
+    if (serial) {
+        BinderStatsPending* pending = g_slice_new(BinderStatsPending);
+
+        pending->info = binder_stats_req_info(self, code);
+        pending->start = now;
+        pending->timed_out = FALSE;
+        g_hash_table_insert(self->pending, GUINT_TO_POINTER(serial), pending);
+    }
+}
+
+static
+void
+binder_stats_resp_cb(
+    RadioInstance* radio,
+    RADIO_RESP code,
+    const RadioResponseInfo* resp,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderStats* self = user_data;
+    gpointer key = GUINT_TO_POINTER(resp->serial);
+    BinderStatsPending* pending = g_hash_table_lookup(self->pending, key);
+
+    if (pending) {
+        BinderStatsReqInfo* info = pending->info;
+        const gint64 t = g_get_monotonic_time() - pending->start;
+        const guint64 us = MAX(t, 0);
+
+        info->count++;
+        info->total_us += us;
+        info->hist[MIN(g_bit_storage(us), BINDER_STATS_BUCKETS - 1)]++;
+        if (info->max_us < us) {
+            info->max_us = us;
+        }
+        if (resp->error != RADIO_ERROR_NONE) {
+            info->errors++;
+        }
+        self->dirty = TRUE;
+        g_hash_table_remove(self->pending, key);
+    }
+}
+
+static
+void
+binder_stats_ind_cb(
+    RadioInstance* radio,
+    RADIO_IND code,
+    RADIO_IND_TYPE type,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    BinderStats* self = user_data;
+    gpointer key = GUINT_TO_POINTER(code);
+    BinderStatsInd* ind = g_hash_table_lookup(self->inds, key);
+    const gint64 now = g_get_monotonic_time();
+    gsize size = 0;
+
+    if (!ind) {
+        ind = g_new0(BinderStatsInd, 1);
+        ind->pub.code = code;
+        g_hash_table_insert(self->inds, key, ind);
+    }
+
+    binder_wakeup_ind(code);
+    gbinder_reader_get_data(args, &size);
+    ind->pub.count++;
+    ind->pub.bytes += size;
+
+    /* Rate within one second windows */
+    if (now - ind->rate_start >= G_USEC_PER_SEC) {
+        ind->rate_start = now;
+        ind->rate = 0;
+    }
+    ind->rate++;
+    if (ind->pub.max_rate < ind->rate) {
+        ind->pub.max_rate = ind->rate;
+    }
+    self->dirty = TRUE;
+
+    /* Charge allocations to this indication until it's handled */
+    binder_stats_current_ind = ind;
+}
+
+static
+void
+binder_stats_ind_done_cb(
+    RadioInstance* radio,
+    RADIO_IND code,
+    RADIO_IND_TYPE type,
+    const GBinderReader* args,
+    gpointer user_data)
+{
+    binder_stats_current_ind = NULL;
+}
+
+static
+guint
+binder_stats_peak_rss_kb(
+    void)
+{
+    char* text = NULL;
+    guint kb = 0;
+
+    /* VmHWM is the peak resident set size of the whole process */
+    if (g_file_get_contents(BINDER_STATS_PROC_STATUS, &text, NULL, NULL)) {
+        const char* line = strstr(text, BINDER_STATS_PEAK_RSS_TAG);
+
+        if (line) {
+            kb = (guint) g_ascii_strtoull(line +
+                sizeof(BINDER_STATS_PEAK_RSS_TAG) - 1, NULL, 10);
+        }
+        g_free(text);
+    }
+    return kb;
+}
+
+static
+void
+binder_stats_drop_instance(
+    BinderStats* self)
+{
+    if (self->instance) {
+        radio_instance_remove_all_handlers(self->instance, self->event_id);
+        radio_instance_unref(self->instance);
+        self->instance = NULL;
+    }
+
+    /* Nothing is going to complete those */
+    g_hash_table_remove_all(self->pending);
+    binder_stats_current_ind = NULL;
+}
+
+static
+gint
+binder_stats_compare_code(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const BinderStatsReqInfo* r1 = a;
+    const BinderStatsReqInfo* r2 = b;
+
+    return (gint)r1->code - (gint)r2->code;
+}
+
+static
+gint
+binder_stats_compare_ind_code(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const BinderStatsIndInfo* i1 = a;
+    const BinderStatsIndInfo* i2 = b;
+
+    return (gint)i1->code - (gint)i2->code;
+}
+
+static
+gint
+binder_stats_compare_ind_alloc(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const BinderStatsIndInfo* i1 = a;
+    const BinderStatsIndInfo* i2 = b;
+
+    /* Biggest first */
+    return (i1->alloc_bytes < i2->alloc_bytes) ? 1 :
+        (i1->alloc_bytes > i2->alloc_bytes) ? (-1) :
+        binder_stats_compare_ind_code(a, b);
+}
+
+static
+void
+binder_stats_add_call_metrics(
+    BinderMetrics* metrics,
+    const BinderMetricFamily* family,
+    const char* labels,
+    const char* dir,
+    const BinderStatsLatency* latency)
+{
+    if (latency->count) {
+        char* call = binder_metrics_labels("direction", dir, NULL);
+        char* all = binder_metrics_labels_join(labels, call);
+
+        binder_metrics_add_histogram(metrics, family, all, latency->hist,
+            BINDER_STATS_BUCKETS, latency->total_us);
+        g_free(all);
+        g_free(call);
+    }
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderStats*
+binder_stats_new(
+    const char* name)
+{
+    BinderStats* self = g_new0(BinderStats, 1);
+
+    self->name = g_strdup(name);
+    binder_stats_set_timeout(self, 0);
+    self->reqs = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+        NULL, g_free);
+    self->pending = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+        NULL, binder_stats_pending_free);
+    self->inds = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+        NULL, g_free);
+    return self;
+}
+
+void
+binder_stats_free(
+    BinderStats* self)
+{
+    if (self) {
+        binder_stats_drop_instance(self);
+        g_hash_table_destroy(self->pending);
+        g_hash_table_destroy(self->reqs);
+        g_hash_table_destroy(self->inds);
+        g_free(self->name);
+        g_free(self);
+    }
+}
+
+void
+binder_stats_set_instance(
+    BinderStats* self,
+    RadioInstance* instance)
+{
+    if (self && self->instance != instance) {
+        binder_stats_drop_instance(self);
+        if (instance) {
+            /* Just below the loggers */
+            const RADIO_INSTANCE_PRIORITY pri =
+                RADIO_INSTANCE_PRIORITY_HIGHEST - 2;
+
+            self->instance = radio_instance_ref(instance);
+            self->event_id[EVENT_REQ] =
+                radio_instance_add_request_observer_with_priority(instance,
+                    pri, RADIO_REQ_ANY, binder_stats_req_cb, self);
+            self->event_id[EVENT_RESP] =
+                radio_instance_add_response_observer_with_priority(instance,
+                    pri, RADIO_RESP_ANY, binder_stats_resp_cb, self);
+            self->event_id[EVENT_IND] =
+                radio_instance_add_indication_observer_with_priority(instance,
+                    pri, RADIO_IND_ANY, binder_stats_ind_cb, self);
+            self->event_id[EVENT_IND_DONE] =
+                radio_instance_add_indication_observer_with_priority(instance,
+                    RADIO_INSTANCE_PRIORITY_LOWEST, RADIO_IND_ANY,
+                    binder_stats_ind_done_cb, self);
+        }
+    }
+}
+
+void
+binder_stats_set_timeout(
+    BinderStats* self,
+    guint ms)
+{
+    if (self) {
+        self->timeout_us = (ms ? ms : BINDER_STATS_DEFAULT_TIMEOUT_MS) *
+            G_GINT64_CONSTANT(1000);
+    }
+}
+
+void
+binder_stats_alloc(
+    guint blocks,
+    gsize bytes)
+{
+    BinderStatsInd* ind = binder_stats_current_ind;
+
+    /* Only allocations made by indication handlers are accounted */
+    if (ind) {
+        ind->pub.allocs += blocks;
+        ind->pub.alloc_bytes += bytes;
+    }
+}
+
+guint64
+binder_stats_req_percentile(
+    const BinderStatsReqInfo* info,
+    guint percent)
+{
+    if (info && info->count) {
+        /* Rank of the requested sample, rounded up */
+        const guint64 rank = ((guint64)info->count * MIN(percent, 100) + 99)
+            / 100;
+        guint64 n = 0;
+        guint i;
+
+        for (i = 0; i < BINDER_STATS_BUCKETS; i++) {
+            n += info->hist[i];
+            if (n >= rank && n) {
+                /* Upper bound of the bucket, but not above the maximum */
+                return MIN(((guint64)1) << i, info->max_us);
+            }
+        }
+        return info->max_us;
+    }
+    return 0;
+}
+
+GList*
+binder_stats_get_reqs(
+    BinderStats* self)
+{
+    if (self) {
+        binder_stats_sweep(self, g_get_monotonic_time());
+        return g_list_sort(g_hash_table_get_values(self->reqs),
+            binder_stats_compare_code);
+    }
+    return NULL;
+}
+
+GList*
+binder_stats_get_inds(
+    BinderStats* self)
+{
+    /* BinderStatsIndInfo is the first member of BinderStatsInd */
+    return self ? g_list_sort(g_hash_table_get_values(self->inds),
+        binder_stats_compare_ind_code) : NULL;
+}
+
+void
+binder_stats_add_call(
+    BinderStats* self,
+    const BinderStatsCallInfo* call)
+{
+    if (self && call && call->t[BINDER_STATS_CALL_START]) {
+        const gint64* t = call->t;
+
+        self->call[self->calls++ % BINDER_STATS_CALL_HISTORY] = *call;
+        if (call->incoming) {
+            binder_stats_latency_add(self->call_latency +
+                CALL_LATENCY_MT_SETUP, t[BINDER_STATS_CALL_START],
+                t[BINDER_STATS_CALL_ALERTING]);
+            binder_stats_latency_add(self->call_latency +
+                CALL_LATENCY_ANSWER, t[BINDER_STATS_CALL_ANSWER],
+                t[BINDER_STATS_CALL_ACTIVE]);
+        } else {
+            binder_stats_latency_add(self->call_latency +
+                CALL_LATENCY_MO_SETUP, t[BINDER_STATS_CALL_START],
+                t[BINDER_STATS_CALL_ALERTING]);
+        }
+        self->dirty = TRUE;
+    }
+}
+
+char*
+binder_stats_format(
+    BinderStats* self)
+{
+    if (self) {
+        GString* buf = g_string_new(NULL);
+        GList* list = binder_stats_get_reqs(self);
+        GList* l;
+        guint i;
+
+        g_string_append_printf(buf, "# %s\n# code name count errors "
+            "timeouts avg_us p50_us p95_us p99_us max_us\n", self->name);
+        for (l = list; l; l = l->next) {
+            const BinderStatsReqInfo* info = l->data;
+            const char* name = radio_req_name(info->code);
+
+            g_string_append_printf(buf, "%u %s %u %u %u %" G_GUINT64_FORMAT
+                " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT
+                " %" G_GUINT64_FORMAT " %" G_GUINT64_FORMAT "\n",
+                info->code, name ? name : "-", info->count, info->errors,
+                info->timeouts, info->count ? (info->total_us / info->count) :
+                0, binder_stats_req_percentile(info, 50),
+                binder_stats_req_percentile(info, 95),
+                binder_stats_req_percentile(info, 99), info->max_us);
+        }
+        g_list_free(list);
+
+        list = binder_stats_get_inds(self);
+        g_string_append(buf, "# ind name count bytes max_per_sec "
+            "allocs alloc_bytes\n");
+        for (l = list; l; l = l->next) {
+            const BinderStatsIndInfo* info = l->data;
+            const char* name = radio_ind_name(info->code);
+
+            g_string_append_printf(buf, "%u %s %u %" G_GUINT64_FORMAT " %u %"
+                G_GUINT64_FORMAT " %" G_GUINT64_FORMAT "\n", info->code,
+                name ? name : "-", info->count, info->bytes, info->max_rate,
+                info->allocs, info->alloc_bytes);
+        }
+
+        /* Top allocating indications */
+        list = g_list_sort(list, binder_stats_compare_ind_alloc);
+        g_string_append(buf, "# top_alloc name alloc_bytes bytes_per_ind\n");
+        for (l = list, i = 0; l && i < BINDER_STATS_TOP_ALLOCS;
+             l = l->next, i++) {
+            const BinderStatsIndInfo* info = l->data;
+            const char* name = radio_ind_name(info->code);
+
+            if (!info->alloc_bytes) {
+                break;
+            }
+            g_string_append_printf(buf, "%u %s %" G_GUINT64_FORMAT " %"
+                G_GUINT64_FORMAT "\n", info->code, name ? name : "-",
+                info->alloc_bytes, info->alloc_bytes / info->count);
+        }
+        g_list_free(list);
+
+        /* Recent calls, oldest first, in ms since the start */
+        g_string_append(buf, "# call dir dial_done state_ind clcc notify "
+            "alerting answer active\n");
+        for (i = (self->calls > BINDER_STATS_CALL_HISTORY) ?
+             (self->calls - BINDER_STATS_CALL_HISTORY) : 0;
+             i < self->calls; i++) {
+            const BinderStatsCallInfo* call = self->call +
+                (i % BINDER_STATS_CALL_HISTORY);
+            const gint64 start = call->t[BINDER_STATS_CALL_START];
+            guint k;
+
+            g_string_append_printf(buf, "%u %s", i + 1, call->incoming ?
+                "mt" : "mo");
+            for (k = BINDER_STATS_CALL_START + 1;
+                 k < BINDER_STATS_CALL_STAGE_COUNT; k++) {
+                if (call->t[k]) {
+                    g_string_append_printf(buf, " %" G_GINT64_FORMAT,
+                        (call->t[k] - start) / 1000);
+                } else {
+                    g_string_append(buf, " -");
+                }
+            }
+            g_string_append_c(buf, '\n');
+        }
+
+        g_string_append_printf(buf, "# peak_rss_kb %u\n",
+            binder_stats_peak_rss_kb());
+        return g_string_free(buf, FALSE);
+    }
+    return NULL;
+}
+
+void
+binder_stats_add_metrics(
+    BinderStats* self,
+    BinderMetrics* metrics,
+    const char* labels)
+{
+    if (self && metrics) {
+        GList* list = binder_stats_get_reqs(self);
+        GList* l;
+
+        for (l = list; l; l = l->next) {
+            const BinderStatsReqInfo* info = l->data;
+            const char* name = radio_req_name(info->code);
+            char* code = g_strdup_printf("%u", info->code);
+            char* req = binder_metrics_labels("request", name ? name : code,
+                NULL);
+            char* all = binder_metrics_labels_join(labels, req);
+
+            binder_metrics_add_histogram(metrics,
+                &binder_stats_metric_req_duration, all, info->hist,
+                BINDER_STATS_BUCKETS, info->total_us);
+            binder_metrics_add(metrics, &binder_stats_metric_req_errors,
+                all, info->errors);
+            binder_metrics_add(metrics, &binder_stats_metric_req_timeouts,
+                all, info->timeouts);
+            g_free(all);
+            g_free(req);
+            g_free(code);
+        }
+        g_list_free(list);
+
+        list = binder_stats_get_inds(self);
+        for (l = list; l; l = l->next) {
+            const BinderStatsIndInfo* info = l->data;
+            const char* name = radio_ind_name(info->code);
+            char* code = g_strdup_printf("%u", info->code);
+            char* ind = binder_metrics_labels("indication",
+                name ? name : code, NULL);
+            char* all = binder_metrics_labels_join(labels, ind);
+
+            binder_metrics_add(metrics, &binder_stats_metric_inds, all,
+                info->count);
+            binder_metrics_add(metrics, &binder_stats_metric_ind_bytes, all,
+                info->bytes);
+            binder_metrics_add(metrics, &binder_stats_metric_ind_max_rate,
+                all, info->max_rate);
+            binder_metrics_add(metrics, &binder_stats_metric_ind_allocs, all,
+                info->allocs);
+            binder_metrics_add(metrics, &binder_stats_metric_ind_alloc_bytes,
+                all, info->alloc_bytes);
+            g_free(all);
+            g_free(ind);
+            g_free(code);
+        }
+        g_list_free(list);
+
+        binder_stats_add_call_metrics(metrics,
+            &binder_stats_metric_call_setup, labels, "mo",
+            self->call_latency + CALL_LATENCY_MO_SETUP);
+        binder_stats_add_call_metrics(metrics,
+            &binder_stats_metric_call_setup, labels, "mt",
+            self->call_latency + CALL_LATENCY_MT_SETUP);
+        binder_stats_add_call_metrics(metrics,
+            &binder_stats_metric_call_answer, labels, "mt",
+            self->call_latency + CALL_LATENCY_ANSWER);
+    }
+}
+
+void
+binder_stats_add_process_metrics(
+    BinderMetrics* metrics)
+{
+    binder_metrics_add(metrics, &binder_stats_metric_peak_rss, NULL,
+        ((guint64)binder_stats_peak_rss_kb()) * 1024);
+}
+
+gboolean
+binder_stats_write(
+    BinderStats* self,
+    const char* dir)
+{
+    gboolean ok = FALSE;
+
+    if (self && dir && self->dirty) {
+        char* file = g_strconcat(self->name, BINDER_STATS_FILE_SUFFIX, NULL);
+        char* path = g_build_filename(dir, file, NULL);
+        char* text = binder_stats_format(self);
+        GError* error = NULL;
+
+        if (g_file_set_contents(path, text, -1, &error)) {
+            self->dirty = FALSE;
+            ok = TRUE;
+        } else {
+            ofono_warn("Failed to write %s: %s", path, error->message);
+            g_error_free(error);
+        }
+        g_free(text);
+        g_free(path);
+        g_free(file);
+    }
+    return ok;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
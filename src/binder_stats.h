@@ -0,0 +1,171 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_STATS_H
+#define BINDER_STATS_H
+
+#include "binder_types.h"
+
+/*
+ * Per-slot runtime statistics. Requests and responses are paired by
+ * serial and request latencies are collected into log2 buckets, per
+ * request code. Indications are counted per code too, along with the
+ * amount of parcel data and the highest rate seen within a second.
+ * Allocations reported by binder_stats_alloc() while an indication is
+ * being handled are charged to that indication, which shows where the
+ * indication handlers spend most on the heap.
+ *
+ * The object outlives RadioInstance, i.e. the numbers survive radio
+ * service restarts.
+ */
+
+#define BINDER_STATS_BUCKETS (32)
+
+typedef struct binder_stats_req_info {
+    guint code;
+    guint count;        /* Completed requests */
+    guint errors;       /* Completed with an error */
+    guint timeouts;     /* Not completed within the timeout */
+    guint64 total_us;
+    guint64 max_us;
+    guint hist[BINDER_STATS_BUCKETS]; /* [2^(i-1), 2^i) microseconds */
+} BinderStatsReqInfo;
+
+typedef struct binder_stats_ind_info {
+    guint code;
+    guint count;
+    guint64 bytes;      /* Parcel data received */
+    guint max_rate;     /* Most indications within a second */
+    guint64 allocs;     /* Heap blocks allocated by the handlers */
+    guint64 alloc_bytes;
+} BinderStatsIndInfo;
+
+#define BINDER_STATS_TOP_ALLOCS (5)
+
+/*
+ * Voice call setup timeline, reported by BinderVoiceCall once the call
+ * gets connected or disappears. Timestamps are monotonic microseconds,
+ * zero if the call didn't get that far (or the stage doesn't apply to
+ * this direction). Comparing the adjacent stages tells apart the time
+ * spent in the RIL, in CLCC polling and in ofono core.
+ */
+typedef enum binder_stats_call_stage {
+    BINDER_STATS_CALL_START,        /* dial() or MT callStateChanged */
+    BINDER_STATS_CALL_DIAL_DONE,    /* dial response (MO) */
+    BINDER_STATS_CALL_STATE_IND,    /* First callStateChanged */
+    BINDER_STATS_CALL_CLCC,         /* First getCurrentCalls with the call */
+    BINDER_STATS_CALL_NOTIFY,       /* First ofono_voicecall_notify returned */
+    BINDER_STATS_CALL_ALERTING,     /* Alerting (MO) or ringing (MT) */
+    BINDER_STATS_CALL_ANSWER,       /* answer() (MT) */
+    BINDER_STATS_CALL_ACTIVE,       /* Active notified to ofono */
+    BINDER_STATS_CALL_STAGE_COUNT
+} BINDER_STATS_CALL_STAGE;
+
+typedef struct binder_stats_call_info {
+    gboolean incoming;
+    gint64 t[BINDER_STATS_CALL_STAGE_COUNT];
+} BinderStatsCallInfo;
+
+#define BINDER_STATS_CALL_HISTORY (8)
+
+BinderStats*
+binder_stats_new(
+    const char* name)
+    BINDER_INTERNAL;
+
+void
+binder_stats_free(
+    BinderStats* stats)
+    BINDER_INTERNAL;
+
+void
+binder_stats_set_instance(
+    BinderStats* stats,
+    RadioInstance* instance)
+    BINDER_INTERNAL;
+
+void
+binder_stats_set_timeout(
+    BinderStats* stats,
+    guint timeout_ms)
+    BINDER_INTERNAL;
+
+void
+binder_stats_alloc(
+    guint blocks,
+    gsize bytes)
+    BINDER_INTERNAL;
+
+guint64
+binder_stats_req_percentile(
+    const BinderStatsReqInfo* info,
+    guint percent)
+    BINDER_INTERNAL;
+
+/*
+ * Snapshots sorted by code. The caller frees the list with g_list_free(),
+ * the data belong to BinderStats and stay valid until it's freed.
+ */
+GList*
+binder_stats_get_reqs(
+    BinderStats* stats)
+    G_GNUC_WARN_UNUSED_RESULT
+    BINDER_INTERNAL;
+
+GList*
+binder_stats_get_inds(
+    BinderStats* stats)
+    G_GNUC_WARN_UNUSED_RESULT
+    BINDER_INTERNAL;
+
+void
+binder_stats_add_call(
+    BinderStats* stats,
+    const BinderStatsCallInfo* call)
+    BINDER_INTERNAL;
+
+char*
+binder_stats_format(
+    BinderStats* stats)
+    BINDER_INTERNAL;
+
+void
+binder_stats_add_metrics(
+    BinderStats* stats,
+    BinderMetrics* metrics,
+    const char* labels)
+    BINDER_INTERNAL;
+
+/* Process wide numbers, not tied to any slot */
+void
+binder_stats_add_process_metrics(
+    BinderMetrics* metrics)
+    BINDER_INTERNAL;
+
+gboolean
+binder_stats_write(
+    BinderStats* stats,
+    const char* dir)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_STATS_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,350 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_data.h"
+#include "binder_decoder.h"
+#include "binder_log.h"
+#include "binder_modem.h"
+#include "binder_network.h"
+#include "binder_radio_caps.h"
+#include "binder_sim_card.h"
+#include "binder_stats.h"
+#include "binder_stats_dbus.h"
+#include "binder_util.h"
+
+#include <ofono/dbus.h>
+#include <ofono/gdbus.h>
+#include <ofono/log.h>
+#include <ofono/modem.h>
+
+#include <radio_util.h>
+
+#define BINDER_STATS_DBUS_INTERFACE OFONO_SERVICE ".BinderStats"
+
+struct binder_stats_dbus {
+    char* path;
+    DBusConnection* conn;
+    struct ofono_modem* modem;
+    BinderStats* stats;
+    BinderDecoder* decoder;
+    BinderSimCard* card;
+    BinderData* data;
+    BinderNetwork* network;
+    BinderRadioCapsManager* caps;
+};
+
+static
+void
+binder_stats_dbus_append_section(
+    GString* buf,
+    char* text)
+{
+    if (text) {
+        if (buf->len) {
+            g_string_append_c(buf, '\n');
+        }
+        g_string_append(buf, text);
+        g_free(text);
+    }
+}
+
+static
+DBusMessage*
+binder_stats_dbus_get_requests(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    BinderStatsDbus* self = user_data;
+    DBusMessage* reply = dbus_message_new_method_return(msg);
+    GList* list = binder_stats_get_reqs(self->stats);
+    DBusMessageIter it, array;
+    GList* l;
+
+    dbus_message_iter_init_append(reply, &it);
+    dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY, "(usuuutt)",
+        &array);
+    for (l = list; l; l = l->next) {
+        const BinderStatsReqInfo* info = l->data;
+        const char* name = radio_req_name(info->code);
+        const dbus_uint64_t avg_us = info->count ?
+            (info->total_us / info->count) : 0;
+        const dbus_uint64_t max_us = info->max_us;
+        DBusMessageIter entry;
+
+        if (!name) {
+            name = "-";
+        }
+        dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT, NULL,
+            &entry);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &info->code);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &name);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+            &info->count);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+            &info->errors);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+            &info->timeouts);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &avg_us);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &max_us);
+        dbus_message_iter_close_container(&array, &entry);
+    }
+    dbus_message_iter_close_container(&it, &array);
+    g_list_free(list);
+    return reply;
+}
+
+static
+DBusMessage*
+binder_stats_dbus_get_indications(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    BinderStatsDbus* self = user_data;
+    DBusMessage* reply = dbus_message_new_method_return(msg);
+    GList* list = binder_stats_get_inds(self->stats);
+    DBusMessageIter it, array;
+    GList* l;
+
+    dbus_message_iter_init_append(reply, &it);
+    dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY, "(usutut)",
+        &array);
+    for (l = list; l; l = l->next) {
+        const BinderStatsIndInfo* info = l->data;
+        const char* name = radio_ind_name(info->code);
+        const dbus_uint64_t bytes = info->bytes;
+        const dbus_uint64_t alloc_bytes = info->alloc_bytes;
+        DBusMessageIter entry;
+
+        if (!name) {
+            name = "-";
+        }
+        dbus_message_iter_open_container(&array, DBUS_TYPE_STRUCT, NULL,
+            &entry);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32, &info->code);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &name);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+            &info->count);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64, &bytes);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT32,
+            &info->max_rate);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_UINT64,
+            &alloc_bytes);
+        dbus_message_iter_close_container(&array, &entry);
+    }
+    dbus_message_iter_close_container(&it, &array);
+    g_list_free(list);
+    return reply;
+}
+
+static
+void
+binder_stats_dbus_append_reg(
+    DBusMessageIter* dict,
+    const char* status_key,
+    const char* tech_key,
+    const BinderRegistrationState* reg)
+{
+    const dbus_int32_t status = reg->status;
+    const char* tech =
+        binder_ofono_access_technology_string(reg->access_tech);
+
+    ofono_dbus_dict_append(dict, status_key, DBUS_TYPE_INT32, &status);
+    ofono_dbus_dict_append(dict, tech_key, DBUS_TYPE_STRING, &tech);
+}
+
+static
+DBusMessage*
+binder_stats_dbus_get_state(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    BinderStatsDbus* self = user_data;
+    DBusMessage* reply = dbus_message_new_method_return(msg);
+    DBusMessageIter it, dict;
+
+    dbus_message_iter_init_append(reply, &it);
+    dbus_message_iter_open_container(&it, DBUS_TYPE_ARRAY,
+        OFONO_PROPERTIES_ARRAY_SIGNATURE, &dict);
+
+    /* Snapshots give a consistent view without poking the objects */
+    if (self->network) {
+        const BinderNetworkSnapshot* net =
+            binder_network_snapshot_ref(self->network);
+        const dbus_int32_t max_calls = net->max_data_calls;
+        const dbus_uint32_t pref = net->pref_modes;
+        const dbus_uint32_t allowed = net->allowed_modes;
+
+        binder_stats_dbus_append_reg(&dict, "VoiceStatus",
+            "VoiceTechnology", &net->voice);
+        binder_stats_dbus_append_reg(&dict, "DataStatus",
+            "DataTechnology", &net->data);
+        if (net->have_operator) {
+            char* op = g_strconcat(net->operator.mcc, net->operator.mnc,
+                NULL);
+
+            ofono_dbus_dict_append(&dict, "Operator", DBUS_TYPE_STRING, &op);
+            g_free(op);
+        }
+        ofono_dbus_dict_append(&dict, "MaxDataCalls", DBUS_TYPE_INT32,
+            &max_calls);
+        ofono_dbus_dict_append(&dict, "PreferredModes", DBUS_TYPE_UINT32,
+            &pref);
+        ofono_dbus_dict_append(&dict, "AllowedModes", DBUS_TYPE_UINT32,
+            &allowed);
+        binder_network_snapshot_unref(net);
+    }
+
+    if (self->data) {
+        const BinderDataSnapshot* data = binder_data_snapshot_ref(self->data);
+        const dbus_bool_t allowed = data->allowed;
+        const dbus_uint32_t count = data->count;
+        dbus_uint32_t active = 0;
+        guint i;
+
+        for (i = 0; i < data->count; i++) {
+            if (data->calls[i].active != RADIO_DATA_CALL_INACTIVE) {
+                active++;
+            }
+        }
+        ofono_dbus_dict_append(&dict, "DataAllowed", DBUS_TYPE_BOOLEAN,
+            &allowed);
+        ofono_dbus_dict_append(&dict, "DataCalls", DBUS_TYPE_UINT32, &count);
+        ofono_dbus_dict_append(&dict, "ActiveDataCalls", DBUS_TYPE_UINT32,
+            &active);
+        binder_data_snapshot_unref(data);
+    }
+
+    dbus_message_iter_close_container(&it, &dict);
+    return reply;
+}
+
+static
+DBusMessage*
+binder_stats_dbus_get_report(
+    DBusConnection* conn,
+    DBusMessage* msg,
+    void* user_data)
+{
+    BinderStatsDbus* self = user_data;
+    DBusMessage* reply = dbus_message_new_method_return(msg);
+    GString* buf = g_string_new(NULL);
+    DBusMessageIter it;
+
+    binder_stats_dbus_append_section(buf,
+        binder_stats_format(self->stats));
+    binder_stats_dbus_append_section(buf,
+        binder_data_format_stats(self->data));
+    binder_stats_dbus_append_section(buf,
+        binder_sim_card_format_stats(self->card));
+    binder_stats_dbus_append_section(buf,
+        binder_decoder_format_stats(self->decoder));
+    binder_stats_dbus_append_section(buf,
+        binder_radio_caps_manager_format_stats(self->caps));
+
+    dbus_message_iter_init_append(reply, &it);
+    dbus_message_iter_append_basic(&it, DBUS_TYPE_STRING, &buf->str);
+    g_string_free(buf, TRUE);
+    return reply;
+}
+
+static const GDBusMethodTable binder_stats_dbus_methods[] = {
+    { GDBUS_METHOD("GetRequests",
+        NULL, GDBUS_ARGS({ "requests", "a(usuuutt)" }),
+        binder_stats_dbus_get_requests) },
+    { GDBUS_METHOD("GetIndications",
+        NULL, GDBUS_ARGS({ "indications", "a(usutut)" }),
+        binder_stats_dbus_get_indications) },
+    { GDBUS_METHOD("GetState",
+        NULL, GDBUS_ARGS({ "state", "a{sv}" }),
+        binder_stats_dbus_get_state) },
+    { GDBUS_METHOD("GetReport",
+        NULL, GDBUS_ARGS({ "report", "s" }),
+        binder_stats_dbus_get_report) },
+    { }
+};
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+BinderStatsDbus*
+binder_stats_dbus_new(
+    BinderModem* modem,
+    BinderDecoder* decoder,
+    BinderRadioCapsManager* caps)
+{
+    BinderStatsDbus* self = g_new0(BinderStatsDbus, 1);
+    const char* path = modem->path;
+
+    self->path = g_strdup(path);
+    self->conn = dbus_connection_ref(ofono_dbus_get_connection());
+    self->stats = modem->stats;
+    self->decoder = binder_decoder_ref(decoder);
+    self->card = binder_sim_card_ref(modem->sim_card);
+    self->data = binder_data_ref(modem->data);
+    self->network = binder_network_ref(modem->network);
+    self->caps = binder_radio_caps_manager_ref(caps);
+    if (g_dbus_register_interface(self->conn, path,
+        BINDER_STATS_DBUS_INTERFACE, binder_stats_dbus_methods,
+        NULL, NULL, self, NULL)) {
+        DBG("%s", path);
+        self->modem = modem->ofono;
+        ofono_modem_add_interface(self->modem, BINDER_STATS_DBUS_INTERFACE);
+        return self;
+    } else {
+        ofono_error("Failed to register %s at %s",
+            BINDER_STATS_DBUS_INTERFACE, path);
+        g_free(self->path);
+        self->path = NULL;
+        binder_stats_dbus_free(self);
+        return NULL;
+    }
+}
+
+void
+binder_stats_dbus_free(
+    BinderStatsDbus* self)
+{
+    if (self) {
+        if (self->path) {
+            DBG("%s", self->path);
+            if (self->modem) {
+                ofono_modem_remove_interface(self->modem,
+                    BINDER_STATS_DBUS_INTERFACE);
+            }
+            g_dbus_unregister_interface(self->conn, self->path,
+                BINDER_STATS_DBUS_INTERFACE);
+            g_free(self->path);
+        }
+        dbus_connection_unref(self->conn);
+        binder_decoder_unref(self->decoder);
+        binder_sim_card_unref(self->card);
+        binder_data_unref(self->data);
+        binder_network_unref(self->network);
+        binder_radio_caps_manager_unref(self->caps);
+        g_free(self);
+    }
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
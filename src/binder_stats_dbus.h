@@ -0,0 +1,64 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_STATS_DBUS_H
+#define BINDER_STATS_DBUS_H
+
+#include "binder_types.h"
+
+/*
+ * org.ofono.BinderStats interface registered at the modem path. It
+ * exposes the same numbers as the files in the stats directory, i.e.
+ * requests and indications per code, data request queues, SIM card
+ * and SIM I/O counters, decoder and radio caps transactions:
+ *
+ *   GetRequests() -> a(usuuutt)
+ *     code, name, count, errors, timeouts, avg_us, max_us
+ *   GetIndications() -> a(usutut)
+ *     code, name, count, bytes, max_per_sec, alloc_bytes
+ *   GetState() -> a{sv}
+ *     Registration, operator, modes and data calls, read from the
+ *     BinderNetwork and BinderData snapshots
+ *   GetReport() -> s
+ *     Everything in text form
+ *
+ * The interface is listed in the modem's Interfaces property. It must
+ * be freed before the ofono modem goes away. Any of the modem's
+ * sources, the decoder and the radio caps manager can be NULL.
+ */
+
+typedef struct binder_stats_dbus BinderStatsDbus;
+
+BinderStatsDbus*
+binder_stats_dbus_new(
+    BinderModem* modem,
+    BinderDecoder* decoder,
+    BinderRadioCapsManager* caps)
+    BINDER_INTERNAL;
+
+void
+binder_stats_dbus_free(
+    BinderStatsDbus* dbus)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_STATS_DBUS_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
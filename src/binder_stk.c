@@ -28,6 +28,9 @@
 #include <gbinder_reader.h>
 #include <gbinder_writer.h>
 
+/* Tag, up to 2 length bytes and 255 bytes of data, see TS 102.223 */
+#define STK_PDU_BUF_SIZE (258)
+
 enum binder_stk_events {
     STK_EVENT_PROACTIVE_COMMAND,
     STK_EVENT_SESSION_END,
@@ -120,8 +123,8 @@ binder_stk_envelope(
     void* data)
 {
     BinderStk* self = binder_stk_get_data(stk);
-    char* hex = binder_encode_hex(cmd, length);
     GBinderWriter writer;
+    char* hex;
 
     /* sendEnvelope(int32 serial, string command); */
     RadioRequest* req = radio_request_new2(self->g,
@@ -129,8 +132,10 @@ binder_stk_envelope(
         binder_stk_envelope_cb, binder_stk_cbd_free,
         binder_stk_cbd_new(self, BINDER_CB(cb), data));
 
+    /* The hex string lives in the writer's memory, no extra copy */
+    hex = gbinder_writer_malloc(&writer, length * 2 + 1);
+    binder_encode_hex_buf(cmd, length, hex);
     DBG("envelope %s", hex);
-    gbinder_writer_add_cleanup(&writer, g_free, hex);
     gbinder_writer_append_hidl_string(&writer, hex);
     radio_request_submit(req);
     radio_request_unref(req);
@@ -178,8 +183,8 @@ binder_stk_terminal_response(
     void* data)
 {
     BinderStk* self = binder_stk_get_data(stk);
-    char* hex = binder_encode_hex(resp, length);
     GBinderWriter writer;
+    char* hex;
 
     /* sendTerminalResponseToSim(int32 serial, string commandResponse); */
     RadioRequest* req = radio_request_new2(self->g,
@@ -187,8 +192,9 @@ binder_stk_terminal_response(
         binder_stk_terminal_response_cb, binder_stk_cbd_free,
         binder_stk_cbd_new(self, BINDER_CB(cb), data));
 
+    hex = gbinder_writer_malloc(&writer, length * 2 + 1);
+    binder_encode_hex_buf(resp, length, hex);
     DBG_(self, "terminal response: %s", hex);
-    gbinder_writer_add_cleanup(&writer, g_free, hex);
     gbinder_writer_append_hidl_string(&writer, hex);
     radio_request_submit(req);
     radio_request_unref(req);
@@ -225,6 +231,7 @@ binder_stk_proactive_command(
     BinderStk* self = user_data;
     GBinderReader reader;
     const char* pcmd;
+    guint8 buf[STK_PDU_BUF_SIZE];
     void* pdu;
     guint len;
 
@@ -238,11 +245,13 @@ binder_stk_proactive_command(
      */
     gbinder_reader_copy(&reader, args);
     pcmd = gbinder_reader_read_hidl_string_c(&reader);
-    pdu = binder_decode_hex(pcmd, -1, &len);
+    pdu = binder_decode_hex_buf(pcmd, -1, buf, sizeof(buf), &len);
     if (pdu) {
         DBG_(self, "pcmd: %s", pcmd);
         ofono_stk_proactive_command_notify(self->stk, len, pdu);
-        g_free(pdu);
+        if (pdu != buf) {
+            g_free(pdu);
+        }
     } else {
         ofono_warn("Failed to parse STK command %s", pcmd);
     }
@@ -259,6 +268,7 @@ binder_stk_event_notify(
     BinderStk* self = user_data;
     GBinderReader reader;
     const char* pcmd;
+    guint8 buf[STK_PDU_BUF_SIZE];
     void* pdu;
     guint len;
 
@@ -273,11 +283,13 @@ binder_stk_event_notify(
      */
     gbinder_reader_copy(&reader, args);
     pcmd = gbinder_reader_read_hidl_string_c(&reader);
-    pdu = binder_decode_hex(pcmd, -1, &len);
+    pdu = binder_decode_hex_buf(pcmd, -1, buf, sizeof(buf), &len);
     if (pdu) {
         DBG_(self, "pcmd: %s", pcmd);
         ofono_stk_proactive_command_handled_notify(self->stk, len, pdu);
-        g_free(pdu);
+        if (pdu != buf) {
+            g_free(pdu);
+        }
     } else {
         ofono_warn("Failed to parse STK event %s", pcmd);
     }
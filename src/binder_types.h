@@ -22,17 +22,23 @@
 
 typedef struct binder_data BinderData;
 typedef struct binder_data_manager BinderDataManager;
+typedef struct binder_decoder BinderDecoder;
 typedef struct binder_devmon BinderDevmon;
 typedef struct binder_ims_reg BinderImsReg;
 typedef struct binder_logger BinderLogger;
+typedef struct binder_metrics BinderMetrics;
 typedef struct binder_modem BinderModem;
 typedef struct binder_network BinderNetwork;
 typedef struct binder_radio_caps BinderRadioCaps;
 typedef struct binder_radio_caps_manager BinderRadioCapsManager;
 typedef struct binder_radio_caps_request BinderRadioCapsRequest;
 typedef struct binder_radio BinderRadio;
+typedef struct binder_req_share BinderReqShare;
 typedef struct binder_sim_card BinderSimCard;
+typedef struct binder_sim_io_cache BinderSimIoCache;
 typedef struct binder_sim_settings BinderSimSettings;
+typedef struct binder_ss_cache BinderSsCache;
+typedef struct binder_stats BinderStats;
 
 typedef enum binder_feature_mask {
     BINDER_FEATURE_NONE           = 0,
@@ -56,14 +62,67 @@ typedef struct binder_data_profile_config {
     guint mms_profile_id;
 } BinderDataProfileConfig;
 
+/*
+ * Device state profiles, selected by setIndicationFilter based device
+ * state tracking. The tethering profile only kicks in if it has been
+ * configured.
+ */
+typedef enum binder_devmon_profile_id {
+    BINDER_DEVMON_PROFILE_SCREEN_ON,
+    BINDER_DEVMON_PROFILE_SCREEN_ON_LOW_BATTERY,
+    BINDER_DEVMON_PROFILE_SCREEN_OFF_CHARGING,
+    BINDER_DEVMON_PROFILE_SCREEN_OFF_IDLE,
+    BINDER_DEVMON_PROFILE_TETHERING,
+    BINDER_DEVMON_PROFILE_COUNT
+} BINDER_DEVMON_PROFILE;
+
+typedef struct binder_devmon_profile {
+    gboolean enabled;
+    int ind_filter;             /* RADIO_IND_FILTER bits */
+    int cell_info_interval_ms;
+} BinderDevmonProfile;
+
+/*
+ * Link capacity estimate reporting criteria (IRadio 1.2+). Thresholds
+ * are in kbps, in ascending order. Reporting criteria are left to the
+ * modem if neither list is configured.
+ */
+#define BINDER_LCE_THRESHOLDS_MAX (8)
+
+typedef struct binder_lce_config {
+    int hysteresis_ms;
+    guint dl_count;
+    guint ul_count;
+    gint32 dl_kbps[BINDER_LCE_THRESHOLDS_MAX];
+    gint32 ul_kbps[BINDER_LCE_THRESHOLDS_MAX];
+} BinderLceConfig;
+
 typedef struct binder_slot_config {
     guint slot;
     int cell_info_interval_short_ms;
     int cell_info_interval_long_ms;
+    int cell_info_interval_max_ms;
+    int cell_info_max_neighbours;
+    int display_on_delay_ms;
+    int display_off_delay_ms;
+    int charger_delay_ms;
     int network_mode_timeout_ms;
     int network_selection_timeout_ms;
+    int network_scan_settle_ms;
+    int operator_list_cache_ms;
     int signal_strength_dbm_weak;
     int signal_strength_dbm_strong;
+    int signal_strength_window_ms;
+    int signal_strength_thresholds;
+    guint sim_io_concurrency;
+    guint sim_record_prefetch;
+    guint sim_status_debounce_ms;
+    guint ims_state_debounce_ms;
+    guint sim_channel_idle_ms;
+    guint sms_send_window;
+    guint sms_fallback_timeout_ms;
+    guint clcc_poll_window_ms;
+    int ss_cache_ms;
     enum ofono_radio_access_mode techs;
     RADIO_PREF_NET_TYPE lte_network_mode;
     RADIO_PREF_NET_TYPE umts_network_mode;
@@ -75,7 +134,11 @@ typedef struct binder_slot_config {
     gboolean use_network_scan;
     gboolean replace_strange_oper;
     gboolean force_gsm_when_radio_off;
+    gboolean dtmf_burst;
+    gboolean sms_adaptive_routing;
     BinderDataProfileConfig data_profile_config;
+    BinderDevmonProfile devmon_profile[BINDER_DEVMON_PROFILE_COUNT];
+    BinderLceConfig lce;
     GUtilInts* local_hangup_reasons;
     GUtilInts* remote_hangup_reasons;
 } BinderSlotConfig;
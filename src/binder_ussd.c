@@ -41,6 +41,12 @@ typedef struct binder_ussd {
     RadioRequest* cancel_req;
     gulong event_id;
     guint register_id;
+    gboolean session; /* Network is waiting for the user's response */
+    guint session_steps;
+    gint64 step_start;
+    guint steps;
+    guint64 step_total_us;
+    guint64 step_max_us;
 } BinderUssd;
 
 typedef struct binder_ussd_cbd {
@@ -77,6 +83,57 @@ binder_ussd_cbd_free(
     g_slice_free(BinderUssdCbData, cbd);
 }
 
+static
+void
+binder_ussd_complete_send(
+    BinderUssd* self)
+{
+    /*
+     * Complete the pending sendUssd request (if any) without waiting
+     * for its response. The network has already delivered the next
+     * message, and ofono won't send the follow-up response until the
+     * previous request has completed.
+     */
+    if (self->send_req) {
+        struct ofono_error err;
+        RadioRequest* req = self->send_req;
+        BinderUssdCbData* cbd = radio_request_user_data(req);
+
+        self->send_req = NULL;
+        cbd->cb(binder_error_ok(&err), cbd->data);
+        radio_request_drop(req); /* Frees BinderUssdCbData */
+    }
+}
+
+static
+void
+binder_ussd_step_done(
+    BinderUssd* self,
+    gboolean session)
+{
+    if (self->step_start) {
+        const gint64 now = g_get_monotonic_time();
+        const guint64 us = MAX(now - self->step_start, 0);
+
+        self->step_start = 0;
+        self->steps++;
+        self->session_steps++;
+        self->step_total_us += us;
+        if (self->step_max_us < us) {
+            self->step_max_us = us;
+        }
+        DBG_(self, "step %u round trip %u ms", self->session_steps,
+            (guint) (us / 1000));
+    }
+    if (self->session && !session) {
+        DBG_(self, "session ended after %u step(s)", self->session_steps);
+    }
+    self->session = session;
+    if (!session) {
+        self->session_steps = 0;
+    }
+}
+
 static
 void
 binder_ussd_cancel_cb(
@@ -148,6 +205,8 @@ binder_ussd_send_cb(
     } else {
         ofono_warn("Failed to send USSD");
     }
+    self->step_start = 0;
+    binder_ussd_step_done(self, FALSE);
     cbd->cb(binder_error_failure(&err), cbd->data);
 }
 
@@ -165,10 +224,11 @@ binder_ussd_request(
     char* text = ofono_ussd_decode(dcs, pdu, len);
     struct ofono_error err;
 
-    DBG_(self, "ussd request: %s", text);
+    DBG_(self, "ussd %s: %s", self->session ? "response" : "request", text);
     GASSERT(!self->send_req);
     radio_request_drop(self->send_req);
     self->send_req = NULL;
+    self->step_start = g_get_monotonic_time();
 
     if (text) {
         /* sendUssd(int32 serial, string ussd); */
@@ -207,6 +267,7 @@ binder_ussd_cancel(
     BinderUssd* self = binder_ussd_get_data(ussd);
 
     ofono_info("sending ussd cancel");
+    binder_ussd_step_done(self, FALSE);
     GASSERT(!self->cancel_req);
     radio_request_drop(self->cancel_req);
 
@@ -246,6 +307,9 @@ binder_ussd_notify(
     if (gbinder_reader_read_int32(&reader, &type)) {
         const char* msg = gbinder_reader_read_hidl_string_c(&reader);
 
+        binder_ussd_step_done(self,
+            type == OFONO_USSD_STATUS_ACTION_REQUIRED);
+
         if (msg && msg[0]) {
             const int len = (int) strlen(msg);
 
@@ -255,15 +319,7 @@ binder_ussd_notify(
              * If sendUssd request is pending, consider it to be successfully
              * completed, otherwise ofono core may get confused.
              */
-            if (self->send_req) {
-                struct ofono_error err;
-                RadioRequest* req = self->send_req;
-                BinderUssdCbData* cbd = radio_request_user_data(req);
-
-                self->send_req = NULL;
-                cbd->cb(binder_error_ok(&err), cbd->data);
-                radio_request_drop(req); /* Frees BinderUssdCbData */
-            }
+            binder_ussd_complete_send(self);
 
             /*
              * Message is freed by core if dcs is 0xff, we have to
@@ -326,6 +382,13 @@ binder_ussd_remove(
 
     DBG_(self, "");
 
+    if (self->steps) {
+        ofono_info("%sussd: %u step(s), round trip avg %u ms max %u ms",
+            self->log_prefix, self->steps, (guint)
+            (self->step_total_us / self->steps / 1000),
+            (guint) (self->step_max_us / 1000));
+    }
+
     if (self->register_id) {
         g_source_remove(self->register_id);
     }
@@ -33,6 +33,35 @@ static const char PROTO_IP_STR[] = "IP";
 static const char PROTO_IPV6_STR[] = "IPV6";
 static const char PROTO_IPV4V6_STR[] = "IPV4V6";
 
+/*
+ * Lookup tables for hex conversions: digit pairs for each byte value,
+ * so that a byte is encoded with a single 2-byte copy, and nibble values
+ * plus one for each hex digit (zero marks an invalid character).
+ */
+#define HEX_PAIRS(x) \
+    x"0" x"1" x"2" x"3" x"4" x"5" x"6" x"7" \
+    x"8" x"9" x"A" x"B" x"C" x"D" x"E" x"F"
+#define HEX_PAIRS_LC(x) \
+    x"0" x"1" x"2" x"3" x"4" x"5" x"6" x"7" \
+    x"8" x"9" x"a" x"b" x"c" x"d" x"e" x"f"
+static const char binder_hex_pairs[] =
+    HEX_PAIRS("0") HEX_PAIRS("1") HEX_PAIRS("2") HEX_PAIRS("3")
+    HEX_PAIRS("4") HEX_PAIRS("5") HEX_PAIRS("6") HEX_PAIRS("7")
+    HEX_PAIRS("8") HEX_PAIRS("9") HEX_PAIRS("A") HEX_PAIRS("B")
+    HEX_PAIRS("C") HEX_PAIRS("D") HEX_PAIRS("E") HEX_PAIRS("F");
+static const char binder_hex_pairs_lc[] =
+    HEX_PAIRS_LC("0") HEX_PAIRS_LC("1") HEX_PAIRS_LC("2") HEX_PAIRS_LC("3")
+    HEX_PAIRS_LC("4") HEX_PAIRS_LC("5") HEX_PAIRS_LC("6") HEX_PAIRS_LC("7")
+    HEX_PAIRS_LC("8") HEX_PAIRS_LC("9") HEX_PAIRS_LC("a") HEX_PAIRS_LC("b")
+    HEX_PAIRS_LC("c") HEX_PAIRS_LC("d") HEX_PAIRS_LC("e") HEX_PAIRS_LC("f");
+static const guint8 binder_hex_nibble[256] = {
+    ['0'] = 0x01, ['1'] = 0x02, ['2'] = 0x03, ['3'] = 0x04, ['4'] = 0x05,
+    ['5'] = 0x06, ['6'] = 0x07, ['7'] = 0x08, ['8'] = 0x09, ['9'] = 0x0a,
+    ['A'] = 0x0b, ['B'] = 0x0c, ['C'] = 0x0d, ['D'] = 0x0e, ['E'] = 0x0f,
+    ['F'] = 0x10, ['a'] = 0x0b, ['b'] = 0x0c, ['c'] = 0x0d, ['d'] = 0x0e,
+    ['e'] = 0x0f, ['f'] = 0x10
+};
+
 #define RADIO_ACCESS_FAMILY_GSM \
     (RAF_GSM|RAF_GPRS|RAF_EDGE)
 #define RADIO_ACCESS_FAMILY_UMTS \
@@ -42,15 +71,21 @@ static const char PROTO_IPV4V6_STR[] = "IPV4V6";
 #define RADIO_ACCESS_FAMILY_NR \
     (RAF_NR)
 
+/*
+ * Strings for unknown enum values. There are only a few of those in
+ * practice, and the same ones keep showing up, so they are interned
+ * rather than allocated (and pooled) every time.
+ */
 static
 const char*
-binder_pool_string(
-    char* str)
+binder_intern_int(
+    const char* format,
+    int value)
 {
-    GUtilIdlePool* pool = gutil_idle_pool_get(&binder_util_pool);
+    char buf[32];
 
-    gutil_idle_pool_add(pool, str, g_free);
-    return str;
+    snprintf(buf, sizeof(buf), format, value);
+    return g_intern_string(buf);
 }
 
 RADIO_ACCESS_NETWORK
@@ -457,7 +492,7 @@ binder_ofono_access_technology_string(
     case OFONO_ACCESS_TECHNOLOGY_EUTRA_NR:
         return "nr";
     }
-    return binder_pool_string(g_strdup_printf("%d (?)", act));
+    return binder_intern_int("%d (?)", act);
 }
 
 const char*
@@ -487,7 +522,7 @@ binder_radio_state_string(
     RADIO_STATE_(UNAVAILABLE);
     RADIO_STATE_(ON);
     }
-    return binder_pool_string(g_strdup_printf("%d (?)", state));
+    return binder_intern_int("%d (?)", state);
 }
 
 const char*
@@ -582,7 +617,7 @@ binder_radio_error_string(
     RADIO_ERROR_STR_(OEM_ERROR_25);
     }
 
-    return binder_pool_string(g_strdup_printf("%d", error));
+    return binder_intern_int("%d", error);
 }
 
 enum ofono_access_technology
@@ -654,15 +689,75 @@ binder_encode_hex(
 {
     char *out = g_new(char, size * 2 + 1);
 
-    ofono_encode_hex(in, size, out);
+    binder_encode_hex_buf(in, size, out);
     return out;
 }
 
+static
+void
+binder_hex_encode(
+    const guint8* in,
+    gsize size,
+    char* out,
+    const char* pairs)
+{
+    const guint8* end = in + size;
+
+    while (in < end) {
+        memcpy(out, pairs + 2 * (*in++), 2);
+        out += 2;
+    }
+    *out = 0;
+}
+
+void
+binder_encode_hex_buf(
+    const void* in,
+    guint size,
+    char* out)
+{
+    binder_hex_encode(in, size, out, binder_hex_pairs);
+}
+
+static
+gboolean
+binder_hex_decode(
+    const char* hex,
+    guint len,
+    guint8* out)
+{
+    const guint8* in = (const guint8*) hex;
+    const guint8* end = in + len;
+
+    while (in < end) {
+        const guint8 hi = binder_hex_nibble[in[0]];
+        const guint8 lo = binder_hex_nibble[in[1]];
+
+        if (G_UNLIKELY(!hi || !lo)) {
+            return FALSE;
+        }
+        *out++ = ((hi - 1) << 4) | (lo - 1);
+        in += 2;
+    }
+    return TRUE;
+}
+
 void*
 binder_decode_hex(
     const char* hex,
     int len,
     guint* out_size)
+{
+    return binder_decode_hex_buf(hex, len, NULL, 0, out_size);
+}
+
+void*
+binder_decode_hex_buf(
+    const char* hex,
+    int len,
+    void* buf,
+    guint buf_size,
+    guint* out_size)
 {
     void* out = NULL;
     guint size = 0;
@@ -673,9 +768,11 @@ binder_decode_hex(
         }
         if (len > 0 && !(len & 1)) {
             size = len/2;
-            out = g_malloc(size);
-            if (!gutil_hex2bin(hex, len, out)) {
-                g_free(out);
+            out = (size <= buf_size) ? buf : g_malloc(size);
+            if (!binder_hex_decode(hex, len, out)) {
+                if (out != buf) {
+                    g_free(out);
+                }
                 out = NULL;
                 size = 0;
             }
@@ -696,6 +793,9 @@ binder_print_strv(
         return NULL;
     } else if (!strv[0]) {
         return binder_empty_str;
+    } else if (!strv[1]) {
+        /* Nothing to join */
+        return strv[0];
     } else {
         GUtilIdlePool* pool = gutil_idle_pool_get(&binder_util_pool);
         char* str = g_strjoinv(sep, strv);
@@ -711,26 +811,42 @@ binder_print_hex(
     gsize size)
 {
     if (data && size) {
-        const guint8* bytes = data;
         GUtilIdlePool* pool = gutil_idle_pool_get(&binder_util_pool);
         char* str = g_new(char, size * 2 + 1);
-        char* ptr = str;
-        gsize i;
-
-        for (i = 0; i < size; i++) {
-            static const char hex[] = "0123456789abcdef";
-            const guint8 b = bytes[i];
 
-            *ptr++ = hex[(b >> 4) & 0xf];
-            *ptr++ = hex[b & 0xf];
-        }
-        *ptr++ = 0;
+        binder_hex_encode(data, size, str, binder_hex_pairs_lc);
         gutil_idle_pool_add(pool, str, g_free);
         return str;
     }
     return binder_empty_str;
 }
 
+guint
+binder_timeout_add_coarse(
+    guint ms,
+    GSourceFunc fn,
+    gpointer data)
+{
+    const gint64 tick = ((ms >= 1000) ? 1000 : BINDER_COARSE_TICK_MS) *
+        (gint64)1000;
+    const gint64 deadline = ((g_get_monotonic_time() + ms * (gint64)1000 +
+        tick - 1) / tick) * tick;
+    GSource* source = g_timeout_source_new(ms);
+    guint id;
+
+    /*
+     * GLib counts the interval from the time cached by the current main
+     * loop iteration, not from g_get_monotonic_time(), so the rounded
+     * interval wouldn't land exactly on the tick. The absolute deadline
+     * does.
+     */
+    g_source_set_ready_time(source, deadline);
+    g_source_set_callback(source, fn, data, NULL);
+    id = g_source_attach(source, NULL);
+    g_source_unref(source);
+    return id;
+}
+
 gboolean
 binder_submit_request(
     RadioRequestGroup* g,
@@ -770,6 +886,131 @@ binder_read_hidl_string(
     return gbinder_reader_read_hidl_string_c(&reader);
 }
 
+const char*
+binder_read_hidl_string_view(
+    const GBinderReader* args,
+    gsize* len)
+{
+    GBinderReader reader;
+
+    /* Read a single string arg without copying it */
+    gbinder_reader_copy(&reader, args);
+    return binder_hidl_string_view(gbinder_reader_read_hidl_struct(&reader,
+        GBinderHidlString), len);
+}
+
+const char*
+binder_hidl_string_view(
+    const GBinderHidlString* str,
+    gsize* len)
+{
+    if (str && str->data.str) {
+        if (len) {
+            *len = str->len;
+        }
+        return str->data.str;
+    } else {
+        /* NULL strings look empty */
+        if (len) {
+            *len = 0;
+        }
+        return str ? binder_empty_str : NULL;
+    }
+}
+
+gboolean
+binder_hidl_string_equal(
+    const GBinderHidlString* str,
+    const char* value)
+{
+    gsize len;
+    const char* view = binder_hidl_string_view(str, &len);
+    const gsize value_len = value ? strlen(value) : 0;
+
+    return view && len == value_len && !memcmp(view, value, len);
+}
+
+gboolean
+binder_hidl_string_parse_int(
+    const GBinderHidlString* str,
+    int* value)
+{
+    gsize i, len;
+    const char* view = binder_hidl_string_view(str, &len);
+
+    /* Only plain decimal numbers which fit into int, no copying */
+    if (view && len > 0 && len < 10) {
+        int n = 0;
+
+        for (i = 0; i < len; i++) {
+            if (g_ascii_isdigit(view[i])) {
+                n = n * 10 + (view[i] - '0');
+            } else {
+                return FALSE;
+            }
+        }
+        if (value) {
+            *value = n;
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
+gboolean
+binder_hidl_string_split_equal(
+    const GBinderHidlString* str,
+    char sep,
+    char* const* strv)
+{
+    gsize len;
+    const char* ptr = binder_hidl_string_view(str, &len);
+    const char* end = ptr + len;
+
+    /* Same as gutil_strv_equal(g_strsplit(str, sep, -1), strv) */
+    if (!len) {
+        return !strv || !strv[0];
+    } else if (strv) {
+        while (*strv) {
+            const char* next = memchr(ptr, sep, end - ptr);
+            const gsize n = (next ? next : end) - ptr;
+
+            if (strlen(*strv) != n || memcmp(*strv, ptr, n)) {
+                return FALSE;
+            }
+            strv++;
+            if (next) {
+                ptr = next + 1;
+            } else {
+                return !*strv;
+            }
+        }
+    }
+    return FALSE;
+}
+
+gboolean
+binder_hidl_string_vec_equal(
+    const GBinderHidlVec* vec,
+    char* const* strv)
+{
+    const guint n = strv ? g_strv_length((char**) strv) : 0;
+
+    /* Same as gutil_strv_equal(binder_strv_from_hidl_string_vec(vec), strv) */
+    if ((vec ? vec->count : 0) == n) {
+        const GBinderHidlString* strings = n ? vec->data.ptr : NULL;
+        guint i;
+
+        for (i = 0; i < n; i++) {
+            if (!binder_hidl_string_equal(strings + i, strv[i])) {
+                return FALSE;
+            }
+        }
+        return TRUE;
+    }
+    return FALSE;
+}
+
 gboolean
 binder_read_int32(
     const GBinderReader* args,
@@ -163,6 +163,13 @@ binder_encode_hex(
     guint size)
     BINDER_INTERNAL;
 
+void
+binder_encode_hex_buf(
+    const void* in,
+    guint size,
+    char* out) /* At least size * 2 + 1 bytes */
+    BINDER_INTERNAL;
+
 void*
 binder_decode_hex(
     const char* hex,
@@ -170,6 +177,15 @@ binder_decode_hex(
     guint* out_size)
     BINDER_INTERNAL;
 
+void* /* Either buf or g_malloc'ed memory */
+binder_decode_hex_buf(
+    const char* hex,
+    int len,
+    void* buf,
+    guint buf_size,
+    guint* out_size)
+    BINDER_INTERNAL;
+
 const char*
 binder_print_strv(
     char** strv,
@@ -182,6 +198,22 @@ binder_print_hex(
     gsize size)
     BINDER_INTERNAL;
 
+/*
+ * One-shot timeout which tolerates some slack. The expiration time is
+ * rounded up to a common tick of the monotonic clock (BINDER_COARSE_TICK_MS
+ * for short timeouts, a whole second for longer ones) so that coarse timers
+ * created by different modules and slots fire together and share wakeups.
+ * The callback is expected to return G_SOURCE_REMOVE.
+ */
+#define BINDER_COARSE_TICK_MS (250)
+
+guint
+binder_timeout_add_coarse(
+    guint ms,
+    GSourceFunc fn,
+    gpointer data)
+    BINDER_INTERNAL;
+
 gboolean
 binder_submit_request(
     RadioRequestGroup* g,
@@ -202,6 +234,49 @@ binder_read_hidl_string(
     const GBinderReader* args)
     BINDER_INTERNAL;
 
+/*
+ * Borrowed views of HIDL strings. The pointers point into the parcel
+ * and remain valid for as long as the reader data is alive, i.e. until
+ * the response or indication callback returns. NULL strings are seen
+ * as empty.
+ */
+const char*
+binder_read_hidl_string_view(
+    const GBinderReader* args,
+    gsize* len)
+    BINDER_INTERNAL;
+
+const char*
+binder_hidl_string_view(
+    const GBinderHidlString* str,
+    gsize* len)
+    BINDER_INTERNAL;
+
+gboolean
+binder_hidl_string_equal(
+    const GBinderHidlString* str,
+    const char* value)
+    BINDER_INTERNAL;
+
+gboolean
+binder_hidl_string_parse_int(
+    const GBinderHidlString* str,
+    int* value)
+    BINDER_INTERNAL;
+
+gboolean
+binder_hidl_string_split_equal(
+    const GBinderHidlString* str,
+    char sep,
+    char* const* strv)
+    BINDER_INTERNAL;
+
+gboolean
+binder_hidl_string_vec_equal(
+    const GBinderHidlVec* vec,
+    char* const* strv)
+    BINDER_INTERNAL;
+
 gboolean
 binder_read_int32(
     const GBinderReader* args,
@@ -16,6 +16,9 @@
 #include "binder_log.h"
 #include "binder_modem.h"
 #include "binder_ims_reg.h"
+#include "binder_retry.h"
+#include "binder_ss_cache.h"
+#include "binder_stats.h"
 #include "binder_util.h"
 #include "binder_voicecall.h"
 
@@ -41,7 +44,10 @@
 #include <gutil_ring.h>
 #include <gutil_strv.h>
 
+#include <string.h>
+
 #define VOICECALL_BLOCK_TIMEOUT_MS (5*1000)
+#define VOICECALL_CLCC_RETRY_MAX_MS (8*1000)
 
 enum binder_voicecall_events {
     VOICECALL_EVENT_CALL_STATE_CHANGED,
@@ -58,15 +64,39 @@ enum binder_voicecall_ext_events {
     VOICECALL_EXT_EVENT_COUNT
 };
 
+typedef struct binder_voicecall_info {
+    struct ofono_call oc;
+    BinderExtCall* ext; /* Not a ref */
+} BinderVoiceCallInfo;
+
+/*
+ * No more than 7 calls at a time, see 3GPP TS 22.084. That's per source
+ * though, the list merges the IRadio calls with the ext ones.
+ */
+#define BINDER_VOICECALL_MAX_SOURCE_CALLS (7)
+#define BINDER_VOICECALL_MAX_CALLS (2 * BINDER_VOICECALL_MAX_SOURCE_CALLS)
+
+typedef struct binder_voicecall_list {
+    guint count;
+    BinderVoiceCallInfo call[BINDER_VOICECALL_MAX_CALLS]; /* Sorted by id */
+} BinderVoiceCallList;
+
 typedef struct binder_voicecall {
     struct ofono_voicecall* vc;
     char* log_prefix;
-    GSList* calls;
+    BinderVoiceCallList calls;
     BinderExtCall* ext;
+    BinderExtCallList* ext_calls; /* The last one we have seen */
     BinderImsReg* ims_reg;
+    BinderSsCache* ss_cache;
+    BinderStats* stats; /* Not a ref */
+    BinderStatsCallInfo setup; /* Call being set up, if started */
+    guint setup_id;     /* Its ofono id, zero until it's seen by CLCC */
+    gint64 clcc_time;   /* When the call list being handled arrived */
     RadioRequestGroup* g;
     ofono_voicecall_cb_t cb;
     void* data;
+    BinderRetry clcc_retry;
     GUtilIntArray* local_release_ids;
     GUtilIdleQueue* idleq;
     GUtilRing* dtmf_queue;
@@ -74,7 +104,13 @@ typedef struct binder_voicecall {
     GUtilInts* remote_hangup_reasons;
     RadioRequest* send_dtmf_req;
     RadioRequest* clcc_poll_req;
+    guint clcc_poll_id;
+    guint clcc_poll_window_ms;
+    gboolean clcc_poll_again;
     guint ext_send_dtmf_id;
+    guint dtmf_count;       /* Tones in flight */
+    gint64 dtmf_start;      /* When they were submitted */
+    gboolean dtmf_burst;
     guint ext_req_id;
     gulong ext_event[VOICECALL_EXT_EVENT_COUNT];
     gulong radio_event[VOICECALL_EVENT_COUNT];
@@ -96,11 +132,6 @@ typedef struct binder_voicecall_lastcause_data {
     guint cid;
 } BinderVoiceCallLastCauseData;
 
-typedef struct binder_voicecall_info {
-    struct ofono_call oc;
-    BinderExtCall* ext; /* Not a ref */
-} BinderVoiceCallInfo;
-
 #define ANSWER_FLAGS BINDER_EXT_CALL_ANSWER_NO_FLAGS
 
 #define DBG_(self,fmt,args...) DBG("%s" fmt, (self)->log_prefix, ##args)
@@ -117,6 +148,16 @@ void
 binder_voicecall_clear_dtmf_queue(
     BinderVoiceCall* self);
 
+static
+void
+binder_voicecall_clcc_submit(
+    BinderVoiceCall* self);
+
+static
+gboolean
+binder_voicecall_clcc_poll_timeout(
+    gpointer user_data);
+
 static inline BinderVoiceCall*
 binder_voicecall_get_data(struct ofono_voicecall* vc)
     { return ofono_voicecall_get_data(vc); }
@@ -153,6 +194,7 @@ binder_voicecall_clear_dtmf_queue(
     BinderVoiceCall* self)
 {
     gutil_ring_clear(self->dtmf_queue);
+    self->dtmf_count = 0;
     if (self->ext_send_dtmf_id) {
         binder_ext_call_cancel(self->ext, self->ext_send_dtmf_id);
         self->ext_send_dtmf_id = 0;
@@ -207,31 +249,65 @@ binder_voicecall_ofono_call_equal(
 }
 
 static
-gint
-binder_voicecall_info_compare(
-    gconstpointer a,
-    gconstpointer b)
+BinderVoiceCallInfo*
+binder_voicecall_list_find(
+    BinderVoiceCallList* list,
+    guint call_id)
 {
-    const guint ca = ((const BinderVoiceCallInfo*)a)->oc.id;
-    const guint cb = ((const BinderVoiceCallInfo*)b)->oc.id;
+    guint i;
+
+    for (i = 0; i < list->count; i++) {
+        BinderVoiceCallInfo* call = list->call + i;
 
-    return (ca < cb) ? -1 : (ca > cb) ? 1 : 0;
+        if (call->oc.id == call_id) {
+            return call;
+        }
+    }
+    return NULL;
+}
+
+static
+BinderVoiceCallInfo*
+binder_voicecall_list_add(
+    BinderVoiceCallList* list,
+    guint call_id)
+{
+    guint i = 0;
+
+    /* Keep the list sorted by id, reuse the entry if the id is there */
+    while (i < list->count && list->call[i].oc.id < call_id) {
+        i++;
+    }
+    if (i < list->count && list->call[i].oc.id == call_id) {
+        return list->call + i;
+    } else if (list->count < BINDER_VOICECALL_MAX_CALLS) {
+        memmove(list->call + i + 1, list->call + i,
+            sizeof(list->call[0]) * (list->count - i));
+        list->count++;
+        return list->call + i;
+    } else {
+        ofono_warn("Too many calls, dropping call %u", call_id);
+        return NULL;
+    }
 }
 
 static
 void
-binder_voicecall_info_free(
-    gpointer data)
+binder_voicecall_list_copy(
+    BinderVoiceCallList* dest,
+    const BinderVoiceCallList* src)
 {
-    g_slice_free(BinderVoiceCallInfo, data);
+    /* Only copy the entries in use */
+    dest->count = src->count;
+    memcpy(dest->call, src->call, sizeof(src->call[0]) * src->count);
 }
 
 static
-BinderVoiceCallInfo*
-binder_voicecall_info_new(
+void
+binder_voicecall_info_init(
+    BinderVoiceCallInfo* call,
     const RadioCall* rc)
 {
-    BinderVoiceCallInfo* call = g_slice_new0(BinderVoiceCallInfo);
     struct ofono_call* oc = &call->oc;
 
     ofono_call_init(oc);
@@ -259,16 +335,16 @@ binder_voicecall_info_new(
     DBG("[id=%d,status=%d,type=%d,number=%s,name=%s]", oc->id,
         oc->status, oc->type, oc->phone_number.number, oc->name);
 
-    return call;
+    call->ext = NULL;
 }
 
 static
-BinderVoiceCallInfo*
-binder_voicecall_info_ext_new(
+void
+binder_voicecall_info_init_ext(
+    BinderVoiceCallInfo* call,
     const BinderExtCallInfo* ci,
     BinderExtCall* ext)
 {
-    BinderVoiceCallInfo* call = g_slice_new0(BinderVoiceCallInfo);
     struct ofono_call* oc = &call->oc;
 
     ofono_call_init(oc);
@@ -297,30 +373,13 @@ binder_voicecall_info_ext_new(
         oc->status, oc->type, oc->phone_number.number, oc->name);
 
     call->ext = ext;
-    return call;
-}
-
-static
-const BinderVoiceCallInfo*
-binder_voicecall_list_find_call_with_id(
-    GSList* list,
-    guint call_id)
-{
-    for (GSList* l = list; l; l = l->next) {
-        const BinderVoiceCallInfo* call = l->data;
-
-        if (call->oc.id == call_id) {
-            return call;
-        }
-    }
-    return NULL;
 }
 
 static
-GSList*
+void
 binder_voicecall_merge_call_lists(
     BinderVoiceCall* self,
-    GSList* new_list,
+    BinderVoiceCallList* new_list,
     gboolean add_ext)
 {
     /*
@@ -329,23 +388,23 @@ binder_voicecall_merge_call_lists(
      * component before current calls list is going to
      * be replaced by the new list.
      */
-    if (!self->ext)
-        return new_list;
+    if (self->ext) {
+        guint i;
 
-    for (GSList* l = self->calls; l; l = l->next) {
-        const BinderVoiceCallInfo* call = l->data;
+        for (i = 0; i < self->calls.count; i++) {
+            const BinderVoiceCallInfo* call = self->calls.call + i;
 
-        if (!!call->ext == add_ext) {
-            if (binder_voicecall_list_find_call_with_id(new_list, call->oc.id))
-                continue;
+            if (!!call->ext == add_ext &&
+                !binder_voicecall_list_find(new_list, call->oc.id)) {
+                BinderVoiceCallInfo* dest =
+                    binder_voicecall_list_add(new_list, call->oc.id);
 
-            new_list = g_slist_insert_sorted(new_list,
-                g_slice_dup(BinderVoiceCallInfo, call),
-                binder_voicecall_info_compare);
+                if (dest) {
+                    *dest = *call;
+                }
+            }
         }
     }
-
-    return new_list;
 }
 
 static
@@ -354,12 +413,10 @@ binder_voicecall_have_ext_call(
     BinderVoiceCall* self)
 {
     if (self->ext) {
-        GSList* l;
-
-        for (l = self->calls; l; l = l->next) {
-            const BinderVoiceCallInfo* call = l->data;
+        guint i;
 
-            if (call->ext) {
+        for (i = 0; i < self->calls.count; i++) {
+            if (self->calls.call[i].ext) {
                 return TRUE;
             }
         }
@@ -373,14 +430,14 @@ binder_voicecall_find_call_with_status(
     BinderVoiceCall* self,
     enum ofono_call_status status)
 {
-    GSList* l;
+    guint i;
 
     /*
      * Normally, the list is either empty or very short, there's
      * nothing to optimize.
      */
-    for (l = self->calls; l; l = l->next) {
-        const BinderVoiceCallInfo* call = l->data;
+    for (i = 0; i < self->calls.count; i++) {
+        const BinderVoiceCallInfo* call = self->calls.call + i;
 
         if (call->oc.status == status) {
             return call;
@@ -389,37 +446,13 @@ binder_voicecall_find_call_with_status(
     return NULL;
 }
 
-static
-GSList*
-binder_voicecall_find_call_link_with_id(
-    BinderVoiceCall* self,
-    guint call_id)
-{
-    GSList* l;
-
-    /*
-     * Normally, the list is either empty or very short, there's
-     * nothing to optimize.
-     */
-    for (l = self->calls; l; l = l->next) {
-        const BinderVoiceCallInfo* call = l->data;
-
-        if (call->oc.id == call_id) {
-            return l;
-        }
-    }
-    return NULL;
-}
-
 static
 const BinderVoiceCallInfo*
 binder_voicecall_find_call_with_id(
     BinderVoiceCall* self,
     unsigned int call_id)
 {
-    GSList* l = binder_voicecall_find_call_link_with_id(self, call_id);
-
-    return l ? l->data : NULL;
+    return binder_voicecall_list_find(&self->calls, call_id);
 }
 
 static
@@ -441,12 +474,15 @@ binder_voicecall_remove_call_id(
     BinderVoiceCall* self,
     guint call_id)
 {
-    GSList* l = binder_voicecall_find_call_link_with_id(self, call_id);
+    BinderVoiceCallList* list = &self->calls;
+    BinderVoiceCallInfo* call = binder_voicecall_list_find(list, call_id);
+
+    if (call) {
+        const guint i = call - list->call;
 
-    if (l) {
         DBG_(self, "removed call %u", call_id);
-        binder_voicecall_info_free(l->data);
-        self->calls = g_slist_delete_link(self->calls, l);
+        list->count--;
+        memmove(call, call + 1, sizeof(*call) * (list->count - i));
     }
 }
 
@@ -566,25 +602,105 @@ binder_voicecall_lastcause_cb(
     ofono_voicecall_disconnected(vc, cid, OFONO_DISCONNECT_REASON_ERROR, NULL);
 }
 
+static
+void
+binder_voicecall_setup_start(
+    BinderVoiceCall* self,
+    gboolean incoming,
+    gint64 time)
+{
+    memset(&self->setup, 0, sizeof(self->setup));
+    self->setup.incoming = incoming;
+    self->setup.t[BINDER_STATS_CALL_START] = time;
+    self->setup_id = 0;
+}
+
+static
+void
+binder_voicecall_setup_mark(
+    BinderVoiceCall* self,
+    BINDER_STATS_CALL_STAGE stage,
+    gint64 time)
+{
+    BinderStatsCallInfo* setup = &self->setup;
+
+    if (setup->t[BINDER_STATS_CALL_START] && !setup->t[stage]) {
+        setup->t[stage] = time ? time : g_get_monotonic_time();
+    }
+}
+
+static
+void
+binder_voicecall_setup_done(
+    BinderVoiceCall* self)
+{
+    BinderStatsCallInfo* setup = &self->setup;
+    const gint64 start = setup->t[BINDER_STATS_CALL_START];
+
+    if (start) {
+        const gint64 alerting = setup->t[BINDER_STATS_CALL_ALERTING];
+
+        DBG_(self, "%s call %u set up in %d ms", setup->incoming ? "mt" :
+            "mo", self->setup_id, alerting ? (int)
+            ((alerting - start) / 1000) : -1);
+        binder_stats_add_call(self->stats, setup);
+        memset(setup, 0, sizeof(*setup));
+        self->setup_id = 0;
+    }
+}
+
+static
+void
+binder_voicecall_setup_notify(
+    BinderVoiceCall* self,
+    const struct ofono_call* oc)
+{
+    if (self->setup.t[BINDER_STATS_CALL_START] && oc->id == self->setup_id) {
+        binder_voicecall_setup_mark(self, BINDER_STATS_CALL_NOTIFY, 0);
+        switch (oc->status) {
+        case OFONO_CALL_STATUS_ALERTING:
+        case OFONO_CALL_STATUS_INCOMING:
+        case OFONO_CALL_STATUS_WAITING:
+            binder_voicecall_setup_mark(self, BINDER_STATS_CALL_ALERTING, 0);
+            break;
+        case OFONO_CALL_STATUS_ACTIVE:
+            binder_voicecall_setup_mark(self, BINDER_STATS_CALL_ACTIVE, 0);
+            binder_voicecall_setup_done(self);
+            break;
+        case OFONO_CALL_STATUS_HELD:
+        case OFONO_CALL_STATUS_DIALING:
+        case OFONO_CALL_STATUS_DISCONNECTED:
+            break;
+        }
+    }
+}
+
 static
 void
 binder_voicecall_set_calls(
     BinderVoiceCall* self,
-    GSList* list)
+    const BinderVoiceCallList* list)
 {
     struct ofono_voicecall* vc = self->vc;
-    GSList* n = list;
-    GSList* o = self->calls;
+    const BinderVoiceCallList* old = &self->calls;
+    const gint64 received = self->clcc_time ? self->clcc_time :
+        g_get_monotonic_time();
+    guint n = 0, o = 0;
 
     /* Note: the lists are sorted by id */
-    while (n || o) {
-        const BinderVoiceCallInfo* nc = n ? n->data : NULL;
-        const BinderVoiceCallInfo* oc = o ? o->data : NULL;
+    while (n < list->count || o < old->count) {
+        const BinderVoiceCallInfo* nc = (n < list->count) ?
+            (list->call + n) : NULL;
+        const BinderVoiceCallInfo* oc = (o < old->count) ?
+            (old->call + o) : NULL;
 
         if (oc && (!nc || (nc->oc.id > oc->oc.id))) {
             const guint id = oc->oc.id;
 
             /* old call is gone */
+            if (id == self->setup_id) {
+                binder_voicecall_setup_done(self);
+            }
             if (gutil_int_array_remove_all_fast(self->local_release_ids, id)) {
                 ofono_voicecall_disconnected(vc, id,
                     OFONO_DISCONNECT_REASON_LOCAL_HANGUP, NULL);
@@ -604,12 +720,27 @@ binder_voicecall_set_calls(
             }
 
             binder_voicecall_clear_dtmf_queue(self);
-            o = o->next;
+            o++;
 
         } else if (nc && (!oc || (nc->oc.id < oc->oc.id))) {
             /* new call, signal it */
             if (nc->oc.type == OFONO_CALL_MODE_VOICE) {
-                ofono_voicecall_notify(vc, &nc->oc);
+                const struct ofono_call* c = &nc->oc;
+
+                if (!self->setup.t[BINDER_STATS_CALL_START] &&
+                    (c->status == OFONO_CALL_STATUS_INCOMING ||
+                     c->status == OFONO_CALL_STATUS_WAITING)) {
+                    /* Missed the indication, start from here */
+                    binder_voicecall_setup_start(self, TRUE, received);
+                }
+                if (self->setup.t[BINDER_STATS_CALL_START] &&
+                    !self->setup_id) {
+                    self->setup_id = c->id;
+                    binder_voicecall_setup_mark(self,
+                        BINDER_STATS_CALL_CLCC, received);
+                }
+                ofono_voicecall_notify(vc, c);
+                binder_voicecall_setup_notify(self, c);
                 if (self->cb) {
                     ofono_voicecall_cb_t cb = self->cb;
                     void* cbdata = self->data;
@@ -621,20 +752,25 @@ binder_voicecall_set_calls(
                 }
             }
 
-            n = n->next;
+            n++;
 
         } else {
             /* Both old and new call exist */
             if (!binder_voicecall_ofono_call_equal(&nc->oc, &oc->oc)) {
                 ofono_voicecall_notify(vc, &nc->oc);
+                binder_voicecall_setup_notify(self, &nc->oc);
             }
-            n = n->next;
-            o = o->next;
+            n++;
+            o++;
         }
     }
 
-    g_slist_free_full(self->calls, binder_voicecall_info_free);
-    self->calls = list;
+    binder_voicecall_list_copy(&self->calls, list);
+
+    /* Incoming call indication which didn't produce a call */
+    if (self->setup.incoming && !self->setup_id) {
+        memset(&self->setup, 0, sizeof(self->setup));
+    }
 }
 
 static
@@ -648,8 +784,10 @@ binder_voicecall_clcc_poll_cb(
     gpointer user_data)
 {
     BinderVoiceCall* self = user_data;
-    GSList* list = NULL;
+    BinderVoiceCallList list;
 
+    list.count = 0;
+    self->clcc_time = g_get_monotonic_time();
     GASSERT(self->clcc_poll_req == req);
     radio_request_unref(self->clcc_poll_req);
     self->clcc_poll_req = NULL;
@@ -666,12 +804,13 @@ binder_voicecall_clcc_poll_cb(
                     gbinder_reader_read_hidl_type_vec(&reader,
                         RadioCall, &count);
 
-                if (calls) {
-                    /* Build sorted list */
-                    for (i = 0; i < count; i++) {
-                        list = g_slist_insert_sorted(list,
-                            binder_voicecall_info_new(calls + i),
-                            binder_voicecall_info_compare);
+                /* Build sorted list */
+                for (i = 0; calls && i < count; i++) {
+                    BinderVoiceCallInfo* call =
+                        binder_voicecall_list_add(&list, calls[i].index);
+
+                    if (call) {
+                        binder_voicecall_info_init(call, calls + i);
                     }
                 }
             } else if (resp == RADIO_RESP_GET_CURRENT_CALLS_1_2) {
@@ -679,12 +818,13 @@ binder_voicecall_clcc_poll_cb(
                     gbinder_reader_read_hidl_type_vec(&reader,
                         RadioCall_1_2, &count);
 
-                if (calls) {
-                    /* Build sorted list */
-                    for (i = 0; i < count; i++) {
-                        list = g_slist_insert_sorted(list,
-                            binder_voicecall_info_new(&calls[i].base),
-                            binder_voicecall_info_compare);
+                /* Build sorted list */
+                for (i = 0; calls && i < count; i++) {
+                    BinderVoiceCallInfo* call =
+                        binder_voicecall_list_add(&list, calls[i].base.index);
+
+                    if (call) {
+                        binder_voicecall_info_init(call, &calls[i].base);
                     }
                 }
             } else {
@@ -701,9 +841,20 @@ binder_voicecall_clcc_poll_cb(
     }
 
     /* Merge the ongoing ext calls since IRadio may not report them */
-    list = binder_voicecall_merge_call_lists(self, list, TRUE /*add_ext*/);
-
-    binder_voicecall_set_calls(self, list);
+    binder_voicecall_merge_call_lists(self, &list, TRUE /*add_ext*/);
+    binder_voicecall_set_calls(self, &list);
+    self->clcc_time = 0;
+
+    /* Something may have changed while we were waiting for the list */
+    if (self->clcc_poll_again) {
+        self->clcc_poll_again = FALSE;
+        if (self->clcc_poll_window_ms) {
+            self->clcc_poll_id = g_timeout_add(self->clcc_poll_window_ms,
+                binder_voicecall_clcc_poll_timeout, self);
+        } else {
+            binder_voicecall_clcc_submit(self);
+        }
+    }
 }
 
 static
@@ -716,13 +867,16 @@ binder_voicecall_clcc_retry(
     const GBinderReader* args,
     void* user_data)
 {
+    BinderVoiceCall* self = user_data;
+
     if (status == RADIO_TX_STATUS_OK) {
         switch (error) {
         case RADIO_ERROR_NONE:
         case RADIO_ERROR_RADIO_NOT_AVAILABLE:
+            binder_retry_reset(&self->clcc_retry);
             return FALSE;
         default:
-            return TRUE;
+            return binder_retry_request(&self->clcc_retry, req, -1);
         }
     }
     return FALSE;
@@ -730,22 +884,50 @@ binder_voicecall_clcc_retry(
 
 static
 void
-binder_voicecall_clcc_poll(
+binder_voicecall_clcc_submit(
     BinderVoiceCall* self)
 {
-    if (!self->clcc_poll_req) {
-        /* getCurrentCalls(int32 serial); */
-        RadioRequest* req = radio_request_new2(self->g,
-            RADIO_REQ_GET_CURRENT_CALLS, NULL,
-            binder_voicecall_clcc_poll_cb, NULL, self);
+    /* getCurrentCalls(int32 serial); */
+    RadioRequest* req = radio_request_new2(self->g,
+        RADIO_REQ_GET_CURRENT_CALLS, NULL,
+        binder_voicecall_clcc_poll_cb, NULL, self);
 
-        radio_request_set_retry(req, BINDER_RETRY_MS, -1);
-        radio_request_set_retry_func(req, binder_voicecall_clcc_retry);
-        if (radio_request_submit(req)) {
-            self->clcc_poll_req = req;
-        } else {
-            radio_request_unref(req);
+    radio_request_set_retry(req, BINDER_RETRY_MS, -1);
+    radio_request_set_retry_func(req, binder_voicecall_clcc_retry);
+    if (radio_request_submit(req)) {
+        self->clcc_poll_req = req;
+    } else {
+        radio_request_unref(req);
+    }
+}
+
+static
+gboolean
+binder_voicecall_clcc_poll_timeout(
+    gpointer user_data)
+{
+    BinderVoiceCall* self = user_data;
+
+    self->clcc_poll_id = 0;
+    binder_voicecall_clcc_submit(self);
+    return G_SOURCE_REMOVE;
+}
+
+static
+void
+binder_voicecall_clcc_poll(
+    BinderVoiceCall* self)
+{
+    if (self->clcc_poll_req || self->clcc_poll_id) {
+        /*
+         * The list being fetched may not reflect this change. Poll
+         * again when it arrives, collapsing all triggers into one.
+         */
+        if (self->clcc_poll_req) {
+            self->clcc_poll_again = TRUE;
         }
+    } else {
+        binder_voicecall_clcc_submit(self);
     }
 }
 
@@ -862,6 +1044,8 @@ binder_voicecall_dial_cb(
     if (status == RADIO_TX_STATUS_OK) {
         if (error == RADIO_ERROR_NONE) {
             if (resp == RADIO_RESP_DIAL) {
+                binder_voicecall_setup_mark(self,
+                    BINDER_STATS_CALL_DIAL_DONE, 0);
                 if (self->cb) {
                     /*
                      * CLCC will update the oFono call list with
@@ -890,6 +1074,10 @@ binder_voicecall_dial_cb(
 
         self->cb = NULL;
         self->data = NULL;
+        if (!self->setup_id) {
+            /* Record how far the failed dial got */
+            binder_voicecall_setup_done(self);
+        }
         cb(binder_error_failure(&err), cbdata);
     }
 }
@@ -964,6 +1152,8 @@ binder_voicecall_dial(
 
     ofono_info("dialing \"%s\"", phstr);
     DBG_(self, "%s,%d,0", phstr, clir);
+    binder_voicecall_setup_done(self);
+    binder_voicecall_setup_start(self, FALSE, g_get_monotonic_time());
 
     binder_ext_call_cancel(self->ext, self->ext_req_id);
     if (binder_voicecall_can_ext_dial(self)) {
@@ -1141,15 +1331,18 @@ binder_voicecall_hangup(
 {
     BinderVoiceCall* self = binder_voicecall_get_data(vc);
     BinderVoiceCallCbData* cbd = NULL;
-    GSList* l;
+    BinderVoiceCallList calls;
+    guint i;
 
     /*
      * The idea is that we submit (potentially) multiple hangup
      * requests and invoke the callback after the last request
-     * has completed (pending call count becomes zero).
+     * has completed (pending call count becomes zero). Iterate
+     * over a copy, the list may change while we are doing that.
      */
-    for (l = self->calls; l; l = l->next) {
-        const BinderVoiceCallInfo* call = l->data;
+    binder_voicecall_list_copy(&calls, &self->calls);
+    for (i = 0; i < calls.count; i++) {
+        const BinderVoiceCallInfo* call = calls.call + i;
         const guint id = call->oc.id;
 
         if (!filter || filter(call)) {
@@ -1257,11 +1450,41 @@ binder_voicecall_call_state_changed_event(
     BinderVoiceCall* self = user_data;
 
     GASSERT(code == RADIO_IND_CALL_STATE_CHANGED);
+    if (!self->setup.t[BINDER_STATS_CALL_START] && !self->calls.count) {
+        /* Most likely an incoming call */
+        binder_voicecall_setup_start(self, TRUE, g_get_monotonic_time());
+    }
+    binder_voicecall_setup_mark(self, BINDER_STATS_CALL_STATE_IND, 0);
 
     /* Just need to request the call list again */
     binder_voicecall_clcc_poll(self);
 }
 
+/*
+ * MO intermediate result codes (3GPP TS 27.007 +CSSI) telling that
+ * forwarding or barring is active, which the cached query results
+ * may not know about.
+ */
+static
+void
+binder_voicecall_ssn_mo_check_cache(
+    BinderVoiceCall* self,
+    int code)
+{
+    switch (code) {
+    case 0: /* Unconditional call forwarding is active */
+    case 1: /* Some of the conditional call forwardings are active */
+        binder_ss_cache_invalidate(self->ss_cache,
+            BINDER_SS_CACHE_CALL_FORWARDING);
+        break;
+    case 5: /* Outgoing calls are barred */
+    case 6: /* Incoming calls are barred */
+        binder_ss_cache_invalidate(self->ss_cache,
+            BINDER_SS_CACHE_CALL_BARRING);
+        break;
+    }
+}
+
 static
 void
 binder_voicecall_ext_supp_svc_notification(
@@ -1289,6 +1512,7 @@ binder_voicecall_ext_supp_svc_notification(
     } else {
         /* MO intermediate result code */
         DBG_(self, "MO code: %d, index: %d",  ssn->code, ssn->index);
+        binder_voicecall_ssn_mo_check_cache(self, ssn->code);
         ofono_voicecall_ssn_mo_notify(self->vc, 0, ssn->code, ssn->index);
     }
 }
@@ -1326,6 +1550,7 @@ binder_voicecall_supp_svc_notification(
                 ssn->index, &ph);
         } else {
             /* MO intermediate result code */
+            binder_voicecall_ssn_mo_check_cache(self, ssn->code);
             ofono_voicecall_ssn_mo_notify(self->vc, 0, ssn->code, ssn->index);
         }
     }
@@ -1363,6 +1588,9 @@ binder_voicecall_answer(
         binder_voicecall_find_call_with_status(self,
             OFONO_CALL_STATUS_INCOMING);
 
+    if (self->setup.incoming) {
+        binder_voicecall_setup_mark(self, BINDER_STATS_CALL_ANSWER, 0);
+    }
     if (call && call->ext) {
         DBG_(self, "answering ext call");
         if (!binder_voicecall_ext_answer(self, cbd)) {
@@ -1378,6 +1606,21 @@ binder_voicecall_answer(
     binder_voicecall_cbd_unref(cbd);
 }
 
+static
+void
+binder_voicecall_dtmf_done(
+    BinderVoiceCall* self)
+{
+    if (self->dtmf_count) {
+        const gint64 us = g_get_monotonic_time() - self->dtmf_start;
+
+        DBG_(self, "%u tone(s) in %d.%03d ms, %d us per tone",
+            self->dtmf_count, (int)(us / 1000), (int)(us % 1000),
+            (int)(us / self->dtmf_count));
+        self->dtmf_count = 0;
+    }
+}
+
 static
 void
 binder_voicecall_send_dtmf_cb(
@@ -1393,6 +1636,7 @@ binder_voicecall_send_dtmf_cb(
     GASSERT(self->send_dtmf_req == req);
     radio_request_unref(self->send_dtmf_req);
     self->send_dtmf_req = NULL;
+    binder_voicecall_dtmf_done(self);
 
     if (status == RADIO_TX_STATUS_OK) {
         if (error == RADIO_ERROR_NONE) {
@@ -1421,6 +1665,7 @@ binder_voicecall_send_dtmf_ext_cb(
     BinderVoiceCall* self = user_data;
 
     self->ext_send_dtmf_id = 0;
+    binder_voicecall_dtmf_done(self);
     if (result == BINDER_EXT_CALL_RESULT_OK) {
         /* Send the next one */
         binder_voicecall_send_one_dtmf(self);
@@ -1430,19 +1675,56 @@ binder_voicecall_send_dtmf_ext_cb(
     }
 }
 
+static
+gboolean
+binder_voicecall_send_dtmf_burst(
+    BinderVoiceCall* self,
+    gint n)
+{
+    char* tones = g_malloc(n + 1);
+    gint i;
+
+    /* Hand the whole queue over to the extension */
+    for (i = 0; i < n; i++) {
+        tones[i] = (char)GPOINTER_TO_UINT(gutil_ring_data_at(self->dtmf_queue,
+            i));
+    }
+    tones[n] = 0;
+    DBG_(self, "'%s'", tones);
+    self->ext_send_dtmf_id = binder_ext_call_send_dtmf(self->ext, tones,
+        binder_voicecall_send_dtmf_ext_cb, NULL, self);
+    g_free(tones);
+
+    if (self->ext_send_dtmf_id) {
+        gutil_ring_drop(self->dtmf_queue, n);
+        self->dtmf_count = n;
+        return TRUE;
+    } else {
+        DBG_(self, "burst not accepted, sending tones one by one");
+        return FALSE;
+    }
+}
+
 static
 void
 binder_voicecall_send_one_dtmf(
     BinderVoiceCall* self)
 {
-    if (!self->send_dtmf_req &&
-        !self->ext_send_dtmf_id &&
-        gutil_ring_size(self->dtmf_queue) > 0) {
+    const gint n = gutil_ring_size(self->dtmf_queue);
+
+    if (!self->send_dtmf_req && !self->ext_send_dtmf_id && n > 0) {
         char tone[2];
 
+        self->dtmf_start = g_get_monotonic_time();
+        if (self->dtmf_burst && self->ext && n > 1 &&
+            binder_voicecall_send_dtmf_burst(self, n)) {
+            return;
+        }
+
         tone[0] = (char)GPOINTER_TO_UINT(gutil_ring_get(self->dtmf_queue));
         tone[1] = 0;
         DBG_(self, "'%s'", tone);
+        self->dtmf_count = 1;
 
         /* If self->ext is NULL then binder_ext_call_send_dtmf is a noop */
         self->ext_send_dtmf_id = binder_ext_call_send_dtmf(self->ext, tone,
@@ -1703,27 +1985,41 @@ binder_voicecall_hangup_with_fallback(
      */
     if (self->ext) {
         gboolean use_fallback = FALSE;
-        GSList* l;
+        BinderVoiceCallList calls;
+        guint ext_ids[G_N_ELEMENTS(calls.call)];
+        guint i, n = 0;
 
-        for (l = self->calls; l; l = l->next) {
-            const BinderVoiceCallInfo* call = l->data;
+        /* Iterate over a copy, the list may change while we are at it */
+        binder_voicecall_list_copy(&calls, &self->calls);
+        for (i = 0; i < calls.count; i++) {
+            const BinderVoiceCallInfo* call = calls.call + i;
 
             if (filter(call)) {
                 const guint id = call->oc.id;
 
                 if (call->ext) {
-                    DBG_(self, "hanging up ext call id %u", id);
-                    if (binder_ext_call_hangup(call->ext, id, reason,
-                        BINDER_EXT_CALL_HANGUP_NO_FLAGS,
-                        binder_voicecall_cbd_ext_complete,
-                        binder_voicecall_cbd_destroy, cbd)) {
-                        binder_voicecall_request_submitted(cbd);
-                        continue;
-                    }
+                    ext_ids[n++] = id;
                 } else {
+                    /* Will use the fallback */
                     DBG_(self, "%s %u", radio_req_name(fallback), id);
+                    use_fallback = TRUE;
                 }
+            }
+        }
 
+        /* Hand all extension calls over at once */
+        if (n) {
+            DBG_(self, "hanging up %u ext call(s)", n);
+            if ((n == 1) ? binder_ext_call_hangup(self->ext, ext_ids[0],
+                reason, BINDER_EXT_CALL_HANGUP_NO_FLAGS,
+                binder_voicecall_cbd_ext_complete,
+                binder_voicecall_cbd_destroy, cbd) :
+                binder_ext_call_hangup_batch(self->ext, ext_ids, n,
+                reason, BINDER_EXT_CALL_HANGUP_NO_FLAGS,
+                binder_voicecall_cbd_ext_complete,
+                binder_voicecall_cbd_destroy, cbd)) {
+                binder_voicecall_request_submitted(cbd);
+            } else {
                 /* Request wasn't submitted - will use the fallback */
                 use_fallback = TRUE;
             }
@@ -1848,26 +2144,56 @@ binder_voicecall_ext_calls_changed(
     void* user_data)
 {
     BinderVoiceCall* self = user_data;
-    const BinderExtCallInfo* const* calls = binder_ext_call_get_calls(ext);
-    const BinderExtCallInfo* const* ptr = calls;
-    GSList* list = NULL;
-
-    /* binder_ext_call_get_calls never returns NULL */
-    while (*ptr) {
-        const BinderExtCallInfo* call = *ptr++;
-
-        /* We don't report multiparty calls to the core */
-        if (!(call->flags & BINDER_EXT_CALL_FLAG_MPTY)) {
-            list = g_slist_insert_sorted(list,
-                binder_voicecall_info_ext_new(call, ext),
-                binder_voicecall_info_compare);
-        }
-    }
+    BinderExtCallList* calls = binder_ext_call_get_call_list(ext);
+    BinderExtCallList* prev = self->ext_calls;
+
+    /* binder_ext_call_get_call_list never returns NULL */
+    if (prev && prev->version == calls->version) {
+        DBG_(self, "ext calls unchanged (version %u)", calls->version);
+        binder_ext_call_list_unref(calls);
+    } else {
+        BinderVoiceCallList list;
+        guint i, k = 0;
 
-    /* Merge the IRadio calls back into the list */
-    list = binder_voicecall_merge_call_lists(self, list, FALSE /*add_ext*/);
+        /* Both lists are sorted by id, walk them in one pass */
+        list.count = 0;
+        for (i = 0; i < calls->count; i++) {
+            const BinderExtCallInfo* call = calls->calls + i;
 
-    binder_voicecall_set_calls(self, list);
+            /* We don't report multiparty calls to the core */
+            if (!(call->flags & BINDER_EXT_CALL_FLAG_MPTY)) {
+                BinderVoiceCallInfo* info =
+                    binder_voicecall_list_add(&list, call->call_id);
+
+                if (info) {
+                    const BinderVoiceCallInfo* known = NULL;
+
+                    while (prev && k < prev->count &&
+                        prev->calls[k].call_id < call->call_id) {
+                        k++;
+                    }
+                    if (prev && k < prev->count &&
+                        binder_ext_call_info_equal(prev->calls + k, call)) {
+                        known = binder_voicecall_list_find(&self->calls,
+                            call->call_id);
+                    }
+
+                    /* No need to convert the calls that haven't changed */
+                    if (known && known->ext == ext) {
+                        *info = *known;
+                    } else {
+                        binder_voicecall_info_init_ext(info, call, ext);
+                    }
+                }
+            }
+        }
+
+        /* Merge the IRadio calls back into the list */
+        binder_voicecall_merge_call_lists(self, &list, FALSE /*add_ext*/);
+        binder_voicecall_set_calls(self, &list);
+        binder_ext_call_list_unref(prev);
+        self->ext_calls = calls;
+    }
 }
 
 static
@@ -1880,7 +2206,7 @@ binder_voicecall_ext_call_disconnected(
 {
     BinderVoiceCall* self = user_data;
 
-    if (binder_voicecall_find_call_link_with_id(self, call_id)) {
+    if (binder_voicecall_find_call_with_id(self, call_id)) {
         DBG_(self, "ext call %u disconnected", call_id);
         binder_voicecall_remove_call_id(self, call_id);
         binder_voicecall_clear_dtmf_queue(self);
@@ -1966,6 +2292,8 @@ binder_voicecall_probe(
     const BinderSlotConfig* cfg = &modem->config;
 
     self->log_prefix = binder_dup_prefix(modem->log_prefix);
+    binder_retry_init(&self->clcc_retry, self->log_prefix, "clcc",
+        BINDER_RETRY_MS, VOICECALL_CLCC_RETRY_MAX_MS);
     DBG_(self, "");
 
     self->vc = vc;
@@ -1976,6 +2304,10 @@ binder_voicecall_probe(
     self->local_release_ids = gutil_int_array_new();
     self->idleq = gutil_idle_queue_new();
     self->ims_reg = binder_ims_reg_ref(modem->ims);
+    self->ss_cache = modem->ss_cache;
+    self->stats = modem->stats;
+    self->clcc_poll_window_ms = cfg->clcc_poll_window_ms;
+    self->dtmf_burst = cfg->dtmf_burst;
 
     if (modem->ext && (self->ext =
         binder_ext_slot_get_interface(modem->ext,
@@ -1998,10 +2330,12 @@ binder_voicecall_remove(
     BinderVoiceCall* self = binder_voicecall_get_data(vc);
 
     DBG_(self, "");
-    g_slist_free_full(self->calls, binder_voicecall_info_free);
 
     radio_request_drop(self->send_dtmf_req);
     radio_request_drop(self->clcc_poll_req);
+    if (self->clcc_poll_id) {
+        g_source_remove(self->clcc_poll_id);
+    }
     radio_client_remove_all_handlers(self->g->client, self->radio_event);
     radio_request_group_cancel(self->g);
     radio_request_group_unref(self->g);
@@ -2016,10 +2350,12 @@ binder_voicecall_remove(
         binder_ext_call_remove_all_handlers(self->ext, self->ext_event);
         binder_ext_call_cancel(self->ext, self->ext_send_dtmf_id);
         binder_ext_call_cancel(self->ext, self->ext_req_id);
+        binder_ext_call_list_unref(self->ext_calls);
         binder_ext_call_unref(self->ext);
     }
 
     binder_ims_reg_unref(self->ims_reg);
+    binder_retry_deinit(&self->clcc_retry);
     g_free(self->log_prefix);
     g_free(self);
 
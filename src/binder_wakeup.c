@@ -0,0 +1,259 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_metrics.h"
+#include "binder_wakeup.h"
+
+#include <ofono/log.h>
+
+#include <radio_util.h>
+
+#define BINDER_WAKEUP_STATS_FILE "wakeups.stats"
+
+typedef struct binder_wakeup_count {
+    guint64 total;
+    guint64 reported;   /* Total at the previous report */
+} BinderWakeupCount;
+
+typedef struct binder_wakeup_entry {
+    const char* source;
+    const BinderWakeupCount* count;
+} BinderWakeupEntry;
+
+static GHashTable* binder_wakeup_sources = NULL; /* name => count */
+static GHashTable* binder_wakeup_inds = NULL;    /* code => count */
+static gint64 binder_wakeup_period_start = 0;
+static gboolean binder_wakeup_dirty = FALSE;
+
+static const BinderMetricFamily binder_wakeup_metric = {
+    "binder_wakeups", BINDER_METRIC_COUNTER,
+    "Main loop wakeups per source"
+};
+
+static
+BinderWakeupCount*
+binder_wakeup_count(
+    GHashTable** table,
+    GHashFunc hash,
+    GEqualFunc equal,
+    gconstpointer key)
+{
+    BinderWakeupCount* count;
+
+    if (!*table) {
+        *table = g_hash_table_new_full(hash, equal, NULL, g_free);
+        if (!binder_wakeup_period_start) {
+            binder_wakeup_period_start = g_get_monotonic_time();
+        }
+    }
+    count = g_hash_table_lookup(*table, key);
+    if (!count) {
+        count = g_new0(BinderWakeupCount, 1);
+        g_hash_table_insert(*table, (gpointer)key, count);
+    }
+    binder_wakeup_dirty = TRUE;
+    return count;
+}
+
+static
+gint
+binder_wakeup_entry_compare(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const BinderWakeupEntry* e1 = a;
+    const BinderWakeupEntry* e2 = b;
+    const guint64 n1 = e1->count->total - e1->count->reported;
+    const guint64 n2 = e2->count->total - e2->count->reported;
+
+    /* Busiest first */
+    return (n1 < n2) ? 1 : (n1 > n2) ? (-1) :
+        g_strcmp0(e1->source, e2->source);
+}
+
+static
+GArray*
+binder_wakeup_entries(
+    void)
+{
+    GArray* entries = g_array_new(FALSE, FALSE, sizeof(BinderWakeupEntry));
+    GHashTableIter it;
+    gpointer key, value;
+
+    if (binder_wakeup_sources) {
+        g_hash_table_iter_init(&it, binder_wakeup_sources);
+        while (g_hash_table_iter_next(&it, &key, &value)) {
+            BinderWakeupEntry entry;
+
+            entry.source = key;
+            entry.count = value;
+            g_array_append_val(entries, entry);
+        }
+    }
+    if (binder_wakeup_inds) {
+        g_hash_table_iter_init(&it, binder_wakeup_inds);
+        while (g_hash_table_iter_next(&it, &key, &value)) {
+            const char* name = radio_ind_name(GPOINTER_TO_UINT(key));
+            BinderWakeupEntry entry;
+
+            /* radio_ind_name() returns static strings */
+            entry.source = name ? name : "unknown indication";
+            entry.count = value;
+            g_array_append_val(entries, entry);
+        }
+    }
+    g_array_sort(entries, binder_wakeup_entry_compare);
+    return entries;
+}
+
+static
+void
+binder_wakeup_start_period(
+    gint64 now)
+{
+    GHashTable* tables[2];
+    guint i;
+
+    tables[0] = binder_wakeup_sources;
+    tables[1] = binder_wakeup_inds;
+    for (i = 0; i < G_N_ELEMENTS(tables); i++) {
+        if (tables[i]) {
+            GHashTableIter it;
+            gpointer value;
+
+            g_hash_table_iter_init(&it, tables[i]);
+            while (g_hash_table_iter_next(&it, NULL, &value)) {
+                BinderWakeupCount* count = value;
+
+                count->reported = count->total;
+            }
+        }
+    }
+    binder_wakeup_period_start = now;
+    binder_wakeup_dirty = FALSE;
+}
+
+/*==========================================================================*
+ * API
+ *==========================================================================*/
+
+void
+binder_wakeup(
+    const char* source)
+{
+    binder_wakeup_count(&binder_wakeup_sources, g_str_hash, g_str_equal,
+        source)->total++;
+}
+
+void
+binder_wakeup_ind(
+    guint code)
+{
+    binder_wakeup_count(&binder_wakeup_inds, g_direct_hash, g_direct_equal,
+        GUINT_TO_POINTER(code))->total++;
+}
+
+char*
+binder_wakeup_format_stats(
+    void)
+{
+    const gint64 now = g_get_monotonic_time();
+    const gint64 period = now - binder_wakeup_period_start;
+    GString* buf = g_string_new(NULL);
+    GArray* entries = binder_wakeup_entries();
+    guint i;
+
+    g_string_append_printf(buf, "# period_sec %u\n# source total per_min\n",
+        (guint)(period / G_USEC_PER_SEC));
+    for (i = 0; i < entries->len; i++) {
+        const BinderWakeupEntry* entry = &g_array_index(entries,
+            BinderWakeupEntry, i);
+        const guint64 n = entry->count->total - entry->count->reported;
+
+        g_string_append_printf(buf, "%s %" G_GUINT64_FORMAT " %.1f\n",
+            entry->source, entry->count->total, (period > 0) ?
+            (n * 60.0 * G_USEC_PER_SEC / period) : 0.0);
+    }
+    g_array_free(entries, TRUE);
+    return g_string_free(buf, FALSE);
+}
+
+gboolean
+binder_wakeup_write_stats(
+    const char* dir)
+{
+    gboolean ok = FALSE;
+
+    if (dir && binder_wakeup_dirty) {
+        char* path = g_build_filename(dir, BINDER_WAKEUP_STATS_FILE, NULL);
+        char* text = binder_wakeup_format_stats();
+        GError* error = NULL;
+
+        if (g_file_set_contents(path, text, -1, &error)) {
+            binder_wakeup_start_period(g_get_monotonic_time());
+            ok = TRUE;
+        } else {
+            ofono_warn("Failed to write %s: %s", path, error->message);
+            g_error_free(error);
+        }
+        g_free(text);
+        g_free(path);
+    }
+    return ok;
+}
+
+void
+binder_wakeup_add_metrics(
+    BinderMetrics* metrics)
+{
+    GArray* entries = binder_wakeup_entries();
+    guint i;
+
+    for (i = 0; i < entries->len; i++) {
+        const BinderWakeupEntry* entry = &g_array_index(entries,
+            BinderWakeupEntry, i);
+        char* labels = binder_metrics_labels("source", entry->source, NULL);
+
+        binder_metrics_add(metrics, &binder_wakeup_metric, labels,
+            entry->count->total);
+        g_free(labels);
+    }
+    g_array_free(entries, TRUE);
+}
+
+void
+binder_wakeup_cleanup(
+    void)
+{
+    if (binder_wakeup_sources) {
+        g_hash_table_destroy(binder_wakeup_sources);
+        binder_wakeup_sources = NULL;
+    }
+    if (binder_wakeup_inds) {
+        g_hash_table_destroy(binder_wakeup_inds);
+        binder_wakeup_inds = NULL;
+    }
+    binder_wakeup_period_start = 0;
+    binder_wakeup_dirty = FALSE;
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,68 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef BINDER_WAKEUP_H
+#define BINDER_WAKEUP_H
+
+#include "binder_types.h"
+
+/*
+ * Process wide accounting of main loop wakeups per source, i.e. timers,
+ * indications and external signals. Source names are not copied and
+ * must be string literals. The report shows the totals and the rate
+ * per minute since the previous report.
+ */
+
+void
+binder_wakeup(
+    const char* source)
+    BINDER_INTERNAL;
+
+void
+binder_wakeup_ind(
+    guint code)
+    BINDER_INTERNAL;
+
+char*
+binder_wakeup_format_stats(
+    void)
+    G_GNUC_WARN_UNUSED_RESULT
+    BINDER_INTERNAL;
+
+/* Writes wakeups.stats and starts the next reporting period */
+gboolean
+binder_wakeup_write_stats(
+    const char* dir)
+    BINDER_INTERNAL;
+
+void
+binder_wakeup_add_metrics(
+    BinderMetrics* metrics)
+    BINDER_INTERNAL;
+
+void
+binder_wakeup_cleanup(
+    void)
+    BINDER_INTERNAL;
+
+#endif /* BINDER_WAKEUP_H */
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
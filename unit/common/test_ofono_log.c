@@ -0,0 +1,70 @@
+/*
+ *  oFono - Open Source Telephony
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ */
+
+#include <ofono/log.h>
+
+#include <gutil_log.h>
+
+/*
+ * ofono core logging, for the tests which link plugin modules
+ * using DBG(), ofono_warn() and friends.
+ */
+
+#define TEST_OFONO_LOG(level) do { \
+        va_list va; \
+        va_start(va, format); \
+        gutil_logv(NULL, level, format, va); \
+        va_end(va); \
+    } while (0)
+
+void
+ofono_info(
+    const char* format,
+    ...)
+{
+    TEST_OFONO_LOG(GLOG_LEVEL_INFO);
+}
+
+void
+ofono_warn(
+    const char* format,
+    ...)
+{
+    TEST_OFONO_LOG(GLOG_LEVEL_WARN);
+}
+
+void
+ofono_error(
+    const char* format,
+    ...)
+{
+    TEST_OFONO_LOG(GLOG_LEVEL_ERR);
+}
+
+void
+ofono_debug(
+    const char* format,
+    ...)
+{
+    TEST_OFONO_LOG(GLOG_LEVEL_DEBUG);
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -35,6 +35,7 @@ typedef enum test_property {
 typedef BinderBaseClass TestObjectClass;
 typedef struct test_object_data {
     void* ptr;
+    int value;
 } TestObjectData;
 typedef struct test_object {
     BinderBase base;
@@ -54,12 +55,37 @@ test_object_init(
 {
 }
 
+static int test_snapshot_count = 0;
+
+static
+void
+test_snapshot_clear(
+    gpointer snapshot)
+{
+    test_snapshot_count--;
+}
+
+static
+gpointer
+test_object_snapshot(
+    BinderBase* base)
+{
+    TestObject* self = TEST(base);
+    TestObjectData* snap = binder_base_snapshot_new(sizeof(*snap),
+        test_snapshot_clear);
+
+    test_snapshot_count++;
+    *snap = self->pub;
+    return snap;
+}
+
 static
 void
 test_object_class_init(
     TestObjectClass* klass)
 {
     BINDER_BASE_CLASS(klass)->public_offset = G_STRUCT_OFFSET(TestObject, pub);
+    BINDER_BASE_CLASS(klass)->snapshot = test_object_snapshot;
 }
 
 /*==========================================================================*
@@ -128,6 +154,158 @@ test_basic(
     g_object_unref(obj);
 }
 
+/*==========================================================================*
+ * batch
+ *==========================================================================*/
+
+typedef struct test_batch_data {
+    int calls;
+    guint mask;
+} TestBatchData;
+
+static
+void
+test_batch_cb(
+    TestObjectData* data,
+    guint mask,
+    void* user_data)
+{
+    TestBatchData* test = user_data;
+
+    g_assert(data->ptr == user_data);
+    test->calls++;
+    test->mask |= mask;
+    GDEBUG("0x%02x %d", mask, test->calls);
+}
+
+static
+void
+test_batch(
+    void)
+{
+    TestBatchData test;
+    TestBasicData basic;
+    TestObject* obj = g_object_new(TEST_TYPE, NULL);
+    BinderBase* base = &obj->base;
+    ulong id[2];
+
+    obj->pub.ptr = &test;
+    memset(&test, 0, sizeof(test));
+    memset(&basic, 0, sizeof(basic));
+    id[0] = binder_base_add_properties_handler(base, (BinderBasePropertiesFunc)
+        test_batch_cb, &test);
+    g_assert(id[0]);
+
+    /* NULL callback is tolerated */
+    g_assert(!binder_base_add_properties_handler(base, NULL, NULL));
+
+    /* Nested batch, nothing is emitted until the outer one is committed */
+    binder_base_begin_batch(base);
+    binder_base_emit_property_change(base, TEST_PROPERTY_ONE);
+    binder_base_begin_batch(base);
+    binder_base_emit_property_change(base, TEST_PROPERTY_TWO);
+    binder_base_commit_batch(base);
+    binder_base_emit_property_change(base, TEST_PROPERTY_ONE);
+    g_assert_cmpint(test.calls, == ,0);
+    binder_base_commit_batch(base);
+    g_assert_cmpint(test.calls, == ,1);
+    g_assert_cmpuint(test.mask, == ,
+        BINDER_BASE_PROPERTY_BIT(TEST_PROPERTY_ONE) |
+        BINDER_BASE_PROPERTY_BIT(TEST_PROPERTY_TWO));
+
+    /* Empty batch emits nothing */
+    binder_base_begin_batch(base);
+    binder_base_commit_batch(base);
+    g_assert_cmpint(test.calls, == ,1);
+
+    /* Per-property handlers still get their signals, once per property */
+    obj->pub.ptr = &basic;
+    g_signal_handler_disconnect(base, id[0]);
+    id[0] = binder_base_add_property_handler(base, TEST_PROPERTY_ANY,
+        G_CALLBACK(test_basic_cb), &basic);
+    id[1] = binder_base_add_property_handler(base, TEST_PROPERTY_TWO,
+        G_CALLBACK(test_basic_cb), &basic);
+    binder_base_begin_batch(base);
+    binder_base_emit_property_change(base, TEST_PROPERTY_TWO);
+    binder_base_emit_property_change(base, TEST_PROPERTY_TWO);
+    binder_base_emit_property_change(base, TEST_PROPERTY_ONE);
+    g_assert_cmpint(basic.total, == ,0);
+    binder_base_commit_batch(base);
+    g_assert_cmpint(basic.total, == ,3);
+    g_assert_cmpint(basic.count[TEST_PROPERTY_ONE], == ,1);
+    g_assert_cmpint(basic.count[TEST_PROPERTY_TWO], == ,2);
+
+    g_signal_handler_disconnect(base, id[0]);
+    g_signal_handler_disconnect(base, id[1]);
+    g_object_unref(obj);
+}
+
+/*==========================================================================*
+ * snapshot
+ *==========================================================================*/
+
+static
+void
+test_snapshot(
+    void)
+{
+    TestObject* obj = g_object_new(TEST_TYPE, NULL);
+    BinderBase* base = &obj->base;
+    const TestObjectData* snap1;
+    const TestObjectData* snap2;
+
+    /* No snapshot until the first update */
+    g_assert(!binder_base_snapshot_ref(NULL));
+    g_assert(!binder_base_snapshot_ref(base));
+    binder_base_snapshot_unref(NULL);
+
+    obj->pub.value = 1;
+    binder_base_update_snapshot(base);
+    g_assert_cmpint(test_snapshot_count, == ,1);
+    snap1 = binder_base_snapshot_ref(base);
+    g_assert(snap1);
+    g_assert_cmpint(snap1->value, == ,1);
+
+    /* Nothing is taken until somebody asks */
+    snap2 = binder_base_snapshot_ref(base);
+    g_assert(snap2 == snap1);
+    binder_base_snapshot_unref(snap2);
+    binder_base_emit_property_change(base, TEST_PROPERTY_TWO);
+    binder_base_emit_property_change(base, TEST_PROPERTY_ONE);
+    g_assert_cmpint(test_snapshot_count, == ,1);
+
+    /* The old snapshot stays intact while referenced */
+    obj->pub.value = 2;
+    g_assert_cmpint(snap1->value, == ,1);
+    binder_base_emit_property_change(base, TEST_PROPERTY_ONE);
+    g_assert_cmpint(test_snapshot_count, == ,1);
+    snap2 = binder_base_snapshot_ref(base);
+    g_assert_cmpint(test_snapshot_count, == ,2);
+    g_assert(snap2 != snap1);
+    g_assert_cmpint(snap1->value, == ,1);
+    g_assert_cmpint(snap2->value, == ,2);
+    binder_base_snapshot_unref(snap1);
+    g_assert_cmpint(test_snapshot_count, == ,1);
+
+    /* Nothing is taken while the batch is open */
+    binder_base_begin_batch(base);
+    obj->pub.value = 3;
+    binder_base_emit_property_change(base, TEST_PROPERTY_TWO);
+    snap1 = binder_base_snapshot_ref(base);
+    g_assert(snap1 == snap2);
+    binder_base_snapshot_unref(snap1);
+    binder_base_commit_batch(base);
+    snap1 = binder_base_snapshot_ref(base);
+    g_assert_cmpint(snap1->value, == ,3);
+    binder_base_snapshot_unref(snap1);
+    binder_base_snapshot_unref(snap2);
+    g_assert_cmpint(test_snapshot_count, == ,1);
+
+    /* The last one is released together with the object */
+    g_object_unref(obj);
+    g_assert_cmpint(test_snapshot_count, == ,0);
+}
+
 /*==========================================================================*
  * Common
  *==========================================================================*/
@@ -139,6 +317,8 @@ int main(int argc, char* argv[])
 {
     g_test_init(&argc, &argv, NULL);
     g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("batch"), test_batch);
+    g_test_add_func(TEST_("snapshot"), test_snapshot);
 
     gutil_log_default.level = g_test_verbose() ?
         GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
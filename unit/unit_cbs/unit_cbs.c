@@ -0,0 +1,192 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_cbs_util.h"
+#include "binder_log.h"
+
+#include <gutil_log.h>
+
+#include <string.h>
+
+GLOG_MODULE_DEFINE("unit_cbs");
+
+static
+void
+test_check_ranges(
+    GArray* ranges,
+    const guint* expected, /* from, to pairs */
+    guint count)
+{
+    const BinderCbsRange* r = (const BinderCbsRange*) ranges->data;
+    guint i;
+
+    g_assert_cmpuint(ranges->len, == ,count);
+    for (i = 0; i < count; i++) {
+        g_assert_cmpuint(r[i].from, == ,expected[2 * i]);
+        g_assert_cmpuint(r[i].to, == ,expected[2 * i + 1]);
+    }
+    g_array_free(ranges, TRUE);
+}
+
+/*==========================================================================*
+ * parse
+ *==========================================================================*/
+
+static
+void
+test_parse(
+    void)
+{
+    static const guint single[] = { 919, 919 };
+    static const guint merged[] = { 919, 919, 4370, 4383 };
+    static const guint adjacent[] = { 1, 20 };
+    static const guint swapped[] = { 50, 100, 200, 200 };
+    static const guint capped[] = { 65000, 0xffff };
+
+    /* Empty lists */
+    test_check_ranges(binder_cbs_parse_topics(NULL), NULL, 0);
+    test_check_ranges(binder_cbs_parse_topics(""), NULL, 0);
+
+    test_check_ranges(binder_cbs_parse_topics("919"), single, 1);
+
+    /* Duplicates and nested ranges are merged, the result is sorted */
+    test_check_ranges(binder_cbs_parse_topics("4370-4383,4370,919,"
+        "4371-4380,919"), merged, G_N_ELEMENTS(merged)/2);
+
+    /* Adjacent and overlapping ranges are merged too */
+    test_check_ranges(binder_cbs_parse_topics("11-20,1-5,6-10,3"),
+        adjacent, 1);
+
+    /* Reversed range gets swapped */
+    test_check_ranges(binder_cbs_parse_topics("200,100-50"),
+        swapped, G_N_ELEMENTS(swapped)/2);
+
+    /* Out of range ids are capped or dropped */
+    test_check_ranges(binder_cbs_parse_topics("65000-70000,70000,"
+        "80000-90000"), capped, 1);
+}
+
+/*==========================================================================*
+ * equal
+ *==========================================================================*/
+
+static
+void
+test_equal(
+    void)
+{
+    GArray* r1 = binder_cbs_parse_topics("1-5,10");
+    GArray* r2 = binder_cbs_parse_topics("10,1,2-5");
+    GArray* r3 = binder_cbs_parse_topics("1-5");
+    GArray* r4 = binder_cbs_parse_topics("1-5,11");
+
+    g_assert(binder_cbs_ranges_equal(r1, r2));
+    g_assert(!binder_cbs_ranges_equal(r1, r3));
+    g_assert(!binder_cbs_ranges_equal(r1, r4));
+
+    /* NULL is never equal to anything, not even to NULL */
+    g_assert(!binder_cbs_ranges_equal(r1, NULL));
+    g_assert(!binder_cbs_ranges_equal(NULL, r1));
+    g_assert(!binder_cbs_ranges_equal(NULL, NULL));
+
+    g_array_free(r1, TRUE);
+    g_array_free(r2, TRUE);
+    g_array_free(r3, TRUE);
+    g_array_free(r4, TRUE);
+}
+
+/*==========================================================================*
+ * recent
+ *==========================================================================*/
+
+static
+void
+test_recent(
+    void)
+{
+    static const guint8 page1[] = { 0x01, 0x02, 0x11, 0x12, 0x0f, 0x11, 0xaa };
+    static const guint8 page2[] = { 0x01, 0x02, 0x11, 0x12, 0x0f, 0x12, 0xaa };
+    const gint64 sec = G_USEC_PER_SEC;
+    const gint64 max_age = BINDER_CBS_RECENT_MAX_AGE_SEC * sec;
+    gint64 now = 1000 * sec;
+    BinderCbsRecent recent;
+    guint8 page[BINDER_CBS_PAGE_ID_SIZE];
+    guint i;
+
+    memset(&recent, 0, sizeof(recent));
+
+    /* Too short to be identified */
+    g_assert(!binder_cbs_recent_check(&recent, page1, 5, now));
+    g_assert(!binder_cbs_recent_check(&recent, page1, 5, now));
+
+    /* Only the first 6 octets matter */
+    g_assert(!binder_cbs_recent_check(&recent, page1, sizeof(page1), now));
+    g_assert(binder_cbs_recent_check(&recent, page1, 6, now));
+    g_assert(!binder_cbs_recent_check(&recent, page2, sizeof(page2), now));
+    g_assert(binder_cbs_recent_check(&recent, page2, sizeof(page2), now));
+
+    /* Repeats keep refreshing the timestamp */
+    now += max_age - sec;
+    g_assert(binder_cbs_recent_check(&recent, page1, sizeof(page1), now));
+    now += max_age - sec;
+    g_assert(binder_cbs_recent_check(&recent, page1, sizeof(page1), now));
+
+    /* While page2 has expired by now */
+    g_assert(!binder_cbs_recent_check(&recent, page2, sizeof(page2), now));
+
+    /* The oldest entry gets replaced when the table is full */
+    memcpy(page, page1, sizeof(page));
+    for (i = 0; i < BINDER_CBS_RECENT_PAGES; i++) {
+        page[0] = 0x80 + i;
+        g_assert(!binder_cbs_recent_check(&recent, page, sizeof(page), now));
+    }
+    g_assert(!binder_cbs_recent_check(&recent, page1, sizeof(page1), now));
+    g_assert(!binder_cbs_recent_check(&recent, page2, sizeof(page2), now));
+
+    /* The last BINDER_CBS_RECENT_PAGES - 2 of those are still there */
+    for (i = 2; i < BINDER_CBS_RECENT_PAGES; i++) {
+        page[0] = 0x80 + i;
+        g_assert(binder_cbs_recent_check(&recent, page, sizeof(page), now));
+    }
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/cbs/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("parse"), test_parse);
+    g_test_add_func(TEST_("equal"), test_equal);
+    g_test_add_func(TEST_("recent"), test_recent);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,724 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_ext_call_impl.h"
+
+#include <gutil_log.h>
+
+#include <string.h>
+
+/*==========================================================================*
+ * Test object, keeps the requests until the test completes them
+ *==========================================================================*/
+
+typedef GObjectClass TestCallClass;
+typedef struct test_call {
+    GObject parent;
+    GSList* reqs;
+    guint last_id;
+    gboolean sync;          /* Complete the requests right away */
+    guint fail_call_id;     /* hangup fails for this call */
+    int hangups;
+    int batches;
+    int cancelled;
+    const BinderExtCallInfo** calls;
+    BinderExtCallList* list;
+} TestCall;
+
+typedef struct test_call_req {
+    guint id;
+    guint call_id;
+    BinderExtCallResultFunc complete;
+    GDestroyNotify destroy;
+    void* user_data;
+} TestCallReq;
+
+G_DEFINE_TYPE(TestCall, test_call, G_TYPE_OBJECT)
+
+#define TEST_TYPE_CALL test_call_get_type()
+#define TEST_CALL(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, TEST_TYPE_CALL, TestCall)
+
+static
+void
+test_call_req_done(
+    TestCall* self,
+    TestCallReq* req,
+    gboolean complete,
+    BINDER_EXT_CALL_RESULT result)
+{
+    self->reqs = g_slist_remove(self->reqs, req);
+    if (complete && req->complete) {
+        req->complete(BINDER_EXT_CALL(self), result, req->user_data);
+    }
+    if (req->destroy) {
+        req->destroy(req->user_data);
+    }
+    g_free(req);
+}
+
+static
+guint
+test_call_req_new(
+    TestCall* self,
+    guint call_id,
+    BinderExtCallResultFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    TestCallReq* req = g_new0(TestCallReq, 1);
+
+    req->id = ++(self->last_id);
+    req->call_id = call_id;
+    req->complete = complete;
+    req->destroy = destroy;
+    req->user_data = user_data;
+    self->reqs = g_slist_append(self->reqs, req);
+    if (self->sync) {
+        const guint id = req->id;
+
+        test_call_req_done(self, req, TRUE, BINDER_EXT_CALL_RESULT_OK);
+        return id;
+    }
+    return req->id;
+}
+
+static
+void
+test_call_complete(
+    TestCall* self,
+    guint call_id,
+    BINDER_EXT_CALL_RESULT result)
+{
+    GSList* l;
+
+    for (l = self->reqs; l; l = l->next) {
+        TestCallReq* req = l->data;
+
+        if (req->call_id == call_id) {
+            test_call_req_done(self, req, TRUE, result);
+            return;
+        }
+    }
+    g_assert_not_reached();
+}
+
+static
+const BinderExtCallInfo* const*
+test_call_get_calls(
+    BinderExtCall* ext)
+{
+    return TEST_CALL(ext)->calls;
+}
+
+static
+guint
+test_call_hangup(
+    BinderExtCall* ext,
+    guint call_id,
+    BINDER_EXT_CALL_HANGUP_REASON reason,
+    BINDER_EXT_CALL_HANGUP_FLAGS flags,
+    BinderExtCallResultFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    TestCall* self = TEST_CALL(ext);
+
+    self->hangups++;
+    return (call_id == self->fail_call_id) ? 0 :
+        test_call_req_new(self, call_id, complete, destroy, user_data);
+}
+
+static
+guint
+test_call_hangup_batch(
+    BinderExtCall* ext,
+    const guint* call_ids,
+    guint count,
+    BINDER_EXT_CALL_HANGUP_REASON reason,
+    BINDER_EXT_CALL_HANGUP_FLAGS flags,
+    BinderExtCallResultFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    TestCall* self = TEST_CALL(ext);
+
+    self->batches++;
+    return test_call_req_new(self, 0, complete, destroy, user_data);
+}
+
+static
+guint
+test_call_hangup_batch_not_reached(
+    BinderExtCall* ext,
+    const guint* call_ids,
+    guint count,
+    BINDER_EXT_CALL_HANGUP_REASON reason,
+    BINDER_EXT_CALL_HANGUP_FLAGS flags,
+    BinderExtCallResultFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    g_assert_not_reached();
+    return 0;
+}
+
+static
+void
+test_call_cancel(
+    BinderExtCall* ext,
+    guint id)
+{
+    TestCall* self = TEST_CALL(ext);
+    GSList* l;
+
+    for (l = self->reqs; l; l = l->next) {
+        TestCallReq* req = l->data;
+
+        if (req->id == id) {
+            self->cancelled++;
+            test_call_req_done(self, req, FALSE, BINDER_EXT_CALL_RESULT_OK);
+            return;
+        }
+    }
+}
+
+static
+BinderExtCallList*
+test_call_get_call_list(
+    BinderExtCall* ext)
+{
+    return binder_ext_call_list_ref(TEST_CALL(ext)->list);
+}
+
+static
+BinderExtCallList*
+test_call_get_call_list_not_reached(
+    BinderExtCall* ext)
+{
+    g_assert_not_reached();
+    return NULL;
+}
+
+static
+void
+test_call_init(
+    TestCall* self)
+{
+}
+
+static
+void
+test_call_finalize(
+    GObject* object)
+{
+    TestCall* self = TEST_CALL(object);
+
+    g_assert(!self->reqs);
+    binder_ext_call_list_unref(self->list);
+    G_OBJECT_CLASS(test_call_parent_class)->finalize(object);
+}
+
+static
+void
+test_call_class_init(
+    TestCallClass* klass)
+{
+    G_OBJECT_CLASS(klass)->finalize = test_call_finalize;
+}
+
+/*==========================================================================*
+ * Version 1 implementation, the version 2 callbacks must be ignored
+ *==========================================================================*/
+
+typedef TestCallClass TestCall1Class;
+typedef TestCall TestCall1;
+
+static void test_call1_iface_init(BinderExtCallInterface* iface);
+G_DEFINE_TYPE_WITH_CODE(TestCall1, test_call1, TEST_TYPE_CALL,
+G_IMPLEMENT_INTERFACE(BINDER_EXT_TYPE_CALL, test_call1_iface_init))
+
+#define TEST_TYPE_CALL1 test_call1_get_type()
+
+static
+void
+test_call1_iface_init(
+    BinderExtCallInterface* iface)
+{
+    iface->version = 1;
+    iface->get_calls = test_call_get_calls;
+    iface->hangup = test_call_hangup;
+    iface->cancel = test_call_cancel;
+    iface->hangup_batch = test_call_hangup_batch_not_reached;
+    iface->get_call_list = test_call_get_call_list_not_reached;
+}
+
+static
+void
+test_call1_init(
+    TestCall1* self)
+{
+}
+
+static
+void
+test_call1_class_init(
+    TestCall1Class* klass)
+{
+}
+
+/*==========================================================================*
+ * Version 2 implementation
+ *==========================================================================*/
+
+typedef TestCallClass TestCall2Class;
+typedef TestCall TestCall2;
+
+static void test_call2_iface_init(BinderExtCallInterface* iface);
+G_DEFINE_TYPE_WITH_CODE(TestCall2, test_call2, TEST_TYPE_CALL,
+G_IMPLEMENT_INTERFACE(BINDER_EXT_TYPE_CALL, test_call2_iface_init))
+
+#define TEST_TYPE_CALL2 test_call2_get_type()
+
+static
+void
+test_call2_iface_init(
+    BinderExtCallInterface* iface)
+{
+    iface->version = BINDER_EXT_CALL_INTERFACE_VERSION;
+    iface->get_calls = test_call_get_calls;
+    iface->hangup = test_call_hangup;
+    iface->cancel = test_call_cancel;
+    iface->hangup_batch = test_call_hangup_batch;
+    iface->get_call_list = test_call_get_call_list;
+}
+
+static
+void
+test_call2_init(
+    TestCall2* self)
+{
+}
+
+static
+void
+test_call2_class_init(
+    TestCall2Class* klass)
+{
+}
+
+/*==========================================================================*
+ * Completion tracking
+ *==========================================================================*/
+
+typedef struct test_result {
+    int complete;
+    int destroy;
+    BINDER_EXT_CALL_RESULT result;
+} TestResult;
+
+static
+void
+test_result_complete(
+    BinderExtCall* ext,
+    BINDER_EXT_CALL_RESULT result,
+    void* user_data)
+{
+    TestResult* test = user_data;
+
+    g_assert(!test->destroy);
+    test->complete++;
+    test->result = result;
+}
+
+static
+void
+test_result_destroy(
+    void* user_data)
+{
+    TestResult* test = user_data;
+
+    test->destroy++;
+}
+
+static
+guint
+test_hangup_batch(
+    BinderExtCall* ext,
+    const guint* call_ids,
+    guint count,
+    TestResult* result)
+{
+    memset(result, 0, sizeof(*result));
+    return binder_ext_call_hangup_batch(ext, call_ids, count,
+        BINDER_EXT_CALL_HANGUP_TERMINATE, BINDER_EXT_CALL_HANGUP_NO_FLAGS,
+        test_result_complete, test_result_destroy, result);
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    static const guint ids[] = { 1 };
+    BinderExtCall* ext = g_object_new(TEST_TYPE_CALL2, NULL);
+    BinderExtCallList* list;
+    TestResult result;
+
+    /* NULL resistance */
+    g_assert(binder_ext_call_get_calls(NULL));
+    g_assert(!binder_ext_call_get_calls(NULL)[0]);
+    list = binder_ext_call_get_call_list(NULL);
+    g_assert(list);
+    g_assert_cmpuint(list->count, == ,0);
+    g_assert_cmpuint(list->version, == ,0);
+    binder_ext_call_list_unref(list);
+    binder_ext_call_list_unref(NULL);
+    g_assert(!binder_ext_call_list_ref(NULL));
+    g_assert(binder_ext_call_info_equal(NULL, NULL));
+    g_assert(!test_hangup_batch(NULL, ids, 1, &result));
+    g_assert(!test_hangup_batch(ext, NULL, 1, &result));
+    g_assert(!test_hangup_batch(ext, ids, 0, &result));
+    g_assert(!result.complete);
+    g_assert(!result.destroy);
+    binder_ext_call_cancel_batch(NULL, 1);
+    binder_ext_call_cancel_batch(ext, 0);
+    g_assert_cmpint(TEST_CALL(ext)->batches, == ,0);
+    g_assert_cmpint(TEST_CALL(ext)->cancelled, == ,0);
+    binder_ext_call_unref(ext);
+}
+
+/*==========================================================================*
+ * list
+ *==========================================================================*/
+
+static
+void
+test_list(
+    void)
+{
+    BinderExtCallInfo c1 = {
+        2, BINDER_EXT_CALL_TYPE_VOICE, BINDER_EXT_CALL_STATE_ACTIVE,
+        BINDER_EXT_CALL_FLAGS_NONE, BINDER_EXT_TOA_INTERNATIONAL,
+        "+358401234567", "Foo"
+    };
+    BinderExtCallInfo c2 = {
+        1, BINDER_EXT_CALL_TYPE_VOICE, BINDER_EXT_CALL_STATE_INCOMING,
+        BINDER_EXT_CALL_FLAG_INCOMING, BINDER_EXT_TOA_LOCAL,
+        "0401234567", NULL
+    };
+    const BinderExtCallInfo* calls[] = { &c1, &c2, NULL };
+    TestCall* test = g_object_new(TEST_TYPE_CALL1, NULL);
+    BinderExtCall* ext = BINDER_EXT_CALL(test);
+    BinderExtCallList* list1;
+    BinderExtCallList* list2;
+
+    /* Version 1 builds the list from get_calls() */
+    test->calls = calls;
+    list1 = binder_ext_call_get_call_list(ext);
+    g_assert_cmpuint(list1->version, == ,1);
+    g_assert_cmpuint(list1->count, == ,2);
+
+    /* Sorted by call id, with the strings copied */
+    g_assert_cmpuint(list1->calls[0].call_id, == ,1);
+    g_assert_cmpuint(list1->calls[1].call_id, == ,2);
+    g_assert(binder_ext_call_info_equal(list1->calls + 0, &c2));
+    g_assert(binder_ext_call_info_equal(list1->calls + 1, &c1));
+    g_assert(list1->calls[1].number != c1.number);
+    g_assert(list1->calls[1].name != c1.name);
+    g_assert(!list1->calls[0].name);
+
+    /* Same contents, same list */
+    list2 = binder_ext_call_get_call_list(ext);
+    g_assert(list2 == list1);
+    binder_ext_call_list_unref(list2);
+
+    /* Change produces a new version, the old list remains intact */
+    c1.state = BINDER_EXT_CALL_STATE_HOLDING;
+    g_assert(!binder_ext_call_info_equal(list1->calls + 1, &c1));
+    list2 = binder_ext_call_get_call_list(ext);
+    g_assert(list2 != list1);
+    g_assert_cmpuint(list2->version, == ,2);
+    g_assert_cmpint(list2->calls[1].state, == ,BINDER_EXT_CALL_STATE_HOLDING);
+    g_assert_cmpint(list1->calls[1].state, == ,BINDER_EXT_CALL_STATE_ACTIVE);
+    binder_ext_call_list_unref(list1);
+    binder_ext_call_list_unref(list2);
+
+    /* And so does a disappearing call */
+    calls[1] = NULL;
+    list1 = binder_ext_call_get_call_list(ext);
+    g_assert_cmpuint(list1->version, == ,3);
+    g_assert_cmpuint(list1->count, == ,1);
+    g_assert_cmpuint(list1->calls[0].call_id, == ,2);
+    binder_ext_call_list_unref(list1);
+
+    /* No calls at all */
+    test->calls = NULL;
+    list1 = binder_ext_call_get_call_list(ext);
+    g_assert_cmpuint(list1->version, == ,4);
+    g_assert_cmpuint(list1->count, == ,0);
+    list2 = binder_ext_call_get_call_list(ext);
+    g_assert(list2 == list1);
+    binder_ext_call_list_unref(list1);
+    binder_ext_call_list_unref(list2);
+    binder_ext_call_unref(ext);
+}
+
+/*==========================================================================*
+ * list2
+ *==========================================================================*/
+
+static
+void
+test_list2(
+    void)
+{
+    BinderExtCallInfo c1 = {
+        3, BINDER_EXT_CALL_TYPE_VOICE, BINDER_EXT_CALL_STATE_DIALING,
+        BINDER_EXT_CALL_FLAGS_NONE, BINDER_EXT_TOA_UNKNOWN, NULL, NULL
+    };
+    const BinderExtCallInfo* calls[] = { &c1, NULL };
+    TestCall* test = g_object_new(TEST_TYPE_CALL2, NULL);
+    BinderExtCall* ext = BINDER_EXT_CALL(test);
+    BinderExtCallList* list;
+
+    /* Falls back to get_calls() if get_call_list() returns NULL */
+    test->calls = calls;
+    list = binder_ext_call_get_call_list(ext);
+    g_assert_cmpuint(list->version, == ,1);
+    g_assert_cmpuint(list->count, == ,1);
+    g_assert(binder_ext_call_info_equal(list->calls, &c1));
+    binder_ext_call_list_unref(list);
+
+    /* Otherwise the list provided by the implementation is returned */
+    test->list = binder_ext_call_list_new(NULL, 7);
+    list = binder_ext_call_get_call_list(ext);
+    g_assert(list == test->list);
+    g_assert_cmpuint(list->version, == ,7);
+    g_assert_cmpuint(list->count, == ,0);
+    binder_ext_call_list_unref(list);
+    binder_ext_call_unref(ext);
+}
+
+/*==========================================================================*
+ * batch
+ *==========================================================================*/
+
+static
+void
+test_batch(
+    void)
+{
+    static const guint ids[] = { 1, 2 };
+    TestCall* test = g_object_new(TEST_TYPE_CALL2, NULL);
+    BinderExtCall* ext = BINDER_EXT_CALL(test);
+    TestResult result;
+    guint id;
+
+    /* Version 2 implementation receives the whole batch */
+    id = test_hangup_batch(ext, ids, G_N_ELEMENTS(ids), &result);
+    g_assert(id);
+    g_assert_cmpint(test->batches, == ,1);
+    g_assert_cmpint(test->hangups, == ,0);
+    test_call_complete(test, 0, BINDER_EXT_CALL_RESULT_ERROR);
+    g_assert_cmpint(result.complete, == ,1);
+    g_assert_cmpint(result.destroy, == ,1);
+    g_assert_cmpint(result.result, == ,BINDER_EXT_CALL_RESULT_ERROR);
+
+    /* And the cancel */
+    id = test_hangup_batch(ext, ids, G_N_ELEMENTS(ids), &result);
+    g_assert(id);
+    binder_ext_call_cancel_batch(ext, id);
+    g_assert_cmpint(test->cancelled, == ,1);
+    g_assert_cmpint(result.complete, == ,0);
+    g_assert_cmpint(result.destroy, == ,1);
+    binder_ext_call_unref(ext);
+}
+
+/*==========================================================================*
+ * fallback
+ *==========================================================================*/
+
+static
+void
+test_fallback(
+    void)
+{
+    static const guint ids[] = { 1, 2, 3 };
+    TestCall* test = g_object_new(TEST_TYPE_CALL1, NULL);
+    BinderExtCall* ext = BINDER_EXT_CALL(test);
+    TestResult result;
+    guint id;
+
+    /* Version 1 implementation hangs up the calls one by one */
+    id = test_hangup_batch(ext, ids, G_N_ELEMENTS(ids), &result);
+    g_assert(id);
+    g_assert_cmpint(test->hangups, == ,3);
+    g_assert_cmpuint(g_slist_length(test->reqs), == ,3);
+
+    /* The batch completes when the last request does */
+    test_call_complete(test, 1, BINDER_EXT_CALL_RESULT_OK);
+    test_call_complete(test, 3, BINDER_EXT_CALL_RESULT_ERROR);
+    g_assert_cmpint(result.complete, == ,0);
+    g_assert_cmpint(result.destroy, == ,0);
+    test_call_complete(test, 2, BINDER_EXT_CALL_RESULT_OK);
+    g_assert_cmpint(result.complete, == ,1);
+    g_assert_cmpint(result.destroy, == ,1);
+
+    /* Any failure fails the whole batch */
+    g_assert_cmpint(result.result, == ,BINDER_EXT_CALL_RESULT_ERROR);
+
+    /* The id is no longer valid */
+    binder_ext_call_cancel_batch(ext, id);
+    g_assert_cmpint(test->cancelled, == ,0);
+
+    /* All good */
+    id = test_hangup_batch(ext, ids, 2, &result);
+    g_assert(id);
+    test_call_complete(test, 2, BINDER_EXT_CALL_RESULT_OK);
+    test_call_complete(test, 1, BINDER_EXT_CALL_RESULT_OK);
+    g_assert_cmpint(result.complete, == ,1);
+    g_assert_cmpint(result.destroy, == ,1);
+    g_assert_cmpint(result.result, == ,BINDER_EXT_CALL_RESULT_OK);
+    binder_ext_call_unref(ext);
+}
+
+/*==========================================================================*
+ * fallback_fail
+ *==========================================================================*/
+
+static
+void
+test_fallback_fail(
+    void)
+{
+    static const guint ids[] = { 1, 2 };
+    TestCall* test = g_object_new(TEST_TYPE_CALL1, NULL);
+    BinderExtCall* ext = BINDER_EXT_CALL(test);
+    TestResult result;
+
+    /* The hangup which didn't go through fails the batch */
+    test->fail_call_id = 2;
+    g_assert(test_hangup_batch(ext, ids, G_N_ELEMENTS(ids), &result));
+    g_assert_cmpuint(g_slist_length(test->reqs), == ,1);
+    test_call_complete(test, 1, BINDER_EXT_CALL_RESULT_OK);
+    g_assert_cmpint(result.complete, == ,1);
+    g_assert_cmpint(result.destroy, == ,1);
+    g_assert_cmpint(result.result, == ,BINDER_EXT_CALL_RESULT_ERROR);
+
+    /* Nothing at all went through, no callbacks */
+    g_assert(!test_hangup_batch(ext, ids + 1, 1, &result));
+    g_assert_cmpint(result.complete, == ,0);
+    g_assert_cmpint(result.destroy, == ,0);
+    binder_ext_call_unref(ext);
+}
+
+/*==========================================================================*
+ * fallback_sync
+ *==========================================================================*/
+
+static
+void
+test_fallback_sync(
+    void)
+{
+    static const guint ids[] = { 1, 2 };
+    TestCall* test = g_object_new(TEST_TYPE_CALL1, NULL);
+    BinderExtCall* ext = BINDER_EXT_CALL(test);
+    TestResult result;
+    guint id;
+
+    /* Everything completes before binder_ext_call_hangup_batch returns */
+    test->sync = TRUE;
+    id = test_hangup_batch(ext, ids, G_N_ELEMENTS(ids), &result);
+    g_assert(id);
+    g_assert(!test->reqs);
+    g_assert_cmpint(result.complete, == ,1);
+    g_assert_cmpint(result.destroy, == ,1);
+    g_assert_cmpint(result.result, == ,BINDER_EXT_CALL_RESULT_OK);
+    binder_ext_call_cancel_batch(ext, id);
+    g_assert_cmpint(test->cancelled, == ,0);
+    binder_ext_call_unref(ext);
+}
+
+/*==========================================================================*
+ * fallback_cancel
+ *==========================================================================*/
+
+static
+void
+test_fallback_cancel(
+    void)
+{
+    static const guint ids[] = { 1, 2, 3 };
+    TestCall* test = g_object_new(TEST_TYPE_CALL1, NULL);
+    BinderExtCall* ext = BINDER_EXT_CALL(test);
+    TestResult result;
+    guint id;
+
+    id = test_hangup_batch(ext, ids, G_N_ELEMENTS(ids), &result);
+    g_assert(id);
+    test_call_complete(test, 2, BINDER_EXT_CALL_RESULT_OK);
+
+    /* Requests still pending get cancelled, no completion callback */
+    binder_ext_call_cancel_batch(ext, id);
+    g_assert_cmpint(test->cancelled, == ,2);
+    g_assert(!test->reqs);
+    g_assert_cmpint(result.complete, == ,0);
+    g_assert_cmpint(result.destroy, == ,1);
+
+    /* Second cancel does nothing */
+    binder_ext_call_cancel_batch(ext, id);
+    g_assert_cmpint(test->cancelled, == ,2);
+    g_assert_cmpint(result.destroy, == ,1);
+    binder_ext_call_unref(ext);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/ext_call/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("list"), test_list);
+    g_test_add_func(TEST_("list2"), test_list2);
+    g_test_add_func(TEST_("batch"), test_batch);
+    g_test_add_func(TEST_("fallback"), test_fallback);
+    g_test_add_func(TEST_("fallback_fail"), test_fallback_fail);
+    g_test_add_func(TEST_("fallback_sync"), test_fallback_sync);
+    g_test_add_func(TEST_("fallback_cancel"), test_fallback_cancel);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
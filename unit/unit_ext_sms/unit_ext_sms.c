@@ -0,0 +1,662 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_ext_sms_impl.h"
+
+#include <gutil_log.h>
+
+#include <string.h>
+
+/*==========================================================================*
+ * Test object, keeps the requests until the test completes them
+ *==========================================================================*/
+
+typedef GObjectClass TestSmsClass;
+typedef struct test_sms {
+    GObject parent;
+    GSList* reqs;
+    guint last_id;
+    int fail_send;          /* send fails on this attempt, -1 if none */
+    int sends;
+    int batches;
+    int cancelled;
+} TestSms;
+
+typedef struct test_sms_req {
+    guint id;
+    char* smsc;
+    GBytes* pdu;
+    guint msg_ref;
+    BINDER_EXT_SMS_SEND_FLAGS flags;
+    BinderExtSmsSendFunc complete;
+    BinderExtSmsSendBatchFunc batch_complete;
+    GDestroyNotify destroy;
+    void* user_data;
+} TestSmsReq;
+
+G_DEFINE_TYPE(TestSms, test_sms, G_TYPE_OBJECT)
+
+#define TEST_TYPE_SMS test_sms_get_type()
+#define TEST_SMS(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, TEST_TYPE_SMS, TestSms)
+
+static
+TestSmsReq*
+test_sms_req_new(
+    TestSms* self,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    TestSmsReq* req = g_new0(TestSmsReq, 1);
+
+    req->id = ++(self->last_id);
+    req->destroy = destroy;
+    req->user_data = user_data;
+    self->reqs = g_slist_append(self->reqs, req);
+    return req;
+}
+
+static
+void
+test_sms_req_done(
+    TestSms* self,
+    TestSmsReq* req,
+    gboolean complete,
+    BINDER_EXT_SMS_SEND_RESULT result,
+    guint msg_ref)
+{
+    BinderExtSms* ext = BINDER_EXT_SMS(self);
+
+    self->reqs = g_slist_remove(self->reqs, req);
+    if (complete) {
+        if (req->complete) {
+            req->complete(ext, result, msg_ref, req->user_data);
+        }
+        if (req->batch_complete) {
+            req->batch_complete(ext, 0, result, msg_ref, req->user_data);
+        }
+    }
+    if (req->destroy) {
+        req->destroy(req->user_data);
+    }
+    if (req->pdu) {
+        g_bytes_unref(req->pdu);
+    }
+    g_free(req->smsc);
+    g_free(req);
+}
+
+/* Returns the oldest pending request */
+static
+TestSmsReq*
+test_sms_req(
+    TestSms* self)
+{
+    g_assert(self->reqs);
+    return self->reqs->data;
+}
+
+static
+void
+test_sms_complete(
+    TestSms* self,
+    BINDER_EXT_SMS_SEND_RESULT result,
+    guint msg_ref)
+{
+    test_sms_req_done(self, test_sms_req(self), TRUE, result, msg_ref);
+}
+
+static
+guint
+test_sms_send(
+    BinderExtSms* ext,
+    const char* smsc,
+    const void* pdu,
+    gsize pdu_len,
+    guint msg_ref,
+    BINDER_EXT_SMS_SEND_FLAGS flags,
+    BinderExtSmsSendFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    TestSms* self = TEST_SMS(ext);
+
+    if (self->sends++ == self->fail_send) {
+        return 0;
+    } else {
+        TestSmsReq* req = test_sms_req_new(self, destroy, user_data);
+
+        req->smsc = g_strdup(smsc);
+        req->pdu = g_bytes_new(pdu, pdu_len);
+        req->msg_ref = msg_ref;
+        req->flags = flags;
+        req->complete = complete;
+        return req->id;
+    }
+}
+
+static
+guint
+test_sms_send_batch(
+    BinderExtSms* ext,
+    const char* smsc,
+    const BinderExtSmsPdu* pdus,
+    guint count,
+    BINDER_EXT_SMS_SEND_FLAGS flags,
+    BinderExtSmsSendBatchFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    TestSms* self = TEST_SMS(ext);
+    TestSmsReq* req = test_sms_req_new(self, destroy, user_data);
+
+    self->batches++;
+    req->smsc = g_strdup(smsc);
+    req->flags = flags;
+    req->batch_complete = complete;
+    return req->id;
+}
+
+static
+guint
+test_sms_send_batch_not_reached(
+    BinderExtSms* ext,
+    const char* smsc,
+    const BinderExtSmsPdu* pdus,
+    guint count,
+    BINDER_EXT_SMS_SEND_FLAGS flags,
+    BinderExtSmsSendBatchFunc complete,
+    GDestroyNotify destroy,
+    void* user_data)
+{
+    g_assert_not_reached();
+    return 0;
+}
+
+static
+void
+test_sms_cancel(
+    BinderExtSms* ext,
+    guint id)
+{
+    TestSms* self = TEST_SMS(ext);
+    GSList* l;
+
+    for (l = self->reqs; l; l = l->next) {
+        TestSmsReq* req = l->data;
+
+        if (req->id == id) {
+            self->cancelled++;
+            test_sms_req_done(self, req, FALSE, 0, 0);
+            return;
+        }
+    }
+}
+
+static
+void
+test_sms_init(
+    TestSms* self)
+{
+    self->fail_send = -1;
+}
+
+static
+void
+test_sms_finalize(
+    GObject* object)
+{
+    g_assert(!TEST_SMS(object)->reqs);
+    G_OBJECT_CLASS(test_sms_parent_class)->finalize(object);
+}
+
+static
+void
+test_sms_class_init(
+    TestSmsClass* klass)
+{
+    G_OBJECT_CLASS(klass)->finalize = test_sms_finalize;
+}
+
+/*==========================================================================*
+ * Version 1 implementation, send_batch must be ignored
+ *==========================================================================*/
+
+typedef TestSmsClass TestSms1Class;
+typedef TestSms TestSms1;
+
+static void test_sms1_iface_init(BinderExtSmsInterface* iface);
+G_DEFINE_TYPE_WITH_CODE(TestSms1, test_sms1, TEST_TYPE_SMS,
+G_IMPLEMENT_INTERFACE(BINDER_EXT_TYPE_SMS, test_sms1_iface_init))
+
+#define TEST_TYPE_SMS1 test_sms1_get_type()
+
+static
+void
+test_sms1_iface_init(
+    BinderExtSmsInterface* iface)
+{
+    iface->version = 1;
+    iface->send = test_sms_send;
+    iface->cancel = test_sms_cancel;
+    iface->send_batch = test_sms_send_batch_not_reached;
+}
+
+static
+void
+test_sms1_init(
+    TestSms1* self)
+{
+}
+
+static
+void
+test_sms1_class_init(
+    TestSms1Class* klass)
+{
+}
+
+/*==========================================================================*
+ * Version 2 implementation
+ *==========================================================================*/
+
+typedef TestSmsClass TestSms2Class;
+typedef TestSms TestSms2;
+
+static void test_sms2_iface_init(BinderExtSmsInterface* iface);
+G_DEFINE_TYPE_WITH_CODE(TestSms2, test_sms2, TEST_TYPE_SMS,
+G_IMPLEMENT_INTERFACE(BINDER_EXT_TYPE_SMS, test_sms2_iface_init))
+
+#define TEST_TYPE_SMS2 test_sms2_get_type()
+
+static
+void
+test_sms2_iface_init(
+    BinderExtSmsInterface* iface)
+{
+    iface->version = BINDER_EXT_SMS_INTERFACE_VERSION;
+    iface->send = test_sms_send;
+    iface->cancel = test_sms_cancel;
+    iface->send_batch = test_sms_send_batch;
+}
+
+static
+void
+test_sms2_init(
+    TestSms2* self)
+{
+}
+
+static
+void
+test_sms2_class_init(
+    TestSms2Class* klass)
+{
+}
+
+/*==========================================================================*
+ * Completion tracking
+ *==========================================================================*/
+
+typedef struct test_result {
+    int complete;
+    int destroy;
+    guint index;
+    BINDER_EXT_SMS_SEND_RESULT result;
+    guint msg_ref;
+} TestResult;
+
+static
+void
+test_result_complete(
+    BinderExtSms* ext,
+    guint index,
+    BINDER_EXT_SMS_SEND_RESULT result,
+    guint msg_ref,
+    void* user_data)
+{
+    TestResult* test = user_data;
+
+    g_assert(!test->destroy);
+    test->complete++;
+    test->index = index;
+    test->result = result;
+    test->msg_ref = msg_ref;
+}
+
+static
+void
+test_result_destroy(
+    void* user_data)
+{
+    TestResult* test = user_data;
+
+    test->destroy++;
+}
+
+static const guint8 test_pdu1[] = { 0x01, 0x02, 0x03 };
+static const guint8 test_pdu2[] = { 0x04, 0x05 };
+static const guint8 test_pdu3[] = { 0x06 };
+#define TEST_SMSC "+358401234567"
+
+static
+guint
+test_send_batch(
+    BinderExtSms* ext,
+    guint count,
+    BINDER_EXT_SMS_SEND_FLAGS flags,
+    TestResult* result)
+{
+    /* The buffers don't have to outlive the call */
+    guint8 buf1[sizeof(test_pdu1)];
+    guint8 buf2[sizeof(test_pdu2)];
+    guint8 buf3[sizeof(test_pdu3)];
+    BinderExtSmsPdu pdus[3];
+    char* smsc = g_strdup(TEST_SMSC);
+    guint id;
+
+    memcpy(buf1, test_pdu1, sizeof(buf1));
+    memcpy(buf2, test_pdu2, sizeof(buf2));
+    memcpy(buf3, test_pdu3, sizeof(buf3));
+    pdus[0].pdu = buf1;
+    pdus[0].pdu_len = sizeof(buf1);
+    pdus[0].msg_ref = 10;
+    pdus[1].pdu = buf2;
+    pdus[1].pdu_len = sizeof(buf2);
+    pdus[1].msg_ref = 11;
+    pdus[2].pdu = buf3;
+    pdus[2].pdu_len = sizeof(buf3);
+    pdus[2].msg_ref = 12;
+
+    g_assert_cmpuint(count, <= ,G_N_ELEMENTS(pdus));
+    memset(result, 0, sizeof(*result));
+    id = binder_ext_sms_send_batch(ext, smsc, pdus, count, flags,
+        test_result_complete, test_result_destroy, result);
+    memset(buf1, 0, sizeof(buf1));
+    memset(buf2, 0, sizeof(buf2));
+    memset(buf3, 0, sizeof(buf3));
+    g_free(smsc);
+    return id;
+}
+
+static
+void
+test_check_req(
+    TestSms* test,
+    const void* pdu,
+    gsize pdu_len,
+    guint msg_ref,
+    BINDER_EXT_SMS_SEND_FLAGS flags)
+{
+    TestSmsReq* req = test_sms_req(test);
+    gsize size;
+    const void* data = g_bytes_get_data(req->pdu, &size);
+
+    g_assert_cmpuint(g_slist_length(test->reqs), == ,1);
+    g_assert_cmpstr(req->smsc, == ,TEST_SMSC);
+    g_assert_cmpuint(size, == ,pdu_len);
+    g_assert(!memcmp(data, pdu, size));
+    g_assert_cmpuint(req->msg_ref, == ,msg_ref);
+    g_assert_cmpint(req->flags, == ,flags);
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    BinderExtSms* ext = g_object_new(TEST_TYPE_SMS2, NULL);
+    BinderExtSmsPdu pdu;
+    TestResult result;
+
+    memset(&pdu, 0, sizeof(pdu));
+    memset(&result, 0, sizeof(result));
+
+    /* NULL resistance */
+    g_assert(!binder_ext_sms_send_batch(NULL, NULL, &pdu, 1,
+        BINDER_EXT_SMS_SEND_NO_FLAGS, NULL, NULL, NULL));
+    g_assert(!binder_ext_sms_send_batch(ext, NULL, NULL, 1,
+        BINDER_EXT_SMS_SEND_NO_FLAGS, NULL, NULL, NULL));
+    g_assert(!test_send_batch(ext, 0, BINDER_EXT_SMS_SEND_NO_FLAGS,
+        &result));
+    g_assert(!result.complete);
+    g_assert(!result.destroy);
+    binder_ext_sms_cancel_batch(NULL, 1);
+    binder_ext_sms_cancel_batch(ext, 0);
+    g_assert_cmpint(TEST_SMS(ext)->batches, == ,0);
+    g_assert_cmpint(TEST_SMS(ext)->cancelled, == ,0);
+    binder_ext_sms_unref(ext);
+}
+
+/*==========================================================================*
+ * batch
+ *==========================================================================*/
+
+static
+void
+test_batch(
+    void)
+{
+    TestSms* test = g_object_new(TEST_TYPE_SMS2, NULL);
+    BinderExtSms* ext = BINDER_EXT_SMS(test);
+    TestResult result;
+    guint id;
+
+    /* Version 2 implementation receives the whole batch */
+    id = test_send_batch(ext, 3, BINDER_EXT_SMS_SEND_NO_FLAGS, &result);
+    g_assert(id);
+    g_assert_cmpint(test->batches, == ,1);
+    g_assert_cmpint(test->sends, == ,0);
+    test_sms_complete(test, BINDER_EXT_SMS_SEND_RESULT_OK, 1);
+    g_assert_cmpint(result.complete, == ,1);
+    g_assert_cmpint(result.destroy, == ,1);
+
+    /* And the cancel */
+    id = test_send_batch(ext, 3, BINDER_EXT_SMS_SEND_NO_FLAGS, &result);
+    g_assert(id);
+    binder_ext_sms_cancel_batch(ext, id);
+    g_assert_cmpint(test->cancelled, == ,1);
+    g_assert_cmpint(result.complete, == ,0);
+    g_assert_cmpint(result.destroy, == ,1);
+    binder_ext_sms_unref(ext);
+}
+
+/*==========================================================================*
+ * fallback
+ *==========================================================================*/
+
+static
+void
+test_fallback(
+    void)
+{
+    TestSms* test = g_object_new(TEST_TYPE_SMS1, NULL);
+    BinderExtSms* ext = BINDER_EXT_SMS(test);
+    const BINDER_EXT_SMS_SEND_FLAGS more = BINDER_EXT_SMS_SEND_RETRY |
+        BINDER_EXT_SMS_SEND_EXPECT_MORE;
+    TestResult result;
+    guint id;
+
+    /* Version 1 implementation sends the segments one after another */
+    id = test_send_batch(ext, 3, BINDER_EXT_SMS_SEND_RETRY, &result);
+    g_assert(id);
+    test_check_req(test, test_pdu1, sizeof(test_pdu1), 10, more);
+
+    test_sms_complete(test, BINDER_EXT_SMS_SEND_RESULT_OK, 100);
+    g_assert_cmpint(result.complete, == ,1);
+    g_assert_cmpuint(result.index, == ,0);
+    g_assert_cmpuint(result.msg_ref, == ,100);
+    test_check_req(test, test_pdu2, sizeof(test_pdu2), 11, more);
+
+    /* The last one is not followed by more */
+    test_sms_complete(test, BINDER_EXT_SMS_SEND_RESULT_OK, 101);
+    g_assert_cmpint(result.complete, == ,2);
+    g_assert_cmpuint(result.index, == ,1);
+    g_assert_cmpuint(result.msg_ref, == ,101);
+    test_check_req(test, test_pdu3, sizeof(test_pdu3), 12,
+        BINDER_EXT_SMS_SEND_RETRY);
+
+    test_sms_complete(test, BINDER_EXT_SMS_SEND_RESULT_OK, 102);
+    g_assert_cmpint(result.complete, == ,3);
+    g_assert_cmpuint(result.index, == ,2);
+    g_assert_cmpint(result.result, == ,BINDER_EXT_SMS_SEND_RESULT_OK);
+    g_assert_cmpuint(result.msg_ref, == ,102);
+    g_assert_cmpint(result.destroy, == ,1);
+    g_assert(!test->reqs);
+    g_assert_cmpint(test->sends, == ,3);
+
+    /* The id is no longer valid */
+    binder_ext_sms_cancel_batch(ext, id);
+    g_assert_cmpint(test->cancelled, == ,0);
+
+    /* Single segment doesn't expect more */
+    id = test_send_batch(ext, 1, BINDER_EXT_SMS_SEND_EXPECT_MORE, &result);
+    g_assert(id);
+    test_check_req(test, test_pdu1, sizeof(test_pdu1), 10,
+        BINDER_EXT_SMS_SEND_NO_FLAGS);
+    test_sms_complete(test, BINDER_EXT_SMS_SEND_RESULT_OK, 103);
+    g_assert_cmpint(result.complete, == ,1);
+    g_assert_cmpint(result.destroy, == ,1);
+    binder_ext_sms_unref(ext);
+}
+
+/*==========================================================================*
+ * fallback_error
+ *==========================================================================*/
+
+static
+void
+test_fallback_error(
+    void)
+{
+    TestSms* test = g_object_new(TEST_TYPE_SMS1, NULL);
+    BinderExtSms* ext = BINDER_EXT_SMS(test);
+    TestResult result;
+
+    /* The first failure finishes the batch */
+    g_assert(test_send_batch(ext, 3, BINDER_EXT_SMS_SEND_NO_FLAGS, &result));
+    test_sms_complete(test, BINDER_EXT_SMS_SEND_RESULT_OK, 100);
+    test_sms_complete(test, BINDER_EXT_SMS_SEND_RESULT_ERROR_NO_SERVICE, 0);
+    g_assert_cmpint(result.complete, == ,2);
+    g_assert_cmpuint(result.index, == ,1);
+    g_assert_cmpint(result.result, == ,
+        BINDER_EXT_SMS_SEND_RESULT_ERROR_NO_SERVICE);
+    g_assert_cmpint(result.destroy, == ,1);
+    g_assert(!test->reqs);
+    g_assert_cmpint(test->sends, == ,2);
+    binder_ext_sms_unref(ext);
+}
+
+/*==========================================================================*
+ * fallback_fail
+ *==========================================================================*/
+
+static
+void
+test_fallback_fail(
+    void)
+{
+    TestSms* test = g_object_new(TEST_TYPE_SMS1, NULL);
+    BinderExtSms* ext = BINDER_EXT_SMS(test);
+    TestResult result;
+
+    /* The second segment doesn't go through */
+    test->fail_send = 1;
+    g_assert(test_send_batch(ext, 3, BINDER_EXT_SMS_SEND_NO_FLAGS, &result));
+    test_sms_complete(test, BINDER_EXT_SMS_SEND_RESULT_OK, 100);
+    g_assert_cmpint(result.complete, == ,2);
+    g_assert_cmpuint(result.index, == ,1);
+    g_assert_cmpint(result.result, == ,BINDER_EXT_SMS_SEND_RESULT_ERROR);
+    g_assert_cmpuint(result.msg_ref, == ,0);
+    g_assert_cmpint(result.destroy, == ,1);
+    g_assert(!test->reqs);
+
+    /* The first one doesn't, no callbacks */
+    test->sends = 0;
+    test->fail_send = 0;
+    g_assert(!test_send_batch(ext, 3, BINDER_EXT_SMS_SEND_NO_FLAGS, &result));
+    g_assert_cmpint(result.complete, == ,0);
+    g_assert_cmpint(result.destroy, == ,0);
+    binder_ext_sms_unref(ext);
+}
+
+/*==========================================================================*
+ * fallback_cancel
+ *==========================================================================*/
+
+static
+void
+test_fallback_cancel(
+    void)
+{
+    TestSms* test = g_object_new(TEST_TYPE_SMS1, NULL);
+    BinderExtSms* ext = BINDER_EXT_SMS(test);
+    TestResult result;
+    guint id;
+
+    id = test_send_batch(ext, 3, BINDER_EXT_SMS_SEND_NO_FLAGS, &result);
+    g_assert(id);
+    test_sms_complete(test, BINDER_EXT_SMS_SEND_RESULT_OK, 100);
+    g_assert_cmpint(result.complete, == ,1);
+
+    /* The segment being sent gets cancelled, nothing is sent after that */
+    binder_ext_sms_cancel_batch(ext, id);
+    g_assert_cmpint(test->cancelled, == ,1);
+    g_assert(!test->reqs);
+    g_assert_cmpint(test->sends, == ,2);
+    g_assert_cmpint(result.complete, == ,1);
+    g_assert_cmpint(result.destroy, == ,1);
+
+    /* Second cancel does nothing */
+    binder_ext_sms_cancel_batch(ext, id);
+    g_assert_cmpint(test->cancelled, == ,1);
+    g_assert_cmpint(result.destroy, == ,1);
+    binder_ext_sms_unref(ext);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/ext_sms/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("batch"), test_batch);
+    g_test_add_func(TEST_("fallback"), test_fallback);
+    g_test_add_func(TEST_("fallback_error"), test_fallback_error);
+    g_test_add_func(TEST_("fallback_fail"), test_fallback_fail);
+    g_test_add_func(TEST_("fallback_cancel"), test_fallback_cancel);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,214 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_oplist.h"
+
+#include <ofono/netreg.h>
+
+#include <gutil_log.h>
+
+#include <string.h>
+
+GLOG_MODULE_DEFINE("unit_oplist");
+
+static
+void
+test_op_init(
+    struct ofono_network_operator* op,
+    const char* mcc,
+    const char* mnc,
+    int tech,
+    int status,
+    const char* name)
+{
+    memset(op, 0, sizeof(*op));
+    g_strlcpy(op->mcc, mcc, sizeof(op->mcc));
+    g_strlcpy(op->mnc, mnc, sizeof(op->mnc));
+    g_strlcpy(op->name, name, sizeof(op->name));
+    op->tech = tech;
+    op->status = status;
+}
+
+/*==========================================================================*
+ * null
+ *==========================================================================*/
+
+static
+void
+test_null(
+    void)
+{
+    BinderOpList* list;
+    struct ofono_network_operator op;
+
+    test_op_init(&op, "244", "91", OFONO_ACCESS_TECHNOLOGY_GSM,
+        OFONO_OPERATOR_STATUS_AVAILABLE, "Test");
+
+    /* NULL is tolerated */
+    binder_oplist_free(NULL);
+    g_assert(!binder_oplist_copy(NULL));
+
+    /* And creates a new list */
+    list = binder_oplist_reserve(NULL, 2);
+    g_assert(list);
+    g_assert_cmpuint(list->count, == ,0);
+    binder_oplist_free(list);
+
+    list = binder_oplist_set_count(NULL, 2);
+    g_assert(list);
+    g_assert_cmpuint(list->count, == ,2);
+    binder_oplist_free(list);
+
+    list = binder_oplist_append(NULL, &op);
+    g_assert_cmpuint(list->count, == ,1);
+    binder_oplist_free(list);
+
+    list = binder_oplist_add(NULL, &op);
+    g_assert_cmpuint(list->count, == ,1);
+    g_assert_cmpstr(list->op[0].name, == ,"Test");
+    binder_oplist_free(list);
+}
+
+/*==========================================================================*
+ * dedup
+ *==========================================================================*/
+
+static
+void
+test_dedup(
+    void)
+{
+    BinderOpList* list = binder_oplist_new();
+    struct ofono_network_operator op;
+
+    test_op_init(&op, "244", "91", OFONO_ACCESS_TECHNOLOGY_GSM,
+        OFONO_OPERATOR_STATUS_AVAILABLE, "");
+    g_assert(binder_oplist_add(list, &op) == list);
+    g_assert(binder_oplist_add(list, &op) == list);
+    g_assert_cmpuint(list->count, == ,1);
+
+    /* Different technology is a different entry */
+    op.tech = OFONO_ACCESS_TECHNOLOGY_EUTRAN;
+    binder_oplist_add(list, &op);
+    g_assert_cmpuint(list->count, == ,2);
+
+    /* And so is different MNC */
+    test_op_init(&op, "244", "05", OFONO_ACCESS_TECHNOLOGY_GSM,
+        OFONO_OPERATOR_STATUS_AVAILABLE, "Other");
+    binder_oplist_add(list, &op);
+    g_assert_cmpuint(list->count, == ,3);
+
+    /* Duplicate fills in the missing name and upgrades the status */
+    test_op_init(&op, "244", "91", OFONO_ACCESS_TECHNOLOGY_GSM,
+        OFONO_OPERATOR_STATUS_CURRENT, "Test");
+    binder_oplist_add(list, &op);
+    g_assert_cmpuint(list->count, == ,3);
+    g_assert_cmpstr(list->op[0].name, == ,"Test");
+    g_assert_cmpint(list->op[0].status, == ,OFONO_OPERATOR_STATUS_CURRENT);
+
+    /* But never downgrades it or replaces the existing name */
+    test_op_init(&op, "244", "91", OFONO_ACCESS_TECHNOLOGY_GSM,
+        OFONO_OPERATOR_STATUS_FORBIDDEN, "Renamed");
+    binder_oplist_add(list, &op);
+    g_assert_cmpuint(list->count, == ,3);
+    g_assert_cmpstr(list->op[0].name, == ,"Test");
+    g_assert_cmpint(list->op[0].status, == ,OFONO_OPERATOR_STATUS_CURRENT);
+    g_assert_cmpstr(list->op[1].name, == ,"");
+    g_assert_cmpint(list->op[1].status, == ,OFONO_OPERATOR_STATUS_AVAILABLE);
+    binder_oplist_free(list);
+}
+
+/*==========================================================================*
+ * index
+ *==========================================================================*/
+
+static
+void
+test_index(
+    void)
+{
+    BinderOpList* list = binder_oplist_new_sized(4);
+    BinderOpList* copy;
+    struct ofono_network_operator op;
+
+    /* Entries filled in by the caller get indexed by the first add */
+    binder_oplist_set_count(list, 2);
+    test_op_init(list->op, "244", "91", OFONO_ACCESS_TECHNOLOGY_GSM,
+        OFONO_OPERATOR_STATUS_AVAILABLE, "One");
+    test_op_init(list->op + 1, "244", "05", OFONO_ACCESS_TECHNOLOGY_GSM,
+        OFONO_OPERATOR_STATUS_AVAILABLE, "Two");
+    test_op_init(&op, "244", "05", OFONO_ACCESS_TECHNOLOGY_GSM,
+        OFONO_OPERATOR_STATUS_CURRENT, "");
+    binder_oplist_add(list, &op);
+    g_assert_cmpuint(list->count, == ,2);
+    g_assert_cmpint(list->op[1].status, == ,OFONO_OPERATOR_STATUS_CURRENT);
+
+    /* Appended entries are indexed too */
+    test_op_init(&op, "244", "12", OFONO_ACCESS_TECHNOLOGY_UTRAN,
+        OFONO_OPERATOR_STATUS_AVAILABLE, "");
+    binder_oplist_append(list, &op);
+    g_assert_cmpuint(list->count, == ,3);
+    g_strlcpy(op.name, "Three", sizeof(op.name));
+    binder_oplist_add(list, &op);
+    g_assert_cmpuint(list->count, == ,3);
+    g_assert_cmpstr(list->op[2].name, == ,"Three");
+
+    /* Reserving doesn't change the contents */
+    binder_oplist_reserve(list, 10);
+    g_assert_cmpuint(list->count, == ,3);
+    g_assert_cmpstr(list->op[0].name, == ,"One");
+
+    /* Copy */
+    copy = binder_oplist_copy(list);
+    g_assert(copy != list);
+    g_assert_cmpuint(copy->count, == ,3);
+    g_assert(!memcmp(copy->op, list->op, 3 * sizeof(op)));
+    binder_oplist_free(list);
+
+    /* The copy builds its own index */
+    binder_oplist_add(copy, &op);
+    g_assert_cmpuint(copy->count, == ,3);
+    binder_oplist_free(copy);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/oplist/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("null"), test_null);
+    g_test_add_func(TEST_("dedup"), test_dedup);
+    g_test_add_func(TEST_("index"), test_index);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,682 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_base.h"
+#include "binder_decoder.h"
+#include "binder_log.h"
+#include "binder_sim_io_cache.h"
+#include "binder_util.h"
+#include "binder_wakeup.h"
+
+#include <gutil_misc.h>
+#include <gutil_log.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+GLOG_MODULE_DEFINE("unit_perf");
+
+/*
+ * Each workload drives the code which runs on the corresponding hot path
+ * of the plugin and reports ns/op and allocs/op. The results are compared
+ * against the baseline file (UNIT_PERF_BASELINE, "baseline" by default),
+ * one "name ns_per_op allocs_per_op" line per workload. Allocation counts
+ * are deterministic and are checked with a tight tolerance, timings are
+ * machine dependent and get a much wider one (both in percent, see
+ * UNIT_PERF_ALLOC_TOLERANCE and UNIT_PERF_TIME_TOLERANCE, zero disables
+ * the check). Workloads missing from the baseline are only reported.
+ * Setting UNIT_PERF_WRITE to a file name writes the current results
+ * there, in the baseline format.
+ */
+
+#define PERF_BASELINE_FILE "baseline"
+#define PERF_DEFAULT_ALLOC_TOLERANCE (10)
+#define PERF_DEFAULT_TIME_TOLERANCE (200)
+
+typedef struct perf_result {
+    const char* name;
+    guint ops;
+    double ns_per_op;
+    double allocs_per_op;
+} PerfResult;
+
+/*==========================================================================*
+ * Allocation counter
+ *==========================================================================*/
+
+static gboolean perf_allocs_counted = FALSE;
+static gint perf_allocs = 0;
+
+#ifdef __GLIBC__
+
+/*
+ * glibc lets the executable take over malloc() and friends. Everything
+ * still ends up in the glibc allocator, just gets counted on the way.
+ * The counter is updated from the decoder thread too.
+ */
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t n, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+void*
+malloc(
+    size_t size)
+{
+    __atomic_fetch_add(&perf_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void*
+calloc(
+    size_t n,
+    size_t size)
+{
+    __atomic_fetch_add(&perf_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(n, size);
+}
+
+void*
+realloc(
+    void* ptr,
+    size_t size)
+{
+    if (!ptr) {
+        __atomic_fetch_add(&perf_allocs, 1, __ATOMIC_RELAXED);
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void
+free(
+    void* ptr)
+{
+    __libc_free(ptr);
+}
+
+#endif /* __GLIBC__ */
+
+static
+gint
+perf_allocs_now(
+    void)
+{
+    return __atomic_load_n(&perf_allocs, __ATOMIC_RELAXED);
+}
+
+/*==========================================================================*
+ * Baseline
+ *==========================================================================*/
+
+static
+guint
+perf_env_uint(
+    const char* name,
+    guint def)
+{
+    const char* value = getenv(name);
+    int ival;
+
+    return (value && gutil_parse_int(value, 0, &ival) && ival >= 0) ?
+        (guint) ival : def;
+}
+
+static
+gboolean
+perf_baseline_find(
+    const char* name,
+    double* ns_per_op,
+    double* allocs_per_op)
+{
+    const char* env = getenv("UNIT_PERF_BASELINE");
+    const char* file = (env && env[0]) ? env : PERF_BASELINE_FILE;
+    gboolean found = FALSE;
+    char* contents = NULL;
+
+    if (g_file_get_contents(file, &contents, NULL, NULL)) {
+        char** lines = g_strsplit(contents, "\n", -1);
+        char** ptr;
+
+        for (ptr = lines; *ptr && !found; ptr++) {
+            char key[64];
+            double ns, allocs;
+
+            if (**ptr != '#' && sscanf(*ptr, "%63s %lf %lf", key, &ns,
+                &allocs) == 3 && !strcmp(key, name)) {
+                *ns_per_op = ns;
+                *allocs_per_op = allocs;
+                found = TRUE;
+            }
+        }
+        g_strfreev(lines);
+        g_free(contents);
+    }
+    return found;
+}
+
+static
+void
+perf_write_result(
+    const PerfResult* result)
+{
+    const char* file = getenv("UNIT_PERF_WRITE");
+
+    if (file && file[0]) {
+        FILE* out = fopen(file, "a");
+
+        if (out) {
+            fprintf(out, "%s %.1f %.2f\n", result->name, result->ns_per_op,
+                result->allocs_per_op);
+            fclose(out);
+        }
+    }
+}
+
+static
+void
+perf_check(
+    const PerfResult* result)
+{
+    const guint alloc_tolerance = perf_env_uint("UNIT_PERF_ALLOC_TOLERANCE",
+        PERF_DEFAULT_ALLOC_TOLERANCE);
+    const guint time_tolerance = perf_env_uint("UNIT_PERF_TIME_TOLERANCE",
+        PERF_DEFAULT_TIME_TOLERANCE);
+    double base_ns, base_allocs;
+
+    /* Always visible (as a TAP comment), that's the point of running it */
+    g_print("# %s: %u ops, %.1f ns/op", result->name, result->ops,
+        result->ns_per_op);
+    if (perf_allocs_counted) {
+        g_print(", %.2f allocs/op", result->allocs_per_op);
+    }
+    g_print("\n");
+    perf_write_result(result);
+
+    if (perf_baseline_find(result->name, &base_ns, &base_allocs)) {
+        /* An extra allocation per op is allowed for rounding */
+        if (perf_allocs_counted && alloc_tolerance) {
+            const double max_allocs = base_allocs *
+                (100 + alloc_tolerance) / 100 + 1;
+
+            if (result->allocs_per_op > max_allocs) {
+                g_printerr("%s: %.2f allocs/op exceeds %.2f (baseline "
+                    "%.2f)\n", result->name, result->allocs_per_op,
+                    max_allocs, base_allocs);
+                g_test_fail();
+            }
+        }
+        if (time_tolerance) {
+            const double max_ns = base_ns * (100 + time_tolerance) / 100;
+
+            if (result->ns_per_op > max_ns) {
+                g_printerr("%s: %.1f ns/op exceeds %.1f (baseline %.1f)\n",
+                    result->name, result->ns_per_op, max_ns, base_ns);
+                g_test_fail();
+            }
+        }
+    } else {
+        GDEBUG("%s: no baseline", result->name);
+    }
+}
+
+typedef struct perf_timer {
+    gint64 start;
+    gint allocs;
+} PerfTimer;
+
+static
+void
+perf_start(
+    PerfTimer* timer)
+{
+    timer->allocs = perf_allocs_now();
+    timer->start = g_get_monotonic_time();
+}
+
+static
+void
+perf_stop(
+    PerfTimer* timer,
+    const char* name,
+    guint ops)
+{
+    const gint64 us = g_get_monotonic_time() - timer->start;
+    PerfResult result;
+
+    result.name = name;
+    result.ops = ops;
+    result.ns_per_op = us * 1000.0 / ops;
+    result.allocs_per_op = (double)(perf_allocs_now() - timer->allocs) / ops;
+    perf_check(&result);
+}
+
+/*==========================================================================*
+ * Test object
+ *==========================================================================*/
+
+typedef enum perf_property {
+    PERF_PROPERTY_ANY,
+    PERF_PROPERTY_STRENGTH,
+    PERF_PROPERTY_CALLS,
+    PERF_PROPERTY_COUNT
+} PERF_PROPERTY;
+
+typedef BinderBaseClass PerfObjectClass;
+typedef struct perf_object_data {
+    int strength;
+    guint generation;
+    GPtrArray* calls;
+} PerfObjectData;
+typedef struct perf_object {
+    BinderBase base;
+    PerfObjectData pub;
+} PerfObject;
+
+G_DEFINE_TYPE(PerfObject, perf_object, BINDER_TYPE_BASE)
+#define PERF_TYPE perf_object_get_type()
+#define PERF(obj) G_TYPE_CHECK_INSTANCE_CAST(obj, PERF_TYPE, PerfObject)
+BINDER_BASE_ASSERT_COUNT(PERF_PROPERTY_COUNT);
+
+static
+void
+perf_object_init(
+    PerfObject* self)
+{
+    self->pub.calls = g_ptr_array_new_with_free_func(g_free);
+}
+
+static
+void
+perf_snapshot_clear(
+    gpointer snapshot)
+{
+    PerfObjectData* snap = snapshot;
+
+    g_ptr_array_unref(snap->calls);
+}
+
+static
+gpointer
+perf_object_snapshot(
+    BinderBase* base)
+{
+    PerfObject* self = PERF(base);
+    PerfObjectData* snap = binder_base_snapshot_new(sizeof(*snap),
+        perf_snapshot_clear);
+
+    *snap = self->pub;
+    g_ptr_array_ref(snap->calls);
+    return snap;
+}
+
+static
+void
+perf_object_finalize(
+    GObject* object)
+{
+    g_ptr_array_unref(PERF(object)->pub.calls);
+    G_OBJECT_CLASS(perf_object_parent_class)->finalize(object);
+}
+
+static
+void
+perf_object_class_init(
+    PerfObjectClass* klass)
+{
+    BINDER_BASE_CLASS(klass)->public_offset = G_STRUCT_OFFSET(PerfObject, pub);
+    BINDER_BASE_CLASS(klass)->snapshot = perf_object_snapshot;
+    G_OBJECT_CLASS(klass)->finalize = perf_object_finalize;
+}
+
+static
+void
+perf_property_cb(
+    PerfObjectData* data,
+    PERF_PROPERTY property,
+    void* user_data)
+{
+    (*(guint*)user_data)++;
+}
+
+/*==========================================================================*
+ * signal_strength
+ *==========================================================================*/
+
+#define PERF_STRENGTH_INDS (10000)
+
+static
+void
+test_signal_strength(
+    void)
+{
+    PerfObject* obj = g_object_new(PERF_TYPE, NULL);
+    BinderBase* base = &obj->base;
+    guint count = 0;
+    PerfTimer timer;
+    gulong id;
+    int i;
+
+    id = binder_base_add_property_handler(base, PERF_PROPERTY_STRENGTH,
+        G_CALLBACK(perf_property_cb), &count);
+
+    /*
+     * Every indication is counted (stats and wakeups), most of them
+     * don't change the reported level.
+     */
+    perf_start(&timer);
+    for (i = 0; i < PERF_STRENGTH_INDS; i++) {
+        const int strength = 40 + (i / 16) % 8;
+
+        binder_wakeup_ind(RADIO_IND_CURRENT_SIGNAL_STRENGTH);
+        if (obj->pub.strength != strength) {
+            obj->pub.strength = strength;
+            binder_base_emit_property_change(base, PERF_PROPERTY_STRENGTH);
+        }
+    }
+    perf_stop(&timer, "signal_strength", PERF_STRENGTH_INDS);
+
+    g_assert_cmpuint(count, == ,PERF_STRENGTH_INDS / 16);
+    g_signal_handler_disconnect(obj, id);
+    g_object_unref(obj);
+    binder_wakeup_cleanup();
+}
+
+/*==========================================================================*
+ * cell_info
+ *==========================================================================*/
+
+#define PERF_CELL_LISTS (1000)
+#define PERF_CELLS_PER_LIST (30)
+
+typedef struct perf_cell {
+    guint type;
+    gboolean registered;
+    int mcc, mnc, tac, pci, ci;
+    int rsrp, rsrq;
+} PerfCell;
+
+typedef struct perf_cell_job {
+    guint seq;
+    PerfCell raw[PERF_CELLS_PER_LIST];
+    GPtrArray* cells;
+    guint* done;
+} PerfCellJob;
+
+static
+gint
+perf_cell_compare(
+    gconstpointer a,
+    gconstpointer b)
+{
+    const PerfCell* c1 = *(const PerfCell**)a;
+    const PerfCell* c2 = *(const PerfCell**)b;
+
+    if (c1->registered != c2->registered) {
+        return c1->registered ? -1 : 1;
+    }
+    return c2->rsrp - c1->rsrp;
+}
+
+static
+void
+perf_cell_decode(
+    gpointer data)
+{
+    PerfCellJob* job = data;
+    guint i;
+
+    /* Same shape of work as binder_cell_info_decode_cells() */
+    job->cells = g_ptr_array_new_full(PERF_CELLS_PER_LIST, g_free);
+    for (i = 0; i < PERF_CELLS_PER_LIST; i++) {
+        g_ptr_array_add(job->cells, gutil_memdup(job->raw + i,
+            sizeof(PerfCell)));
+    }
+    g_ptr_array_sort(job->cells, perf_cell_compare);
+}
+
+static
+void
+perf_cell_done(
+    gpointer data)
+{
+    PerfCellJob* job = data;
+
+    g_assert_cmpuint(job->cells->len, == ,PERF_CELLS_PER_LIST);
+    g_assert(((PerfCell*)job->cells->pdata[0])->registered);
+    (*job->done)++;
+    g_ptr_array_unref(job->cells);
+    g_free(job);
+}
+
+static
+void
+test_cell_info(
+    void)
+{
+    BinderDecoder* decoder = binder_decoder_new("perf", TRUE);
+    guint done = 0;
+    PerfTimer timer;
+    guint i, k;
+
+    perf_start(&timer);
+    for (i = 0; i < PERF_CELL_LISTS; i++) {
+        PerfCellJob* job = g_new0(PerfCellJob, 1);
+
+        /* This part is copied out of the parcel on the main thread */
+        job->seq = i;
+        job->done = &done;
+        for (k = 0; k < PERF_CELLS_PER_LIST; k++) {
+            PerfCell* cell = job->raw + k;
+
+            cell->type = 3; /* LTE */
+            cell->registered = (k == PERF_CELLS_PER_LIST / 2);
+            cell->mcc = 244;
+            cell->mnc = 91;
+            cell->tac = 1000 + k;
+            cell->pci = (i + k) % 504;
+            cell->ci = 0x10000 + k;
+            cell->rsrp = 80 + (i * 7 + k * 13) % 60;
+            cell->rsrq = 3 + k % 17;
+        }
+        binder_decoder_submit(decoder, "cell_info", perf_cell_decode,
+            perf_cell_done, job);
+    }
+    while (done < PERF_CELL_LISTS) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    perf_stop(&timer, "cell_info", PERF_CELL_LISTS);
+    binder_decoder_unref(decoder);
+}
+
+/*==========================================================================*
+ * data_call_list
+ *==========================================================================*/
+
+#define PERF_DATA_CALL_LISTS (1000)
+#define PERF_DATA_CALLS (4)
+
+static
+void
+test_data_call_list(
+    void)
+{
+    PerfObject* obj = g_object_new(PERF_TYPE, NULL);
+    BinderBase* base = &obj->base;
+    guint count = 0;
+    PerfTimer timer;
+    gulong id;
+    int i, k;
+
+    id = binder_base_add_property_handler(base, PERF_PROPERTY_CALLS,
+        G_CALLBACK(perf_property_cb), &count);
+    binder_base_update_snapshot(base);
+
+    /* Each change replaces the list and somebody reads the snapshot */
+    perf_start(&timer);
+    for (i = 0; i < PERF_DATA_CALL_LISTS; i++) {
+        GPtrArray* calls = g_ptr_array_new_full(PERF_DATA_CALLS, g_free);
+        gconstpointer snap;
+
+        for (k = 0; k < PERF_DATA_CALLS; k++) {
+            g_ptr_array_add(calls, g_strdup_printf("rmnet_data%d", k));
+        }
+        g_ptr_array_unref(obj->pub.calls);
+        obj->pub.calls = calls;
+        obj->pub.generation++;
+        binder_base_emit_property_change(base, PERF_PROPERTY_CALLS);
+
+        snap = binder_base_snapshot_ref(base);
+        g_assert_cmpuint(((const PerfObjectData*)snap)->generation, == ,
+            obj->pub.generation);
+        binder_base_snapshot_unref(snap);
+    }
+    perf_stop(&timer, "data_call_list", PERF_DATA_CALL_LISTS);
+
+    g_assert_cmpuint(count, == ,PERF_DATA_CALL_LISTS);
+    g_signal_handler_disconnect(obj, id);
+    g_object_unref(obj);
+}
+
+/*==========================================================================*
+ * sim_records
+ *==========================================================================*/
+
+#define PERF_SIM_RECORDS (500)
+#define PERF_SIM_RECORD_SIZE (28)
+#define PERF_SIM_CMD_READ_RECORD (0xb2)
+
+static
+void
+test_sim_records(
+    void)
+{
+    static const guchar path[] = { 0x3f, 0x00, 0x7f, 0x10 };
+    static const char aid[] = "a0000000871002ff";
+    BinderSimIoCache* cache = binder_sim_io_cache_new("perf", NULL);
+    guint8 record[PERF_SIM_RECORD_SIZE];
+    char* hex_record;
+    PerfTimer timer;
+    guint i;
+
+    memset(record, 0xff, sizeof(record));
+    memcpy(record, "Perf", 4);
+    hex_record = binder_encode_hex(record, sizeof(record));
+    binder_sim_io_cache_set_iccid(cache, "8935801234567890123");
+    g_assert(binder_sim_io_cache_active(cache));
+
+    /*
+     * Each record is read from the card (the response comes in as a hex
+     * string), stored in the cache and then served from there.
+     */
+    perf_start(&timer);
+    for (i = 0; i < PERF_SIM_RECORDS; i++) {
+        const guint fid = 0x6f40 + i % 8; /* Not a volatile one */
+        char* key = binder_sim_io_cache_key(aid, path, sizeof(path), fid,
+            PERF_SIM_CMD_READ_RECORD, 1 + i / 8, 4, PERF_SIM_RECORD_SIZE);
+        const BinderSimIoCacheEntry* entry;
+        gboolean verify;
+        guchar* data;
+        guint len = 0;
+
+        g_assert(!binder_sim_io_cache_get(cache, key, NULL));
+        data = binder_decode_hex(hex_record, -1, &len);
+        g_assert_cmpuint(len, == ,PERF_SIM_RECORD_SIZE);
+        binder_sim_io_cache_put(cache, key, fid, 0x90, 0, data, len);
+        g_free(data);
+
+        entry = binder_sim_io_cache_get(cache, key, &verify);
+        g_assert(entry);
+        g_assert(!verify);
+        g_free(key);
+    }
+    perf_stop(&timer, "sim_records", PERF_SIM_RECORDS);
+
+    g_free(hex_record);
+    binder_sim_io_cache_free(cache);
+}
+
+/*==========================================================================*
+ * multipart_sms
+ *==========================================================================*/
+
+#define PERF_SMS_MESSAGES (100)
+#define PERF_SMS_PARTS (3)
+#define PERF_SMS_TPDU_SIZE (140)
+
+static
+void
+test_multipart_sms(
+    void)
+{
+    guint8 tpdu[PERF_SMS_TPDU_SIZE];
+    PerfTimer timer;
+    guint i, k;
+
+    for (i = 0; i < sizeof(tpdu); i++) {
+        tpdu[i] = (guint8) (i * 31);
+    }
+
+    /* Outgoing parts are sent as hex strings, incoming counted */
+    perf_start(&timer);
+    for (i = 0; i < PERF_SMS_MESSAGES; i++) {
+        for (k = 0; k < PERF_SMS_PARTS; k++) {
+            char* hex;
+
+            tpdu[0] = (guint8) k;
+            hex = binder_encode_hex(tpdu, sizeof(tpdu));
+            g_assert_cmpuint(strlen(hex), == ,2 * PERF_SMS_TPDU_SIZE);
+            g_free(hex);
+            binder_wakeup_ind(RADIO_IND_NEW_SMS);
+        }
+    }
+    perf_stop(&timer, "multipart_sms", PERF_SMS_MESSAGES);
+    binder_wakeup_cleanup();
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/perf/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+#ifdef __GLIBC__
+    perf_allocs_counted = TRUE;
+#endif
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("signal_strength"), test_signal_strength);
+    g_test_add_func(TEST_("cell_info"), test_cell_info);
+    g_test_add_func(TEST_("data_call_list"), test_data_call_list);
+    g_test_add_func(TEST_("sim_records"), test_sim_records);
+    g_test_add_func(TEST_("multipart_sms"), test_multipart_sms);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,193 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_metrics.h"
+#include "binder_retry.h"
+
+#include <gutil_log.h>
+
+#include <string.h>
+
+GLOG_MODULE_DEFINE("unit_retry");
+
+/*==========================================================================*
+ * init
+ *==========================================================================*/
+
+static
+void
+test_init(
+    void)
+{
+    BinderRetry retry;
+
+    /* Zero delay is bumped to 1 ms, the cap is never below the delay */
+    binder_retry_init(&retry, NULL, "unit_retry_init", 0, 0);
+    g_assert_cmpstr(retry.log_prefix, == ,"");
+    g_assert_cmpuint(retry.delay_ms, == ,1);
+    g_assert_cmpuint(retry.max_delay_ms, == ,1);
+    g_assert_cmpuint(retry.jitter_pct, == ,BINDER_RETRY_JITTER_PCT);
+    g_assert_cmpuint(retry.attempt, == ,0);
+    binder_retry_deinit(&retry);
+
+    binder_retry_init(&retry, "[x] ", "unit_retry_init", 500, 100);
+    g_assert_cmpstr(retry.log_prefix, == ,"[x] ");
+    g_assert_cmpuint(retry.delay_ms, == ,500);
+    g_assert_cmpuint(retry.max_delay_ms, == ,500);
+    binder_retry_deinit(&retry);
+}
+
+/*==========================================================================*
+ * backoff
+ *==========================================================================*/
+
+static
+void
+test_backoff(
+    void)
+{
+    BinderRetry retry;
+
+    binder_retry_init(&retry, NULL, "unit_retry_backoff", 100, 1000);
+    retry.jitter_pct = 0;
+
+    /* Doubles up to the cap */
+    g_assert_cmpuint(binder_retry_next_delay(&retry), == ,100);
+    g_assert_cmpuint(binder_retry_next_delay(&retry), == ,200);
+    g_assert_cmpuint(binder_retry_next_delay(&retry), == ,400);
+    g_assert_cmpuint(binder_retry_next_delay(&retry), == ,800);
+    g_assert_cmpuint(binder_retry_next_delay(&retry), == ,1000);
+    g_assert_cmpuint(binder_retry_next_delay(&retry), == ,1000);
+    g_assert_cmpuint(retry.attempt, == ,6);
+    g_assert_cmpuint(retry.retries, == ,6);
+    g_assert_cmpuint(retry.resets, == ,0);
+
+    /* Success starts over */
+    binder_retry_reset(&retry);
+    g_assert_cmpuint(retry.attempt, == ,0);
+    g_assert_cmpuint(retry.resets, == ,1);
+    g_assert_cmpuint(retry.longest, == ,6);
+    g_assert_cmpuint(binder_retry_next_delay(&retry), == ,100);
+    g_assert_cmpuint(binder_retry_next_delay(&retry), == ,200);
+
+    /* Shorter streak doesn't replace the longest one */
+    binder_retry_reset(&retry);
+    g_assert_cmpuint(retry.resets, == ,2);
+    g_assert_cmpuint(retry.longest, == ,6);
+    g_assert_cmpuint(retry.retries, == ,8);
+
+    /* Reset without a failure is not a recovery */
+    binder_retry_reset(&retry);
+    g_assert_cmpuint(retry.resets, == ,2);
+    binder_retry_deinit(&retry);
+}
+
+/*==========================================================================*
+ * jitter
+ *==========================================================================*/
+
+static
+void
+test_jitter(
+    void)
+{
+    BinderRetry retry;
+    int i;
+
+    binder_retry_init(&retry, NULL, "unit_retry_jitter", 1000,
+        BINDER_RETRY_MAX_MS);
+    for (i = 0; i < 100; i++) {
+        const guint delay = binder_retry_next_delay(&retry);
+
+        g_assert_cmpuint(delay, >= ,800);
+        g_assert_cmpuint(delay, <= ,1200);
+        binder_retry_reset(&retry);
+    }
+
+    /* Spread of the capped delay */
+    retry.attempt = 100;
+    for (i = 0; i < 100; i++) {
+        const guint delay = binder_retry_next_delay(&retry);
+
+        g_assert_cmpuint(delay, >= ,BINDER_RETRY_MAX_MS * 8 / 10);
+        g_assert_cmpuint(delay, <= ,BINDER_RETRY_MAX_MS * 12 / 10);
+    }
+    binder_retry_deinit(&retry);
+}
+
+/*==========================================================================*
+ * metrics
+ *==========================================================================*/
+
+static
+void
+test_metrics(
+    void)
+{
+    BinderRetry r1, r2;
+    BinderMetrics* metrics = binder_metrics_new();
+    char* text;
+
+    /* Totals are shared by the policies with the same name */
+    binder_retry_init(&r1, NULL, "unit_retry_metrics", 10, 100);
+    binder_retry_init(&r2, NULL, "unit_retry_metrics", 10, 100);
+    binder_retry_next_delay(&r1);
+    binder_retry_next_delay(&r1);
+    binder_retry_next_delay(&r2);
+    binder_retry_reset(&r1);
+    binder_retry_deinit(&r1);
+    binder_retry_deinit(&r2);
+
+    binder_retry_add_metrics(metrics);
+    text = binder_metrics_format(metrics);
+    GDEBUG("%s", text);
+    g_assert(strstr(text,
+        "binder_retries_total{policy=\"unit_retry_metrics\"} 3\n"));
+    g_assert(strstr(text,
+        "binder_retry_recoveries_total{policy=\"unit_retry_metrics\"} 1\n"));
+    g_free(text);
+    binder_metrics_free(metrics);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/retry/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("init"), test_init);
+    g_test_add_func(TEST_("backoff"), test_backoff);
+    g_test_add_func(TEST_("jitter"), test_jitter);
+    g_test_add_func(TEST_("metrics"), test_metrics);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
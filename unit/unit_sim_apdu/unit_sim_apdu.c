@@ -0,0 +1,133 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_sim_apdu.h"
+
+#include <gutil_log.h>
+
+/*==========================================================================*
+ * cla
+ *==========================================================================*/
+
+static
+void
+test_cla(
+    void)
+{
+    /* Basic logical channels */
+    g_assert_cmpint(binder_sim_apdu_cla(0), == ,0x00);
+    g_assert_cmpint(binder_sim_apdu_cla(3), == ,0x03);
+
+    /* Extended logical channels */
+    g_assert_cmpint(binder_sim_apdu_cla(4), == ,0x40);
+    g_assert_cmpint(binder_sim_apdu_cla(19), == ,0x4f);
+}
+
+/*==========================================================================*
+ * offset
+ *==========================================================================*/
+
+static
+void
+test_offset(
+    void)
+{
+    guint8 p1 = 0xff, p2 = 0xff;
+
+    g_assert(binder_sim_apdu_binary_offset(0, &p1, &p2));
+    g_assert_cmpuint(p1, == ,0);
+    g_assert_cmpuint(p2, == ,0);
+
+    g_assert(binder_sim_apdu_binary_offset(0x1fe, &p1, &p2));
+    g_assert_cmpuint(p1, == ,0x01);
+    g_assert_cmpuint(p2, == ,0xfe);
+
+    g_assert(binder_sim_apdu_binary_offset(BINDER_SIM_APDU_MAX_OFFSET,
+        &p1, &p2));
+    g_assert_cmpuint(p1, == ,0x7f);
+    g_assert_cmpuint(p2, == ,0xff);
+
+    /* These can't be addressed and leave P1 and P2 alone */
+    p1 = p2 = 0;
+    g_assert(!binder_sim_apdu_binary_offset(BINDER_SIM_APDU_MAX_OFFSET + 1,
+        &p1, &p2));
+    g_assert(!binder_sim_apdu_binary_offset(0x10000, &p1, &p2));
+    g_assert(!binder_sim_apdu_binary_offset(-1, &p1, &p2));
+    g_assert_cmpuint(p1, == ,0);
+    g_assert_cmpuint(p2, == ,0);
+}
+
+/*==========================================================================*
+ * step
+ *==========================================================================*/
+
+static
+void
+test_step(
+    void)
+{
+    guint i;
+
+    g_assert_cmpint(binder_sim_apdu_step(0x90, 0), == ,
+        BINDER_SIM_APDU_STEP_DONE);
+    g_assert_cmpint(binder_sim_apdu_step(0x6a, 0), == ,
+        BINDER_SIM_APDU_STEP_DONE);
+
+    /* GET RESPONSE doesn't count as a resend */
+    g_assert_cmpint(binder_sim_apdu_step(0x61, 0), == ,
+        BINDER_SIM_APDU_STEP_GET_RESPONSE);
+    g_assert_cmpint(binder_sim_apdu_step(0x61,
+        BINDER_SIM_APDU_MAX_RESENDS), == ,
+        BINDER_SIM_APDU_STEP_GET_RESPONSE);
+
+    /* Wrong length is retried a limited number of times */
+    for (i = 0; i < BINDER_SIM_APDU_MAX_RESENDS; i++) {
+        g_assert_cmpint(binder_sim_apdu_step(0x6C, i), == ,
+            BINDER_SIM_APDU_STEP_RESEND);
+    }
+    g_assert_cmpint(binder_sim_apdu_step(0x6C, i), == ,
+        BINDER_SIM_APDU_STEP_FAIL);
+    g_assert_cmpint(binder_sim_apdu_step(0x6C, i + 1), == ,
+        BINDER_SIM_APDU_STEP_FAIL);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/sim_apdu/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("cla"), test_cla);
+    g_test_add_func(TEST_("offset"), test_offset);
+    g_test_add_func(TEST_("step"), test_step);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,127 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_stats.h"
+
+#include <gutil_log.h>
+
+#include <string.h>
+
+GLOG_MODULE_DEFINE("unit_stats");
+
+/*==========================================================================*
+ * basic
+ *==========================================================================*/
+
+static
+void
+test_basic(
+    void)
+{
+    BinderStats* stats = binder_stats_new("test");
+
+    /* NULL is tolerated */
+    binder_stats_free(NULL);
+    g_assert(!binder_stats_get_reqs(NULL));
+    g_assert(!binder_stats_get_inds(NULL));
+
+    /* Nothing has been seen yet */
+    g_assert(!binder_stats_get_reqs(stats));
+    g_assert(!binder_stats_get_inds(stats));
+    binder_stats_free(stats);
+}
+
+/*==========================================================================*
+ * percentile
+ *==========================================================================*/
+
+static
+void
+test_percentile(
+    void)
+{
+    BinderStatsReqInfo info;
+
+    g_assert_cmpuint(binder_stats_req_percentile(NULL, 50), == ,0);
+
+    /* No completed requests */
+    memset(&info, 0, sizeof(info));
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 50), == ,0);
+
+    /* 5 in [4,8), 4 in [512,1024) and 1 in [2^19,2^20) microseconds */
+    info.count = 10;
+    info.hist[3] = 5;
+    info.hist[10] = 4;
+    info.hist[20] = 1;
+    info.max_us = 600000;
+
+    /* The upper bound of the bucket containing the rank */
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 0), == ,8);
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 10), == ,8);
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 50), == ,8);
+
+    /* Rank is rounded up, 51% of 10 is the 6th sample */
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 51), == ,1024);
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 90), == ,1024);
+
+    /* But never above the maximum */
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 91), == ,600000);
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 99), == ,600000);
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 100), == ,600000);
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 200), == ,600000);
+
+    /* Sub-microsecond latencies */
+    memset(&info, 0, sizeof(info));
+    info.count = 1;
+    info.hist[0] = 1;
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 50), == ,0);
+
+    /* The histogram which doesn't add up falls back to the maximum */
+    memset(&info, 0, sizeof(info));
+    info.count = 5;
+    info.hist[2] = 1;
+    info.max_us = 3;
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 1), == ,3);
+    g_assert_cmpuint(binder_stats_req_percentile(&info, 100), == ,3);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/stats/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("basic"), test_basic);
+    g_test_add_func(TEST_("percentile"), test_percentile);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,217 @@
+/*
+ *  oFono - Open Source Telephony - binder based adaptation
+ *
+ *  Copyright (C) 2026 The ofono-binder-plugin contributors
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License version 2 as
+ *  published by the Free Software Foundation.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "binder_log.h"
+#include "binder_util.h"
+
+#include <ofono/radio-settings.h>
+
+#include <gutil_log.h>
+
+#include <string.h>
+
+GLOG_MODULE_DEFINE("unit_util");
+
+/*==========================================================================*
+ * Stubs
+ *==========================================================================*/
+
+enum ofono_radio_access_mode
+ofono_radio_access_max_mode(
+    enum ofono_radio_access_mode mask)
+{
+    g_assert_not_reached();
+    return mask;
+}
+
+/*==========================================================================*
+ * encode
+ *==========================================================================*/
+
+static
+void
+test_encode(
+    void)
+{
+    static const guint8 data[] = { 0x00, 0x01, 0x9a, 0xbc, 0xef, 0xff };
+    char buf[2 * G_N_ELEMENTS(data) + 1];
+    char* hex;
+
+    hex = binder_encode_hex(data, sizeof(data));
+    g_assert_cmpstr(hex, == ,"00019ABCEFFF");
+    g_free(hex);
+
+    hex = binder_encode_hex(data, 0);
+    g_assert_cmpstr(hex, == ,"");
+    g_free(hex);
+
+    memset(buf, 'x', sizeof(buf));
+    binder_encode_hex_buf(data + 2, 2, buf);
+    g_assert_cmpstr(buf, == ,"9ABC");
+}
+
+/*==========================================================================*
+ * decode
+ *==========================================================================*/
+
+static
+void
+test_decode(
+    void)
+{
+    static const guint8 data[] = { 0x0a, 0xbc, 0xde, 0xf0 };
+    guint8 buf[4];
+    guint size = 0;
+    void* out;
+
+    /* Both cases are accepted */
+    out = binder_decode_hex("0ABCdef0", -1, &size);
+    g_assert(out);
+    g_assert_cmpuint(size, == ,sizeof(data));
+    g_assert(!memcmp(out, data, size));
+    g_free(out);
+
+    /* The length limits the input */
+    out = binder_decode_hex("0ABCdef0", 4, &size);
+    g_assert(out);
+    g_assert_cmpuint(size, == ,2);
+    g_assert(!memcmp(out, data, size));
+    g_free(out);
+
+    /* The buffer is used when the output fits */
+    size = 0;
+    g_assert(binder_decode_hex_buf("0abcdef0", -1, buf, sizeof(buf),
+        &size) == buf);
+    g_assert_cmpuint(size, == ,sizeof(data));
+    g_assert(!memcmp(buf, data, size));
+
+    /* And otherwise the output is allocated */
+    out = binder_decode_hex_buf("0abcdef0", -1, buf, 2, &size);
+    g_assert(out);
+    g_assert(out != buf);
+    g_assert_cmpuint(size, == ,sizeof(data));
+    g_assert(!memcmp(out, data, size));
+    g_free(out);
+
+    /* The size pointer is optional */
+    out = binder_decode_hex("00", -1, NULL);
+    g_assert(out);
+    g_assert_cmpuint(*(guint8*)out, == ,0);
+    g_free(out);
+}
+
+/*==========================================================================*
+ * invalid
+ *==========================================================================*/
+
+static
+void
+test_invalid(
+    void)
+{
+    static const char* bad[] = {
+        "", "0", "012", "0g", "g0", "0x12", " 012", "01 2", "-1",
+        "\xff\xff", "0\xa0"
+    };
+    guint8 buf[4];
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(bad); i++) {
+        guint size = 1;
+
+        g_assert(!binder_decode_hex(bad[i], -1, &size));
+        g_assert_cmpuint(size, == ,0);
+        size = 1;
+        g_assert(!binder_decode_hex_buf(bad[i], -1, buf, sizeof(buf),
+            &size));
+        g_assert_cmpuint(size, == ,0);
+    }
+
+    /* Embedded NUL is not a digit */
+    g_assert(!binder_decode_hex("0\0001", 4, NULL));
+
+    /* NULL input and non-positive length */
+    g_assert(!binder_decode_hex(NULL, -1, NULL));
+    g_assert(!binder_decode_hex(NULL, 2, NULL));
+    g_assert(!binder_decode_hex("01", 0, NULL));
+}
+
+/*==========================================================================*
+ * roundtrip
+ *==========================================================================*/
+
+static
+void
+test_roundtrip(
+    void)
+{
+    guint8 data[256];
+    char* hex;
+    char* lower;
+    guint8* out;
+    guint i, size = 0;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (guint8)i;
+    }
+
+    hex = binder_encode_hex(data, sizeof(data));
+    g_assert_cmpuint(strlen(hex), == ,2 * sizeof(data));
+    out = binder_decode_hex(hex, -1, &size);
+    g_assert(out);
+    g_assert_cmpuint(size, == ,sizeof(data));
+    g_assert(!memcmp(out, data, size));
+    g_free(out);
+
+    /* Lowercase decodes to the same bytes */
+    lower = g_ascii_strdown(hex, -1);
+    out = binder_decode_hex(lower, -1, &size);
+    g_assert(out);
+    g_assert_cmpuint(size, == ,sizeof(data));
+    g_assert(!memcmp(out, data, size));
+    g_free(out);
+    g_free(lower);
+    g_free(hex);
+}
+
+/*==========================================================================*
+ * Common
+ *==========================================================================*/
+
+#define TEST_PREFIX "/util/"
+#define TEST_(t) TEST_PREFIX t
+
+int main(int argc, char* argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func(TEST_("encode"), test_encode);
+    g_test_add_func(TEST_("decode"), test_decode);
+    g_test_add_func(TEST_("invalid"), test_invalid);
+    g_test_add_func(TEST_("roundtrip"), test_roundtrip);
+
+    gutil_log_default.level = g_test_verbose() ?
+        GLOG_LEVEL_VERBOSE : GLOG_LEVEL_NONE;
+    gutil_log_timestamp = FALSE;
+
+    return g_test_run();
+}
+
+/*
+ * Local Variables:
+ * mode: C
+ * c-basic-offset: 4
+ * indent-tabs-mode: nil
+ * End:
+ */